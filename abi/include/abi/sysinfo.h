@@ -47,6 +47,7 @@
 /** Maximum name sizes */
 #define TASK_NAME_BUFLEN  64
 #define EXC_NAME_BUFLEN   20
+#define SLAB_NAME_BUFLEN  32
 
 /** Item value type
  *
@@ -133,6 +134,24 @@ typedef struct {
 	uint64_t count;              /**< Number of handled exceptions */
 } stats_exc_t;
 
+/** Statistics about a single slab cache
+ *
+ */
+typedef struct {
+	char name[SLAB_NAME_BUFLEN];  /**< Cache name */
+	size_t size;                  /**< Object size (bytes) */
+	size_t frames;                /**< Frames per slab */
+	size_t objects;               /**< Objects per slab */
+	size_t slabs;                 /**< Number of allocated slabs */
+	size_t allocated;             /**< Number of allocated objects */
+	size_t cached;                /**< Number of objects in magazines */
+	size_t magazine_size;         /**< Current magazine size (0 if none) */
+	uint64_t mag_hits;            /**< Operations served by CPU magazines */
+	uint64_t depot_trips;         /**< Magazine exchanges with the depot */
+	uint64_t depot_contention;    /**< Contended depot lock acquisitions */
+	uint64_t slab_allocs;         /**< Objects allocated from slabs */
+} stats_slab_t;
+
 /** Load fixed-point value */
 typedef uint32_t load_t;
 
@@ -148,6 +148,21 @@
 #define SET_FRAME_PRESENT_ARCH(ptl3, i) \
 	set_pt_present((pte_t *) (ptl3), (size_t) (i))
 
+/* Large pages terminate the walk in PTL2. */
+#define LARGE_PAGE_WIDTH_ARCH  21
+
+#define GET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].page_size != 0)
+#define SET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].page_size = 1)
+
+/* Copy the accessed and dirty bits of a large page to a small page. */
+#define SET_FRAME_USAGE_ARCH(ptl3, i, large) \
+	do { \
+		((pte_t *) (ptl3))[(i)].accessed = (large)->accessed; \
+		((pte_t *) (ptl3))[(i)].dirty = (large)->dirty; \
+	} while (0)
+
 /* Macros for querying the last-level PTE entries. */
 #define PTE_VALID_ARCH(p) \
 	((p)->soft_valid != 0)
@@ -197,7 +212,7 @@ typedef struct {
 	unsigned int page_cache_disable : 1;
 	unsigned int accessed : 1;
 	unsigned int dirty : 1;
-	unsigned int unused : 1;
+	unsigned int page_size : 1;  /**< PTL2 entry maps a 2 MiB page. */
 	unsigned int global : 1;
 	unsigned int soft_valid : 1;  /**< Valid content even if present bit is cleared. */
 	unsigned int avl : 2;
@@ -128,6 +128,20 @@
 #define SET_PTL3_PRESENT(ptl2, i)   SET_PTL3_PRESENT_ARCH(ptl2, i)
 #define SET_FRAME_PRESENT(ptl3, i)  SET_FRAME_PRESENT_ARCH(ptl3, i)
 
+/*
+ * These macros are provided by architectures which can map a large page
+ * directly from a PTL2 entry instead of pointing it to a PTL3.
+ *
+ */
+#ifdef LARGE_PAGE_WIDTH_ARCH
+#define GET_PTL3_LARGE(ptl2, i)  GET_PTL3_LARGE_ARCH(ptl2, i)
+#define SET_PTL3_LARGE(ptl2, i)  SET_PTL3_LARGE_ARCH(ptl2, i)
+#define SET_FRAME_USAGE(ptl3, i, large) \
+	SET_FRAME_USAGE_ARCH(ptl3, i, large)
+#else
+#define GET_PTL3_LARGE(ptl2, i)  false
+#endif
+
 /*
  * Macros for querying the last-level PTEs.
  *
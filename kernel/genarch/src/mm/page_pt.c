@@ -56,33 +56,37 @@ static void pt_mapping_remove(as_t *, uintptr_t);
 static bool pt_mapping_find(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_update(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_make_global(uintptr_t, size_t);
+#ifdef LARGE_PAGE_WIDTH_ARCH
+static bool pt_mapping_insert_large(as_t *, uintptr_t, uintptr_t, unsigned int);
+static bool pt_mapping_is_large(as_t *, uintptr_t, bool);
+static void pt_mapping_demote(as_t *, uintptr_t);
+#endif
 
 page_mapping_operations_t pt_mapping_operations = {
 	.mapping_insert = pt_mapping_insert,
 	.mapping_remove = pt_mapping_remove,
 	.mapping_find = pt_mapping_find,
 	.mapping_update = pt_mapping_update,
-	.mapping_make_global = pt_mapping_make_global
+	.mapping_make_global = pt_mapping_make_global,
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	.mapping_insert_large = pt_mapping_insert_large,
+	.mapping_is_large = pt_mapping_is_large,
+	.mapping_demote = pt_mapping_demote
+#endif
 };
 
-/** Map page to frame using hierarchical page tables.
+/** Get PTL2 for page, allocating any missing PTL1 and PTL2.
  *
- * Map virtual address page to physical address frame
- * using flags.
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page.
  *
- * @param as    Address space to wich page belongs.
- * @param page  Virtual address of the page to be mapped.
- * @param frame Physical address of memory frame to which the mapping is done.
- * @param flags Flags to be used for mapping.
+ * @return Kernel address of the PTL2 covering page.
  *
  */
-void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
-    unsigned int flags)
+static pte_t *pt_ptl2_get(as_t *as, uintptr_t page)
 {
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
 
-	assert(page_table_locked(as));
-
 	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
 		    PA2KA(frame_alloc(PTL1_FRAMES, FRAME_LOWMEM, PTL1_SIZE - 1));
@@ -117,7 +121,29 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 		SET_PTL2_PRESENT(ptl1, PTL1_INDEX(page));
 	}
 
-	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+	return (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+}
+
+/** Map page to frame using hierarchical page tables.
+ *
+ * Map virtual address page to physical address frame
+ * using flags.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the page to be mapped.
+ * @param frame Physical address of memory frame to which the mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+	/* Small pages cannot be mapped over a large page. */
+	assert(!GET_PTL3_LARGE(ptl2, PTL2_INDEX(page)));
 
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
@@ -145,6 +171,44 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	SET_FRAME_PRESENT(ptl3, PTL3_INDEX(page));
 }
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+
+/** Map large page to frame using hierarchical page tables.
+ *
+ * The large page is mapped directly from PTL2.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame of the large page.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return False if there already is a PTL3 or a large page in place.
+ *
+ */
+bool pt_mapping_insert_large(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+	if (!(GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT))
+		return false;
+
+	SET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page), frame);
+	SET_PTL3_FLAGS(ptl2, PTL2_INDEX(page), flags | PAGE_NOT_PRESENT);
+	SET_PTL3_LARGE(ptl2, PTL2_INDEX(page));
+	/*
+	 * Make the new mapping visible only after it is fully initialized.
+	 */
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, PTL2_INDEX(page));
+
+	return true;
+}
+
+#endif /* LARGE_PAGE_WIDTH_ARCH */
+
 /** Remove mapping of page from hierarchical page tables.
  *
  * Remove any mapping of page within address space as.
@@ -177,6 +241,20 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return;
 
+	bool empty = true;
+	unsigned int i;
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		/*
+		 * The page is covered by a large page, which is removed
+		 * as a whole. There is no PTL3 to release.
+		 */
+		memsetb(&ptl2[PTL2_INDEX(page)], sizeof(pte_t), 0);
+		goto check_ptl2;
+	}
+#endif
+
 	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
 
 	/*
@@ -195,9 +273,6 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	 */
 
 	/* Check PTL3 */
-	bool empty = true;
-
-	unsigned int i;
 	for (i = 0; i < PTL3_ENTRIES; i++) {
 		if (PTE_VALID(&ptl3[i])) {
 			empty = false;
@@ -232,6 +307,9 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 		return;
 	}
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+check_ptl2:
+#endif
 	/* Check PTL2, empty is still true */
 #if (PTL2_ENTRIES != 0)
 	for (i = 0; i < PTL2_ENTRIES; i++) {
@@ -291,8 +369,21 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 #endif /* PTL1_ENTRIES != 0 */
 }
 
-static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
+/** Find the last-level PTE for page.
+ *
+ * @param as         Address space to which page belongs.
+ * @param page       Virtual page.
+ * @param nolock     True if the page tables need not be locked.
+ * @param[out] large Set to true if the returned entry is a PTL2 entry
+ *                   mapping a large page.
+ *
+ * @return Pointer to the PTE or NULL if there is none.
+ */
+static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock,
+    bool *large)
 {
+	*large = false;
+
 	assert(nolock || page_table_locked(as));
 
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
@@ -316,6 +407,11 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
 
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		*large = true;
+		return &ptl2[PTL2_INDEX(page)];
+	}
+
 #if (PTL2_ENTRIES != 0)
 	/*
 	 * Always read ptl3 only after we are sure it is present.
@@ -339,9 +435,21 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
  */
 bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
-	if (t)
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
+	if (t) {
 		*pte = *t;
+#ifdef LARGE_PAGE_WIDTH_ARCH
+		if (large) {
+			/*
+			 * Report the small page within the large one so that
+			 * callers need not care about the mapping size.
+			 */
+			SET_FRAME_ADDRESS(pte, 0, PTE_GET_FRAME(t) +
+			    (page & (LARGE_PAGE_SIZE - 1)));
+		}
+#endif
+	}
 	return t != NULL;
 }
 
@@ -354,10 +462,17 @@ bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
  */
 void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
 	if (!t)
 		panic("Updating non-existent PTE");
 
+	/*
+	 * Only architectures with software-managed TLBs update PTEs and none
+	 * of them maps large pages.
+	 */
+	assert(!large);
+
 	assert(PTE_VALID(t) == PTE_VALID(pte));
 	assert(PTE_PRESENT(t) == PTE_PRESENT(pte));
 	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(pte));
@@ -367,6 +482,69 @@ void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 	*t = *pte;
 }
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+
+/** Test whether page is mapped by a large page.
+ *
+ * @param as     Address space to which page belongs.
+ * @param page   Virtual page.
+ * @param nolock True if the page tables need not be locked.
+ *
+ * @return True if page is covered by a large page.
+ */
+bool pt_mapping_is_large(as_t *as, uintptr_t page, bool nolock)
+{
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
+
+	return (t != NULL) && large;
+}
+
+/** Split large page into a PTL3 full of small pages.
+ *
+ * The new PTL3 maps the same frames with the same flags, each small page
+ * inherits the accessed and dirty bits of the large page. It replaces
+ * the large page in a single store so that concurrent hardware page table
+ * walks see either the old or the new translation.
+ *
+ * @param as   Address space to which page belongs.
+ * @param page Virtual address of the large page.
+ */
+void pt_mapping_demote(as_t *as, uintptr_t page)
+{
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, false, &large);
+	if (!t || !large)
+		return;
+
+	uintptr_t frame = PTE_GET_FRAME(t);
+	unsigned int flags = GET_PTL3_FLAGS(t, 0);
+
+	pte_t *newpt = (pte_t *)
+	    PA2KA(frame_alloc(PTL3_FRAMES, FRAME_LOWMEM, PTL3_SIZE - 1));
+	memsetb(newpt, PTL3_SIZE, 0);
+
+	for (unsigned int i = 0; i < PTL3_ENTRIES; i++) {
+		SET_FRAME_ADDRESS(newpt, i, frame + P2SZ(i));
+		SET_FRAME_FLAGS(newpt, i, flags);
+		SET_FRAME_USAGE(newpt, i, t);
+	}
+
+	pte_t entry;
+	memsetb(&entry, sizeof(pte_t), 0);
+	SET_PTL3_ADDRESS(&entry, 0, KA2PA(newpt));
+	SET_PTL3_FLAGS(&entry, 0, PAGE_USER | PAGE_EXEC | PAGE_CACHEABLE |
+	    PAGE_WRITE);
+
+	/*
+	 * Make the new PTL3 visible only after it is fully initialized.
+	 */
+	write_barrier();
+	*t = entry;
+}
+
+#endif /* LARGE_PAGE_WIDTH_ARCH */
+
 /** Return the size of the region mapped by a single PTL0 entry.
  *
  * @return Size of the region mapped by a single PTL0 entry.
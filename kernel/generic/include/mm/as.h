@@ -174,6 +174,10 @@ struct mem_backend;
 typedef union mem_backend_data {
 	/* anon_backend members */
 	struct {
+		/** Page expected to fault next on sequential access. */
+		uintptr_t fault_next;
+		/** Number of pages mapped around the last fault. */
+		size_t fault_window;
 	};
 
 	/** elf_backend members */
@@ -47,6 +47,18 @@
 /** Maximum number of zones in the system. */
 #define ZONES_MAX  32
 
+/** Number of single frames cached per CPU (for each type of memory). */
+#define FRAME_PCPU_SIZE  32
+
+/** Number of frames moved between a per-CPU cache and the zones at once. */
+#define FRAME_PCPU_BATCH  16
+
+/** Runs of up to 2^(FRAME_RUN_ORDERS - 1) frames are kept in free lists. */
+#define FRAME_RUN_ORDERS  5
+
+/** Maximum number of runs kept in each free list. */
+#define FRAME_RUN_MAX  8
+
 typedef uint8_t frame_flags_t;
 
 #define FRAME_NONE        0x00
@@ -130,6 +142,7 @@ typedef struct {
 extern zones_t zones;
 
 extern void frame_init(void);
+extern void frame_enable_cpucache(void);
 extern bool frame_adjust_zone_bounds(bool, uintptr_t *, size_t *);
 extern uintptr_t frame_alloc_generic(size_t, frame_flags_t, uintptr_t,
     size_t *);
@@ -43,6 +43,19 @@
 #define P2SZ(pages) \
 	((pages) << PAGE_WIDTH)
 
+/*
+ * Size of a large page. Architectures without large page support fall back
+ * to PAGE_SIZE, in which case there is a single small page per large page.
+ */
+#ifdef LARGE_PAGE_WIDTH_ARCH
+#define LARGE_PAGE_WIDTH  LARGE_PAGE_WIDTH_ARCH
+#else
+#define LARGE_PAGE_WIDTH  PAGE_WIDTH
+#endif
+
+#define LARGE_PAGE_SIZE    (((uintptr_t) 1) << LARGE_PAGE_WIDTH)
+#define LARGE_PAGE_FRAMES  (LARGE_PAGE_SIZE >> PAGE_WIDTH)
+
 /** Operations to manipulate page mappings. */
 typedef struct {
 	void (*mapping_insert)(as_t *, uintptr_t, uintptr_t, unsigned int);
@@ -50,6 +63,11 @@ typedef struct {
 	bool (*mapping_find)(as_t *, uintptr_t, bool, pte_t *);
 	void (*mapping_update)(as_t *, uintptr_t, bool, pte_t *);
 	void (*mapping_make_global)(uintptr_t, size_t);
+
+	/* Optional large page operations. */
+	bool (*mapping_insert_large)(as_t *, uintptr_t, uintptr_t, unsigned int);
+	bool (*mapping_is_large)(as_t *, uintptr_t, bool);
+	void (*mapping_demote)(as_t *, uintptr_t);
 } page_mapping_operations_t;
 
 extern page_mapping_operations_t *page_mapping_operations;
@@ -63,6 +81,10 @@ extern void page_mapping_remove(as_t *, uintptr_t);
 extern bool page_mapping_find(as_t *, uintptr_t, bool, pte_t *);
 extern void page_mapping_update(as_t *, uintptr_t, bool, pte_t *);
 extern void page_mapping_make_global(uintptr_t, size_t);
+extern bool page_mapping_insert_large(as_t *, uintptr_t, uintptr_t,
+    unsigned int);
+extern bool page_mapping_is_large(as_t *, uintptr_t, bool);
+extern void page_mapping_demote(as_t *, uintptr_t);
 extern pte_t *page_table_create(unsigned int);
 extern void page_table_destroy(pte_t *);
 
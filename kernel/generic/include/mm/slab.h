@@ -39,6 +39,7 @@
 #include <synch/spinlock.h>
 #include <atomic.h>
 #include <mm/frame.h>
+#include <abi/sysinfo.h>
 
 /** Minimum size to be allocated by malloc */
 #define SLAB_MIN_MALLOC_W  4
@@ -46,8 +47,20 @@
 /** Maximum size to be allocated by malloc */
 #define SLAB_MAX_MALLOC_W  22
 
-/** Initial Magazine size (TODO: dynamically growing magazines) */
-#define SLAB_MAG_SIZE  4
+/** Initial magazine size */
+#define SLAB_MAG_SIZE_MIN  4
+
+/** Number of magazine sizes (each class doubles the previous size) */
+#define SLAB_MAG_CLASSES  5
+
+/** Maximum magazine size */
+#define SLAB_MAG_SIZE_MAX  (SLAB_MAG_SIZE_MIN << (SLAB_MAG_CLASSES - 1))
+
+/**
+ * Number of contended acquisitions of the depot lock after which
+ * the magazine size of the cache is doubled
+ */
+#define SLAB_MAG_CONTENTION_LIMIT  16
 
 /** If object size is less, store control structure inside SLAB */
 #define SLAB_INSIDE_SIZE  (PAGE_SIZE >> 3)
@@ -81,6 +94,9 @@ typedef struct {
 	slab_magazine_t *current;
 	slab_magazine_t *last;
 	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Allocations and frees satisfied by the CPU magazines */
+	uint64_t hits;
 } slab_mag_cache_t;
 
 typedef struct {
@@ -110,6 +126,13 @@ typedef struct {
 	/** How many magazines in magazines list */
 	atomic_t magazine_counter;
 
+	/** Magazine exchanges with the depot (protected by maglock) */
+	uint64_t depot_trips;
+	/** Contended acquisitions of maglock (protected by maglock) */
+	uint64_t depot_contention;
+	/** Objects allocated directly from slabs (protected by slablock) */
+	uint64_t slab_allocs;
+
 	/* Slabs */
 	list_t full_slabs;     /**< List of full slabs */
 	list_t partial_slabs;  /**< List of partial slabs */
@@ -117,6 +140,10 @@ typedef struct {
 	/* Magazines */
 	list_t magazines;  /**< List o full magazines */
 	IRQ_SPINLOCK_DECLARE(maglock);
+	/** Size of newly allocated magazines (protected by maglock) */
+	size_t mag_size;
+	/** Depot lock contention since the last magazine resize */
+	size_t mag_contention;
 
 	/** CPU cache */
 	slab_mag_cache_t *mag_cache;
@@ -138,6 +165,10 @@ extern void slab_enable_cpucache(void);
 /* kconsole debug */
 extern void slab_print_list(void);
 
+/* statistics */
+extern size_t slab_stats_count(void);
+extern size_t slab_stats(stats_slab_t *, size_t);
+
 /* malloc support */
 extern void *malloc(size_t)
     __attribute__((malloc));
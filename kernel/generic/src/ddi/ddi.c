@@ -441,7 +441,11 @@ NO_TRACE static errno_t dmamem_map_anonymous(size_t size, uintptr_t constraint,
 	backend_data.frames = frames;
 	backend_data.anonymous = true;
 
-	if (!as_area_create(TASK->as, map_flags, size,
+	/*
+	 * The frames are allocated already, so mapping them up front costs
+	 * no memory and spares the driver a fault per page.
+	 */
+	if (!as_area_create(TASK->as, map_flags | AS_AREA_POPULATE, size,
 	    AS_AREA_ATTR_NONE, &phys_backend, &backend_data, virt, bound)) {
 		frame_free(*phys, frames);
 		return ENOMEM;
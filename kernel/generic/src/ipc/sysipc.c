@@ -740,7 +740,7 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
 	return rc;
 }
 
-/** Wait for an incoming IPC call or an answer.
+/** Wait for an incoming IPC call or an answer and copy it to uspace.
  *
  * @param calldata Pointer to buffer where the call/answer data is stored.
  * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
@@ -749,7 +749,7 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
  *
  * @return An error code on error.
  */
-sys_errno_t sys_ipc_wait_for_call(ipc_data_t *calldata, uint32_t usec,
+static errno_t ipc_wait_one(ipc_data_t *calldata, uint32_t usec,
     unsigned int flags)
 {
 	call_t *call = NULL;
@@ -850,6 +850,74 @@ error:
 	return rc;
 }
 
+/** Wait for an incoming IPC call or an answer.
+ *
+ * @param calldata Pointer to buffer where the call/answer data is stored.
+ * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags    Select mode of sleep operation. See waitq_sleep_timeout()
+ *                 for explanation.
+ *
+ * @return An error code on error.
+ */
+sys_errno_t sys_ipc_wait_for_call(ipc_data_t *calldata, uint32_t usec,
+    unsigned int flags)
+{
+	return (sys_errno_t) ipc_wait_one(calldata, usec, flags);
+}
+
+/** Wait for incoming IPC calls or answers and retrieve as many as are queued.
+ *
+ * Only the wait for the first call/answer may block. The answerbox is then
+ * drained without blocking until all buffers are used or no more calls and
+ * answers are queued.
+ *
+ * @param calldata Uspace array of pointers to buffers where the call/answer
+ *                 data is stored.
+ * @param count    Number of elements of calldata.
+ * @param received Uspace pointer where the number of stored calls/answers
+ *                 is written.
+ * @param usec     Timeout for the first call/answer.
+ *                 See waitq_sleep_timeout() for explanation.
+ * @param flags    Select mode of sleep operation for the first call/answer.
+ *                 See waitq_sleep_timeout() for explanation.
+ *
+ * @return An error code if not even the first call/answer was retrieved.
+ */
+sys_errno_t sys_ipc_wait_batch(ipc_data_t **calldata, size_t count,
+    size_t *received, uint32_t usec, unsigned int flags)
+{
+	ipc_data_t *buffer;
+
+	if (count == 0)
+		return (sys_errno_t) EINVAL;
+
+	errno_t rc = copy_from_uspace(&buffer, &calldata[0], sizeof(buffer));
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	rc = ipc_wait_one(buffer, usec, flags);
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	size_t i;
+	for (i = 1; i < count; i++) {
+		if (copy_from_uspace(&buffer, &calldata[i],
+		    sizeof(buffer)) != EOK)
+			break;
+
+		if (ipc_wait_one(buffer, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING) != EOK)
+			break;
+	}
+
+	/*
+	 * The retrieved calls are owned by uspace now. Should it be unable
+	 * to learn how many there are, it will at least find the first one.
+	 */
+	(void) copy_to_uspace(received, &i, sizeof(i));
+	return EOK;
+}
+
 /** Interrupt one thread from sys_ipc_wait_for_call().
  *
  */
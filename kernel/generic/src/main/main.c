@@ -263,6 +263,9 @@ void main_bsp_separated_stack(void)
 	/* Slab must be initialized after we know the number of processors. */
 	slab_enable_cpucache();
 
+	/* So must the per-CPU frame caches. */
+	frame_enable_cpucache();
+
 	uint64_t size;
 	const char *size_suffix;
 	bin_order_suffix(zones_total_size(), &size, &size_suffix, false);
@@ -561,6 +561,49 @@ NO_TRACE static void sh_info_remove_reference(share_info_t *sh_info)
 	}
 }
 
+/** Map all pages of a new address space area in advance.
+ *
+ * The pages are resolved by the backend page fault handler as if they were
+ * touched. Populating is best effort, pages which cannot be resolved now
+ * are left to be faulted in on first access.
+ *
+ * @param area Address space area to be populated.
+ *
+ */
+NO_TRACE static void as_area_populate(as_area_t *area)
+{
+	assert(mutex_locked(&area->as->lock));
+
+	if ((!area->backend) || (!area->backend->page_fault))
+		return;
+
+	pf_access_t access;
+	if (area->flags & AS_AREA_WRITE)
+		access = PF_ACCESS_WRITE;
+	else if (area->flags & AS_AREA_READ)
+		access = PF_ACCESS_READ;
+	else
+		access = PF_ACCESS_EXEC;
+
+	mutex_lock(&area->lock);
+	page_table_lock(area->as, false);
+
+	for (size_t i = 0; i < area->pages; i++) {
+		uintptr_t page = area->base + P2SZ(i);
+		pte_t pte;
+
+		/* Skip pages mapped around the previous ones. */
+		if (page_mapping_find(area->as, page, false, &pte))
+			continue;
+
+		if (area->backend->page_fault(area, page, access) != AS_PF_OK)
+			break;
+	}
+
+	page_table_unlock(area->as, false);
+	mutex_unlock(&area->lock);
+}
+
 /** Create address space area of common attributes.
  *
  * The created address space area is added to the target address space.
@@ -687,6 +730,14 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 	btree_create(&area->used_space);
 	odict_insert(&area->las_areas, &as->as_areas, NULL);
 
+	/*
+	 * Backends resolve faults only in the current address space, so
+	 * populating areas of other address spaces is left to page faults.
+	 */
+	if ((flags & AS_AREA_POPULATE) && (as == AS) &&
+	    (!(attrs & AS_AREA_ATTR_PARTIAL)))
+		as_area_populate(area);
+
 	mutex_unlock(&as->lock);
 
 	return area;
@@ -721,6 +772,83 @@ NO_TRACE static as_area_t *find_area_and_lock(as_t *as, uintptr_t va)
 	return NULL;
 }
 
+/** Remove mapping of a used page and release its frame.
+ *
+ * A page covered by a large mapping takes the whole large mapping with it,
+ * so the caller must advance by the returned number of pages. Large mappings
+ * are always recorded as a whole in the used_space B+tree, which guarantees
+ * that the caller visits the first page of the large mapping.
+ *
+ * The page tables must be locked and a TLB shootdown sequence for the page
+ * must be in progress.
+ *
+ * @param area        Address space area the page belongs to.
+ * @param page        Virtual page to be unmapped.
+ * @param release     If true, frames are released by the backend.
+ * @param[out] frames If not NULL, receives the frames of the unmapped pages.
+ *
+ * @return Number of pages unmapped.
+ *
+ */
+NO_TRACE static size_t area_page_unmap(as_area_t *area, uintptr_t page,
+    bool release, uintptr_t *frames)
+{
+	pte_t pte;
+	bool found = page_mapping_find(area->as, page, false, &pte);
+
+	assert(found);
+	assert(PTE_VALID(&pte));
+	assert(PTE_PRESENT(&pte));
+
+	size_t count = 1;
+	if (page_mapping_is_large(area->as, page, false)) {
+		assert(IS_ALIGNED(page, LARGE_PAGE_SIZE));
+		count = LARGE_PAGE_FRAMES;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		uintptr_t frame = PTE_GET_FRAME(&pte) + P2SZ(i);
+
+		if (frames)
+			frames[i] = frame;
+
+		if ((release) && (area->backend) &&
+		    (area->backend->frame_free))
+			area->backend->frame_free(area, page + P2SZ(i), frame);
+	}
+
+	page_mapping_remove(area->as, page);
+	return count;
+}
+
+/** Test whether a run of used pages can be mapped by a large mapping.
+ *
+ * @param page   First page of the run.
+ * @param count  Number of pages in the run.
+ * @param frames Frames of the pages in the run.
+ *
+ * @return True if page starts a large page fully contained in the run and
+ *         the frames are physically contiguous and suitably aligned.
+ *
+ */
+NO_TRACE static bool area_frames_large(uintptr_t page, size_t count,
+    uintptr_t *frames)
+{
+	if ((LARGE_PAGE_FRAMES == 1) || (count < LARGE_PAGE_FRAMES))
+		return false;
+
+	if ((!IS_ALIGNED(page, LARGE_PAGE_SIZE)) ||
+	    (!IS_ALIGNED(frames[0], LARGE_PAGE_SIZE)))
+		return false;
+
+	for (size_t i = 1; i < LARGE_PAGE_FRAMES; i++) {
+		if (frames[i] != frames[0] + P2SZ(i))
+			return false;
+	}
+
+	return true;
+}
+
 /** Find address space area and change it.
  *
  * @param as      Address space.
@@ -791,6 +919,26 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 
 		page_table_lock(as, false);
 
+		/*
+		 * A large mapping straddling the new end of the area
+		 * must be split first so that its head can stay mapped.
+		 * This needs to allocate the new page table and thus cannot
+		 * be done inside the TLB shootdown sequence below.
+		 */
+		uintptr_t large_page = ALIGN_DOWN(start_free, LARGE_PAGE_SIZE);
+		if ((large_page != start_free) &&
+		    (page_mapping_is_large(as, start_free, false))) {
+			page_mapping_demote(as, start_free);
+
+			ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES,
+			    as->asid, large_page, LARGE_PAGE_FRAMES);
+			tlb_invalidate_pages(as->asid, large_page,
+			    LARGE_PAGE_FRAMES);
+			as_invalidate_translation_cache(as, large_page,
+			    LARGE_PAGE_FRAMES);
+			tlb_shootdown_finalize(ipl);
+		}
+
 		/*
 		 * Remove frames belonging to used space starting from
 		 * the highest addresses downwards until an overlap with
@@ -861,23 +1009,9 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 				    as->asid, area->base + P2SZ(pages),
 				    area->pages - pages);
 
-				for (; i < node_size; i++) {
-					pte_t pte;
-					bool found = page_mapping_find(as,
-					    ptr + P2SZ(i), false, &pte);
-
-					assert(found);
-					assert(PTE_VALID(&pte));
-					assert(PTE_PRESENT(&pte));
-
-					if ((area->backend) &&
-					    (area->backend->frame_free)) {
-						area->backend->frame_free(area,
-						    ptr + P2SZ(i),
-						    PTE_GET_FRAME(&pte));
-					}
-
-					page_mapping_remove(as, ptr + P2SZ(i));
+				while (i < node_size) {
+					i += area_page_unmap(area,
+					    ptr + P2SZ(i), true, NULL);
 				}
 
 				/*
@@ -974,23 +1108,10 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 			uintptr_t ptr = node->key[i];
 			size_t size;
 
-			for (size = 0; size < (size_t) node->value[i]; size++) {
-				pte_t pte;
-				bool found = page_mapping_find(as,
-				    ptr + P2SZ(size), false, &pte);
-
-				assert(found);
-				assert(PTE_VALID(&pte));
-				assert(PTE_PRESENT(&pte));
-
-				if ((area->backend) &&
-				    (area->backend->frame_free)) {
-					area->backend->frame_free(area,
-					    ptr + P2SZ(size),
-					    PTE_GET_FRAME(&pte));
-				}
-
-				page_mapping_remove(as, ptr + P2SZ(size));
+			size = 0;
+			while (size < (size_t) node->value[i]) {
+				size += area_page_unmap(area,
+				    ptr + P2SZ(size), true, NULL);
 			}
 		}
 	}
@@ -1292,19 +1413,15 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 			uintptr_t ptr = node->key[i];
 			size_t size;
 
-			for (size = 0; size < (size_t) node->value[i]; size++) {
-				pte_t pte;
-				bool found = page_mapping_find(as,
-				    ptr + P2SZ(size), false, &pte);
-
-				assert(found);
-				assert(PTE_VALID(&pte));
-				assert(PTE_PRESENT(&pte));
-
-				old_frame[frame_idx++] = PTE_GET_FRAME(&pte);
-
+			size = 0;
+			while (size < (size_t) node->value[i]) {
 				/* Remove old mapping */
-				page_mapping_remove(as, ptr + P2SZ(size));
+				size_t count = area_page_unmap(area,
+				    ptr + P2SZ(size), false,
+				    &old_frame[frame_idx]);
+
+				frame_idx += count;
+				size += count;
 			}
 		}
 	}
@@ -1344,14 +1461,31 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 			uintptr_t ptr = node->key[i];
 			size_t size;
 
-			for (size = 0; size < (size_t) node->value[i]; size++) {
+			size = 0;
+			while (size < (size_t) node->value[i]) {
 				page_table_lock(as, false);
 
-				/* Insert the new mapping */
-				page_mapping_insert(as, ptr + P2SZ(size),
-				    old_frame[frame_idx++], page_flags);
+				/*
+				 * Insert the new mapping, restoring large
+				 * mappings where the frames allow it.
+				 */
+				size_t count = 1;
+				if (area_frames_large(ptr + P2SZ(size),
+				    (size_t) node->value[i] - size,
+				    &old_frame[frame_idx]) &&
+				    page_mapping_insert_large(as,
+				    ptr + P2SZ(size), old_frame[frame_idx],
+				    page_flags)) {
+					count = LARGE_PAGE_FRAMES;
+				} else {
+					page_mapping_insert(as, ptr + P2SZ(size),
+					    old_frame[frame_idx], page_flags);
+				}
 
 				page_table_unlock(as, false);
+
+				frame_idx += count;
+				size += count;
 			}
 		}
 	}
@@ -53,6 +53,15 @@
 #include <align.h>
 #include <mem.h>
 #include <arch.h>
+#include <macros.h>
+
+/*
+ * Bounds of the window of pages mapped ahead of a sequential fault. The
+ * window starts small and doubles with each fault that continues
+ * the sequence.
+ */
+#define ANON_FAULT_AROUND_MIN  2
+#define ANON_FAULT_AROUND_MAX  16
 
 static bool anon_create(as_area_t *);
 static bool anon_resize(as_area_t *, size_t);
@@ -83,6 +92,10 @@ mem_backend_t anon_backend = {
 
 bool anon_create(as_area_t *area)
 {
+	/* Expect the area to be first touched at its beginning. */
+	area->backend_data.fault_next = area->base;
+	area->backend_data.fault_window = 0;
+
 	if (area->flags & AS_AREA_LATE_RESERVE)
 		return true;
 
@@ -174,6 +187,116 @@ bool anon_is_shareable(as_area_t *area)
 	return !(area->flags & AS_AREA_LATE_RESERVE);
 }
 
+/** Try to service a fault in a private area with a large page.
+ *
+ * The large page containing the faulting page must lie entirely within
+ * the area and none of its small pages may be mapped yet. If this is not
+ * the case or if there is not enough aligned contiguous memory, the caller
+ * falls back to small pages.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if the large mapping was inserted.
+ */
+static bool anon_large_page_fault(as_area_t *area, uintptr_t upage)
+{
+	if (LARGE_PAGE_FRAMES == 1)
+		return false;
+
+	uintptr_t lpage = ALIGN_DOWN(upage, LARGE_PAGE_SIZE);
+	if ((lpage < area->base) ||
+	    (lpage - area->base + LARGE_PAGE_SIZE > P2SZ(area->pages)))
+		return false;
+
+	if ((area->flags & AS_AREA_LATE_RESERVE) &&
+	    (!reserve_try_alloc(LARGE_PAGE_FRAMES)))
+		return false;
+
+	uintptr_t frame = frame_alloc(LARGE_PAGE_FRAMES,
+	    FRAME_LOWMEM | FRAME_ATOMIC | FRAME_NO_RESERVE,
+	    LARGE_PAGE_SIZE - 1);
+	if (!frame)
+		goto fail;
+
+	memsetb((void *) PA2KA(frame), LARGE_PAGE_SIZE, 0);
+
+	if (!page_mapping_insert_large(AS, lpage, frame,
+	    as_area_get_flags(area))) {
+		frame_free_noreserve(frame, LARGE_PAGE_FRAMES);
+		goto fail;
+	}
+
+	/*
+	 * The small pages are released one by one by anon_frame_free().
+	 */
+	if (!used_space_insert(area, lpage, LARGE_PAGE_FRAMES))
+		panic("Cannot insert used space.");
+
+	return true;
+
+fail:
+	if (area->flags & AS_AREA_LATE_RESERVE)
+		reserve_free(LARGE_PAGE_FRAMES);
+	return false;
+}
+
+/** Map a window of pages following a sequential fault in a private area.
+ *
+ * If the faulting page is the one expected to fault next, the pages
+ * following it are mapped too, so that sequential first touch of the area
+ * does not trap on every page. The window grows while the access remains
+ * sequential and stops at the first page that is already mapped or that
+ * cannot be backed right now.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page, already mapped.
+ */
+static void anon_fault_around(as_area_t *area, uintptr_t upage)
+{
+	size_t window = 0;
+	if (upage == area->backend_data.fault_next) {
+		window = min(max(2 * area->backend_data.fault_window,
+		    ANON_FAULT_AROUND_MIN), ANON_FAULT_AROUND_MAX);
+	}
+
+	size_t left = ((area->base + P2SZ(area->pages) - upage) >>
+	    PAGE_WIDTH) - 1;
+	window = min(window, left);
+
+	unsigned int flags = as_area_get_flags(area);
+	size_t count;
+
+	for (count = 0; count < window; count++) {
+		uintptr_t page = upage + P2SZ(count + 1);
+		pte_t pte;
+
+		if (page_mapping_find(AS, page, false, &pte))
+			break;
+
+		if ((area->flags & AS_AREA_LATE_RESERVE) &&
+		    (!reserve_try_alloc(1)))
+			break;
+
+		uintptr_t frame = frame_alloc(1,
+		    FRAME_LOWMEM | FRAME_ATOMIC | FRAME_NO_RESERVE, 0);
+		if (!frame) {
+			if (area->flags & AS_AREA_LATE_RESERVE)
+				reserve_free(1);
+			break;
+		}
+
+		memsetb((void *) PA2KA(frame), PAGE_SIZE, 0);
+		page_mapping_insert(AS, page, frame, flags);
+	}
+
+	if ((count > 0) && (!used_space_insert(area, upage + PAGE_SIZE, count)))
+		panic("Cannot insert used space.");
+
+	area->backend_data.fault_window = count;
+	area->backend_data.fault_next = upage + P2SZ(count + 1);
+}
+
 /** Service a page fault in the anonymous memory address space area.
  *
  * The address space area and page tables must be already locked.
@@ -189,6 +312,7 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 {
 	uintptr_t kpage;
 	uintptr_t frame;
+	bool shared;
 
 	assert(page_table_locked(AS));
 	assert(mutex_locked(&area->lock));
@@ -198,7 +322,8 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	mutex_lock(&area->sh_info->lock);
-	if (area->sh_info->shared) {
+	shared = area->sh_info->shared;
+	if (shared) {
 		btree_node_t *leaf;
 
 		/*
@@ -256,6 +381,12 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		 *   the different causes
 		 */
 
+		if ((area->flags & AS_AREA_LARGE) &&
+		    (anon_large_page_fault(area, upage))) {
+			mutex_unlock(&area->sh_info->lock);
+			return AS_PF_OK;
+		}
+
 		if (area->flags & AS_AREA_LATE_RESERVE) {
 			/*
 			 * Reserve the memory for this page now.
@@ -281,6 +412,9 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	if (!used_space_insert(area, upage, 1))
 		panic("Cannot insert used space.");
 
+	if (!shared)
+		anon_fault_around(area, upage);
+
 	return AS_PF_OK;
 }
 
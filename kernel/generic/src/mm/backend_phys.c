@@ -116,6 +116,50 @@ bool phys_is_shareable(as_area_t *area)
 	return true;
 }
 
+/** Try to map the whole large page containing the faulting page.
+ *
+ * Physical memory areas are promoted to large mappings automatically
+ * whenever the large page lies entirely within the area and the virtual
+ * and physical addresses are equally aligned.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if the large mapping was inserted.
+ */
+static bool phys_large_page_fault(as_area_t *area, uintptr_t upage)
+{
+	if (LARGE_PAGE_FRAMES == 1)
+		return false;
+
+	uintptr_t lpage = ALIGN_DOWN(upage, LARGE_PAGE_SIZE);
+	if (lpage < area->base)
+		return false;
+
+	size_t offset = lpage - area->base;
+	if ((offset + LARGE_PAGE_SIZE > P2SZ(area->pages)) ||
+	    (offset + LARGE_PAGE_SIZE >
+	    area->backend_data.frames * FRAME_SIZE))
+		return false;
+
+	uintptr_t frame = area->backend_data.base + offset;
+	if (!IS_ALIGNED(frame, LARGE_PAGE_SIZE))
+		return false;
+
+	/*
+	 * This fails if any small page of the large page is already mapped.
+	 * Otherwise none of them can be in the used space yet.
+	 */
+	if (!page_mapping_insert_large(AS, lpage, frame,
+	    as_area_get_flags(area)))
+		return false;
+
+	if (!used_space_insert(area, lpage, LARGE_PAGE_FRAMES))
+		panic("Cannot insert used space.");
+
+	return true;
+}
+
 /** Service a page fault in the address space area backed by physical memory.
  *
  * The address space area and page tables must be already locked.
@@ -139,6 +183,10 @@ int phys_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	assert(upage - area->base < area->backend_data.frames * FRAME_SIZE);
+
+	if (phys_large_page_fault(area, upage))
+		return AS_PF_OK;
+
 	page_mapping_insert(AS, upage, base + (upage - area->base),
 	    as_area_get_flags(area));
 
@@ -39,6 +39,13 @@
  * This file contains the physical frame allocator and memory zone management.
  * The frame allocator is built on top of the two-level bitmap structure.
  *
+ * Common allocations avoid searching the bitmaps: each CPU caches a small
+ * stack of single frames and freed runs of 2^order frames in low memory
+ * are kept in order-indexed free lists. Frames in these caches still look
+ * allocated to the zones (their reference count stays at one and their
+ * bits stay set). When the zones run out of memory, the caches are drained
+ * back before slab reclaiming starts.
+ *
  */
 
 #include <typedefs.h>
@@ -60,6 +67,9 @@
 #include <macros.h>
 #include <config.h>
 #include <str.h>
+#include <mem.h>
+#include <cpu.h>
+#include <atomic.h>
 #include <proc/thread.h> /* THREAD */
 
 zones_t zones;
@@ -73,6 +83,40 @@ static condvar_t mem_avail_cv;
 static size_t mem_avail_req = 0;  /**< Number of frames requested. */
 static size_t mem_avail_gen = 0;  /**< Generation counter. */
 
+/** Types of per-CPU frame caches. */
+#define FRAME_PCPU_LOWMEM   0
+#define FRAME_PCPU_HIGHMEM  1
+#define FRAME_PCPU_TYPES    2
+
+/** Per-CPU cache of single frames. */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Stacks of cached frames (most recently freed on top). */
+	pfn_t frames[FRAME_PCPU_TYPES][FRAME_PCPU_SIZE];
+
+	/** Number of frames in the stacks. */
+	size_t count[FRAME_PCPU_TYPES];
+} frame_pcpu_t;
+
+/** Free run of frames, stored in the first frame of the run itself. */
+typedef struct {
+	link_t link;
+} frame_run_t;
+
+/** Per-CPU frame caches (NULL until the number of CPUs is known). */
+static frame_pcpu_t *frame_pcpu = NULL;
+
+/** Free lists of runs of 2^order frames in low memory. */
+IRQ_SPINLOCK_STATIC_INITIALIZE(frame_runs_lock);
+static list_t frame_runs[FRAME_RUN_ORDERS];
+static size_t frame_runs_count[FRAME_RUN_ORDERS];
+
+/** Number of free frames held in the frame caches. */
+static atomic_size_t frames_cached;
+
+static size_t frame_cache_drain_all(void);
+
 /** Initialize frame structure.
  *
  * @param frame Frame structure to be initialized.
@@ -163,7 +207,7 @@ NO_TRACE static size_t frame_total_free_get_internal(void)
 	for (i = 0; i < zones.count; i++)
 		total += zones.info[i].free_count;
 
-	return total;
+	return total + atomic_load(&frames_cached);
 }
 
 NO_TRACE size_t frame_total_free_get(void)
@@ -533,6 +577,9 @@ NO_TRACE static void return_config_frames(size_t znum, pfn_t pfn, size_t count)
  */
 bool zone_merge(size_t z1, size_t z2)
 {
+	/* The zone layout changes, do not keep any frames cached */
+	(void) frame_cache_drain_all();
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	bool ret = true;
@@ -828,6 +875,366 @@ static size_t try_find_zone(size_t count, bool lowmem,
 	    frame_constraint, hint);
 }
 
+/****************/
+/* Frame caches */
+/****************/
+
+/** Return cached frames to their zone.
+ *
+ * Assume interrupts are disabled and zones lock is
+ * locked.
+ *
+ * @param pfn   First frame to return.
+ * @param count Number of frames to return.
+ *
+ */
+NO_TRACE static void frame_cache_release(pfn_t pfn, size_t count)
+{
+	size_t znum = find_zone(pfn, count, 0);
+
+	assert(znum != (size_t) -1);
+
+	for (size_t i = 0; i < count; i++)
+		(void) zone_frame_free(&zones.info[znum],
+		    pfn - zones.info[znum].base + i);
+
+	atomic_fetch_sub(&frames_cached, count);
+}
+
+/** Refill per-CPU frame cache from the zones.
+ *
+ * Assume interrupts are disabled and the per-CPU
+ * cache is locked.
+ *
+ * @param pcpu Per-CPU frame cache.
+ * @param type Type of memory to refill.
+ *
+ */
+NO_TRACE static void frame_pcpu_refill(frame_pcpu_t *pcpu, size_t type)
+{
+	size_t hint = 0;
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	while (pcpu->count[type] < FRAME_PCPU_BATCH) {
+		size_t znum = try_find_zone(1, type == FRAME_PCPU_LOWMEM, 0,
+		    hint);
+		if (znum == (size_t) -1)
+			break;
+
+		pcpu->frames[type][pcpu->count[type]++] =
+		    zone_frame_alloc(&zones.info[znum], 1, 0) +
+		    zones.info[znum].base;
+		atomic_inc(&frames_cached);
+
+		hint = znum;
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+}
+
+/** Allocate single frame from the per-CPU frame cache.
+ *
+ * @param lowmem Allocate from low memory.
+ *
+ * @return Physical address of the allocated frame or 0.
+ *
+ */
+NO_TRACE static uintptr_t frame_pcpu_alloc(bool lowmem)
+{
+	uintptr_t addr = 0;
+	ipl_t ipl = interrupts_disable();
+
+	if ((frame_pcpu != NULL) && (CPU != NULL)) {
+		frame_pcpu_t *pcpu = &frame_pcpu[CPU->id];
+		size_t type = lowmem ? FRAME_PCPU_LOWMEM : FRAME_PCPU_HIGHMEM;
+
+		irq_spinlock_lock(&pcpu->lock, false);
+
+		if (pcpu->count[type] == 0)
+			frame_pcpu_refill(pcpu, type);
+
+		if (pcpu->count[type] > 0) {
+			addr = PFN2ADDR(pcpu->frames[type][--pcpu->count[type]]);
+			atomic_dec(&frames_cached);
+		}
+
+		irq_spinlock_unlock(&pcpu->lock, false);
+	}
+
+	interrupts_restore(ipl);
+	return addr;
+}
+
+/** Put single frame into the per-CPU frame cache.
+ *
+ * If the cache is full, the coldest frames are returned to the zones.
+ *
+ * @param pfn  Frame to cache.
+ * @param type Type of memory of the frame.
+ *
+ */
+NO_TRACE static void frame_pcpu_put(pfn_t pfn, size_t type)
+{
+	ipl_t ipl = interrupts_disable();
+
+	if (CPU == NULL) {
+		irq_spinlock_lock(&zones.lock, false);
+		frame_cache_release(pfn, 1);
+		irq_spinlock_unlock(&zones.lock, false);
+
+		interrupts_restore(ipl);
+		return;
+	}
+
+	frame_pcpu_t *pcpu = &frame_pcpu[CPU->id];
+	irq_spinlock_lock(&pcpu->lock, false);
+
+	if (pcpu->count[type] == FRAME_PCPU_SIZE) {
+		irq_spinlock_lock(&zones.lock, false);
+
+		for (size_t i = 0; i < FRAME_PCPU_BATCH; i++)
+			frame_cache_release(pcpu->frames[type][i], 1);
+
+		irq_spinlock_unlock(&zones.lock, false);
+
+		pcpu->count[type] -= FRAME_PCPU_BATCH;
+		memmove(&pcpu->frames[type][0],
+		    &pcpu->frames[type][FRAME_PCPU_BATCH],
+		    pcpu->count[type] * sizeof(pfn_t));
+	}
+
+	pcpu->frames[type][pcpu->count[type]++] = pfn;
+
+	irq_spinlock_unlock(&pcpu->lock, false);
+	interrupts_restore(ipl);
+}
+
+/** Allocate run of frames from the run free lists.
+ *
+ * @param order      Order of the run.
+ * @param constraint Indication of bits that cannot be set in the
+ *                   physical frame number of the first frame.
+ *
+ * @return Physical address of the first frame of the run or 0.
+ *
+ */
+NO_TRACE static uintptr_t frame_run_alloc(size_t order, pfn_t constraint)
+{
+	irq_spinlock_lock(&frame_runs_lock, true);
+
+	list_foreach(frame_runs[order], link, frame_run_t, run) {
+		pfn_t pfn = ADDR2PFN(KA2PA((uintptr_t) run));
+		if ((pfn & constraint) != 0)
+			continue;
+
+		list_remove(&run->link);
+		frame_runs_count[order]--;
+		atomic_fetch_sub(&frames_cached, (size_t) 1 << order);
+
+		irq_spinlock_unlock(&frame_runs_lock, true);
+		return PFN2ADDR(pfn);
+	}
+
+	irq_spinlock_unlock(&frame_runs_lock, true);
+	return 0;
+}
+
+/** Put run of frames in low memory into the run free lists.
+ *
+ * @param pfn   First frame of the run.
+ * @param order Order of the run.
+ *
+ */
+NO_TRACE static void frame_run_put(pfn_t pfn, size_t order)
+{
+	frame_run_t *run = (frame_run_t *) PA2KA(PFN2ADDR(pfn));
+	link_initialize(&run->link);
+
+	irq_spinlock_lock(&frame_runs_lock, true);
+
+	if (frame_runs_count[order] < FRAME_RUN_MAX) {
+		list_prepend(&run->link, &frame_runs[order]);
+		frame_runs_count[order]++;
+
+		irq_spinlock_unlock(&frame_runs_lock, true);
+		return;
+	}
+
+	irq_spinlock_unlock(&frame_runs_lock, true);
+
+	irq_spinlock_lock(&zones.lock, true);
+	frame_cache_release(pfn, (size_t) 1 << order);
+	irq_spinlock_unlock(&zones.lock, true);
+}
+
+/** Allocate frames from the frame caches.
+ *
+ * @param count      Number of continuous frames to allocate.
+ * @param lowmem     Allocate from low memory.
+ * @param constraint Indication of bits that cannot be set in the
+ *                   physical frame number of the first allocated frame.
+ *
+ * @return Physical address of the allocated frames or 0.
+ *
+ */
+NO_TRACE static uintptr_t frame_cache_alloc(size_t count, bool lowmem,
+    pfn_t constraint)
+{
+	if (frame_pcpu == NULL)
+		return 0;
+
+	if ((count == 1) && (constraint == 0))
+		return frame_pcpu_alloc(lowmem);
+
+	if ((lowmem) && (count > 1) && (ispwr2(count)) &&
+	    (fnzb(count) < FRAME_RUN_ORDERS))
+		return frame_run_alloc(fnzb(count), constraint);
+
+	return 0;
+}
+
+/** Try to put freed frames into the frame caches.
+ *
+ * Only frames whose last reference is being dropped
+ * by the caller are cached.
+ *
+ * @param pfn   First frame to free.
+ * @param count Number of frames to free.
+ *
+ * @return True if the frames were cached.
+ *
+ */
+NO_TRACE static bool frame_cache_free(pfn_t pfn, size_t count)
+{
+	if ((frame_pcpu == NULL) || (!ispwr2(count)) ||
+	    (fnzb(count) >= FRAME_RUN_ORDERS))
+		return false;
+
+	size_t order = fnzb(count);
+
+	irq_spinlock_lock(&zones.lock, true);
+
+	size_t znum = find_zone(pfn, count, 0);
+	if (znum == (size_t) -1) {
+		irq_spinlock_unlock(&zones.lock, true);
+		return false;
+	}
+
+	zone_t *zone = &zones.info[znum];
+	zone_flags_t flags = zone->flags;
+
+	bool cacheable = (flags & ZONE_AVAILABLE) &&
+	    ((order == 0) || (flags & ZONE_LOWMEM));
+
+	for (size_t i = 0; (cacheable) && (i < count); i++) {
+		if (zone_get_frame(zone, pfn - zone->base + i)->refcount != 1)
+			cacheable = false;
+	}
+
+	if (cacheable)
+		atomic_fetch_add(&frames_cached, count);
+
+	irq_spinlock_unlock(&zones.lock, true);
+
+	if (!cacheable)
+		return false;
+
+	if (order == 0)
+		frame_pcpu_put(pfn, (flags & ZONE_HIGHMEM) ?
+		    FRAME_PCPU_HIGHMEM : FRAME_PCPU_LOWMEM);
+	else
+		frame_run_put(pfn, order);
+
+	return true;
+}
+
+/** Return all frames held in the frame caches to the zones.
+ *
+ * @return Number of frames returned.
+ *
+ */
+NO_TRACE static size_t frame_cache_drain_all(void)
+{
+	if (frame_pcpu == NULL)
+		return 0;
+
+	size_t drained = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&frame_pcpu[i].lock, true);
+		irq_spinlock_lock(&zones.lock, false);
+
+		for (size_t type = 0; type < FRAME_PCPU_TYPES; type++) {
+			for (size_t j = 0; j < frame_pcpu[i].count[type]; j++)
+				frame_cache_release(frame_pcpu[i].frames[type][j], 1);
+
+			drained += frame_pcpu[i].count[type];
+			frame_pcpu[i].count[type] = 0;
+		}
+
+		irq_spinlock_unlock(&zones.lock, false);
+		irq_spinlock_unlock(&frame_pcpu[i].lock, true);
+	}
+
+	list_t runs[FRAME_RUN_ORDERS];
+
+	irq_spinlock_lock(&frame_runs_lock, true);
+
+	for (size_t order = 1; order < FRAME_RUN_ORDERS; order++) {
+		list_initialize(&runs[order]);
+		list_concat(&runs[order], &frame_runs[order]);
+		frame_runs_count[order] = 0;
+	}
+
+	irq_spinlock_unlock(&frame_runs_lock, true);
+
+	irq_spinlock_lock(&zones.lock, true);
+
+	for (size_t order = 1; order < FRAME_RUN_ORDERS; order++) {
+		while (!list_empty(&runs[order])) {
+			frame_run_t *run = list_get_instance(
+			    list_first(&runs[order]), frame_run_t, link);
+			list_remove(&run->link);
+
+			frame_cache_release(ADDR2PFN(KA2PA((uintptr_t) run)),
+			    (size_t) 1 << order);
+			drained += (size_t) 1 << order;
+		}
+	}
+
+	irq_spinlock_unlock(&zones.lock, true);
+
+	return drained;
+}
+
+/** Enable the frame caches.
+ *
+ * Kernel calls this function when it knows the
+ * real number of processors.
+ *
+ */
+void frame_enable_cpucache(void)
+{
+	frame_pcpu_t *pcpu = malloc(sizeof(frame_pcpu_t) * config.cpu_count);
+	if (pcpu == NULL) {
+		log(LF_OTHER, LVL_WARN, "Cannot allocate per-CPU frame caches.");
+		return;
+	}
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		memsetb(&pcpu[i], sizeof(pcpu[i]), 0);
+		irq_spinlock_initialize(&pcpu[i].lock, "frame.pcpu.lock");
+	}
+
+	for (size_t order = 0; order < FRAME_RUN_ORDERS; order++) {
+		list_initialize(&frame_runs[order]);
+		frame_runs_count[order] = 0;
+	}
+
+	frame_pcpu = pcpu;
+}
+
 /** Allocate frames of physical memory.
  *
  * @param count      Number of continuous frames to allocate.
@@ -853,17 +1260,49 @@ uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_force_alloc(count);
 
-loop:
-	irq_spinlock_lock(&zones.lock, true);
-
 	// TODO: Print diagnostic if neither is explicitly specified.
 	bool lowmem = (flags & FRAME_LOWMEM) || !(flags & FRAME_HIGHMEM);
 
+	/*
+	 * Try the frame caches first, they do not need to
+	 * search the bitmaps.
+	 */
+	uintptr_t cached = frame_cache_alloc(count, lowmem, frame_constraint);
+	if (cached != 0) {
+		if (pzone) {
+			irq_spinlock_lock(&zones.lock, true);
+			size_t znum = find_zone(ADDR2PFN(cached), count, hint);
+			irq_spinlock_unlock(&zones.lock, true);
+
+			assert(znum != (size_t) -1);
+			*pzone = znum;
+		}
+
+		return cached;
+	}
+
+loop:
+	irq_spinlock_lock(&zones.lock, true);
+
 	/*
 	 * First, find suitable frame zone.
 	 */
 	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint);
 
+	/*
+	 * The free frames might be held in the frame caches,
+	 * return them to the zones before reclaiming.
+	 */
+	if (znum == (size_t) -1) {
+		irq_spinlock_unlock(&zones.lock, true);
+		size_t drained = frame_cache_drain_all();
+		irq_spinlock_lock(&zones.lock, true);
+
+		if (drained > 0)
+			znum = try_find_zone(count, lowmem,
+			    frame_constraint, hint);
+	}
+
 	/*
 	 * If no memory, reclaim some slab memory,
 	 * if it does not help, reclaim all.
@@ -871,6 +1310,7 @@ loop:
 	if ((znum == (size_t) -1) && (!(flags & FRAME_NO_RECLAIM))) {
 		irq_spinlock_unlock(&zones.lock, true);
 		size_t freed = slab_reclaim(0);
+		freed += frame_cache_drain_all();
 		irq_spinlock_lock(&zones.lock, true);
 
 		if (freed > 0)
@@ -880,6 +1320,7 @@ loop:
 		if (znum == (size_t) -1) {
 			irq_spinlock_unlock(&zones.lock, true);
 			freed = slab_reclaim(SLAB_RECLAIM_ALL);
+			freed += frame_cache_drain_all();
 			irq_spinlock_lock(&zones.lock, true);
 
 			if (freed > 0)
@@ -975,22 +1416,26 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 {
 	size_t freed = 0;
 
-	irq_spinlock_lock(&zones.lock, true);
+	if (frame_cache_free(ADDR2PFN(start), count)) {
+		freed = count;
+	} else {
+		irq_spinlock_lock(&zones.lock, true);
 
-	for (size_t i = 0; i < count; i++) {
-		/*
-		 * First, find host frame zone for addr.
-		 */
-		pfn_t pfn = ADDR2PFN(start) + i;
-		size_t znum = find_zone(pfn, 1, 0);
+		for (size_t i = 0; i < count; i++) {
+			/*
+			 * First, find host frame zone for addr.
+			 */
+			pfn_t pfn = ADDR2PFN(start) + i;
+			size_t znum = find_zone(pfn, 1, 0);
 
-		assert(znum != (size_t) -1);
+			assert(znum != (size_t) -1);
 
-		freed += zone_frame_free(&zones.info[znum],
-		    pfn - zones.info[znum].base);
-	}
+			freed += zone_frame_free(&zones.info[znum],
+			    pfn - zones.info[znum].base);
+		}
 
-	irq_spinlock_unlock(&zones.lock, true);
+		irq_spinlock_unlock(&zones.lock, true);
+	}
 
 	/*
 	 * Signal that some memory has been freed.
@@ -1056,6 +1501,9 @@ NO_TRACE void frame_reference_add(pfn_t pfn)
  */
 NO_TRACE void frame_mark_unavailable(pfn_t start, size_t count)
 {
+	/* Cached frames look allocated, give them back first */
+	(void) frame_cache_drain_all();
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	for (size_t i = 0; i < count; i++) {
@@ -1189,6 +1637,11 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 			*unavail += (uint64_t) FRAMES2SIZE(zones.info[i].count);
 	}
 
+	/* Cached frames are accounted as busy in the zones */
+	uint64_t cached = (uint64_t) FRAMES2SIZE(atomic_load(&frames_cached));
+	*busy -= min(*busy, cached);
+	*free += cached;
+
 	irq_spinlock_unlock(&zones.lock, true);
 }
 
@@ -1311,6 +1764,11 @@ void zones_print_list(void)
 	    false);
 	printf("Available high priority: %zu frames (%" PRIu64 " %s)\n",
 	    free_highprio, size, size_suffix);
+
+	size_t cached = atomic_load(&frames_cached);
+	bin_order_suffix(FRAMES2SIZE(cached), &size, &size_suffix, false);
+	printf("Cached (counted busy):   %zu frames (%" PRIu64 " %s)\n",
+	    cached, size, size_suffix);
 }
 
 /** Prints zone details.
@@ -189,6 +189,92 @@ void page_mapping_make_global(uintptr_t base, size_t size)
 	return page_mapping_operations->mapping_make_global(base, size);
 }
 
+/** Insert large mapping of page to frame.
+ *
+ * Map LARGE_PAGE_SIZE bytes starting at page to the physically contiguous
+ * memory starting at frame. Both addresses must be aligned to
+ * LARGE_PAGE_SIZE.
+ *
+ * @param as    Address space to which page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame of the large page.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return True if the large mapping was inserted. False if the architecture
+ *         does not support large pages or if some small page within the
+ *         range is already mapped. In that case nothing is changed and the
+ *         caller should fall back to page_mapping_insert().
+ *
+ */
+NO_TRACE bool page_mapping_insert_large(as_t *as, uintptr_t page,
+    uintptr_t frame, unsigned int flags)
+{
+	assert(page_table_locked(as));
+	assert(IS_ALIGNED(page, LARGE_PAGE_SIZE));
+	assert(IS_ALIGNED(frame, LARGE_PAGE_SIZE));
+
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_insert_large)
+		return false;
+
+	if (!page_mapping_operations->mapping_insert_large(as, page, frame,
+	    flags))
+		return false;
+
+	/* Repel prefetched accesses to the old mapping. */
+	memory_barrier();
+	return true;
+}
+
+/** Test whether page is mapped by a large mapping.
+ *
+ * Note that page_mapping_remove() called on any page within a large mapping
+ * removes the whole large mapping.
+ *
+ * @param as     Address space to which page belongs.
+ * @param page   Virtual page.
+ * @param nolock True if the page tables need not be locked.
+ *
+ * @return True if page is covered by a large mapping.
+ */
+NO_TRACE bool page_mapping_is_large(as_t *as, uintptr_t page, bool nolock)
+{
+	assert(nolock || page_table_locked(as));
+
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_is_large)
+		return false;
+
+	return page_mapping_operations->mapping_is_large(as,
+	    ALIGN_DOWN(page, PAGE_SIZE), nolock);
+}
+
+/** Split the large mapping covering page into small mappings.
+ *
+ * The translation does not change, but the caller should invalidate
+ * the TLB for the whole large page afterwards. This function may
+ * allocate memory and so it must not be called from within a TLB
+ * shootdown sequence.
+ *
+ * @param as   Address space to which page belongs.
+ * @param page Virtual page within the large mapping.
+ *
+ */
+NO_TRACE void page_mapping_demote(as_t *as, uintptr_t page)
+{
+	assert(page_table_locked(as));
+
+	assert(page_mapping_operations);
+	assert(page_mapping_operations->mapping_demote);
+
+	page_mapping_operations->mapping_demote(as,
+	    ALIGN_DOWN(page, LARGE_PAGE_SIZE));
+
+	memory_barrier();
+}
+
 errno_t page_find_mapping(uintptr_t virt, uintptr_t *phys)
 {
 	page_table_lock(AS, true);
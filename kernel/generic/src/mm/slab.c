@@ -45,8 +45,6 @@
  *
  * Following features are not currently supported but would be easy to do:
  * @li cache coloring
- * @li dynamic magazine growing (different magazine sizes are already
- *     supported, but we would need to adjust allocation strategy)
  *
  * The slab allocator supports per-CPU caches ('magazines') to facilitate
  * good SMP scaling.
@@ -66,6 +64,14 @@
  * size boundary. LIFO order is enforced, which should avoid fragmentation
  * as much as possible.
  *
+ * The magazine size is tuned per cache. Each cache starts with magazines
+ * of SLAB_MAG_SIZE_MIN objects. Whenever the CPUs contend for the lock of
+ * the cache-shared magazine list (the 'depot') often enough, the size of
+ * newly allocated magazines is doubled (up to SLAB_MAG_SIZE_MAX), so that
+ * busy caches visit the depot less often. Magazines of different sizes
+ * can coexist in one cache. Under memory stress the size drops back to
+ * the minimum.
+ *
  * Every cache contains list of full slabs and list of partially full slabs.
  * Empty slabs are immediately freed (thrashing will be avoided because
  * of magazines).
@@ -115,12 +121,22 @@
 #include <bitops.h>
 #include <macros.h>
 #include <cpu.h>
+#include <str.h>
 
 IRQ_SPINLOCK_STATIC_INITIALIZE(slab_cache_lock);
 static LIST_INITIALIZE(slab_cache_list);
 
-/** Magazine cache */
-static slab_cache_t mag_cache;
+/** Magazine caches (one for each magazine size) */
+static slab_cache_t mag_caches[SLAB_MAG_CLASSES];
+
+/** Names of the magazine caches (sizes SLAB_MAG_SIZE_MIN to SLAB_MAG_SIZE_MAX) */
+static const char *mag_names[SLAB_MAG_CLASSES] = {
+	"slab_magazine-4",
+	"slab_magazine-8",
+	"slab_magazine-16",
+	"slab_magazine-32",
+	"slab_magazine-64"
+};
 
 /** Cache for cache descriptors */
 static slab_cache_t slab_cache_cache;
@@ -326,6 +342,8 @@ NO_TRACE static void *slab_obj_create(slab_cache_t *cache, unsigned int flags)
 		list_remove(&slab->link);
 	}
 
+	cache->slab_allocs++;
+
 	void *obj = slab->start + slab->nextavail * cache->size;
 	slab->nextavail = *((size_t *) obj);
 	slab->available--;
@@ -350,6 +368,42 @@ NO_TRACE static void *slab_obj_create(slab_cache_t *cache, unsigned int flags)
 /* CPU-Cache slab functions */
 /****************************/
 
+/** Return the magazine cache for magazines of given size
+ *
+ */
+NO_TRACE static slab_cache_t *mag_cache_get(size_t size)
+{
+	assert(size >= SLAB_MAG_SIZE_MIN);
+	assert(size <= SLAB_MAG_SIZE_MAX);
+
+	return &mag_caches[fnzb(size) - fnzb(SLAB_MAG_SIZE_MIN)];
+}
+
+/** Lock the magazine list of a cache
+ *
+ * Contended acquisitions of the lock are counted. Once there are
+ * SLAB_MAG_CONTENTION_LIMIT of them, the size of newly allocated
+ * magazines is doubled so that the CPUs visit the magazine list
+ * less often.
+ *
+ * Interrupts must be disabled.
+ *
+ */
+NO_TRACE static void maglock_lock(slab_cache_t *cache)
+{
+	if (irq_spinlock_trylock(&cache->maglock))
+		return;
+
+	irq_spinlock_lock(&cache->maglock, false);
+	cache->depot_contention++;
+
+	if ((++cache->mag_contention >= SLAB_MAG_CONTENTION_LIMIT) &&
+	    (cache->mag_size < SLAB_MAG_SIZE_MAX)) {
+		cache->mag_size <<= 1;
+		cache->mag_contention = 0;
+	}
+}
+
 /** Find a full magazine in cache, take it from list and return it
  *
  * @param first If true, return first, else last mag.
@@ -361,7 +415,10 @@ NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 	slab_magazine_t *mag = NULL;
 	link_t *cur;
 
-	irq_spinlock_lock(&cache->maglock, true);
+	ipl_t ipl = interrupts_disable();
+	maglock_lock(cache);
+	cache->depot_trips++;
+
 	if (!list_empty(&cache->magazines)) {
 		if (first)
 			cur = list_first(&cache->magazines);
@@ -372,7 +429,9 @@ NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 		list_remove(&mag->link);
 		atomic_dec(&cache->magazine_counter);
 	}
-	irq_spinlock_unlock(&cache->maglock, true);
+
+	irq_spinlock_unlock(&cache->maglock, false);
+	interrupts_restore(ipl);
 
 	return mag;
 }
@@ -383,12 +442,15 @@ NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
 NO_TRACE static void put_mag_to_cache(slab_cache_t *cache,
     slab_magazine_t *mag)
 {
-	irq_spinlock_lock(&cache->maglock, true);
+	ipl_t ipl = interrupts_disable();
+	maglock_lock(cache);
+	cache->depot_trips++;
 
 	list_prepend(&mag->link, &cache->magazines);
 	atomic_inc(&cache->magazine_counter);
 
-	irq_spinlock_unlock(&cache->maglock, true);
+	irq_spinlock_unlock(&cache->maglock, false);
+	interrupts_restore(ipl);
 }
 
 /** Free all objects in magazine and free memory associated with magazine
@@ -407,7 +469,7 @@ NO_TRACE static size_t magazine_destroy(slab_cache_t *cache,
 		atomic_dec(&cache->cached_objs);
 	}
 
-	slab_free(&mag_cache, mag);
+	slab_free(mag_cache_get(mag->size), mag);
 
 	return frames;
 }
@@ -466,6 +528,7 @@ NO_TRACE static void *magazine_obj_get(slab_cache_t *cache)
 	}
 
 	void *obj = mag->objs[--mag->busy];
+	cache->mag_cache[CPU->id].hits++;
 	irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
 
 	atomic_dec(&cache->cached_objs);
@@ -502,18 +565,24 @@ NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache)
 
 	/* current | last are full | nonexistent, allocate new */
 
+	/*
+	 * The magazine size is only a hint, so it is fine
+	 * to read it without holding the maglock.
+	 */
+	size_t size = cache->mag_size;
+
 	/*
 	 * We do not want to sleep just because of caching,
 	 * especially we do not want reclaiming to start, as
 	 * this would deadlock.
 	 *
 	 */
-	slab_magazine_t *newmag = slab_alloc(&mag_cache,
+	slab_magazine_t *newmag = slab_alloc(mag_cache_get(size),
 	    FRAME_ATOMIC | FRAME_NO_RECLAIM);
 	if (!newmag)
 		return NULL;
 
-	newmag->size = SLAB_MAG_SIZE;
+	newmag->size = size;
 	newmag->busy = 0;
 
 	/* Flush last to magazine list */
@@ -546,6 +615,7 @@ NO_TRACE static int magazine_obj_put(slab_cache_t *cache, void *obj)
 	}
 
 	mag->objs[mag->busy++] = obj;
+	cache->mag_cache[CPU->id].hits++;
 
 	irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
 
@@ -633,6 +703,7 @@ NO_TRACE static void _slab_cache_create(slab_cache_t *cache, const char *name,
 
 	irq_spinlock_initialize(&cache->slablock, "slab.cache.slablock");
 	irq_spinlock_initialize(&cache->maglock, "slab.cache.maglock");
+	cache->mag_size = SLAB_MAG_SIZE_MIN;
 
 	if (!(cache->flags & SLAB_CACHE_NOMAGAZINE))
 		(void) make_magcache(cache);
@@ -701,6 +772,12 @@ NO_TRACE static size_t _slab_reclaim(slab_cache_t *cache, unsigned int flags)
 	}
 
 	if (flags & SLAB_RECLAIM_ALL) {
+		/* Large magazines hold too much memory under stress */
+		irq_spinlock_lock(&cache->maglock, true);
+		cache->mag_size = SLAB_MAG_SIZE_MIN;
+		cache->mag_contention = 0;
+		irq_spinlock_unlock(&cache->maglock, true);
+
 		/* Free cpu-bound magazines */
 		/* Destroy CPU magazines */
 		size_t i;
@@ -826,7 +903,7 @@ size_t slab_reclaim(unsigned int flags)
 void slab_print_list(void)
 {
 	printf("[cache name      ] [size  ] [pages ] [obj/pg] [slabs ]"
-	    " [cached] [alloc ] [ctl]\n");
+	    " [cached] [alloc ] [mag] [ctl]\n");
 
 	size_t skip = 0;
 	while (true) {
@@ -878,24 +955,110 @@ void slab_print_list(void)
 		long allocated_slabs = atomic_load(&cache->allocated_slabs);
 		long cached_objs = atomic_load(&cache->cached_objs);
 		long allocated_objs = atomic_load(&cache->allocated_objs);
+		size_t mag_size = cache->mag_size;
 		unsigned int flags = cache->flags;
 
 		irq_spinlock_unlock(&slab_cache_lock, true);
 
-		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld %-5s\n",
+		if (flags & SLAB_CACHE_NOMAGAZINE)
+			mag_size = 0;
+
+		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld %5zu %-5s\n",
 		    name, size, frames, objects, allocated_slabs,
-		    cached_objs, allocated_objs,
+		    cached_objs, allocated_objs, mag_size,
 		    flags & SLAB_CACHE_SLINSIDE ? "in" : "out");
 	}
 }
 
+/** Get the number of slab caches
+ *
+ * The number is only a hint for slab_stats(),
+ * caches might be created or destroyed meanwhile.
+ *
+ */
+size_t slab_stats_count(void)
+{
+	irq_spinlock_lock(&slab_cache_lock, true);
+	size_t count = list_count(&slab_cache_list);
+	irq_spinlock_unlock(&slab_cache_lock, true);
+
+	return count;
+}
+
+/** Gather statistics of slab caches
+ *
+ * @param stats Array of statistics to fill in.
+ * @param count Number of entries in the array.
+ *
+ * @return Number of entries actually filled in.
+ *
+ */
+size_t slab_stats(stats_slab_t *stats, size_t count)
+{
+	irq_spinlock_lock(&slab_cache_lock, true);
+
+	size_t i = 0;
+	list_foreach(slab_cache_list, link, slab_cache_t, cache) {
+		if (i == count)
+			break;
+
+		stats_slab_t *stat = &stats[i++];
+
+		str_cpy(stat->name, SLAB_NAME_BUFLEN, cache->name);
+		stat->size = cache->size;
+		stat->frames = cache->frames;
+		stat->objects = cache->objects;
+		stat->slabs = atomic_load(&cache->allocated_slabs);
+		stat->allocated = atomic_load(&cache->allocated_objs);
+		stat->cached = atomic_load(&cache->cached_objs);
+		stat->mag_hits = 0;
+
+		if ((cache->flags & SLAB_CACHE_NOMAGAZINE) ||
+		    (cache->mag_cache == NULL)) {
+			stat->magazine_size = 0;
+		} else {
+			for (size_t cpu = 0; cpu < config.cpu_count; cpu++) {
+				irq_spinlock_lock(&cache->mag_cache[cpu].lock,
+				    false);
+				stat->mag_hits += cache->mag_cache[cpu].hits;
+				irq_spinlock_unlock(&cache->mag_cache[cpu].lock,
+				    false);
+			}
+
+			stat->magazine_size = cache->mag_size;
+		}
+
+		irq_spinlock_lock(&cache->maglock, false);
+		stat->depot_trips = cache->depot_trips;
+		stat->depot_contention = cache->depot_contention;
+		irq_spinlock_unlock(&cache->maglock, false);
+
+		irq_spinlock_lock(&cache->slablock, false);
+		stat->slab_allocs = cache->slab_allocs;
+		irq_spinlock_unlock(&cache->slablock, false);
+	}
+
+	irq_spinlock_unlock(&slab_cache_lock, true);
+
+	return i;
+}
+
 void slab_cache_init(void)
 {
-	/* Initialize magazine cache */
-	_slab_cache_create(&mag_cache, "slab_magazine_t",
-	    sizeof(slab_magazine_t) + SLAB_MAG_SIZE * sizeof(void *),
-	    sizeof(uintptr_t), NULL, NULL, SLAB_CACHE_NOMAGAZINE |
-	    SLAB_CACHE_SLINSIDE);
+	/* Initialize magazine caches */
+	size_t i;
+	size_t size;
+
+	static_assert((SLAB_MAG_SIZE_MIN == 4) && (SLAB_MAG_SIZE_MAX == 64),
+	    "Magazine cache names do not match the magazine sizes");
+
+	for (i = 0, size = SLAB_MAG_SIZE_MIN; i < SLAB_MAG_CLASSES;
+	    i++, size <<= 1) {
+		_slab_cache_create(&mag_caches[i], mag_names[i],
+		    sizeof(slab_magazine_t) + size * sizeof(void *),
+		    sizeof(uintptr_t), NULL, NULL, SLAB_CACHE_NOMAGAZINE |
+		    SLAB_CACHE_SLINSIDE);
+	}
 
 	/* Initialize slab_cache cache */
 	_slab_cache_create(&slab_cache_cache, "slab_cache_cache",
@@ -907,9 +1070,6 @@ void slab_cache_init(void)
 	    NULL, NULL, SLAB_CACHE_SLINSIDE | SLAB_CACHE_MAGDEFERRED);
 
 	/* Initialize structures for malloc */
-	size_t i;
-	size_t size;
-
 	for (i = 0, size = (1 << SLAB_MIN_MALLOC_W);
 	    i < (SLAB_MAX_MALLOC_W - SLAB_MIN_MALLOC_W + 1);
 	    i++, size <<= 1) {
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <mm/slab.h>
+#include <proc/thread.h>
+#include <arch.h>
+#include <config.h>
+#include <cpu.h>
+#include <macros.h>
+#include <atomic.h>
+
+/*
+ * Each CPU runs one wired thread that repeatedly allocates a batch of
+ * objects from a shared cache, stamps them, verifies the stamps and
+ * frees them again. The batches are bigger than the largest magazine,
+ * so that the magazines are exchanged with the depot all the time and
+ * the depot lock is contended.
+ */
+
+#define MAX_CPUS    64
+#define ITERATIONS  2000
+#define BATCH       (2 * SLAB_MAG_SIZE_MAX + 1)
+#define ITEM_SIZE   64
+
+static slab_cache_t *hammer_cache;
+static atomic_size_t hammer_errors;
+
+static void hammer(void *arg)
+{
+	uintptr_t stamp = (uintptr_t) arg;
+	void *objs[BATCH];
+
+	for (int iter = 0; iter < ITERATIONS; iter++) {
+		/* Vary the batch size to mix magazine hits and depot trips */
+		size_t count = 1 + (iter % BATCH);
+
+		for (size_t i = 0; i < count; i++) {
+			objs[i] = slab_alloc(hammer_cache, 0);
+			*((uintptr_t *) objs[i]) = stamp;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			if (*((uintptr_t *) objs[i]) != stamp)
+				atomic_inc(&hammer_errors);
+
+			slab_free(hammer_cache, objs[i]);
+		}
+	}
+}
+
+const char *test_slab3(void)
+{
+	thread_t *thread[MAX_CPUS] = { NULL };
+	unsigned int cpu_count = min(config.cpu_active, MAX_CPUS);
+
+	atomic_store(&hammer_errors, 0);
+	hammer_cache = slab_cache_create("test_cache3", ITEM_SIZE, 0, NULL,
+	    NULL, 0);
+
+	TPRINTF("Hammering slab cache from %u cpus.\n", cpu_count);
+
+	for (unsigned int id = 0; id < cpu_count; id++) {
+		thread[id] = thread_create(hammer, (void *) (uintptr_t) (id + 1),
+		    TASK, THREAD_FLAG_NONE, "slab-hammer");
+
+		if (thread[id])
+			thread_wire(thread[id], &cpus[id]);
+		else
+			TPRINTF("Failed to create thread on cpu%u.\n", id);
+	}
+
+	for (unsigned int id = 0; id < cpu_count; id++) {
+		if (thread[id] != NULL)
+			thread_ready(thread[id]);
+	}
+
+	for (unsigned int id = 0; id < cpu_count; id++) {
+		if (thread[id] != NULL) {
+			thread_join(thread[id]);
+			thread_detach(thread[id]);
+		}
+	}
+
+	if (!test_quiet)
+		slab_print_list();
+
+	size_t allocated = atomic_load(&hammer_cache->allocated_objs);
+	size_t errors = atomic_load(&hammer_errors);
+
+	slab_cache_destroy(hammer_cache);
+
+	if (errors != 0)
+		return "Object shared by two threads";
+
+	if (allocated != 0)
+		return "Cache reports allocated objects after all were freed";
+
+	return NULL;
+}
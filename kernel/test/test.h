@@ -68,6 +68,7 @@ extern const char *test_mapping1(void);
 extern const char *test_purge1(void);
 extern const char *test_slab1(void);
 extern const char *test_slab2(void);
+extern const char *test_slab3(void);
 extern const char *test_semaphore1(void);
 extern const char *test_semaphore2(void);
 extern const char *test_print1(void);
@@ -49,11 +49,64 @@
 #include <time.h>
 #include <dirent.h>
 #include <str.h>
+#include <task.h>
+#include <pcm/format.h>
+#include <pcm/resampler.h>
+#include <math.h>
+#include <compose.h>
+#include <drawctx.h>
+#include <font.h>
+#include <font/embedded.h>
+#include <deflate.h>
+#include <inflate.h>
+#include <source.h>
+#include <surface.h>
 
 #define NAME	"bnchmark"
 #define BUFSIZE 8096
 #define MBYTE (1024*1024)
 
+/** Frames processed by the PCM tests (10 s of stereo audio at 48 kHz) */
+#define PCM_FRAMES 480000
+#define PCM_CHANNELS 2
+#define PCM_BLOCK 4096
+
+/** Surface drawn by the draw tests, drawn DRAW_FRAMES times */
+#define DRAW_WIDTH 640
+#define DRAW_HEIGHT 480
+#define DRAW_FRAMES 20
+#define DRAW_PIXELS ((uint64_t) DRAW_WIDTH * DRAW_HEIGHT * DRAW_FRAMES)
+
+/** Text drawn by the text test, the embedded font has 8x16 glyphs */
+#define TEXT_COLUMNS (DRAW_WIDTH / 8)
+#define TEXT_ROWS (DRAW_HEIGHT / 16)
+#define TEXT_GLYPHS ((uint64_t) TEXT_COLUMNS * TEXT_ROWS * DRAW_FRAMES)
+
+/** Corpus (de)compressed by the compress tests */
+#define COMPRESS_CORPUS (4 * MBYTE)
+
+/** Data of the compress tests, prepared before measuring */
+typedef struct {
+	unsigned int level;
+	uint8_t *corpus;
+	void *compressed;
+	size_t compressed_size;
+} compress_test_t;
+
+/** Sample formats accepted by the PCM tests */
+static const struct {
+	const char *name;
+	pcm_sample_format_t format;
+} pcm_formats[] = {
+	{ "u8", PCM_SAMPLE_UINT8 },
+	{ "s16le", PCM_SAMPLE_SINT16_LE },
+	{ "s16be", PCM_SAMPLE_SINT16_BE },
+	{ "s24le", PCM_SAMPLE_SINT24_LE },
+	{ "s24_32le", PCM_SAMPLE_SINT24_32_LE },
+	{ "s32le", PCM_SAMPLE_SINT32_LE },
+	{ "f32", PCM_SAMPLE_FLOAT32 }
+};
+
 typedef errno_t (*measure_func_t)(void *);
 
 static void syntax_print(void);
@@ -127,6 +180,396 @@ static errno_t sequential_read_dir(void *data)
 	return EOK;
 }
 
+static errno_t program_startup(void *data)
+{
+	char *path = (char *) data;
+	task_wait_t wait;
+	task_exit_t texit;
+	int retval;
+
+	errno_t rc = task_spawnl(NULL, &wait, path, path, NULL);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed spawning program: %s\n", path);
+		return rc;
+	}
+
+	rc = task_wait(&wait, &texit, &retval);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed waiting for program: %s\n", path);
+		return rc;
+	}
+
+	return EOK;
+}
+
+/** Parse "<first>:<second>" argument of the PCM tests. */
+static errno_t pcm_parse_pair(const char *arg, char *first, char *second,
+    size_t size)
+{
+	const char *sep = str_chr(arg, ':');
+	if (sep == NULL || (size_t) (sep - arg) >= size)
+		return EINVAL;
+
+	str_ncpy(first, size, arg, sep - arg);
+	str_cpy(second, size, sep + 1);
+	return EOK;
+}
+
+static errno_t pcm_parse_format(const char *name, pcm_format_t *format)
+{
+	for (size_t i = 0; i < sizeof(pcm_formats) / sizeof(pcm_formats[0]);
+	    i++) {
+		if (str_cmp(name, pcm_formats[i].name) == 0) {
+			format->channels = PCM_CHANNELS;
+			format->sampling_rate = 48000;
+			format->sample_format = pcm_formats[i].format;
+			return EOK;
+		}
+	}
+
+	fprintf(stderr, "Unknown sample format: %s\n", name);
+	return EINVAL;
+}
+
+static errno_t pcm_mix(void *data)
+{
+	char src_name[16];
+	char dst_name[16];
+	pcm_format_t sf;
+	pcm_format_t df;
+
+	if (pcm_parse_pair(data, src_name, dst_name, sizeof(src_name)) != EOK ||
+	    pcm_parse_format(src_name, &sf) != EOK ||
+	    pcm_parse_format(dst_name, &df) != EOK) {
+		fprintf(stderr, "Expected <src format>:<dst format>\n");
+		return EINVAL;
+	}
+
+	const size_t src_size = PCM_BLOCK * pcm_format_frame_size(&sf);
+	const size_t dst_size = PCM_BLOCK * pcm_format_frame_size(&df);
+	void *src = malloc(src_size);
+	void *dst = malloc(dst_size);
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		return ENOMEM;
+	}
+
+	pcm_format_silence(src, src_size, &sf);
+	pcm_format_silence(dst, dst_size, &df);
+
+	errno_t rc = EOK;
+	for (size_t i = 0; i < PCM_FRAMES / PCM_BLOCK && rc == EOK; i++)
+		rc = pcm_format_convert_and_mix(dst, dst_size, src, src_size,
+		    &sf, &df);
+
+	free(src);
+	free(dst);
+	return rc;
+}
+
+static errno_t pcm_resample(void *data)
+{
+	char src_rate[16];
+	char dst_rate[16];
+
+	if (pcm_parse_pair(data, src_rate, dst_rate, sizeof(src_rate)) != EOK) {
+		fprintf(stderr, "Expected <src rate>:<dst rate>\n");
+		return EINVAL;
+	}
+
+	pcm_resampler_t *resampler;
+	errno_t rc = pcm_resampler_create(strtoul(src_rate, NULL, 10),
+	    strtoul(dst_rate, NULL, 10), PCM_CHANNELS, &resampler);
+	if (rc != EOK) {
+		fprintf(stderr, "Failed creating resampler\n");
+		return rc;
+	}
+
+	float *src = calloc(PCM_BLOCK * PCM_CHANNELS, sizeof(float));
+	float *dst = calloc(PCM_BLOCK * PCM_CHANNELS, sizeof(float));
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		pcm_resampler_destroy(resampler);
+		return ENOMEM;
+	}
+
+	for (size_t done = 0; done < PCM_FRAMES; ) {
+		size_t used = 0;
+		pcm_resampler_process(resampler, src, PCM_BLOCK, &used, dst,
+		    PCM_BLOCK);
+		done += used;
+	}
+
+	free(src);
+	free(dst);
+	pcm_resampler_destroy(resampler);
+	return EOK;
+}
+
+/** Fill pixels with a pattern, alpha cycles through all values unless opaque */
+static void draw_fill(pixel_t *pixels, size_t count, bool opaque)
+{
+	for (size_t i = 0; i < count; i++) {
+		pixels[i] = PIXEL(opaque ? 255 : i * 7, i, i >> 2, i >> 4);
+	}
+}
+
+static errno_t draw_compose(void *data)
+{
+	compose_t compose;
+
+	if (str_cmp(data, "src") == 0) {
+		compose = compose_src;
+	} else if (str_cmp(data, "over") == 0) {
+		compose = compose_over;
+	} else if (str_cmp(data, "add") == 0) {
+		compose = compose_add;
+	} else {
+		fprintf(stderr, "Expected src, over or add\n");
+		return EINVAL;
+	}
+
+	pixel_t *src = malloc(DRAW_WIDTH * sizeof(pixel_t));
+	pixel_t *dst = malloc(DRAW_WIDTH * sizeof(pixel_t));
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		return ENOMEM;
+	}
+
+	draw_fill(src, DRAW_WIDTH, false);
+
+	for (size_t i = 0; i < DRAW_FRAMES * DRAW_HEIGHT; i++) {
+		/* Keep the background opaque as on a screen */
+		if (compose == compose_add)
+			draw_fill(dst, DRAW_WIDTH, true);
+		compose_span(compose, dst, src, DRAW_WIDTH);
+	}
+
+	free(src);
+	free(dst);
+	return EOK;
+}
+
+static errno_t draw_transfer(void *data)
+{
+	transform_t transform;
+	pixel_t alpha = PIXEL(255, 0, 0, 0);
+	bool opaque = true;
+
+	transform_identity(&transform);
+
+	if (str_cmp(data, "copy") == 0) {
+		/* Identity */
+	} else if (str_cmp(data, "blend") == 0) {
+		opaque = false;
+	} else if (str_cmp(data, "alpha") == 0) {
+		alpha = PIXEL(128, 0, 0, 0);
+	} else if (str_cmp(data, "scale") == 0) {
+		transform_scale(&transform, 1.5, 1.5);
+	} else if (str_cmp(data, "rotate") == 0) {
+		transform_translate(&transform, DRAW_WIDTH / 2, DRAW_HEIGHT / 2);
+		transform_rotate(&transform, M_PI / 12);
+		transform_translate(&transform, -DRAW_WIDTH / 2, -DRAW_HEIGHT / 2);
+	} else {
+		fprintf(stderr, "Expected copy, blend, alpha, scale or rotate\n");
+		return EINVAL;
+	}
+
+	surface_t *texture = surface_create(DRAW_WIDTH, DRAW_HEIGHT, NULL, 0);
+	surface_t *target = surface_create(DRAW_WIDTH, DRAW_HEIGHT, NULL, 0);
+	if (texture == NULL || target == NULL) {
+		if (texture != NULL)
+			surface_destroy(texture);
+		if (target != NULL)
+			surface_destroy(target);
+		return ENOMEM;
+	}
+
+	draw_fill(surface_direct_access(texture), DRAW_WIDTH * DRAW_HEIGHT,
+	    opaque);
+	draw_fill(surface_direct_access(target), DRAW_WIDTH * DRAW_HEIGHT,
+	    true);
+
+	source_t source;
+	source_init(&source);
+	source_set_filter(&source, filter_bilinear);
+	source_set_transform(&source, transform);
+	source_set_texture(&source, texture, PIXELMAP_EXTEND_TRANSPARENT_SIDES);
+	source_set_alpha(&source, alpha);
+
+	drawctx_t context;
+	drawctx_init(&context, target);
+	drawctx_set_compose(&context, compose_over);
+	drawctx_set_source(&context, &source);
+
+	for (size_t i = 0; i < DRAW_FRAMES; i++)
+		drawctx_transfer(&context, 0, 0, DRAW_WIDTH, DRAW_HEIGHT);
+
+	surface_destroy(texture);
+	surface_destroy(target);
+	return EOK;
+}
+
+static errno_t draw_text(void *data)
+{
+	bool clip;
+
+	if (str_cmp(data, "solid") == 0) {
+		clip = false;
+	} else if (str_cmp(data, "clip") == 0) {
+		/* Clipped text is rendered glyph by glyph */
+		clip = true;
+	} else {
+		fprintf(stderr, "Expected solid or clip\n");
+		return EINVAL;
+	}
+
+	font_t *font;
+	errno_t rc = embedded_font_create(&font, 16);
+	if (rc != EOK)
+		return rc;
+
+	surface_t *target = surface_create(DRAW_WIDTH, DRAW_HEIGHT, NULL, 0);
+	if (target == NULL) {
+		font_release(font);
+		return ENOMEM;
+	}
+
+	draw_fill(surface_direct_access(target), DRAW_WIDTH * DRAW_HEIGHT,
+	    true);
+
+	source_t source;
+	source_init(&source);
+	source_set_color(&source, PIXEL(255, 255, 255, 255));
+
+	drawctx_t context;
+	drawctx_init(&context, target);
+	drawctx_set_source(&context, &source);
+	drawctx_set_font(&context, font);
+	if (clip)
+		drawctx_set_clip(&context, 0, 0, DRAW_WIDTH - 1, DRAW_HEIGHT);
+
+	/* Lines of printable ASCII, each row shifted by one character */
+	char line[TEXT_COLUMNS + 1];
+
+	for (size_t i = 0; i < DRAW_FRAMES; i++) {
+		for (size_t row = 0; row < TEXT_ROWS; row++) {
+			for (size_t col = 0; col < TEXT_COLUMNS; col++)
+				line[col] = ' ' + (row + col) % 95;
+			line[TEXT_COLUMNS] = '\0';
+
+			drawctx_print(&context, line, 0, row * 16);
+		}
+	}
+
+	surface_destroy(target);
+	font_release(font);
+	return EOK;
+}
+
+/** Fill the corpus of the compress tests
+ *
+ * The corpus is always the same: half of it is text made of common words,
+ * a quarter is an image-like gradient and a quarter is noise.
+ *
+ */
+static void compress_corpus_fill(uint8_t *corpus)
+{
+	static const char *words[] = {
+		"the", "of", "and", "a", "to", "in", "is", "you", "that",
+		"it", "he", "was", "for", "on", "are", "as", "with", "his",
+		"they", "at", "be", "this", "have", "from", "or", "one",
+		"had", "by", "word", "but", "not", "what", "all", "were",
+		"kernel", "task", "thread", "fibril", "service", "driver"
+	};
+	size_t nwords = sizeof(words) / sizeof(words[0]);
+	uint32_t seed = 1;
+	size_t pos = 0;
+
+	while (pos < COMPRESS_CORPUS / 2) {
+		seed = seed * 1103515245 + 12345;
+		const char *word = words[(seed >> 16) % nwords];
+
+		while ((*word != '\0') && (pos < COMPRESS_CORPUS / 2))
+			corpus[pos++] = *word++;
+
+		if (pos < COMPRESS_CORPUS / 2)
+			corpus[pos++] = ((seed >> 8) % 16 == 0) ? '\n' : ' ';
+	}
+
+	while (pos < COMPRESS_CORPUS / 4 * 3) {
+		corpus[pos] = (pos / 4 + pos / 2048) & 0xff;
+		pos++;
+	}
+
+	while (pos < COMPRESS_CORPUS) {
+		seed = seed * 1103515245 + 12345;
+		corpus[pos++] = seed >> 24;
+	}
+}
+
+static errno_t compress_prepare(const char *arg, compress_test_t *test)
+{
+	char *endptr;
+	unsigned long level = strtoul(arg, &endptr, 10);
+	if ((*endptr != '\0') || (level > DEFLATE_LEVEL_BEST)) {
+		fprintf(stderr, "Expected compression level 0 to 9\n");
+		return EINVAL;
+	}
+
+	test->level = level;
+	test->corpus = malloc(COMPRESS_CORPUS);
+	if (test->corpus == NULL)
+		return ENOMEM;
+
+	compress_corpus_fill(test->corpus);
+
+	errno_t rc = deflate(test->corpus, COMPRESS_CORPUS, test->level,
+	    &test->compressed, &test->compressed_size);
+	if (rc != EOK) {
+		free(test->corpus);
+		return rc;
+	}
+
+	return EOK;
+}
+
+static errno_t compress_deflate(void *data)
+{
+	compress_test_t *test = (compress_test_t *) data;
+	void *compressed;
+	size_t compressed_size;
+
+	errno_t rc = deflate(test->corpus, COMPRESS_CORPUS, test->level,
+	    &compressed, &compressed_size);
+	if (rc != EOK)
+		return rc;
+
+	free(compressed);
+	return EOK;
+}
+
+static errno_t compress_inflate(void *data)
+{
+	compress_test_t *test = (compress_test_t *) data;
+
+	uint8_t *expanded = malloc(COMPRESS_CORPUS);
+	if (expanded == NULL)
+		return ENOMEM;
+
+	errno_t rc = inflate(test->compressed, test->compressed_size,
+	    expanded, COMPRESS_CORPUS);
+	if ((rc == EOK) &&
+	    (memcmp(expanded, test->corpus, COMPRESS_CORPUS) != 0))
+		rc = EIO;
+
+	free(expanded);
+	return rc;
+}
+
 int main(int argc, char **argv)
 {
 	errno_t rc;
@@ -138,6 +581,10 @@ int main(int argc, char **argv)
 	char *log_str = NULL;
 	char *test_type = NULL;
 	char *endptr;
+	uint64_t work = 0;
+	const char *work_unit = NULL;
+	void *data;
+	compress_test_t compress_test;
 
 	if (argc < 5) {
 		fprintf(stderr, NAME ": Error, argument missing.\n");
@@ -173,11 +620,45 @@ int main(int argc, char **argv)
 	--argc;
 	++argv;
 	path = *argv;
+	data = path;
 
 	if (str_cmp(test_type, "sequential-file-read") == 0) {
 		fn = sequential_read_file;
 	} else if (str_cmp(test_type, "sequential-dir-read") == 0) {
 		fn = sequential_read_dir;
+	} else if (str_cmp(test_type, "program-startup") == 0) {
+		fn = program_startup;
+	} else if (str_cmp(test_type, "pcm-mix") == 0) {
+		fn = pcm_mix;
+	} else if (str_cmp(test_type, "pcm-resample") == 0) {
+		fn = pcm_resample;
+	} else if (str_cmp(test_type, "draw-compose") == 0) {
+		fn = draw_compose;
+		work = DRAW_PIXELS;
+		work_unit = "px";
+	} else if (str_cmp(test_type, "draw-transfer") == 0) {
+		fn = draw_transfer;
+		work = DRAW_PIXELS;
+		work_unit = "px";
+	} else if (str_cmp(test_type, "draw-text") == 0) {
+		fn = draw_text;
+		work = TEXT_GLYPHS;
+		work_unit = "glyphs";
+	} else if ((str_cmp(test_type, "compress-deflate") == 0) ||
+	    (str_cmp(test_type, "compress-inflate") == 0)) {
+		fn = (str_cmp(test_type, "compress-deflate") == 0) ?
+		    compress_deflate : compress_inflate;
+		work = COMPRESS_CORPUS;
+		work_unit = "B";
+
+		/* The corpus is not part of the measurement */
+		rc = compress_prepare(path, &compress_test);
+		if (rc != EOK) {
+			fprintf(stderr, "Error: %s\n", str_error(rc));
+			return 1;
+		}
+
+		data = &compress_test;
 	} else {
 		fprintf(stderr, "Error, unknown test type\n");
 		syntax_print();
@@ -185,13 +666,20 @@ int main(int argc, char **argv)
 	}
 
 	for (iteration = 0; iteration < iterations; iteration++) {
-		rc = measure(fn, path, &milliseconds_taken);
+		rc = measure(fn, data, &milliseconds_taken);
 		if (rc != EOK) {
 			fprintf(stderr, "Error: %s\n", str_error(rc));
 			return 1;
 		}
 
 		printf("%s;%s;%s;%lld;ms\n", test_type, path, log_str, milliseconds_taken);
+
+		/* measure() actually reports microseconds */
+		if (work != 0 && milliseconds_taken > 0) {
+			printf("%s;%s;%s;%" PRIu64 ";%s/s\n", test_type, path,
+			    log_str, work * 1000000 / (uint64_t) milliseconds_taken,
+			    work_unit);
+		}
 	}
 
 	return 0;
@@ -204,8 +692,24 @@ static void syntax_print(void)
 	fprintf(stderr, "  <test-type>     one of:\n");
 	fprintf(stderr, "                    sequential-file-read\n");
 	fprintf(stderr, "                    sequential-dir-read\n");
+	fprintf(stderr, "                    program-startup\n");
+	fprintf(stderr, "                    pcm-mix\n");
+	fprintf(stderr, "                    pcm-resample\n");
+	fprintf(stderr, "                    draw-compose\n");
+	fprintf(stderr, "                    draw-transfer\n");
+	fprintf(stderr, "                    draw-text\n");
+	fprintf(stderr, "                    compress-deflate\n");
+	fprintf(stderr, "                    compress-inflate\n");
 	fprintf(stderr, "  <log-str>       a string to attach to results\n");
-	fprintf(stderr, "  <path>          file/directory to use for testing\n");
+	fprintf(stderr, "  <path>          file/directory to use for testing,\n");
+	fprintf(stderr, "                  program to run (without arguments),\n");
+	fprintf(stderr, "                  <src>:<dst> sample formats to mix\n");
+	fprintf(stderr, "                  (u8, s16le, s16be, s24le, s24_32le,\n");
+	fprintf(stderr, "                  s32le, f32) or sampling rates,\n");
+	fprintf(stderr, "                  compose operator (src, over, add) or\n");
+	fprintf(stderr, "                  transfer (copy, blend, alpha, scale,\n");
+	fprintf(stderr, "                  rotate), text (solid, clip) or\n");
+	fprintf(stderr, "                  compression level (0 to 9)\n");
 }
 
 /**
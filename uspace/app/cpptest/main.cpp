@@ -47,9 +47,11 @@
 
 #include <algorithm>
 #include <array>
+#include <charconv>
 #include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <execution>
 #include <exception>
 #include <fstream>
 #include <functional>
@@ -68,6 +70,7 @@
 #include <numeric>
 #include <ostream>
 #include <ratio>
+#include <regex>
 #include <sstream>
 #include <stack>
 #include <streambuf>
@@ -113,6 +116,7 @@ int main()
     ts.add<std::test::set_test>();
     ts.add<std::test::unordered_map_test>();
     ts.add<std::test::unordered_set_test>();
+    ts.add<std::test::flat_hash_test>();
     ts.add<std::test::numeric_test>();
     ts.add<std::test::adaptors_test>();
     ts.add<std::test::memory_test>();
@@ -120,6 +124,9 @@ int main()
     ts.add<std::test::ratio_test>();
     ts.add<std::test::functional_test>();
     ts.add<std::test::algorithm_test>();
+    ts.add<std::test::parallel_test>();
+    ts.add<std::test::regex_test>();
+    ts.add<std::test::io_test>();
 
     return ts.run(true) ? 0 : 1;
 }
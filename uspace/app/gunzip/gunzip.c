@@ -34,17 +34,21 @@
 
 #include <errno.h>
 #include <gzip.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#define BUFFER_SIZE  65536
+
 int main(int argc, char *argv[])
 {
 	errno_t rc;
-	void *data, *ddata;
-	size_t size, dsize;
+	gzip_stream_t *stream;
+	uint8_t *data, *ddata;
 	size_t nread, nwr;
-	long len;
+	size_t pos, consumed, produced;
 	FILE *f, *wf;
+	int retval = 1;
 
 	if (argc != 3) {
 		printf("syntax: gunzip <src.gz> <dest>\n");
@@ -57,68 +61,78 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
-	if (fseek(f, 0, SEEK_END) < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
+	wf = fopen(argv[2], "wb");
+	if (wf == NULL) {
+		printf("Error creating file '%s'\n", argv[2]);
 		fclose(f);
 		return 1;
 	}
 
-	len = ftell(f);
-	if (len < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
+	data = malloc(BUFFER_SIZE);
+	ddata = malloc(BUFFER_SIZE);
+	if ((data == NULL) || (ddata == NULL)) {
+		printf("Error allocating buffers.\n");
+		goto error;
 	}
 
-	if (fseek(f, 0, SEEK_SET) < 0) {
-		printf ("Error rewinding '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
+	rc = gzip_stream_create(&stream);
+	if (rc != EOK) {
+		printf("Error allocating buffers.\n");
+		goto error;
 	}
 
-	data = malloc(len);
-	if (data == NULL) {
-		printf("Error allocating %ld bytes.\n", len);
-		fclose(f);
-		return 1;
+	/*
+	 * Decompress the file in pieces so that the memory needed
+	 * does not depend on the size of the file.
+	 */
+	while (!gzip_stream_done(stream)) {
+		nread = fread(data, 1, BUFFER_SIZE, f);
+		if (ferror(f)) {
+			printf("Error reading '%s'\n", argv[1]);
+			goto error_stream;
+		}
+
+		if (nread == 0) {
+			printf("Error decompressing data: unexpected end of "
+			    "file.\n");
+			goto error_stream;
+		}
+
+		pos = 0;
+		do {
+			rc = gzip_stream_process(stream, data + pos, nread - pos,
+			    &consumed, ddata, BUFFER_SIZE, &produced);
+			if (rc != EOK) {
+				printf("Error decompressing data.\n");
+				goto error_stream;
+			}
+
+			pos += consumed;
+
+			nwr = fwrite(ddata, 1, produced, wf);
+			if (nwr != produced) {
+				printf("Error writing '%s'\n", argv[2]);
+				goto error_stream;
+			}
+		} while (((pos < nread) || (produced == BUFFER_SIZE)) &&
+		    (!gzip_stream_done(stream)));
 	}
 
-	nread = fread(data, 1, len, f);
-	if (nread != (size_t)len) {
-		printf("Error reading '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
+	retval = 0;
 
+error_stream:
+	gzip_stream_destroy(stream);
+error:
+	free(data);
+	free(ddata);
 	fclose(f);
 
-	size = (size_t) len;
-
-	rc = gzip_expand(data, size, &ddata, &dsize);
-	if (rc != EOK) {
-		printf("Error decompressing data.\n");
-		return 1;
-	}
-
-	wf = fopen(argv[2], "wb");
-	if (wf == NULL) {
-		printf("Error creating file '%s'\n", argv[2]);
-		return 1;
-	}
-
-	nwr = fwrite(ddata, 1, dsize, wf);
-	if (nwr != dsize) {
+	if ((fclose(wf) != 0) && (retval == 0)) {
 		printf("Error writing '%s'\n", argv[2]);
-		fclose(wf);
-		return 1;
-	}
-
-	if (fclose(wf) != 0) {
-		printf("Error writing '%s'\n", argv[2]);
-		return 1;
+		retval = 1;
 	}
 
-	return 0;
+	return retval;
 }
 
 /** @}
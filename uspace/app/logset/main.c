@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <async.h>
 #include <errno.h>
+#include <str.h>
 #include <str_error.h>
 #include <io/logctl.h>
 
@@ -55,11 +56,20 @@ static void usage(const char *progname)
 	fprintf(stderr, "Usage:\n");
 	fprintf(stderr, "  %s <default-logging-level>\n", progname);
 	fprintf(stderr, "  %s <log-name> <logging-level>\n", progname);
+	fprintf(stderr, "  %s --flush\n", progname);
 }
 
 int main(int argc, char *argv[])
 {
-	if (argc == 2) {
+	if ((argc == 2) && (str_cmp(argv[1], "--flush") == 0)) {
+		errno_t rc = logctl_flush();
+
+		if (rc != EOK) {
+			fprintf(stderr, "Failed to flush logs: %s.\n",
+			    str_error(rc));
+			return 2;
+		}
+	} else if (argc == 2) {
 		log_level_t new_default_level = parse_log_level_or_die(argv[1]);
 		errno_t rc = logctl_set_default_level(new_default_level);
 
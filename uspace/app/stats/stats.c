@@ -161,6 +161,40 @@ static void list_cpus(void)
 	free(cpus);
 }
 
+static void list_slabs(void)
+{
+	size_t count;
+	stats_slab_t *slabs = stats_get_slabs(&count);
+
+	if (slabs == NULL) {
+		fprintf(stderr, "%s: Unable to get slab statistics\n", NAME);
+		return;
+	}
+
+	printf("[cache name      ] [size  ] [slabs ] [alloc ] [cached] [mag]"
+	    " [mag hits] [depot ] [contend] [slab alloc]\n");
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		uint64_t hits, trips, contention, sallocs;
+		char hsuffix, tsuffix, csuffix, ssuffix;
+
+		order_suffix(slabs[i].mag_hits, &hits, &hsuffix);
+		order_suffix(slabs[i].depot_trips, &trips, &tsuffix);
+		order_suffix(slabs[i].depot_contention, &contention, &csuffix);
+		order_suffix(slabs[i].slab_allocs, &sallocs, &ssuffix);
+
+		printf("%-18s %8zu %8zu %8zu %8zu %5zu %9" PRIu64 "%c"
+		    " %7" PRIu64 "%c %8" PRIu64 "%c %11" PRIu64 "%c\n",
+		    slabs[i].name, slabs[i].size, slabs[i].slabs,
+		    slabs[i].allocated, slabs[i].cached, slabs[i].magazine_size,
+		    hits, hsuffix, trips, tsuffix, contention, csuffix,
+		    sallocs, ssuffix);
+	}
+
+	free(slabs);
+}
+
 static void print_load(void)
 {
 	size_t count;
@@ -199,7 +233,7 @@ static void print_uptime(void)
 static void usage(const char *name)
 {
 	printf(
-	    "Usage: %s [-t task_id] [-a] [-c] [-l] [-u]\n"
+	    "Usage: %s [-t task_id] [-a] [-c] [-s] [-l] [-u]\n"
 	    "\n"
 	    "Options:\n"
 	    "\t-t task_id\n"
@@ -214,6 +248,10 @@ static void usage(const char *name)
 	    "\t--cpus\n"
 	    "\t\tList CPUs\n"
 	    "\n"
+	    "\t-s\n"
+	    "\t--slabs\n"
+	    "\t\tList kernel slab caches\n"
+	    "\n"
 	    "\t-l\n"
 	    "\t--load\n"
 	    "\t\tPrint system load\n"
@@ -236,6 +274,7 @@ int main(int argc, char *argv[])
 	bool toggle_threads = false;
 	bool toggle_all = false;
 	bool toggle_cpus = false;
+	bool toggle_slabs = false;
 	bool toggle_load = false;
 	bool toggle_uptime = false;
 
@@ -266,6 +305,13 @@ int main(int argc, char *argv[])
 			continue;
 		}
 
+		/* Slab caches */
+		if ((off = arg_parse_short_long(argv[i], "-s", "--slabs")) != -1) {
+			toggle_tasks = false;
+			toggle_slabs = true;
+			continue;
+		}
+
 		/* Threads */
 		if ((off = arg_parse_short_long(argv[i], "-t", "--task=")) != -1) {
 			// TODO: Support for 64b range
@@ -307,6 +353,9 @@ int main(int argc, char *argv[])
 	if (toggle_cpus)
 		list_cpus();
 
+	if (toggle_slabs)
+		list_slabs();
+
 	if (toggle_load)
 		print_load();
 
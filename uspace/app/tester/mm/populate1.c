@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <as.h>
+#include "../tester.h"
+
+#define AREA_SIZE    (32 * 1024 * 1024)
+#define NUM_SAMPLES  4
+
+/** Create an area, touch every page once and destroy it again.
+ *
+ * @param flags       Extra area flags.
+ * @param[out] create Time spent creating the area in microseconds.
+ * @param[out] touch  Time spent touching the area in microseconds.
+ *
+ * @return NULL on success, error message on failure.
+ */
+static const char *populate_measure(unsigned int flags, uint64_t *create,
+    uint64_t *touch)
+{
+	struct timespec start;
+	struct timespec mid;
+	struct timespec end;
+
+	getuptime(&start);
+
+	uint8_t *area = as_area_create(AS_AREA_ANY, AREA_SIZE,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE | flags,
+	    AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return "Cannot create AS area";
+
+	getuptime(&mid);
+
+	for (size_t off = 0; off < AREA_SIZE; off += PAGE_SIZE)
+		area[off] = 1;
+
+	getuptime(&end);
+
+	for (size_t off = 0; off < AREA_SIZE; off += PAGE_SIZE) {
+		if (area[off] != 1) {
+			as_area_destroy(area);
+			return "Touched page lost its content";
+		}
+	}
+
+	if (as_area_destroy(area) != EOK)
+		return "Cannot destroy AS area";
+
+	*create = ts_sub_diff(&mid, &start) / 1000;
+	*touch = ts_sub_diff(&end, &mid) / 1000;
+	return NULL;
+}
+
+static const char *populate_run(const char *name, unsigned int flags)
+{
+	uint64_t best = UINT64_MAX;
+
+	TPRINTF("%s:\n", name);
+
+	for (int i = 0; i < NUM_SAMPLES; i++) {
+		uint64_t create;
+		uint64_t touch;
+
+		const char *err = populate_measure(flags, &create, &touch);
+		if (err != NULL)
+			return err;
+
+		TPRINTF("  create %" PRIu64 " us, first touch %" PRIu64 " us\n",
+		    create, touch);
+
+		if (create + touch < best)
+			best = create + touch;
+	}
+
+	if (best > 0) {
+		TPRINTF("  best %" PRIu64 " MiB/s\n",
+		    (uint64_t) AREA_SIZE * 1000000 / best / (1024 * 1024));
+	}
+
+	return NULL;
+}
+
+const char *test_populate1(void)
+{
+	const char *err;
+
+	TPRINTF("Benchmark first touch of a %d MiB area\n",
+	    AREA_SIZE / (1024 * 1024));
+
+	err = populate_run("On demand", 0);
+	if (err != NULL)
+		return err;
+
+	err = populate_run("Populated", AS_AREA_POPULATE);
+	if (err != NULL)
+		return err;
+
+	err = populate_run("Large pages", AS_AREA_LARGE);
+	if (err != NULL)
+		return err;
+
+	return NULL;
+}
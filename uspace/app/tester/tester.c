@@ -73,6 +73,7 @@ test_t tests[] = {
 #include "mm/malloc3.def"
 #include "mm/mapping1.def"
 #include "mm/pager1.def"
+#include "mm/populate1.def"
 #include "hw/serial/serial1.def"
 #include "chardev/chardev1.def"
 	{ NULL, NULL, NULL, false }
@@ -41,6 +41,7 @@
 #include <str_error.h>
 #include <stdio.h>
 #include <hound/client.h>
+#include <macros.h>
 #include <pcm/sample_format.h>
 #include <getopt.h>
 
@@ -50,6 +51,7 @@
 
 #define READ_SIZE   (32 * 1024)
 #define STREAM_BUFFER_SIZE   (64 * 1024)
+#define SHARED_STREAM_PERIODS   4
 
 /**
  * Play audio file using a new stream on provided context.
@@ -113,12 +115,70 @@ static errno_t hplay_ctx(hound_context_t *ctx, const char *filename)
 	return ret;
 }
 
+/**
+ * Write data to a shared stream and print its statistics at the end.
+ * @param hound Connected playback context.
+ * @param source File positioned at the audio data.
+ * @param format Audio data format.
+ * @param period Period duration in microseconds.
+ * @return Error code.
+ */
+static errno_t hplay_shared(hound_context_t *hound, FILE *source,
+    pcm_format_t format, usec_t period)
+{
+	const size_t frames = max(1,
+	    (size_t) ((uint64_t) format.sampling_rate * period / 1000000));
+	hound_stream_t *stream = hound_stream_create_shared(hound,
+	    HOUND_STREAM_DRAIN_ON_EXIT, format, frames, SHARED_STREAM_PERIODS);
+	if (!stream) {
+		printf("Failed to create shared stream\n");
+		return ENOMEM;
+	}
+
+	/* Write whole frames, the ring does not take partial ones */
+	const size_t frame_size = pcm_format_frame_size(&format);
+	const size_t size = READ_SIZE - READ_SIZE % frame_size;
+	static char buffer[READ_SIZE];
+	hound_stream_stats_t stats = { 0 };
+	usec_t latency_max = 0;
+	usec_t latency_sum = 0;
+	unsigned samples = 0;
+	errno_t ret = EOK;
+	size_t read;
+	while ((read = fread(buffer, sizeof(char), size, source)) > 0) {
+		read -= read % frame_size;
+		if (read == 0)
+			break;
+		ret = hound_stream_write(stream, buffer, read);
+		if (ret != EOK) {
+			printf("Failed to write to shared stream: %s\n",
+			    str_error(ret));
+			break;
+		}
+		if (hound_stream_get_stats(stream, &stats) == EOK) {
+			latency_max = max(latency_max, stats.latency);
+			latency_sum += stats.latency;
+			++samples;
+		}
+	}
+
+	hound_stream_destroy(stream);
+	if (samples > 0) {
+		printf("Period %zu frames, latency avg %lld us, max %lld us, "
+		    "%u xrun(s).\n", frames, latency_sum / samples, latency_max,
+		    stats.xruns);
+	}
+	return ret;
+}
+
 /**
  * Play audio file via hound server.
  * @param filename File to play.
+ * @param period Period of a shared stream in microseconds, 0 to use
+ *               the main stream.
  * @return Error code
  */
-static errno_t hplay(const char *filename)
+static errno_t hplay(const char *filename, usec_t period)
 {
 	printf("Hound playback: %s\n", filename);
 	FILE *source = fopen(filename, "rb");
@@ -166,6 +226,13 @@ static errno_t hplay(const char *filename)
 		return ret;
 	}
 
+	if (period) {
+		ret = hplay_shared(hound, source, format, period);
+		hound_context_destroy(hound);
+		fclose(source);
+		return ret;
+	}
+
 	/* Read and play */
 	static char buffer[READ_SIZE];
 	while ((read = fread(buffer, sizeof(char), READ_SIZE, source)) > 0) {
@@ -212,6 +279,7 @@ static errno_t play_wrapper(void *arg)
  */
 static const struct option opts[] = {
 	{ "device", required_argument, 0, 'd' },
+	{ "latency", required_argument, 0, 'l' },
 	{ "parallel", no_argument, 0, 'p' },
 	{ "record", no_argument, 0, 'r' },
 	{ "help", no_argument, 0, 'h' },
@@ -233,6 +301,9 @@ static void print_help(const char *name)
 	    "service. Use location path or a special device `default'\n");
 	printf("\t -p, --parallel\t Play given files in parallel instead of "
 	    "sequentially (does not work with -d).\n");
+	printf("\t -l, --latency\t Play through a low latency stream with "
+	    "the given period (in microseconds) and report the latency "
+	    "(does not work with -d or -p).\n");
 }
 
 int main(int argc, char *argv[])
@@ -240,12 +311,13 @@ int main(int argc, char *argv[])
 	const char *device = "default";
 	int idx = 0;
 	bool direct = false, record = false, parallel = false;
+	usec_t period = 0;
 	optind = 0;
 	int ret = 0;
 
 	/* Parse command line options */
 	while (ret != -1) {
-		ret = getopt_long(argc, argv, "d:prh", opts, &idx);
+		ret = getopt_long(argc, argv, "d:l:prh", opts, &idx);
 		switch (ret) {
 		case 'd':
 			direct = true;
@@ -254,6 +326,9 @@ int main(int argc, char *argv[])
 		case 'r':
 			record = true;
 			break;
+		case 'l':
+			period = strtoul(optarg, NULL, 10);
+			break;
 		case 'p':
 			parallel = true;
 			break;
@@ -270,6 +345,13 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
+	if (period != 0 && (parallel || direct)) {
+		printf("Low latency playback is available only if using sound "
+		    "server (no -d) for a single stream (no -p)\n");
+		print_help(*argv);
+		return 1;
+	}
+
 	if (optind == argc) {
 		printf("Not enough arguments.\n");
 		print_help(*argv);
@@ -333,7 +415,7 @@ int main(int argc, char *argv[])
 				atomic_fetch_add(&playcount, 1);
 				fibril_add_ready(fid);
 			} else {
-				hplay(file);
+				hplay(file, period);
 			}
 		}
 	}
@@ -252,6 +252,12 @@ static errno_t hda_start_playback(ddf_fun_t *fun, unsigned frames,
 	/* 48 kHz, 16-bits, 1 channel */
 	fmt = (fmt_base_44khz << fmt_base) | (fmt_bits_16 << fmt_bits_l) | 1;
 
+	/* Interrupt after each fragment of the requested size */
+	if (frames != 0 && hda_stream_buffers_set_fragment(hda->pcm_buffers,
+	    frames * pcm_sample_format_frame_size(channels, format)) != EOK) {
+		ddf_msg(LVL_WARN, "Cannot use fragments of %u frames", frames);
+	}
+
 	ddf_msg(LVL_NOTE, "hda_start_playback() - create output stream");
 	hda->pcm_stream = hda_stream_create(hda, sdir_output, hda->pcm_buffers,
 	    fmt);
@@ -311,6 +317,12 @@ static errno_t hda_start_capture(ddf_fun_t *fun, unsigned frames, unsigned chann
 	/* 48 kHz, 16-bits, 1 channel */
 	fmt = (fmt_base_44khz << fmt_base) | (fmt_bits_16 << fmt_bits_l) | 1;
 
+	/* Interrupt after each fragment of the requested size */
+	if (frames != 0 && hda_stream_buffers_set_fragment(hda->pcm_buffers,
+	    frames * pcm_sample_format_frame_size(channels, format)) != EOK) {
+		ddf_msg(LVL_WARN, "Cannot use fragments of %u frames", frames);
+	}
+
 	ddf_msg(LVL_NOTE, "hda_start_capture() - create input stream");
 	hda->pcm_stream = hda_stream_create(hda, sdir_input, hda->pcm_buffers,
 	    fmt);
@@ -42,6 +42,9 @@ typedef struct {
 	uint32_t flags;
 } hda_buffer_desc_t;
 
+/** Maximum number of entries in a buffer descriptor list */
+#define BDL_MAX_ENTRIES 256
+
 /** Buffer descriptor flags bits */
 typedef enum {
 	bdf_ioc = 0
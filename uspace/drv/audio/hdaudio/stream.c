@@ -48,14 +48,28 @@
 #include "spec/bdl.h"
 #include "stream.h"
 
+/** Point BDL entries and buffer pointers to consecutive buffers. */
+static void hda_stream_buffers_fill_bdl(hda_stream_buffers_t *bufs)
+{
+	size_t i;
+
+	for (i = 0; i < bufs->nbuffers; i++) {
+		bufs->buf[i] = bufs->base + i * bufs->bufsize;
+		bufs->buf_phys[i] = bufs->base_phys + i * bufs->bufsize;
+
+		bufs->bdl[i].address = host2uint64_t_le(bufs->buf_phys[i]);
+		bufs->bdl[i].length = host2uint32_t_le(bufs->bufsize);
+		bufs->bdl[i].flags = BIT_V(uint32_t, bdf_ioc);
+	}
+}
+
 errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
 {
 	void *bdl;
 	void *buffer;
 	uintptr_t buffer_phys;
 	hda_stream_buffers_t *bufs = NULL;
-	size_t i;
-	//size_t j, k;
+	//size_t i, j, k;
 	errno_t rc;
 
 	bufs = calloc(1, sizeof(hda_stream_buffers_t));
@@ -72,7 +86,7 @@ errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
 	 * it must be within the 32-bit address space.
 	 */
 	bdl = AS_AREA_ANY;
-	rc = dmamem_map_anonymous(bufs->nbuffers * sizeof(hda_buffer_desc_t),
+	rc = dmamem_map_anonymous(BDL_MAX_ENTRIES * sizeof(hda_buffer_desc_t),
 	    hda->ctl->ok64bit ? 0 : DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE,
 	    0, &bufs->bdl_phys, &bdl);
 	if (rc != EOK)
@@ -82,11 +96,11 @@ errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
 
 	/* Allocate arrays of buffer pointers */
 
-	bufs->buf = calloc(bufs->nbuffers, sizeof(void *));
+	bufs->buf = calloc(BDL_MAX_ENTRIES, sizeof(void *));
 	if (bufs->buf == NULL)
 		goto error;
 
-	bufs->buf_phys = calloc(bufs->nbuffers, sizeof(uintptr_t));
+	bufs->buf_phys = calloc(BDL_MAX_ENTRIES, sizeof(uintptr_t));
 	if (bufs->buf_phys == NULL)
 		goto error;
 
@@ -126,21 +140,12 @@ errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
 		goto error;
 	}
 
-	for (i = 0; i < bufs->nbuffers; i++) {
-		bufs->buf[i] = buffer + i * bufs->bufsize;
-		bufs->buf_phys[i] = buffer_phys + i * bufs->bufsize;
-
-		ddf_msg(LVL_NOTE, "Stream buf phys=0x%llx virt=%p",
-		    (long long unsigned)(uintptr_t)bufs->buf[i],
-		    (void *)bufs->buf_phys[i]);
-	}
+	ddf_msg(LVL_NOTE, "Stream buf phys=0x%llx virt=%p",
+	    (long long unsigned)buffer_phys, buffer);
 
-	/* Fill in BDL */
-	for (i = 0; i < bufs->nbuffers; i++) {
-		bufs->bdl[i].address = host2uint64_t_le(bufs->buf_phys[i]);
-		bufs->bdl[i].length = host2uint32_t_le(bufs->bufsize);
-		bufs->bdl[i].flags = BIT_V(uint32_t, bdf_ioc);
-	}
+	bufs->base = buffer;
+	bufs->base_phys = buffer_phys;
+	hda_stream_buffers_fill_bdl(bufs);
 
 	*rbufs = bufs;
 	return EOK;
@@ -149,6 +154,33 @@ error:
 	return ENOMEM;
 }
 
+/** Split stream buffer to fragments of the given size.
+ *
+ * The controller interrupts after each fragment. The buffer memory stays
+ * the same, only the BDL changes, so this must not be called while
+ * a stream uses the buffers.
+ *
+ * @param bufs Stream buffers
+ * @param size Fragment size in bytes
+ * @return EOK on success, EINVAL if the buffer cannot be split to fragments
+ *         of @a size bytes
+ */
+errno_t hda_stream_buffers_set_fragment(hda_stream_buffers_t *bufs,
+    size_t size)
+{
+	const size_t total = bufs->nbuffers * bufs->bufsize;
+
+	/* Buffers in the BDL must be aligned to 128 bytes */
+	if (size == 0 || size % 128 != 0 || total % size != 0 ||
+	    total / size < 2 || total / size > BDL_MAX_ENTRIES)
+		return EINVAL;
+
+	bufs->nbuffers = total / size;
+	bufs->bufsize = size;
+	hda_stream_buffers_fill_bdl(bufs);
+	return EOK;
+}
+
 void hda_stream_buffers_free(hda_stream_buffers_t *bufs)
 {
 	if (bufs == NULL)
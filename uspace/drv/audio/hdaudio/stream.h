@@ -60,6 +60,10 @@ typedef struct hda_stream_buffers {
 	void **buf;
 	/** Physical addresses of buffers */
 	uintptr_t *buf_phys;
+	/** Contiguous memory of all buffers */
+	void *base;
+	/** Physical address of @c base */
+	uintptr_t base_phys;
 } hda_stream_buffers_t;
 
 typedef struct hda_stream {
@@ -77,6 +81,8 @@ typedef struct hda_stream {
 } hda_stream_t;
 
 extern errno_t hda_stream_buffers_alloc(hda_t *, hda_stream_buffers_t **);
+extern errno_t hda_stream_buffers_set_fragment(hda_stream_buffers_t *,
+    size_t);
 extern void hda_stream_buffers_free(hda_stream_buffers_t *);
 extern hda_stream_t *hda_stream_create(hda_t *, hda_stream_dir_t,
     hda_stream_buffers_t *, uint32_t);
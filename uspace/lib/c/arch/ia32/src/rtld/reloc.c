@@ -34,6 +34,7 @@
  * @file
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
@@ -207,6 +208,78 @@ void rel_table_process(module_t *m, elf_rel_t *rt, size_t rt_size)
 
 }
 
+/** Prepare the PLT of a module for lazy binding.
+ *
+ * PLT0 pushes the second GOT entry and jumps through the third one, so
+ * these receive the module and the lazy binding entry point. Until bound,
+ * each JUMP_SLOT points back into its PLT entry (at the link-time address),
+ * which pushes the relocation offset and jumps to PLT0.
+ *
+ * @return @c true on success, @c false if the PLT must be bound eagerly
+ */
+bool plt_lazy_setup_arch(module_t *m)
+{
+	uint32_t *got = m->dyn.plt_got;
+	elf_rel_t *rt = m->dyn.jmp_rel;
+	size_t rt_entries;
+	size_t i;
+
+	if (m->dyn.plt_rel != DT_REL)
+		return false;
+
+	got[1] = (uint32_t) m;
+	got[2] = (uint32_t) m->rtld->plt_trampoline;
+
+	rt_entries = m->dyn.plt_rel_sz / sizeof(elf_rel_t);
+	for (i = 0; i < rt_entries; ++i) {
+		if (ELF32_R_TYPE(rt[i].r_info) != R_386_JUMP_SLOT) {
+			rel_table_process(m, &rt[i], sizeof(elf_rel_t));
+			++m->n_relocs;
+			continue;
+		}
+
+		*(uint32_t *) (rt[i].r_offset + m->bias) += m->bias;
+		++m->n_lazy;
+	}
+
+	return true;
+}
+
+/** Bind a PLT entry on its first call.
+ *
+ * Called from plt_trampoline_arch(). The lookup bypasses the lookup
+ * cache, since the calling thread need not be the only one running.
+ *
+ * @param m Module whose PLT entry was called
+ * @param rel_off Offset of the JUMP_SLOT relocation in the PLT relocation table
+ * @return Address of the function
+ */
+void *plt_resolve_arch(module_t *m, size_t rel_off)
+{
+	elf_rel_t *rel;
+	elf_symbol_t *sym;
+	elf_symbol_t *sym_def;
+	module_t *dest;
+	const char *name;
+	void *addr;
+
+	rel = (elf_rel_t *) ((uint8_t *) m->dyn.jmp_rel + rel_off);
+	sym = &((elf_symbol_t *) m->dyn.sym_tab)[ELF32_R_SYM(rel->r_info)];
+	name = m->dyn.str_tab + sym->st_name;
+
+	DPRINTF("plt_resolve_arch('%s', '%s')\n", m->dyn.soname, name);
+
+	sym_def = symbol_def_find(name, m, ssf_nocache, &dest);
+	if (sym_def == NULL) {
+		printf("Definition of '%s' not found.\n", name);
+		abort();
+	}
+
+	addr = symbol_get_addr(sym_def, dest, NULL);
+	*(uint32_t *) (rel->r_offset + m->bias) = (uint32_t) addr;
+	return addr;
+}
+
 void rela_table_process(module_t *m, elf_rela_t *rt, size_t rt_size)
 {
 	/* Unused */
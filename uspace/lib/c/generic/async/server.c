@@ -123,6 +123,12 @@
 
 #define DPRINTF(...)  ((void) 0)
 
+/** Maximum number of calls the async manager dispatches per wakeup. */
+#define ASYNC_MANAGER_BATCH  8
+
+/** Stack size of the async manager fibril, which holds the call batch. */
+#define ASYNC_MANAGER_STACK_SIZE  (2 * PAGE_SIZE)
+
 /* Client connection data */
 typedef struct {
 	ht_link_t link;
@@ -973,13 +979,18 @@ static void handle_call(ipc_call_t *call)
  */
 static errno_t async_manager_worker(void)
 {
-	ipc_call_t call;
+	ipc_call_t calls[ASYNC_MANAGER_BATCH];
+	size_t received;
 	errno_t rc;
 
 	while (true) {
-		rc = fibril_ipc_wait(&call, NULL);
-		if (rc == EOK)
-			handle_call(&call);
+		rc = fibril_ipc_wait_batch(calls, ASYNC_MANAGER_BATCH,
+		    &received, NULL);
+		if (rc != EOK)
+			continue;
+
+		for (size_t i = 0; i < received; i++)
+			handle_call(&calls[i]);
 	}
 
 	return 0;
@@ -1002,7 +1013,8 @@ static errno_t async_manager_fibril(void *arg)
 /** Add one manager to manager list. */
 fid_t async_create_manager(void)
 {
-	fid_t fid = fibril_create_generic(async_manager_fibril, NULL, PAGE_SIZE);
+	fid_t fid = fibril_create_generic(async_manager_fibril, NULL,
+	    ASYNC_MANAGER_STACK_SIZE);
 	fibril_start(fid);
 	return fid;
 }
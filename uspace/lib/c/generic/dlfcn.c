@@ -53,6 +53,8 @@ void *dlopen(const char *path, int flag)
 	if (m == NULL) {
 		m = module_load(runtime_env, path, mlf_local);
 		module_load_deps(m, mlf_local);
+		if ((flag & RTLD_NOW) != 0)
+			m->dyn.bind_now = true;
 		/* Now relocate. */
 		module_process_relocs(m);
 	}
@@ -34,8 +34,8 @@
  * @file
  * @brief Sorting functions.
  *
- * This files contains functions implementing several sorting
- * algorithms (e.g. quick sort and gnome sort).
+ * This file contains a generic stable sort (merge sort with
+ * an insertion sort cutoff).
  *
  */
 
@@ -57,10 +57,12 @@
  */
 #define INDEX(buf, i, elem_size)  ((buf) + (i) * (elem_size))
 
-/** Gnome sort
+/** Ranges up to this many elements are sorted using insertion sort. */
+#define GSORT_INSERTION_MAX  16
+
+/** Insertion sort
  *
- * Apply generic gnome sort algorithm on supplied data,
- * using pre-allocated buffer.
+ * Sort a short range in place. The sort is stable.
  *
  * @param data      Pointer to data to be sorted.
  * @param cnt       Number of elements to be sorted.
@@ -71,30 +73,93 @@
  *                  elem_size bytes long.
  *
  */
-static void _gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
+static void _isort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
     void *arg, void *slot)
 {
-	size_t i = 0;
-
-	while (i < cnt) {
-		if ((i != 0) &&
-		    (cmp(INDEX(data, i, elem_size),
-		    INDEX(data, i - 1, elem_size), arg) == -1)) {
-			memcpy(slot, INDEX(data, i, elem_size), elem_size);
-			memcpy(INDEX(data, i, elem_size), INDEX(data, i - 1, elem_size),
-			    elem_size);
-			memcpy(INDEX(data, i - 1, elem_size), slot, elem_size);
-			i--;
-		} else
-			i++;
+	size_t i;
+	size_t j;
+
+	for (i = 1; i < cnt; i++) {
+		j = i;
+		while ((j > 0) && (cmp(INDEX(data, i, elem_size),
+		    INDEX(data, j - 1, elem_size), arg) < 0))
+			j--;
+
+		if (j == i)
+			continue;
+
+		memcpy(slot, INDEX(data, i, elem_size), elem_size);
+		memmove(INDEX(data, j + 1, elem_size), INDEX(data, j, elem_size),
+		    (i - j) * elem_size);
+		memcpy(INDEX(data, j, elem_size), slot, elem_size);
 	}
 }
 
-/** Gnome sort wrapper
+/** Merge sort
+ *
+ * Apply stable merge sort on supplied data. Short runs are
+ * sorted using insertion sort. Adjacent runs that are already
+ * in order are not merged at all.
+ *
+ * @param data      Pointer to data to be sorted.
+ * @param cnt       Number of elements to be sorted.
+ * @param elem_size Size of one element.
+ * @param cmp       Comparator function.
+ * @param arg       3rd argument passed to cmp.
+ * @param slot      Pointer to scratch memory buffer
+ *                  elem_size bytes long.
+ * @param buf       Pointer to scratch memory buffer
+ *                  (cnt + 1) / 2 elements long.
+ *
+ */
+static void _msort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
+    void *arg, void *slot, void *buf)
+{
+	size_t half = cnt / 2;
+	void *right = INDEX(data, half, elem_size);
+	void *end = INDEX(data, cnt, elem_size);
+	void *lhs;
+	void *lhs_end;
+	void *dst;
+
+	if (cnt <= GSORT_INSERTION_MAX) {
+		_isort(data, cnt, elem_size, cmp, arg, slot);
+		return;
+	}
+
+	_msort(data, half, elem_size, cmp, arg, slot, buf);
+	_msort(right, cnt - half, elem_size, cmp, arg, slot, buf);
+
+	if (cmp(right, INDEX(data, half - 1, elem_size), arg) >= 0)
+		return;
+
+	/* Move the left run aside and merge both runs back into place. */
+	memcpy(buf, data, half * elem_size);
+
+	lhs = buf;
+	lhs_end = INDEX(buf, half, elem_size);
+	dst = data;
+	while ((lhs != lhs_end) && (right != end)) {
+		if (cmp(right, lhs, arg) < 0) {
+			memcpy(dst, right, elem_size);
+			right += elem_size;
+		} else {
+			memcpy(dst, lhs, elem_size);
+			lhs += elem_size;
+		}
+
+		dst += elem_size;
+	}
+
+	memcpy(dst, lhs, lhs_end - lhs);
+}
+
+/** Generic stable sort
  *
  * This is only a wrapper that takes care of memory
- * allocations for storing the slot element for generic
- * gnome sort algorithm.
+ * allocations for the merge buffer and the slot element.
+ * If the merge buffer cannot be allocated, the data is
+ * sorted using insertion sort, which is also stable.
  *
  * @param data      Pointer to data to be sorted.
  * @param cnt       Number of elements to be sorted.
@@ -109,6 +174,7 @@ bool gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp, void *arg)
 {
 	uint8_t ibuf_slot[IBUF_SIZE];
 	void *slot;
+	void *buf = NULL;
 
 	if (elem_size > IBUF_SIZE) {
 		slot = (void *) malloc(elem_size);
@@ -117,7 +183,15 @@ bool gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp, void *arg)
 	} else
 		slot = (void *) ibuf_slot;
 
-	_gsort(data, cnt, elem_size, cmp, arg, slot);
+	if (cnt > GSORT_INSERTION_MAX)
+		buf = malloc(((cnt + 1) / 2) * elem_size);
+
+	if (buf != NULL)
+		_msort(data, cnt, elem_size, cmp, arg, slot, buf);
+	else
+		_isort(data, cnt, elem_size, cmp, arg, slot);
+
+	free(buf);
 
 	if (elem_size > IBUF_SIZE)
 		free(slot);
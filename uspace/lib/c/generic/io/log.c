@@ -31,17 +31,22 @@
  * @{
  */
 
+#include <align.h>
+#include <as.h>
 #include <assert.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <async.h>
 #include <io/log.h>
+#include <io/logfmt.h>
 #include <ipc/logger.h>
 #include <str.h>
 #include <ns.h>
+#include "../private/fibril.h"
 
 /** Id of the first log we create at logger. */
 static sysarg_t default_log_id;
@@ -66,6 +71,24 @@ static async_sess_t *logger_session;
 /** Maximum length of a single log message (in bytes). */
 #define MESSAGE_BUFFER_SIZE 4096
 
+/** Message ring shared with the logger or @c NULL if not available. */
+static logger_ring_t *logger_ring;
+
+/** Serializes writers of the message ring. */
+static FIBRIL_RMUTEX_INITIALIZE(logger_ring_guard);
+
+/** Ids of our logs, in the order of logger_ring_t.levels. */
+static log_t log_ids[LOGGER_RING_MAX_LOGS];
+
+/** Number of valid entries in log_ids. */
+static atomic_size_t log_ids_count;
+
+/** Serializes log_create(). */
+static FIBRIL_MUTEX_INITIALIZE(log_create_guard);
+
+/** Serializes registration of log_msg_bin() formats. */
+static FIBRIL_MUTEX_INITIALIZE(log_fmt_guard);
+
 /** Send formatted message to the logger service.
  *
  * @param session Initialized IPC session with the logger.
@@ -108,6 +131,272 @@ static errno_t logger_message(async_sess_t *session, log_t log, log_level_t leve
 	return reg_msg_rc;
 }
 
+/** Set up the message ring shared with the logger.
+ *
+ * Failure is not fatal, messages are then sent by IPC.
+ */
+static void logger_ring_init(void)
+{
+	logger_ring_t *ring = as_area_create(AS_AREA_ANY, sizeof(logger_ring_t),
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (ring == AS_MAP_FAILED)
+		return;
+
+	/* Until the logger tells us otherwise, send everything. */
+	for (size_t i = 0; i < LOGGER_RING_MAX_LOGS; i++)
+		atomic_init(&ring->levels[i], LVL_LIMIT);
+
+	async_exch_t *exchange = async_exchange_begin(logger_session);
+	if (exchange == NULL) {
+		as_area_destroy(ring);
+		return;
+	}
+
+	aid_t req = async_send_0(exchange, LOGGER_WRITER_SHARE_RING, NULL);
+	errno_t rc = async_share_out_start(exchange, ring, AS_AREA_READ |
+	    AS_AREA_WRITE | AS_AREA_CACHEABLE);
+
+	async_exchange_end(exchange);
+
+	errno_t req_rc;
+	async_wait_for(req, &req_rc);
+
+	if ((rc != EOK) || (req_rc != EOK)) {
+		as_area_destroy(ring);
+		return;
+	}
+
+	logger_ring = ring;
+}
+
+/** Reserve space for a record in the shared ring.
+ *
+ * Space for the longest possible record is reserved, so that the record
+ * can be written right into the ring. On success, the ring is locked
+ * until the record is published by logger_ring_publish().
+ *
+ * @param head Place to store the ring position of the record.
+ * @return The record or @c NULL if there was not enough space.
+ */
+static logger_ring_rec_t *logger_ring_reserve(unsigned int *head)
+{
+	logger_ring_t *ring = logger_ring;
+	size_t rec_max = ALIGN_UP(sizeof(logger_ring_rec_t) + MESSAGE_BUFFER_SIZE,
+	    LOGGER_RING_ALIGN);
+
+	fibril_rmutex_lock(&logger_ring_guard);
+
+	unsigned int pos = atomic_load_explicit(&ring->head,
+	    memory_order_relaxed);
+	unsigned int tail = atomic_load_explicit(&ring->tail,
+	    memory_order_acquire);
+	size_t avail = LOGGER_RING_DATA_SIZE - (pos - tail);
+	size_t offset = pos % LOGGER_RING_DATA_SIZE;
+	size_t to_end = LOGGER_RING_DATA_SIZE - offset;
+	size_t skip = (to_end < rec_max) ? to_end : 0;
+
+	if (avail < skip + rec_max) {
+		fibril_rmutex_unlock(&logger_ring_guard);
+		return NULL;
+	}
+
+	if (skip != 0) {
+		/* Records do not wrap, fill the rest of the ring. */
+		logger_ring_rec_t *rec = (logger_ring_rec_t *) &ring->data[offset];
+		rec->size = skip;
+		rec->level = 0;
+		rec->format = 0;
+		rec->log = 0;
+		pos += skip;
+		offset = 0;
+	}
+
+	*head = pos;
+	return (logger_ring_rec_t *) &ring->data[offset];
+}
+
+/** Publish a record reserved by logger_ring_reserve() and unlock the ring.
+ *
+ * @param head Ring position of the record.
+ * @param rec The record.
+ */
+static void logger_ring_publish(unsigned int head, logger_ring_rec_t *rec)
+{
+	/*
+	 * Publishing the record and checking whether the logger waits
+	 * pairs with the logger announcing it waits and re-checking
+	 * the ring, so that either we notify it or it sees the record.
+	 */
+	atomic_store(&logger_ring->head, head + rec->size);
+	bool notify = atomic_exchange(&logger_ring->waiting, 0) != 0;
+
+	fibril_rmutex_unlock(&logger_ring_guard);
+
+	if (notify) {
+		async_exch_t *exchange = async_exchange_begin(logger_session);
+		if (exchange != NULL) {
+			async_msg_0(exchange, LOGGER_WRITER_RING_NOTIFY);
+			async_exchange_end(exchange);
+		}
+	}
+}
+
+/** Fill a reserved record with a formatted message.
+ *
+ * @param rec The record.
+ * @param log Log to use.
+ * @param level Verbosity level of the message.
+ * @param fmt Format string.
+ * @param args Arguments.
+ */
+static void logger_ring_format(logger_ring_rec_t *rec, log_t log,
+    log_level_t level, const char *fmt, va_list args)
+{
+	char *message = (char *) (rec + 1);
+	vsnprintf(message, MESSAGE_BUFFER_SIZE, fmt, args);
+
+	// FIXME: remove when all USB drivers use libc logging explicitly
+	str_rtrim(message, '\n');
+
+	rec->size = ALIGN_UP(sizeof(logger_ring_rec_t) + str_size(message) + 1,
+	    LOGGER_RING_ALIGN);
+	rec->level = level;
+	rec->format = 0;
+	rec->log = log;
+}
+
+/** Append a formatted message to the shared ring.
+ *
+ * @param log Log to use.
+ * @param level Verbosity level of the message.
+ * @param fmt Format string.
+ * @param args Arguments (not used if there is not enough space).
+ * @return @c false if there was not enough space in the ring.
+ */
+static bool logger_ring_write(log_t log, log_level_t level, const char *fmt,
+    va_list args)
+{
+	unsigned int head;
+	logger_ring_rec_t *rec = logger_ring_reserve(&head);
+	if (rec == NULL)
+		return false;
+
+	logger_ring_format(rec, log, level, fmt, args);
+	logger_ring_publish(head, rec);
+	return true;
+}
+
+/** Append a binary record to the shared ring.
+ *
+ * If the arguments do not fit into a record, the message is formatted
+ * and sent as a (truncated) text record instead.
+ *
+ * @param log Log to use.
+ * @param level Verbosity level of the message.
+ * @param site Call site with registered format.
+ * @param id Format id.
+ * @param fmt Format string.
+ * @param args Arguments (not used if there is not enough space).
+ * @return @c false if there was not enough space in the ring.
+ */
+static bool logger_ring_write_bin(log_t log, log_level_t level,
+    log_fmt_site_t *site, unsigned int id, const char *fmt, va_list args)
+{
+	unsigned int head;
+	logger_ring_rec_t *rec = logger_ring_reserve(&head);
+	if (rec == NULL)
+		return false;
+
+	va_list pack_args;
+	va_copy(pack_args, args);
+	size_t size = log_fmt_pack(rec + 1, MESSAGE_BUFFER_SIZE, site->args,
+	    site->precs, site->nargs, pack_args);
+	va_end(pack_args);
+
+	if ((size == 0) && (site->nargs > 0)) {
+		logger_ring_format(rec, log, level, fmt, args);
+		logger_ring_publish(head, rec);
+		return true;
+	}
+
+	rec->size = ALIGN_UP(sizeof(logger_ring_rec_t) + size,
+	    LOGGER_RING_ALIGN);
+	rec->level = level;
+	rec->format = id;
+	rec->log = log;
+
+	logger_ring_publish(head, rec);
+	return true;
+}
+
+/** Register the format of a log_msg_bin() call site with the logger.
+ *
+ * @param site The call site.
+ * @param fmt Format string.
+ * @return Format id or LOG_FMT_TEXT if the messages are to be sent as text.
+ */
+static unsigned int log_fmt_register(log_fmt_site_t *site, const char *fmt)
+{
+	fibril_mutex_lock(&log_fmt_guard);
+
+	unsigned int id = atomic_load_explicit(&site->id, memory_order_relaxed);
+	if (id != 0)
+		goto leave;
+
+	id = LOG_FMT_TEXT;
+
+	size_t nargs;
+	if (log_fmt_parse(fmt, site->args, site->precs, &nargs) != EOK)
+		goto publish;
+	site->nargs = nargs;
+
+	async_exch_t *exchange = async_exchange_begin(logger_session);
+	if (exchange == NULL)
+		goto publish;
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exchange, LOGGER_WRITER_REGISTER_FORMAT,
+	    &answer);
+	errno_t rc = async_data_write_start(exchange, fmt, str_size(fmt));
+
+	async_exchange_end(exchange);
+
+	errno_t req_rc;
+	async_wait_for(req, &req_rc);
+
+	if ((rc == EOK) && (req_rc == EOK) && (IPC_GET_ARG1(answer) != 0))
+		id = IPC_GET_ARG1(answer);
+
+publish:
+	atomic_store_explicit(&site->id, id, memory_order_release);
+leave:
+	fibril_mutex_unlock(&log_fmt_guard);
+	return id;
+}
+
+/** Check whether the logger would write out a message.
+ *
+ * @param log Log to use.
+ * @param level Verbosity level of the message.
+ * @return @c false if the message would be discarded by the logger.
+ */
+static bool log_level_enabled(log_t log, log_level_t level)
+{
+	if (logger_ring == NULL)
+		return true;
+
+	size_t count = atomic_load_explicit(&log_ids_count,
+	    memory_order_acquire);
+	for (size_t i = 0; i < count; i++) {
+		if (log_ids[i] == log) {
+			return level <= atomic_load_explicit(
+			    &logger_ring->levels[i], memory_order_relaxed);
+		}
+	}
+
+	return true;
+}
+
 /** Get name of the log level.
  *
  * @param level The log level.
@@ -172,6 +461,8 @@ errno_t log_init(const char *prog_name)
 		return ENOMEM;
 	}
 
+	logger_ring_init();
+
 	default_log_id = log_create(prog_name, LOG_NO_PARENT);
 
 	return EOK;
@@ -207,13 +498,28 @@ log_t log_create(const char *name, log_t parent)
 	if ((rc != EOK) || (reg_msg_rc != EOK))
 		return parent;
 
-	return IPC_GET_ARG1(answer);
+	log_t log = IPC_GET_ARG1(answer);
+	size_t index = IPC_GET_ARG2(answer);
+
+	/* Remember which entry of the shared level table belongs to the log. */
+	fibril_mutex_lock(&log_create_guard);
+	size_t count = atomic_load_explicit(&log_ids_count,
+	    memory_order_relaxed);
+	if ((index == count) && (count < LOGGER_RING_MAX_LOGS)) {
+		log_ids[count] = log;
+		atomic_store_explicit(&log_ids_count, count + 1,
+		    memory_order_release);
+	}
+	fibril_mutex_unlock(&log_create_guard);
+
+	return log;
 }
 
 /** Write an entry to the log.
  *
  * The message is printed only if the verbosity level is less than or
- * equal to currently set reporting level of the log.
+ * equal to currently set reporting level of the log. The logger publishes
+ * the levels, so messages that would be discarded are not even formatted.
  *
  * @param ctx Log to use (use LOG_DEFAULT if you have no idea what it means).
  * @param level Severity level of the message.
@@ -239,6 +545,19 @@ void log_msgv(log_t ctx, log_level_t level, const char *fmt, va_list args)
 {
 	assert(level < LVL_LIMIT);
 
+	if (ctx == LOG_DEFAULT)
+		ctx = default_log_id;
+
+	if (!log_level_enabled(ctx, level))
+		return;
+
+	if ((logger_ring != NULL) && logger_ring_write(ctx, level, fmt, args))
+		return;
+
+	/*
+	 * No ring or the ring is full. Sending the message synchronously
+	 * also makes the logger catch up with the ring first.
+	 */
 	char *message_buffer = malloc(MESSAGE_BUFFER_SIZE);
 	if (message_buffer == NULL)
 		return;
@@ -248,5 +567,48 @@ void log_msgv(log_t ctx, log_level_t level, const char *fmt, va_list args)
 	free(message_buffer);
 }
 
+/** Write an entry to the log from a log_msg_bin() call site.
+ *
+ * If the format can be stored in binary records, only the arguments
+ * are copied to the shared ring and the logger formats the message.
+ * Otherwise, this is the same as log_msg().
+ *
+ * @param site The call site.
+ * @param ctx Log to use (use LOG_DEFAULT if you have no idea what it means).
+ * @param level Severity level of the message.
+ * @param fmt Format string in printf-like format (without trailing newline).
+ */
+void log_msg_site(log_fmt_site_t *site, log_t ctx, log_level_t level,
+    const char *fmt, ...)
+{
+	va_list args;
+
+	assert(level < LVL_LIMIT);
+
+	if (ctx == LOG_DEFAULT)
+		ctx = default_log_id;
+
+	if (!log_level_enabled(ctx, level))
+		return;
+
+	va_start(args, fmt);
+
+	if (logger_ring != NULL) {
+		unsigned int id = atomic_load_explicit(&site->id,
+		    memory_order_acquire);
+		if (id == 0)
+			id = log_fmt_register(site, fmt);
+
+		if ((id != LOG_FMT_TEXT) &&
+		    logger_ring_write_bin(ctx, level, site, id, fmt, args)) {
+			va_end(args);
+			return;
+		}
+	}
+
+	log_msgv(ctx, level, fmt, args);
+	va_end(args);
+}
+
 /** @}
  */
@@ -147,5 +147,23 @@ errno_t logctl_set_root(void)
 	return (errno_t) reg_msg_rc;
 }
 
+/** Make the logger write buffered messages out to the log files.
+ *
+ * @return Error code or EOK on success.
+ */
+errno_t logctl_flush(void)
+{
+	async_exch_t *exchange = NULL;
+	errno_t rc = start_logger_exchange(&exchange);
+	if (rc != EOK)
+		return rc;
+
+	rc = (errno_t) async_req_0_0(exchange, LOGGER_CONTROL_FLUSH);
+
+	async_exchange_end(exchange);
+
+	return rc;
+}
+
 /** @}
  */
@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Binary log records.
+ *
+ * The format string is split into conversion specifications the same way
+ * printf_core() does it. Conversions that cannot be stored in a binary
+ * record (wide characters and strings) make the whole format unsupported
+ * and such messages are formatted by the client as usual.
+ */
+
+#include <assert.h>
+#include <ctype.h>
+#include <io/logfmt.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <str.h>
+
+/** Longest conversion specification with '*' replaced by numbers. */
+#define LOG_SPEC_MAX 48
+
+/** Conversion specification. */
+typedef struct {
+	/** Length including the leading '%' */
+	size_t len;
+	/** Conversion character, '%' for the percent sign itself */
+	char conv;
+	/** Width is passed as an argument */
+	bool width_arg;
+	/** Precision is passed as an argument */
+	bool prec_arg;
+	/** Precision given in the format, zero if none */
+	size_t prec;
+	/** Argument of the conversion (if @c conv is not '%') */
+	log_arg_t arg;
+} log_spec_t;
+
+static bool log_spec_flag(char c)
+{
+	return (c == '#') || (c == '-') || (c == '+') || (c == ' ') ||
+	    (c == '0');
+}
+
+/** Parse one conversion specification.
+ *
+ * @param fmt Specification starting with '%'.
+ * @param spec Place to store the result.
+ * @return EOK on success, ENOTSUP if the conversion is not supported
+ *         in binary records.
+ */
+static errno_t log_spec_parse(const char *fmt, log_spec_t *spec)
+{
+	size_t i = 1;
+
+	while (log_spec_flag(fmt[i]))
+		i++;
+
+	spec->width_arg = false;
+	if (fmt[i] == '*') {
+		spec->width_arg = true;
+		i++;
+	} else {
+		while (isdigit(fmt[i]))
+			i++;
+	}
+
+	spec->prec_arg = false;
+	spec->prec = 0;
+	if (fmt[i] == '.') {
+		i++;
+		if (fmt[i] == '*') {
+			spec->prec_arg = true;
+			i++;
+		} else {
+			while (isdigit(fmt[i])) {
+				if (spec->prec <= LOG_ARG_STR_MAX)
+					spec->prec = spec->prec * 10 + (fmt[i] - '0');
+				i++;
+			}
+		}
+	}
+
+	/* 'H' stands for "hh" and 'L' for "ll". */
+	char qualifier = '\0';
+	switch (fmt[i]) {
+	case 't':
+	case 'z':
+	case 'j':
+		qualifier = fmt[i++];
+		break;
+	case 'h':
+		qualifier = 'h';
+		if (fmt[++i] == 'h') {
+			qualifier = 'H';
+			i++;
+		}
+		break;
+	case 'l':
+		qualifier = 'l';
+		if (fmt[++i] == 'l') {
+			qualifier = 'L';
+			i++;
+		}
+		break;
+	}
+
+	spec->conv = fmt[i];
+	spec->len = i + 1;
+
+	switch (spec->conv) {
+	case 's':
+		if (qualifier == 'l')
+			return ENOTSUP;
+		spec->arg = LOG_ARG_STR;
+		break;
+	case 'c':
+		if (qualifier == 'l')
+			return ENOTSUP;
+		spec->arg = LOG_ARG_INT;
+		break;
+	case 'G':
+	case 'g':
+	case 'F':
+	case 'f':
+	case 'E':
+	case 'e':
+		spec->arg = LOG_ARG_DOUBLE;
+		break;
+	case 'P':
+	case 'p':
+		spec->arg = LOG_ARG_PTR;
+		break;
+	case 'b':
+	case 'o':
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'X':
+	case 'x':
+		switch (qualifier) {
+		case 'l':
+			spec->arg = LOG_ARG_LONG;
+			break;
+		case 'L':
+			spec->arg = LOG_ARG_LLONG;
+			break;
+		case 'z':
+			spec->arg = LOG_ARG_SIZE;
+			break;
+		case 'j':
+			spec->arg = LOG_ARG_MAX;
+			break;
+		case 't':
+			/* Matches how printf_core() reads ptrdiff_t. */
+			if (sizeof(ptrdiff_t) == sizeof(int32_t))
+				spec->arg = LOG_ARG_INT;
+			else
+				spec->arg = LOG_ARG_LLONG;
+			break;
+		default:
+			spec->arg = LOG_ARG_INT;
+		}
+		break;
+	case '%':
+		break;
+	default:
+		return ENOTSUP;
+	}
+
+	return EOK;
+}
+
+/** Determine arguments of a format string.
+ *
+ * @param fmt Format string.
+ * @param args Array of LOG_FMT_MAX_ARGS entries to store the log_arg_t
+ *             of each argument.
+ * @param precs Array of LOG_FMT_MAX_ARGS entries to store the precision
+ *              given in the format for each string argument (zero if none
+ *              or for other arguments), can be NULL.
+ * @param nargs Place to store the number of arguments.
+ * @return EOK on success, ENOTSUP if the format cannot be used with
+ *         binary records, ELIMIT if it has too many arguments.
+ */
+errno_t log_fmt_parse(const char *fmt, uint8_t *args, uint16_t *precs,
+    size_t *nargs)
+{
+	size_t count = 0;
+
+	while (*fmt != '\0') {
+		if (*fmt != '%') {
+			fmt++;
+			continue;
+		}
+
+		log_spec_t spec;
+		errno_t rc = log_spec_parse(fmt, &spec);
+		if (rc != EOK)
+			return rc;
+
+		if (spec.conv != '%') {
+			size_t needed = 1 + (spec.width_arg ? 1 : 0) +
+			    (spec.prec_arg ? 1 : 0);
+			if (count + needed > LOG_FMT_MAX_ARGS)
+				return ELIMIT;
+
+			if (spec.width_arg) {
+				if (precs != NULL)
+					precs[count] = 0;
+				args[count++] = LOG_ARG_INT;
+			}
+			if (spec.prec_arg) {
+				if (precs != NULL)
+					precs[count] = 0;
+				args[count++] = LOG_ARG_PREC;
+			}
+			if (precs != NULL) {
+				precs[count] = (spec.arg == LOG_ARG_STR) ?
+				    min(spec.prec, (size_t) LOG_ARG_STR_MAX) : 0;
+			}
+			args[count++] = spec.arg;
+		}
+
+		fmt += spec.len;
+	}
+
+	*nargs = count;
+	return EOK;
+}
+
+/** Determine how much of a string argument to store.
+ *
+ * A string with precision need not be terminated, so no more than
+ * @a prec characters are looked at.
+ *
+ * @param str The string.
+ * @param max Maximal number of bytes to store.
+ * @param prec Maximal number of characters to store, zero if unlimited.
+ * @return Number of bytes to store, never ending in the middle of
+ *         a character.
+ */
+static size_t log_fmt_str_size(const char *str, size_t max, size_t prec)
+{
+	if (prec == 0) {
+		size_t len = str_nsize(str, max);
+		while ((len > 0) && ((str[len] & 0xc0) == 0x80))
+			len--;
+		return len;
+	}
+
+	size_t len = 0;
+	for (size_t i = 0; i < prec; i++) {
+		if ((len == max) || (str[len] == '\0'))
+			break;
+
+		/* Length of the character from its first byte. */
+		uint8_t b0 = str[len];
+		size_t clen = 1;
+		if ((b0 & 0xe0) == 0xc0)
+			clen = 2;
+		else if ((b0 & 0xf0) == 0xe0)
+			clen = 3;
+		else if ((b0 & 0xf8) == 0xf0)
+			clen = 4;
+
+		if (clen > max - len)
+			break;
+		len += clen;
+	}
+
+	return len;
+}
+
+/** Store arguments of a message.
+ *
+ * Strings are truncated to their precision, to LOG_ARG_STR_MAX bytes
+ * and to the space left in the buffer, never in the middle of a character.
+ *
+ * @param buf Buffer to store the arguments to.
+ * @param size Size of the buffer.
+ * @param args Arguments as determined by log_fmt_parse().
+ * @param precs Precisions of string arguments as determined by
+ *              log_fmt_parse().
+ * @param nargs Number of arguments.
+ * @param ap Argument values.
+ * @return Number of bytes stored, zero if the buffer was too small.
+ */
+size_t log_fmt_pack(void *buf, size_t size, const uint8_t *args,
+    const uint16_t *precs, size_t nargs, va_list ap)
+{
+	uint8_t *out = buf;
+	size_t pos = 0;
+	/* Precision passed as an argument for the next conversion */
+	int prec = 0;
+
+#define LOG_PACK(type) \
+	do { \
+		type value = va_arg(ap, type); \
+		if (size - pos < sizeof(value)) \
+			return 0; \
+		memcpy(out + pos, &value, sizeof(value)); \
+		pos += sizeof(value); \
+	} while (0)
+
+	for (size_t i = 0; i < nargs; i++) {
+		switch ((log_arg_t) args[i]) {
+		case LOG_ARG_INT:
+			LOG_PACK(int);
+			break;
+		case LOG_ARG_PREC:
+			if (size - pos < sizeof(prec))
+				return 0;
+
+			prec = va_arg(ap, int);
+			memcpy(out + pos, &prec, sizeof(prec));
+			pos += sizeof(prec);
+			/* The precision applies to the next argument only. */
+			continue;
+		case LOG_ARG_LONG:
+			LOG_PACK(long);
+			break;
+		case LOG_ARG_LLONG:
+			LOG_PACK(long long);
+			break;
+		case LOG_ARG_PTR:
+			LOG_PACK(void *);
+			break;
+		case LOG_ARG_SIZE:
+			LOG_PACK(size_t);
+			break;
+		case LOG_ARG_MAX:
+			LOG_PACK(uintmax_t);
+			break;
+		case LOG_ARG_DOUBLE:
+			LOG_PACK(double);
+			break;
+		case LOG_ARG_STR:
+			if (size - pos < sizeof(uint16_t))
+				return 0;
+
+			const char *str = va_arg(ap, const char *);
+			if (str == NULL)
+				str = "(NULL)";
+
+			size_t max = min(size - pos - sizeof(uint16_t),
+			    (size_t) LOG_ARG_STR_MAX);
+			size_t str_prec = precs[i];
+			if ((prec > 0) && ((str_prec == 0) ||
+			    ((size_t) prec < str_prec)))
+				str_prec = prec;
+			size_t len = log_fmt_str_size(str, max, str_prec);
+
+			uint16_t len16 = len;
+			memcpy(out + pos, &len16, sizeof(len16));
+			memcpy(out + pos + sizeof(len16), str, len);
+			pos += sizeof(len16) + len;
+			break;
+		}
+
+		prec = 0;
+	}
+
+#undef LOG_PACK
+
+	return pos;
+}
+
+static bool log_fmt_take(const uint8_t *data, size_t size, size_t *pos,
+    void *value, size_t value_size)
+{
+	if (size - *pos < value_size)
+		return false;
+
+	memcpy(value, data + *pos, value_size);
+	*pos += value_size;
+	return true;
+}
+
+/** Format a message from a binary record.
+ *
+ * The arguments come from another task and are checked against
+ * the format, so a broken record cannot make us read garbage.
+ *
+ * @param buf Buffer for the message.
+ * @param size Size of the buffer (the message is truncated to fit).
+ * @param fmt Format string accepted by log_fmt_parse().
+ * @param data Arguments stored by log_fmt_pack().
+ * @param data_size Size of the arguments.
+ * @return EOK on success, EINVAL if the arguments do not match the format.
+ */
+errno_t log_fmt_format(char *buf, size_t size, const char *fmt,
+    const void *data, size_t data_size)
+{
+	const uint8_t *in = data;
+	size_t in_pos = 0;
+	size_t pos = 0;
+	int rc;
+
+	assert(size > 0);
+	buf[0] = '\0';
+
+	while (*fmt != '\0') {
+		if (*fmt != '%') {
+			size_t len = 0;
+			while ((fmt[len] != '\0') && (fmt[len] != '%'))
+				len++;
+
+			size_t copy = min(len, size - 1 - pos);
+			while ((copy < len) && (copy > 0) &&
+			    ((fmt[copy] & 0xc0) == 0x80))
+				copy--;
+
+			memcpy(buf + pos, fmt, copy);
+			pos += copy;
+			buf[pos] = '\0';
+			fmt += len;
+			continue;
+		}
+
+		log_spec_t spec;
+		if (log_spec_parse(fmt, &spec) != EOK)
+			return EINVAL;
+
+		if (spec.conv == '%') {
+			if (pos < size - 1) {
+				buf[pos++] = '%';
+				buf[pos] = '\0';
+			}
+			fmt += spec.len;
+			continue;
+		}
+
+		/* Replace '*' by the stored width and precision. */
+		char conv[LOG_SPEC_MAX];
+		size_t conv_len = 0;
+		for (size_t i = 0; i < spec.len; i++) {
+			if ((fmt[i] == '*') || ((fmt[i] == '.') && (fmt[i + 1] == '*'))) {
+				bool prec = (fmt[i] == '.');
+				int value;
+				if (!log_fmt_take(in, data_size, &in_pos, &value,
+				    sizeof(value)))
+					return EINVAL;
+
+				if (prec) {
+					i++;
+					/* Negative precision is ignored. */
+					if (value < 0)
+						continue;
+				}
+
+				rc = snprintf(conv + conv_len, LOG_SPEC_MAX - conv_len,
+				    prec ? ".%d" : "%d", value);
+				if (rc < 0)
+					return EINVAL;
+				conv_len += rc;
+			} else {
+				conv[conv_len++] = fmt[i];
+			}
+
+			if (conv_len >= LOG_SPEC_MAX - 1)
+				return EINVAL;
+		}
+		conv[conv_len] = '\0';
+
+		char *out = buf + pos;
+		size_t out_size = size - pos;
+
+#define LOG_FORMAT(type) \
+	do { \
+		type value; \
+		if (!log_fmt_take(in, data_size, &in_pos, &value, \
+		    sizeof(value))) \
+			return EINVAL; \
+		rc = snprintf(out, out_size, conv, value); \
+	} while (0)
+
+		switch (spec.arg) {
+		case LOG_ARG_INT:
+		case LOG_ARG_PREC:
+			LOG_FORMAT(int);
+			break;
+		case LOG_ARG_LONG:
+			LOG_FORMAT(long);
+			break;
+		case LOG_ARG_LLONG:
+			LOG_FORMAT(long long);
+			break;
+		case LOG_ARG_PTR:
+			LOG_FORMAT(void *);
+			break;
+		case LOG_ARG_SIZE:
+			LOG_FORMAT(size_t);
+			break;
+		case LOG_ARG_MAX:
+			LOG_FORMAT(uintmax_t);
+			break;
+		case LOG_ARG_DOUBLE:
+			LOG_FORMAT(double);
+			break;
+		case LOG_ARG_STR:
+			;
+			uint16_t len;
+			char str[LOG_ARG_STR_MAX + 1];
+			if (!log_fmt_take(in, data_size, &in_pos, &len,
+			    sizeof(len)) || (len > LOG_ARG_STR_MAX) ||
+			    !log_fmt_take(in, data_size, &in_pos, str, len))
+				return EINVAL;
+			str[len] = '\0';
+			rc = snprintf(out, out_size, conv, str);
+			break;
+		}
+
+#undef LOG_FORMAT
+
+		if (rc > 0)
+			pos = min(pos + rc, size - 1);
+		fmt += spec.len;
+	}
+
+	return EOK;
+}
+
+/** @}
+ */
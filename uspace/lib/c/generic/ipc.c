@@ -176,6 +176,26 @@ errno_t ipc_wait(ipc_call_t *call, sysarg_t usec, unsigned int flags)
 	return __SYSCALL3(SYS_IPC_WAIT, (sysarg_t) call, usec, flags);
 }
 
+/** Wait for IPC calls and answers and retrieve as many as are queued.
+ *
+ * Only the wait for the first call/answer may block.
+ *
+ * @param calls         Array of pointers to calls to fill.
+ * @param count         Number of elements of calls.
+ * @param[out] received Number of calls/answers stored in calls.
+ * @param usec          Timeout for the first call/answer.
+ * @param flags         Flags for the first call/answer.
+ *
+ * @return EOK if at least one call/answer was retrieved.
+ */
+errno_t ipc_wait_batch(ipc_call_t **calls, size_t count, size_t *received,
+    sysarg_t usec, unsigned int flags)
+{
+	*received = 1;
+	return __SYSCALL5(SYS_IPC_WAIT_BATCH, (sysarg_t) calls, count,
+	    (sysarg_t) received, usec, flags);
+}
+
 /** Hang up a phone.
  *
  * @param phandle  Handle of the phone to be hung up.
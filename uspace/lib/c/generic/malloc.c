@@ -76,6 +76,13 @@
  */
 #define SHRINK_GRANULARITY  (64 * PAGE_SIZE)
 
+/** Largest heap area to be populated on creation.
+ *
+ * Pages of bigger areas are faulted in on first access.
+ *
+ */
+#define AREA_POPULATE_LIMIT  (64 * PAGE_SIZE)
+
 /** Overhead of each heap block. */
 #define STRUCT_OVERHEAD \
 	(sizeof(heap_block_head_t) + sizeof(heap_block_foot_t))
@@ -287,8 +294,17 @@ static bool area_create(size_t size)
 {
 	/* Align the heap area size on page boundary */
 	size_t asize = ALIGN_UP(size, PAGE_SIZE);
-	void *astart = as_area_create(AS_AREA_ANY, asize,
-	    AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+
+	/*
+	 * Small areas are about to be used right away, so map them
+	 * up front. Large ones may be sparse and are faulted in lazily.
+	 */
+	unsigned int flags = AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE;
+	if (asize <= AREA_POPULATE_LIMIT)
+		flags |= AS_AREA_POPULATE;
+
+	void *astart = as_area_create(AS_AREA_ANY, asize, flags,
+	    AS_AREA_UNPAGED);
 	if (astart == AS_MAP_FAILED)
 		return false;
 
@@ -84,6 +84,8 @@ extern errno_t fibril_wait_timeout(fibril_event_t *, const struct timespec *);
 extern void fibril_notify(fibril_event_t *);
 
 extern errno_t fibril_ipc_wait(ipc_call_t *, const struct timespec *);
+extern errno_t fibril_ipc_wait_batch(ipc_call_t *, size_t, size_t *,
+    const struct timespec *);
 extern void fibril_ipc_poke(void);
 
 /**
@@ -33,12 +33,22 @@
 /**
  * @file
  * @brief Quicksort.
+ *
+ * Introsort with median-of-three pivots and an insertion sort cutoff.
  */
 
+#include <macros.h>
+#include <mem.h>
 #include <qsort.h>
 #include <stdbool.h>
 #include <stddef.h>
 
+/** Ranges up to this many elements are sorted using insertion sort */
+#define QS_INSERTION_MAX  16
+
+/** Elements are swapped through a stack buffer of this size */
+#define QS_SWAP_CHUNK  64
+
 /** Quicksort spec */
 typedef struct {
 	void *base;
@@ -94,71 +104,197 @@ static void elem_swap(qs_spec_t *qs, size_t i, size_t j)
 {
 	char *a;
 	char *b;
-	char t;
+	char t[QS_SWAP_CHUNK];
 	size_t k;
+	size_t n;
 
 	a = qs->base + i * qs->size;
 	b = qs->base + j * qs->size;
 
-	for (k = 0; k < qs->size; k++) {
-		t = a[k];
-		a[k] = b[k];
-		b[k] = t;
+	for (k = 0; k < qs->size; k += n) {
+		n = min(qs->size - k, QS_SWAP_CHUNK);
+		memcpy(t, a + k, n);
+		memcpy(a + k, b + k, n);
+		memcpy(b + k, t, n);
+	}
+}
+
+/** Sort a short range of indices using insertion sort.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ */
+static void insertion_sort(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t i, j;
+
+	for (i = lo + 1; i < hi; i++) {
+		for (j = i; j > lo && elem_lt(qs, j, j - 1); j--)
+			elem_swap(qs, j, j - 1);
 	}
 }
 
+/** Move the median of three elements to the lower bound.
+ *
+ * @param qs Quicksort spec
+ * @param lo Index receiving the median
+ * @param a First sample index
+ * @param b Second sample index
+ * @param c Third sample index
+ */
+static void median_to_lo(qs_spec_t *qs, size_t lo, size_t a, size_t b,
+    size_t c)
+{
+	size_t m;
+
+	if (elem_lt(qs, a, b)) {
+		if (elem_lt(qs, b, c))
+			m = b;
+		else if (elem_lt(qs, a, c))
+			m = c;
+		else
+			m = a;
+	} else if (elem_lt(qs, a, c)) {
+		m = a;
+	} else if (elem_lt(qs, b, c)) {
+		m = c;
+	} else {
+		m = b;
+	}
+
+	elem_swap(qs, lo, m);
+}
+
 /** Partition a range of indices.
+ *
+ * The pivot is the median of the first, middle and last element and
+ * is kept at @a lo during partitioning. The median guarantees that
+ * both scans stop within the range, so they need no bound checks.
+ * The range must contain at least three elements.
  *
  * @param qs Quicksort spec
  * @param lo Lower bound (inclusive)
- * @param hi Upper bound (inclusive)
- * @return Pivot index
+ * @param hi Upper bound (exclusive)
+ * @return Split index. No element before it is greater than any
+ *         element from it onwards.
  */
 static size_t partition(qs_spec_t *qs, size_t lo, size_t hi)
 {
-	size_t pivot;
 	size_t i, j;
 
-	pivot = lo + (hi - lo) / 2;
-	i = lo;
+	median_to_lo(qs, lo, lo + 1, lo + (hi - lo) / 2, hi - 1);
+
+	i = lo + 1;
 	j = hi;
 	while (true) {
-		while (elem_lt(qs, i, pivot))
+		while (elem_lt(qs, i, lo))
 			++i;
-		while (elem_lt(qs, pivot, j))
+		--j;
+		while (elem_lt(qs, lo, j))
 			--j;
 
 		if (i >= j)
-			return j;
+			return i;
 
 		elem_swap(qs, i, j);
+		++i;
+	}
+}
 
-		/* Need to follow pivot movement */
-		if (i == pivot)
-			pivot = j;
-		else if (j == pivot)
-			pivot = i;
+/** Restore the heap property below a heap node.
+ *
+ * @param qs Quicksort spec
+ * @param lo Index of the heap root
+ * @param node Node index relative to @a lo
+ * @param cnt Number of elements in the heap
+ */
+static void sift_down(qs_spec_t *qs, size_t lo, size_t node, size_t cnt)
+{
+	size_t child;
+
+	while ((child = 2 * node + 1) < cnt) {
+		if (child + 1 < cnt && elem_lt(qs, lo + child, lo + child + 1))
+			++child;
+		if (!elem_lt(qs, lo + node, lo + child))
+			return;
+
+		elem_swap(qs, lo + node, lo + child);
+		node = child;
+	}
+}
+
+/** Sort a range of indices using heapsort.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ */
+static void heapsort(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t cnt = hi - lo;
+	size_t i;
 
-		i++;
-		j--;
+	for (i = cnt / 2; i > 0; i--)
+		sift_down(qs, lo, i - 1, cnt);
+
+	for (i = cnt - 1; i > 0; i--) {
+		elem_swap(qs, lo, lo + i);
+		sift_down(qs, lo, 0, i);
 	}
 }
 
 /** Sort a range of indices.
+ *
+ * This is introsort. Ranges of up to QS_INSERTION_MAX elements are
+ * left for insertion sort and if partitioning does not converge within
+ * @a depth levels we switch to heapsort to keep the worst case at
+ * O(n log n). We only recurse into the smaller partition, so the stack
+ * depth is logarithmic.
  *
  * @param qs Quicksort spec
  * @param lo Lower bound (inclusive)
- * @param hi Upper bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ * @param depth Remaining partitioning depth
  */
-static void quicksort(qs_spec_t *qs, size_t lo, size_t hi)
+static void quicksort(qs_spec_t *qs, size_t lo, size_t hi, unsigned depth)
 {
 	size_t p;
 
-	if (lo < hi) {
+	while (hi - lo > QS_INSERTION_MAX) {
+		if (depth == 0) {
+			heapsort(qs, lo, hi);
+			return;
+		}
+
+		--depth;
 		p = partition(qs, lo, hi);
-		quicksort(qs, lo, p);
-		quicksort(qs, p + 1, hi);
+
+		if (p - lo < hi - p) {
+			quicksort(qs, lo, p, depth);
+			lo = p;
+		} else {
+			quicksort(qs, p, hi, depth);
+			hi = p;
+		}
 	}
+
+	insertion_sort(qs, lo, hi);
+}
+
+/** Sort the whole array described by a quicksort spec.
+ *
+ * @param qs Quicksort spec
+ */
+static void qs_sort(qs_spec_t *qs)
+{
+	unsigned depth = 0;
+	size_t n;
+
+	for (n = qs->nmemb; n > 1; n /= 2)
+		depth += 2;
+
+	quicksort(qs, 0, qs->nmemb, depth);
 }
 
 /** Quicksort.
@@ -182,7 +318,7 @@ void qsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 	qs.compar = compar_wrap;
 	qs.arg = compar;
 
-	quicksort(&qs, 0, nmemb - 1);
+	qs_sort(&qs);
 }
 
 /** Quicksort with extra argument to comparison function.
@@ -207,7 +343,7 @@ void qsort_r(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 	qs.compar = compar;
 	qs.arg = arg;
 
-	quicksort(&qs, 0, nmemb - 1);
+	qs_sort(&qs);
 }
 
 /** @}
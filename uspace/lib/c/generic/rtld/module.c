@@ -49,6 +49,7 @@
 #include <rtld/dynamic.h>
 #include <rtld/rtld_arch.h>
 #include <rtld/module.h>
+#include <rtld/symbol.h>
 
 #include "../private/libc.h"
 
@@ -96,30 +97,57 @@ errno_t module_create_static_exec(rtld_t *rtld, module_t **rmodule)
 	return EOK;
 }
 
-/** (Eagerly) process all relocation tables in a module.
+/** Determine whether PLT relocations of a module can be deferred.
  *
- * Currently works as if LD_BIND_NOW was specified.
+ * Binding is eager if requested for the whole process or by the module
+ * itself (linked with -z now), if there is no lazy binding entry point
+ * and for the module providing it, as the resolver calls through its PLT.
+ */
+static bool module_bind_lazy(module_t *m)
+{
+	rtld_t *rtld = m->rtld;
+
+	return !rtld->bind_now && !m->dyn.bind_now && m->dyn.plt_got != NULL &&
+	    rtld->plt_trampoline != NULL && m != rtld->plt_trampoline_mod;
+}
+
+/** Process all relocation tables in a module.
+ *
+ * PLT relocations are only prepared to be bound on the first call,
+ * unless module_bind_lazy() says otherwise.
  */
 void module_process_relocs(module_t *m)
 {
+#ifdef RTLD_STATS
+	struct timespec start, end;
+#endif
+
 	DPRINTF("module_process_relocs('%s')\n", m->dyn.soname);
 
 	/* Do not relocate twice. */
 	if (m->relocated)
 		return;
 
+#ifdef RTLD_STATS
+	getuptime(&start);
+#endif
+
 	module_process_pre_arch(m);
 
 	/* jmp_rel table */
 	if (m->dyn.jmp_rel != NULL) {
 		DPRINTF("jmp_rel table\n");
-		if (m->dyn.plt_rel == DT_REL) {
+		if (module_bind_lazy(m) && plt_lazy_setup_arch(m)) {
+			DPRINTF("jmp_rel table bound lazily\n");
+		} else if (m->dyn.plt_rel == DT_REL) {
 			DPRINTF("jmp_rel table type DT_REL\n");
 			rel_table_process(m, m->dyn.jmp_rel, m->dyn.plt_rel_sz);
+			m->n_relocs += m->dyn.plt_rel_sz / sizeof(elf_rel_t);
 		} else {
 			assert(m->dyn.plt_rel == DT_RELA);
 			DPRINTF("jmp_rel table type DT_RELA\n");
 			rela_table_process(m, m->dyn.jmp_rel, m->dyn.plt_rel_sz);
+			m->n_relocs += m->dyn.plt_rel_sz / sizeof(elf_rela_t);
 		}
 	}
 
@@ -127,15 +155,22 @@ void module_process_relocs(module_t *m)
 	if (m->dyn.rel != NULL) {
 		DPRINTF("rel table\n");
 		rel_table_process(m, m->dyn.rel, m->dyn.rel_sz);
+		m->n_relocs += m->dyn.rel_sz / sizeof(elf_rel_t);
 	}
 
 	/* rela table */
 	if (m->dyn.rela != NULL) {
 		DPRINTF("rela table\n");
 		rela_table_process(m, m->dyn.rela, m->dyn.rela_sz);
+		m->n_relocs += m->dyn.rela_sz / sizeof(elf_rela_t);
 	}
 
 	m->relocated = true;
+
+#ifdef RTLD_STATS
+	getuptime(&end);
+	m->reloc_time = ts_sub_diff(&end, &start);
+#endif
 }
 
 /** Find module structure by soname/pathname.
@@ -231,6 +266,10 @@ module_t *module_load(rtld_t *rtld, const char *name, mlflags_t flags)
 	/* Insert into the list of loaded modules */
 	list_append(&m->modules_link, &rtld->modules);
 
+	/* Cached lookups might now resolve to the new module. */
+	if (!m->local)
+		symbol_cache_clear(rtld);
+
 	/* Copy TLS info */
 	m->tdata = info.tls.tdata;
 	m->tdata_size = info.tls.tdata_size;
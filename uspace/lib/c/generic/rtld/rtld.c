@@ -37,13 +37,70 @@
 #include <errno.h>
 #include <rtld/module.h>
 #include <rtld/rtld.h>
+#include <rtld/rtld_arch.h>
 #include <rtld/rtld_debug.h>
+#include <rtld/symbol.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
+#include <time.h>
 
 rtld_t *runtime_env;
 static rtld_t rt_env_static;
 
+#ifdef RTLD_STATS
+
+/** Print relocation and symbol lookup statistics of all modules. */
+static void rtld_print_stats(rtld_t *rtld, nsec_t load_time, nsec_t reloc_time)
+{
+	size_t relocs = 0;
+	size_t lazy = 0;
+	size_t lookups = 0;
+	size_t hits = 0;
+
+	printf("rtld: %-24s %8s %8s %8s %8s %10s %s\n", "module", "relocs",
+	    "lazy", "lookups", "cached", "time[us]", "hash");
+
+	list_foreach(rtld->modules, modules_link, module_t, m) {
+		printf("rtld: %-24s %8zu %8zu %8zu %8zu %10lld %s\n",
+		    m->dyn.soname, m->n_relocs, m->n_lazy, m->n_lookups,
+		    m->n_cache_hits,
+		    NSEC2USEC(m->reloc_time),
+		    m->dyn.gnu_hash != NULL ? "gnu" : "sysv");
+
+		relocs += m->n_relocs;
+		lazy += m->n_lazy;
+		lookups += m->n_lookups;
+		hits += m->n_cache_hits;
+	}
+
+	printf("rtld: %zu relocations (%zu deferred), %zu lookups "
+	    "(%zu cached), load %lld us, relocation %lld us\n", relocs, lazy,
+	    lookups, hits, NSEC2USEC(load_time), NSEC2USEC(reloc_time));
+}
+
+#endif
+
+/** Find the lazy binding entry point among the program's modules.
+ *
+ * It is looked up rather than referenced directly, as the program
+ * must call into its own copy of the C library, not the loader's.
+ */
+static void rtld_find_plt_trampoline(rtld_t *rtld)
+{
+	elf_symbol_t *sym;
+	module_t *m;
+
+	sym = symbol_bfs_find(PLT_TRAMPOLINE_NAME, rtld->program, &m);
+	if (sym == NULL) {
+		DPRINTF("No lazy binding entry point, binding eagerly\n");
+		return;
+	}
+
+	rtld->plt_trampoline = symbol_get_addr(sym, m, NULL);
+	rtld->plt_trampoline_mod = m;
+}
+
 /** Initialize the runtime linker for use in a statically-linked executable. */
 errno_t rtld_init_static(void)
 {
@@ -73,6 +130,11 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 {
 	rtld_t *env;
 	module_t *prog;
+#ifdef RTLD_STATS
+	struct timespec start, loaded, relocated;
+
+	getuptime(&start);
+#endif
 
 	DPRINTF("Load dynamically linked program.\n");
 
@@ -129,6 +191,22 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 	/* Compute static TLS size */
 	modules_process_tls(env);
 
+	/*
+	 * Linking the program with -z now makes the whole process bind
+	 * eagerly, there being no environment to pass LD_BIND_NOW in.
+	 */
+#ifdef RTLD_BIND_NOW
+	env->bind_now = true;
+#else
+	env->bind_now = prog->dyn.bind_now;
+#endif
+	if (!env->bind_now)
+		rtld_find_plt_trampoline(env);
+
+#ifdef RTLD_STATS
+	getuptime(&loaded);
+#endif
+
 	/*
 	 * Now relocate/link all modules together.
 	 */
@@ -137,6 +215,19 @@ errno_t rtld_prog_process(elf_finfo_t *p_info, rtld_t **rre)
 	DPRINTF("Relocate all modules\n");
 	modules_process_relocs(env, prog);
 
+	/*
+	 * The lookup cache was allocated from the loader's heap, which
+	 * the program's allocator knows nothing about. Free it before
+	 * handing the environment over to the program.
+	 */
+	symbol_cache_clear(env);
+
+#ifdef RTLD_STATS
+	getuptime(&relocated);
+	rtld_print_stats(env, ts_sub_diff(&loaded, &start),
+	    ts_sub_diff(&relocated, &loaded));
+#endif
+
 	*rre = env;
 	return EOK;
 }
@@ -34,16 +34,31 @@
  * @file
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 
 #include <elf/elf.h>
+#include <rtld/elf_dyn.h>
 #include <rtld/module.h>
 #include <rtld/rtld.h>
 #include <rtld/rtld_debug.h>
 #include <rtld/symbol.h>
 
+/** Initial number of slots in the symbol lookup cache */
+#define SYM_CACHE_INIT_SIZE 256
+
+/** Symbol name together with its hashes, computed once per lookup */
+typedef struct {
+	const char *name;
+	/** GNU hash of name */
+	elf_word gnu_hash;
+	/** SysV hash of name, valid iff elf_hash_valid is set */
+	elf_word elf_hash;
+	bool elf_hash_valid;
+} symbol_key_t;
+
 /*
  * Hash tables are 32-bit (elf_word) even for 64-bit ELF files.
  */
@@ -62,38 +77,127 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/** Hash function used by DT_GNU_HASH (Bernstein's h * 33 + c). */
+static elf_word gnu_hash(const unsigned char *name)
+{
+	elf_word h = 5381;
+
+	while (*name)
+		h = (h << 5) + h + *name++;
+
+	return h;
+}
+
+static void symbol_key_init(symbol_key_t *key, const char *name)
+{
+	key->name = name;
+	key->gnu_hash = gnu_hash((const unsigned char *) name);
+	key->elf_hash_valid = false;
+}
+
+/** Look up a symbol using the module's DT_GNU_HASH table.
+ *
+ * The Bloom filter rejects most names the module does not define
+ * without touching the buckets. The chains only hold defined
+ * symbols and each entry carries the hash of its symbol (with
+ * the lowest bit marking the end of the chain), so names are
+ * only compared when the hashes match.
+ */
+static elf_symbol_t *gnu_hash_find(symbol_key_t *key, module_t *m)
+{
+	elf_word *table = m->dyn.gnu_hash;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_word nbucket = table[0];
+	elf_word symoffset = table[1];
+	elf_word bloom_size = table[2];
+	elf_word bloom_shift = table[3];
+	elf_gnu_bloom_t *bloom = (elf_gnu_bloom_t *) &table[4];
+	elf_word *buckets = (elf_word *) &bloom[bloom_size];
+	elf_word *chain = &buckets[nbucket];
+	const unsigned bits = sizeof(elf_gnu_bloom_t) * 8;
+	elf_word h = key->gnu_hash;
+	elf_gnu_bloom_t word, mask;
+	elf_word i, ch;
+	elf_symbol_t *s;
+
+	if (nbucket == 0 || bloom_size == 0)
+		return NULL;
+
+	word = bloom[(h / bits) & (bloom_size - 1)];
+	mask = ((elf_gnu_bloom_t) 1 << (h % bits)) |
+	    ((elf_gnu_bloom_t) 1 << ((h >> bloom_shift) % bits));
+	if ((word & mask) != mask)
+		return NULL;
+
+	i = buckets[h % nbucket];
+	if (i < symoffset)
+		return NULL;
+
+	while (true) {
+		ch = chain[i - symoffset];
+		if ((ch | 1) == (h | 1)) {
+			s = &sym_table[i];
+			if (str_cmp(key->name, m->dyn.str_tab + s->st_name) == 0)
+				return s;
+		}
+
+		if ((ch & 1) != 0)
+			break;
+		++i;
+	}
+
+	return NULL;
+}
+
+/** Look up a symbol using the module's SysV DT_HASH table. */
+static elf_symbol_t *elf_hash_find(symbol_key_t *key, module_t *m)
 {
 	elf_symbol_t *sym_table;
-	elf_symbol_t *s, *sym;
+	elf_symbol_t *s;
 	elf_word nbucket;
 	/*elf_word nchain;*/
 	elf_word i;
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
+	if (!key->elf_hash_valid) {
+		key->elf_hash = elf_hash((const unsigned char *) key->name);
+		key->elf_hash_valid = true;
+	}
 
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/*nchain = m->dyn.hash[1]; XXX Use to check HT range*/
 
-	bucket = elf_hash((unsigned char *)name) % nbucket;
+	bucket = key->elf_hash % nbucket;
 	i = m->dyn.hash[2 + bucket];
 
-	sym = NULL;
 	while (i != STN_UNDEF) {
 		s = &sym_table[i];
 		s_name = m->dyn.str_tab + s->st_name;
 
-		if (str_cmp(name, s_name) == 0) {
-			sym = s;
-			break;
-		}
+		if (str_cmp(key->name, s_name) == 0)
+			return s;
 
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(symbol_key_t *key, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", key->name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL)
+		sym = gnu_hash_find(key, m);
+	else if (m->dyn.hash != NULL)
+		sym = elf_hash_find(key, m);
+	else
+		sym = NULL;
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -105,6 +209,107 @@ static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
 	return sym; /* Found */
 }
 
+/** Find the cache slot for a lookup.
+ *
+ * @return Slot holding the lookup or the free slot where it should
+ *         be inserted, @c NULL if there is no cache.
+ */
+static rtld_sym_cache_entry_t *sym_cache_slot(rtld_sym_cache_entry_t *cache,
+    size_t size, symbol_key_t *key, bool noexec)
+{
+	size_t mask = size - 1;
+	size_t i;
+
+	if (cache == NULL)
+		return NULL;
+
+	i = key->gnu_hash & mask;
+	while (cache[i].name != NULL) {
+		if (cache[i].hash == key->gnu_hash && cache[i].noexec == noexec &&
+		    str_cmp(cache[i].name, key->name) == 0)
+			break;
+
+		i = (i + 1) & mask;
+	}
+
+	return &cache[i];
+}
+
+/** Double the size of the lookup cache (or create it). */
+static bool sym_cache_grow(rtld_t *rtld)
+{
+	rtld_sym_cache_entry_t *cache, *slot;
+	symbol_key_t key;
+	size_t size;
+	size_t i;
+
+	size = rtld->sym_cache_size != 0 ? 2 * rtld->sym_cache_size :
+	    SYM_CACHE_INIT_SIZE;
+
+	cache = calloc(size, sizeof(rtld_sym_cache_entry_t));
+	if (cache == NULL)
+		return false;
+
+	for (i = 0; i < rtld->sym_cache_size; ++i) {
+		if (rtld->sym_cache[i].name == NULL)
+			continue;
+
+		key.name = rtld->sym_cache[i].name;
+		key.gnu_hash = rtld->sym_cache[i].hash;
+		slot = sym_cache_slot(cache, size, &key,
+		    rtld->sym_cache[i].noexec);
+		*slot = rtld->sym_cache[i];
+	}
+
+	free(rtld->sym_cache);
+	rtld->sym_cache = cache;
+	rtld->sym_cache_size = size;
+	return true;
+}
+
+/** Remember the result of searching the global modules.
+ *
+ * The cache is only an optimization, so running out of memory
+ * just means the lookup is not remembered.
+ */
+static void sym_cache_insert(rtld_t *rtld, symbol_key_t *key, bool noexec,
+    elf_symbol_t *sym, module_t *mod)
+{
+	rtld_sym_cache_entry_t *slot;
+
+	/* Keep the load factor at most one half. */
+	if (2 * (rtld->sym_cache_count + 1) > rtld->sym_cache_size &&
+	    !sym_cache_grow(rtld))
+		return;
+
+	slot = sym_cache_slot(rtld->sym_cache, rtld->sym_cache_size, key,
+	    noexec);
+	if (slot->name == NULL)
+		++rtld->sym_cache_count;
+
+	slot->name = key->name;
+	slot->hash = key->gnu_hash;
+	slot->noexec = noexec;
+	slot->sym = sym;
+	slot->mod = mod;
+}
+
+/** Forget all cached symbol lookups.
+ *
+ * Must be called whenever a module exporting symbols to the global
+ * namespace is added, as the cached results might no longer be
+ * the first definitions in the search order.
+ *
+ * @param rtld Runtime linker
+ */
+void symbol_cache_clear(rtld_t *rtld)
+{
+	free(rtld->sym_cache);
+	rtld->sym_cache = NULL;
+	rtld->sym_cache_size = 0;
+	rtld->sym_cache_count = 0;
+}
+
 /** Find the definition of a symbol in a module and its deps.
  *
  * Search the module dependency graph is breadth-first, beginning
@@ -121,9 +326,12 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 {
 	module_t *m, *dm;
 	elf_symbol_t *sym, *s;
+	symbol_key_t key;
 	list_t queue;
 	size_t i;
 
+	symbol_key_init(&key, name);
+
 	/*
 	 * Do a BFS using the queue_link and bfs_tag fields.
 	 * Vertices (modules) are tagged the moment they are inserted
@@ -149,7 +357,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		list_remove(&m->queue_link);
 
 		/* If ssf_noroot is specified, do not look in start module */
-		s = def_find_in_module(name, m);
+		s = def_find_in_module(&key, m);
 		if (s != NULL) {
 			/* Symbol found */
 			sym = s;
@@ -182,16 +390,68 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 	return sym; /* Symbol found */
 }
 
+/** Find the definition of a symbol in the global modules.
+ *
+ * The result does not depend on the module making the reference,
+ * so unless @a cached is false it is looked up in (and stored to)
+ * the lookup cache.
+ */
+static elf_symbol_t *global_find(symbol_key_t *key, module_t *origin,
+    bool noexec, bool cached, module_t **mod)
+{
+	rtld_t *rtld = origin->rtld;
+	rtld_sym_cache_entry_t *slot;
+	elf_symbol_t *s;
+
+	slot = NULL;
+	if (cached) {
+		slot = sym_cache_slot(rtld->sym_cache, rtld->sym_cache_size,
+		    key, noexec);
+	}
+
+	if (slot != NULL && slot->name != NULL) {
+		++origin->n_cache_hits;
+		*mod = slot->mod;
+		return slot->sym;
+	}
+
+	list_foreach(rtld->modules, modules_link, module_t, m) {
+		DPRINTF("module '%s' local?\n", m->dyn.soname);
+		if (!m->local && (!m->exec || !noexec)) {
+			DPRINTF("!local->find '%s' in module '%s'\n", key->name, m->dyn.soname);
+			s = def_find_in_module(key, m);
+			if (s != NULL) {
+				/* Found */
+				if (cached)
+					sym_cache_insert(rtld, key, noexec, s, m);
+				*mod = m;
+				return s;
+			}
+		}
+	}
+
+	if (cached)
+		sym_cache_insert(rtld, key, noexec, NULL, NULL);
+	return NULL;
+}
+
 /** Find the definition of a symbol.
  *
  * By definition in System V ABI, if module origin has the flag DT_SYMBOLIC,
  * origin is searched first. Otherwise, search global modules in the default
  * order.
  *
+ * Results of searching the global modules are cached, so @a name
+ * must stay valid as long as the module that references it is loaded
+ * (names from the module's string table do). Lookups with @c ssf_nocache
+ * neither use nor modify the cache or the module's statistics, so they
+ * can run in several threads at once.
+ *
  * @param name		Name of the symbol to search for.
  * @param origin	Module in which the dependency originates.
- * @param flags		@c ssf_none or @c ssf_noexec to not look for the symbol
- *			in the executable program.
+ * @param flags		@c ssf_none or a combination of @c ssf_noexec to not
+ *			look for the symbol in the executable program and
+ *			@c ssf_nocache to bypass the lookup cache.
  * @param mod		(output) Will be filled with a pointer to the module
  *			that contains the symbol.
  */
@@ -199,16 +459,24 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
     symbol_search_flags_t flags, module_t **mod)
 {
 	elf_symbol_t *s;
+	symbol_key_t key;
+	bool noexec = (flags & ssf_noexec) != 0;
+	bool cached = (flags & ssf_nocache) == 0;
 
 	DPRINTF("symbol_def_find('%s', origin='%s'\n",
 	    name, origin->dyn.soname);
-	if (origin->dyn.symbolic && (!origin->exec || (flags & ssf_noexec) == 0)) {
+
+	symbol_key_init(&key, name);
+	if (cached)
+		++origin->n_lookups;
+
+	if (origin->dyn.symbolic && (!origin->exec || !noexec)) {
 		DPRINTF("symbolic->find '%s' in module '%s'\n", name, origin->dyn.soname);
 		/*
 		 * Origin module has a DT_SYMBOLIC flag.
 		 * Try this module first
 		 */
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -218,26 +486,17 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 
 	/* Not DT_SYMBOLIC or no match. Now try other locations. */
 
-	list_foreach(origin->rtld->modules, modules_link, module_t, m) {
-		DPRINTF("module '%s' local?\n", m->dyn.soname);
-		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
-			DPRINTF("!local->find '%s' in module '%s'\n", name, m->dyn.soname);
-			s = def_find_in_module(name, m);
-			if (s != NULL) {
-				/* Found */
-				*mod = m;
-				return s;
-			}
-		}
-	}
+	s = global_find(&key, origin, noexec, cached, mod);
+	if (s != NULL)
+		return s;
 
 	/* Finally, try origin. */
 
 	DPRINTF("try finding '%s' in origin '%s'\n", name,
 	    origin->dyn.soname);
 
-	if (!origin->exec || (flags & ssf_noexec) == 0) {
-		s = def_find_in_module(name, origin);
+	if (!origin->exec || !noexec) {
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -76,6 +76,9 @@ typedef struct {
 	ipc_call_t call;
 } _ipc_buffer_t;
 
+/** Maximum number of calls retrieved from the kernel by one IPC wait. */
+#define IPC_BATCH_SIZE  16
+
 typedef enum {
 	SWITCH_FROM_DEAD,
 	SWITCH_FROM_HELPER,
@@ -237,22 +240,85 @@ static fibril_t *_fibril_trigger_internal(fibril_event_t *event, fibril_t *reaso
 	return f;
 }
 
-static errno_t _ipc_wait(ipc_call_t *call, const struct timespec *expires)
+static errno_t _ipc_wait(ipc_call_t **calls, size_t count, size_t *received,
+    const struct timespec *expires)
 {
-	if (!expires)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NONE);
+	if (!expires) {
+		return ipc_wait_batch(calls, count, received, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NONE);
+	}
 
-	if (expires->tv_sec == 0)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (expires->tv_sec == 0) {
+		return ipc_wait_batch(calls, count, received, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING);
+	}
 
 	struct timespec now;
 	getuptime(&now);
 
-	if (ts_gteq(&now, expires))
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (ts_gteq(&now, expires)) {
+		return ipc_wait_batch(calls, count, received, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING);
+	}
+
+	return ipc_wait_batch(calls, count, received,
+	    NSEC2USEC(ts_sub_diff(expires, &now)), SYNCH_FLAGS_NONE);
+}
+
+static void _ready_list_push(fibril_t *f)
+{
+	if (!f)
+		return;
+
+	futex_assert_is_locked(&fibril_futex);
+
+	/* Enqueue in ready_list. */
+	list_append(&f->link, &ready_list);
+	_ready_up();
 
-	return ipc_wait(call, NSEC2USEC(ts_sub_diff(expires, &now)),
-	    SYNCH_FLAGS_NONE);
+	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
+		DPRINTF("Poking.\n");
+		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
+		ipc_poke();
+	}
+}
+
+/*
+ * Takes a free call buffer together with its token from ready_semaphore,
+ * so that an IPC wait can retrieve one more call. Must be called with
+ * ready_list empty and fibril_futex locked. Every token left on the
+ * semaphore then stands for a free buffer, and taking one leaves enough
+ * buffers for all threads that are already on their way to an IPC wait.
+ */
+static _ipc_buffer_t *_ipc_buffer_reserve(void)
+{
+	futex_assert_is_locked(&fibril_futex);
+	assert(list_empty(&ready_list));
+
+	if (multithreaded) {
+		if (!futex_trydown(&ready_semaphore))
+			return NULL;
+	} else {
+		if (ready_st_count <= 0)
+			return NULL;
+		ready_st_count--;
+	}
+
+	futex_lock(&ipc_lists_futex);
+	_ipc_buffer_t *buf = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
+	futex_unlock(&ipc_lists_futex);
+
+	assert(buf);
+	return buf;
+}
+
+/* Returns a reserved call buffer and its token. */
+static void _ipc_buffer_release(_ipc_buffer_t *buf)
+{
+	futex_lock(&ipc_lists_futex);
+	list_append(&buf->link, &ipc_buffer_free_list);
+	_ready_up();
+	futex_unlock(&ipc_lists_futex);
 }
 
 /*
@@ -282,24 +348,42 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 	 * for each entry of the call buffer.
 	 */
 
+	/*
+	 * Spare call buffers taken along let a single IPC wait retrieve
+	 * more calls when many are queued.
+	 */
+	_ipc_buffer_t *spare[IPC_BATCH_SIZE - 1];
+	size_t nspare = 0;
+
 	if (!locked)
 		futex_lock(&fibril_futex);
 	fibril_t *f = list_pop(&ready_list, fibril_t, link);
-	if (!f)
+	if (!f) {
 		atomic_fetch_add_explicit(&threads_in_ipc_wait, 1,
 		    memory_order_relaxed);
+
+		while (nspare < IPC_BATCH_SIZE - 1) {
+			spare[nspare] = _ipc_buffer_reserve();
+			if (!spare[nspare])
+				break;
+			nspare++;
+		}
+	}
 	if (!locked)
 		futex_unlock(&fibril_futex);
 
 	if (f)
 		return f;
 
-	if (!multithreaded)
-		assert(list_empty(&ipc_buffer_list));
-
 	/* No fibril is ready, IPC wait it is. */
 	ipc_call_t call = { 0 };
-	rc = _ipc_wait(&call, expires);
+	ipc_call_t *calls[IPC_BATCH_SIZE] = { &call };
+	size_t received = 1;
+
+	for (size_t i = 0; i < nspare; i++)
+		calls[i + 1] = &spare[i]->call;
+
+	rc = _ipc_wait(calls, nspare + 1, &received, expires);
 
 	atomic_fetch_sub_explicit(&threads_in_ipc_wait, 1,
 	    memory_order_relaxed);
@@ -307,9 +391,16 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 	if (rc != EOK && rc != ENOENT) {
 		/* Return token. */
 		_ready_up();
+
+		for (size_t i = 0; i < nspare; i++)
+			_ipc_buffer_release(spare[i]);
+
 		return NULL;
 	}
 
+	if (rc != EOK)
+		received = 1;
+
 	/*
 	 * We might get ENOENT due to a poke.
 	 * In that case, we propagate the null call out of fibril_ipc_wait(),
@@ -345,6 +436,35 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 		list_append(&buf->link, &ipc_buffer_list);
 	}
 
+	/*
+	 * The rest of the calls already sit in the spare buffers, which
+	 * hold their own tokens. A spare buffer handed over to a waiting
+	 * fibril is returned right away.
+	 */
+	for (size_t i = 1; i < received; i++) {
+		_ipc_buffer_t *buf = spare[i - 1];
+
+		w = list_pop(&ipc_waiter_list, _ipc_waiter_t, link);
+		if (w) {
+			*w->call = buf->call;
+			w->rc = EOK;
+			_ready_list_push(_fibril_trigger_internal(&w->event,
+			    _EVENT_TRIGGERED));
+
+			list_append(&buf->link, &ipc_buffer_free_list);
+			_ready_up();
+		} else {
+			buf->rc = EOK;
+			list_append(&buf->link, &ipc_buffer_list);
+		}
+	}
+
+	/* Return unused spare buffers. */
+	for (size_t i = received; i <= nspare; i++) {
+		list_append(&spare[i - 1]->link, &ipc_buffer_free_list);
+		_ready_up();
+	}
+
 	futex_unlock(&ipc_lists_futex);
 
 	if (!locked)
@@ -359,24 +479,6 @@ static fibril_t *_ready_list_pop_nonblocking(bool locked)
 	return _ready_list_pop(&tv, locked);
 }
 
-static void _ready_list_push(fibril_t *f)
-{
-	if (!f)
-		return;
-
-	futex_assert_is_locked(&fibril_futex);
-
-	/* Enqueue in ready_list. */
-	list_append(&f->link, &ready_list);
-	_ready_up();
-
-	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
-		DPRINTF("Poking.\n");
-		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
-		ipc_poke();
-	}
-}
-
 /* Blocks the current fibril until an IPC call arrives. */
 static errno_t _wait_ipc(ipc_call_t *call, const struct timespec *expires)
 {
@@ -830,6 +932,20 @@ void fibril_enable_multithreaded(void)
 	}
 }
 
+/**
+ * Check whether the task may run fibrils in more than one runner thread.
+ *
+ * Once true, this never becomes false again. While it is false, all
+ * fibrils of the task are serialized on a single thread, which allows
+ * e.g. reference counts to be updated without atomic operations.
+ *
+ * @return  True if additional runner threads have been spawned.
+ */
+bool fibril_is_multithreaded(void)
+{
+	return multithreaded;
+}
+
 /**
  * Detach a fibril.
  */
@@ -907,5 +1023,55 @@ errno_t fibril_ipc_wait(ipc_call_t *call, const struct timespec *expires)
 	return _wait_ipc(call, expires);
 }
 
+/** Wait for IPC calls and take all that are already retrieved.
+ *
+ * Blocks like fibril_ipc_wait() until the first call arrives. Then takes
+ * up to count - 1 more calls which were retrieved from the kernel by the
+ * same batched IPC wait, without blocking.
+ *
+ * @param calls         Array of calls to fill.
+ * @param count         Number of elements of calls.
+ * @param[out] received Number of calls stored in calls.
+ * @param expires       Timeout for the first call.
+ *
+ * @return Error code of the wait for the first call.
+ */
+errno_t fibril_ipc_wait_batch(ipc_call_t *calls, size_t count,
+    size_t *received, const struct timespec *expires)
+{
+	assert(count > 0);
+
+	*received = 0;
+
+	errno_t rc = _wait_ipc(&calls[0], expires);
+	if (rc != EOK)
+		return rc;
+
+	*received = 1;
+
+	futex_lock(&ipc_lists_futex);
+
+	while (*received < count) {
+		link_t *link = list_first(&ipc_buffer_list);
+		if (!link)
+			break;
+
+		_ipc_buffer_t *buf = list_get_instance(link, _ipc_buffer_t, link);
+		if (buf->rc != EOK)
+			break;
+
+		list_remove(&buf->link);
+		calls[(*received)++] = buf->call;
+
+		/* Return to freelist. */
+		list_append(&buf->link, &ipc_buffer_free_list);
+		/* Return IPC wait token. */
+		_ready_up();
+	}
+
+	futex_unlock(&ipc_lists_futex);
+	return EOK;
+}
+
 /** @}
  */
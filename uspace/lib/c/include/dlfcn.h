@@ -36,6 +36,9 @@
 #ifndef LIBC_DLFCN_H_
 #define LIBC_DLFCN_H_
 
+#define RTLD_LAZY 1
+#define RTLD_NOW 2
+
 void *dlopen(const char *, int);
 void *dlsym(void *, const char *);
 
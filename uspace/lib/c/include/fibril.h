@@ -35,6 +35,7 @@
 #ifndef LIBC_FIBRIL_H_
 #define LIBC_FIBRIL_H_
 
+#include <stdbool.h>
 #include <types/common.h>
 #include <time.h>
 #include <_bits/__noreturn.h>
@@ -64,6 +65,7 @@ extern void fibril_sleep(sec_t);
 
 extern void fibril_enable_multithreaded(void);
 extern int fibril_test_spawn_runners(int);
+extern bool fibril_is_multithreaded(void);
 
 extern void fibril_detach(fid_t fid);
 
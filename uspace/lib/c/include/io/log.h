@@ -35,6 +35,7 @@
 #define LIBC_IO_LOG_H_
 
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <inttypes.h>
 #include <io/verify.h>
 #include <types/common.h>
@@ -62,6 +63,40 @@ extern void log_msg(log_t, log_level_t, const char *, ...)
     _HELENOS_PRINTF_ATTRIBUTE(3, 4);
 extern void log_msgv(log_t, log_level_t, const char *, va_list);
 
+/** Maximum number of arguments of a message logged by log_msg_bin(). */
+#define LOG_FMT_MAX_ARGS 16
+
+/** Format id of a call site whose messages are sent as text. */
+#define LOG_FMT_TEXT ((unsigned int) -1)
+
+/** Call site of log_msg_bin(). */
+typedef struct {
+	/** Format id at the logger, zero until registered */
+	atomic_uint id;
+	/** Number of arguments */
+	uint8_t nargs;
+	/** How the arguments are stored (log_arg_t) */
+	uint8_t args[LOG_FMT_MAX_ARGS];
+	/** Precisions of string arguments given in the format */
+	uint16_t precs[LOG_FMT_MAX_ARGS];
+} log_fmt_site_t;
+
+extern void log_msg_site(log_fmt_site_t *, log_t, log_level_t,
+    const char *, ...) _HELENOS_PRINTF_ATTRIBUTE(4, 5);
+
+/** Write an entry to the log, formatting it later in the logger.
+ *
+ * Same as log_msg(), but the format must be a string literal. It is
+ * registered with the logger on first use, then only the arguments are
+ * recorded, which makes this suitable for high-frequency tracing.
+ */
+#define log_msg_bin(ctx, level, fmt, ...) \
+	do { \
+		static log_fmt_site_t __log_fmt_site; \
+		log_msg_site(&__log_fmt_site, (ctx), (level), "" fmt, \
+		    ##__VA_ARGS__); \
+	} while (0)
+
 #endif
 
 /** @}
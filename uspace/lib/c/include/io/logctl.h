@@ -38,6 +38,7 @@
 extern errno_t logctl_set_default_level(log_level_t);
 extern errno_t logctl_set_log_level(const char *, log_level_t);
 extern errno_t logctl_set_root(void);
+extern errno_t logctl_flush(void);
 
 #endif
 
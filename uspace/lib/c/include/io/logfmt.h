@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Binary log records.
+ *
+ * Messages logged with log_msg_bin() carry the raw arguments instead of
+ * the formatted text. The format string is known to the logger in advance
+ * and the message is formatted only when (and if) it is written out.
+ */
+
+#ifndef LIBC_IO_LOGFMT_H_
+#define LIBC_IO_LOGFMT_H_
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <io/log.h>
+
+/** How an argument of a binary record is passed and stored. */
+typedef enum {
+	/** int (also char, short and '*' width or precision) */
+	LOG_ARG_INT,
+	/** long */
+	LOG_ARG_LONG,
+	/** long long */
+	LOG_ARG_LLONG,
+	/** void * */
+	LOG_ARG_PTR,
+	/** size_t */
+	LOG_ARG_SIZE,
+	/** uintmax_t */
+	LOG_ARG_MAX,
+	/** double */
+	LOG_ARG_DOUBLE,
+	/** char *, stored as uint16_t length and the characters */
+	LOG_ARG_STR,
+	/** int precision passed by '*', limits the length of a string */
+	LOG_ARG_PREC
+} log_arg_t;
+
+/** Longest string argument stored in a binary record (in bytes). */
+#define LOG_ARG_STR_MAX 1024
+
+extern errno_t log_fmt_parse(const char *, uint8_t *, uint16_t *, size_t *);
+extern size_t log_fmt_pack(void *, size_t, const uint8_t *, const uint16_t *,
+    size_t, va_list);
+extern errno_t log_fmt_format(char *, size_t, const char *, const void *,
+    size_t);
+
+#endif
+
+/** @}
+ */
@@ -46,6 +46,8 @@
 #include <abi/cap.h>
 
 extern errno_t ipc_wait(ipc_call_t *, sysarg_t, unsigned int);
+extern errno_t ipc_wait_batch(ipc_call_t **, size_t, size_t *, sysarg_t,
+    unsigned int);
 extern void ipc_poke(void);
 
 /*
@@ -34,6 +34,8 @@
 #define LIBC_IPC_LOGGER_H_
 
 #include <ipc/common.h>
+#include <stdatomic.h>
+#include <stdint.h>
 
 typedef enum {
 	/** Set (global) default displayed logging level.
@@ -54,14 +56,20 @@ typedef enum {
 	 * Returns: error code
 	 * Followed by: vfs_pass_handle() request.
 	 */
-	LOGGER_CONTROL_SET_ROOT
+	LOGGER_CONTROL_SET_ROOT,
+	/** Write buffered messages out to the log files.
+	 *
+	 * Returns: error code
+	 */
+	LOGGER_CONTROL_FLUSH
 } logger_control_request_t;
 
 typedef enum {
 	/** Create new log.
 	 *
 	 * Arguments: parent log id (0 for top-level log).
-	 * Returns: error code, log id
+	 * Returns: error code, log id, index of the log's entry in
+	 *     logger_ring_t.levels
 	 * Followed by: string with log name.
 	 */
 	LOGGER_WRITER_CREATE_LOG = IPC_FIRST_USER_METHOD,
@@ -71,9 +79,74 @@ typedef enum {
 	 * Returns: error code
 	 * Followed by: string with the message.
 	 */
-	LOGGER_WRITER_MESSAGE
+	LOGGER_WRITER_MESSAGE,
+	/** Set up a message ring shared with the logger.
+	 *
+	 * Returns: error code
+	 * Followed by: async_share_out_start() of a logger_ring_t.
+	 */
+	LOGGER_WRITER_SHARE_RING,
+	/** Tell a waiting logger that there are new messages in the ring.
+	 *
+	 * Sent with async_msg_0(), the answer is ignored.
+	 */
+	LOGGER_WRITER_RING_NOTIFY,
+	/** Register format string of binary records.
+	 *
+	 * Returns: error code, format id (for logger_ring_rec_t.format)
+	 * Followed by: string with the format.
+	 */
+	LOGGER_WRITER_REGISTER_FORMAT
 } logger_writer_request_t;
 
+/** Size of the message area of logger_ring_t (a power of two) */
+#define LOGGER_RING_DATA_SIZE 65536
+
+/** Alignment (and size granularity) of ring records */
+#define LOGGER_RING_ALIGN 16
+
+/** Maximum number of logs whose levels are published to a client */
+#define LOGGER_RING_MAX_LOGS 100
+
+/** Message record in logger_ring_t.
+ *
+ * Records never wrap around the end of the ring. A record whose log
+ * is zero only fills the rest of the ring and carries no message.
+ */
+typedef struct {
+	/** Size including this header, multiple of LOGGER_RING_ALIGN */
+	uint32_t size;
+	/** Message severity level (log_level_t) */
+	uint32_t level;
+	/** Format id or zero for a text record */
+	uint32_t format;
+	/** Log id */
+	sysarg_t log;
+	/**
+	 * NUL-terminated message or, if @c format is not zero, arguments
+	 * stored by log_fmt_pack() follow
+	 */
+} logger_ring_rec_t;
+
+/** Message ring shared by a logger client with the logger.
+ *
+ * The client appends records and advances @c head, the logger
+ * consumes them and advances @c tail. Both are free-running byte
+ * counters, records start at offset (counter % LOGGER_RING_DATA_SIZE).
+ */
+typedef struct {
+	/** Total size of records written by the client */
+	atomic_uint head;
+	/** Total size of records consumed by the logger */
+	atomic_uint tail;
+	/** Nonzero if the logger waits for LOGGER_WRITER_RING_NOTIFY */
+	atomic_int waiting;
+	/** Most verbose level the logger writes out, for each client log */
+	atomic_uchar levels[LOGGER_RING_MAX_LOGS];
+	/** Records */
+	uint8_t data[LOGGER_RING_DATA_SIZE] __attribute__((aligned(LOGGER_RING_ALIGN)));
+} logger_ring_t;
+
 #endif
 
 /** @}
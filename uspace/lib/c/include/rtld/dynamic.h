@@ -68,6 +68,8 @@ typedef struct dyn_info {
 
 	/** Hash table */
 	elf_word *hash;
+	/** GNU hash table or @c NULL if the module has none */
+	elf_word *gnu_hash;
 
 	/** String table */
 	char *str_tab;
@@ -64,6 +64,9 @@ struct elf32_rela {
 typedef struct elf32_dyn elf_dyn_t;
 typedef struct elf32_rel elf_rel_t;
 typedef struct elf32_rela elf_rela_t;
+
+/** Word of the DT_GNU_HASH Bloom filter (ELF class sized) */
+typedef elf32_addr elf_gnu_bloom_t;
 #endif
 
 /*
@@ -94,9 +97,24 @@ typedef struct elf32_rela elf_rela_t;
 #define DT_TEXTREL	22
 #define DT_JMPREL	23
 #define DT_BIND_NOW	24
+#define DT_FLAGS	30
+#define DT_GNU_HASH	0x6ffffef5
+#define DT_FLAGS_1	0x6ffffffb
 #define DT_LOPROC	0x70000000
 #define DT_HIPROC	0x7fffffff
 
+/*
+ * DT_FLAGS values
+ */
+#define DF_SYMBOLIC	0x2
+#define DF_TEXTREL	0x4
+#define DF_BIND_NOW	0x8
+
+/*
+ * DT_FLAGS_1 values
+ */
+#define DF_1_NOW	0x1
+
 /*
  * Special section indexes
  */
@@ -35,6 +35,7 @@
 #ifndef LIBC_RTLD_RTLD_ARCH_H_
 #define LIBC_RTLD_RTLD_ARCH_H_
 
+#include <stdbool.h>
 #include <rtld/rtld.h>
 #include <loader/pcb.h>
 
@@ -45,6 +46,13 @@ void rela_table_process(module_t *m, elf_rela_t *rt, size_t rt_size);
 
 void program_run(void *entry, pcb_t *pcb);
 
+/** Name of the lazy binding entry point, if the architecture has one */
+#define PLT_TRAMPOLINE_NAME "plt_trampoline_arch"
+
+bool plt_lazy_setup_arch(module_t *m);
+void *plt_resolve_arch(module_t *m, size_t rel_off)
+    __attribute__((visibility("hidden")));
+
 #endif
 
 /** @}
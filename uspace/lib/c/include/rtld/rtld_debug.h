@@ -40,6 +40,15 @@
 /* Define to enable debugging mode. */
 #undef RTLD_DEBUG
 
+/*
+ * Define to print per-module relocation and symbol lookup statistics
+ * once a dynamically linked program has been relocated.
+ */
+#undef RTLD_STATS
+
+/* Define to resolve all PLT entries at load time (as with LD_BIND_NOW). */
+#undef RTLD_BIND_NOW
+
 #ifdef RTLD_DEBUG
 #define DPRINTF(format, ...) printf(format, ##__VA_ARGS__)
 #else
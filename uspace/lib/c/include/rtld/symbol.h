@@ -44,13 +44,16 @@ typedef enum {
 	/** No flags */
 	ssf_none = 0,
 	/** Do not search in the executable */
-	ssf_noexec = 0x1
+	ssf_noexec = 0x1,
+	/** Do not use the lookup cache (lookup can run concurrently) */
+	ssf_nocache = 0x2
 } symbol_search_flags_t;
 
 extern elf_symbol_t *symbol_bfs_find(const char *, module_t *, module_t **);
 extern elf_symbol_t *symbol_def_find(const char *, module_t *,
     symbol_search_flags_t, module_t **);
 extern void *symbol_get_addr(elf_symbol_t *, module_t *, tcb_t *);
+extern void symbol_cache_clear(rtld_t *);
 
 #endif
 
@@ -37,6 +37,7 @@
 
 #include <adt/list.h>
 #include <stddef.h>
+#include <time.h>
 
 typedef enum {
 	/** Do not export symbols to global namespace */
@@ -87,6 +88,17 @@ typedef struct module {
 	bool local;
 	/** This is the dynamically linked executable */
 	bool exec;
+
+	/** Number of relocations processed in this module */
+	size_t n_relocs;
+	/** Number of PLT relocations deferred until the first call */
+	size_t n_lazy;
+	/** Number of symbol lookups made on behalf of this module */
+	size_t n_lookups;
+	/** Number of those lookups answered from the lookup cache */
+	size_t n_cache_hits;
+	/** Time spent processing relocations (only with RTLD_STATS) */
+	nsec_t reloc_time;
 } module_t;
 
 #endif
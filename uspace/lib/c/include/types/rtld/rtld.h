@@ -37,11 +37,30 @@
 
 #include <adt/list.h>
 #include <elf/elf_mod.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include <types/rtld/module.h>
 
+/** Symbol lookup cache entry
+ *
+ * Caches the result of searching the global modules for a symbol,
+ * which does not depend on the module the reference comes from.
+ */
+typedef struct {
+	/** Symbol name or @c NULL if the slot is free */
+	const char *name;
+	/** GNU hash of the name */
+	uint32_t hash;
+	/** Lookup was done with @c ssf_noexec */
+	bool noexec;
+	/** Definition or @c NULL if no global module defines the symbol */
+	elf_symbol_t *sym;
+	/** Module containing the definition */
+	module_t *mod;
+} rtld_sym_cache_entry_t;
+
 typedef struct rtld {
 	elf_dyn_t *rtld_dynamic;
 	module_t rtld;
@@ -60,6 +79,20 @@ typedef struct rtld {
 
 	/** List of initial modules */
 	list_t imodules;
+
+	/** Symbol lookup cache (open addressing, size is a power of two) */
+	rtld_sym_cache_entry_t *sym_cache;
+	/** Number of slots in the symbol lookup cache */
+	size_t sym_cache_size;
+	/** Number of used slots in the symbol lookup cache */
+	size_t sym_cache_count;
+
+	/** Resolve all PLT entries at load time rather than on first call */
+	bool bind_now;
+	/** Lazy binding entry point or @c NULL if not available */
+	void *plt_trampoline;
+	/** Module defining the lazy binding entry point */
+	module_t *plt_trampoline_mod;
 } rtld_t;
 
 #endif
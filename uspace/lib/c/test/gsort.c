@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcut/pcut.h>
+#include <gsort.h>
+#include <stdlib.h>
+
+enum {
+	/** Length of test sequences */
+	test_seq_len = 500,
+	/** Number of distinct keys in test sequences */
+	test_keys = 7
+};
+
+typedef struct {
+	int key;
+	int idx;
+} test_elem_t;
+
+/** Test compare function.
+ *
+ * @param a First element
+ * @param b Second element
+ * @param arg Unused
+ * @return <0, 0, >0 if key of @a a is less than, equal or greater than
+ *         key of @a b
+ */
+static int test_cmp(void *a, void *b, void *arg)
+{
+	test_elem_t *ea = (test_elem_t *)a;
+	test_elem_t *eb = (test_elem_t *)b;
+
+	(void)arg;
+	return ea->key - eb->key;
+}
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(gsort);
+
+/** Test that elements with equal keys keep their relative order. */
+PCUT_TEST(stable)
+{
+	test_elem_t *seq;
+	bool rc;
+	int i;
+	int v;
+
+	seq = calloc(test_seq_len, sizeof(test_elem_t));
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	v = 1;
+	for (i = 0; i < test_seq_len; i++) {
+		seq[i].key = v % test_keys;
+		seq[i].idx = i;
+		v = (v * 1951) % 1000000;
+	}
+
+	rc = gsort(seq, test_seq_len, sizeof(test_elem_t), test_cmp, NULL);
+	PCUT_ASSERT_TRUE(rc);
+
+	for (i = 1; i < test_seq_len; i++) {
+		PCUT_ASSERT_TRUE(seq[i - 1].key <= seq[i].key);
+		if (seq[i - 1].key == seq[i].key)
+			PCUT_ASSERT_TRUE(seq[i - 1].idx < seq[i].idx);
+	}
+
+	free(seq);
+}
+
+PCUT_EXPORT(gsort);
@@ -33,7 +33,9 @@
 
 enum {
 	/** Length of test number sequences */
-	test_seq_len = 5
+	test_seq_len = 5,
+	/** Length of long test number sequences */
+	test_long_seq_len = 1000
 };
 
 /** Test compare function.
@@ -171,4 +173,58 @@ PCUT_TEST(pseudorandom_seq)
 	free(seq2);
 }
 
+/** Test sorting long sequences that exercise partitioning. */
+PCUT_TEST(long_seq)
+{
+	int *seq, *seq2;
+	int i;
+	int v;
+	int pattern;
+
+	seq = calloc(test_long_seq_len, sizeof(int));
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	seq2 = calloc(test_long_seq_len, sizeof(int));
+	PCUT_ASSERT_NOT_NULL(seq2);
+
+	for (pattern = 0; pattern < 4; pattern++) {
+		v = 1;
+		for (i = 0; i < test_long_seq_len; i++) {
+			switch (pattern) {
+			case 0:
+				/* Pseudorandom */
+				seq[i] = v;
+				v = seq_next(v);
+				break;
+			case 1:
+				/* Organ pipe */
+				seq[i] = i < test_long_seq_len / 2 ? i :
+				    test_long_seq_len - i;
+				break;
+			case 2:
+				/* Few distinct values */
+				seq[i] = v % 3;
+				v = seq_next(v);
+				break;
+			default:
+				/* Decreasing */
+				seq[i] = test_long_seq_len - i;
+				break;
+			}
+
+			seq2[i] = seq[i];
+		}
+
+		qsort(seq, test_long_seq_len, sizeof(int), test_cmp);
+		bubble_sort(seq2, test_long_seq_len);
+
+		for (i = 0; i < test_long_seq_len; i++) {
+			PCUT_ASSERT_INT_EQUALS(seq2[i], seq[i]);
+		}
+	}
+
+	free(seq);
+	free(seq2);
+}
+
 PCUT_EXPORT(qsort);
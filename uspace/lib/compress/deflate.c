@@ -0,0 +1,1322 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Implementation of deflate compression
+ *
+ * A deflate compressor (producing a `deflate' stream as described by
+ * RFC 1951). Repeated strings are found by hash chains over a 32 KiB
+ * sliding window. Higher levels search longer chains and defer matches
+ * when a longer one starts at the next byte (lazy matching). Each block
+ * is output as stored, fixed or dynamic Huffman codes, whichever is the
+ * shortest.
+ *
+ */
+
+#include <assert.h>
+#include <bitops.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "deflate.h"
+
+/** Maximum bits in the Huffman code */
+#define MAX_HUFFMAN_BIT  15
+/** Maximum bits in the code length code */
+#define MAX_ORDER_BIT    7
+
+/** Number of length codes */
+#define MAX_LEN     29
+/** Number of distance codes */
+#define MAX_DIST    30
+/** Number of order codes */
+#define MAX_ORDER   19
+/** Number of literal/length codes */
+#define MAX_LITLEN  286
+/** Number of fixed literal/length codes */
+#define MAX_FIXED_LITLEN  288
+
+/** End of block symbol */
+#define END_BLOCK  256
+
+/** Size of the sliding window */
+#define WINDOW_SIZE  32768
+#define WINDOW_MASK  (WINDOW_SIZE - 1)
+
+#define MIN_MATCH  3
+#define MAX_MATCH  258
+
+/** Input needed ahead of the current position to find the longest match */
+#define MIN_LOOKAHEAD  (MAX_MATCH + MIN_MATCH + 1)
+
+/** Farthest match, so that the lookahead stays in the window */
+#define MAX_DISTANCE  (WINDOW_SIZE - MIN_LOOKAHEAD)
+
+/** Shortest matches farther than this are not worth it */
+#define TOO_FAR  4096
+
+#define HASH_BITS  15
+#define HASH_SIZE  (1 << HASH_BITS)
+
+/** Empty hash chain (position zero is never matched) */
+#define NIL  0
+
+/** Number of symbols collected before a block is output */
+#define SYM_BUF_SIZE  16384
+
+/** Largest block (the whole window) with all headers fits the buffer */
+#define PENDING_SIZE  (2 * WINDOW_SIZE + 64)
+
+/** Compression level parameters
+ *
+ */
+typedef struct {
+	/** Search only a quarter of the chain above this match length */
+	uint16_t good_length;
+	/** Do not look for a lazy match above this match length */
+	uint16_t max_lazy;
+	/** Stop searching at this match length */
+	uint16_t nice_length;
+	/** Longest hash chain searched */
+	uint16_t max_chain;
+	/** Look for lazy matches */
+	bool lazy;
+} deflate_config_t;
+
+/** Parameters of the levels (same as in zlib)
+ *
+ * Without lazy matching, max_lazy limits the length of matches whose
+ * strings are inserted in the hash table.
+ *
+ */
+static const deflate_config_t configs[DEFLATE_LEVEL_BEST + 1] = {
+	{ 0, 0, 0, 0, false },
+	{ 4, 4, 8, 4, false },
+	{ 4, 5, 16, 8, false },
+	{ 4, 6, 32, 32, false },
+	{ 4, 4, 16, 16, true },
+	{ 8, 16, 32, 32, true },
+	{ 8, 16, 128, 128, true },
+	{ 8, 32, 128, 256, true },
+	{ 32, 128, 258, 1024, true },
+	{ 32, 258, 258, 4096, true }
+};
+
+/** Length codes
+ *
+ */
+static const uint16_t lens[MAX_LEN] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+/** Extended length codes
+ *
+ */
+static const uint8_t lens_ext[MAX_LEN] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/** Distance codes
+ *
+ */
+static const uint16_t dists[MAX_DIST] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+/** Extended distance codes
+ *
+ */
+static const uint8_t dists_ext[MAX_DIST] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+	12, 12, 13, 13
+};
+
+/** Order codes
+ *
+ */
+static const uint8_t order[MAX_ORDER] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/** Huffman code for output
+ *
+ */
+typedef struct {
+	uint16_t code[MAX_FIXED_LITLEN];   /**< Codes (bit reversed) */
+	uint8_t length[MAX_FIXED_LITLEN];  /**< Code lengths */
+} huffman_code_t;
+
+/** Deflate stream state
+ *
+ */
+struct deflate_stream {
+	const deflate_config_t *config;  /**< Level parameters */
+	unsigned int level;              /**< Compression level */
+
+	const uint8_t *src;  /**< Input buffer */
+	size_t srclen;       /**< Input buffer size */
+	size_t srccnt;       /**< Position in the input buffer */
+
+	/** Two windows, the input is matched against the first one */
+	uint8_t window[2 * WINDOW_SIZE];
+	size_t strstart;     /**< Current position in the window */
+	size_t lookahead;    /**< Bytes of input after the current position */
+	size_t block_start;  /**< Start of the current block in the window */
+	size_t block_end;    /**< End of the input covered by the symbols */
+
+	uint16_t head[HASH_SIZE];    /**< Last position of each hash */
+	uint16_t prev[WINDOW_SIZE];  /**< Previous position with same hash */
+
+	size_t match_length;    /**< Length of the match at strstart */
+	size_t match_start;     /**< Start of the match at strstart */
+	size_t prev_length;     /**< Length of the match at strstart - 1 */
+	size_t prev_match;      /**< Start of the match at strstart - 1 */
+	bool match_available;   /**< Byte at strstart - 1 not output yet */
+
+	uint16_t sym_lit[SYM_BUF_SIZE];   /**< Literals or match lengths */
+	uint16_t sym_dist[SYM_BUF_SIZE];  /**< Match distances (0 for literal) */
+	size_t sym_count;                 /**< Number of symbols */
+	uint16_t lit_freq[MAX_LITLEN];    /**< Literal/length frequencies */
+	uint16_t dist_freq[MAX_DIST];     /**< Distance frequencies */
+
+	/** Length codes of match lengths (minus MIN_MATCH) */
+	uint8_t len_symbol[MAX_MATCH - MIN_MATCH + 1];
+
+	uint8_t pending[PENDING_SIZE];  /**< Output not yet returned */
+	size_t pending_out;             /**< Position of the pending output */
+	size_t pending_len;             /**< Size of the pending output */
+	uint64_t bitbuf;                /**< Bit buffer */
+	unsigned int bitlen;            /**< Number of bits in the bit buffer */
+
+	bool flushed;   /**< Flushed with no input since */
+	bool finished;  /**< Last block output */
+};
+
+/** Put bits to the output
+ *
+ * @param stream Deflate stream.
+ * @param value  Bits to put.
+ * @param cnt    Number of bits (at most 16).
+ *
+ */
+static inline void put_bits(deflate_stream_t *stream, uint32_t value,
+    unsigned int cnt)
+{
+	stream->bitbuf |= ((uint64_t) value) << stream->bitlen;
+	stream->bitlen += cnt;
+
+	while (stream->bitlen >= 8) {
+		stream->pending[stream->pending_len] = (uint8_t) stream->bitbuf;
+		stream->pending_len++;
+		stream->bitbuf >>= 8;
+		stream->bitlen -= 8;
+	}
+}
+
+/** Pad the output to a byte boundary
+ *
+ * @param stream Deflate stream.
+ *
+ */
+static void put_align(deflate_stream_t *stream)
+{
+	if (stream->bitlen > 0)
+		put_bits(stream, 0, 8 - stream->bitlen);
+}
+
+/** Get distance code of a match distance
+ *
+ * @param dist Match distance minus one.
+ *
+ * @return Distance code.
+ *
+ */
+static inline unsigned int distance_symbol(unsigned int dist)
+{
+	if (dist < 4)
+		return dist;
+
+	unsigned int bits = fnzb32(dist);
+	return 2 * bits + ((dist >> (bits - 1)) & 1);
+}
+
+/** Compute lengths of a Huffman code
+ *
+ * The code is built by the two queue method from symbols sorted by
+ * frequency. If it is deeper than allowed, the frequencies are halved
+ * (keeping the used symbols used) and the code is built again.
+ *
+ * @param freq   Symbol frequencies.
+ * @param n      Number of symbols.
+ * @param limit  Maximum code length.
+ * @param length Computed code lengths.
+ *
+ */
+static void huffman_lengths(const uint16_t *freq, size_t n,
+    unsigned int limit, uint8_t *length)
+{
+	uint32_t weight[2 * MAX_LITLEN];
+	uint16_t sorted[MAX_LITLEN];
+	uint16_t child[MAX_LITLEN][2];
+	size_t used = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		length[i] = 0;
+		weight[i] = freq[i];
+		if (freq[i] != 0)
+			sorted[used++] = i;
+	}
+
+	if (used == 0)
+		return;
+
+	if (used == 1) {
+		length[sorted[0]] = 1;
+		return;
+	}
+
+	while (true) {
+		/* Sort the used symbols by weight (insertion sort) */
+		for (size_t i = 1; i < used; i++) {
+			uint16_t symbol = sorted[i];
+			size_t j = i;
+			while ((j > 0) && (weight[sorted[j - 1]] > weight[symbol])) {
+				sorted[j] = sorted[j - 1];
+				j--;
+			}
+
+			sorted[j] = symbol;
+		}
+
+		/*
+		 * Merge the two lightest nodes repeatedly. Internal nodes are
+		 * created with non-decreasing weights, so they form the second
+		 * queue in their order of creation.
+		 */
+		size_t leaf = 0;
+		size_t node = n;
+		size_t nodes = n;
+
+		for (size_t i = 0; i < used - 1; i++) {
+			uint16_t pick[2];
+			for (size_t k = 0; k < 2; k++) {
+				if ((leaf < used) && ((node == nodes) ||
+				    (weight[sorted[leaf]] <= weight[node]))) {
+					pick[k] = sorted[leaf];
+					leaf++;
+				} else {
+					pick[k] = node;
+					node++;
+				}
+			}
+
+			weight[nodes] = weight[pick[0]] + weight[pick[1]];
+			child[nodes - n][0] = pick[0];
+			child[nodes - n][1] = pick[1];
+			nodes++;
+		}
+
+		/* Depths of the nodes, the root is the last one created */
+		uint8_t depth[2 * MAX_LITLEN];
+		depth[nodes - 1] = 0;
+		unsigned int max = 0;
+
+		for (size_t i = nodes - 1; i >= n; i--) {
+			for (size_t k = 0; k < 2; k++) {
+				uint16_t c = child[i - n][k];
+				depth[c] = depth[i] + 1;
+				if ((c < n) && (depth[c] > max))
+					max = depth[c];
+			}
+		}
+
+		if (max <= limit) {
+			for (size_t i = 0; i < used; i++)
+				length[sorted[i]] = depth[sorted[i]];
+
+			return;
+		}
+
+		for (size_t i = 0; i < used; i++) {
+			uint16_t symbol = sorted[i];
+			weight[symbol] = (weight[symbol] + 1) / 2;
+		}
+	}
+}
+
+/** Assign canonical codes to code lengths
+ *
+ * @param code Huffman code with lengths set.
+ * @param n    Number of symbols.
+ *
+ */
+static void huffman_codes(huffman_code_t *code, size_t n)
+{
+	uint16_t count[MAX_HUFFMAN_BIT + 1] = { 0 };
+	uint16_t next[MAX_HUFFMAN_BIT + 1];
+
+	for (size_t i = 0; i < n; i++)
+		count[code->length[i]]++;
+
+	count[0] = 0;
+	next[0] = 0;
+	for (size_t len = 1; len <= MAX_HUFFMAN_BIT; len++)
+		next[len] = (next[len - 1] + count[len - 1]) << 1;
+
+	for (size_t i = 0; i < n; i++) {
+		unsigned int len = code->length[i];
+		if (len == 0)
+			continue;
+
+		/* Codes are output starting by the most significant bit */
+		uint16_t value = next[len]++;
+		uint16_t rev = 0;
+		for (unsigned int bit = 0; bit < len; bit++)
+			rev |= ((value >> bit) & 1) << (len - 1 - bit);
+
+		code->code[i] = rev;
+	}
+}
+
+/** Set up the fixed Huffman codes
+ *
+ * @param len_code  Literal/length code.
+ * @param dist_code Distance code.
+ *
+ */
+static void huffman_fixed(huffman_code_t *len_code, huffman_code_t *dist_code)
+{
+	for (size_t i = 0; i < MAX_FIXED_LITLEN; i++) {
+		if (i < 144)
+			len_code->length[i] = 8;
+		else if (i < 256)
+			len_code->length[i] = 9;
+		else if (i < 280)
+			len_code->length[i] = 7;
+		else
+			len_code->length[i] = 8;
+	}
+
+	for (size_t i = 0; i < MAX_DIST; i++)
+		dist_code->length[i] = 5;
+
+	huffman_codes(len_code, MAX_FIXED_LITLEN);
+	huffman_codes(dist_code, MAX_DIST);
+}
+
+/** Compute size of the block data encoded by given codes
+ *
+ * @param stream    Deflate stream.
+ * @param len_code  Literal/length code.
+ * @param dist_code Distance code.
+ *
+ * @return Size in bits (without the block header and code tables).
+ *
+ */
+static size_t block_data_bits(deflate_stream_t *stream,
+    huffman_code_t *len_code, huffman_code_t *dist_code)
+{
+	size_t bits = 0;
+
+	for (size_t i = 0; i < MAX_LITLEN; i++) {
+		bits += (size_t) stream->lit_freq[i] * len_code->length[i];
+		if (i > END_BLOCK)
+			bits += (size_t) stream->lit_freq[i] * lens_ext[i - END_BLOCK - 1];
+	}
+
+	for (size_t i = 0; i < MAX_DIST; i++) {
+		bits += (size_t) stream->dist_freq[i] *
+		    (dist_code->length[i] + dists_ext[i]);
+	}
+
+	return bits;
+}
+
+/** Output the collected symbols
+ *
+ * @param stream    Deflate stream.
+ * @param len_code  Literal/length code.
+ * @param dist_code Distance code.
+ *
+ */
+static void block_put_data(deflate_stream_t *stream,
+    huffman_code_t *len_code, huffman_code_t *dist_code)
+{
+	for (size_t i = 0; i < stream->sym_count; i++) {
+		unsigned int lit = stream->sym_lit[i];
+		unsigned int dist = stream->sym_dist[i];
+
+		if (dist == 0) {
+			put_bits(stream, len_code->code[lit], len_code->length[lit]);
+			continue;
+		}
+
+		unsigned int code = stream->len_symbol[lit];
+		put_bits(stream, len_code->code[END_BLOCK + 1 + code],
+		    len_code->length[END_BLOCK + 1 + code]);
+		if (lens_ext[code] != 0) {
+			put_bits(stream, lit + MIN_MATCH - lens[code],
+			    lens_ext[code]);
+		}
+
+		code = distance_symbol(dist - 1);
+		put_bits(stream, dist_code->code[code], dist_code->length[code]);
+		if (dists_ext[code] != 0)
+			put_bits(stream, dist - dists[code], dists_ext[code]);
+	}
+
+	put_bits(stream, len_code->code[END_BLOCK],
+	    len_code->length[END_BLOCK]);
+}
+
+/** Compute size of the dynamic Huffman code tables
+ *
+ * Computes the code lengths and the run-length encoding of the code
+ * lengths as it would be output.
+ *
+ * @param len_code  Literal/length code (lengths set).
+ * @param dist_code Distance code (lengths set).
+ * @param cl_code   Computed code length code.
+ * @param rle       Computed run-length encoded code lengths.
+ * @param rle_ext   Extra bits of the run-length encoded code lengths.
+ * @param rle_count Number of run-length encoded code lengths.
+ * @param hlit      Number of literal/length code lengths.
+ * @param hdist     Number of distance code lengths.
+ * @param hclen     Number of code length code lengths.
+ *
+ * @return Size of the tables in bits.
+ *
+ */
+static size_t dynamic_tables(huffman_code_t *len_code,
+    huffman_code_t *dist_code, huffman_code_t *cl_code, uint8_t *rle,
+    uint8_t *rle_ext, size_t *rle_count, size_t *hlit, size_t *hdist,
+    size_t *hclen)
+{
+	*hlit = MAX_LITLEN;
+	while ((*hlit > END_BLOCK + 1) && (len_code->length[*hlit - 1] == 0))
+		(*hlit)--;
+
+	*hdist = MAX_DIST;
+	while ((*hdist > 1) && (dist_code->length[*hdist - 1] == 0))
+		(*hdist)--;
+
+	uint8_t length[MAX_LITLEN + MAX_DIST];
+	size_t total = *hlit + *hdist;
+	memcpy(length, len_code->length, *hlit);
+	memcpy(length + *hlit, dist_code->length, *hdist);
+
+	/* Run-length encode the code lengths */
+	uint16_t cl_freq[MAX_ORDER] = { 0 };
+	size_t count = 0;
+	size_t i = 0;
+
+	while (i < total) {
+		uint8_t value = length[i];
+		size_t run = 1;
+		while ((i + run < total) && (length[i + run] == value))
+			run++;
+
+		i += run;
+
+		if (value == 0) {
+			while (run >= 11) {
+				size_t rep = (run > 138) ? 138 : run;
+				rle[count] = 18;
+				rle_ext[count++] = rep - 11;
+				run -= rep;
+			}
+
+			if (run >= 3) {
+				rle[count] = 17;
+				rle_ext[count++] = run - 3;
+				run = 0;
+			}
+		} else {
+			rle[count] = value;
+			rle_ext[count++] = 0;
+			run--;
+
+			while (run >= 3) {
+				size_t rep = (run > 6) ? 6 : run;
+				rle[count] = 16;
+				rle_ext[count++] = rep - 3;
+				run -= rep;
+			}
+		}
+
+		while (run > 0) {
+			rle[count] = value;
+			rle_ext[count++] = 0;
+			run--;
+		}
+	}
+
+	for (i = 0; i < count; i++)
+		cl_freq[rle[i]]++;
+
+	huffman_lengths(cl_freq, MAX_ORDER, MAX_ORDER_BIT, cl_code->length);
+	huffman_codes(cl_code, MAX_ORDER);
+
+	*hclen = MAX_ORDER;
+	while ((*hclen > 4) && (cl_code->length[order[*hclen - 1]] == 0))
+		(*hclen)--;
+
+	*rle_count = count;
+
+	size_t bits = 5 + 5 + 4 + 3 * *hclen;
+	for (i = 0; i < MAX_ORDER; i++)
+		bits += (size_t) cl_freq[i] * cl_code->length[i];
+
+	bits += 2 * cl_freq[16] + 3 * cl_freq[17] + 7 * cl_freq[18];
+	return bits;
+}
+
+/** Output a stored block
+ *
+ * @param stream Deflate stream.
+ * @param data   Block data.
+ * @param len    Block size (at most 65535 bytes).
+ * @param last   Last block of the stream.
+ *
+ */
+static void block_put_stored(deflate_stream_t *stream, const uint8_t *data,
+    size_t len, bool last)
+{
+	put_bits(stream, last ? 1 : 0, 1);
+	put_bits(stream, 0, 2);
+	put_align(stream);
+
+	put_bits(stream, len, 16);
+	put_bits(stream, (uint16_t) ~len, 16);
+
+	if (len > 0) {
+		memcpy(stream->pending + stream->pending_len, data, len);
+		stream->pending_len += len;
+	}
+}
+
+/** Output the current block
+ *
+ * The block covers the input from block_start to block_end and it is
+ * encoded in the shortest of the stored, fixed and dynamic forms.
+ *
+ * @param stream Deflate stream.
+ * @param last   Last block of the stream.
+ *
+ */
+static void block_flush(deflate_stream_t *stream, bool last)
+{
+	size_t stored_len = stream->block_end - stream->block_start;
+	size_t chunks = (stored_len + UINT16_MAX - 1) / UINT16_MAX;
+	if (chunks == 0)
+		chunks = 1;
+
+	/* Block header, padding, length and its complement per chunk */
+	size_t stored_bits = chunks * (3 + 7 + 32) + 8 * stored_len;
+
+	huffman_code_t len_code;
+	huffman_code_t dist_code;
+	huffman_code_t cl_code;
+	uint8_t rle[MAX_LITLEN + MAX_DIST];
+	uint8_t rle_ext[MAX_LITLEN + MAX_DIST];
+	size_t rle_count = 0;
+	size_t hlit = 0;
+	size_t hdist = 0;
+	size_t hclen = 0;
+
+	size_t fixed_bits = SIZE_MAX;
+	size_t dynamic_bits = SIZE_MAX;
+
+	if (stream->level != DEFLATE_LEVEL_STORE) {
+		stream->lit_freq[END_BLOCK] = 1;
+
+		huffman_fixed(&len_code, &dist_code);
+		fixed_bits = 3 + block_data_bits(stream, &len_code, &dist_code);
+
+		/* Use at least two distance codes as zlib does */
+		uint16_t dist_freq[MAX_DIST];
+		memcpy(dist_freq, stream->dist_freq, sizeof(dist_freq));
+		size_t used = 0;
+		for (size_t i = 0; i < MAX_DIST; i++) {
+			if (dist_freq[i] != 0)
+				used++;
+		}
+
+		for (size_t i = 0; (used < 2) && (i < MAX_DIST); i++) {
+			if (dist_freq[i] == 0) {
+				dist_freq[i] = 1;
+				used++;
+			}
+		}
+
+		huffman_lengths(stream->lit_freq, MAX_LITLEN, MAX_HUFFMAN_BIT,
+		    len_code.length);
+		huffman_lengths(dist_freq, MAX_DIST, MAX_HUFFMAN_BIT,
+		    dist_code.length);
+		huffman_codes(&len_code, MAX_LITLEN);
+		huffman_codes(&dist_code, MAX_DIST);
+
+		dynamic_bits = 3 + dynamic_tables(&len_code, &dist_code,
+		    &cl_code, rle, rle_ext, &rle_count, &hlit, &hdist, &hclen) +
+		    block_data_bits(stream, &len_code, &dist_code);
+	}
+
+	if ((stored_bits <= fixed_bits) && (stored_bits <= dynamic_bits)) {
+		const uint8_t *data = stream->window + stream->block_start;
+
+		do {
+			size_t len = (stored_len > UINT16_MAX) ? UINT16_MAX :
+			    stored_len;
+			stored_len -= len;
+			block_put_stored(stream, data, len, last &&
+			    (stored_len == 0));
+			data += len;
+		} while (stored_len > 0);
+	} else if (fixed_bits <= dynamic_bits) {
+		put_bits(stream, last ? 1 : 0, 1);
+		put_bits(stream, 1, 2);
+		huffman_fixed(&len_code, &dist_code);
+		block_put_data(stream, &len_code, &dist_code);
+	} else {
+		put_bits(stream, last ? 1 : 0, 1);
+		put_bits(stream, 2, 2);
+
+		put_bits(stream, hlit - (END_BLOCK + 1), 5);
+		put_bits(stream, hdist - 1, 5);
+		put_bits(stream, hclen - 4, 4);
+
+		for (size_t i = 0; i < hclen; i++)
+			put_bits(stream, cl_code.length[order[i]], 3);
+
+		for (size_t i = 0; i < rle_count; i++) {
+			put_bits(stream, cl_code.code[rle[i]], cl_code.length[rle[i]]);
+			if (rle[i] == 16)
+				put_bits(stream, rle_ext[i], 2);
+			else if (rle[i] == 17)
+				put_bits(stream, rle_ext[i], 3);
+			else if (rle[i] == 18)
+				put_bits(stream, rle_ext[i], 7);
+		}
+
+		block_put_data(stream, &len_code, &dist_code);
+	}
+
+	stream->block_start = stream->block_end;
+	stream->sym_count = 0;
+	memset(stream->lit_freq, 0, sizeof(stream->lit_freq));
+	memset(stream->dist_freq, 0, sizeof(stream->dist_freq));
+}
+
+/** Record a literal
+ *
+ * @param stream Deflate stream.
+ * @param lit    Literal byte.
+ *
+ * @return True if the block is full.
+ *
+ */
+static inline bool tally_lit(deflate_stream_t *stream, uint8_t lit)
+{
+	stream->sym_lit[stream->sym_count] = lit;
+	stream->sym_dist[stream->sym_count] = 0;
+	stream->sym_count++;
+	stream->lit_freq[lit]++;
+	stream->block_end++;
+
+	return (stream->sym_count >= SYM_BUF_SIZE - 1);
+}
+
+/** Record a match
+ *
+ * @param stream Deflate stream.
+ * @param dist   Match distance.
+ * @param len    Match length.
+ *
+ * @return True if the block is full.
+ *
+ */
+static inline bool tally_match(deflate_stream_t *stream, size_t dist,
+    size_t len)
+{
+	stream->sym_lit[stream->sym_count] = len - MIN_MATCH;
+	stream->sym_dist[stream->sym_count] = dist;
+	stream->sym_count++;
+	stream->lit_freq[END_BLOCK + 1 + stream->len_symbol[len - MIN_MATCH]]++;
+	stream->dist_freq[distance_symbol(dist - 1)]++;
+	stream->block_end += len;
+
+	return (stream->sym_count >= SYM_BUF_SIZE - 1);
+}
+
+/** Insert string at a position to the hash table
+ *
+ * @param stream Deflate stream.
+ * @param pos    Position in the window (at least MIN_MATCH bytes valid).
+ *
+ * @return Previous position with the same hash or NIL.
+ *
+ */
+static inline size_t hash_insert(deflate_stream_t *stream, size_t pos)
+{
+	const uint8_t *str = stream->window + pos;
+	uint32_t hash = ((uint32_t) str[0] | ((uint32_t) str[1] << 8) |
+	    ((uint32_t) str[2] << 16)) * UINT32_C(2654435761);
+	hash >>= 32 - HASH_BITS;
+
+	size_t head = stream->head[hash];
+	stream->prev[pos & WINDOW_MASK] = head;
+	stream->head[hash] = pos;
+
+	return head;
+}
+
+/** Find the longest match at the current position
+ *
+ * Follows the hash chain starting at cur_match and sets match_start to
+ * the start of the best match found.
+ *
+ * @param stream    Deflate stream.
+ * @param cur_match First position to try.
+ * @param best_len  Length of a match that has to be exceeded.
+ *
+ * @return Length of the longest match (best_len if nothing longer).
+ *
+ */
+static size_t longest_match(deflate_stream_t *stream, size_t cur_match,
+    size_t best_len)
+{
+	const deflate_config_t *config = stream->config;
+	const uint8_t *scan = stream->window + stream->strstart;
+	size_t limit = (stream->strstart > MAX_DISTANCE) ?
+	    stream->strstart - MAX_DISTANCE : NIL;
+
+	size_t max_len = (stream->lookahead < MAX_MATCH) ? stream->lookahead :
+	    MAX_MATCH;
+	if (best_len >= max_len)
+		return best_len;
+
+	size_t nice_len = (config->nice_length < max_len) ?
+	    config->nice_length : max_len;
+
+	unsigned int chain = config->max_chain;
+	if (best_len >= config->good_length)
+		chain >>= 2;
+
+	do {
+		const uint8_t *match = stream->window + cur_match;
+
+		/* Quickly skip matches that cannot be better */
+		if ((match[best_len] != scan[best_len]) ||
+		    (match[best_len - 1] != scan[best_len - 1]) ||
+		    (match[0] != scan[0]) || (match[1] != scan[1]))
+			continue;
+
+		size_t len = 2;
+
+		/* Compare eight bytes at a time while they are the same */
+		while (len + 8 <= max_len) {
+			uint64_t a;
+			uint64_t b;
+			memcpy(&a, match + len, sizeof(a));
+			memcpy(&b, scan + len, sizeof(b));
+			if (a != b)
+				break;
+
+			len += 8;
+		}
+
+		while ((len < max_len) && (match[len] == scan[len]))
+			len++;
+
+		if (len > best_len) {
+			stream->match_start = cur_match;
+			best_len = len;
+			if (len >= nice_len)
+				break;
+		}
+	} while (((cur_match = stream->prev[cur_match & WINDOW_MASK]) > limit) &&
+	    (--chain != 0));
+
+	return best_len;
+}
+
+/** Compress without looking for matches
+ *
+ * @param stream Deflate stream.
+ *
+ */
+static void deflate_store(deflate_stream_t *stream)
+{
+	stream->strstart += stream->lookahead;
+	stream->block_end = stream->strstart;
+	stream->lookahead = 0;
+}
+
+/** Compress taking the first match found at each position
+ *
+ * @param stream   Deflate stream.
+ * @param flushing Compress all the input, even without enough lookahead.
+ *
+ * @return True if the block is full.
+ *
+ */
+static bool deflate_greedy(deflate_stream_t *stream, bool flushing)
+{
+	while ((stream->lookahead >= MIN_LOOKAHEAD) ||
+	    (flushing && (stream->lookahead > 0))) {
+		size_t hash_head = NIL;
+		if (stream->lookahead >= MIN_MATCH)
+			hash_head = hash_insert(stream, stream->strstart);
+
+		size_t match_length = 0;
+		if ((hash_head != NIL) &&
+		    (stream->strstart - hash_head <= MAX_DISTANCE)) {
+			match_length = longest_match(stream, hash_head,
+			    MIN_MATCH - 1);
+		}
+
+		bool full;
+		if (match_length >= MIN_MATCH) {
+			full = tally_match(stream,
+			    stream->strstart - stream->match_start, match_length);
+			stream->lookahead -= match_length;
+
+			if ((match_length <= stream->config->max_lazy) &&
+			    (stream->lookahead >= MIN_MATCH)) {
+				/* Insert the strings inside of the match */
+				for (size_t i = 1; i < match_length; i++) {
+					stream->strstart++;
+					hash_insert(stream, stream->strstart);
+				}
+
+				stream->strstart++;
+			} else {
+				stream->strstart += match_length;
+			}
+		} else {
+			full = tally_lit(stream, stream->window[stream->strstart]);
+			stream->lookahead--;
+			stream->strstart++;
+		}
+
+		if (full)
+			return true;
+	}
+
+	return false;
+}
+
+/** Compress looking for a longer match at the next position
+ *
+ * A match is output only if there is no longer match starting at the
+ * next byte, otherwise the byte is output as a literal.
+ *
+ * @param stream   Deflate stream.
+ * @param flushing Compress all the input, even without enough lookahead.
+ *
+ * @return True if the block is full.
+ *
+ */
+static bool deflate_lazy(deflate_stream_t *stream, bool flushing)
+{
+	while ((stream->lookahead >= MIN_LOOKAHEAD) ||
+	    (flushing && (stream->lookahead > 0))) {
+		size_t hash_head = NIL;
+		if (stream->lookahead >= MIN_MATCH)
+			hash_head = hash_insert(stream, stream->strstart);
+
+		stream->prev_length = stream->match_length;
+		stream->prev_match = stream->match_start;
+		stream->match_length = MIN_MATCH - 1;
+
+		if ((hash_head != NIL) &&
+		    (stream->prev_length < stream->config->max_lazy) &&
+		    (stream->strstart - hash_head <= MAX_DISTANCE)) {
+			stream->match_length = longest_match(stream, hash_head,
+			    stream->prev_length);
+
+			if ((stream->match_length == MIN_MATCH) &&
+			    (stream->strstart - stream->match_start > TOO_FAR))
+				stream->match_length = MIN_MATCH - 1;
+		}
+
+		bool full = false;
+
+		if ((stream->prev_length >= MIN_MATCH) &&
+		    (stream->match_length <= stream->prev_length)) {
+			/* The match at the previous byte is the better one */
+			size_t max_insert = stream->strstart + stream->lookahead -
+			    MIN_MATCH;
+
+			full = tally_match(stream,
+			    stream->strstart - 1 - stream->prev_match,
+			    stream->prev_length);
+
+			/* Insert the strings inside of the match */
+			stream->lookahead -= stream->prev_length - 1;
+			for (size_t i = 2; i < stream->prev_length; i++) {
+				stream->strstart++;
+				if (stream->strstart <= max_insert)
+					hash_insert(stream, stream->strstart);
+			}
+
+			stream->match_available = false;
+			stream->match_length = MIN_MATCH - 1;
+			stream->strstart++;
+		} else if (stream->match_available) {
+			full = tally_lit(stream,
+			    stream->window[stream->strstart - 1]);
+			stream->strstart++;
+			stream->lookahead--;
+		} else {
+			/* Wait for the next byte to decide */
+			stream->match_available = true;
+			stream->strstart++;
+			stream->lookahead--;
+		}
+
+		if (full)
+			return true;
+	}
+
+	return false;
+}
+
+/** Move the second window to the first one
+ *
+ * @param stream Deflate stream.
+ *
+ */
+static void deflate_slide(deflate_stream_t *stream)
+{
+	memcpy(stream->window, stream->window + WINDOW_SIZE, WINDOW_SIZE);
+
+	stream->strstart -= WINDOW_SIZE;
+	stream->block_start -= WINDOW_SIZE;
+	stream->block_end -= WINDOW_SIZE;
+
+	stream->match_start = (stream->match_start >= WINDOW_SIZE) ?
+	    stream->match_start - WINDOW_SIZE : NIL;
+	stream->prev_match = (stream->prev_match >= WINDOW_SIZE) ?
+	    stream->prev_match - WINDOW_SIZE : NIL;
+
+	for (size_t i = 0; i < HASH_SIZE; i++) {
+		stream->head[i] = (stream->head[i] >= WINDOW_SIZE) ?
+		    stream->head[i] - WINDOW_SIZE : NIL;
+	}
+
+	for (size_t i = 0; i < WINDOW_SIZE; i++) {
+		stream->prev[i] = (stream->prev[i] >= WINDOW_SIZE) ?
+		    stream->prev[i] - WINDOW_SIZE : NIL;
+	}
+}
+
+/** Get an upper bound of the compressed size
+ *
+ * @param srclen Size of the data to compress (bytes).
+ *
+ * @return Largest size of the data compressed by deflate() (bytes).
+ *
+ */
+size_t deflate_bound(size_t srclen)
+{
+	/* Blocks hold at least 16 KiB (save the last one) */
+	return srclen + (srclen >> 10) + 32;
+}
+
+/** Create deflate stream
+ *
+ * @param level   Compression level (DEFLATE_LEVEL_STORE to
+ *                DEFLATE_LEVEL_BEST).
+ * @param rstream Place to store pointer to the new stream.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t deflate_stream_create(unsigned int level, deflate_stream_t **rstream)
+{
+	if (level > DEFLATE_LEVEL_BEST)
+		return EINVAL;
+
+	deflate_stream_t *stream = malloc(sizeof(deflate_stream_t));
+	if (stream == NULL)
+		return ENOMEM;
+
+	stream->config = &configs[level];
+	stream->level = level;
+
+	stream->strstart = 0;
+	stream->lookahead = 0;
+	stream->block_start = 0;
+	stream->block_end = 0;
+
+	memset(stream->head, 0, sizeof(stream->head));
+	memset(stream->prev, 0, sizeof(stream->prev));
+
+	stream->match_length = MIN_MATCH - 1;
+	stream->match_start = 0;
+	stream->prev_length = MIN_MATCH - 1;
+	stream->prev_match = 0;
+	stream->match_available = false;
+
+	stream->sym_count = 0;
+	memset(stream->lit_freq, 0, sizeof(stream->lit_freq));
+	memset(stream->dist_freq, 0, sizeof(stream->dist_freq));
+
+	unsigned int code = 0;
+	for (size_t len = MIN_MATCH; len <= MAX_MATCH; len++) {
+		while ((code < MAX_LEN - 1) && (lens[code + 1] <= len))
+			code++;
+
+		stream->len_symbol[len - MIN_MATCH] = code;
+	}
+
+	stream->pending_out = 0;
+	stream->pending_len = 0;
+	stream->bitbuf = 0;
+	stream->bitlen = 0;
+
+	stream->flushed = false;
+	stream->finished = false;
+
+	*rstream = stream;
+	return EOK;
+}
+
+/** Destroy deflate stream
+ *
+ * @param stream Deflate stream.
+ *
+ */
+void deflate_stream_destroy(deflate_stream_t *stream)
+{
+	free(stream);
+}
+
+/** Deflate part of a stream
+ *
+ * Compresses as much of the input as possible and stops when the whole
+ * input has been consumed or the output buffer is full. Unless flushing,
+ * some of the input is kept back to be compressed with the following data.
+ * After the whole input has been consumed with DEFLATE_SYNC_FLUSH or
+ * DEFLATE_FINISH (and all output returned), the output decompresses to
+ * all the input so far.
+ *
+ * @param stream   Deflate stream.
+ * @param src      Source data buffer.
+ * @param srclen   Source buffer size (bytes).
+ * @param consumed Place to store number of bytes consumed from the source.
+ * @param dest     Destination data buffer.
+ * @param destlen  Destination buffer size (bytes).
+ * @param produced Place to store number of bytes written to the
+ *                 destination.
+ * @param flush    Flush mode.
+ *
+ * @return EOK on success.
+ * @return EINVAL if there is input after the stream was finished.
+ *
+ */
+errno_t deflate_stream_process(deflate_stream_t *stream, const void *src,
+    size_t srclen, size_t *consumed, void *dest, size_t destlen,
+    size_t *produced, deflate_flush_t flush)
+{
+	if ((stream->finished) && (srclen > 0))
+		return EINVAL;
+
+	stream->src = (const uint8_t *) src;
+	stream->srclen = srclen;
+	stream->srccnt = 0;
+
+	if (srclen > 0)
+		stream->flushed = false;
+
+	size_t destcnt = 0;
+
+	while (true) {
+		/* Return the pending output first */
+		size_t len = stream->pending_len - stream->pending_out;
+		if (len > destlen - destcnt)
+			len = destlen - destcnt;
+
+		memcpy((uint8_t *) dest + destcnt,
+		    stream->pending + stream->pending_out, len);
+		stream->pending_out += len;
+		destcnt += len;
+
+		if (stream->pending_out < stream->pending_len)
+			break;
+
+		stream->pending_out = 0;
+		stream->pending_len = 0;
+
+		if (stream->finished)
+			break;
+
+		/* Make room for more input */
+		if ((stream->srccnt < stream->srclen) &&
+		    (stream->strstart >= 2 * WINDOW_SIZE - MIN_LOOKAHEAD)) {
+			if (stream->block_start < WINDOW_SIZE) {
+				/* The block would not be in the window anymore */
+				block_flush(stream, false);
+				continue;
+			}
+
+			deflate_slide(stream);
+		}
+
+		size_t end = stream->strstart + stream->lookahead;
+		len = 2 * WINDOW_SIZE - end;
+		if (len > stream->srclen - stream->srccnt)
+			len = stream->srclen - stream->srccnt;
+
+		memcpy(stream->window + end, stream->src + stream->srccnt, len);
+		stream->srccnt += len;
+		stream->lookahead += len;
+
+		bool flushing = (flush != DEFLATE_NO_FLUSH) &&
+		    (stream->srccnt == stream->srclen);
+
+		bool full;
+		if (stream->level == DEFLATE_LEVEL_STORE) {
+			deflate_store(stream);
+			full = false;
+		} else if (stream->config->lazy) {
+			full = deflate_lazy(stream, flushing);
+		} else {
+			full = deflate_greedy(stream, flushing);
+		}
+
+		if (full) {
+			block_flush(stream, false);
+			continue;
+		}
+
+		/* The window is full, slide it */
+		if (stream->srccnt < stream->srclen)
+			continue;
+
+		/* Do not repeat a sync flush with no new input */
+		if ((!flushing) ||
+		    ((flush == DEFLATE_SYNC_FLUSH) && (stream->flushed)))
+			break;
+
+		if (stream->match_available) {
+			tally_lit(stream, stream->window[stream->strstart - 1]);
+			stream->match_available = false;
+		}
+
+		if (flush == DEFLATE_FINISH) {
+			block_flush(stream, true);
+			put_align(stream);
+			stream->finished = true;
+		} else {
+			block_flush(stream, false);
+
+			/* Empty stored block aligns the output to a byte */
+			block_put_stored(stream, NULL, 0, false);
+		}
+
+		stream->flushed = true;
+	}
+
+	*consumed = stream->srccnt;
+	*produced = destcnt;
+	return EOK;
+}
+
+/** Check whether the whole stream has been deflated
+ *
+ * @param stream Deflate stream.
+ *
+ * @return True if the last block has been output.
+ *
+ */
+bool deflate_stream_done(deflate_stream_t *stream)
+{
+	return ((stream->finished) &&
+	    (stream->pending_out == stream->pending_len));
+}
+
+/** Deflate data
+ *
+ * The routine allocates the output buffer.
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level (DEFLATE_LEVEL_STORE to
+ *                     DEFLATE_LEVEL_BEST).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t deflate(void *src, size_t srclen, unsigned int level, void **dest,
+    size_t *destlen)
+{
+	deflate_stream_t *stream;
+	errno_t ret = deflate_stream_create(level, &stream);
+	if (ret != EOK)
+		return ret;
+
+	size_t bound = deflate_bound(srclen);
+	void *buf = malloc(bound);
+	if (buf == NULL) {
+		deflate_stream_destroy(stream);
+		return ENOMEM;
+	}
+
+	size_t consumed;
+	size_t produced;
+	ret = deflate_stream_process(stream, src, srclen, &consumed, buf, bound,
+	    &produced, DEFLATE_FINISH);
+
+	assert(ret != EOK || deflate_stream_done(stream));
+	deflate_stream_destroy(stream);
+
+	if (ret != EOK) {
+		free(buf);
+		return ret;
+	}
+
+	*dest = buf;
+	*destlen = produced;
+	return EOK;
+}
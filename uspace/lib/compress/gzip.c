@@ -32,7 +32,9 @@
 #include <mem.h>
 #include <byteorder.h>
 #include <stdlib.h>
+#include <adt/checksum.h>
 #include "gzip.h"
+#include "deflate.h"
 #include "inflate.h"
 
 #define GZIP_ID1  UINT8_C(0x1f)
@@ -46,6 +48,11 @@
 #define GZIP_FLAG_FNAME     UINT8_C(1 << 3)
 #define GZIP_FLAG_FCOMMENT  UINT8_C(1 << 4)
 
+#define GZIP_EXTRA_BEST  UINT8_C(2)
+#define GZIP_EXTRA_FAST  UINT8_C(4)
+
+#define GZIP_OS_UNKNOWN  UINT8_C(255)
+
 typedef struct {
 	uint8_t id1;
 	uint8_t id2;
@@ -61,6 +68,37 @@ typedef struct {
 	uint32_t size;
 } __attribute__((packed)) gzip_footer_t;
 
+/** Gzip decoder state
+ *
+ */
+typedef enum {
+	GZIP_HEADER,    /**< Fixed header */
+	GZIP_EXTRA_LEN, /**< Length of the extra field */
+	GZIP_EXTRA,     /**< Extra field */
+	GZIP_NAME,      /**< File name */
+	GZIP_COMMENT,   /**< Comment */
+	GZIP_HCRC,      /**< Header CRC */
+	GZIP_DATA,      /**< Compressed data */
+	GZIP_FOOTER,    /**< Footer */
+	GZIP_DONE       /**< Whole member decoded */
+} gzip_mode_t;
+
+/** Gzip stream state
+ *
+ */
+struct gzip_stream {
+	gzip_mode_t mode;         /**< Decoder state */
+	inflate_stream_t *inflate;  /**< Stream of the compressed data */
+
+	uint8_t buf[sizeof(gzip_header_t)];  /**< Collected fixed fields */
+	size_t buflen;            /**< Bytes collected in the buffer */
+	uint8_t flags;            /**< Header flags */
+	size_t skip;              /**< Bytes of the extra field left */
+
+	uint32_t crc32;           /**< CRC of the output so far */
+	uint32_t size;            /**< Size of the output so far (modulo 2^32) */
+};
+
 /** Expand GZIP compressed data
  *
  * The routine allocates the output buffer based
@@ -175,9 +213,321 @@ errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
 
 	errno_t ret = inflate(stream, stream_length, *dest, *destlen);
 	if (ret != EOK) {
-		free(dest);
+		free(*dest);
+		return ret;
+	}
+
+	return EOK;
+}
+
+/** Create gzip decompression stream
+ *
+ * Unlike gzip_expand(), the stream does not need the whole input at once
+ * and its memory use is bounded. The CRC and size of the data are checked.
+ *
+ * @param rstream Place to store pointer to the new stream.
+ *
+ * @return EOK on success.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t gzip_stream_create(gzip_stream_t **rstream)
+{
+	gzip_stream_t *stream = malloc(sizeof(gzip_stream_t));
+	if (stream == NULL)
+		return ENOMEM;
+
+	errno_t ret = inflate_stream_create(&stream->inflate);
+	if (ret != EOK) {
+		free(stream);
+		return ret;
+	}
+
+	stream->mode = GZIP_HEADER;
+	stream->buflen = 0;
+	stream->flags = 0;
+	stream->skip = 0;
+	stream->crc32 = 0;
+	stream->size = 0;
+
+	*rstream = stream;
+	return EOK;
+}
+
+/** Destroy gzip decompression stream
+ *
+ * @param stream Gzip stream.
+ *
+ */
+void gzip_stream_destroy(gzip_stream_t *stream)
+{
+	inflate_stream_destroy(stream->inflate);
+	free(stream);
+}
+
+/** Collect fixed size fields
+ *
+ * @param stream Gzip stream.
+ * @param src    Source data buffer.
+ * @param srclen Source buffer size (bytes).
+ * @param srccnt Position in the source buffer.
+ * @param len    Size of the fields (bytes).
+ *
+ * @return True if all the fields have been collected.
+ *
+ */
+static bool gzip_collect(gzip_stream_t *stream, const uint8_t *src,
+    size_t srclen, size_t *srccnt, size_t len)
+{
+	while ((stream->buflen < len) && (*srccnt < srclen)) {
+		stream->buf[stream->buflen] = src[*srccnt];
+		stream->buflen++;
+		(*srccnt)++;
+	}
+
+	if (stream->buflen < len)
+		return false;
+
+	stream->buflen = 0;
+	return true;
+}
+
+/** Skip a zero terminated field
+ *
+ * @param src    Source data buffer.
+ * @param srclen Source buffer size (bytes).
+ * @param srccnt Position in the source buffer.
+ *
+ * @return True if the terminating zero has been skipped.
+ *
+ */
+static bool gzip_skip_string(const uint8_t *src, size_t srclen,
+    size_t *srccnt)
+{
+	while (*srccnt < srclen) {
+		uint8_t byte = src[*srccnt];
+		(*srccnt)++;
+
+		if (byte == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/** Expand part of a GZIP compressed stream
+ *
+ * Expands as much of the input as possible and stops when the whole
+ * input has been consumed, the output buffer is full or the end of
+ * the (first) member has been reached.
+ *
+ * @param stream   Gzip stream.
+ * @param src      Source data buffer.
+ * @param srclen   Source buffer size (bytes).
+ * @param consumed Place to store number of bytes consumed from the source.
+ * @param dest     Destination data buffer.
+ * @param destlen  Destination buffer size (bytes).
+ * @param produced Place to store number of bytes written to the
+ *                 destination.
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code, invalid deflate data,
+ *                   invalid compression method, invalid stream or
+ *                   data not matching the CRC or size.
+ *
+ */
+errno_t gzip_stream_process(gzip_stream_t *stream, const void *src,
+    size_t srclen, size_t *consumed, void *dest, size_t destlen,
+    size_t *produced)
+{
+	const uint8_t *in = (const uint8_t *) src;
+	size_t srccnt = 0;
+	size_t destcnt = 0;
+	errno_t ret = EOK;
+
+	while (ret == EOK) {
+		if (stream->mode == GZIP_DATA) {
+			size_t used;
+			size_t len;
+			ret = inflate_stream_process(stream->inflate, in + srccnt,
+			    srclen - srccnt, &used, (uint8_t *) dest + destcnt,
+			    destlen - destcnt, &len);
+
+			stream->crc32 = compute_crc32_seed((uint8_t *) dest + destcnt,
+			    len, stream->crc32);
+			stream->size += len;
+			srccnt += used;
+			destcnt += len;
+
+			if ((ret != EOK) || (!inflate_stream_done(stream->inflate)))
+				break;
+
+			stream->mode = GZIP_FOOTER;
+			continue;
+		}
+
+		if ((stream->mode == GZIP_DONE) || (srccnt == srclen))
+			break;
+
+		switch (stream->mode) {
+		case GZIP_HEADER:
+			if (!gzip_collect(stream, in, srclen, &srccnt,
+			    sizeof(gzip_header_t)))
+				break;
+
+			gzip_header_t header;
+			memcpy(&header, stream->buf, sizeof(header));
+
+			if ((header.id1 != GZIP_ID1) ||
+			    (header.id2 != GZIP_ID2) ||
+			    (header.method != GZIP_METHOD_DEFLATE) ||
+			    ((header.flags & (~GZIP_FLAGS_MASK)) != 0)) {
+				ret = EINVAL;
+				break;
+			}
+
+			stream->flags = header.flags;
+			stream->mode = GZIP_EXTRA_LEN;
+			break;
+		case GZIP_EXTRA_LEN:
+			if ((stream->flags & GZIP_FLAG_FEXTRA) == 0) {
+				stream->mode = GZIP_NAME;
+				break;
+			}
+
+			if (!gzip_collect(stream, in, srclen, &srccnt,
+			    sizeof(uint16_t)))
+				break;
+
+			stream->skip = stream->buf[0] | (stream->buf[1] << 8);
+			stream->mode = GZIP_EXTRA;
+			break;
+		case GZIP_EXTRA:
+			if (stream->skip > srclen - srccnt) {
+				stream->skip -= srclen - srccnt;
+				srccnt = srclen;
+				break;
+			}
+
+			srccnt += stream->skip;
+			stream->mode = GZIP_NAME;
+			break;
+		case GZIP_NAME:
+			if (((stream->flags & GZIP_FLAG_FNAME) == 0) ||
+			    (gzip_skip_string(in, srclen, &srccnt)))
+				stream->mode = GZIP_COMMENT;
+			break;
+		case GZIP_COMMENT:
+			if (((stream->flags & GZIP_FLAG_FCOMMENT) == 0) ||
+			    (gzip_skip_string(in, srclen, &srccnt)))
+				stream->mode = GZIP_HCRC;
+			break;
+		case GZIP_HCRC:
+			if (((stream->flags & GZIP_FLAG_FHCRC) == 0) ||
+			    (gzip_collect(stream, in, srclen, &srccnt,
+			    sizeof(uint16_t))))
+				stream->mode = GZIP_DATA;
+			break;
+		case GZIP_FOOTER:
+			if (!gzip_collect(stream, in, srclen, &srccnt,
+			    sizeof(gzip_footer_t)))
+				break;
+
+			gzip_footer_t footer;
+			memcpy(&footer, stream->buf, sizeof(footer));
+
+			if ((uint32_t_le2host(footer.crc32) != stream->crc32) ||
+			    (uint32_t_le2host(footer.size) != stream->size)) {
+				ret = EINVAL;
+				break;
+			}
+
+			stream->mode = GZIP_DONE;
+			break;
+		default:
+			ret = EINVAL;
+		}
+	}
+
+	*consumed = srccnt;
+	*produced = destcnt;
+	return ret;
+}
+
+/** Check whether the whole GZIP stream has been expanded
+ *
+ * @param stream Gzip stream.
+ *
+ * @return True if the data and the footer have been decoded.
+ *
+ */
+bool gzip_stream_done(gzip_stream_t *stream)
+{
+	return (stream->mode == GZIP_DONE);
+}
+
+/** Compress data in GZIP format
+ *
+ * The routine allocates the output buffer.
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level (DEFLATE_LEVEL_STORE to
+ *                     DEFLATE_LEVEL_BEST).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t gzip_compress(void *src, size_t srclen, unsigned int level,
+    void **dest, size_t *destlen)
+{
+	deflate_stream_t *stream;
+	errno_t ret = deflate_stream_create(level, &stream);
+	if (ret != EOK)
+		return ret;
+
+	size_t bound = sizeof(gzip_header_t) + deflate_bound(srclen) +
+	    sizeof(gzip_footer_t);
+	uint8_t *buf = malloc(bound);
+	if (buf == NULL) {
+		deflate_stream_destroy(stream);
+		return ENOMEM;
+	}
+
+	gzip_header_t header;
+	header.id1 = GZIP_ID1;
+	header.id2 = GZIP_ID2;
+	header.method = GZIP_METHOD_DEFLATE;
+	header.flags = 0;
+	header.mtime = 0;
+	header.extra_flags = (level == DEFLATE_LEVEL_BEST) ? GZIP_EXTRA_BEST :
+	    ((level == DEFLATE_LEVEL_FAST) ? GZIP_EXTRA_FAST : 0);
+	header.os = GZIP_OS_UNKNOWN;
+	memcpy(buf, &header, sizeof(header));
+
+	size_t consumed;
+	size_t produced;
+	ret = deflate_stream_process(stream, src, srclen, &consumed,
+	    buf + sizeof(header), bound - sizeof(header) - sizeof(gzip_footer_t),
+	    &produced, DEFLATE_FINISH);
+	deflate_stream_destroy(stream);
+
+	if (ret != EOK) {
+		free(buf);
 		return ret;
 	}
 
+	gzip_footer_t footer;
+	footer.crc32 = host2uint32_t_le(compute_crc32(src, srclen));
+	footer.size = host2uint32_t_le((uint32_t) srclen);
+	memcpy(buf + sizeof(header) + produced, &footer, sizeof(footer));
+
+	*dest = buf;
+	*destlen = sizeof(header) + produced + sizeof(footer);
 	return EOK;
 }
@@ -29,8 +29,20 @@
 #ifndef LIBCOMPRESS_GZIP_H_
 #define LIBCOMPRESS_GZIP_H_
 
+#include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+typedef struct gzip_stream gzip_stream_t;
+
 extern errno_t gzip_expand(void *, size_t, void **, size_t *);
 
+extern errno_t gzip_stream_create(gzip_stream_t **);
+extern void gzip_stream_destroy(gzip_stream_t *);
+extern errno_t gzip_stream_process(gzip_stream_t *, const void *, size_t,
+    size_t *, void *, size_t, size_t *);
+extern bool gzip_stream_done(gzip_stream_t *);
+
+extern errno_t gzip_compress(void *, size_t, unsigned int, void **, size_t *);
+
 #endif
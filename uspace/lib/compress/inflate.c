@@ -30,12 +30,14 @@
 /** @file
  * @brief Implementation of inflate decompression
  *
- * A simple inflate implementation (decompression of `deflate' stream as
- * described by RFC 1951) based on puff.c by Mark Adler. This code is
- * currently not optimized for speed but for readability.
+ * An inflate implementation (decompression of `deflate' stream as
+ * described by RFC 1951) originally based on puff.c by Mark Adler.
  *
- * All dynamically allocated memory memory is taken from the stack. The
- * stack usage should be typically bounded by 2 KB.
+ * Huffman codes are decoded by lookup tables indexed by several bits of
+ * the input at once. Codes longer than the root table index are resolved
+ * by a second level table. The decoder is a state machine which can stop
+ * at any point when it runs out of input or output space and continue
+ * later, keeping only the last 32 KiB of output as the sliding window.
  *
  * Original copyright notice:
  *
@@ -66,6 +68,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <mem.h>
 #include "inflate.h"
@@ -84,42 +87,105 @@
 /** Number of fixed literal/length codes */
 #define MAX_FIXED_LITLEN  288
 
-/** Number of all codes */
-#define MAX_CODE  (MAX_LITLEN + MAX_DIST)
+/** Number of all codes (including the unused fixed literal/length codes) */
+#define MAX_CODE  (MAX_FIXED_LITLEN + MAX_DIST)
 
-/** Check for input buffer overrun condition */
-#define CHECK_OVERRUN(state) \
-	do { \
-		if ((state).overrun) \
-			return ELIMIT; \
-	} while (false)
+/** Size of the sliding window */
+#define WINDOW_SIZE  32768
+#define WINDOW_MASK  (WINDOW_SIZE - 1)
 
-/** Inflate algorithm state
- *
- */
-typedef struct {
-	uint8_t *dest;    /**< Output buffer */
-	size_t destlen;   /**< Output buffer size */
-	size_t destcnt;   /**< Position in the output buffer */
+/** Longest match */
+#define MAX_MATCH  258
 
-	uint8_t *src;     /**< Input buffer */
-	size_t srclen;    /**< Input buffer size */
-	size_t srccnt;    /**< Position in the input buffer */
+/** Bits of the input indexing the root tables */
+#define LEN_ROOT    9
+#define DIST_ROOT   6
+#define ORDER_ROOT  7
+
+/*
+ * Largest tables needed for the root sizes above, including the second
+ * level tables (computed by the enough utility from zlib).
+ */
+#define LEN_ENOUGH   852
+#define DIST_ENOUGH  592
 
-	uint16_t bitbuf;  /**< Bit buffer */
-	size_t bitlen;    /**< Number of bits in the bit buffer */
+/** Decoding table entry kinds */
+#define HUFFMAN_INVALID  0
+#define HUFFMAN_SYMBOL   1
+#define HUFFMAN_TABLE    2
 
-	bool overrun;     /**< Overrun condition */
-} inflate_state_t;
+/** Huffman decoding table entry
+ *
+ */
+typedef struct {
+	/** Decoded symbol or offset of the second level table */
+	uint16_t value;
+	/** Length of the code or index bits of the second level table */
+	uint8_t bits;
+	/** Kind of the entry */
+	uint8_t kind;
+} huffman_entry_t;
 
 /** Huffman code description
  *
  */
 typedef struct {
-	uint16_t *count;   /**< Array of symbol counts */
-	uint16_t *symbol;  /**< Array of symbols */
+	huffman_entry_t *entries;  /**< Root and second level tables */
+	size_t size;               /**< Number of entries available */
+	unsigned int root;         /**< Bits indexing the root table */
 } huffman_t;
 
+/** Decoder state
+ *
+ */
+typedef enum {
+	INFLATE_HEADER,    /**< Block header */
+	INFLATE_STORED,    /**< Length of a stored block */
+	INFLATE_COPY,      /**< Data of a stored block */
+	INFLATE_TABLE,     /**< Sizes of the dynamic code tables */
+	INFLATE_LENLENS,   /**< Code length code lengths */
+	INFLATE_CODELENS,  /**< Literal/length and distance code lengths */
+	INFLATE_CODES,     /**< Compressed data */
+	INFLATE_DONE       /**< Last block decoded */
+} inflate_mode_t;
+
+/** Inflate stream state
+ *
+ */
+struct inflate_stream {
+	inflate_mode_t mode;  /**< Decoder state */
+	bool last;            /**< Decoding the last block */
+
+	const uint8_t *src;   /**< Input buffer */
+	size_t srclen;        /**< Input buffer size */
+	size_t srccnt;        /**< Position in the input buffer */
+
+	uint8_t *dest;        /**< Output buffer */
+	size_t destlen;       /**< Output buffer size */
+	size_t destcnt;       /**< Position in the output buffer */
+
+	uint64_t bitbuf;      /**< Bit buffer */
+	unsigned int bitlen;  /**< Number of bits in the bit buffer */
+
+	size_t stored;        /**< Bytes left in the stored block */
+
+	uint16_t nlen;        /**< Number of literal/length codes */
+	uint16_t ndist;       /**< Number of distance codes */
+	uint16_t ncode;       /**< Number of code length codes */
+	uint16_t index;       /**< Code lengths read so far */
+	uint16_t length[MAX_CODE];  /**< Code lengths */
+
+	huffman_t len_code;   /**< Literal/length (or code length) code */
+	huffman_t dist_code;  /**< Distance code */
+	huffman_entry_t len_entries[LEN_ENOUGH];
+	huffman_entry_t dist_entries[DIST_ENOUGH];
+
+	uint8_t window[WINDOW_SIZE];  /**< Sliding window */
+	size_t wpos;          /**< Write position in the window */
+	size_t whave;         /**< Valid bytes in the window */
+	size_t pending;       /**< Bytes in the window not yet output */
+};
+
 /** Length codes
  *
  */
@@ -161,200 +227,157 @@ static const short order[MAX_ORDER] = {
 	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
 };
 
-/** Static length symbol counts
+/** Load bits from the input into the bit buffer
  *
- */
-static uint16_t len_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 0, 0, 24, 152, 112, 0, 0, 0, 0, 0, 0
-};
-
-/** Static length symbols
- *
- */
-static uint16_t len_symbol[MAX_FIXED_LITLEN] = {
-	256, 257, 258, 259, 260, 261, 262, 263, 264, 265, 266, 267, 268,
-	269, 270, 271, 272, 273, 274, 275, 276, 277, 278, 279, 0, 1, 2,
-	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
-	21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
-	37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52,
-	53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68,
-	69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84,
-	85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100,
-	101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113,
-	114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126,
-	127, 128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139,
-	140, 141, 142, 143, 280, 281, 282, 283, 284, 285, 286, 287, 144,
-	145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157,
-	158, 159, 160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170,
-	171, 172, 173, 174, 175, 176, 177, 178, 179, 180, 181, 182, 183,
-	184, 185, 186, 187, 188, 189, 190, 191, 192, 193, 194, 195, 196,
-	197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 209,
-	210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222,
-	223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235,
-	236, 237, 238, 239, 240, 241, 242, 243, 244, 245, 246, 247, 248,
-	249, 250, 251, 252, 253, 254, 255
-};
-
-/** Static distance symbol counts
+ * @param state Inflate state.
  *
  */
-static uint16_t dist_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
+static inline void inflate_refill(inflate_stream_t *state)
+{
+	while ((state->bitlen <= 56) && (state->srccnt < state->srclen)) {
+		state->bitbuf |=
+		    ((uint64_t) state->src[state->srccnt]) << state->bitlen;
+		state->srccnt++;
+		state->bitlen += 8;
+	}
+}
 
-/** Static distance symbols
+/** Make sure there are enough bits in the bit buffer
  *
- */
-static uint16_t dist_symbol[MAX_DIST] = {
-	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
-	16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29
-};
-
-/** Huffman code for lengths
+ * @param state Inflate state.
+ * @param cnt   Number of bits needed (at most 56).
  *
- */
-static huffman_t len_code = {
-	.count = len_count,
-	.symbol = len_symbol
-};
-
-/** Huffman code for distances
+ * @return True if the bits are available.
  *
  */
-static huffman_t dist_code = {
-	.count = dist_count,
-	.symbol = dist_symbol
-};
+static inline bool need_bits(inflate_stream_t *state, unsigned int cnt)
+{
+	if (state->bitlen < cnt)
+		inflate_refill(state);
+
+	return (state->bitlen >= cnt);
+}
 
 /** Get bits from the bit buffer
+ *
+ * The bits must be available (see need_bits()).
  *
  * @param state Inflate state.
- * @param cnt   Number of bits to return (at most 16).
+ * @param cnt   Number of bits to return.
  *
  * @return Returned bits.
  *
  */
-static inline uint16_t get_bits(inflate_state_t *state, size_t cnt)
+static inline uint16_t get_bits(inflate_stream_t *state, unsigned int cnt)
 {
-	/* Bit accumulator for at least 20 bits */
-	uint32_t val = state->bitbuf;
+	uint16_t val = (uint16_t) (state->bitbuf & ((UINT64_C(1) << cnt) - 1));
 
-	while (state->bitlen < cnt) {
-		if (state->srccnt == state->srclen) {
-			state->overrun = true;
-			return 0;
-		}
-
-		/* Load 8 more bits */
-		val |= ((uint32_t) state->src[state->srccnt]) << state->bitlen;
-		state->srccnt++;
-		state->bitlen += 8;
-	}
-
-	/* Update bits in the buffer */
-	state->bitbuf = (uint16_t) (val >> cnt);
+	state->bitbuf >>= cnt;
 	state->bitlen -= cnt;
 
-	return ((uint16_t) (val & ((1 << cnt) - 1)));
+	return val;
 }
 
-/** Decode `stored' block
+/** Write a byte to the window
  *
  * @param state Inflate state.
- *
- * @return EOK on success.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
- * @return EINVAL on invalid data.
+ * @param byte  Byte to write.
  *
  */
-static errno_t inflate_stored(inflate_state_t *state)
+static inline void window_put(inflate_stream_t *state, uint8_t byte)
 {
-	/* Discard bits in the bit buffer */
-	state->bitbuf = 0;
-	state->bitlen = 0;
-
-	if (state->srccnt + 4 > state->srclen)
-		return ELIMIT;
-
-	uint16_t len =
-	    state->src[state->srccnt] | (state->src[state->srccnt + 1] << 8);
-	uint16_t len_compl =
-	    state->src[state->srccnt + 2] | (state->src[state->srccnt + 3] << 8);
-
-	/* Check block length and its complement */
-	if (((int16_t) len) != ~((int16_t) len_compl))
-		return EINVAL;
-
-	state->srccnt += 4;
-
-	/* Check input buffer size */
-	if (state->srccnt + len > state->srclen)
-		return ELIMIT;
-
-	/* Check output buffer size */
-	if (state->destcnt + len > state->destlen)
-		return ENOMEM;
+	state->window[state->wpos] = byte;
+	state->wpos = (state->wpos + 1) & WINDOW_MASK;
+	state->pending++;
 
-	/* Copy data */
-	memcpy(state->dest + state->destcnt, state->src + state->srccnt, len);
-	state->srccnt += len;
-	state->destcnt += len;
-
-	return EOK;
+	if (state->whave < WINDOW_SIZE)
+		state->whave++;
 }
 
-/** Decode a symbol using the Huffman code
- *
- * @param state   Inflate state.
- * @param huffman Huffman code.
- * @param symbol  Decoded symbol.
+/** Write bytes to the window
  *
- * @param EOK on success.
- * @param EINVAL on invalid Huffman code.
+ * @param state Inflate state.
+ * @param src   Bytes to write.
+ * @param len   Number of bytes (at most the free space in the window).
  *
  */
-static errno_t huffman_decode(inflate_state_t *state, huffman_t *huffman,
-    uint16_t *symbol)
+static void window_write(inflate_stream_t *state, const uint8_t *src,
+    size_t len)
 {
-	/* Decode bits */
-	uint16_t code = 0;
-
-	/* First code of the given length */
-	size_t first = 0;
-
-	/*
-	 * Index of the first code of the given length
-	 * in the symbol table
-	 */
-	size_t index = 0;
-
-	/* Current number of bits in the code */
-	size_t len;
+	state->pending += len;
+	state->whave += len;
+	if (state->whave > WINDOW_SIZE)
+		state->whave = WINDOW_SIZE;
+
+	while (len > 0) {
+		size_t chunk = WINDOW_SIZE - state->wpos;
+		if (chunk > len)
+			chunk = len;
+
+		memcpy(state->window + state->wpos, src, chunk);
+		state->wpos = (state->wpos + chunk) & WINDOW_MASK;
+		src += chunk;
+		len -= chunk;
+	}
+}
 
-	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
-		/* Get next bit */
-		code |= get_bits(state, 1);
-		CHECK_OVERRUN(*state);
-
-		uint16_t count = huffman->count[len];
-		if (code < first + count) {
-			/* Return decoded symbol */
-			*symbol = huffman->symbol[index + code - first];
-			return EOK;
+/** Copy len bytes from dist bytes back in the window
+ *
+ * @param state Inflate state.
+ * @param dist  Distance (at most the valid bytes in the window).
+ * @param len   Number of bytes (at most MAX_MATCH).
+ *
+ */
+static inline void window_copy(inflate_stream_t *state, size_t dist,
+    size_t len)
+{
+	size_t from = (state->wpos - dist) & WINDOW_MASK;
+
+	if ((dist >= len) && (from + len <= WINDOW_SIZE) &&
+	    (state->wpos + len <= WINDOW_SIZE)) {
+		/* The source and destination do not overlap or wrap */
+		memmove(state->window + state->wpos, state->window + from, len);
+		state->wpos = (state->wpos + len) & WINDOW_MASK;
+	} else {
+		for (size_t i = 0; i < len; i++) {
+			state->window[state->wpos] = state->window[from];
+			state->wpos = (state->wpos + 1) & WINDOW_MASK;
+			from = (from + 1) & WINDOW_MASK;
 		}
-
-		/* Update for next length */
-		index += count;
-		first += count;
-		first <<= 1;
-		code <<= 1;
 	}
 
-	return EINVAL;
+	state->pending += len;
+	state->whave += len;
+	if (state->whave > WINDOW_SIZE)
+		state->whave = WINDOW_SIZE;
+}
+
+/** Move decoded bytes from the window to the output buffer
+ *
+ * @param state Inflate state.
+ *
+ */
+static void window_flush(inflate_stream_t *state)
+{
+	while ((state->pending > 0) && (state->destcnt < state->destlen)) {
+		size_t from = (state->wpos - state->pending) & WINDOW_MASK;
+		size_t chunk = WINDOW_SIZE - from;
+		if (chunk > state->pending)
+			chunk = state->pending;
+		if (chunk > state->destlen - state->destcnt)
+			chunk = state->destlen - state->destcnt;
+
+		memcpy(state->dest + state->destcnt, state->window + from, chunk);
+		state->destcnt += chunk;
+		state->pending -= chunk;
+	}
 }
 
 /** Construct Huffman tables from canonical Huffman code
+ *
+ * Codes not longer than the root index bits are replicated in the root
+ * table, longer codes are placed in second level tables sized to fit
+ * the codes sharing the same root prefix.
  *
  * @param huffman Constructed Huffman tables.
  * @param length  Lengths of the canonical Huffman code.
@@ -367,17 +390,22 @@ static errno_t huffman_decode(inflate_state_t *state, huffman_t *huffman,
  */
 static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
 {
+	size_t root_size = ((size_t) 1) << huffman->root;
+	for (size_t i = 0; i < root_size; i++)
+		huffman->entries[i].kind = HUFFMAN_INVALID;
+
 	/* Count number of codes for each length */
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
 	size_t len;
 	for (len = 0; len <= MAX_HUFFMAN_BIT; len++)
-		huffman->count[len] = 0;
+		count[len] = 0;
 
 	/* We assume that the lengths are within bounds */
 	size_t symbol;
 	for (symbol = 0; symbol < n; symbol++)
-		huffman->count[length[symbol]]++;
+		count[length[symbol]]++;
 
-	if (huffman->count[0] == n) {
+	if (count[0] == n) {
 		/* The code is complete, but decoding will fail */
 		return 0;
 	}
@@ -386,289 +414,705 @@ static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
 	int16_t left = 1;
 	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
 		left <<= 1;
-		left -= huffman->count[len];
+		left -= count[len];
 		if (left < 0) {
 			/* Over-subscribed */
 			return left;
 		}
 	}
 
-	/* Generate offsets into symbol table */
+	/* Sort the symbols by code length */
 	uint16_t offs[MAX_HUFFMAN_BIT + 1];
+	uint16_t sorted[MAX_FIXED_LITLEN];
 
 	offs[1] = 0;
 	for (len = 1; len < MAX_HUFFMAN_BIT; len++)
-		offs[len + 1] = offs[len] + huffman->count[len];
+		offs[len + 1] = offs[len] + count[len];
 
 	for (symbol = 0; symbol < n; symbol++) {
 		if (length[symbol] != 0) {
-			huffman->symbol[offs[length[symbol]]] = symbol;
+			sorted[offs[length[symbol]]] = symbol;
 			offs[length[symbol]]++;
 		}
 	}
 
+	size_t max = MAX_HUFFMAN_BIT;
+	while (count[max] == 0)
+		max--;
+
+	/* Assign the canonical codes in increasing order */
+	uint32_t code = 0;
+	size_t used = root_size;
+	size_t sub_prefix = root_size;
+	size_t sub_base = 0;
+	unsigned int sub_bits = 0;
+	size_t index = 0;
+
+	for (len = 1; len <= max; len++) {
+		for (size_t i = 0; i < count[len]; i++) {
+			/* The input is read starting by the first bit of the code */
+			uint32_t rev = 0;
+			for (size_t bit = 0; bit < len; bit++)
+				rev |= ((code >> bit) & 1) << (len - 1 - bit);
+
+			huffman_entry_t entry = {
+				.value = sorted[index],
+				.bits = len,
+				.kind = HUFFMAN_SYMBOL
+			};
+
+			if (len <= huffman->root) {
+				for (size_t j = rev; j < root_size; j += ((size_t) 1) << len)
+					huffman->entries[j] = entry;
+			} else {
+				size_t prefix = rev & (root_size - 1);
+				if (prefix != sub_prefix) {
+					/*
+					 * Size the second level table to hold all the
+					 * remaining codes with this prefix.
+					 */
+					sub_bits = len - huffman->root;
+					int avail = 1 << sub_bits;
+					while (sub_bits + huffman->root < max) {
+						avail -= count[sub_bits + huffman->root] -
+						    (sub_bits + huffman->root == len ? i : 0);
+						if (avail <= 0)
+							break;
+
+						sub_bits++;
+						avail <<= 1;
+					}
+
+					if (used + (((size_t) 1) << sub_bits) > huffman->size)
+						return -1;
+
+					huffman->entries[prefix].value = used;
+					huffman->entries[prefix].bits = sub_bits;
+					huffman->entries[prefix].kind = HUFFMAN_TABLE;
+
+					sub_prefix = prefix;
+					sub_base = used;
+					used += ((size_t) 1) << sub_bits;
+
+					for (size_t j = sub_base; j < used; j++)
+						huffman->entries[j].kind = HUFFMAN_INVALID;
+				}
+
+				for (size_t j = rev >> huffman->root;
+				    j < (((size_t) 1) << sub_bits);
+				    j += ((size_t) 1) << (len - huffman->root))
+					huffman->entries[sub_base + j] = entry;
+			}
+
+			code++;
+			index++;
+		}
+
+		code <<= 1;
+	}
+
 	return left;
 }
 
-/** Decode literal/length and distance codes
+/** Check for a code consisting of a single symbol
  *
- * Decode until end-of-block code.
+ * Such incomplete code is permitted for both literal/length and
+ * distance codes.
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ * @param length Lengths of the canonical Huffman code.
+ * @param n      Number of lengths.
  *
- * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return True if exactly one length is non-zero.
  *
  */
-static errno_t inflate_codes(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static bool huffman_single(uint16_t *length, size_t n)
 {
-	uint16_t symbol;
+	size_t used = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (length[i] != 0)
+			used++;
+	}
 
-	do {
-		errno_t err = huffman_decode(state, len_code, &symbol);
-		if (err != EOK) {
-			/* Error decoding */
-			return err;
-		}
+	return (used == 1);
+}
 
-		if (symbol < 256) {
-			/* Write out literal */
-			if (state->destcnt == state->destlen)
-				return ENOMEM;
-
-			state->dest[state->destcnt] = (uint8_t) symbol;
-			state->destcnt++;
-		} else if (symbol > 256) {
-			/* Compute length */
-			symbol -= 257;
-			if (symbol >= 29)
-				return EINVAL;
+/** Decode a symbol using the Huffman code
+ *
+ * The bit buffer is not modified, the caller drops the code bits.
+ *
+ * @param huffman Huffman code.
+ * @param bitbuf  Bit buffer.
+ * @param bitlen  Number of valid bits in the bit buffer.
+ * @param symbol  Decoded symbol.
+ * @param len     Length of the decoded code.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid Huffman code.
+ *
+ */
+static inline errno_t huffman_decode(huffman_t *huffman, uint64_t bitbuf,
+    unsigned int bitlen, uint16_t *symbol, unsigned int *len)
+{
+	huffman_entry_t entry =
+	    huffman->entries[bitbuf & ((UINT64_C(1) << huffman->root) - 1)];
 
-			size_t len = lens[symbol] + get_bits(state, lens_ext[symbol]);
-			CHECK_OVERRUN(*state);
+	if (entry.kind == HUFFMAN_TABLE) {
+		entry = huffman->entries[entry.value +
+		    ((bitbuf >> huffman->root) & ((UINT64_C(1) << entry.bits) - 1))];
+	}
 
-			/* Get distance */
-			err = huffman_decode(state, dist_code, &symbol);
-			if (err != EOK)
-				return err;
+	if (entry.kind == HUFFMAN_INVALID)
+		return (bitlen < MAX_HUFFMAN_BIT) ? EAGAIN : EINVAL;
 
-			size_t dist = dists[symbol] + get_bits(state, dists_ext[symbol]);
-			if (dist > state->destcnt)
-				return ENOENT;
+	if (entry.bits > bitlen)
+		return EAGAIN;
 
-			if (state->destcnt + len > state->destlen)
-				return ENOMEM;
+	*symbol = entry.value;
+	*len = entry.bits;
+	return EOK;
+}
 
-			while (len > 0) {
-				/* Copy len bytes from distance bytes back */
-				state->dest[state->destcnt] =
-				    state->dest[state->destcnt - dist];
-				state->destcnt++;
-				len--;
-			}
+/** Decode block header
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid block type.
+ *
+ */
+static errno_t inflate_header(inflate_stream_t *state)
+{
+	if (!need_bits(state, 3))
+		return EAGAIN;
+
+	/* Last block is indicated by a non-zero bit */
+	state->last = get_bits(state, 1);
+
+	/* Block type */
+	switch (get_bits(state, 2)) {
+	case 0:
+		/* Discard bits up to the byte boundary */
+		get_bits(state, state->bitlen & 7);
+		state->mode = INFLATE_STORED;
+		break;
+	case 1:
+		for (size_t i = 0; i < MAX_FIXED_LITLEN; i++) {
+			if (i < 144)
+				state->length[i] = 8;
+			else if (i < 256)
+				state->length[i] = 9;
+			else if (i < 280)
+				state->length[i] = 7;
+			else
+				state->length[i] = 8;
 		}
-	} while (symbol != 256);
+
+		for (size_t i = 0; i < MAX_DIST; i++)
+			state->length[MAX_FIXED_LITLEN + i] = 5;
+
+		state->len_code.root = LEN_ROOT;
+		huffman_construct(&state->len_code, state->length,
+		    MAX_FIXED_LITLEN);
+		huffman_construct(&state->dist_code,
+		    state->length + MAX_FIXED_LITLEN, MAX_DIST);
+
+		state->mode = INFLATE_CODES;
+		break;
+	case 2:
+		state->mode = INFLATE_TABLE;
+		break;
+	default:
+		return EINVAL;
+	}
 
 	return EOK;
 }
 
-/** Decode `fixed codes' block
+/** Decode `stored' block
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ * @param state Inflate state.
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid data.
  *
  */
-static errno_t inflate_fixed(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static errno_t inflate_stored(inflate_stream_t *state)
 {
-	return inflate_codes(state, len_code, dist_code);
+	if (state->mode == INFLATE_STORED) {
+		if (!need_bits(state, 32))
+			return EAGAIN;
+
+		uint16_t len = get_bits(state, 16);
+		uint16_t len_compl = get_bits(state, 16);
+
+		/* Check block length and its complement */
+		if ((uint16_t) (len ^ len_compl) != 0xffff)
+			return EINVAL;
+
+		state->stored = len;
+		state->mode = INFLATE_COPY;
+	}
+
+	/* The bit buffer holds whole bytes of the block */
+	while ((state->stored > 0) && (state->bitlen > 0) &&
+	    (state->pending < WINDOW_SIZE)) {
+		window_put(state, get_bits(state, 8));
+		state->stored--;
+	}
+
+	size_t len = state->stored;
+	if (len > WINDOW_SIZE - state->pending)
+		len = WINDOW_SIZE - state->pending;
+	if (len > state->srclen - state->srccnt)
+		len = state->srclen - state->srccnt;
+
+	window_write(state, state->src + state->srccnt, len);
+	state->srccnt += len;
+	state->stored -= len;
+
+	if (state->stored == 0) {
+		state->mode = state->last ? INFLATE_DONE : INFLATE_HEADER;
+		return EOK;
+	}
+
+	return (state->srccnt == state->srclen) ? EAGAIN : EOK;
 }
 
-/** Decode `dynamic codes' block
+/** Decode literal/length and distance codes
  *
- * @param state     Inflate state.
+ * Decode until end-of-block code or until the window is full.
+ *
+ * @param state Inflate state.
  *
  * @return EOK on success.
+ * @return EAGAIN if more input is needed.
  * @return ENOENT on distance too large.
  * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
  *
  */
-static errno_t inflate_dynamic(inflate_state_t *state)
+static errno_t inflate_codes(inflate_stream_t *state)
 {
-	uint16_t length[MAX_CODE];
-	uint16_t dyn_len_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_len_symbol[MAX_LITLEN];
-	uint16_t dyn_dist_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_dist_symbol[MAX_DIST];
-	huffman_t dyn_len_code;
-	huffman_t dyn_dist_code;
+	while (state->pending <= WINDOW_SIZE - MAX_MATCH) {
+		inflate_refill(state);
 
-	dyn_len_code.count = dyn_len_count;
-	dyn_len_code.symbol = dyn_len_symbol;
+		/* Decode a whole literal or match before dropping any bits */
+		uint64_t bitbuf = state->bitbuf;
+		unsigned int bitlen = state->bitlen;
 
-	dyn_dist_code.count = dyn_dist_count;
-	dyn_dist_code.symbol = dyn_dist_symbol;
+		uint16_t symbol;
+		unsigned int len;
+		errno_t err = huffman_decode(&state->len_code, bitbuf, bitlen,
+		    &symbol, &len);
+		if (err != EOK)
+			return err;
 
-	/* Get number of bits in each table */
-	uint16_t nlen = get_bits(state, 5) + 257;
-	CHECK_OVERRUN(*state);
+		bitbuf >>= len;
+		bitlen -= len;
+
+		if (symbol < 256) {
+			/* Write out literal */
+			state->bitbuf = bitbuf;
+			state->bitlen = bitlen;
+			window_put(state, (uint8_t) symbol);
+			continue;
+		}
+
+		if (symbol == 256) {
+			/* End of block */
+			state->bitbuf = bitbuf;
+			state->bitlen = bitlen;
+			state->mode = state->last ? INFLATE_DONE : INFLATE_HEADER;
+			return EOK;
+		}
+
+		/* Compute length */
+		symbol -= 257;
+		if (symbol >= MAX_LEN)
+			return EINVAL;
+
+		unsigned int ext = lens_ext[symbol];
+		if (bitlen < ext)
+			return EAGAIN;
+
+		size_t copy = lens[symbol] + (bitbuf & ((UINT64_C(1) << ext) - 1));
+		bitbuf >>= ext;
+		bitlen -= ext;
+
+		/* Get distance */
+		err = huffman_decode(&state->dist_code, bitbuf, bitlen, &symbol,
+		    &len);
+		if (err != EOK)
+			return err;
+
+		bitbuf >>= len;
+		bitlen -= len;
+
+		if (symbol >= MAX_DIST)
+			return EINVAL;
 
-	uint16_t ndist = get_bits(state, 5) + 1;
-	CHECK_OVERRUN(*state);
+		ext = dists_ext[symbol];
+		if (bitlen < ext)
+			return EAGAIN;
+
+		size_t dist = dists[symbol] + (bitbuf & ((UINT64_C(1) << ext) - 1));
+		bitbuf >>= ext;
+		bitlen -= ext;
+
+		if (dist > state->whave)
+			return ENOENT;
+
+		state->bitbuf = bitbuf;
+		state->bitlen = bitlen;
+		window_copy(state, dist, copy);
+	}
+
+	return EOK;
+}
+
+/** Decode sizes of the dynamic code tables
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid data.
+ *
+ */
+static errno_t inflate_table(inflate_stream_t *state)
+{
+	if (!need_bits(state, 14))
+		return EAGAIN;
 
-	uint16_t ncode = get_bits(state, 4) + 4;
-	CHECK_OVERRUN(*state);
+	/* Get number of bits in each table */
+	state->nlen = get_bits(state, 5) + 257;
+	state->ndist = get_bits(state, 5) + 1;
+	state->ncode = get_bits(state, 4) + 4;
 
-	if ((nlen > MAX_LITLEN) || (ndist > MAX_DIST) ||
-	    (ncode > MAX_ORDER))
+	if ((state->nlen > MAX_LITLEN) || (state->ndist > MAX_DIST) ||
+	    (state->ncode > MAX_ORDER))
 		return EINVAL;
 
+	state->index = 0;
+	state->mode = INFLATE_LENLENS;
+	return EOK;
+}
+
+/** Decode code length code lengths
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid Huffman code.
+ *
+ */
+static errno_t inflate_lenlens(inflate_stream_t *state)
+{
 	/* Read code length code lengths */
-	uint16_t index;
-	for (index = 0; index < ncode; index++) {
-		length[order[index]] = get_bits(state, 3);
-		CHECK_OVERRUN(*state);
+	while (state->index < state->ncode) {
+		if (!need_bits(state, 3))
+			return EAGAIN;
+
+		state->length[order[state->index]] = get_bits(state, 3);
+		state->index++;
 	}
 
 	/* Set missing lengths to zero */
-	for (index = ncode; index < MAX_ORDER; index++)
-		length[order[index]] = 0;
+	for (uint16_t index = state->ncode; index < MAX_ORDER; index++)
+		state->length[order[index]] = 0;
 
 	/* Build Huffman code */
-	int16_t rc = huffman_construct(&dyn_len_code, length, MAX_ORDER);
+	state->len_code.root = ORDER_ROOT;
+	int16_t rc = huffman_construct(&state->len_code, state->length,
+	    MAX_ORDER);
 	if (rc != 0)
 		return EINVAL;
 
+	state->index = 0;
+	state->mode = INFLATE_CODELENS;
+	return EOK;
+}
+
+/** Decode literal/length and distance code lengths
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid Huffman code or invalid data.
+ *
+ */
+static errno_t inflate_codelens(inflate_stream_t *state)
+{
 	/* Read length/literal and distance code length tables */
-	index = 0;
-	while (index < nlen + ndist) {
+	while (state->index < state->nlen + state->ndist) {
+		inflate_refill(state);
+
 		uint16_t symbol;
-		errno_t err = huffman_decode(state, &dyn_len_code, &symbol);
+		unsigned int len;
+		errno_t err = huffman_decode(&state->len_code, state->bitbuf,
+		    state->bitlen, &symbol, &len);
 		if (err != EOK)
-			return EOK;
+			return err;
 
 		if (symbol < 16) {
-			length[index] = symbol;
-			index++;
+			get_bits(state, len);
+			state->length[state->index] = symbol;
+			state->index++;
+			continue;
+		}
+
+		/* Repeat code with extra bits */
+		unsigned int ext;
+		uint16_t base;
+		if (symbol == 16) {
+			ext = 2;
+			base = 3;
+		} else if (symbol == 17) {
+			ext = 3;
+			base = 3;
 		} else {
-			uint16_t len = 0;
-
-			if (symbol == 16) {
-				if (index == 0)
-					return EINVAL;
-
-				len = length[index - 1];
-				symbol = get_bits(state, 2) + 3;
-				CHECK_OVERRUN(*state);
-			} else if (symbol == 17) {
-				symbol = get_bits(state, 3) + 3;
-				CHECK_OVERRUN(*state);
-			} else {
-				symbol = get_bits(state, 7) + 11;
-				CHECK_OVERRUN(*state);
-			}
+			ext = 7;
+			base = 11;
+		}
+
+		if (state->bitlen < len + ext)
+			return EAGAIN;
+
+		get_bits(state, len);
+		uint16_t repeat = get_bits(state, ext) + base;
 
-			if (index + symbol > nlen + ndist)
+		uint16_t value = 0;
+		if (symbol == 16) {
+			if (state->index == 0)
 				return EINVAL;
 
-			while (symbol > 0) {
-				length[index] = len;
-				index++;
-				symbol--;
-			}
+			value = state->length[state->index - 1];
+		}
+
+		if (state->index + repeat > state->nlen + state->ndist)
+			return EINVAL;
+
+		while (repeat > 0) {
+			state->length[state->index] = value;
+			state->index++;
+			repeat--;
 		}
 	}
 
 	/* Check for end-of-block code */
-	if (length[256] == 0)
+	if (state->length[256] == 0)
 		return EINVAL;
 
 	/* Build Huffman tables for literal/length codes */
-	rc = huffman_construct(&dyn_len_code, length, nlen);
-	if ((rc < 0) || ((rc > 0) && (dyn_len_code.count[0] + 1 != nlen)))
+	state->len_code.root = LEN_ROOT;
+	int16_t rc = huffman_construct(&state->len_code, state->length,
+	    state->nlen);
+	if ((rc < 0) || ((rc > 0) && (!huffman_single(state->length,
+	    state->nlen))))
 		return EINVAL;
 
 	/* Build Huffman tables for distance codes */
-	rc = huffman_construct(&dyn_dist_code, length + nlen, ndist);
-	if ((rc < 0) || ((rc > 0) && (dyn_dist_code.count[0] + 1 != ndist)))
+	rc = huffman_construct(&state->dist_code, state->length + state->nlen,
+	    state->ndist);
+	if ((rc < 0) || ((rc > 0) && (!huffman_single(state->length +
+	    state->nlen, state->ndist))))
 		return EINVAL;
 
-	return inflate_codes(state, &dyn_len_code, &dyn_dist_code);
+	state->mode = INFLATE_CODES;
+	return EOK;
 }
 
-/** Inflate data
+/** Create inflate stream
  *
- * @param src     Source data buffer.
- * @param srclen  Source buffer size (bytes).
- * @param dest    Destination data buffer.
- * @param destlen Destination buffer size (bytes).
+ * @param rstream Place to store pointer to the new stream.
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code or invalid deflate data.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return ENOMEM if out of memory.
  *
  */
-errno_t inflate(void *src, size_t srclen, void *dest, size_t destlen)
+errno_t inflate_stream_create(inflate_stream_t **rstream)
 {
-	/* Initialize the state */
-	inflate_state_t state;
+	inflate_stream_t *stream = malloc(sizeof(inflate_stream_t));
+	if (stream == NULL)
+		return ENOMEM;
+
+	stream->mode = INFLATE_HEADER;
+	stream->last = false;
 
-	state.dest = (uint8_t *) dest;
-	state.destlen = destlen;
-	state.destcnt = 0;
+	stream->bitbuf = 0;
+	stream->bitlen = 0;
 
-	state.src = (uint8_t *) src;
-	state.srclen = srclen;
-	state.srccnt = 0;
+	stream->len_code.entries = stream->len_entries;
+	stream->len_code.size = LEN_ENOUGH;
+	stream->len_code.root = LEN_ROOT;
 
-	state.bitbuf = 0;
-	state.bitlen = 0;
+	stream->dist_code.entries = stream->dist_entries;
+	stream->dist_code.size = DIST_ENOUGH;
+	stream->dist_code.root = DIST_ROOT;
+
+	stream->wpos = 0;
+	stream->whave = 0;
+	stream->pending = 0;
+
+	*rstream = stream;
+	return EOK;
+}
+
+/** Destroy inflate stream
+ *
+ * @param stream Inflate stream.
+ *
+ */
+void inflate_stream_destroy(inflate_stream_t *stream)
+{
+	free(stream);
+}
+
+/** Inflate part of a stream
+ *
+ * Decodes as much of the input as possible and stops when the whole
+ * input has been consumed, the output buffer is full or the last block
+ * has been decoded and output. Decoding continues with the next call.
+ *
+ * @param stream   Inflate stream.
+ * @param src      Source data buffer.
+ * @param srclen   Source buffer size (bytes).
+ * @param consumed Place to store number of bytes consumed from the source.
+ * @param dest     Destination data buffer.
+ * @param destlen  Destination buffer size (bytes).
+ * @param produced Place to store number of bytes written to the
+ *                 destination.
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ *
+ */
+errno_t inflate_stream_process(inflate_stream_t *stream, const void *src,
+    size_t srclen, size_t *consumed, void *dest, size_t destlen,
+    size_t *produced)
+{
+	stream->src = (const uint8_t *) src;
+	stream->srclen = srclen;
+	stream->srccnt = 0;
 
-	state.overrun = false;
+	stream->dest = (uint8_t *) dest;
+	stream->destlen = destlen;
+	stream->destcnt = 0;
 
-	uint16_t last;
 	errno_t ret = EOK;
 
-	do {
-		/* Last block is indicated by a non-zero bit */
-		last = get_bits(&state, 1);
-		CHECK_OVERRUN(state);
+	while (true) {
+		window_flush(stream);
 
-		/* Block type */
-		uint16_t type = get_bits(&state, 2);
-		CHECK_OVERRUN(state);
+		/* Keep room in the window for the longest match */
+		if ((stream->mode == INFLATE_DONE) ||
+		    (stream->pending > WINDOW_SIZE - MAX_MATCH))
+			break;
 
-		switch (type) {
-		case 0:
-			ret = inflate_stored(&state);
+		switch (stream->mode) {
+		case INFLATE_HEADER:
+			ret = inflate_header(stream);
+			break;
+		case INFLATE_STORED:
+		case INFLATE_COPY:
+			ret = inflate_stored(stream);
+			break;
+		case INFLATE_TABLE:
+			ret = inflate_table(stream);
+			break;
+		case INFLATE_LENLENS:
+			ret = inflate_lenlens(stream);
 			break;
-		case 1:
-			ret = inflate_fixed(&state, &len_code, &dist_code);
+		case INFLATE_CODELENS:
+			ret = inflate_codelens(stream);
 			break;
-		case 2:
-			ret = inflate_dynamic(&state);
+		case INFLATE_CODES:
+			ret = inflate_codes(stream);
 			break;
 		default:
 			ret = EINVAL;
 		}
-	} while ((!last) && (ret == 0));
 
+		if (ret != EOK)
+			break;
+	}
+
+	window_flush(stream);
+
+	if (ret == EAGAIN) {
+		/* Running out of input is not an error, it just needs more */
+		ret = EOK;
+	} else {
+		/*
+		 * Return whole bytes which have not been decoded yet to the
+		 * input, so that the data following the deflate stream is
+		 * left to the caller. The most recently loaded bytes are at
+		 * the top of the bit buffer.
+		 *
+		 * More input is only requested when the bit buffer does not
+		 * hold the whole next item, thus all the bytes beyond the end
+		 * of the stream come from this input buffer.
+		 */
+		size_t unused = stream->bitlen >> 3;
+		if (unused > stream->srccnt)
+			unused = stream->srccnt;
+
+		stream->srccnt -= unused;
+		stream->bitlen -= unused << 3;
+		stream->bitbuf &= (UINT64_C(1) << stream->bitlen) - 1;
+	}
+
+	*consumed = stream->srccnt;
+	*produced = stream->destcnt;
+	return ret;
+}
+
+/** Check whether the whole stream has been inflated
+ *
+ * @param stream Inflate stream.
+ *
+ * @return True if the last block has been decoded and output.
+ *
+ */
+bool inflate_stream_done(inflate_stream_t *stream)
+{
+	return ((stream->mode == INFLATE_DONE) && (stream->pending == 0));
+}
+
+/** Inflate data
+ *
+ * @param src     Source data buffer.
+ * @param srclen  Source buffer size (bytes).
+ * @param dest    Destination data buffer.
+ * @param destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ * @return ELIMIT on input buffer overrun.
+ * @return ENOMEM on output buffer overrun or if out of memory.
+ *
+ */
+errno_t inflate(void *src, size_t srclen, void *dest, size_t destlen)
+{
+	inflate_stream_t *stream;
+	errno_t ret = inflate_stream_create(&stream);
+	if (ret != EOK)
+		return ret;
+
+	size_t consumed;
+	size_t produced;
+	ret = inflate_stream_process(stream, src, srclen, &consumed, dest,
+	    destlen, &produced);
+
+	if ((ret == EOK) && (!inflate_stream_done(stream)))
+		ret = (produced == destlen) ? ENOMEM : ELIMIT;
+
+	inflate_stream_destroy(stream);
 	return ret;
 }
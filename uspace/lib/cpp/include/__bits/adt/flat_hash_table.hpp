@@ -0,0 +1,796 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+#define LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+
+#include <__bits/adt/key_extractors.hpp>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Open addressing hash table in the style of Swiss tables.
+     * Elements live directly in one array of slots and every slot
+     * has a control byte in a second array. A full slot's control
+     * byte holds the low seven bits of its hash (h2), while free
+     * slots have the top bit set, so a lookup can compare a whole
+     * group of control bytes against h2 at once and only touches
+     * the slots whose byte matched.
+     *
+     * Groups are eight bytes wide and matched with plain 64-bit
+     * arithmetic (SWAR) instead of vector instructions, as this
+     * has to work on every architecture we support.
+     */
+
+    constexpr uint8_t flat_ctrl_empty{0x80};
+    constexpr uint8_t flat_ctrl_deleted{0xFE};
+
+    inline bool flat_ctrl_is_full(uint8_t ctrl) noexcept
+    {
+        return (ctrl & 0x80) == 0;
+    }
+
+    struct flat_hash_group
+    {
+        static constexpr size_t width{8};
+        static constexpr uint64_t lsbs{0x0101010101010101ULL};
+        static constexpr uint64_t msbs{0x8080808080808080ULL};
+
+        explicit flat_hash_group(const uint8_t* ctrl) noexcept
+            : bytes{}
+        {
+            /**
+             * Note: Assembled byte by byte so that bit 8 * i
+             *       belongs to slot i regardless of endianness,
+             *       compilers turn this into a single load on
+             *       little endian targets.
+             */
+            for (size_t i = 0; i < width; ++i)
+                bytes |= static_cast<uint64_t>(ctrl[i]) << (8 * i);
+        }
+
+        /**
+         * Returns a mask with the top bit of every byte
+         * equal to h2 set. It can also flag the full byte
+         * right above a true match (borrow), callers compare
+         * the keys anyway.
+         */
+        uint64_t match(uint8_t h2) const noexcept
+        {
+            auto x = bytes ^ (lsbs * h2);
+
+            return (x - lsbs) & ~x & msbs;
+        }
+
+        uint64_t match_empty() const noexcept
+        {
+            return bytes & ~(bytes << 6) & msbs;
+        }
+
+        uint64_t match_free() const noexcept
+        {
+            return bytes & ~(bytes << 7) & msbs;
+        }
+
+        static size_t lowest(uint64_t mask) noexcept
+        {
+            return static_cast<size_t>(__builtin_ctzll(mask)) / 8;
+        }
+
+        static uint64_t next(uint64_t mask) noexcept
+        {
+            return mask & (mask - 1);
+        }
+
+        uint64_t bytes;
+    };
+
+    /**
+     * Triangular probing over the groups, which visits
+     * every group once when their count is a power of two.
+     */
+    class flat_hash_probe
+    {
+        public:
+            flat_hash_probe(size_t hash, size_t groups) noexcept
+                : mask_{groups - 1}, group_{hash & mask_}, step_{}
+            { /* DUMMY BODY */ }
+
+            size_t offset() const noexcept
+            {
+                return group_ * flat_hash_group::width;
+            }
+
+            size_t offset(size_t i) const noexcept
+            {
+                return offset() + i;
+            }
+
+            void next() noexcept
+            {
+                ++step_;
+                group_ = (group_ + step_) & mask_;
+            }
+
+        private:
+            size_t mask_;
+            size_t group_;
+            size_t step_;
+    };
+
+    template<class Value, class Reference, class Pointer>
+    class flat_hash_table_iterator
+    {
+        public:
+            using value_type        = Value;
+            using reference         = Reference;
+            using pointer           = Pointer;
+            using difference_type   = ptrdiff_t;
+            using iterator_category = forward_iterator_tag;
+
+            flat_hash_table_iterator()
+                : ctrl_{}, end_{}, slot_{}
+            { /* DUMMY BODY */ }
+
+            flat_hash_table_iterator(const uint8_t* ctrl, const uint8_t* end,
+                                     Pointer slot)
+                : ctrl_{ctrl}, end_{end}, slot_{slot}
+            {
+                skip_free_();
+            }
+
+            template<class Ref, class Ptr>
+            flat_hash_table_iterator(
+                const flat_hash_table_iterator<Value, Ref, Ptr>& other
+            )
+                : ctrl_{other.ctrl()}, end_{other.end()}, slot_{other.slot()}
+            { /* DUMMY BODY */ }
+
+            reference operator*() const
+            {
+                return *slot_;
+            }
+
+            pointer operator->() const
+            {
+                return slot_;
+            }
+
+            flat_hash_table_iterator& operator++()
+            {
+                ++ctrl_;
+                ++slot_;
+                skip_free_();
+
+                return *this;
+            }
+
+            flat_hash_table_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+            const uint8_t* ctrl() const
+            {
+                return ctrl_;
+            }
+
+            const uint8_t* end() const
+            {
+                return end_;
+            }
+
+            pointer slot() const
+            {
+                return slot_;
+            }
+
+        private:
+            const uint8_t* ctrl_;
+            const uint8_t* end_;
+            pointer slot_;
+
+            void skip_free_()
+            {
+                while (ctrl_ != end_ && !flat_ctrl_is_full(*ctrl_))
+                {
+                    ++ctrl_;
+                    ++slot_;
+                }
+            }
+    };
+
+    template<class Value, class Ref1, class Ptr1, class Ref2, class Ptr2>
+    bool operator==(const flat_hash_table_iterator<Value, Ref1, Ptr1>& lhs,
+                    const flat_hash_table_iterator<Value, Ref2, Ptr2>& rhs)
+    {
+        return lhs.ctrl() == rhs.ctrl();
+    }
+
+    template<class Value, class Ref1, class Ptr1, class Ref2, class Ptr2>
+    bool operator!=(const flat_hash_table_iterator<Value, Ref1, Ptr1>& lhs,
+                    const flat_hash_table_iterator<Value, Ref2, Ptr2>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<
+        class Value, class Key, class KeyExtractor,
+        class Hasher, class KeyEq, class Alloc
+    >
+    class flat_hash_table
+    {
+        public:
+            using value_type     = Value;
+            using key_type       = Key;
+            using size_type      = size_t;
+            using allocator_type = Alloc;
+            using key_equal      = KeyEq;
+            using hasher         = Hasher;
+            using key_extract    = KeyExtractor;
+
+            using iterator       = flat_hash_table_iterator<
+                value_type, value_type&, value_type*
+            >;
+            using const_iterator = flat_hash_table_iterator<
+                value_type, const value_type&, const value_type*
+            >;
+
+            flat_hash_table(size_type capacity, const hasher& hf,
+                            const key_equal& eql, const allocator_type& alloc)
+                : ctrl_{}, slots_{}, capacity_{}, size_{}, growth_left_{},
+                  hasher_{hf}, key_eq_{eql}, key_extractor_{}, allocator_{alloc}
+            {
+                if (capacity > 0)
+                    reserve(capacity);
+            }
+
+            flat_hash_table(const flat_hash_table& other)
+                : flat_hash_table{0, other.hasher_, other.key_eq_, other.allocator_}
+            {
+                if (other.size_ == 0)
+                    return;
+
+                /**
+                 * Same capacity means same positions, so we copy
+                 * the control bytes and construct the elements in
+                 * place instead of inserting them one by one.
+                 * Tombstones are copied as well, otherwise they
+                 * would end the probe sequences of later elements.
+                 */
+                allocate_(other.capacity_);
+                for (size_type i = 0; i < capacity_; ++i)
+                {
+                    if (flat_ctrl_is_full(other.ctrl_[i]))
+                    {
+                        alloc_traits::construct(allocator_, slots_ + i, other.slots_[i]);
+                        ++size_;
+                    }
+                    ctrl_[i] = other.ctrl_[i];
+                }
+                growth_left_ = other.growth_left_;
+            }
+
+            flat_hash_table(flat_hash_table&& other)
+                : ctrl_{other.ctrl_}, slots_{other.slots_},
+                  capacity_{other.capacity_}, size_{other.size_},
+                  growth_left_{other.growth_left_}, hasher_{move(other.hasher_)},
+                  key_eq_{move(other.key_eq_)}, key_extractor_{},
+                  allocator_{move(other.allocator_)}
+            {
+                other.ctrl_ = nullptr;
+                other.slots_ = nullptr;
+                other.capacity_ = size_type{};
+                other.size_ = size_type{};
+                other.growth_left_ = size_type{};
+            }
+
+            flat_hash_table& operator=(const flat_hash_table& other)
+            {
+                flat_hash_table tmp{other};
+                tmp.swap(*this);
+
+                return *this;
+            }
+
+            flat_hash_table& operator=(flat_hash_table&& other)
+            {
+                flat_hash_table tmp{move(other)};
+                tmp.swap(*this);
+
+                return *this;
+            }
+
+            ~flat_hash_table()
+            {
+                destroy_();
+            }
+
+            bool empty() const noexcept
+            {
+                return size_ == 0;
+            }
+
+            size_type size() const noexcept
+            {
+                return size_;
+            }
+
+            size_type max_size() const noexcept
+            {
+                return alloc_traits::max_size(allocator_);
+            }
+
+            size_type capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            allocator_type get_allocator() const noexcept
+            {
+                return allocator_;
+            }
+
+            hasher hash_function() const
+            {
+                return hasher_;
+            }
+
+            key_equal key_eq() const
+            {
+                return key_eq_;
+            }
+
+            iterator begin() noexcept
+            {
+                return iterator{ctrl_, ctrl_ + capacity_, slots_};
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return const_iterator{ctrl_, ctrl_ + capacity_, slots_};
+            }
+
+            iterator end() noexcept
+            {
+                return iterator{ctrl_ + capacity_, ctrl_ + capacity_,
+                                slots_ + capacity_};
+            }
+
+            const_iterator end() const noexcept
+            {
+                return const_iterator{ctrl_ + capacity_, ctrl_ + capacity_,
+                                      slots_ + capacity_};
+            }
+
+            template<class K>
+            iterator find(const K& key)
+            {
+                auto idx = find_(key, hasher_(key));
+                if (idx == capacity_)
+                    return end();
+
+                return iterator_at_(idx);
+            }
+
+            template<class K>
+            const_iterator find(const K& key) const
+            {
+                auto idx = find_(key, hasher_(key));
+                if (idx == capacity_)
+                    return end();
+
+                return const_iterator{ctrl_ + idx, ctrl_ + capacity_, slots_ + idx};
+            }
+
+            /**
+             * Inserts an element with the given key unless the table
+             * already has one, the element is created by calling
+             * construct with a pointer to the uninitialized slot.
+             */
+            template<class K, class Constructor>
+            pair<iterator, bool> insert_unique(const K& key, Constructor&& construct)
+            {
+                auto hash = hasher_(key);
+                auto idx = find_(key, hash);
+                if (idx != capacity_)
+                    return make_pair(iterator_at_(idx), false);
+
+                idx = prepare_insert_(hash);
+                construct(slots_ + idx);
+                finish_insert_(idx, hash);
+
+                return make_pair(iterator_at_(idx), true);
+            }
+
+            template<class... Args>
+            pair<iterator, bool> emplace(Args&&... args)
+            {
+                value_type val(forward<Args>(args)...);
+
+                return insert_unique(
+                    key_extractor_(val),
+                    [this, &val](value_type* slot){
+                        alloc_traits::construct(allocator_, slot, move(val));
+                    }
+                );
+            }
+
+            pair<iterator, bool> insert(const value_type& val)
+            {
+                return insert_unique(
+                    key_extractor_(val),
+                    [this, &val](value_type* slot){
+                        alloc_traits::construct(allocator_, slot, val);
+                    }
+                );
+            }
+
+            pair<iterator, bool> insert(value_type&& val)
+            {
+                return insert_unique(
+                    key_extractor_(val),
+                    [this, &val](value_type* slot){
+                        alloc_traits::construct(allocator_, slot, move(val));
+                    }
+                );
+            }
+
+            iterator erase(const_iterator it)
+            {
+                auto idx = static_cast<size_type>(it.ctrl() - ctrl_);
+                erase_at_(idx);
+
+                return iterator_at_(idx);
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                auto idx = static_cast<size_type>(first.ctrl() - ctrl_);
+                auto end_idx = static_cast<size_type>(last.ctrl() - ctrl_);
+
+                for (; idx < end_idx; ++idx)
+                {
+                    if (flat_ctrl_is_full(ctrl_[idx]))
+                        erase_at_(idx);
+                }
+
+                return iterator_at_(end_idx);
+            }
+
+            template<class K>
+            size_type erase_key(const K& key)
+            {
+                auto idx = find_(key, hasher_(key));
+                if (idx == capacity_)
+                    return 0;
+
+                erase_at_(idx);
+
+                return 1;
+            }
+
+            void clear() noexcept
+            {
+                for (size_type i = 0; i < capacity_; ++i)
+                {
+                    if (flat_ctrl_is_full(ctrl_[i]))
+                        alloc_traits::destroy(allocator_, slots_ + i);
+                    ctrl_[i] = flat_ctrl_empty;
+                }
+
+                size_ = size_type{};
+                growth_left_ = growth_(capacity_);
+            }
+
+            void swap(flat_hash_table& other)
+            {
+                std::swap(ctrl_, other.ctrl_);
+                std::swap(slots_, other.slots_);
+                std::swap(capacity_, other.capacity_);
+                std::swap(size_, other.size_);
+                std::swap(growth_left_, other.growth_left_);
+                std::swap(hasher_, other.hasher_);
+                std::swap(key_eq_, other.key_eq_);
+                std::swap(allocator_, other.allocator_);
+            }
+
+            /**
+             * Makes sure count elements fit without
+             * growing the table.
+             */
+            void reserve(size_type count)
+            {
+                if (count <= size_ + growth_left_)
+                    return;
+
+                resize_(capacity_for_(count));
+            }
+
+            /**
+             * Rebuilds the table with room for at least count
+             * elements (and no less than the current size), which
+             * also drops tombstones left behind by erase.
+             */
+            void rehash(size_type count)
+            {
+                if (count < size_)
+                    count = size_;
+
+                if (count == 0 && size_ == 0)
+                {
+                    destroy_();
+                    return;
+                }
+
+                resize_(capacity_for_(count));
+            }
+
+            float load_factor() const noexcept
+            {
+                if (capacity_ == 0)
+                    return 0.f;
+
+                return size_ / static_cast<float>(capacity_);
+            }
+
+            float max_load_factor() const noexcept
+            {
+                return 7.f / 8.f;
+            }
+
+        private:
+            using alloc_traits = allocator_traits<allocator_type>;
+
+            uint8_t* ctrl_;
+            value_type* slots_;
+            size_type capacity_;
+            size_type size_;
+            size_type growth_left_;
+            hasher hasher_;
+            key_equal key_eq_;
+            key_extract key_extractor_;
+            allocator_type allocator_;
+
+            static constexpr size_type min_capacity_{2 * flat_hash_group::width};
+
+            static uint8_t h2_(size_t hash) noexcept
+            {
+                return static_cast<uint8_t>(hash & 0x7F);
+            }
+
+            static size_t h1_(size_t hash) noexcept
+            {
+                return hash >> 7;
+            }
+
+            /**
+             * Keeps the load factor at or below 7/8.
+             */
+            static size_type growth_(size_type capacity) noexcept
+            {
+                return capacity - capacity / 8;
+            }
+
+            static size_type capacity_for_(size_type count) noexcept
+            {
+                size_type res{min_capacity_};
+                while (growth_(res) < count)
+                    res *= 2;
+
+                return res;
+            }
+
+            iterator iterator_at_(size_type idx) noexcept
+            {
+                return iterator{ctrl_ + idx, ctrl_ + capacity_, slots_ + idx};
+            }
+
+            template<class K>
+            size_type find_(const K& key, size_t hash) const
+            {
+                if (capacity_ == 0)
+                    return capacity_;
+
+                auto h2 = h2_(hash);
+                flat_hash_probe probe{h1_(hash), capacity_ / flat_hash_group::width};
+
+                while (true)
+                {
+                    flat_hash_group group{ctrl_ + probe.offset()};
+
+                    for (auto mask = group.match(h2); mask;
+                         mask = flat_hash_group::next(mask))
+                    {
+                        auto idx = probe.offset(flat_hash_group::lowest(mask));
+                        if (key_eq_(key_extractor_(slots_[idx]), key))
+                            return idx;
+                    }
+
+                    /**
+                     * Inserts fill the first free slot of a probe
+                     * sequence, so the key cannot be further than
+                     * a group that has never been full.
+                     */
+                    if (group.match_empty())
+                        return capacity_;
+
+                    probe.next();
+                }
+            }
+
+            size_type find_free_(size_t hash) const noexcept
+            {
+                flat_hash_probe probe{h1_(hash), capacity_ / flat_hash_group::width};
+
+                while (true)
+                {
+                    flat_hash_group group{ctrl_ + probe.offset()};
+
+                    auto mask = group.match_free();
+                    if (mask)
+                        return probe.offset(flat_hash_group::lowest(mask));
+
+                    probe.next();
+                }
+            }
+
+            size_type prepare_insert_(size_t hash)
+            {
+                auto idx = capacity_;
+                if (capacity_ > 0)
+                    idx = find_free_(hash);
+
+                /**
+                 * Reusing a tombstone never costs growth,
+                 * only taking an empty slot does.
+                 */
+                if (growth_left_ == 0 && (idx == capacity_ ||
+                    ctrl_[idx] == flat_ctrl_empty))
+                {
+                    grow_();
+                    idx = find_free_(hash);
+                }
+
+                return idx;
+            }
+
+            void finish_insert_(size_type idx, size_t hash) noexcept
+            {
+                if (ctrl_[idx] == flat_ctrl_empty)
+                    --growth_left_;
+
+                ctrl_[idx] = h2_(hash);
+                ++size_;
+            }
+
+            void erase_at_(size_type idx)
+            {
+                alloc_traits::destroy(allocator_, slots_ + idx);
+                --size_;
+
+                /**
+                 * A group that still has an empty slot has never
+                 * been full, so no probe went past it and the slot
+                 * can become empty again. Otherwise it has to stay
+                 * a tombstone to keep longer probe sequences intact.
+                 */
+                auto start = idx - idx % flat_hash_group::width;
+                flat_hash_group group{ctrl_ + start};
+                if (group.match_empty())
+                {
+                    ctrl_[idx] = flat_ctrl_empty;
+                    ++growth_left_;
+                }
+                else
+                    ctrl_[idx] = flat_ctrl_deleted;
+            }
+
+            void grow_()
+            {
+                /**
+                 * If tombstones take up most of the growth
+                 * budget, rehashing in place is enough.
+                 */
+                if (capacity_ == 0)
+                    resize_(min_capacity_);
+                else if (size_ <= growth_(capacity_) / 2)
+                    resize_(capacity_);
+                else
+                    resize_(capacity_ * 2);
+            }
+
+            void allocate_(size_type capacity)
+            {
+                ctrl_ = new uint8_t[capacity];
+                slots_ = alloc_traits::allocate(allocator_, capacity);
+                capacity_ = capacity;
+                growth_left_ = growth_(capacity);
+
+                for (size_type i = 0; i < capacity; ++i)
+                    ctrl_[i] = flat_ctrl_empty;
+            }
+
+            void deallocate_(uint8_t* ctrl, value_type* slots, size_type capacity)
+            {
+                if (!ctrl)
+                    return;
+
+                delete[] ctrl;
+                alloc_traits::deallocate(allocator_, slots, capacity);
+            }
+
+            void resize_(size_type capacity)
+            {
+                auto old_ctrl = ctrl_;
+                auto old_slots = slots_;
+                auto old_capacity = capacity_;
+
+                allocate_(capacity);
+
+                for (size_type i = 0; i < old_capacity; ++i)
+                {
+                    if (!flat_ctrl_is_full(old_ctrl[i]))
+                        continue;
+
+                    auto hash = hasher_(key_extractor_(old_slots[i]));
+                    auto idx = find_free_(hash);
+
+                    alloc_traits::construct(allocator_, slots_ + idx,
+                                            move(old_slots[i]));
+                    alloc_traits::destroy(allocator_, old_slots + i);
+
+                    ctrl_[idx] = h2_(hash);
+                    --growth_left_;
+                }
+
+                deallocate_(old_ctrl, old_slots, old_capacity);
+            }
+
+            void destroy_()
+            {
+                clear();
+                deallocate_(ctrl_, slots_, capacity_);
+
+                ctrl_ = nullptr;
+                slots_ = nullptr;
+                capacity_ = size_type{};
+                growth_left_ = size_type{};
+            }
+    };
+}
+
+#endif
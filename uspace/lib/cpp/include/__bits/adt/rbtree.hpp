@@ -370,25 +370,27 @@ namespace std::aux
                     update_root_(succ); // Incase the first in list was root.
                     return succ;
                 }
-                else if (node == root_)
-                { // Only executed if root_ is unique.
-                    root_ = nullptr;
-                    delete node;
-
-                    return nullptr;
-                }
 
                 if (node->left() && node->right())
                 {
+                    /**
+                     * The successor is the smallest node
+                     * in the right subtree, so it cannot
+                     * be nullptr here.
+                     */
                     node->swap(succ);
-                    if (succ && !succ->parent())
+                    if (!succ->parent())
                         root_ = succ;
 
                     // Node now has at most one child.
-                    // Also: If succ was nullptr, the swap
-                    //       didn't do anything and we can
-                    //       safely delete node.
-                    return delete_node(node);
+                }
+
+                if (node == root_ && !node->left() && !node->right())
+                { // Only executed if root_ is unique.
+                    root_ = nullptr;
+                    delete node;
+
+                    return nullptr;
                 }
 
                 auto child = node->right() ? node->right() : node->left();
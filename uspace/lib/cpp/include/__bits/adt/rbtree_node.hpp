@@ -222,6 +222,25 @@ namespace std::aux
             auto right2 = node2->right();
             auto is_right2 = is_right_child(node2);
 
+            /**
+             * If one of the nodes is the parent of the
+             * other, the links between them have to point
+             * to the node that takes their place.
+             */
+            if (parent1 == node2)
+                parent1 = node1;
+            if (left1 == node2)
+                left1 = node1;
+            if (right1 == node2)
+                right1 = node1;
+
+            if (parent2 == node1)
+                parent2 = node2;
+            if (left2 == node1)
+                left2 = node2;
+            if (right2 == node1)
+                right2 = node2;
+
             assimilate(node1, parent2, left2, right2, is_right2);
             assimilate(node2, parent1, left1, right1, is_right1);
         }
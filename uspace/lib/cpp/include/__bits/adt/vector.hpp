@@ -30,9 +30,11 @@
 #define LIBCPP_BITS_ADT_VECTOR
 
 #include <algorithm>
+#include <cstring>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace std
@@ -68,40 +70,42 @@ namespace std
             { /* DUMMY BODY */ }
 
             explicit vector(size_type n, const Allocator& alloc = Allocator{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{}, size_{}, capacity_{n}, allocator_{alloc}
             {
                 data_ = allocator_.allocate(capacity_);
 
-                for (size_type i = 0; i < size_; ++i)
-                    allocator_traits<Allocator>::construct(allocator_, data_ + i);
+                for (; size_ < n; ++size_)
+                    alloc_traits::construct(allocator_, data_ + size_);
             }
 
             vector(size_type n, const T& val, const Allocator& alloc = Allocator{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{}, size_{}, capacity_{n}, allocator_{alloc}
             {
                 data_ = allocator_.allocate(capacity_);
 
-                for (size_type i = 0; i < size_; ++i)
-                    data_[i] = val;
+                for (; size_ < n; ++size_)
+                    alloc_traits::construct(allocator_, data_ + size_, val);
             }
 
             template<class InputIterator>
             vector(InputIterator first, InputIterator last,
                    const Allocator& alloc = Allocator{})
+                : vector{alloc}
             {
-                // TODO: research constraints and provide multiple
-                //       implementations via enable_if
+                /**
+                 * Note: vector<int>(5, 3) ends up here, so two
+                 *       integers mean size and value.
+                 */
+                if constexpr (is_integral<InputIterator>::value)
+                    insert(end(), static_cast<size_type>(first),
+                           static_cast<value_type>(last));
+                else
+                    insert(end(), first, last);
             }
 
             vector(const vector& other)
-                : data_{nullptr}, size_{other.size_}, capacity_{other.capacity_},
-                  allocator_{other.allocator_}
-            {
-                data_ = allocator_.allocate(capacity_);
-
-                for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
-            }
+                : vector{other, other.allocator_}
+            { /* DUMMY BODY */ }
 
             vector(vector&& other) noexcept
                 : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_},
@@ -113,30 +117,28 @@ namespace std
             }
 
             vector(const vector& other, const Allocator& alloc)
-                : data_{nullptr}, size_{other.size_}, capacity_{other.capacity_},
+                : data_{nullptr}, size_{}, capacity_{other.size_},
                   allocator_{alloc}
             {
                 data_ = allocator_.allocate(capacity_);
 
-                for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
+                copy_construct_(other.data_, other.data_ + other.size_, data_);
+                size_ = other.size_;
             }
 
             vector(initializer_list<T> init, const Allocator& alloc = Allocator{})
-                : data_{nullptr}, size_{init.size()}, capacity_{init.size()},
+                : data_{nullptr}, size_{}, capacity_{init.size()},
                   allocator_{alloc}
             {
                 data_ = allocator_.allocate(capacity_);
 
-                auto it = init.begin();
-                for (size_type i = 0; it != init.end(); ++i, ++it)
-                {
-                    data_[i] = *it;
-                }
+                copy_construct_(init.begin(), init.end(), data_);
+                size_ = init.size();
             }
 
             ~vector()
             {
+                clear();
                 allocator_.deallocate(data_, capacity_);
             }
 
@@ -153,9 +155,11 @@ namespace std
                          allocator_traits<Allocator>::is_always_equal::value)
             {
                 if (data_)
+                {
+                    clear();
                     allocator_.deallocate(data_, capacity_);
+                }
 
-                // TODO: test this
                 data_ = other.data_;
                 size_ = other.size_;
                 capacity_ = other.capacity_;
@@ -179,7 +183,7 @@ namespace std
             template<class InputIterator>
             void assign(InputIterator first, InputIterator last)
             {
-                vector tmp{first, last};
+                vector tmp(first, last);
                 swap(tmp);
             }
 
@@ -274,16 +278,30 @@ namespace std
 
             void resize(size_type sz)
             {
-                resize_with_copy_(size_, capacity_);
+                if (sz <= size_)
+                {
+                    destroy_from_end_until_(begin() + sz);
+                    size_ = sz;
+
+                    return;
+                }
+
+                if (sz > capacity_)
+                    reallocate_(next_capacity_(sz));
+
+                for (; size_ < sz; ++size_)
+                    alloc_traits::construct(allocator_, data_ + size_);
             }
 
             void resize(size_type sz, const value_type& val)
             {
-                auto old_size = size_;
-                resize_with_copy_(sz, capacity_);
-
-                for (size_type i = old_size - 1; i < size_; ++i)
-                    data_[i] = val;
+                if (sz <= size_)
+                {
+                    destroy_from_end_until_(begin() + sz);
+                    size_ = sz;
+                }
+                else
+                    insert(end(), sz - size_, val);
             }
 
             size_type capacity() const noexcept
@@ -302,12 +320,13 @@ namespace std
                 //       length_error (this function shall have no
                 //       effect in such case)
                 if (new_capacity > capacity_)
-                    resize_with_copy_(size_, new_capacity);
+                    reallocate_(new_capacity);
             }
 
             void shrink_to_fit()
             {
-                resize_with_copy_(size_, size_);
+                if (capacity_ > size_)
+                    reallocate_(size_);
             }
 
             reference operator[](size_type idx)
@@ -356,7 +375,7 @@ namespace std
 
             const_reference back() const
             {
-                return at(size - 1);
+                return at(size_ - 1);
             }
 
             T* data() noexcept
@@ -372,27 +391,31 @@ namespace std
             template<class... Args>
             reference emplace_back(Args&&... args)
             {
-                if (size_ >= capacity_)
-                    resize_with_copy_(size_, next_capacity_());
-
-                allocator_traits<Allocator>::construct(allocator_,
-                                                       begin() + size_, forward<Args>(args)...);
+                if (size_ < capacity_)
+                {
+                    alloc_traits::construct(allocator_, data_ + size_,
+                                            forward<Args>(args)...);
+                    ++size_;
+                }
+                else
+                {
+                    reallocate_insert_(size_, 1, [&](value_type* target){
+                        alloc_traits::construct(allocator_, target,
+                                                forward<Args>(args)...);
+                    });
+                }
 
                 return back();
             }
 
             void push_back(const T& x)
             {
-                if (size_ >= capacity_)
-                    resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = x;
+                emplace_back(x);
             }
 
             void push_back(T&& x)
             {
-                if (size_ >= capacity_)
-                    resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = forward<T>(x);
+                emplace_back(forward<T>(x));
             }
 
             void pop_back()
@@ -404,83 +427,167 @@ namespace std
             template<class... Args>
             iterator emplace(const_iterator position, Args&&... args)
             {
-                auto pos = const_cast<iterator>(position);
+                auto idx = index_of_(position);
 
-                pos = shift_(pos, 1);
-                allocator_.construct(pos, forward<Args>(args)...);
+                if (idx == size_)
+                {
+                    emplace_back(forward<Args>(args)...);
 
-                return pos;
+                    return begin() + idx;
+                }
+
+                /**
+                 * The arguments may refer to elements that
+                 * are about to be shifted, so the new element
+                 * is built before anything moves.
+                 */
+                value_type tmp(forward<Args>(args)...);
+
+                return insert(position, move(tmp));
             }
 
             iterator insert(const_iterator position, const value_type& x)
             {
-                auto pos = const_cast<iterator>(position);
-
-                pos = shift_(pos, 1);
-                *pos = x;
-
-                return pos;
+                return insert(position, size_type{1}, x);
             }
 
             iterator insert(const_iterator position, value_type&& x)
             {
-                auto pos = const_cast<iterator>(position);
+                auto idx = index_of_(position);
 
-                pos = shift_(pos, 1);
-                *pos = forward<value_type>(x);
+                if (size_ < capacity_)
+                {
+                    open_gap_(idx, 1);
+                    alloc_traits::construct(allocator_, data_ + idx,
+                                            forward<value_type>(x));
+                    ++size_;
+                }
+                else
+                {
+                    reallocate_insert_(idx, 1, [&](value_type* target){
+                        alloc_traits::construct(allocator_, target,
+                                                forward<value_type>(x));
+                    });
+                }
 
-                return pos;
+                return begin() + idx;
             }
 
             iterator insert(const_iterator position, size_type count, const value_type& x)
             {
-                auto pos = const_cast<iterator>(position);
+                auto idx = index_of_(position);
+                if (count == 0)
+                    return begin() + idx;
+
+                if (size_ + count <= capacity_)
+                {
+                    if (aliases_(x))
+                    {
+                        value_type tmp(x);
 
-                pos = shift_(pos, count);
-                auto copy_target = pos;
-                for (size_type i = 0; i < count; ++i)
-                    *copy_target++ = x;
+                        return insert(position, count, tmp);
+                    }
 
-                return pos;
+                    open_gap_(idx, count);
+                    for (size_type i = 0; i < count; ++i)
+                        alloc_traits::construct(allocator_, data_ + idx + i, x);
+                    size_ += count;
+                }
+                else
+                {
+                    reallocate_insert_(idx, count, [&](value_type* target){
+                        for (size_type i = 0; i < count; ++i)
+                            alloc_traits::construct(allocator_, target + i, x);
+                    });
+                }
+
+                return begin() + idx;
             }
 
             template<class InputIterator>
             iterator insert(const_iterator position, InputIterator first,
                             InputIterator last)
             {
-                auto pos = const_cast<iterator>(position);
-                auto count = static_cast<size_type>(last - first);
-
-                pos = shift_(pos, count);
-                copy(first, last, pos);
-
-                return pos;
+                if constexpr (is_integral<InputIterator>::value)
+                {
+                    return insert(position, static_cast<size_type>(first),
+                                  static_cast<value_type>(last));
+                }
+                else if constexpr (is_base_of<
+                    forward_iterator_tag,
+                    typename iterator_traits<InputIterator>::iterator_category
+                >::value)
+                {
+                    auto idx = index_of_(position);
+                    auto count = static_cast<size_type>(distance(first, last));
+
+                    if (size_ + count <= capacity_)
+                    {
+                        open_gap_(idx, count);
+                        copy_construct_(first, last, data_ + idx);
+                        size_ += count;
+                    }
+                    else
+                    {
+                        reallocate_insert_(idx, count, [&](value_type* target){
+                            copy_construct_(first, last, target);
+                        });
+                    }
+
+                    return begin() + idx;
+                }
+                else
+                {
+                    /**
+                     * Single pass iterators, append at the end
+                     * and rotate the new elements into place.
+                     */
+                    auto idx = index_of_(position);
+                    auto old_size = size_;
+
+                    while (first != last)
+                        emplace_back(*first++);
+                    rotate(begin() + idx, begin() + old_size, end());
+
+                    return begin() + idx;
+                }
             }
 
             iterator insert(const_iterator position, initializer_list<T> init)
             {
-                auto pos = const_cast<iterator>(position);
-
-                pos = shift_(pos, init.size());
-                copy(init.begin(), init.end(), pos);
-
-                return pos;
+                return insert(position, init.begin(), init.end());
             }
 
             iterator erase(const_iterator position)
             {
-                iterator pos = const_cast<iterator>(position);
-                copy(position + 1, cend(), pos);
-                --size_;
-
-                return pos;
+                return erase(position, position + 1);
             }
 
             iterator erase(const_iterator first, const_iterator last)
             {
                 iterator pos = const_cast<iterator>(first);
-                copy(last, cend(), pos);
-                size_ -= static_cast<size_type>(last - first);
+                auto count = static_cast<size_type>(last - first);
+                if (count == 0)
+                    return pos;
+
+                if constexpr (trivially_relocatable_)
+                {
+                    /**
+                     * Nothing to destroy, the tail
+                     * just slides over the gap.
+                     */
+                    memmove(
+                        static_cast<void*>(pos), static_cast<const void*>(last),
+                        static_cast<size_type>(cend() - last) * sizeof(value_type)
+                    );
+                    size_ -= count;
+                }
+                else
+                {
+                    auto new_end = move(const_cast<iterator>(last), end(), pos);
+                    destroy_from_end_until_(new_end);
+                    size_ -= count;
+                }
 
                 return pos;
             }
@@ -507,45 +614,166 @@ namespace std
             size_type capacity_;
             allocator_type allocator_;
 
-            void resize_without_copy_(size_type capacity)
-            {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+            using alloc_traits = allocator_traits<Allocator>;
 
-                data_ = allocator_.allocate(capacity);
-                size_ = 0;
-                capacity_ = capacity;
+            /**
+             * Trivially copyable elements can be moved around
+             * with memcpy/memmove, which also leaves nothing
+             * behind that would need to be destroyed.
+             */
+            static constexpr bool trivially_relocatable_{
+                is_trivially_copyable<value_type>::value
+            };
+
+            size_type index_of_(const_iterator position) const noexcept
+            {
+                return static_cast<size_type>(position - cbegin());
             }
 
-            void resize_with_copy_(size_type size, size_type capacity)
+            bool aliases_(const value_type& x) const noexcept
             {
-                if (size < size_)
-                    destroy_from_end_until_(begin() + size);
+                return data_ && &x >= data_ && &x < data_ + size_;
+            }
 
-                if(capacity_ == 0 || capacity_ < capacity)
+            template<class InputIterator>
+            void copy_construct_(InputIterator first, InputIterator last,
+                                 value_type* target)
+            {
+                if constexpr (trivially_relocatable_ && is_pointer<InputIterator>::value &&
+                              is_same<remove_cv_t<typename remove_pointer<InputIterator>::type>,
+                                      value_type>::value)
                 {
-                    auto new_data = allocator_.allocate(capacity);
+                    if (first != last)
+                    {
+                        memcpy(
+                            static_cast<void*>(target), static_cast<const void*>(first),
+                            static_cast<size_type>(last - first) * sizeof(value_type)
+                        );
+                    }
+                }
+                else
+                {
+                    while (first != last)
+                        alloc_traits::construct(allocator_, target++, *first++);
+                }
+            }
 
-                    auto to_copy = min(size, size_);
-                    for (size_type i = 0; i < to_copy; ++i)
-                        new_data[i] = move(data_[i]);
+            /**
+             * Moves the elements in [first, last) to the uninitialized
+             * storage at target and destroys the originals. Elements
+             * whose move constructor might throw are copied (all of them
+             * before any original is destroyed), so that a failure leaves
+             * the source untouched.
+             */
+            void relocate_(value_type* first, value_type* last, value_type* target)
+            {
+                if (first == last)
+                    return;
 
-                    std::swap(data_, new_data);
+                if constexpr (trivially_relocatable_)
+                {
+                    memmove(
+                        static_cast<void*>(target), static_cast<const void*>(first),
+                        static_cast<size_type>(last - first) * sizeof(value_type)
+                    );
+                }
+                else if constexpr (is_nothrow_move_constructible<value_type>::value ||
+                                   !is_copy_constructible<value_type>::value)
+                {
+                    for (; first != last; ++first, ++target)
+                    {
+                        alloc_traits::construct(allocator_, target, move(*first));
+                        alloc_traits::destroy(allocator_, first);
+                    }
+                }
+                else
+                {
+                    auto it = first;
+                    for (; it != last; ++it, ++target)
+                        alloc_traits::construct(allocator_, target, *it);
 
-                    allocator_.deallocate(new_data, capacity_);
+                    for (it = first; it != last; ++it)
+                        alloc_traits::destroy(allocator_, it);
                 }
+            }
+
+            void reallocate_(size_type capacity)
+            {
+                auto new_data = allocator_.allocate(capacity);
+
+                relocate_(data_, data_ + size_, new_data);
 
+                if (data_)
+                    allocator_.deallocate(data_, capacity_);
+                data_ = new_data;
                 capacity_ = capacity;
-                size_ = size;
+            }
+
+            /**
+             * Grows the storage to make room for count new elements
+             * at idx. The new elements are constructed (by calling
+             * construct with their location) before the old ones
+             * move, so they can be copies of existing elements,
+             * and if that fails the vector stays as it was.
+             */
+            template<class Constructor>
+            void reallocate_insert_(size_type idx, size_type count,
+                                    Constructor&& construct)
+            {
+                auto new_capacity = next_capacity_(size_ + count);
+                auto new_data = allocator_.allocate(new_capacity);
+
+                construct(new_data + idx);
+
+                relocate_(data_, data_ + idx, new_data);
+                relocate_(data_ + idx, data_ + size_, new_data + idx + count);
+
+                if (data_)
+                    allocator_.deallocate(data_, capacity_);
+                data_ = new_data;
+                size_ += count;
+                capacity_ = new_capacity;
+            }
+
+            /**
+             * Shifts the elements from idx onwards count places
+             * to the right, leaving uninitialized storage at
+             * [idx, idx + count). Requires enough capacity.
+             */
+            void open_gap_(size_type idx, size_type count)
+            {
+                if constexpr (trivially_relocatable_)
+                {
+                    if (idx < size_)
+                    {
+                        memmove(
+                            static_cast<void*>(data_ + idx + count),
+                            static_cast<const void*>(data_ + idx),
+                            (size_ - idx) * sizeof(value_type)
+                        );
+                    }
+                }
+                else
+                {
+                    for (auto i = size_; i > idx; --i)
+                    {
+                        alloc_traits::construct(allocator_, data_ + i - 1 + count,
+                                                move(data_[i - 1]));
+                        alloc_traits::destroy(allocator_, data_ + i - 1);
+                    }
+                }
             }
 
             void destroy_from_end_until_(iterator target)
             {
+                if constexpr (is_trivially_destructible<value_type>::value)
+                    return;
+
                 if (!empty())
                 {
                     auto last = end();
                     while(last != target)
-                        allocator_traits<Allocator>::destroy(allocator_, --last);
+                        alloc_traits::destroy(allocator_, --last);
                 }
             }
 
@@ -556,39 +784,6 @@ namespace std
                 else
                     return max(capacity_ * 2, size_type{2u});
             }
-
-            iterator shift_(iterator position, size_type count)
-            {
-                if (size_ + count < capacity_)
-                {
-                    copy_backward(position, end(), end() + count);
-                    size_ += count;
-
-                    return position;
-                }
-                else
-                {
-                    auto start_idx = static_cast<size_type>(position - begin());
-                    auto end_idx = start_idx + count;
-                    auto new_size = size_ + count;
-
-                    // Auxiliary vector for easier swap.
-                    vector tmp{};
-                    tmp.resize_without_copy_(max(new_size, capacity_));
-                    tmp.size_ = new_size;
-
-                    // Copy before insertion index.
-                    copy(begin(), begin() + start_idx, tmp.begin());
-
-                    // Copy after insertion index.
-                    copy(begin() + start_idx, end(), tmp.begin() + end_idx);
-
-                    swap(tmp);
-
-                    // Position was invalidated!
-                    return begin() + start_idx;
-                }
-            }
     };
 
     template<class T, class Alloc>
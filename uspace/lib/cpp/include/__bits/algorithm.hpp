@@ -30,6 +30,7 @@
 #define LIBCPP_BITS_ALGORITHM
 
 #include <iterator>
+#include <new>
 #include <utility>
 
 namespace std
@@ -653,7 +654,44 @@ namespace std
      * 25.3.11, rotate:
      */
 
-    // TODO: implement
+    template<class ForwardIterator>
+    ForwardIterator rotate(ForwardIterator first, ForwardIterator middle,
+                           ForwardIterator last)
+    {
+        if (first == middle)
+            return last;
+        if (middle == last)
+            return first;
+
+        /**
+         * Swap the first block into place, then keep rotating
+         * whatever is left over until both blocks line up.
+         */
+        auto it = middle;
+        while (true)
+        {
+            iter_swap(first++, it);
+
+            if (++it == last)
+                break;
+            if (first == middle)
+                middle = it;
+        }
+
+        auto res = first;
+        it = middle;
+        while (first != middle)
+        {
+            iter_swap(first++, it);
+
+            if (++it == last)
+                it = middle;
+            else if (first == middle)
+                middle = it;
+        }
+
+        return res;
+    }
 
     /**
      * 25.3.12, shuffle:
@@ -687,6 +725,179 @@ namespace std
     void sort_heap(RandomAccessIterator, RandomAccessIterator,
                    Compare);
 
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
+
+    namespace aux
+    {
+        template<class RandomAccessIterator, class Size, class Compare>
+        void correct_children(RandomAccessIterator, Size, Size, Compare);
+
+        /**
+         * Ranges this short are left to insertion sort,
+         * which beats partitioning on small inputs.
+         */
+        constexpr ptrdiff_t sort_threshold{16};
+
+        template<class Size>
+        Size sort_depth_limit(Size count)
+        {
+            Size res{};
+            while (count > 1)
+            {
+                count /= 2;
+                ++res;
+            }
+
+            return 2 * res;
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void insertion_sort(RandomAccessIterator first,
+                            RandomAccessIterator last, Compare comp)
+        {
+            if (first == last)
+                return;
+
+            for (auto it = first + 1; it != last; ++it)
+            {
+                auto tmp = move(*it);
+                auto hole = it;
+
+                while (hole != first && comp(tmp, *(hole - 1)))
+                {
+                    *hole = move(*(hole - 1));
+                    --hole;
+                }
+
+                *hole = move(tmp);
+            }
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void move_median_to_first(RandomAccessIterator res,
+                                  RandomAccessIterator a,
+                                  RandomAccessIterator b,
+                                  RandomAccessIterator c,
+                                  Compare comp)
+        {
+            if (comp(*a, *b))
+            {
+                if (comp(*b, *c))
+                    iter_swap(res, b);
+                else if (comp(*a, *c))
+                    iter_swap(res, c);
+                else
+                    iter_swap(res, a);
+            }
+            else if (comp(*a, *c))
+                iter_swap(res, a);
+            else if (comp(*b, *c))
+                iter_swap(res, c);
+            else
+                iter_swap(res, b);
+        }
+
+        /**
+         * Partitions [first, last) around the median of
+         * three samples and returns the split point. Every
+         * element before it is not greater than every element
+         * after it. The median guarantees there is an element
+         * stopping each scan, so the inner loops need no bound
+         * checks. Requires at least three elements.
+         */
+        template<class RandomAccessIterator, class Compare>
+        RandomAccessIterator partition_pivot(RandomAccessIterator first,
+                                             RandomAccessIterator last,
+                                             Compare comp)
+        {
+            auto mid = first + (last - first) / 2;
+            move_median_to_first(first, first + 1, mid, last - 1, comp);
+
+            auto lo = first + 1;
+            auto hi = last;
+            while (true)
+            {
+                while (comp(*lo, *first))
+                    ++lo;
+                --hi;
+                while (comp(*first, *hi))
+                    --hi;
+
+                if (!(lo < hi))
+                    return lo;
+
+                iter_swap(lo, hi);
+                ++lo;
+            }
+        }
+
+        /**
+         * Leaves the middle - first smallest elements of
+         * [first, last) in [first, middle) arranged as a heap.
+         */
+        template<class RandomAccessIterator, class Compare>
+        void heap_select(RandomAccessIterator first,
+                         RandomAccessIterator middle,
+                         RandomAccessIterator last, Compare comp)
+        {
+            make_heap(first, middle, comp);
+
+            auto count = middle - first;
+            for (auto it = middle; it < last; ++it)
+            {
+                if (comp(*it, *first))
+                {
+                    swap(*it, *first);
+                    correct_children(first, decltype(count){}, count, comp);
+                }
+            }
+        }
+
+        template<class RandomAccessIterator, class Size, class Compare>
+        void introsort_loop(RandomAccessIterator first,
+                            RandomAccessIterator last,
+                            Size depth, Compare comp)
+        {
+            while (last - first > sort_threshold)
+            {
+                if (depth == 0)
+                {
+                    /**
+                     * Partitioning keeps going badly, switch
+                     * to heap sort to keep the O(n log n) bound.
+                     */
+                    make_heap(first, last, comp);
+                    sort_heap(first, last, comp);
+
+                    return;
+                }
+                --depth;
+
+                /**
+                 * Recurse into the smaller part and loop on the
+                 * larger one, so that the stack stays logarithmic.
+                 */
+                auto cut = partition_pivot(first, last, comp);
+                if (cut - first < last - cut)
+                {
+                    introsort_loop(first, cut, depth, comp);
+                    first = cut;
+                }
+                else
+                {
+                    introsort_loop(cut, last, depth, comp);
+                    last = cut;
+                }
+            }
+        }
+    }
+
     template<class RandomAccessIterator>
     void sort(RandomAccessIterator first, RandomAccessIterator last)
     {
@@ -700,29 +911,185 @@ namespace std
               Compare comp)
     {
         /**
-         * Note: This isn't the most effective approach,
-         *       but since we already have these two functions
-         *       and they satisfy asymptotic limitations
-         *       imposed by the standard, we're using them at
-         *       the moment. Might be good to change it to qsort
-         *       or merge sort later.
+         * Introsort: quicksort with median of three pivots that
+         * falls back to heap sort when the recursion gets too
+         * deep. Short subranges are left unsorted and finished
+         * by a single insertion sort pass at the end, which
+         * only ever moves elements within their subrange.
          */
+        auto count = last - first;
+        if (count < 2)
+            return;
 
-        make_heap(first, last, comp);
-        sort_heap(first, last, comp);
+        aux::introsort_loop(first, last, aux::sort_depth_limit(count), comp);
+        aux::insertion_sort(first, last, comp);
     }
 
     /**
      * 25.4.1.2, stable_sort:
      */
 
-    // TODO: implement
+    namespace aux
+    {
+        /**
+         * Merges [first, middle) and [middle, last) using
+         * a buffer that can hold the first of them.
+         */
+        template<class RandomAccessIterator, class T, class Compare>
+        void merge_buffered(RandomAccessIterator first,
+                            RandomAccessIterator middle,
+                            RandomAccessIterator last,
+                            T* buffer, Compare comp)
+        {
+            auto count = middle - first;
+            for (decltype(count) i = 0; i < count; ++i)
+                ::new(static_cast<void*>(buffer + i)) T(move(first[i]));
+
+            auto lhs = buffer;
+            auto lhs_end = buffer + count;
+            auto rhs = middle;
+            auto res = first;
+            while (lhs != lhs_end && rhs != last)
+            {
+                if (comp(*rhs, *lhs))
+                    *res++ = move(*rhs++);
+                else
+                    *res++ = move(*lhs++);
+            }
+
+            while (lhs != lhs_end)
+                *res++ = move(*lhs++);
+
+            for (decltype(count) i = 0; i < count; ++i)
+                buffer[i].~T();
+        }
+
+        /**
+         * Stable merge without a buffer. Splits the longer
+         * run in half, finds where its middle element belongs
+         * in the other run and rotates the two inner blocks
+         * into place, O(n log n) per merge.
+         */
+        template<class RandomAccessIterator, class Compare>
+        void merge_in_place(RandomAccessIterator first,
+                            RandomAccessIterator middle,
+                            RandomAccessIterator last, Compare comp)
+        {
+            auto len1 = middle - first;
+            auto len2 = last - middle;
+            if (len1 == 0 || len2 == 0)
+                return;
+
+            if (len1 + len2 == 2)
+            {
+                if (comp(*middle, *first))
+                    iter_swap(first, middle);
+
+                return;
+            }
+
+            RandomAccessIterator cut1, cut2;
+            if (len1 > len2)
+            {
+                cut1 = first + len1 / 2;
+                cut2 = lower_bound(middle, last, *cut1, comp);
+            }
+            else
+            {
+                cut2 = middle + len2 / 2;
+                cut1 = upper_bound(first, middle, *cut2, comp);
+            }
+
+            auto new_middle = rotate(cut1, middle, cut2);
+            merge_in_place(first, cut1, new_middle, comp);
+            merge_in_place(new_middle, cut2, last, comp);
+        }
+
+        template<class RandomAccessIterator, class T, class Compare>
+        void merge_sort(RandomAccessIterator first,
+                        RandomAccessIterator last,
+                        T* buffer, Compare comp)
+        {
+            if (last - first <= sort_threshold)
+            {
+                insertion_sort(first, last, comp);
+
+                return;
+            }
+
+            auto middle = first + (last - first) / 2;
+            merge_sort(first, middle, buffer, comp);
+            merge_sort(middle, last, buffer, comp);
+
+            // Already ordered runs are common, skip the merge.
+            if (!comp(*middle, *(middle - 1)))
+                return;
+
+            if (buffer)
+                merge_buffered(first, middle, last, buffer, comp);
+            else
+                merge_in_place(first, middle, last, comp);
+        }
+    }
+
+    template<class RandomAccessIterator>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        stable_sort(first, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last,
+                     Compare comp)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        auto count = last - first;
+        if (count < 2)
+            return;
+
+        /**
+         * Merges only ever buffer their left run, which is
+         * at most half of the range. If we cannot get that
+         * much memory we merge in place, which is slower
+         * but still stable.
+         */
+        auto size = static_cast<size_t>((count + 1) / 2) * sizeof(value_type);
+        auto buffer = static_cast<value_type*>(::operator new(size, nothrow));
+
+        aux::merge_sort(first, last, buffer, comp);
+
+        if (buffer)
+            ::operator delete(buffer);
+    }
 
     /**
      * 25.4.1.3, partial_sort:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        partial_sort(first, middle, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last, Compare comp)
+    {
+        if (first == middle)
+            return;
+
+        aux::heap_select(first, middle, last, comp);
+        sort_heap(first, middle, comp);
+    }
 
     /**
      * 25.4.1.4, partial_sort_copy:
@@ -734,29 +1101,18 @@ namespace std
      * 25.4.1.5, is_sorted:
      */
 
-    template<class ForwardIterator>
-    bool is_sorted(ForwardIterator first, ForwardIterator last)
-    {
-        return is_sorted_until(first, last) == last;
-    }
-
-    template<class ForwardIterator, class Comp>
-    bool is_sorted(ForwardIterator first, ForwardIterator last,
-                   Comp comp)
-    {
-        return is_sorted_until(first, last, comp) == last;
-    }
-
     template<class ForwardIterator>
     ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last)
     {
-        if (distance(first, last) < 2)
+        if (first == last)
             return last;
 
-        while (first != last)
+        auto next = first;
+        while (++next != last)
         {
-            if (*first > *(++first))
-                return first;
+            if (*next < *first)
+                return next;
+            first = next;
         }
 
         return last;
@@ -766,23 +1122,82 @@ namespace std
     ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last,
                                     Comp comp)
     {
-        if (distance(first, last) < 2)
+        if (first == last)
             return last;
 
-        while (first != last)
+        auto next = first;
+        while (++next != last)
         {
-            if (!comp(*first, *(++first)))
-                return first;
+            if (comp(*next, *first))
+                return next;
+            first = next;
         }
 
         return last;
     }
 
+    template<class ForwardIterator>
+    bool is_sorted(ForwardIterator first, ForwardIterator last)
+    {
+        return is_sorted_until(first, last) == last;
+    }
+
+    template<class ForwardIterator, class Comp>
+    bool is_sorted(ForwardIterator first, ForwardIterator last,
+                   Comp comp)
+    {
+        return is_sorted_until(first, last, comp) == last;
+    }
+
     /**
      * 25.4.2, nth_element:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        nth_element(first, nth, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last, Compare comp)
+    {
+        if (first == last || nth == last)
+            return;
+
+        /**
+         * Introselect: same partitioning as sort, but only
+         * the part containing nth is processed further.
+         */
+        auto depth = aux::sort_depth_limit(last - first);
+        while (last - first > aux::sort_threshold)
+        {
+            if (depth == 0)
+            {
+                /**
+                 * The largest of the nth + 1 smallest elements
+                 * ends up at the top of the selected heap.
+                 */
+                aux::heap_select(first, nth + 1, last, comp);
+                iter_swap(first, nth);
+
+                return;
+            }
+            --depth;
+
+            auto cut = aux::partition_pivot(first, last, comp);
+            if (cut <= nth)
+                first = cut;
+            else
+                last = cut;
+        }
+
+        aux::insertion_sort(first, last, comp);
+    }
 
     /**
      * 25.4.3, binary search:
@@ -792,13 +1207,75 @@ namespace std
      * 25.4.3.1, lower_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        return lower_bound(
+            first, last, value,
+            [](const auto& lhs, const auto& rhs){ return lhs < rhs; }
+        );
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto step = count / 2;
+            auto it = first;
+            advance(it, step);
+
+            if (comp(*it, value))
+            {
+                first = ++it;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.2, upper_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        return upper_bound(
+            first, last, value,
+            [](const auto& lhs, const auto& rhs){ return lhs < rhs; }
+        );
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto step = count / 2;
+            auto it = first;
+            advance(it, step);
+
+            if (!comp(value, *it))
+            {
+                first = ++it;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.3, equal_range:
@@ -883,32 +1360,22 @@ namespace std
             using aux::heap_left_child;
             using aux::heap_right_child;
 
-            auto left = heap_left_child(idx);
-            auto right = heap_right_child(idx);
-
-            bool left_incorrect{comp(first[idx], first[left])};
-            bool right_incorrect{comp(first[idx], first[right])};
-            while ((left < count && left_incorrect) ||
-                   (right < count && right_incorrect))
+            while (true)
             {
-                if (right >= count || (left_incorrect && comp(first[right], first[left])))
-                {
-                    swap(first[idx], first[left]);
-
-                    idx = left;
-                }
-                else if (right < count && right_incorrect)
-                {
-                    swap(first[idx], first[right]);
+                auto left = heap_left_child(idx);
+                auto right = heap_right_child(idx);
+                auto largest = idx;
 
-                    idx = right;
-                } // Else should not happen because of the while condition.
+                if (left < count && comp(first[largest], first[left]))
+                    largest = left;
+                if (right < count && comp(first[largest], first[right]))
+                    largest = right;
 
-                left = heap_left_child(idx);
-                right = heap_right_child(idx);
+                if (largest == idx)
+                    return;
 
-                left_incorrect = comp(first[idx], first[left]);
-                right_incorrect = comp(first[idx], first[right]);
+                swap(first[idx], first[largest]);
+                idx = largest;
             }
         }
     }
@@ -971,7 +1438,7 @@ namespace std
             return;
 
         swap(first[0], first[count - 1]);
-        aux::correct_children(first, decltype(count){}, count - 2, comp);
+        aux::correct_children(first, decltype(count){}, count - 1, comp);
     }
 
     /**
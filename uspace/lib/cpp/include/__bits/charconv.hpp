@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_CHARCONV
+#define LIBCPP_BITS_CHARCONV
+
+#include <__bits/system_error.hpp>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace std
+{
+    /**
+     * C++17, primitive numeric conversions:
+     */
+
+    enum class chars_format
+    {
+        scientific = 0x1,
+        fixed      = 0x2,
+        hex        = 0x4,
+        general    = fixed | scientific
+    };
+
+    struct to_chars_result
+    {
+        char* ptr;
+        errc ec;
+    };
+
+    struct from_chars_result
+    {
+        const char* ptr;
+        errc ec;
+    };
+
+    namespace aux
+    {
+        inline constexpr char charconv_digits[] =
+            "0123456789abcdefghijklmnopqrstuvwxyz";
+
+        inline constexpr char charconv_upper_digits[] =
+            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+        inline constexpr char charconv_pairs[] =
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+
+        /**
+         * Writes the digits of v backwards so that they end at last
+         * and returns a pointer to the first digit. The caller has
+         * to provide room for 8 * sizeof(T) digits.
+         * Note: Base 10 goes two digits per division, the other
+         *       power of two bases use shifts.
+         */
+        template<class T>
+        char* format_unsigned(char* last, T v, int base = 10, bool upper = false)
+        {
+            static_assert(is_unsigned_v<T>);
+
+            if (base == 10)
+            {
+                while (v >= 100)
+                {
+                    auto idx = static_cast<unsigned>(v % 100) * 2;
+                    v /= 100;
+
+                    *--last = charconv_pairs[idx + 1];
+                    *--last = charconv_pairs[idx];
+                }
+
+                if (v >= 10)
+                {
+                    auto idx = static_cast<unsigned>(v) * 2;
+
+                    *--last = charconv_pairs[idx + 1];
+                    *--last = charconv_pairs[idx];
+                }
+                else
+                    *--last = static_cast<char>('0' + v);
+
+                return last;
+            }
+
+            const char* digits = upper ? charconv_upper_digits : charconv_digits;
+            if ((base & (base - 1)) == 0)
+            {
+                unsigned shift = 0;
+                while ((1 << shift) < base)
+                    ++shift;
+
+                T mask = static_cast<T>(base - 1);
+                do
+                {
+                    *--last = digits[v & mask];
+                    v >>= shift;
+                } while (v != 0);
+
+                return last;
+            }
+
+            T b = static_cast<T>(base);
+            do
+            {
+                *--last = digits[v % b];
+                v /= b;
+            } while (v != 0);
+
+            return last;
+        }
+
+        template<class T>
+        to_chars_result to_chars_integer(char* first, char* last, T value, int base)
+        {
+            using unsigned_type = make_unsigned_t<T>;
+
+            if (base < 2 || base > 36)
+                return {last, errc::invalid_argument};
+
+            unsigned_type uvalue = static_cast<unsigned_type>(value);
+            bool negative{};
+            if constexpr (is_signed_v<T>)
+            {
+                if (value < 0)
+                {
+                    negative = true;
+                    uvalue = static_cast<unsigned_type>(0) - uvalue;
+                }
+            }
+
+            char buffer[8 * sizeof(T)];
+            char* end = buffer + sizeof(buffer);
+            char* start = format_unsigned(end, uvalue, base);
+
+            auto len = static_cast<size_t>(end - start);
+            if (static_cast<size_t>(last - first) < len + negative)
+                return {last, errc::value_too_large};
+
+            if (negative)
+                *first++ = '-';
+            std::memcpy(first, start, len);
+
+            return {first + len, errc{}};
+        }
+
+        inline int charconv_digit_value(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            else if (c >= 'a' && c <= 'z')
+                return c - 'a' + 10;
+            else if (c >= 'A' && c <= 'Z')
+                return c - 'A' + 10;
+            else
+                return 36;
+        }
+
+        template<class T>
+        from_chars_result from_chars_integer(const char* first, const char* last,
+                                             T& value, int base)
+        {
+            using unsigned_type = make_unsigned_t<T>;
+
+            if (base < 2 || base > 36)
+                return {first, errc::invalid_argument};
+
+            auto it = first;
+            bool negative{};
+            if constexpr (is_signed_v<T>)
+            {
+                if (it != last && *it == '-')
+                {
+                    negative = true;
+                    ++it;
+                }
+            }
+
+            auto digits_begin = it;
+            unsigned_type result{};
+            bool overflow{};
+            unsigned_type b = static_cast<unsigned_type>(base);
+            unsigned_type max = static_cast<unsigned_type>(~unsigned_type{});
+
+            for (; it != last; ++it)
+            {
+                int d = charconv_digit_value(*it);
+                if (d >= base)
+                    break;
+
+                if (result > (max - static_cast<unsigned_type>(d)) / b)
+                    overflow = true;
+                else
+                    result = result * b + static_cast<unsigned_type>(d);
+            }
+
+            if (it == digits_begin)
+                return {first, errc::invalid_argument};
+
+            if constexpr (is_signed_v<T>)
+            {
+                unsigned_type limit = static_cast<unsigned_type>(
+                    std::numeric_limits<T>::max()
+                ) + (negative ? 1 : 0);
+
+                if (result > limit)
+                    overflow = true;
+            }
+
+            if (overflow)
+                return {it, errc::result_out_of_range};
+
+            if (negative)
+                value = static_cast<T>(static_cast<unsigned_type>(0) - result);
+            else
+                value = static_cast<T>(result);
+
+            return {it, errc{}};
+        }
+    }
+
+    template<class T>
+    enable_if_t<is_integral<T>::value && !is_same_v<T, bool>, to_chars_result>
+    to_chars(char* first, char* last, T value, int base = 10)
+    {
+        return aux::to_chars_integer(first, last, value, base);
+    }
+
+    to_chars_result to_chars(char* first, char* last, bool value, int base = 10) = delete;
+
+    /**
+     * Note: Without a precision these produce the shortest string
+     *       that reads back to the same value. General picks the shorter
+     *       of the fixed and scientific forms, preferring fixed on a tie.
+     *       Hex is not supported and long double goes through double.
+     */
+
+    to_chars_result to_chars(char* first, char* last, double value);
+    to_chars_result to_chars(char* first, char* last, double value,
+                             chars_format fmt);
+    to_chars_result to_chars(char* first, char* last, float value);
+    to_chars_result to_chars(char* first, char* last, float value,
+                             chars_format fmt);
+
+    inline to_chars_result to_chars(char* first, char* last, long double value)
+    {
+        return to_chars(first, last, static_cast<double>(value));
+    }
+
+    inline to_chars_result to_chars(char* first, char* last, long double value,
+                                    chars_format fmt)
+    {
+        return to_chars(first, last, static_cast<double>(value), fmt);
+    }
+
+    template<class T>
+    enable_if_t<is_integral<T>::value && !is_same_v<T, bool>, from_chars_result>
+    from_chars(const char* first, const char* last, T& value, int base = 10)
+    {
+        return aux::from_chars_integer(first, last, value, base);
+    }
+}
+
+#endif
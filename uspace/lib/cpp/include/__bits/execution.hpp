@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_EXECUTION
+#define LIBCPP_BITS_EXECUTION
+
+#include <__bits/algorithm.hpp>
+#include <__bits/functional/arithmetic_operations.hpp>
+#include <__bits/numeric.hpp>
+#include <__bits/thread/executor.hpp>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace std
+{
+    /**
+     * C++17, execution policies:
+     */
+
+    namespace execution
+    {
+        class sequenced_policy
+        { /* DUMMY BODY */ };
+
+        class parallel_policy
+        { /* DUMMY BODY */ };
+
+        class parallel_unsequenced_policy
+        { /* DUMMY BODY */ };
+
+        inline constexpr sequenced_policy seq{};
+        inline constexpr parallel_policy par{};
+        inline constexpr parallel_unsequenced_policy par_unseq{};
+    }
+
+    template<class T>
+    struct is_execution_policy: false_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::sequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_unsequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<class T>
+    inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+    namespace aux
+    {
+        template<class ExecutionPolicy, class R>
+        using enable_if_policy_t = enable_if_t<
+            is_execution_policy_v<decay_t<ExecutionPolicy>>, R
+        >;
+
+        /**
+         * Only random access ranges are split, anything
+         * else runs sequentially no matter the policy.
+         */
+        template<class ExecutionPolicy, class... Iterators>
+        inline constexpr bool runs_parallel_v =
+            !is_same_v<decay_t<ExecutionPolicy>, execution::sequenced_policy> &&
+            (is_base_of_v<
+                random_access_iterator_tag,
+                typename iterator_traits<Iterators>::iterator_category
+             > && ...);
+
+        /**
+         * Ranges shorter than this are not worth splitting
+         * (or splitting further).
+         */
+        inline constexpr size_t parallel_min_chunk{4096};
+
+        inline size_t parallel_chunk_count(size_t count, executor& exec)
+        {
+            /**
+             * A few chunks per worker, so that the ones that
+             * finish early can steal from the slower ones.
+             */
+            auto chunks = exec.workers() * 4;
+            auto max_chunks = count / parallel_min_chunk;
+
+            return max_chunks < chunks ? (max_chunks ? max_chunks : 1) : chunks;
+        }
+
+        /**
+         * Calls fn(begin, end, idx) for each of the chunks
+         * [begin, end) of [0, count) in parallel, the calling
+         * fibril runs the first chunk itself.
+         */
+        template<class Function>
+        void parallel_chunks(size_t count, size_t chunks, Function fn)
+        {
+            if (chunks <= 1)
+            {
+                fn(size_t{}, count, size_t{});
+
+                return;
+            }
+
+            task_group group{};
+            for (size_t i = 1; i < chunks; ++i)
+            {
+                auto begin = count * i / chunks;
+                auto end = count * (i + 1) / chunks;
+
+                group.run([&fn, begin, end, i](){
+                    fn(begin, end, i);
+                });
+            }
+
+            fn(size_t{}, count / chunks, size_t{});
+            group.wait();
+        }
+    }
+
+    /**
+     * 25.2.4, for_each:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class Function>
+    aux::enable_if_policy_t<ExecutionPolicy, void>
+    for_each(ExecutionPolicy&&, ForwardIterator first,
+             ForwardIterator last, Function f)
+    {
+        if constexpr (aux::runs_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            auto count = static_cast<size_t>(last - first);
+            auto chunks = aux::parallel_chunk_count(count, aux::executor::instance());
+
+            aux::parallel_chunks(count, chunks, [&](size_t begin, size_t end, size_t){
+                for (auto it = first + begin; it != first + end; ++it)
+                    f(*it);
+            });
+        }
+        else
+            for_each(first, last, f);
+    }
+
+    /**
+     * 25.3.4, transform:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator1,
+             class ForwardIterator2, class UnaryOperation>
+    aux::enable_if_policy_t<ExecutionPolicy, ForwardIterator2>
+    transform(ExecutionPolicy&&, ForwardIterator1 first,
+              ForwardIterator1 last, ForwardIterator2 result,
+              UnaryOperation op)
+    {
+        if constexpr (aux::runs_parallel_v<ExecutionPolicy, ForwardIterator1,
+                                           ForwardIterator2>)
+        {
+            auto count = static_cast<size_t>(last - first);
+            auto chunks = aux::parallel_chunk_count(count, aux::executor::instance());
+
+            aux::parallel_chunks(count, chunks, [&](size_t begin, size_t end, size_t){
+                transform(first + begin, first + end, result + begin, op);
+            });
+
+            return result + count;
+        }
+        else
+            return transform(first, last, result, op);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator1, class ForwardIterator2,
+             class ForwardIterator3, class BinaryOperation>
+    aux::enable_if_policy_t<ExecutionPolicy, ForwardIterator3>
+    transform(ExecutionPolicy&&, ForwardIterator1 first1,
+              ForwardIterator1 last1, ForwardIterator2 first2,
+              ForwardIterator3 result, BinaryOperation op)
+    {
+        if constexpr (aux::runs_parallel_v<ExecutionPolicy, ForwardIterator1,
+                                           ForwardIterator2, ForwardIterator3>)
+        {
+            auto count = static_cast<size_t>(last1 - first1);
+            auto chunks = aux::parallel_chunk_count(count, aux::executor::instance());
+
+            aux::parallel_chunks(count, chunks, [&](size_t begin, size_t end, size_t){
+                transform(first1 + begin, first1 + end, first2 + begin,
+                          result + begin, op);
+            });
+
+            return result + count;
+        }
+        else
+            return transform(first1, last1, first2, result, op);
+    }
+
+    /**
+     * C++17, reduce:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator,
+             class T, class BinaryOperation>
+    aux::enable_if_policy_t<ExecutionPolicy, T>
+    reduce(ExecutionPolicy&&, ForwardIterator first,
+           ForwardIterator last, T init, BinaryOperation op)
+    {
+        if constexpr (aux::runs_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            auto count = static_cast<size_t>(last - first);
+            auto chunks = aux::parallel_chunk_count(count, aux::executor::instance());
+            if (chunks <= 1)
+                return reduce(first, last, init, op);
+
+            /**
+             * Every chunk starts with its first element, so
+             * we do not need an identity of the operation.
+             */
+            auto partials = static_cast<T*>(::operator new(chunks * sizeof(T)));
+            aux::parallel_chunks(count, chunks, [&](size_t begin, size_t end, size_t idx){
+                ::new(static_cast<void*>(partials + idx)) T(
+                    reduce(first + begin + 1, first + end, T(first[begin]), op)
+                );
+            });
+
+            auto acc{init};
+            for (size_t i = 0; i < chunks; ++i)
+            {
+                acc = op(acc, move(partials[i]));
+                partials[i].~T();
+            }
+            ::operator delete(partials);
+
+            return acc;
+        }
+        else
+            return reduce(first, last, init, op);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator, class T>
+    aux::enable_if_policy_t<ExecutionPolicy, T>
+    reduce(ExecutionPolicy&& policy, ForwardIterator first,
+           ForwardIterator last, T init)
+    {
+        return reduce(
+            forward<ExecutionPolicy>(policy), first, last, init, plus<>{}
+        );
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator>
+    aux::enable_if_policy_t<
+        ExecutionPolicy, typename iterator_traits<ForwardIterator>::value_type
+    >
+    reduce(ExecutionPolicy&& policy, ForwardIterator first, ForwardIterator last)
+    {
+        using value_type = typename iterator_traits<ForwardIterator>::value_type;
+
+        return reduce(forward<ExecutionPolicy>(policy), first, last, value_type{});
+    }
+
+    /**
+     * 25.4.1.1, sort:
+     */
+
+    template<class ExecutionPolicy, class RandomAccessIterator, class Compare>
+    aux::enable_if_policy_t<ExecutionPolicy, void>
+    sort(ExecutionPolicy&&, RandomAccessIterator first,
+         RandomAccessIterator last, Compare comp)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        auto count = static_cast<size_t>(last - first);
+        size_t chunks{1};
+        if constexpr (aux::runs_parallel_v<ExecutionPolicy, RandomAccessIterator>)
+            chunks = aux::parallel_chunk_count(count, aux::executor::instance());
+
+        if (chunks <= 1)
+        {
+            sort(first, last, comp);
+
+            return;
+        }
+
+        /**
+         * Sort the chunks in parallel and then merge pairs of
+         * neighbouring runs, also in parallel, until there is
+         * only one. The merges in one round are independent.
+         */
+        auto bound = [count, chunks](size_t idx){
+            return count * (idx < chunks ? idx : chunks) / chunks;
+        };
+
+        aux::parallel_chunks(count, chunks, [&](size_t begin, size_t end, size_t){
+            sort(first + begin, first + end, comp);
+        });
+
+        for (size_t width = 1; width < chunks; width *= 2)
+        {
+            auto merges = (chunks + 2 * width - 1) / (2 * width);
+            aux::parallel_chunks(merges, merges, [&](size_t idx, size_t, size_t){
+                auto lo = idx * 2 * width;
+                if (lo + width >= chunks)
+                    return;
+
+                auto begin = first + bound(lo);
+                auto middle = first + bound(lo + width);
+                auto end = first + bound(lo + 2 * width);
+                if (!comp(*middle, *(middle - 1)))
+                    return;
+
+                auto size = static_cast<size_t>(middle - begin) * sizeof(value_type);
+                auto buffer = static_cast<value_type*>(::operator new(size, nothrow));
+                if (buffer)
+                {
+                    aux::merge_buffered(begin, middle, end, buffer, comp);
+                    ::operator delete(buffer);
+                }
+                else
+                    aux::merge_in_place(begin, middle, end, comp);
+            });
+        }
+    }
+
+    template<class ExecutionPolicy, class RandomAccessIterator>
+    aux::enable_if_policy_t<ExecutionPolicy, void>
+    sort(ExecutionPolicy&& policy, RandomAccessIterator first,
+         RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        sort(forward<ExecutionPolicy>(policy), first, last, less<value_type>{});
+    }
+}
+
+#endif
@@ -31,6 +31,7 @@
 
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 
 namespace std
 {
@@ -46,26 +47,26 @@ namespace std
 
     namespace aux
     {
-        template<class T>
-        union converter
-        {
-            T value;
-            uint64_t converted;
-        };
-
         template<class T>
         T hash_(uint64_t x) noexcept
         {
             /**
              * Note: std::hash is used for indexing in
-             *       unordered containers, not for cryptography.
-             *       Because of this, we decided to simply convert
-             *       the value to uin64_t, which will help us
-             *       with testing (since in order to create
-             *       a collision in a multiset or multimap
-             *       we simply need 2 values that congruent
-             *       by the size of the table.
+             *       unordered containers, not for cryptography,
+             *       but returning the value itself makes keys
+             *       that differ only in their high bits (pointers,
+             *       multiples of the table size) share a bucket,
+             *       and leaves the low bits of the flat tables'
+             *       control bytes constant. This is the splitmix64
+             *       finalizer, which is a bijection, so distinct
+             *       values still never collide before reduction.
              */
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+
             return static_cast<T>(x);
         }
 
@@ -75,10 +76,61 @@ namespace std
             static_assert(is_arithmetic<T>::value || is_pointer<T>::value,
                           "invalid type passed to aux::hash");
 
-            converter<T> conv;
-            conv.value = x;
+            /**
+             * Note: Types narrower than 64 bits must not
+             *       leave garbage in the upper bytes, and
+             *       long double only contributes its first
+             *       eight bytes.
+             */
+            uint64_t converted{};
+            memcpy(&converted, &x, sizeof(T) < sizeof(uint64_t) ?
+                   sizeof(T) : sizeof(uint64_t));
+
+            return hash_<size_t>(converted);
+        }
+
+        /**
+         * Hashes a sequence of bytes eight at a time
+         * (this is MurmurHash64A), mixing every block
+         * in, because strings that share a prefix are
+         * common keys.
+         */
+        inline size_t hash_bytes(const void* data, size_t len) noexcept
+        {
+            constexpr uint64_t m{0xc6a4a7935bd1e995ULL};
+            constexpr int r{47};
+
+            auto bytes = static_cast<const unsigned char*>(data);
+            uint64_t res = 0x8445d61a4e774912ULL ^ (len * m);
+
+            while (len >= sizeof(uint64_t))
+            {
+                uint64_t k;
+                memcpy(&k, bytes, sizeof(k));
+
+                k *= m;
+                k ^= k >> r;
+                k *= m;
+
+                res ^= k;
+                res *= m;
+
+                bytes += sizeof(uint64_t);
+                len -= sizeof(uint64_t);
+            }
+
+            if (len > 0)
+            {
+                for (size_t i = len; i > 0; --i)
+                    res ^= static_cast<uint64_t>(bytes[i - 1]) << (8 * (i - 1));
+                res *= m;
+            }
+
+            res ^= res >> r;
+            res *= m;
+            res ^= res >> r;
 
-            return hash_<size_t>(conv.converted);
+            return static_cast<size_t>(res);
         }
     }
 
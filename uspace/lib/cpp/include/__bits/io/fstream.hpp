@@ -63,9 +63,8 @@ namespace std
             basic_filebuf(const basic_filebuf&) = delete;
 
             basic_filebuf(basic_filebuf&& other)
-                : mode_{other.mode_}
+                : obuf_{nullptr}, ibuf_{nullptr}, mode_{other.mode_}, file_{nullptr}
             {
-                close();
                 std::swap(obuf_, other.obuf_);
                 std::swap(ibuf_, other.ibuf_);
                 std::swap(file_, other.file_);
@@ -77,6 +76,9 @@ namespace std
             {
                 // TODO: exception here caught and not rethrown
                 close();
+
+                delete[] obuf_;
+                delete[] ibuf_;
             }
 
             /**
@@ -127,6 +129,9 @@ namespace std
                 if (!file_)
                     return nullptr;
 
+                // Our buffers replace the ones of stdio.
+                setvbuf(file_, nullptr, hel::_IONBF, 0);
+
                 if ((mode_ & ios_base::ate) != 0)
                 {
                     if (fseek(file_, 0, SEEK_END) != 0)
@@ -157,8 +162,7 @@ namespace std
                     return nullptr;
                 // TODO: deallocate buffers?
 
-                if (this->output_next_ != this->output_begin_)
-                    overflow(traits_type::eof());
+                flush_();
                 // TODO: unshift? (p. 1084 at the top)
 
                 fclose(file_);
@@ -188,25 +192,17 @@ namespace std
                 if (this->input_next_ < this->input_end_)
                 {
                     auto idx = static_cast<off_type>(this->input_next_ - this->input_begin_);
-                    auto count = static_cast<off_type>(buf_size_) - idx;
+                    auto count = static_cast<off_type>(this->input_end_ - this->input_next_);
 
                     for (; i < count; ++i, ++idx)
                         ibuf_[i] = ibuf_[idx];
                 }
 
-                for (; i < static_cast<off_type>(buf_size_); ++i)
+                if (i < static_cast<off_type>(buf_size_))
                 {
-                    auto c = fgetc(file_);
-                    if (c == traits_type::eof())
-                        break;
-
-                    ibuf_[i] = static_cast<char_type>(c);
-
-                    if (ibuf_[i] == '\n')
-                    {
-                        ++i;
-                        break;
-                    }
+                    i += static_cast<off_type>(fread(
+                        ibuf_ + i, sizeof(char_type), buf_size_ - i, file_
+                    ));
                 }
 
                 this->input_next_ = this->input_begin_;
@@ -253,15 +249,40 @@ namespace std
                 if (!mode_is_out_(mode_))
                     return traits_type::eof();
 
-                auto count = static_cast<size_t>(this->output_next_ - this->output_begin_);
-                fwrite(obuf_, sizeof(char_type), count, file_);
-                fflush(file_);
+                if (!flush_())
+                    return traits_type::eof();
 
-                this->output_next_ = this->output_begin_;
+                if (!traits_type::eq_int_type(c, traits_type::eof()))
+                {
+                    if (this->output_next_ < this->output_end_)
+                        *this->output_next_++ = traits_type::to_char_type(c);
+                    else
+                    {
+                        auto cc = traits_type::to_char_type(c);
+                        if (fwrite(&cc, sizeof(char_type), 1, file_) != 1)
+                            return traits_type::eof();
+                    }
+                }
 
                 return traits_type::not_eof(c);
             }
 
+            streamsize xsputn(const char_type* s, streamsize n) override
+            {
+                // Large writes skip the buffer.
+                if (mode_is_out_(mode_) && n >= static_cast<streamsize>(buf_size_))
+                {
+                    if (!flush_())
+                        return 0;
+
+                    return static_cast<streamsize>(
+                        fwrite(s, sizeof(char_type), static_cast<size_t>(n), file_)
+                    );
+                }
+
+                return basic_streambuf<char_type, traits_type>::xsputn(s, n);
+            }
+
             basic_streambuf<char_type, traits_type>*
             setbuf(char_type* s, streamsize n) override
             {
@@ -285,10 +306,10 @@ namespace std
 
             int sync() override
             {
-                if (mode_is_out_(mode_))
-                    overflow();
+                if (mode_is_out_(mode_) && (!flush_() || fflush(file_)))
+                    return -1;
 
-                return 0; // TODO: what is the correct return value?
+                return 0;
             }
 
             void imbue(const locale& loc) override
@@ -305,7 +326,18 @@ namespace std
 
             FILE* file_;
 
-            static constexpr size_t buf_size_{128};
+            static constexpr size_t buf_size_{8192};
+
+            bool flush_()
+            {
+                if (!file_ || !obuf_)
+                    return true;
+
+                auto count = static_cast<size_t>(this->output_next_ - this->output_begin_);
+                this->output_next_ = this->output_begin_;
+
+                return count == 0 || fwrite(obuf_, sizeof(char_type), count, file_) == count;
+            }
 
             const char* get_mode_str_(ios_base::openmode mode)
             {
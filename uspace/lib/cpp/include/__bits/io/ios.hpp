@@ -183,13 +183,7 @@ namespace std
             using event_callback = void (*)(event, ios_base&, int);
             void register_callback(event_callback fn, int index);
 
-            static bool sync_with_stdio(bool sync = true)
-            {
-                auto old = sync_;
-                sync_ = sync;
-
-                return old;
-            }
+            static bool sync_with_stdio(bool sync = true);
 
         protected:
             ios_base();
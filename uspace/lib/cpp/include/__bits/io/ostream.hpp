@@ -151,199 +151,67 @@ namespace std
 
             basic_ostream<Char, Traits>& operator<<(short x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    auto basefield = (this->flags() & ios_base::basefield);
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
-                                          (basefield == ios_base::oct || basefield == ios_base::hex)
-                                          ? static_cast<long>(static_cast<unsigned short>(x))
-                                          : static_cast<long>(x)).failed();
+                auto basefield = (this->flags() & ios_base::basefield);
 
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                if (basefield == ios_base::oct || basefield == ios_base::hex)
+                    return put_number_(static_cast<long>(static_cast<unsigned short>(x)));
+                else
+                    return put_number_(static_cast<long>(x));
             }
 
             basic_ostream<Char, Traits>& operator<<(unsigned short x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
-                                          static_cast<unsigned long>(x)).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(static_cast<unsigned long>(x));
             }
 
             basic_ostream<Char, Traits>& operator<<(int x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    auto basefield = (this->flags() & ios_base::basefield);
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
-                                          (basefield == ios_base::oct || basefield == ios_base::hex)
-                                          ? static_cast<long>(static_cast<unsigned int>(x))
-                                          : static_cast<long>(x)).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
+                auto basefield = (this->flags() & ios_base::basefield);
 
-                return *this;
+                if (basefield == ios_base::oct || basefield == ios_base::hex)
+                    return put_number_(static_cast<long>(static_cast<unsigned int>(x)));
+                else
+                    return put_number_(static_cast<long>(x));
             }
 
             basic_ostream<Char, Traits>& operator<<(unsigned int x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
-                                          static_cast<unsigned long>(x)).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(static_cast<unsigned long>(x));
             }
 
             basic_ostream<Char, Traits>& operator<<(long x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(x);
             }
 
             basic_ostream<Char, Traits>& operator<<(unsigned long x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(x);
             }
 
             basic_ostream<Char, Traits>& operator<<(long long x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(x);
             }
 
             basic_ostream<Char, Traits>& operator<<(unsigned long long x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(x);
             }
 
             basic_ostream<Char, Traits>& operator<<(float x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), static_cast<double>(x)).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(static_cast<double>(x));
             }
 
             basic_ostream<Char, Traits>& operator<<(double x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(x);
             }
 
             basic_ostream<Char, Traits>& operator<<(long double x)
             {
-                sentry sen{*this};
-
-                if (sen)
-                {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
-
-                    if (failed)
-                        this->setstate(ios_base::badbit);
-                }
-
-                return *this;
+                return put_number_(x);
             }
 
             basic_ostream<Char, Traits>& operator<<(const void* p)
@@ -497,6 +365,90 @@ namespace std
             {
                 basic_ios<Char, Traits>::swap(rhs);
             }
+
+        private:
+            /**
+             * Note: Our locale is always the classic one, so for narrow
+             *       streams we skip num_put and its per character
+             *       ostreambuf_iterator writes, format on the stack and
+             *       hand the result to the buffer in one sputn call.
+             */
+            template<class T>
+            basic_ostream<Char, Traits>& put_number_(T x)
+            {
+                sentry sen{*this};
+
+                if (sen)
+                {
+                    bool failed{};
+                    if constexpr (is_same_v<char_type, char>)
+                    {
+                        char buffer[128];
+                        size_t size{};
+                        if constexpr (is_floating_point_v<T>)
+                        {
+                            size = aux::format_floating(
+                                buffer, sizeof(buffer), this->flags(),
+                                this->precision(), x
+                            );
+                        }
+                        else
+                            size = aux::format_integer(buffer, sizeof(buffer), this->flags(), x);
+
+                        failed = !put_padded_(buffer, size);
+                    }
+                    else
+                    {
+                        failed = use_facet<
+                            num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
+                        >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    }
+
+                    if (failed)
+                        this->setstate(ios_base::badbit);
+                }
+
+                return *this;
+            }
+
+            bool put_padded_(const char_type* str, size_t size)
+            {
+                auto sb = this->rdbuf();
+                auto width = this->width();
+                this->width(0);
+
+                size_t to_fill{};
+                if (width > 0 && size < static_cast<size_t>(width))
+                    to_fill = static_cast<size_t>(width) - size;
+
+                auto adjustfield = (this->flags() & ios_base::adjustfield);
+                size_t prefix{};
+                if (adjustfield == ios_base::left)
+                    prefix = size;
+                else if (adjustfield == ios_base::internal && to_fill > 0)
+                {
+                    if (size > 0 && (str[0] == '-' || str[0] == '+'))
+                        prefix = 1;
+                    if (size > prefix + 1 && str[prefix] == '0' &&
+                        (str[prefix + 1] == 'x' || str[prefix + 1] == 'X'))
+                        prefix += 2;
+                }
+
+                auto n = static_cast<streamsize>(prefix);
+                if (prefix > 0 && sb->sputn(str, n) != n)
+                    return false;
+
+                auto fill = this->fill();
+                for (size_t i = 0; i < to_fill; ++i)
+                {
+                    if (traits_type::eq_int_type(sb->sputc(fill), traits_type::eof()))
+                        return false;
+                }
+
+                n = static_cast<streamsize>(size - prefix);
+
+                return n == 0 || sb->sputn(str + prefix, n) == n;
+            }
     };
 
     using ostream  = basic_ostream<char>;
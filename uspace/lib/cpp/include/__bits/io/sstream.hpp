@@ -72,9 +72,13 @@ namespace std
             basic_stringbuf(const basic_stringbuf&) = delete;
 
             basic_stringbuf(basic_stringbuf&& other)
-                : mode_{move(other.mode_)}, str_{move(other.str_)}
+                : mode_{move(other.mode_)}, str_{}
             {
+                auto other_base = other.str_.begin();
+
+                str_ = move(other.str_);
                 basic_streambuf<char_type, traits_type>::swap(other);
+                rebase_(other_base);
             }
 
             /**
@@ -86,14 +90,21 @@ namespace std
             basic_stringbuf& operator=(basic_stringbuf&& other)
             {
                 swap(other);
+
+                return *this;
             }
 
             void swap(basic_stringbuf& rhs)
             {
+                auto base = str_.begin();
+                auto rhs_base = rhs.str_.begin();
+
                 std::swap(mode_, rhs.mode_);
-                std::swap(str_, rhs.str_);
+                str_.swap(rhs.str_);
 
                 basic_streambuf<char_type, traits_type>::swap(rhs);
+                rebase_(rhs_base);
+                rhs.rebase_(base);
             }
 
             /**
@@ -104,7 +115,7 @@ namespace std
             {
                 if (mode_ & ios_base::out)
                     return basic_string<char_type, traits_type, allocator_type>{
-                        this->output_begin_, this->output_next_ - 1, str_.get_allocator()
+                        this->output_begin_, output_high_(), str_.get_allocator()
                     };
                 else if (mode_ == ios_base::in)
                     return basic_string<char_type, traits_type, allocator_type>{
@@ -166,23 +177,26 @@ namespace std
                 if ((mode_ & ios_base::out) == 0)
                     return traits_type::eof();
 
-                if (!traits_type::eq_int_type(c, traits_type::eof()))
-                {
-                    if (this->output_next_ < this->output_end_)
-                        return c;
+                if (traits_type::eq_int_type(c, traits_type::eof()))
+                    return traits_type::not_eof(c);
 
-                    auto size = static_cast<size_t>(this->output_next_ - this->output_begin_);
-                    str_.size_ = size;
+                /**
+                 * Characters written since the last overflow went
+                 * straight into the spare capacity of str_, commit
+                 * them before the string grows.
+                 */
+                auto input_off = this->input_next_ - this->input_begin_;
+                auto output_off = this->output_next_ - this->output_begin_;
 
-                    str_.push_back(traits_type::to_char_type(c));
-                    init_();
+                str_.size_ = static_cast<size_t>(output_high_() - this->output_begin_);
+                str_.push_back(traits_type::to_char_type(c));
+                init_();
 
-                    return c;
-                }
-                else if (traits_type::eq_int_type(c, traits_type::eof()))
-                    return traits_type::not_eof(c);
+                if ((mode_ & ios_base::in) != 0)
+                    this->input_next_ = this->input_begin_ + input_off;
+                this->output_next_ = this->output_begin_ + output_off + 1;
 
-                return traits_type::eof();
+                return c;
             }
 
             basic_streambuf<char_type, traits_type>* setbuf(char_type* str, streamsize n) override
@@ -244,9 +258,44 @@ namespace std
 
                 if ((mode_ & ios_base::out) != 0)
                 {
+                    // The last slot of the capacity is for the null terminator.
                     this->output_begin_ = str_.begin();
                     this->output_next_ = str_.end();
-                    this->output_end_ = str_.begin() + str_.size() + 1;
+                    this->output_end_ = str_.begin() + str_.capacity() - 1;
+                }
+            }
+
+            /**
+             * End of the written contents, which might
+             * be past str_.size() until the next overflow.
+             */
+            char_type* output_high_() const
+            {
+                auto end = this->output_begin_ + str_.size();
+
+                return this->output_next_ > end ? this->output_next_ : end;
+            }
+
+            /**
+             * Short strings live inside the string object, so
+             * moving it moves the buffer. Shifts our pointers from
+             * the buffer that started at old_base to the current one.
+             */
+            void rebase_(char_type* old_base)
+            {
+                auto base = str_.begin();
+                if (base == old_base)
+                    return;
+
+                char_type** ptrs[] = {
+                    &this->input_begin_, &this->input_next_, &this->input_end_,
+                    &this->output_begin_, &this->output_next_, &this->output_end_
+                };
+
+                for (auto ptr: ptrs)
+                {
+                    if (*ptr)
+                        *ptr = base + (*ptr - old_base);
                 }
             }
 
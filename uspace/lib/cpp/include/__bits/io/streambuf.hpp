@@ -336,13 +336,25 @@ namespace std
                     return 0;
 
                 streamsize i{0};
-                auto eof = traits_type::eof();
-                for (; i <= n; ++i)
+                while (i < n)
                 {
-                    if (!read_avail_() && traits_type::eq_int_type(uflow(), eof))
-                        break;
-
-                    *s++ = *input_next_++;
+                    if (read_avail_())
+                    {
+                        auto avail = static_cast<streamsize>(input_end_ - input_next_);
+                        auto count = avail < n - i ? avail : n - i;
+
+                        traits_type::copy(s + i, input_next_, count);
+                        input_next_ += count;
+                        i += count;
+                    }
+                    else
+                    {
+                        auto c = uflow();
+                        if (traits_type::eq_int_type(c, traits_type::eof()))
+                            break;
+
+                        s[i++] = traits_type::to_char_type(c);
+                    }
                 }
 
                 return i;
@@ -381,12 +393,25 @@ namespace std
                     return 0;
 
                 streamsize i{0};
-                for (; i <= n; ++i)
+                while (i < n)
                 {
-                    if (!write_avail_() && traits_type::eq_int_type(overflow(), traits_type::eof()))
-                        break;
-
-                    *output_next_++ = *s++;
+                    if (write_avail_())
+                    {
+                        auto avail = static_cast<streamsize>(output_end_ - output_next_);
+                        auto count = avail < n - i ? avail : n - i;
+
+                        traits_type::copy(output_next_, s + i, count);
+                        output_next_ += count;
+                        i += count;
+                    }
+                    else
+                    {
+                        // Overflow consumes the character it is given.
+                        auto c = traits_type::to_int_type(s[i]);
+                        if (traits_type::eq_int_type(overflow(c), traits_type::eof()))
+                            break;
+                        ++i;
+                    }
                 }
 
                 return i;
@@ -30,6 +30,7 @@
 #define LIBCPP_BITS_IO_STREAMBUFS
 
 #include <iosfwd>
+#include <cstdint>
 #include <cstdio>
 #include <streambuf>
 
@@ -123,16 +124,65 @@ namespace std::aux
             static constexpr off_type buf_size_{128};
     };
 
+    /**
+     * Writes size bytes of data to the file descriptor fd at the
+     * position pos (which is then advanced), returns false on
+     * failure.
+     */
+    bool write_fd(int fd, uint64_t& pos, const void* data, size_t size);
+
+    /**
+     * While synchronized with stdio (the default), characters
+     * are passed to stdio right away so that output of cout and
+     * printf interleaves correctly. Otherwise output is collected
+     * in a large buffer that is written directly to the underlying
+     * file (or as a single fwrite if stdout has none) when full
+     * or on flush.
+     */
     template<class Char, class Traits = char_traits<Char>>
     class stdout_streambuf: public basic_streambuf<Char, Traits>
     {
         public:
             stdout_streambuf()
-                : basic_streambuf<Char, Traits>{}
+                : basic_streambuf<Char, Traits>{}, buffer_{nullptr},
+                  fd_{-1}, pos_{}
             { /* DUMMY BODY */ }
 
             virtual ~stdout_streambuf()
-            { /* DUMMY BODY */ }
+            {
+                flush_();
+                if (buffer_)
+                    delete[] buffer_;
+            }
+
+            void synchronize(bool sync)
+            {
+                flush_();
+                fflush(out_);
+
+                if (sync)
+                {
+                    // Let stdio continue where we stopped.
+                    if (fd_ >= 0)
+                        fseek(out_, static_cast<long>(pos_), SEEK_SET);
+
+                    fd_ = -1;
+                    this->setp(nullptr, nullptr);
+
+                    return;
+                }
+
+                if (!buffer_)
+                    buffer_ = new char_type[buf_size_];
+                this->setp(buffer_, buffer_ + buf_size_);
+
+                fd_ = sizeof(char_type) == 1 ? hel::fileno(out_) : -1;
+                if (fd_ >= 0)
+                {
+                    auto pos = ftell(out_);
+                    pos_ = pos > 0 ? static_cast<uint64_t>(pos) : 0;
+                }
+            }
 
         protected:
             using traits_type = Traits;
@@ -142,10 +192,22 @@ namespace std::aux
 
             int_type overflow(int_type c = traits_type::eof()) override
             {
+                if (this->pbase())
+                {
+                    if (!flush_())
+                        return traits_type::eof();
+
+                    if (!traits_type::eq_int_type(c, traits_type::eof()))
+                        *this->output_next_++ = traits_type::to_char_type(c);
+
+                    return traits_type::not_eof(c);
+                }
+
                 if (!traits_type::eq_int_type(c, traits_type::eof()))
                 {
                     auto cc = traits_type::to_char_type(c);
-                    fwrite(&cc, sizeof(char_type), 1, out_);
+                    if (fwrite(&cc, sizeof(char_type), 1, out_) != 1)
+                        return traits_type::eof();
                 }
 
                 return traits_type::not_eof(c);
@@ -153,18 +215,53 @@ namespace std::aux
 
             streamsize xsputn(const char_type* s, streamsize n) override
             {
-                return fwrite(s, sizeof(char_type), n, out_);
+                if (!this->pbase())
+                    return fwrite(s, sizeof(char_type), n, out_);
+
+                // Large writes skip the buffer.
+                if (n >= static_cast<streamsize>(buf_size_))
+                {
+                    if (!flush_() || !write_(s, static_cast<size_t>(n)))
+                        return 0;
+                    return n;
+                }
+
+                return basic_streambuf<Char, Traits>::xsputn(s, n);
             }
 
             int sync() override
             {
-                if (fflush(out_))
+                if (!flush_() || fflush(out_))
                     return -1;
                 return 0;
             }
 
         private:
             FILE* out_{stdout};
+
+            char_type* buffer_;
+            int fd_;
+            uint64_t pos_;
+
+            static constexpr size_t buf_size_{16384};
+
+            bool write_(const char_type* s, size_t n)
+            {
+                if (fd_ >= 0)
+                    return write_fd(fd_, pos_, s, n * sizeof(char_type));
+                return fwrite(s, sizeof(char_type), n, out_) == n;
+            }
+
+            bool flush_()
+            {
+                if (!this->pbase())
+                    return true;
+
+                auto count = static_cast<size_t>(this->pptr() - this->pbase());
+                this->setp(buffer_, buffer_ + buf_size_);
+
+                return count == 0 || write_(buffer_, count);
+            }
     };
 }
 
@@ -115,8 +115,22 @@ namespace std
     template<class InputIterator, class Distance>
     void advance(InputIterator& it, Distance n)
     {
-        for (Distance i = Distance{}; i < n; ++i)
-            ++it;
+        using cat_t = typename iterator_traits<InputIterator>::iterator_category;
+
+        if constexpr (is_base_of_v<random_access_iterator_tag, cat_t>)
+            it += n;
+        else
+        {
+            for (Distance i = Distance{}; i < n; ++i)
+                ++it;
+
+            // Negative distance, only valid for bidirectional iterators.
+            if constexpr (is_base_of_v<bidirectional_iterator_tag, cat_t>)
+            {
+                for (Distance i = Distance{}; i > n; --i)
+                    --it;
+            }
+        }
     }
 
     template<class InputIterator>
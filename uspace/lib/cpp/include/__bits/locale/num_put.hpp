@@ -29,13 +29,96 @@
 #ifndef LIBCPP_BITS_LOCALE_NUM_PUT
 #define LIBCPP_BITS_LOCALE_NUM_PUT
 
+#include <__bits/charconv.hpp>
 #include <__bits/locale/locale.hpp>
 #include <__bits/locale/numpunct.hpp>
+#include <cstdio>
 #include <ios>
 #include <iterator>
 
 namespace std
 {
+    namespace aux
+    {
+        /**
+         * Locale independent formatting shared by num_put and
+         * the char fast path of basic_ostream. Both write at most
+         * size - 1 characters and return their count.
+         */
+
+        template<class T>
+        size_t format_integer(char* buffer, size_t size, ios_base::fmtflags flags, T v)
+        {
+            using unsigned_type = make_unsigned_t<T>;
+
+            auto basefield = (flags & ios_base::basefield);
+            bool upper = (flags & ios_base::uppercase) != 0;
+            int base = 10;
+            if (basefield == ios_base::oct)
+                base = 8;
+            else if (basefield == ios_base::hex)
+                base = 16;
+
+            auto uv = static_cast<unsigned_type>(v);
+            bool negative{};
+            if constexpr (is_signed_v<T>)
+            {
+                if (base == 10 && v < 0)
+                {
+                    negative = true;
+                    uv = static_cast<unsigned_type>(0) - uv;
+                }
+            }
+
+            char digits[8 * sizeof(T)];
+            char* end = digits + sizeof(digits);
+            char* start = format_unsigned(end, uv, base, upper);
+
+            auto len = static_cast<size_t>(end - start);
+            if (len + negative >= size)
+                return 0;
+
+            if (negative)
+                *buffer++ = '-';
+            std::memcpy(buffer, start, len);
+
+            return len + negative;
+        }
+
+        template<class T>
+        size_t format_floating(char* buffer, size_t size, ios_base::fmtflags flags,
+                               streamsize precision, T v)
+        {
+            auto floatfield = (flags & ios_base::floatfield);
+            bool upper = (flags & ios_base::uppercase) != 0;
+
+            char conv{};
+            if (floatfield == ios_base::fixed)
+                conv = 'f';
+            else if (floatfield == ios_base::scientific)
+                conv = upper ? 'E' : 'e';
+            else if (floatfield == (ios_base::fixed | ios_base::scientific))
+                conv = upper ? 'A' : 'a';
+            else
+                conv = upper ? 'G' : 'g';
+
+            // TODO: showbase, showpoint, showpos
+            char fmt[] = { '%', '.', '*', 'L', conv, '\0' };
+            if constexpr (!is_same_v<T, long double>)
+            {
+                fmt[3] = conv;
+                fmt[4] = '\0';
+            }
+
+            int prec = precision < 0 ? 6 : static_cast<int>(precision);
+            int ret = snprintf(buffer, size, fmt, prec, v);
+            if (ret < 0)
+                return 0;
+
+            return static_cast<size_t>(ret) < size ? static_cast<size_t>(ret) : size - 1;
+        }
+    }
+
     /**
      * 22.4.2.2, class template num_put:
      */
@@ -113,101 +196,48 @@ namespace std
 
             iter_type do_put(iter_type it, ios_base& base, char_type fill, long v) const
             {
-                auto basefield = (base.flags() & ios_base::basefield);
-                auto uppercase = (base.flags() & ios_base::uppercase);
-
-                int ret{};
-                if (basefield == ios_base::oct)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lo", v);
-                else if ((basefield == ios_base::hex) && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lx", v);
-                else if (basefield == ios_base::hex)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lX", v);
-                else
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%ld", v);
+                auto size = aux::format_integer(
+                    base.buffer_, ios_base::buffer_size_, base.flags(), v
+                );
 
-                return put_adjusted_buffer_(it, base, fill, ret);
+                return put_adjusted_buffer_(it, base, fill, size);
             }
 
             iter_type do_put(iter_type it, ios_base& base, char_type fill, long long v) const
             {
-                auto basefield = (base.flags() & ios_base::basefield);
-                auto uppercase = (base.flags() & ios_base::uppercase);
-
-                int ret{};
-                if (basefield == ios_base::oct)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%llo", v);
-                else if ((basefield == ios_base::hex) && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%llx", v);
-                else if (basefield == ios_base::hex)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%llX", v);
-                else
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lld", v);
+                auto size = aux::format_integer(
+                    base.buffer_, ios_base::buffer_size_, base.flags(), v
+                );
 
-                return put_adjusted_buffer_(it, base, fill, ret);
+                return put_adjusted_buffer_(it, base, fill, size);
             }
 
             iter_type do_put(iter_type it, ios_base& base, char_type fill, unsigned long v) const
             {
-                auto basefield = (base.flags() & ios_base::basefield);
-                auto uppercase = (base.flags() & ios_base::uppercase);
-
-                int ret{};
-                if (basefield == ios_base::oct)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lo", v);
-                else if ((basefield == ios_base::hex) && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lx", v);
-                else if (basefield == ios_base::hex)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lX", v);
-                else
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%lu", v);
+                auto size = aux::format_integer(
+                    base.buffer_, ios_base::buffer_size_, base.flags(), v
+                );
 
-                return put_adjusted_buffer_(it, base, fill, ret);
+                return put_adjusted_buffer_(it, base, fill, size);
             }
 
             iter_type do_put(iter_type it, ios_base& base, char_type fill, unsigned long long v) const
             {
-                auto basefield = (base.flags() & ios_base::basefield);
-                auto uppercase = (base.flags() & ios_base::uppercase);
-
-                // TODO: showbase
-                int ret{};
-                if (basefield == ios_base::oct)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%llo", v);
-                else if ((basefield == ios_base::hex) && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%llx", v);
-                else if (basefield == ios_base::hex)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%llX", v);
-                else
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%llu", v);
+                auto size = aux::format_integer(
+                    base.buffer_, ios_base::buffer_size_, base.flags(), v
+                );
 
-                return put_adjusted_buffer_(it, base, fill, ret);
+                return put_adjusted_buffer_(it, base, fill, size);
             }
 
             iter_type do_put(iter_type it, ios_base& base, char_type fill, double v) const
             {
-                auto floatfield = (base.flags() & ios_base::floatfield);
-                auto uppercase = (base.flags() & ios_base::uppercase);
-
-                // TODO: showbase
-                // TODO: precision
-                int ret{};
-                if (floatfield == ios_base::fixed)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%f", v);
-                else if (floatfield == ios_base::scientific && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%e", v);
-                else if (floatfield == ios_base::scientific)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%E", v);
-                else if (floatfield == (ios_base::fixed | ios_base::scientific) && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%a", v);
-                else if (floatfield == (ios_base::fixed | ios_base::scientific))
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%A", v);
-                else if (!uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%g", v);
-                else
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%G", v);
+                auto size = aux::format_floating(
+                    base.buffer_, ios_base::buffer_size_,
+                    base.flags(), base.precision(), v
+                );
 
-                return put_adjusted_buffer_(it, base, fill, ret);
+                return put_adjusted_buffer_(it, base, fill, size);
             }
 
             iter_type do_put(iter_type it, ios_base& base, char_type fill, long double v) const
@@ -215,28 +245,12 @@ namespace std
                 /**
                  * Note: Long double is not support at the moment in snprintf.
                  */
-                auto floatfield = (base.flags() & ios_base::floatfield);
-                auto uppercase = (base.flags() & ios_base::uppercase);
-
-                // TODO: showbase
-                // TODO: precision
-                int ret{};
-                if (floatfield == ios_base::fixed)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%Lf", v);
-                else if (floatfield == ios_base::scientific && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%Le", v);
-                else if (floatfield == ios_base::scientific)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%LE", v);
-                else if (floatfield == (ios_base::fixed | ios_base::scientific) && !uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%La", v);
-                else if (floatfield == (ios_base::fixed | ios_base::scientific))
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%LA", v);
-                else if (!uppercase)
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%Lg", v);
-                else
-                    ret = snprintf(base.buffer_, ios_base::buffer_size_, "%LG", v);
+                auto size = aux::format_floating(
+                    base.buffer_, ios_base::buffer_size_,
+                    base.flags(), base.precision(), v
+                );
 
-                return put_adjusted_buffer_(it, base, fill, ret);
+                return put_adjusted_buffer_(it, base, fill, size);
             }
 
             iter_type do_put(iter_type it, ios_base& base, char_type fill, const void* v) const
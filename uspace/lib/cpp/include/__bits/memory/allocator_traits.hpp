@@ -87,7 +87,7 @@ namespace std
         using is_always_equal                        = typename aux::alloc_get_always_equal<Alloc>::type;
 
         template<class T>
-        using rebind_alloc = typename aux::alloc_get_rebind_alloc<Alloc, T>;
+        using rebind_alloc = typename aux::alloc_get_rebind_alloc<Alloc, T>::type;
 
         template<class T>
         using rebind_traits = allocator_traits<rebind_alloc<T>>;
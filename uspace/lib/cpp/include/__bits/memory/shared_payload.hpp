@@ -29,7 +29,10 @@
 #ifndef LIBCPP_BITS_MEMORY_SHARED_PAYLOAD
 #define LIBCPP_BITS_MEMORY_SHARED_PAYLOAD
 
+#include <__bits/memory/allocator_traits.hpp>
+#include <__bits/trycatch.hpp>
 #include <cinttypes>
+#include <new>
 #include <utility>
 
 namespace std
@@ -40,13 +43,86 @@ namespace std
     struct allocator_arg_t;
 }
 
+namespace std::hel
+{
+    extern "C" bool fibril_is_multithreaded(void);
+}
+
 namespace std::aux
 {
+    using refcount_t = long;
+
     /**
-     * At the moment we do not have atomics, change this
-     * to std::atomic<long> once we do.
+     * Until the task spawns additional runner threads,
+     * all fibrils run on a single thread and cannot
+     * preempt each other, so the reference counts can
+     * be updated without the (bus locking) atomic
+     * instructions. The switch is one way and happens
+     * before any other thread exists, so counts that
+     * were touched non-atomically are visible to them.
      */
-    using refcount_t = long;
+    inline bool refcount_atomic() noexcept
+    {
+        return hel::fibril_is_multithreaded();
+    }
+
+    inline void refcount_increment(refcount_t& count) noexcept
+    {
+        if (refcount_atomic())
+            __atomic_add_fetch(&count, 1, __ATOMIC_RELAXED);
+        else
+            ++count;
+    }
+
+    /**
+     * Returns true if the count dropped to zero, the
+     * acquire-release ordering makes all accesses to
+     * the object made through other references visible
+     * to the one that destroys it.
+     */
+    inline bool refcount_decrement(refcount_t& count) noexcept
+    {
+        if (refcount_atomic())
+            return __atomic_sub_fetch(&count, 1, __ATOMIC_ACQ_REL) == 0;
+        else
+            return --count == 0;
+    }
+
+    /**
+     * Increments the count unless it already is zero,
+     * used when a weak_ptr gets locked.
+     */
+    inline bool refcount_increment_nonzero(refcount_t& count) noexcept
+    {
+        if (refcount_atomic())
+        {
+            refcount_t old = __atomic_load_n(&count, __ATOMIC_RELAXED);
+            while (old != 0)
+            {
+                if (__atomic_compare_exchange_n(&count, &old, old + 1,
+                                                true, __ATOMIC_ACQUIRE,
+                                                __ATOMIC_RELAXED))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+        else if (count != 0)
+        {
+            ++count;
+
+            return true;
+        }
+        else
+            return false;
+    }
+
+    inline refcount_t refcount_load(const refcount_t& count) noexcept
+    {
+        return __atomic_load_n(&count, __ATOMIC_RELAXED);
+    }
 
     /**
      * This allows us to construct shared_ptr from
@@ -64,160 +140,216 @@ namespace std::aux
             (*deleter)(data);
     }
 
+    /**
+     * Control block shared by all shared_ptrs and weak_ptrs
+     * of a single object. The counting itself is not virtual,
+     * only the final disposal of the object (when the last
+     * shared_ptr goes away) and of the block (when the last
+     * weak reference goes away) are.
+     */
     template<class T>
     class shared_payload_base
     {
         public:
-            virtual void destroy() = 0;
-            virtual T* get() const noexcept = 0;
+            T* get() const noexcept
+            {
+                return data_;
+            }
 
             virtual uint8_t* deleter() const noexcept = 0;
 
-            virtual void increment() noexcept = 0;
-            virtual void increment_weak() noexcept = 0;
-            virtual bool decrement() noexcept = 0;
-            virtual bool decrement_weak() noexcept = 0;
-            virtual refcount_t refs() const noexcept = 0;
-            virtual refcount_t weak_refs() const noexcept = 0;
-            virtual bool expired() const noexcept = 0;
-            virtual shared_payload_base* lock() noexcept = 0;
-
-            virtual ~shared_payload_base() = default;
-    };
-
-    template<class T, class D = default_delete<T>>
-    class shared_payload: public shared_payload_base<T>
-    {
-        public:
-            shared_payload(T* ptr, D deleter = D{})
-                : data_{ptr}, deleter_{deleter},
-                  refcount_{1}, weak_refcount_{1}
-            { /* DUMMY BODY */ }
-
-            template<class... Args>
-            shared_payload(Args&&... args)
-                : data_{new T{forward<Args>(args)...}},
-                  deleter_{}, refcount_{1}, weak_refcount_{1}
-            { /* DUMMY BODY */ }
-
-            template<class Alloc, class... Args>
-            shared_payload(allocator_arg_t, Alloc alloc, Args&&... args)
-                : data_{alloc.allocate(1)},
-                  deleter_{}, refcount_{1}, weak_refcount_{1}
+            void increment() noexcept
             {
-                alloc.construct(data_, forward<Args>(args)...);
+                refcount_increment(refcount_);
             }
 
-            template<class Alloc, class... Args>
-            shared_payload(D deleter, Alloc alloc, Args&&... args)
-                : data_{alloc.allocate(1)},
-                  deleter_{deleter}, refcount_{1}, weak_refcount_{1}
+            void increment_weak() noexcept
             {
-                alloc.construct(data_, forward<Args>(args)...);
+                refcount_increment(weak_refcount_);
             }
 
-            void destroy() override
+            void release() noexcept
             {
-                if (refs() == 0)
+                if (refcount_decrement(refcount_))
                 {
-                    if (data_)
-                    {
-                        deleter_(data_);
-                        data_ = nullptr;
-                    }
-
-                    if (weak_refs() == 0)
-                        delete this;
+                    dispose();
+
+                    /**
+                     * The shared references together held one
+                     * weak reference, see below.
+                     */
+                    release_weak();
                 }
             }
 
-            T* get() const noexcept override
+            void release_weak() noexcept
             {
-                return data_;
+                if (refcount_decrement(weak_refcount_))
+                    destroy();
             }
 
-            uint8_t* deleter() const noexcept override
+            refcount_t refs() const noexcept
             {
-                return (uint8_t*)&deleter_;
+                return refcount_load(refcount_);
             }
 
-            void increment() noexcept override
+            refcount_t weak_refs() const noexcept
             {
-                __atomic_add_fetch(&refcount_, 1, __ATOMIC_ACQ_REL);
+                return refcount_load(weak_refcount_);
             }
 
-            void increment_weak() noexcept override
+            bool expired() const noexcept
             {
-                __atomic_add_fetch(&weak_refcount_, 1, __ATOMIC_ACQ_REL);
+                return refs() == 0;
             }
 
-            bool decrement() noexcept override
+            shared_payload_base* lock() noexcept
             {
-                if (__atomic_sub_fetch(&refcount_, 1, __ATOMIC_ACQ_REL) == 0)
-                {
-                    /**
-                     * First call to destroy() will delete the held object,
-                     * so it doesn't matter what the weak_refcount_ is,
-                     * but we added one and we need to remove it now.
-                     */
-                    decrement_weak();
+                if (refcount_increment_nonzero(refcount_))
+                    return this;
+                else
+                    return nullptr;
+            }
 
-                    return true;
+            virtual ~shared_payload_base() = default;
+
+        protected:
+            shared_payload_base(T* data)
+                : data_{data}, refcount_{1}, weak_refcount_{1}
+            { /* DUMMY BODY */ }
+
+            /**
+             * Destroys the held object.
+             */
+            virtual void dispose() noexcept = 0;
+
+            /**
+             * Destroys and deallocates the payload itself.
+             */
+            virtual void destroy() noexcept = 0;
+
+            T* data_;
+
+        private:
+            /**
+             * We're using a trick where refcount_ > 0
+             * means weak_refcount_ has 1 added to it,
+             * so that only one of release() and
+             * release_weak() can ever see the weak
+             * count drop to zero and destroy the payload.
+             */
+            refcount_t refcount_;
+            refcount_t weak_refcount_;
+    };
+
+    /**
+     * Payload for objects allocated separately, e.g.
+     * shared_ptr<T>{new T{}}.
+     */
+    template<class T, class D = default_delete<T>>
+    class shared_payload: public shared_payload_base<T>
+    {
+        public:
+            shared_payload(T* ptr, D deleter = D{})
+                : shared_payload_base<T>{ptr}, deleter_{deleter}
+            { /* DUMMY BODY */ }
+
+            uint8_t* deleter() const noexcept override
+            {
+                return (uint8_t*)&deleter_;
+            }
+
+        protected:
+            void dispose() noexcept override
+            {
+                if (this->data_)
+                {
+                    deleter_(this->data_);
+                    this->data_ = nullptr;
                 }
-                else
-                    return false;
             }
 
-            bool decrement_weak() noexcept override
+            void destroy() noexcept override
             {
-                return __atomic_sub_fetch(&weak_refcount_, 1, __ATOMIC_ACQ_REL) == 0 && refs() == 0;
+                delete this;
             }
 
-            refcount_t refs() const noexcept override
+        private:
+            D deleter_;
+    };
+
+    /**
+     * Payload that embeds the object, used by make_shared
+     * and allocate_shared so that the control block and
+     * the object share a single allocation.
+     */
+    template<class T, class Alloc>
+    class shared_payload_inplace: public shared_payload_base<T>
+    {
+        public:
+            using allocator_type = typename allocator_traits<Alloc>::template
+                rebind_alloc<shared_payload_inplace>;
+
+            template<class... Args>
+            shared_payload_inplace(const Alloc& alloc, Args&&... args)
+                : shared_payload_base<T>{nullptr}, alloc_{alloc}
             {
-                return __atomic_load_n(&refcount_, __ATOMIC_RELAXED);
+                T* data = reinterpret_cast<T*>(&storage_[0]);
+                allocator_traits<Alloc>::construct(alloc_, data, forward<Args>(args)...);
+
+                this->data_ = data;
             }
 
-            refcount_t weak_refs() const noexcept override
+            uint8_t* deleter() const noexcept override
             {
-                return __atomic_load_n(&weak_refcount_, __ATOMIC_RELAXED);
+                return nullptr;
             }
 
-            bool expired() const noexcept override
+        protected:
+            void dispose() noexcept override
             {
-                return refs() == 0;
+                allocator_traits<Alloc>::destroy(alloc_, this->data_);
             }
 
-            shared_payload_base<T>* lock() noexcept override
+            void destroy() noexcept override
             {
-                refcount_t rfs = refs();
-                while (rfs != 0L)
-                {
-                    if (__atomic_compare_exchange_n(&refcount_, &rfs, rfs + 1,
-                                                    true, __ATOMIC_RELAXED,
-                                                    __ATOMIC_RELAXED))
-                    {
-                        return this;
-                    }
-                }
+                allocator_type alloc{alloc_};
 
-                return nullptr;
+                this->~shared_payload_inplace();
+                allocator_traits<allocator_type>::deallocate(alloc, this, 1);
             }
 
         private:
-            T* data_;
-            D deleter_;
-
-            /**
-             * We're using a trick where refcount_ > 0
-             * means weak_refcount_ has 1 added to it,
-             * this makes it easier for weak_ptrs that
-             * can't decrement the weak_refcount_ to
-             * zero with shared_ptrs using this object.
-             */
-            refcount_t refcount_;
-            refcount_t weak_refcount_;
+            alignas(T) unsigned char storage_[sizeof(T)];
+            Alloc alloc_;
     };
+
+    template<class T, class Alloc, class... Args>
+    shared_payload_base<T>* make_shared_payload(const Alloc& alloc, Args&&... args)
+    {
+        using alloc_type = typename allocator_traits<Alloc>::template rebind_alloc<T>;
+        using payload_type = shared_payload_inplace<T, alloc_type>;
+        using payload_alloc_type = typename payload_type::allocator_type;
+
+        alloc_type talloc{alloc};
+        payload_alloc_type palloc{alloc};
+        auto payload = allocator_traits<payload_alloc_type>::allocate(palloc, 1);
+
+        try
+        {
+            return ::new(static_cast<void*>(payload)) payload_type{
+                talloc, forward<Args>(args)...
+            };
+        }
+        catch (...)
+        {
+            allocator_traits<payload_alloc_type>::deallocate(palloc, payload, 1);
+
+            throw;
+        }
+
+        return nullptr;
+    }
 }
 
 #endif
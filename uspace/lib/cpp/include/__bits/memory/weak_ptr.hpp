@@ -116,11 +116,7 @@ namespace std
 
             weak_ptr& operator=(const weak_ptr& rhs) noexcept
             {
-                remove_payload_();
-
-                payload_ = rhs.payload_;
-                if (payload_)
-                    payload_->increment_weak();
+                weak_ptr{rhs}.swap(*this);
 
                 return *this;
             }
@@ -191,7 +187,10 @@ namespace std
 
             shared_ptr<T> lock() const noexcept
             {
-                return shared_ptr{aux::payload_tag, payload_->lock()};
+                if (payload_)
+                    return shared_ptr<T>{aux::payload_tag, payload_->lock()};
+                else
+                    return shared_ptr<T>{};
             }
 
             template<class U>
@@ -211,8 +210,8 @@ namespace std
 
             void remove_payload_()
             {
-                if (payload_ && payload_->decrement_weak())
-                    payload_->destroy();
+                if (payload_)
+                    payload_->release_weak();
                 payload_ = nullptr;
             }
 
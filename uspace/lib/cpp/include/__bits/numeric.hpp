@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_NUMERIC
 #define LIBCPP_BITS_NUMERIC
 
+#include <iterator>
 #include <utility>
 
 namespace std
@@ -59,6 +60,42 @@ namespace std
         return acc;
     }
 
+    /**
+     * C++17, reduce:
+     * Note: Unlike accumulate, reduce may apply the operation
+     *       in any order, which is what allows the parallel
+     *       overloads in <execution> to split the range.
+     */
+
+    template<class InputIterator, class T, class BinaryOperation>
+    T reduce(InputIterator first, InputIterator last, T init,
+             BinaryOperation op)
+    {
+        auto acc{init};
+        while (first != last)
+            acc = op(acc, *first++);
+
+        return acc;
+    }
+
+    template<class InputIterator, class T>
+    T reduce(InputIterator first, InputIterator last, T init)
+    {
+        auto acc{init};
+        while (first != last)
+            acc = acc + *first++;
+
+        return acc;
+    }
+
+    template<class InputIterator>
+    auto reduce(InputIterator first, InputIterator last)
+    {
+        using value_type = typename iterator_traits<InputIterator>::value_type;
+
+        return reduce(first, last, value_type{});
+    }
+
     /**
      * 26.7.3, inner product:
      */
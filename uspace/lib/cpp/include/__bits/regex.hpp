@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_REGEX
 #define LIBCPP_BITS_REGEX
 
-#error "<regex> is not implemented"
+#include <__bits/regex/regex_constants.hpp>
+#include <__bits/regex/regex.hpp>
 
 #endif
@@ -0,0 +1,673 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_REGEX_MATCHER
+#define LIBCPP_BITS_REGEX_MATCHER
+
+#include <__bits/regex/program.hpp>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace std::aux
+{
+    template<class CharT>
+    inline uint32_t regex_unit(CharT c)
+    {
+        if constexpr (sizeof(CharT) == 1)
+            return static_cast<unsigned char>(c);
+        else
+            return static_cast<uint32_t>(c);
+    }
+
+    /**
+     * Runs the DFA over the whole input and says whether
+     * it is matched completely.
+     */
+    template<class BidirIt>
+    bool regex_dfa_match(const regex_dfa& dfa, BidirIt first,
+                         BidirIt last, bool not_bol)
+    {
+        uint32_t state = not_bol ? dfa.start_not_bol : dfa.start_bol;
+        for (; first != last; ++first)
+        {
+            state = dfa.step(state, regex_unit(*first));
+            if (state == 0)
+                return false;
+        }
+
+        return dfa.accept_at_end[state];
+    }
+
+    /**
+     * Runs the unanchored DFA and says whether there is
+     * a match anywhere in the input, stops at the first
+     * position where some match ends.
+     */
+    template<class BidirIt>
+    bool regex_dfa_search(const regex_dfa& dfa, BidirIt first,
+                          BidirIt last, bool not_bol)
+    {
+        uint32_t state = not_bol ? dfa.start_not_bol : dfa.start_bol;
+        if (dfa.accept[state])
+            return true;
+
+        for (; first != last; ++first)
+        {
+            state = dfa.step(state, regex_unit(*first));
+            if (dfa.accept[state])
+                return true;
+            else if (state == 0)
+                return false;
+        }
+
+        return dfa.accept_at_end[state];
+    }
+
+    /**
+     * Input and assertions shared by the interpreters below.
+     */
+    template<class BidirIt>
+    class regex_matcher_base
+    {
+        public:
+            regex_matcher_base(const regex_program& prog, BidirIt first,
+                               BidirIt last, regex_constants::match_flag_type flags,
+                               bool full)
+                : prog_{prog}, first_{first}, last_{last}, flags_{flags},
+                  full_{full}
+            { /* DUMMY BODY */ }
+
+        protected:
+            const regex_program& prog_;
+            BidirIt first_;
+            BidirIt last_;
+            regex_constants::match_flag_type flags_;
+            bool full_;
+
+            bool has_prev_(size_t idx) const
+            {
+                return idx > 0 || (flags_ & regex_constants::match_prev_avail);
+            }
+
+            bool at_bol_(BidirIt it, size_t idx) const
+            {
+                bool multiline = prog_.flags & regex_constants::multiline;
+                if (idx == 0 && !(flags_ & regex_constants::match_prev_avail))
+                    return !(flags_ & regex_constants::match_not_bol);
+                else if (multiline)
+                    return regex_is_line_terminator(regex_unit(*std::prev(it)));
+                else
+                    return false;
+            }
+
+            bool at_eol_(BidirIt it) const
+            {
+                bool multiline = prog_.flags & regex_constants::multiline;
+                if (it == last_)
+                    return !(flags_ & regex_constants::match_not_eol);
+                else if (multiline)
+                    return regex_is_line_terminator(regex_unit(*it));
+                else
+                    return false;
+            }
+
+            bool at_word_boundary_(BidirIt it, size_t idx) const
+            {
+                bool prev = has_prev_(idx) && regex_is_word(regex_unit(*std::prev(it)));
+                bool next = it != last_ && regex_is_word(regex_unit(*it));
+
+                if (!has_prev_(idx) && (flags_ & regex_constants::match_not_bow))
+                    return false;
+                if (it == last_ && (flags_ & regex_constants::match_not_eow))
+                    return false;
+
+                return prev != next;
+            }
+
+            /**
+             * Says whether the instruction consuming a character
+             * accepts the character at it.
+             */
+            bool consumes_(const regex_inst& inst, BidirIt it) const
+            {
+                if (it == last_)
+                    return false;
+
+                auto c = regex_unit(*it);
+                switch (inst.op)
+                {
+                    case regex_op::chr:
+                        return c == inst.x;
+                    case regex_op::any:
+                        return !regex_is_line_terminator(c);
+                    case regex_op::cls:
+                        return prog_.classes[inst.x].contains(c);
+                    default:
+                        return false;
+                }
+            }
+    };
+
+    /**
+     * Backtracking interpreter of the program, tries
+     * the alternatives of each split in order, which gives
+     * us ECMAScript's leftmost-first semantics and captures.
+     *
+     * Unless the pattern contains backreferences (in which
+     * case the outcome depends on the captured text), reaching
+     * a (pc, position) pair for the second time can never
+     * succeed, so we remember the visited pairs in a bitmap
+     * which bounds the work by the product of the program
+     * and input sizes. The bitmap stays valid across start
+     * positions, so an unsuccessful regex_search is linear
+     * in the input as well. If the bitmap would be too large,
+     * regex_pike is used instead (see memoizable). Patterns
+     * with backreferences are not memoized, the number of steps
+     * from a single start position is bounded instead and
+     * exceeding it is reported as error_complexity.
+     */
+    template<class BidirIt>
+    class regex_backtracker: public regex_matcher_base<BidirIt>
+    {
+        using base_t = regex_matcher_base<BidirIt>;
+
+        public:
+            regex_backtracker(const regex_program& prog, BidirIt first,
+                              BidirIt last, regex_constants::match_flag_type flags,
+                              bool full, size_t len)
+                : base_t{prog, first, last, flags, full},
+                  len_{len}, visited_{}, stack_{},
+                  slots_(2 * prog.groups, last), set_(2 * prog.groups, 0),
+                  steps_{}, complexity_{}
+            {
+                if (!prog.has_backrefs)
+                    visited_.resize((prog.insts.size() * (len_ + 1) + 63) / 64);
+            }
+
+            /**
+             * Says whether the visited bitmap for a program without
+             * backreferences and an input of length len fits
+             * into the limit.
+             */
+            static bool memoizable(const regex_program& prog, size_t len)
+            {
+                return prog.insts.size() * (len + 1) <= max_visited_bits_;
+            }
+
+            /**
+             * Tries to find a match that starts at start,
+             * idx is the distance of start from the beginning
+             * of the input.
+             */
+            bool run(BidirIt start, size_t idx)
+            {
+                for (auto& s: set_)
+                    s = 0;
+                stack_.clear();
+                stack_.push_back(frame{start, idx, 0, 0, 0});
+                steps_ = 0;
+
+                while (!stack_.empty())
+                {
+                    frame f = stack_.back();
+                    stack_.pop_back();
+
+                    if (f.restore)
+                    {
+                        slots_[f.restore - 1] = f.it;
+                        set_[f.restore - 1] = f.was_set;
+                        continue;
+                    }
+
+                    if (try_(start, f.it, f.idx, f.pc))
+                        return true;
+                    if (complexity_)
+                        return false;
+                }
+
+                return false;
+            }
+
+            bool complexity_exceeded() const
+            {
+                return complexity_;
+            }
+
+            BidirIt slot(size_t i) const
+            {
+                return slots_[i];
+            }
+
+            bool slot_set(size_t i) const
+            {
+                return set_[i];
+            }
+
+        private:
+            struct frame
+            {
+                BidirIt it;
+                size_t idx;
+                uint32_t pc;
+                uint32_t restore;
+                uint8_t was_set;
+            };
+
+            static constexpr size_t max_visited_bits_{size_t{1} << 25};
+            static constexpr size_t max_steps_{size_t{1} << 24};
+
+            size_t len_;
+            vector<uint64_t> visited_;
+            vector<frame> stack_;
+            vector<BidirIt> slots_;
+            vector<uint8_t> set_;
+            size_t steps_;
+            bool complexity_;
+
+            bool visit_(uint32_t pc, size_t idx)
+            {
+                if (visited_.empty())
+                {
+                    if (++steps_ > max_steps_)
+                    {
+                        complexity_ = true;
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                size_t bit = pc * (len_ + 1) + idx;
+                uint64_t mask = uint64_t{1} << (bit & 63);
+                if (visited_[bit >> 6] & mask)
+                    return false;
+                visited_[bit >> 6] |= mask;
+
+                return true;
+            }
+
+            bool backref_(BidirIt& it, size_t& idx, uint32_t group)
+            {
+                // ECMAScript: unset groups match the empty string.
+                if (!set_[2 * group] || !set_[2 * group + 1])
+                    return true;
+
+                bool icase = this->prog_.flags & regex_constants::icase;
+                auto curr = it;
+                auto ref = slots_[2 * group];
+                auto ref_end = slots_[2 * group + 1];
+                size_t count{};
+                for (; ref != ref_end; ++ref, ++curr, ++count)
+                {
+                    if (curr == this->last_)
+                        return false;
+
+                    auto lhs = regex_unit(*ref);
+                    auto rhs = regex_unit(*curr);
+                    if (icase ? regex_fold(lhs) != regex_fold(rhs) : lhs != rhs)
+                        return false;
+                }
+
+                it = curr;
+                idx += count;
+
+                return true;
+            }
+
+            bool try_(BidirIt start, BidirIt it, size_t idx, uint32_t pc)
+            {
+                while (true)
+                {
+                    if (!visit_(pc, idx))
+                        return false;
+
+                    const auto& inst = this->prog_.insts[pc];
+                    switch (inst.op)
+                    {
+                        case regex_op::match:
+                            if (this->full_ && it != this->last_)
+                                return false;
+                            if ((this->flags_ & regex_constants::match_not_null) && it == start)
+                                return false;
+
+                            slots_[0] = start;
+                            set_[0] = 1;
+                            slots_[1] = it;
+                            set_[1] = 1;
+
+                            return true;
+                        case regex_op::chr:
+                        case regex_op::any:
+                        case regex_op::cls:
+                            if (!this->consumes_(inst, it))
+                                return false;
+                            ++it;
+                            ++idx;
+                            ++pc;
+                            break;
+                        case regex_op::split:
+                            stack_.push_back(frame{it, idx, inst.y, 0, 0});
+                            pc = inst.x;
+                            break;
+                        case regex_op::jmp:
+                            pc = inst.x;
+                            break;
+                        case regex_op::save:
+                            stack_.push_back(frame{
+                                slots_[inst.x], 0, 0, inst.x + 1, set_[inst.x]
+                            });
+                            slots_[inst.x] = it;
+                            set_[inst.x] = 1;
+                            ++pc;
+                            break;
+                        case regex_op::bol:
+                            if (!this->at_bol_(it, idx))
+                                return false;
+                            ++pc;
+                            break;
+                        case regex_op::eol:
+                            if (!this->at_eol_(it))
+                                return false;
+                            ++pc;
+                            break;
+                        case regex_op::word_boundary:
+                            if (!this->at_word_boundary_(it, idx))
+                                return false;
+                            ++pc;
+                            break;
+                        case regex_op::not_word_boundary:
+                            if (this->at_word_boundary_(it, idx))
+                                return false;
+                            ++pc;
+                            break;
+                        case regex_op::backref:
+                            if (!backref_(it, idx, inst.x))
+                                return false;
+                            ++pc;
+                            break;
+                    }
+                }
+            }
+    };
+
+    /**
+     * Thompson simulation of a program without backreferences
+     * (Pike's VM), used when the input is too long for the visited
+     * bitmap of regex_backtracker. All threads advance over the input
+     * together, ordered by priority, so the first thread to reach
+     * match gives the same (leftmost-first) result as backtracking.
+     * Each thread carries its own captures. A search adds a thread
+     * starting at each position with the lowest priority, so it
+     * takes a single pass over the input.
+     */
+    template<class BidirIt>
+    class regex_pike: public regex_matcher_base<BidirIt>
+    {
+        using base_t = regex_matcher_base<BidirIt>;
+
+        public:
+            regex_pike(const regex_program& prog, BidirIt first,
+                       BidirIt last, regex_constants::match_flag_type flags,
+                       bool full)
+                : base_t{prog, first, last, flags, full},
+                  nslots_{2 * prog.groups}, lists_{
+                      thread_list{prog.insts.size(), nslots_, last},
+                      thread_list{prog.insts.size(), nslots_, last}
+                  },
+                  stack_{}, slots_(nslots_, last), set_(nslots_, 0),
+                  match_slots_(nslots_, last), match_set_(nslots_, 0)
+            { /* DUMMY BODY */ }
+
+            /**
+             * Finds the match starting at start or, if search is
+             * true, at the first position after it where there is
+             * one, idx is the distance of start from the beginning
+             * of the input.
+             */
+            bool run(BidirIt start, size_t idx, bool search)
+            {
+                auto* curr = &lists_[0];
+                auto* next = &lists_[1];
+                curr->clear();
+
+                bool matched{};
+                auto it = start;
+                while (true)
+                {
+                    bool can_start = it == this->last_ ||
+                        this->prog_.can_start_with(regex_unit(*it));
+                    if (!matched && (it == start || search) && can_start)
+                    {
+                        for (size_t i = 0; i < nslots_; ++i)
+                            set_[i] = 0;
+                        slots_[0] = it;
+                        set_[0] = 1;
+                        add_(*curr, 0, it, idx);
+                    }
+
+                    if (curr->count == 0 && (matched || !search || it == this->last_))
+                        break;
+
+                    next->clear();
+                    for (size_t i = 0; i < curr->count; ++i)
+                    {
+                        uint32_t pc = curr->pcs[i];
+                        const auto& inst = this->prog_.insts[pc];
+                        auto* caps = &curr->slots[i * nslots_];
+                        auto* caps_set = &curr->set[i * nslots_];
+
+                        if (inst.op == regex_op::match)
+                        {
+                            if (this->full_ && it != this->last_)
+                                continue;
+                            if ((this->flags_ & regex_constants::match_not_null) &&
+                                it == caps[0])
+                                continue;
+
+                            for (size_t j = 0; j < nslots_; ++j)
+                            {
+                                match_slots_[j] = caps[j];
+                                match_set_[j] = caps_set[j];
+                            }
+                            match_slots_[1] = it;
+                            match_set_[1] = 1;
+                            matched = true;
+
+                            // Threads with lower priority cannot win.
+                            break;
+                        }
+                        else if (this->consumes_(inst, it))
+                        {
+                            for (size_t j = 0; j < nslots_; ++j)
+                            {
+                                slots_[j] = caps[j];
+                                set_[j] = caps_set[j];
+                            }
+                            add_(*next, pc + 1, std::next(it), idx + 1);
+                        }
+                    }
+
+                    if (it == this->last_)
+                        break;
+
+                    std::swap(curr, next);
+                    ++it;
+                    ++idx;
+                }
+
+                return matched;
+            }
+
+            bool complexity_exceeded() const
+            {
+                return false;
+            }
+
+            BidirIt slot(size_t i) const
+            {
+                return match_slots_[i];
+            }
+
+            bool slot_set(size_t i) const
+            {
+                return match_set_[i];
+            }
+
+        private:
+            /**
+             * Threads at one position, kept as a sparse set
+             * of program counters in the order of priority.
+             */
+            struct thread_list
+            {
+                thread_list(size_t insts, size_t nslots, BidirIt last)
+                    : pcs(insts), index(insts), slots(insts * nslots, last),
+                      set(insts * nslots), count{}
+                { /* DUMMY BODY */ }
+
+                vector<uint32_t> pcs;
+                vector<uint32_t> index;
+                vector<BidirIt> slots;
+                vector<uint8_t> set;
+                size_t count;
+
+                void clear()
+                {
+                    count = 0;
+                }
+
+                bool contains(uint32_t pc) const
+                {
+                    return index[pc] < count && pcs[index[pc]] == pc;
+                }
+            };
+
+            struct frame
+            {
+                BidirIt it;
+                uint32_t pc;
+                uint32_t restore;
+                uint8_t was_set;
+            };
+
+            size_t nslots_;
+            thread_list lists_[2];
+            vector<frame> stack_;
+            vector<BidirIt> slots_;
+            vector<uint8_t> set_;
+            vector<BidirIt> match_slots_;
+            vector<uint8_t> match_set_;
+
+            /**
+             * Adds the thread at pc with the captures in slots_
+             * to the list, following the instructions that do not
+             * consume input in the order of priority.
+             */
+            void add_(thread_list& list, uint32_t pc, BidirIt it, size_t idx)
+            {
+                stack_.clear();
+                stack_.push_back(frame{it, pc, 0, 0});
+
+                while (!stack_.empty())
+                {
+                    frame f = stack_.back();
+                    stack_.pop_back();
+
+                    if (f.restore)
+                    {
+                        slots_[f.restore - 1] = f.it;
+                        set_[f.restore - 1] = f.was_set;
+                        continue;
+                    }
+
+                    pc = f.pc;
+                    while (!list.contains(pc))
+                    {
+                        size_t i = list.count++;
+                        list.pcs[i] = pc;
+                        list.index[pc] = i;
+
+                        const auto& inst = this->prog_.insts[pc];
+                        bool cont{};
+                        switch (inst.op)
+                        {
+                            case regex_op::split:
+                                stack_.push_back(frame{it, inst.y, 0, 0});
+                                pc = inst.x;
+                                cont = true;
+                                break;
+                            case regex_op::jmp:
+                                pc = inst.x;
+                                cont = true;
+                                break;
+                            case regex_op::save:
+                                stack_.push_back(frame{
+                                    slots_[inst.x], 0, inst.x + 1, set_[inst.x]
+                                });
+                                slots_[inst.x] = it;
+                                set_[inst.x] = 1;
+                                ++pc;
+                                cont = true;
+                                break;
+                            case regex_op::bol:
+                                cont = this->at_bol_(it, idx);
+                                ++pc;
+                                break;
+                            case regex_op::eol:
+                                cont = this->at_eol_(it);
+                                ++pc;
+                                break;
+                            case regex_op::word_boundary:
+                                cont = this->at_word_boundary_(it, idx);
+                                ++pc;
+                                break;
+                            case regex_op::not_word_boundary:
+                                cont = !this->at_word_boundary_(it, idx);
+                                ++pc;
+                                break;
+                            default:
+                                // Consumes input or matches, keep the captures.
+                                for (size_t j = 0; j < nslots_; ++j)
+                                {
+                                    list.slots[i * nslots_ + j] = slots_[j];
+                                    list.set[i * nslots_ + j] = set_[j];
+                                }
+                                break;
+                        }
+
+                        if (!cont)
+                            break;
+                    }
+                }
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_REGEX_PROGRAM
+#define LIBCPP_BITS_REGEX_PROGRAM
+
+#include <__bits/regex/regex_constants.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace std::aux
+{
+    /**
+     * Patterns are compiled into a program for a Thompson-style
+     * automaton, the same program is then either interpreted by
+     * a backtracking matcher (which gives us ECMAScript captures
+     * and backreferences) or converted into a DFA (which gives us
+     * a fast yes/no answer).
+     */
+
+    enum class regex_op: uint8_t
+    {
+        match,             // accept
+        chr,               // code unit x
+        any,               // any code unit except line terminators
+        cls,               // code unit in classes[x]
+        split,             // try x, then y
+        jmp,               // continue at x
+        save,              // capture slot x = current position
+        bol,               // ^
+        eol,               // $
+        word_boundary,     // \b
+        not_word_boundary, // \B
+        backref            // text of group x
+    };
+
+    struct regex_inst
+    {
+        regex_op op;
+        uint32_t x;
+        uint32_t y;
+    };
+
+    /**
+     * Bracket expressions and class escapes. Code units that fit
+     * into a byte are looked up in a bitmap (with negation already
+     * applied), wider ones go through the list of ranges.
+     */
+    struct regex_class
+    {
+        uint64_t bits[4]{};
+        vector<pair<uint32_t, uint32_t>> ranges{};
+        bool negated{};
+
+        bool contains(uint32_t c) const
+        {
+            if (c < 256)
+                return (bits[c >> 6] >> (c & 63)) & 1;
+
+            bool found{false};
+            for (const auto& r: ranges)
+            {
+                if (r.first <= c && c <= r.second)
+                {
+                    found = true;
+                    break;
+                }
+            }
+
+            return found != negated;
+        }
+
+        void add(uint32_t c)
+        {
+            if (c < 256)
+                bits[c >> 6] |= uint64_t{1} << (c & 63);
+            else
+                ranges.emplace_back(c, c);
+        }
+
+        void add(uint32_t first, uint32_t last);
+    };
+
+    /**
+     * Deterministic automaton over bytes, only built for narrow
+     * character patterns without backreferences and word boundaries.
+     * State 0 is the dead state, bytes are first mapped to
+     * equivalence classes so that the transition table stays small.
+     */
+    struct regex_dfa
+    {
+        vector<uint32_t> next{};
+        vector<uint8_t> accept{};
+        vector<uint8_t> accept_at_end{};
+        uint8_t byte_class[256]{};
+        uint32_t classes{};
+        uint32_t start_bol{};
+        uint32_t start_not_bol{};
+        bool built{};
+
+        uint32_t step(uint32_t state, unsigned char c) const
+        {
+            return next[state * classes + byte_class[c]];
+        }
+    };
+
+    struct regex_program
+    {
+        vector<regex_inst> insts{};
+        vector<regex_class> classes{};
+
+        /**
+         * Number of capture groups, including
+         * the whole match.
+         */
+        size_t groups{};
+
+        /**
+         * Bytes a match can start with, all of
+         * them if the pattern can match the empty
+         * string or starts with an assertion.
+         */
+        uint64_t first_bytes[4]{};
+
+        regex_dfa anchored{};
+        regex_dfa unanchored{};
+
+        regex_constants::syntax_option_type flags{};
+        regex_constants::error_type error{};
+        bool valid{};
+        bool has_backrefs{};
+
+        bool can_start_with(uint32_t c) const
+        {
+            if (c >= 256)
+                return true;
+            return (first_bytes[c >> 6] >> (c & 63)) & 1;
+        }
+    };
+
+    /**
+     * Compiles the pattern (given as a sequence of code units)
+     * into prog, on failure prog.valid is false and prog.error
+     * says why. The DFAs are only built for narrow (single byte)
+     * character types.
+     */
+    void regex_compile(regex_program& prog, const uint32_t* pattern,
+                       size_t size, regex_constants::syntax_option_type flags,
+                       bool narrow);
+
+    inline bool regex_is_line_terminator(uint32_t c)
+    {
+        return c == '\n' || c == '\r' || c == 0x2028 || c == 0x2029;
+    }
+
+    inline bool regex_is_word(uint32_t c)
+    {
+        return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+               ('0' <= c && c <= '9') || c == '_';
+    }
+
+    inline uint32_t regex_fold(uint32_t c)
+    {
+        if ('A' <= c && c <= 'Z')
+            return c + ('a' - 'A');
+        return c;
+    }
+}
+
+#endif
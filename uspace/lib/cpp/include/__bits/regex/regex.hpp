@@ -0,0 +1,1269 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_REGEX_REGEX
+#define LIBCPP_BITS_REGEX_REGEX
+
+#include <__bits/regex/matcher.hpp>
+#include <__bits/regex/program.hpp>
+#include <__bits/regex/regex_constants.hpp>
+#include <algorithm>
+#include <initializer_list>
+#include <iosfwd>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+    namespace aux
+    {
+        struct regex_access;
+    }
+
+    /**
+     * 28.7, class template regex_traits:
+     *
+     * Note: The engine works with code units directly and classifies
+     *       them the same way in every locale, the traits are provided
+     *       for interface compatibility.
+     */
+
+    template<class CharT>
+    struct regex_traits
+    {
+        using char_type   = CharT;
+        using string_type = basic_string<char_type>;
+
+        static size_t length(const char_type* p)
+        {
+            return char_traits<char_type>::length(p);
+        }
+
+        char_type translate(char_type c) const
+        {
+            return c;
+        }
+
+        char_type translate_nocase(char_type c) const
+        {
+            if (char_type{'A'} <= c && c <= char_type{'Z'})
+                return static_cast<char_type>(c + ('a' - 'A'));
+            return c;
+        }
+
+        int value(char_type c, int radix) const
+        {
+            int res{-1};
+            if (char_type{'0'} <= c && c <= char_type{'9'})
+                res = c - '0';
+            else if (char_type{'a'} <= c && c <= char_type{'f'})
+                res = c - 'a' + 10;
+            else if (char_type{'A'} <= c && c <= char_type{'F'})
+                res = c - 'A' + 10;
+
+            return res < radix ? res : -1;
+        }
+    };
+
+    /**
+     * 28.8, class template basic_regex:
+     *
+     * Patterns use the ECMAScript grammar (without lookahead
+     * assertions), the other grammar flags are accepted but
+     * parsed the same way.
+     */
+
+    template<class CharT, class Traits = regex_traits<CharT>>
+    class basic_regex
+    {
+        public:
+            using value_type  = CharT;
+            using traits_type = Traits;
+            using string_type = typename Traits::string_type;
+            using flag_type   = regex_constants::syntax_option_type;
+
+            /**
+             * 28.8.1, constants:
+             */
+
+            static constexpr flag_type icase      = regex_constants::icase;
+            static constexpr flag_type nosubs     = regex_constants::nosubs;
+            static constexpr flag_type optimize   = regex_constants::optimize;
+            static constexpr flag_type collate    = regex_constants::collate;
+            static constexpr flag_type ECMAScript = regex_constants::ECMAScript;
+            static constexpr flag_type basic      = regex_constants::basic;
+            static constexpr flag_type extended   = regex_constants::extended;
+            static constexpr flag_type awk        = regex_constants::awk;
+            static constexpr flag_type grep       = regex_constants::grep;
+            static constexpr flag_type egrep      = regex_constants::egrep;
+            static constexpr flag_type multiline  = regex_constants::multiline;
+
+            /**
+             * 28.8.2, construct/copy/destroy:
+             */
+
+            basic_regex()
+                : flags_{ECMAScript}, program_{}
+            { /* DUMMY BODY */ }
+
+            explicit basic_regex(const value_type* p, flag_type f = ECMAScript)
+                : basic_regex{}
+            {
+                assign(p, f);
+            }
+
+            basic_regex(const value_type* p, size_t len, flag_type f = ECMAScript)
+                : basic_regex{}
+            {
+                assign(p, len, f);
+            }
+
+            basic_regex(const basic_regex&) = default;
+
+            basic_regex(basic_regex&&) noexcept = default;
+
+            template<class ST, class SA>
+            explicit basic_regex(const basic_string<value_type, ST, SA>& str,
+                                 flag_type f = ECMAScript)
+                : basic_regex{}
+            {
+                assign(str, f);
+            }
+
+            template<class ForwardIterator>
+            basic_regex(ForwardIterator first, ForwardIterator last,
+                        flag_type f = ECMAScript)
+                : basic_regex{}
+            {
+                assign(first, last, f);
+            }
+
+            basic_regex(initializer_list<value_type> init, flag_type f = ECMAScript)
+                : basic_regex{}
+            {
+                assign(init.begin(), init.end(), f);
+            }
+
+            ~basic_regex() = default;
+
+            basic_regex& operator=(const basic_regex&) = default;
+
+            basic_regex& operator=(basic_regex&&) noexcept = default;
+
+            basic_regex& operator=(const value_type* p)
+            {
+                return assign(p);
+            }
+
+            basic_regex& operator=(initializer_list<value_type> init)
+            {
+                return assign(init.begin(), init.end());
+            }
+
+            template<class ST, class SA>
+            basic_regex& operator=(const basic_string<value_type, ST, SA>& str)
+            {
+                return assign(str);
+            }
+
+            /**
+             * 28.8.3, assign:
+             */
+
+            basic_regex& assign(const basic_regex& other)
+            {
+                return *this = other;
+            }
+
+            basic_regex& assign(basic_regex&& other) noexcept
+            {
+                return *this = move(other);
+            }
+
+            basic_regex& assign(const value_type* p, flag_type f = ECMAScript)
+            {
+                return assign(p, p + traits_type::length(p), f);
+            }
+
+            basic_regex& assign(const value_type* p, size_t len, flag_type f = ECMAScript)
+            {
+                return assign(p, p + len, f);
+            }
+
+            template<class ST, class SA>
+            basic_regex& assign(const basic_string<value_type, ST, SA>& str,
+                                flag_type f = ECMAScript)
+            {
+                return assign(str.begin(), str.end(), f);
+            }
+
+            template<class InputIterator>
+            basic_regex& assign(InputIterator first, InputIterator last,
+                                flag_type f = ECMAScript)
+            {
+                vector<uint32_t> units{};
+                for (; first != last; ++first)
+                    units.push_back(aux::regex_unit(static_cast<value_type>(*first)));
+
+                auto prog = make_shared<aux::regex_program>();
+                aux::regex_compile(*prog, units.data(), units.size(), f,
+                                   sizeof(value_type) == 1);
+
+                flags_ = f;
+                program_ = move(prog);
+                if (!program_->valid)
+                    throw regex_error{program_->error};
+
+                return *this;
+            }
+
+            basic_regex& assign(initializer_list<value_type> init,
+                                flag_type f = ECMAScript)
+            {
+                return assign(init.begin(), init.end(), f);
+            }
+
+            /**
+             * 28.8.4, const operations:
+             */
+
+            unsigned mark_count() const
+            {
+                if (!program_ || (flags_ & nosubs))
+                    return 0;
+                return static_cast<unsigned>(program_->groups - 1);
+            }
+
+            flag_type flags() const
+            {
+                return flags_;
+            }
+
+            /**
+             * 28.8.6, swap:
+             */
+
+            void swap(basic_regex& other)
+            {
+                std::swap(flags_, other.flags_);
+                std::swap(program_, other.program_);
+            }
+
+        private:
+            flag_type flags_;
+
+            /**
+             * Compiled programs are never modified after
+             * compilation, so copies of a regex share them.
+             */
+            shared_ptr<aux::regex_program> program_;
+
+            friend struct aux::regex_access;
+    };
+
+    template<class CharT, class Traits>
+    void swap(basic_regex<CharT, Traits>& lhs, basic_regex<CharT, Traits>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    using regex  = basic_regex<char>;
+    using wregex = basic_regex<wchar_t>;
+
+    /**
+     * 28.9, class template sub_match:
+     */
+
+    template<class BidirectionalIterator>
+    class sub_match: public pair<BidirectionalIterator, BidirectionalIterator>
+    {
+        public:
+            using value_type      = typename iterator_traits<BidirectionalIterator>::value_type;
+            using difference_type = typename iterator_traits<BidirectionalIterator>::difference_type;
+            using iterator        = BidirectionalIterator;
+            using string_type     = basic_string<value_type>;
+
+            bool matched;
+
+            constexpr sub_match()
+                : pair<iterator, iterator>{}, matched{false}
+            { /* DUMMY BODY */ }
+
+            difference_type length() const
+            {
+                if (matched)
+                    return std::distance(this->first, this->second);
+                return 0;
+            }
+
+            operator string_type() const
+            {
+                return str();
+            }
+
+            string_type str() const
+            {
+                if (matched)
+                    return string_type(this->first, this->second);
+                return string_type{};
+            }
+
+            int compare(const sub_match& other) const
+            {
+                return str().compare(other.str());
+            }
+
+            int compare(const string_type& str) const
+            {
+                return this->str().compare(str);
+            }
+
+            int compare(const value_type* str) const
+            {
+                return this->str().compare(str);
+            }
+    };
+
+    using csub_match  = sub_match<const char*>;
+    using wcsub_match = sub_match<const wchar_t*>;
+    using ssub_match  = sub_match<string::const_iterator>;
+    using wssub_match = sub_match<wstring::const_iterator>;
+
+    /**
+     * 28.9.2, sub_match non-member operators:
+     */
+
+    template<class BiIter>
+    bool operator==(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator!=(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) != 0;
+    }
+
+    template<class BiIter>
+    bool operator<(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) < 0;
+    }
+
+    template<class BiIter>
+    bool operator==(const sub_match<BiIter>& lhs,
+                    const typename sub_match<BiIter>::string_type& rhs)
+    {
+        return lhs.compare(rhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator==(const typename sub_match<BiIter>::string_type& lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return rhs.compare(lhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator!=(const sub_match<BiIter>& lhs,
+                    const typename sub_match<BiIter>::string_type& rhs)
+    {
+        return lhs.compare(rhs) != 0;
+    }
+
+    template<class BiIter>
+    bool operator!=(const typename sub_match<BiIter>::string_type& lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return rhs.compare(lhs) != 0;
+    }
+
+    template<class BiIter>
+    bool operator==(const sub_match<BiIter>& lhs,
+                    const typename sub_match<BiIter>::value_type* rhs)
+    {
+        return lhs.compare(rhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator==(const typename sub_match<BiIter>::value_type* lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return rhs.compare(lhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator!=(const sub_match<BiIter>& lhs,
+                    const typename sub_match<BiIter>::value_type* rhs)
+    {
+        return lhs.compare(rhs) != 0;
+    }
+
+    template<class BiIter>
+    bool operator!=(const typename sub_match<BiIter>::value_type* lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return rhs.compare(lhs) != 0;
+    }
+
+    template<class Char, class Traits, class BiIter>
+    basic_ostream<Char, Traits>& operator<<(basic_ostream<Char, Traits>& os,
+                                            const sub_match<BiIter>& m)
+    {
+        return os << m.str();
+    }
+
+    /**
+     * 28.10, class template match_results:
+     */
+
+    template<
+        class BidirectionalIterator,
+        class Allocator = allocator<sub_match<BidirectionalIterator>>
+    >
+    class match_results
+    {
+        public:
+            using value_type      = sub_match<BidirectionalIterator>;
+            using const_reference = const value_type&;
+            using reference       = value_type&;
+            using const_iterator  = typename vector<value_type, Allocator>::const_iterator;
+            using iterator        = const_iterator;
+            using difference_type = typename iterator_traits<BidirectionalIterator>::difference_type;
+            using size_type       = typename allocator_traits<Allocator>::size_type;
+            using allocator_type  = Allocator;
+            using char_type       = typename iterator_traits<BidirectionalIterator>::value_type;
+            using string_type     = basic_string<char_type>;
+
+            /**
+             * 28.10.1, construct/copy/destroy:
+             */
+
+            explicit match_results(const Allocator& alloc = Allocator{})
+                : subs_{alloc}, prefix_{}, suffix_{}, unmatched_{},
+                  base_{}, ready_{false}
+            { /* DUMMY BODY */ }
+
+            match_results(const match_results&) = default;
+
+            match_results(match_results&&) noexcept = default;
+
+            match_results& operator=(const match_results&) = default;
+
+            match_results& operator=(match_results&&) = default;
+
+            ~match_results() = default;
+
+            /**
+             * 28.10.2, state:
+             */
+
+            bool ready() const
+            {
+                return ready_;
+            }
+
+            /**
+             * 28.10.3, size:
+             */
+
+            size_type size() const
+            {
+                return subs_.size();
+            }
+
+            size_type max_size() const
+            {
+                return subs_.max_size();
+            }
+
+            bool empty() const
+            {
+                return subs_.empty();
+            }
+
+            /**
+             * 28.10.4, element access:
+             */
+
+            difference_type length(size_type sub = 0) const
+            {
+                return (*this)[sub].length();
+            }
+
+            difference_type position(size_type sub = 0) const
+            {
+                return std::distance(base_, (*this)[sub].first);
+            }
+
+            string_type str(size_type sub = 0) const
+            {
+                return (*this)[sub].str();
+            }
+
+            const_reference operator[](size_type n) const
+            {
+                if (n < subs_.size())
+                    return subs_[n];
+                return unmatched_;
+            }
+
+            const_reference prefix() const
+            {
+                return prefix_;
+            }
+
+            const_reference suffix() const
+            {
+                return suffix_;
+            }
+
+            const_iterator begin() const
+            {
+                return subs_.begin();
+            }
+
+            const_iterator end() const
+            {
+                return subs_.end();
+            }
+
+            const_iterator cbegin() const
+            {
+                return subs_.cbegin();
+            }
+
+            const_iterator cend() const
+            {
+                return subs_.cend();
+            }
+
+            /**
+             * 28.10.5, format:
+             */
+
+            template<class OutputIter>
+            OutputIter format(
+                OutputIter out, const char_type* fmt_first, const char_type* fmt_last,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                if (flags & regex_constants::format_sed)
+                    return format_sed_(out, fmt_first, fmt_last);
+
+                while (fmt_first != fmt_last)
+                {
+                    auto c = *fmt_first++;
+                    if (c != char_type{'$'} || fmt_first == fmt_last)
+                    {
+                        *out++ = c;
+                        continue;
+                    }
+
+                    auto next = *fmt_first;
+                    if (next == char_type{'$'})
+                    {
+                        *out++ = next;
+                        ++fmt_first;
+                    }
+                    else if (next == char_type{'&'})
+                    {
+                        out = copy_(out, (*this)[0]);
+                        ++fmt_first;
+                    }
+                    else if (next == char_type{'`'})
+                    {
+                        out = copy_(out, prefix_);
+                        ++fmt_first;
+                    }
+                    else if (next == char_type{'\''})
+                    {
+                        out = copy_(out, suffix_);
+                        ++fmt_first;
+                    }
+                    else if (is_digit_(next))
+                    {
+                        size_type n = next - '0';
+                        ++fmt_first;
+
+                        // Two digit references are used only if such group exists.
+                        if (fmt_first != fmt_last && is_digit_(*fmt_first))
+                        {
+                            size_type n2 = n * 10 + (*fmt_first - '0');
+                            if (n2 < size())
+                            {
+                                n = n2;
+                                ++fmt_first;
+                            }
+                        }
+
+                        out = copy_(out, (*this)[n]);
+                    }
+                    else
+                        *out++ = c;
+                }
+
+                return out;
+            }
+
+            template<class OutputIter, class ST, class SA>
+            OutputIter format(
+                OutputIter out, const basic_string<char_type, ST, SA>& fmt,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                return format(out, fmt.data(), fmt.data() + fmt.size(), flags);
+            }
+
+            template<class ST, class SA>
+            basic_string<char_type, ST, SA> format(
+                const basic_string<char_type, ST, SA>& fmt,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                basic_string<char_type, ST, SA> res{};
+                format(back_inserter(res), fmt, flags);
+
+                return res;
+            }
+
+            string_type format(
+                const char_type* fmt,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                string_type res{};
+                format(back_inserter(res), fmt,
+                       fmt + char_traits<char_type>::length(fmt), flags);
+
+                return res;
+            }
+
+            /**
+             * 28.10.6, allocator:
+             */
+
+            allocator_type get_allocator() const
+            {
+                return subs_.get_allocator();
+            }
+
+            /**
+             * 28.10.7, swap:
+             */
+
+            void swap(match_results& other)
+            {
+                std::swap(subs_, other.subs_);
+                std::swap(prefix_, other.prefix_);
+                std::swap(suffix_, other.suffix_);
+                std::swap(unmatched_, other.unmatched_);
+                std::swap(base_, other.base_);
+                std::swap(ready_, other.ready_);
+            }
+
+        private:
+            vector<value_type, Allocator> subs_;
+            value_type prefix_;
+            value_type suffix_;
+            value_type unmatched_;
+            BidirectionalIterator base_;
+            bool ready_;
+
+            static bool is_digit_(char_type c)
+            {
+                return char_type{'0'} <= c && c <= char_type{'9'};
+            }
+
+            template<class OutputIter>
+            static OutputIter copy_(OutputIter out, const value_type& sub)
+            {
+                if (sub.matched)
+                    return std::copy(sub.first, sub.second, out);
+                return out;
+            }
+
+            template<class OutputIter>
+            OutputIter format_sed_(OutputIter out, const char_type* fmt_first,
+                                   const char_type* fmt_last) const
+            {
+                while (fmt_first != fmt_last)
+                {
+                    auto c = *fmt_first++;
+                    if (c == char_type{'&'})
+                        out = copy_(out, (*this)[0]);
+                    else if (c == char_type{'\\'} && fmt_first != fmt_last)
+                    {
+                        auto next = *fmt_first++;
+                        if (is_digit_(next))
+                            out = copy_(out, (*this)[next - '0']);
+                        else
+                            *out++ = next;
+                    }
+                    else
+                        *out++ = c;
+                }
+
+                return out;
+            }
+
+            friend struct aux::regex_access;
+    };
+
+    template<class BidirectionalIterator, class Allocator>
+    bool operator==(const match_results<BidirectionalIterator, Allocator>& lhs,
+                    const match_results<BidirectionalIterator, Allocator>& rhs)
+    {
+        if (!lhs.ready() || !rhs.ready())
+            return !lhs.ready() && !rhs.ready();
+        if (lhs.empty() || rhs.empty())
+            return lhs.empty() && rhs.empty();
+
+        return lhs.prefix() == rhs.prefix() && lhs.suffix() == rhs.suffix() &&
+               std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    template<class BidirectionalIterator, class Allocator>
+    bool operator!=(const match_results<BidirectionalIterator, Allocator>& lhs,
+                    const match_results<BidirectionalIterator, Allocator>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class BidirectionalIterator, class Allocator>
+    void swap(match_results<BidirectionalIterator, Allocator>& lhs,
+              match_results<BidirectionalIterator, Allocator>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    using cmatch  = match_results<const char*>;
+    using wcmatch = match_results<const wchar_t*>;
+    using smatch  = match_results<string::const_iterator>;
+    using wsmatch = match_results<wstring::const_iterator>;
+
+    namespace aux
+    {
+        struct regex_access
+        {
+            template<class CharT, class Traits>
+            static const regex_program* program(const basic_regex<CharT, Traits>& re)
+            {
+                return re.program_.get();
+            }
+
+            template<class BidirIt, class Alloc>
+            static void fail(match_results<BidirIt, Alloc>& m, BidirIt last)
+            {
+                m.subs_.clear();
+                m.prefix_ = sub_match<BidirIt>{};
+                m.suffix_ = sub_match<BidirIt>{};
+                m.unmatched_.first = last;
+                m.unmatched_.second = last;
+                m.unmatched_.matched = false;
+                m.ready_ = true;
+            }
+
+            template<class BidirIt, class Alloc, class Matcher>
+            static void fill(match_results<BidirIt, Alloc>& m,
+                             const Matcher& bt, size_t size,
+                             BidirIt base, BidirIt first, BidirIt last)
+            {
+                m.subs_.resize(size);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    auto& sub = m.subs_[i];
+                    sub.matched = bt.slot_set(2 * i) && bt.slot_set(2 * i + 1);
+                    sub.first = sub.matched ? bt.slot(2 * i) : last;
+                    sub.second = sub.matched ? bt.slot(2 * i + 1) : last;
+                }
+
+                m.prefix_.first = first;
+                m.prefix_.second = m.subs_[0].first;
+                m.prefix_.matched = m.prefix_.first != m.prefix_.second;
+                m.suffix_.first = m.subs_[0].second;
+                m.suffix_.second = last;
+                m.suffix_.matched = m.suffix_.first != m.suffix_.second;
+                m.unmatched_.first = last;
+                m.unmatched_.second = last;
+                m.unmatched_.matched = false;
+                m.base_ = base;
+                m.ready_ = true;
+            }
+
+            template<class BidirIt, class Alloc>
+            static void set_prefix_first(match_results<BidirIt, Alloc>& m, BidirIt first)
+            {
+                m.prefix_.first = first;
+                m.prefix_.matched = m.prefix_.first != m.prefix_.second;
+            }
+        };
+
+        /**
+         * Common implementation of regex_match (full) and regex_search.
+         * If the caller does not need the submatches and the flags allow
+         * it, the answer comes from the DFA alone, otherwise the DFA
+         * only filters out inputs without a match before we start
+         * backtracking (or the Thompson simulation when the input
+         * is too long to memoize the backtracking).
+         */
+        template<class BidirIt, class Alloc, class CharT, class Traits>
+        bool regex_run(BidirIt first, BidirIt last, match_results<BidirIt, Alloc>* m,
+                       const basic_regex<CharT, Traits>& re,
+                       regex_constants::match_flag_type flags, bool full,
+                       BidirIt base)
+        {
+            const auto* prog = regex_access::program(re);
+            if (!prog || !prog->valid)
+            {
+                if (m)
+                    regex_access::fail(*m, last);
+                return false;
+            }
+
+            constexpr auto no_dfa = regex_constants::match_not_eol |
+                regex_constants::match_not_bow | regex_constants::match_not_eow |
+                regex_constants::match_not_null | regex_constants::match_continuous;
+            bool not_bol = flags & (regex_constants::match_not_bol |
+                                    regex_constants::match_prev_avail);
+
+            const auto& dfa = full ? prog->anchored : prog->unanchored;
+            if (dfa.built && !(flags & no_dfa))
+            {
+                bool found = full ? regex_dfa_match(dfa, first, last, not_bol)
+                                  : regex_dfa_search(dfa, first, last, not_bol);
+
+                if (!found || !m)
+                {
+                    if (m)
+                        regex_access::fail(*m, last);
+                    return found;
+                }
+            }
+
+            size_t len = static_cast<size_t>(std::distance(first, last));
+            if (!prog->has_backrefs && !regex_backtracker<BidirIt>::memoizable(*prog, len))
+            {
+                bool search = !full && !(flags & regex_constants::match_continuous);
+                regex_pike<BidirIt> vm{*prog, first, last, flags, full};
+                if (vm.run(first, 0, search))
+                {
+                    if (m)
+                        regex_access::fill(*m, vm, re.mark_count() + 1, base, first, last);
+                    return true;
+                }
+
+                if (m)
+                    regex_access::fail(*m, last);
+                return false;
+            }
+
+            regex_backtracker<BidirIt> bt{*prog, first, last, flags, full, len};
+            auto it = first;
+            size_t idx{};
+            while (true)
+            {
+                if (it == last || prog->can_start_with(regex_unit(*it)))
+                {
+                    if (bt.run(it, idx))
+                    {
+                        if (m)
+                            regex_access::fill(*m, bt, re.mark_count() + 1, base, first, last);
+                        return true;
+                    }
+                    else if (bt.complexity_exceeded())
+                    {
+                        throw regex_error{regex_constants::error_complexity};
+                        break;
+                    }
+                }
+
+                if (full || (flags & regex_constants::match_continuous) || it == last)
+                    break;
+                ++it;
+                ++idx;
+            }
+
+            if (m)
+                regex_access::fail(*m, last);
+
+            return false;
+        }
+    }
+
+    /**
+     * 28.11.2, function template regex_match:
+     */
+
+    template<class BidirectionalIterator, class Allocator, class CharT, class Traits>
+    bool regex_match(BidirectionalIterator first, BidirectionalIterator last,
+                     match_results<BidirectionalIterator, Allocator>& m,
+                     const basic_regex<CharT, Traits>& re,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return aux::regex_run(first, last, &m, re, flags, true, first);
+    }
+
+    template<class BidirectionalIterator, class CharT, class Traits>
+    bool regex_match(BidirectionalIterator first, BidirectionalIterator last,
+                     const basic_regex<CharT, Traits>& re,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        match_results<BidirectionalIterator>* m{};
+
+        return aux::regex_run(first, last, m, re, flags, true, first);
+    }
+
+    template<class CharT, class Allocator, class Traits>
+    bool regex_match(const CharT* str, match_results<const CharT*, Allocator>& m,
+                     const basic_regex<CharT, Traits>& re,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(str, str + char_traits<CharT>::length(str), m, re, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class CharT, class Traits>
+    bool regex_match(const basic_string<CharT, ST, SA>& s,
+                     match_results<typename basic_string<CharT, ST, SA>::const_iterator, Allocator>& m,
+                     const basic_regex<CharT, Traits>& re,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(s.begin(), s.end(), m, re, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class CharT, class Traits>
+    bool regex_match(const basic_string<CharT, ST, SA>&&,
+                     match_results<typename basic_string<CharT, ST, SA>::const_iterator, Allocator>&,
+                     const basic_regex<CharT, Traits>&,
+                     regex_constants::match_flag_type = regex_constants::match_default) = delete;
+
+    template<class CharT, class Traits>
+    bool regex_match(const CharT* str, const basic_regex<CharT, Traits>& re,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(str, str + char_traits<CharT>::length(str), re, flags);
+    }
+
+    template<class ST, class SA, class CharT, class Traits>
+    bool regex_match(const basic_string<CharT, ST, SA>& s,
+                     const basic_regex<CharT, Traits>& re,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(s.begin(), s.end(), re, flags);
+    }
+
+    /**
+     * 28.11.3, function template regex_search:
+     */
+
+    template<class BidirectionalIterator, class Allocator, class CharT, class Traits>
+    bool regex_search(BidirectionalIterator first, BidirectionalIterator last,
+                      match_results<BidirectionalIterator, Allocator>& m,
+                      const basic_regex<CharT, Traits>& re,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return aux::regex_run(first, last, &m, re, flags, false, first);
+    }
+
+    template<class BidirectionalIterator, class CharT, class Traits>
+    bool regex_search(BidirectionalIterator first, BidirectionalIterator last,
+                      const basic_regex<CharT, Traits>& re,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        match_results<BidirectionalIterator>* m{};
+
+        return aux::regex_run(first, last, m, re, flags, false, first);
+    }
+
+    template<class CharT, class Allocator, class Traits>
+    bool regex_search(const CharT* str, match_results<const CharT*, Allocator>& m,
+                      const basic_regex<CharT, Traits>& re,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(str, str + char_traits<CharT>::length(str), m, re, flags);
+    }
+
+    template<class CharT, class Traits>
+    bool regex_search(const CharT* str, const basic_regex<CharT, Traits>& re,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(str, str + char_traits<CharT>::length(str), re, flags);
+    }
+
+    template<class ST, class SA, class CharT, class Traits>
+    bool regex_search(const basic_string<CharT, ST, SA>& s,
+                      const basic_regex<CharT, Traits>& re,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(s.begin(), s.end(), re, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class CharT, class Traits>
+    bool regex_search(const basic_string<CharT, ST, SA>& s,
+                      match_results<typename basic_string<CharT, ST, SA>::const_iterator, Allocator>& m,
+                      const basic_regex<CharT, Traits>& re,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(s.begin(), s.end(), m, re, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class CharT, class Traits>
+    bool regex_search(const basic_string<CharT, ST, SA>&&,
+                      match_results<typename basic_string<CharT, ST, SA>::const_iterator, Allocator>&,
+                      const basic_regex<CharT, Traits>&,
+                      regex_constants::match_flag_type = regex_constants::match_default) = delete;
+
+    /**
+     * 28.12.1, class template regex_iterator:
+     */
+
+    template<
+        class BidirectionalIterator,
+        class CharT = typename iterator_traits<BidirectionalIterator>::value_type,
+        class Traits = regex_traits<CharT>
+    >
+    class regex_iterator
+    {
+        public:
+            using regex_type        = basic_regex<CharT, Traits>;
+            using value_type        = match_results<BidirectionalIterator>;
+            using difference_type   = ptrdiff_t;
+            using pointer           = const value_type*;
+            using reference         = const value_type&;
+            using iterator_category = forward_iterator_tag;
+
+            regex_iterator()
+                : begin_{}, end_{}, regex_{}, flags_{}, match_{}
+            { /* DUMMY BODY */ }
+
+            regex_iterator(BidirectionalIterator first, BidirectionalIterator last,
+                           const regex_type& re,
+                           regex_constants::match_flag_type flags = regex_constants::match_default)
+                : begin_{first}, end_{last}, regex_{&re}, flags_{flags}, match_{}
+            {
+                if (!aux::regex_run(begin_, end_, &match_, *regex_, flags_, false, begin_))
+                    regex_ = nullptr;
+            }
+
+            regex_iterator(BidirectionalIterator, BidirectionalIterator,
+                           const regex_type&&,
+                           regex_constants::match_flag_type = regex_constants::match_default) = delete;
+
+            regex_iterator(const regex_iterator&) = default;
+
+            regex_iterator& operator=(const regex_iterator&) = default;
+
+            bool operator==(const regex_iterator& other) const
+            {
+                if (!regex_ || !other.regex_)
+                    return !regex_ && !other.regex_;
+
+                return begin_ == other.begin_ && end_ == other.end_ &&
+                       regex_ == other.regex_ && flags_ == other.flags_ &&
+                       match_[0] == other.match_[0];
+            }
+
+            bool operator!=(const regex_iterator& other) const
+            {
+                return !(*this == other);
+            }
+
+            const value_type& operator*() const
+            {
+                return match_;
+            }
+
+            const value_type* operator->() const
+            {
+                return &match_;
+            }
+
+            regex_iterator& operator++()
+            {
+                auto prev_end = match_[0].second;
+                auto start = prev_end;
+                auto flags = flags_ | regex_constants::match_prev_avail;
+
+                if (match_[0].first == match_[0].second)
+                {
+                    if (start == end_)
+                    {
+                        regex_ = nullptr;
+                        return *this;
+                    }
+
+                    // An empty match, try a non-empty one at the same position.
+                    auto retry = flags | regex_constants::match_not_null |
+                                 regex_constants::match_continuous;
+                    if (aux::regex_run(start, end_, &match_, *regex_, retry, false, begin_))
+                        return *this;
+                    ++start;
+                }
+
+                if (!aux::regex_run(start, end_, &match_, *regex_, flags, false, begin_))
+                    regex_ = nullptr;
+                else
+                    aux::regex_access::set_prefix_first(match_, prev_end);
+
+                return *this;
+            }
+
+            regex_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+        private:
+            BidirectionalIterator begin_;
+            BidirectionalIterator end_;
+            const regex_type* regex_;
+            regex_constants::match_flag_type flags_;
+            value_type match_;
+    };
+
+    using cregex_iterator  = regex_iterator<const char*>;
+    using wcregex_iterator = regex_iterator<const wchar_t*>;
+    using sregex_iterator  = regex_iterator<string::const_iterator>;
+    using wsregex_iterator = regex_iterator<wstring::const_iterator>;
+
+    /**
+     * 28.11.4, function template regex_replace:
+     */
+
+    template<class OutputIterator, class BidirectionalIterator,
+             class Traits, class CharT>
+    OutputIterator regex_replace(
+        OutputIterator out, BidirectionalIterator first, BidirectionalIterator last,
+        const basic_regex<CharT, Traits>& re, const CharT* fmt,
+        regex_constants::match_flag_type flags = regex_constants::match_default
+    )
+    {
+        regex_iterator<BidirectionalIterator, CharT, Traits> it{first, last, re, flags};
+        regex_iterator<BidirectionalIterator, CharT, Traits> end{};
+        bool copy = !(flags & regex_constants::format_no_copy);
+        auto fmt_last = fmt + char_traits<CharT>::length(fmt);
+
+        if (it == end)
+        {
+            if (copy)
+                out = std::copy(first, last, out);
+
+            return out;
+        }
+
+        sub_match<BidirectionalIterator> suffix{};
+        for (; it != end; ++it)
+        {
+            if (copy)
+                out = std::copy(it->prefix().first, it->prefix().second, out);
+            out = it->format(out, fmt, fmt_last, flags);
+            suffix = it->suffix();
+
+            if (flags & regex_constants::format_first_only)
+                break;
+        }
+
+        if (copy)
+            out = std::copy(suffix.first, suffix.second, out);
+
+        return out;
+    }
+
+    template<class OutputIterator, class BidirectionalIterator,
+             class Traits, class CharT, class ST, class SA>
+    OutputIterator regex_replace(
+        OutputIterator out, BidirectionalIterator first, BidirectionalIterator last,
+        const basic_regex<CharT, Traits>& re, const basic_string<CharT, ST, SA>& fmt,
+        regex_constants::match_flag_type flags = regex_constants::match_default
+    )
+    {
+        return regex_replace(out, first, last, re, fmt.c_str(), flags);
+    }
+
+    template<class Traits, class CharT, class ST, class SA, class FST, class FSA>
+    basic_string<CharT, ST, SA> regex_replace(
+        const basic_string<CharT, ST, SA>& s, const basic_regex<CharT, Traits>& re,
+        const basic_string<CharT, FST, FSA>& fmt,
+        regex_constants::match_flag_type flags = regex_constants::match_default
+    )
+    {
+        basic_string<CharT, ST, SA> res{};
+        regex_replace(back_inserter(res), s.begin(), s.end(), re, fmt.c_str(), flags);
+
+        return res;
+    }
+
+    template<class Traits, class CharT, class ST, class SA>
+    basic_string<CharT, ST, SA> regex_replace(
+        const basic_string<CharT, ST, SA>& s, const basic_regex<CharT, Traits>& re,
+        const CharT* fmt,
+        regex_constants::match_flag_type flags = regex_constants::match_default
+    )
+    {
+        basic_string<CharT, ST, SA> res{};
+        regex_replace(back_inserter(res), s.begin(), s.end(), re, fmt, flags);
+
+        return res;
+    }
+
+    template<class Traits, class CharT, class ST, class SA>
+    basic_string<CharT> regex_replace(
+        const CharT* s, const basic_regex<CharT, Traits>& re,
+        const basic_string<CharT, ST, SA>& fmt,
+        regex_constants::match_flag_type flags = regex_constants::match_default
+    )
+    {
+        basic_string<CharT> res{};
+        regex_replace(back_inserter(res), s, s + char_traits<CharT>::length(s),
+                      re, fmt.c_str(), flags);
+
+        return res;
+    }
+
+    template<class Traits, class CharT>
+    basic_string<CharT> regex_replace(
+        const CharT* s, const basic_regex<CharT, Traits>& re, const CharT* fmt,
+        regex_constants::match_flag_type flags = regex_constants::match_default
+    )
+    {
+        basic_string<CharT> res{};
+        regex_replace(back_inserter(res), s, s + char_traits<CharT>::length(s),
+                      re, fmt, flags);
+
+        return res;
+    }
+}
+
+#endif
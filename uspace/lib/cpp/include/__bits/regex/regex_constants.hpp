@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_REGEX_CONSTANTS
+#define LIBCPP_BITS_REGEX_CONSTANTS
+
+#include <__bits/stdexcept.hpp>
+#include <cstdint>
+
+namespace std::regex_constants
+{
+    /**
+     * 28.5.1, bitmask type syntax_option_type:
+     */
+
+    enum syntax_option_type: uint16_t
+    {
+        icase      = 0b0000'0000'0001,
+        nosubs     = 0b0000'0000'0010,
+        optimize   = 0b0000'0000'0100,
+        collate    = 0b0000'0000'1000,
+        ECMAScript = 0b0000'0001'0000,
+        basic      = 0b0000'0010'0000,
+        extended   = 0b0000'0100'0000,
+        awk        = 0b0000'1000'0000,
+        grep       = 0b0001'0000'0000,
+        egrep      = 0b0010'0000'0000,
+
+        /**
+         * C++17, multiline:
+         */
+        multiline  = 0b0100'0000'0000
+    };
+
+    constexpr syntax_option_type operator|(syntax_option_type lhs, syntax_option_type rhs)
+    {
+        return static_cast<syntax_option_type>(
+            static_cast<uint16_t>(lhs) | static_cast<uint16_t>(rhs)
+        );
+    }
+
+    constexpr syntax_option_type operator&(syntax_option_type lhs, syntax_option_type rhs)
+    {
+        return static_cast<syntax_option_type>(
+            static_cast<uint16_t>(lhs) & static_cast<uint16_t>(rhs)
+        );
+    }
+
+    constexpr syntax_option_type operator^(syntax_option_type lhs, syntax_option_type rhs)
+    {
+        return static_cast<syntax_option_type>(
+            static_cast<uint16_t>(lhs) ^ static_cast<uint16_t>(rhs)
+        );
+    }
+
+    constexpr syntax_option_type operator~(syntax_option_type flags)
+    {
+        return static_cast<syntax_option_type>(~static_cast<uint16_t>(flags));
+    }
+
+    inline syntax_option_type& operator|=(syntax_option_type& lhs, syntax_option_type rhs)
+    {
+        return lhs = lhs | rhs;
+    }
+
+    inline syntax_option_type& operator&=(syntax_option_type& lhs, syntax_option_type rhs)
+    {
+        return lhs = lhs & rhs;
+    }
+
+    inline syntax_option_type& operator^=(syntax_option_type& lhs, syntax_option_type rhs)
+    {
+        return lhs = lhs ^ rhs;
+    }
+
+    /**
+     * 28.5.2, bitmask type match_flag_type:
+     */
+
+    enum match_flag_type: uint16_t
+    {
+        match_default     = 0,
+        match_not_bol     = 0b0000'0000'0001,
+        match_not_eol     = 0b0000'0000'0010,
+        match_not_bow     = 0b0000'0000'0100,
+        match_not_eow     = 0b0000'0000'1000,
+        match_any         = 0b0000'0001'0000,
+        match_not_null    = 0b0000'0010'0000,
+        match_continuous  = 0b0000'0100'0000,
+        match_prev_avail  = 0b0000'1000'0000,
+        format_default    = 0,
+        format_sed        = 0b0001'0000'0000,
+        format_no_copy    = 0b0010'0000'0000,
+        format_first_only = 0b0100'0000'0000
+    };
+
+    constexpr match_flag_type operator|(match_flag_type lhs, match_flag_type rhs)
+    {
+        return static_cast<match_flag_type>(
+            static_cast<uint16_t>(lhs) | static_cast<uint16_t>(rhs)
+        );
+    }
+
+    constexpr match_flag_type operator&(match_flag_type lhs, match_flag_type rhs)
+    {
+        return static_cast<match_flag_type>(
+            static_cast<uint16_t>(lhs) & static_cast<uint16_t>(rhs)
+        );
+    }
+
+    constexpr match_flag_type operator^(match_flag_type lhs, match_flag_type rhs)
+    {
+        return static_cast<match_flag_type>(
+            static_cast<uint16_t>(lhs) ^ static_cast<uint16_t>(rhs)
+        );
+    }
+
+    constexpr match_flag_type operator~(match_flag_type flags)
+    {
+        return static_cast<match_flag_type>(~static_cast<uint16_t>(flags));
+    }
+
+    inline match_flag_type& operator|=(match_flag_type& lhs, match_flag_type rhs)
+    {
+        return lhs = lhs | rhs;
+    }
+
+    inline match_flag_type& operator&=(match_flag_type& lhs, match_flag_type rhs)
+    {
+        return lhs = lhs & rhs;
+    }
+
+    inline match_flag_type& operator^=(match_flag_type& lhs, match_flag_type rhs)
+    {
+        return lhs = lhs ^ rhs;
+    }
+
+    /**
+     * 28.5.3, implementation defined error_type:
+     */
+
+    enum error_type
+    {
+        error_collate,
+        error_ctype,
+        error_escape,
+        error_backref,
+        error_brack,
+        error_paren,
+        error_brace,
+        error_badbrace,
+        error_range,
+        error_space,
+        error_badrepeat,
+        error_complexity,
+        error_stack
+    };
+}
+
+namespace std
+{
+    /**
+     * 28.6, class regex_error:
+     */
+
+    class regex_error: public runtime_error
+    {
+        public:
+            explicit regex_error(regex_constants::error_type ecode);
+
+            regex_constants::error_type code() const
+            {
+                return code_;
+            }
+
+        private:
+            regex_constants::error_type code_;
+    };
+}
+
+#endif
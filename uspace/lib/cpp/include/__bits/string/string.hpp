@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_STRING
 #define LIBCPP_BITS_STRING
 
+#include <__bits/functional/hash.hpp>
 #include <__bits/string/stringfwd.hpp>
 #include <algorithm>
 #include <initializer_list>
@@ -454,7 +455,8 @@ namespace std
             { /* DUMMY BODY */ }
 
             explicit basic_string(const allocator_type& alloc)
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 /**
                  * Postconditions:
@@ -462,29 +464,27 @@ namespace std
                  *  size() = 0
                  *  capacity() = unspecified
                  */
-                data_ = allocator_.allocate(default_capacity_);
-                capacity_ = default_capacity_;
+                ensure_null_terminator_();
             }
 
             basic_string(const basic_string& other)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_},
+                : data_{local_}, size_{}, capacity_{local_capacity_},
                   allocator_{other.allocator_}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size());
             }
 
-            basic_string(basic_string&& other)
-                : data_{other.data_}, size_{other.size_},
-                  capacity_{other.capacity_}, allocator_{move(other.allocator_)}
+            basic_string(basic_string&& other) noexcept
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{move(other.allocator_)}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                move_from_(other);
             }
 
             basic_string(const basic_string& other, size_type pos, size_type n = npos,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 // TODO: if pos < other.size() throw out_of_range.
                 auto len = min(n, other.size() - pos);
@@ -492,39 +492,42 @@ namespace std
             }
 
             basic_string(const value_type* str, size_type n, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                init_(str, size_);
+                init_(str, n);
             }
 
             basic_string(const value_type* str, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 init_(str, traits_type::length(str));
             }
 
             basic_string(size_type n, value_type c, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                data_ = allocator_.allocate(capacity_);
-                for (size_type i = 0; i < size_; ++i)
-                    traits_type::assign(data_[i], c);
+                resize_without_copy_(n + 1);
+                traits_type::assign(data_, n, c);
+                size_ = n;
                 ensure_null_terminator_();
             }
 
             template<class InputIterator>
             basic_string(InputIterator first, InputIterator last,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 if constexpr (is_integral<InputIterator>::value)
                 { // Required by the standard.
-                    size_ = static_cast<size_type>(first);
-                    capacity_ = size_;
-                    data_ = allocator_.allocate(capacity_);
+                    auto n = static_cast<size_type>(first);
 
-                    for (size_type i = 0; i < size_; ++i)
-                        traits_type::assign(data_[i], static_cast<value_type>(last));
+                    resize_without_copy_(n + 1);
+                    traits_type::assign(data_, n, static_cast<value_type>(last));
+                    size_ = n;
                     ensure_null_terminator_();
                 }
                 else
@@ -539,22 +542,22 @@ namespace std
             { /* DUMMY BODY */ }
 
             basic_string(const basic_string& other, const allocator_type& alloc)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size());
             }
 
             basic_string(basic_string&& other, const allocator_type& alloc)
-                : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                move_from_(other);
             }
 
             ~basic_string()
             {
-                allocator_.deallocate(data_, capacity_);
+                release_();
             }
 
             basic_string& operator=(const basic_string& other)
@@ -573,23 +576,22 @@ namespace std
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
                 if (this != &other)
-                    swap(other);
+                {
+                    release_();
+                    move_from_(other);
+                }
 
                 return *this;
             }
 
             basic_string& operator=(const value_type* other)
             {
-                *this = basic_string{other};
-
-                return *this;
+                return assign(other);
             }
 
             basic_string& operator=(value_type c)
             {
-                *this = basic_string{1, c};
-
-                return *this;
+                return assign(&c, 1);
             }
 
             basic_string& operator=(initializer_list<value_type> init)
@@ -688,9 +690,8 @@ namespace std
                 // TODO: if new_size > max_size() throw length_error.
                 if (new_size > size_)
                 {
-                    ensure_free_space_(new_size - size_ + 1);
-                    for (size_type i = size_; i < new_size; ++i)
-                        traits_type::assign(data_[i], i);
+                    ensure_free_space_(new_size - size_);
+                    traits_type::assign(data_ + size_, new_size - size_, c);
                 }
 
                 size_ = new_size;
@@ -712,16 +713,37 @@ namespace std
                 // TODO: if new_capacity > max_size() throw
                 //       length_error (this function shall have no
                 //       effect in such case)
-                if (new_capacity > capacity_)
-                    resize_with_copy_(size_, new_capacity);
-                else if (new_capacity < capacity_)
+                if (new_capacity >= capacity_)
+                    resize_with_copy_(size_, new_capacity + 1);
+                else if (new_capacity < size_)
                     shrink_to_fit(); // Non-binding request, but why not.
             }
 
             void shrink_to_fit()
             {
-                if (size_ != capacity_)
-                    resize_with_copy_(size_, capacity_);
+                if (is_local_() || size_ + 1 == capacity_)
+                    return;
+
+                if (size_ < local_capacity_)
+                {
+                    auto old_data = data_;
+                    auto old_capacity = capacity_;
+
+                    traits_type::copy(local_, data_, size_ + 1);
+                    data_ = local_;
+                    capacity_ = local_capacity_;
+
+                    allocator_.deallocate(old_data, old_capacity);
+                }
+                else
+                {
+                    auto new_data = allocator_.allocate(size_ + 1);
+                    traits_type::copy(new_data, data_, size_ + 1);
+
+                    release_();
+                    data_ = new_data;
+                    capacity_ = size_ + 1;
+                }
             }
 
             void clear() noexcept
@@ -840,7 +862,12 @@ namespace std
 
             basic_string& append(size_type n, value_type c)
             {
-                return append(basic_string(n, c));
+                ensure_free_space_(n);
+                traits_type::assign(data_ + size_, n, c);
+                size_ += n;
+                ensure_null_terminator_();
+
+                return *this;
             }
 
             template<class InputIterator>
@@ -876,10 +903,9 @@ namespace std
             basic_string& assign(const basic_string& str, size_type pos,
                                  size_type n = npos)
             {
-                if (pos < str.size())
+                if (pos <= str.size())
                 {
                     auto len = min(n, str.size() - pos);
-                    ensure_free_space_(len);
 
                     return assign(str.data() + pos, len);
                 }
@@ -891,8 +917,19 @@ namespace std
             basic_string& assign(const value_type* str, size_type n)
             {
                 // TODO: if (n > max_size()) throw length_error.
-                resize_without_copy_(n);
-                traits_type::copy(begin(), str, n);
+                if (n < capacity_)
+                {
+                    // Reuse our buffer, str may point into it.
+                    traits_type::move(data_, str, n);
+                }
+                else
+                {
+                    basic_string tmp{str, n, allocator_};
+                    swap(tmp);
+
+                    return *this;
+                }
+
                 size_ = n;
                 ensure_null_terminator_();
 
@@ -906,7 +943,14 @@ namespace std
 
             basic_string& assign(size_type n, value_type c)
             {
-                return assign(basic_string(n, c));
+                if (n >= capacity_)
+                    resize_without_copy_(n + 1);
+
+                traits_type::assign(data_, n, c);
+                size_ = n;
+                ensure_null_terminator_();
+
+                return *this;
             }
 
             template<class InputIterator>
@@ -1015,7 +1059,7 @@ namespace std
             basic_string& erase(size_type pos = 0, size_type n = npos)
             {
                 auto len = min(n, size_ - pos);
-                copy_(begin() + pos + n, end(), begin() + pos);
+                copy_(begin() + pos + len, end(), begin() + pos);
                 size_ -= len;
                 ensure_null_terminator_();
 
@@ -1066,8 +1110,8 @@ namespace std
                 // TODO: if size() - len > max_size() - n2 throw length_error
                 auto len = min(n1, size_ - pos);
 
-                basic_string tmp{};
-                tmp.resize_without_copy_(size_ - len + n2);
+                basic_string tmp{allocator_};
+                tmp.resize_without_copy_(size_ - len + n2 + 1);
 
                 // Prefix.
                 copy_(begin(), begin() + pos, tmp.begin());
@@ -1079,6 +1123,7 @@ namespace std
                 copy_(begin() + pos + len, end(), tmp.begin() + pos + n2);
 
                 tmp.size_ = size_ - len + n2;
+                tmp.ensure_null_terminator_();
                 swap(tmp);
                 return *this;
             }
@@ -1144,9 +1189,23 @@ namespace std
                 noexcept(allocator_traits<allocator_type>::propagate_on_container_swap::value ||
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
-                std::swap(data_, other.data_);
-                std::swap(size_, other.size_);
-                std::swap(capacity_, other.capacity_);
+                if (!is_local_() && !other.is_local_())
+                {
+                    std::swap(data_, other.data_);
+                    std::swap(size_, other.size_);
+                    std::swap(capacity_, other.capacity_);
+
+                    return;
+                }
+
+                /**
+                 * Inline buffers cannot be swapped by pointer,
+                 * but moving out of a string never allocates.
+                 */
+                basic_string tmp{allocator_};
+                tmp.move_from_(other);
+                other.move_from_(*this);
+                move_from_(tmp);
             }
 
             /**
@@ -1460,31 +1519,68 @@ namespace std
             }
 
         private:
+            /**
+             * Short strings (including the null terminator)
+             * are kept in an inline buffer of 16 bytes, so that
+             * they do not need an allocation.
+             */
+            static constexpr size_type local_capacity_{
+                sizeof(value_type) < 16 ? 16 / sizeof(value_type) : 2
+            };
+
             value_type* data_;
             size_type size_;
             size_type capacity_;
             allocator_type allocator_;
+            value_type local_[local_capacity_];
 
             template<class C, class T, class A>
             friend class basic_stringbuf;
 
+            bool is_local_() const noexcept
+            {
+                return data_ == local_;
+            }
+
+            void release_()
+            {
+                if (!is_local_())
+                    allocator_.deallocate(data_, capacity_);
+
+                data_ = local_;
+                capacity_ = local_capacity_;
+            }
+
             /**
-             * Arbitrary value, standard just requires
-             * data() to have some capacity.
-             * (Well, we could've done data_ = &data_ and
-             * set capacity to 0, but that would be too cryptic.)
+             * Takes over the contents of other, leaving it
+             * empty. Our own storage must have been released.
              */
-            static constexpr size_type default_capacity_{4};
+            void move_from_(basic_string& other) noexcept
+            {
+                if (other.is_local_())
+                {
+                    traits_type::copy(local_, other.local_, other.size_ + 1);
+                    data_ = local_;
+                    capacity_ = local_capacity_;
+                }
+                else
+                {
+                    data_ = other.data_;
+                    capacity_ = other.capacity_;
+                }
+                size_ = other.size_;
+
+                other.data_ = other.local_;
+                other.size_ = 0;
+                other.capacity_ = local_capacity_;
+                other.ensure_null_terminator_();
+            }
 
             void init_(const value_type* str, size_type size)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                resize_without_copy_(size + 1);
 
                 size_ = size;
-                capacity_ = size + 1;
-
-                data_ = allocator_.allocate(capacity_);
                 traits_type::copy(data_, str, size);
                 ensure_null_terminator_();
             }
@@ -1510,30 +1606,32 @@ namespace std
 
             void resize_without_copy_(size_type capacity)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (capacity > capacity_)
+                {
+                    release_();
+
+                    data_ = allocator_.allocate(capacity);
+                    capacity_ = capacity;
+                }
 
-                data_ = allocator_.allocate(capacity);
                 size_ = 0;
-                capacity_ = capacity;
                 ensure_null_terminator_();
             }
 
             void resize_with_copy_(size_type size, size_type capacity)
             {
-                if(capacity_ == 0 || capacity_ < capacity)
+                if (capacity > capacity_)
                 {
                     auto new_data = allocator_.allocate(capacity);
 
                     auto to_copy = min(size, size_);
-                    traits_type::move(new_data, data_, to_copy);
-
-                    std::swap(data_, new_data);
+                    traits_type::copy(new_data, data_, to_copy);
 
-                    allocator_.deallocate(new_data, capacity_);
+                    release_();
+                    data_ = new_data;
+                    capacity_ = capacity;
                 }
 
-                capacity_ = capacity;
                 size_ = size;
                 ensure_null_terminator_();
             }
@@ -1915,17 +2013,7 @@ namespace std
     {
         size_t operator()(const string& str) const noexcept
         {
-            size_t res{};
-
-            /**
-             * Note: No need for fancy algorithms here,
-             *       std::hash is used for indexing, not
-             *       cryptography.
-             */
-            for (const auto& c: str)
-                res = res * 5 + (res >> 3) + static_cast<size_t>(c);
-
-            return res;
+            return aux::hash_bytes(str.data(), str.size());
         }
 
         using argument_type = string;
@@ -1937,15 +2025,36 @@ namespace std
     {
         size_t operator()(const wstring& str) const noexcept
         {
-            // TODO: implement
-            return size_t{};
+            return aux::hash_bytes(str.data(), str.size() * sizeof(wchar_t));
         }
 
         using argument_type = wstring;
         using result_type   = size_t;
     };
 
-    // TODO: add those other 2 string types
+    template<>
+    struct hash<u16string>
+    {
+        size_t operator()(const u16string& str) const noexcept
+        {
+            return aux::hash_bytes(str.data(), str.size() * sizeof(char16_t));
+        }
+
+        using argument_type = u16string;
+        using result_type   = size_t;
+    };
+
+    template<>
+    struct hash<u32string>
+    {
+        size_t operator()(const u32string& str) const noexcept
+        {
+            return aux::hash_bytes(str.data(), str.size() * sizeof(char32_t));
+        }
+
+        using argument_type = u32string;
+        using result_type   = size_t;
+    };
 
     /**
      * 21.7, suffix for basic_string literals:
@@ -64,7 +64,11 @@ namespace std::test
 
         ~mock()
         {
-            ++destructor_calls;
+            /**
+             * Shared objects can be destroyed by the last
+             * owner in any thread.
+             */
+            __atomic_add_fetch(&destructor_calls, 1, __ATOMIC_RELAXED);
         }
 
         static void clear()
@@ -75,6 +79,61 @@ namespace std::test
             move_constructor_calls = size_t{};
         }
     };
+
+    /**
+     * Allocator that counts the calls to allocate
+     * and deallocate, so that we can test when
+     * containers touch the heap.
+     */
+    struct allocation_counter
+    {
+        static size_t allocations;
+        static size_t deallocations;
+
+        static void clear()
+        {
+            allocations = size_t{};
+            deallocations = size_t{};
+        }
+    };
+
+    template<class T>
+    struct counting_allocator
+    {
+        using value_type = T;
+
+        counting_allocator() = default;
+
+        template<class U>
+        counting_allocator(const counting_allocator<U>&)
+        { /* DUMMY BODY */ }
+
+        T* allocate(size_t n)
+        {
+            ++allocation_counter::allocations;
+
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t)
+        {
+            ++allocation_counter::deallocations;
+
+            ::operator delete(ptr);
+        }
+    };
+
+    template<class T, class U>
+    bool operator==(const counting_allocator<T>&, const counting_allocator<U>&)
+    {
+        return true;
+    }
+
+    template<class T, class U>
+    bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&)
+    {
+        return false;
+    }
 }
 
 #endif
@@ -105,6 +105,8 @@ namespace std::test
             void test_construction_and_assignment();
             void test_insert();
             void test_erase();
+            void test_element_lifetime();
+            void bench_operations();
     };
 
     class string_test: public test_suite
@@ -123,6 +125,8 @@ namespace std::test
             void test_find();
             void test_substr();
             void test_compare();
+            void test_allocation();
+            void test_hash();
     };
 
     class bitset_test: public test_suite
@@ -219,6 +223,66 @@ namespace std::test
             void test_multi();
     };
 
+    class flat_hash_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_constructors_and_assignment();
+            void test_emplace_insert();
+            void test_erase();
+            void test_set();
+            void bench_maps();
+    };
+
+    class parallel_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_async();
+            void test_promise();
+            void test_shared_future();
+            void test_packaged_task();
+            void test_algorithms();
+            void bench_scaling();
+    };
+
+    class regex_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_match();
+            void test_search();
+            void test_captures();
+            void test_replace();
+            void test_iterator();
+            void test_errors();
+            void test_long();
+            void bench_logs();
+    };
+
+    class io_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_to_chars();
+            void test_from_chars();
+            void test_formatting();
+            void test_filebuf();
+            void bench_output();
+    };
+
     class numeric_test: public test_suite
     {
         public:
@@ -252,6 +316,7 @@ namespace std::test
             void test_unique_ptr();
             void test_shared_ptr();
             void test_weak_ptr();
+            void test_shared_ptr_concurrency();
             void test_allocators();
             void test_pointers();
     };
@@ -293,6 +358,8 @@ namespace std::test
         private:
             void test_non_modifying();
             void test_mutating();
+            void test_sorting();
+            void bench_sorting();
     };
 }
 
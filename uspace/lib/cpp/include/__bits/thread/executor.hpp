@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_THREAD_EXECUTOR
+#define LIBCPP_BITS_THREAD_EXECUTOR
+
+#include <__bits/thread/threading.hpp>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Type erased unit of work run by the executor.
+     */
+    class executor_task
+    {
+        public:
+            virtual void run() = 0;
+
+            virtual ~executor_task() = default;
+    };
+
+    template<class Callable>
+    class executor_callable_task: public executor_task
+    {
+        public:
+            executor_callable_task(Callable&& clbl)
+                : callable_{move(clbl)}
+            { /* DUMMY BODY */ }
+
+            executor_callable_task(const Callable& clbl)
+                : callable_{clbl}
+            { /* DUMMY BODY */ }
+
+            void run() override
+            {
+                callable_();
+            }
+
+        private:
+            Callable callable_;
+    };
+
+    class executor;
+
+    /**
+     * Deque of tasks owned by a single worker. The owner
+     * pushes and pops at the back, so it keeps working on
+     * the most recent (and cache hot) task, while thieves
+     * take the oldest tasks from the front, which tend to
+     * be the biggest pieces of work.
+     * Note: The deque is guarded by a fibril mutex instead
+     *       of being lock free, the mutex is only contended
+     *       when a steal races with its owner.
+     */
+    class work_queue
+    {
+        public:
+            work_queue();
+            ~work_queue();
+
+            work_queue(const work_queue&) = delete;
+            work_queue& operator=(const work_queue&) = delete;
+
+            void push(executor_task* task);
+            executor_task* pop();
+            executor_task* steal();
+
+        private:
+            mutex_t mtx_;
+            executor_task** tasks_;
+            size_t capacity_;
+            size_t head_;
+            size_t size_;
+
+            executor* owner_;
+            size_t index_;
+
+            void grow_();
+
+            friend class executor;
+    };
+
+    /**
+     * Work stealing executor backing std::async and the
+     * parallel algorithms. Every worker is a fibril with its
+     * own deque, tasks submitted by a worker go to its own
+     * deque and idle workers steal from the others. Enabling
+     * the executor also enables additional fibril runners,
+     * so that the workers actually run on multiple kernel
+     * threads.
+     *
+     * Workers block on fibril synchronization primitives, so
+     * a worker that waits for something only blocks its own
+     * fibril and never the runner thread it was on. Waits
+     * for tasks (futures and task groups) also run queued
+     * tasks in the meantime instead of blocking right away.
+     */
+    class executor
+    {
+        public:
+            /**
+             * Returns the executor shared by the whole task,
+             * it gets started on first use.
+             */
+            static executor& instance();
+
+            template<class Callable>
+            void submit(Callable&& clbl)
+            {
+                submit_task(new executor_callable_task<decay_t<Callable>>{
+                    forward<Callable>(clbl)
+                });
+            }
+
+            void submit_task(executor_task* task);
+
+            /**
+             * Runs a single queued task in the calling fibril,
+             * returns false if there was nothing to run.
+             */
+            bool run_one();
+
+            size_t workers() const noexcept
+            {
+                return workers_;
+            }
+
+            executor(const executor&) = delete;
+            executor& operator=(const executor&) = delete;
+
+        private:
+            executor(size_t workers);
+
+            executor_task* find_task_();
+            void wake_();
+
+            static int worker_main_(void* arg);
+
+            work_queue* queues_;
+            size_t workers_;
+            size_t next_queue_;
+
+            /**
+             * Number of tasks in all of the queues and number
+             * of workers that went to sleep because of there
+             * being none.
+             */
+            size_t queued_;
+            size_t sleeping_;
+
+            mutex_t idle_mtx_;
+            condvar_t idle_cv_;
+    };
+
+    /**
+     * Tracks tasks of a single parallel operation so that
+     * its caller can wait for all of them, helping with
+     * queued tasks in the meantime.
+     */
+    class task_group
+    {
+        public:
+            task_group(executor& exec = executor::instance());
+            ~task_group();
+
+            task_group(const task_group&) = delete;
+            task_group& operator=(const task_group&) = delete;
+
+            template<class Callable>
+            void run(Callable&& clbl)
+            {
+                __atomic_add_fetch(&pending_, 1, __ATOMIC_RELAXED);
+                exec_.submit(
+                    [this, clbl = forward<Callable>(clbl)]() mutable {
+                        clbl();
+                        done_();
+                    }
+                );
+            }
+
+            void wait();
+
+            executor& get_executor() noexcept
+            {
+                return exec_;
+            }
+
+        private:
+            executor& exec_;
+            size_t pending_;
+
+            mutex_t mtx_;
+            condvar_t cv_;
+
+            void done_();
+    };
+}
+
+#endif
@@ -29,8 +29,14 @@
 #ifndef LIBCPP_BITS_THREAD_FUTURE
 #define LIBCPP_BITS_THREAD_FUTURE
 
+#include <__bits/thread/executor.hpp>
+#include <__bits/thread/threading.hpp>
+#include <__bits/trycatch.hpp>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <system_error>
+#include <tuple>
 #include <type_traits>
 
 namespace std
@@ -49,10 +55,24 @@ namespace std
 
     enum class launch
     {
-        async,
-        deferred
+        async    = 0b01,
+        deferred = 0b10
     };
 
+    constexpr launch operator|(launch lhs, launch rhs)
+    {
+        return static_cast<launch>(
+            static_cast<int>(lhs) | static_cast<int>(rhs)
+        );
+    }
+
+    constexpr launch operator&(launch lhs, launch rhs)
+    {
+        return static_cast<launch>(
+            static_cast<int>(lhs) & static_cast<int>(rhs)
+        );
+    }
+
     enum class future_status
     {
         ready,
@@ -93,18 +113,564 @@ namespace std
      */
 
     template<class R>
-    class promise
+    class future;
+
+    template<class R>
+    class shared_future;
+
+    namespace aux
+    {
+        /**
+         * State shared by a promise (or an asynchronous task)
+         * and its futures. It is reference counted intrusively
+         * instead of being held by shared_ptrs, the promise
+         * and each (shared) future hold one reference.
+         */
+        class shared_state_base
+        {
+            public:
+                shared_state_base();
+
+                virtual ~shared_state_base() = default;
+
+                shared_state_base(const shared_state_base&) = delete;
+                shared_state_base& operator=(const shared_state_base&) = delete;
+
+                void increment() noexcept;
+                void release() noexcept;
+
+                /**
+                 * Waits until the value is set. Deferred tasks
+                 * are run by the waiter, waits for tasks run
+                 * by the executor run other queued tasks in
+                 * the meantime.
+                 */
+                void wait();
+
+                future_status wait_for(time_unit_t timeout);
+
+                bool is_ready() const noexcept;
+
+                bool is_async() const noexcept
+                {
+                    return exec_ != nullptr;
+                }
+
+                void set_executor(executor& exec) noexcept
+                {
+                    exec_ = &exec;
+                }
+
+                void set_deferred() noexcept
+                {
+                    deferred_ = true;
+                }
+
+                /**
+                 * Returns false if the future was already
+                 * retrieved from this state.
+                 */
+                bool retrieve() noexcept;
+
+                /**
+                 * Called by a promise that goes away
+                 * without setting the value.
+                 */
+                void abandon();
+
+                /**
+                 * Reports a broken promise to the
+                 * caller of get().
+                 */
+                void check_value();
+
+            protected:
+                /**
+                 * Returns false if the value was already set,
+                 * otherwise the value can be stored and made
+                 * visible with finish_set_().
+                 */
+                bool begin_set_();
+                void finish_set_();
+
+                virtual void run_deferred_()
+                { /* DUMMY BODY */ }
+
+            private:
+                mutex_t mtx_;
+                condvar_t cv_;
+                executor* exec_;
+                refcount_t refs_;
+                bool ready_;
+                bool deferred_;
+                bool retrieved_;
+                bool broken_;
+        };
+
+        template<class R>
+        class future_storage
+        {
+            public:
+                future_storage()
+                    : constructed_{false}
+                { /* DUMMY BODY */ }
+
+                ~future_storage()
+                {
+                    if (constructed_)
+                        get().~R();
+                }
+
+                template<class... Args>
+                void set(Args&&... args)
+                {
+                    ::new(static_cast<void*>(&data_[0])) R(forward<Args>(args)...);
+                    constructed_ = true;
+                }
+
+                R& get()
+                {
+                    return *reinterpret_cast<R*>(&data_[0]);
+                }
+
+            private:
+                alignas(R) unsigned char data_[sizeof(R)];
+                bool constructed_;
+        };
+
+        template<class R>
+        class future_storage<R&>
+        {
+            public:
+                void set(R& ref)
+                {
+                    ptr_ = addressof(ref);
+                }
+
+                R& get()
+                {
+                    return *ptr_;
+                }
+
+            private:
+                R* ptr_{};
+        };
+
+        template<>
+        class future_storage<void>
+        {
+            public:
+                void set()
+                { /* DUMMY BODY */ }
+
+                void get()
+                { /* DUMMY BODY */ }
+        };
+
+        template<class R>
+        class shared_state: public shared_state_base
+        {
+            public:
+                template<class... Args>
+                void set_value(Args&&... args)
+                {
+                    if (!begin_set_())
+                    {
+                        throw future_error{
+                            make_error_code(future_errc::promise_already_satisfied)
+                        };
+
+                        return;
+                    }
+
+                    value_.set(forward<Args>(args)...);
+                    finish_set_();
+                }
+
+                decltype(auto) get()
+                {
+                    wait();
+                    check_value();
+
+                    return value_.get();
+                }
+
+            private:
+                future_storage<R> value_;
+        };
+
+        /**
+         * State of a std::async call, it owns the function
+         * and its arguments and stores the result.
+         */
+        template<class R, class F, class... Args>
+        class async_state: public shared_state<R>
+        {
+            public:
+                template<class G, class... As>
+                async_state(G&& f, As&&... args)
+                    : func_{forward<G>(f)}, args_{forward<As>(args)...}
+                { /* DUMMY BODY */ }
+
+                void execute()
+                {
+                    execute_(make_index_sequence<sizeof...(Args)>{});
+                }
+
+            protected:
+                void run_deferred_() override
+                {
+                    execute();
+                }
+
+            private:
+                F func_;
+                tuple<Args...> args_;
+
+                template<size_t... Is>
+                void execute_(index_sequence<Is...>)
+                {
+                    if constexpr (is_void_v<R>)
+                    {
+                        invoke(move(func_), move(std::get<Is>(args_))...);
+                        this->set_value();
+                    }
+                    else
+                        this->set_value(invoke(move(func_), move(std::get<Is>(args_))...));
+                }
+        };
+
+        /**
+         * State of a packaged_task, the stored function
+         * is type erased by the virtual call.
+         */
+        template<class R, class... Args>
+        class packaged_state_base: public shared_state<R>
+        {
+            public:
+                virtual void call(Args... args) = 0;
+
+                /**
+                 * Moves the function to a new state.
+                 */
+                virtual packaged_state_base* reset() = 0;
+        };
+
+        template<class F, class R, class... Args>
+        class packaged_state: public packaged_state_base<R, Args...>
+        {
+            public:
+                template<class G>
+                packaged_state(G&& f)
+                    : func_{forward<G>(f)}
+                { /* DUMMY BODY */ }
+
+                void call(Args... args) override
+                {
+                    if (this->is_ready())
+                    {
+                        throw future_error{
+                            make_error_code(future_errc::promise_already_satisfied)
+                        };
+
+                        return;
+                    }
+
+                    if constexpr (is_void_v<R>)
+                    {
+                        invoke(func_, forward<Args>(args)...);
+                        this->set_value();
+                    }
+                    else
+                        this->set_value(invoke(func_, forward<Args>(args)...));
+                }
+
+                packaged_state_base<R, Args...>* reset() override
+                {
+                    return new packaged_state{move(func_)};
+                }
+
+            private:
+                F func_;
+        };
+
+        template<class R>
+        future<R> make_future(shared_state<R>* state);
+
+        template<class R>
+        class shared_future_base;
+
+        template<class R>
+        class future_base
+        {
+            public:
+                future_base() noexcept
+                    : state_{}
+                { /* DUMMY BODY */ }
+
+                future_base(const future_base&) = delete;
+
+                future_base(future_base&& other) noexcept
+                    : state_{other.state_}
+                {
+                    other.state_ = nullptr;
+                }
+
+                ~future_base()
+                {
+                    release_();
+                }
+
+                future_base& operator=(const future_base&) = delete;
+
+                future_base& operator=(future_base&& rhs) noexcept
+                {
+                    if (this != &rhs)
+                    {
+                        release_();
+
+                        state_ = rhs.state_;
+                        rhs.state_ = nullptr;
+                    }
+
+                    return *this;
+                }
+
+                bool valid() const noexcept
+                {
+                    return state_ != nullptr;
+                }
+
+                void wait() const
+                {
+                    if (state_)
+                        state_->wait();
+                }
+
+                template<class Rep, class Period>
+                future_status wait_for(const chrono::duration<Rep, Period>& rel_time) const
+                {
+                    if (!state_)
+                        return future_status::ready;
+
+                    return state_->wait_for(threading::time::convert(rel_time));
+                }
+
+                template<class Clock, class Duration>
+                future_status wait_until(
+                    const chrono::time_point<Clock, Duration>& abs_time
+                ) const
+                {
+                    return wait_for(abs_time - Clock::now());
+                }
+
+            protected:
+                shared_state<R>* state_;
+
+                future_base(shared_state<R>* state)
+                    : state_{state}
+                { /* DUMMY BODY */ }
+
+                /**
+                 * Detaches the state, so that get() leaves
+                 * the future invalid.
+                 */
+                shared_state<R>* take_state_()
+                {
+                    if (!state_)
+                    {
+                        throw future_error{make_error_code(future_errc::no_state)};
+
+                        // Without exceptions there is no value to return.
+                        abort();
+                    }
+
+                    auto state = state_;
+                    state_ = nullptr;
+
+                    return state;
+                }
+
+                void release_()
+                {
+                    if (state_)
+                    {
+                        /**
+                         * A future returned by std::async blocks
+                         * in its destructor until the task is done,
+                         * the task may refer to our caller's stack.
+                         */
+                        if (state_->is_async())
+                            state_->wait();
+
+                        state_->release();
+                        state_ = nullptr;
+                    }
+                }
+
+                friend class shared_future_base<R>;
+        };
+
+        /**
+         * Unlike future, a shared_future can be copied, each
+         * copy holds a reference to the shared state and get()
+         * leaves it valid.
+         */
+        template<class R>
+        class shared_future_base: public future_base<R>
+        {
+            public:
+                shared_future_base() noexcept = default;
+
+                shared_future_base(const shared_future_base& other) noexcept
+                    : future_base<R>{other.state_}
+                {
+                    if (this->state_)
+                        this->state_->increment();
+                }
+
+                shared_future_base(shared_future_base&&) noexcept = default;
+
+                shared_future_base(future_base<R>&& other) noexcept
+                    : future_base<R>{other.state_}
+                {
+                    other.state_ = nullptr;
+                }
+
+                shared_future_base& operator=(const shared_future_base& rhs) noexcept
+                {
+                    if (this != &rhs)
+                    {
+                        this->release_();
+
+                        this->state_ = rhs.state_;
+                        if (this->state_)
+                            this->state_->increment();
+                    }
+
+                    return *this;
+                }
+
+                shared_future_base& operator=(shared_future_base&&) noexcept = default;
+
+            protected:
+                shared_state<R>& state_or_throw_() const
+                {
+                    if (!this->state_)
+                    {
+                        throw future_error{make_error_code(future_errc::no_state)};
+
+                        // Without exceptions there is no value to return.
+                        abort();
+                    }
+
+                    return *this->state_;
+                }
+        };
+
+        template<class R>
+        class promise_base
+        {
+            public:
+                promise_base()
+                    : state_{new shared_state<R>{}}
+                { /* DUMMY BODY */ }
+
+                promise_base(promise_base&& other) noexcept
+                    : state_{other.state_}
+                {
+                    other.state_ = nullptr;
+                }
+
+                promise_base(const promise_base&) = delete;
+
+                ~promise_base()
+                {
+                    release_();
+                }
+
+                promise_base& operator=(promise_base&& rhs) noexcept
+                {
+                    if (this != &rhs)
+                    {
+                        release_();
+
+                        state_ = rhs.state_;
+                        rhs.state_ = nullptr;
+                    }
+
+                    return *this;
+                }
+
+                promise_base& operator=(const promise_base&) = delete;
+
+                void swap(promise_base& other) noexcept
+                {
+                    std::swap(state_, other.state_);
+                }
+
+                future<R> get_future()
+                {
+                    if (!state_ || !state_->retrieve())
+                    {
+                        throw future_error{
+                            make_error_code(future_errc::future_already_retrieved)
+                        };
+
+                        return future<R>{};
+                    }
+
+                    return make_future(state_);
+                }
+
+            protected:
+                shared_state<R>* state_;
+
+                void release_()
+                {
+                    if (state_)
+                    {
+                        state_->abandon();
+                        state_->release();
+                        state_ = nullptr;
+                    }
+                }
+        };
+    }
+
+    template<class R>
+    class promise: public aux::promise_base<R>
     {
+        public:
+            void set_value(const R& val)
+            {
+                this->state_->set_value(val);
+            }
+
+            void set_value(R&& val)
+            {
+                this->state_->set_value(move(val));
+            }
     };
 
     template<class R>
-    class promise<R&>
+    class promise<R&>: public aux::promise_base<R&>
     {
+        public:
+            void set_value(R& val)
+            {
+                this->state_->set_value(val);
+            }
     };
 
     template<>
-    class promise<void>
+    class promise<void>: public aux::promise_base<void>
     {
+        public:
+            void set_value()
+            {
+                this->state_->set_value();
+            }
     };
 
     template<class R>
@@ -118,65 +684,373 @@ namespace std
     { /* DUMMY BODY */ };
 
     template<class R>
-    class future
+    class future: public aux::future_base<R>
     {
+        public:
+            future() noexcept = default;
+            future(future&&) noexcept = default;
+            future& operator=(future&&) noexcept = default;
+
+            R get()
+            {
+                auto state = this->take_state_();
+                R res{move(state->get())};
+                state->release();
+
+                return res;
+            }
+
+            shared_future<R> share()
+            {
+                return shared_future<R>{move(*this)};
+            }
+
+        private:
+            future(aux::shared_state<R>* state)
+                : aux::future_base<R>{state}
+            { /* DUMMY BODY */ }
+
+            template<class U>
+            friend future<U> aux::make_future(aux::shared_state<U>*);
     };
 
     template<class R>
-    class future<R&>
+    class future<R&>: public aux::future_base<R&>
     {
+        public:
+            future() noexcept = default;
+            future(future&&) noexcept = default;
+            future& operator=(future&&) noexcept = default;
+
+            R& get()
+            {
+                auto state = this->take_state_();
+                R& res = state->get();
+                state->release();
+
+                return res;
+            }
+
+            shared_future<R&> share()
+            {
+                return shared_future<R&>{move(*this)};
+            }
+
+        private:
+            future(aux::shared_state<R&>* state)
+                : aux::future_base<R&>{state}
+            { /* DUMMY BODY */ }
+
+            template<class U>
+            friend future<U> aux::make_future(aux::shared_state<U>*);
     };
 
     template<>
-    class future<void>
+    class future<void>: public aux::future_base<void>
     {
+        public:
+            future() noexcept = default;
+            future(future&&) noexcept = default;
+            future& operator=(future&&) noexcept = default;
+
+            void get()
+            {
+                auto state = this->take_state_();
+                state->get();
+                state->release();
+            }
+
+            shared_future<void> share();
+
+        private:
+            future(aux::shared_state<void>* state)
+                : aux::future_base<void>{state}
+            { /* DUMMY BODY */ }
+
+            template<class U>
+            friend future<U> aux::make_future(aux::shared_state<U>*);
     };
 
+    namespace aux
+    {
+        template<class R>
+        future<R> make_future(shared_state<R>* state)
+        {
+            state->increment();
+
+            return future<R>{state};
+        }
+    }
+
+    /**
+     * 30.6.7, class template shared_future:
+     */
+
     template<class R>
-    class shared_future
+    class shared_future: public aux::shared_future_base<R>
     {
+        public:
+            shared_future() noexcept = default;
+            shared_future(const shared_future&) noexcept = default;
+            shared_future(shared_future&&) noexcept = default;
+
+            shared_future(future<R>&& other) noexcept
+                : aux::shared_future_base<R>{move(other)}
+            { /* DUMMY BODY */ }
+
+            shared_future& operator=(const shared_future&) noexcept = default;
+            shared_future& operator=(shared_future&&) noexcept = default;
+
+            const R& get() const
+            {
+                return this->state_or_throw_().get();
+            }
     };
 
     template<class R>
-    class shared_future<R&>
+    class shared_future<R&>: public aux::shared_future_base<R&>
     {
+        public:
+            shared_future() noexcept = default;
+            shared_future(const shared_future&) noexcept = default;
+            shared_future(shared_future&&) noexcept = default;
+
+            shared_future(future<R&>&& other) noexcept
+                : aux::shared_future_base<R&>{move(other)}
+            { /* DUMMY BODY */ }
+
+            shared_future& operator=(const shared_future&) noexcept = default;
+            shared_future& operator=(shared_future&&) noexcept = default;
+
+            R& get() const
+            {
+                return this->state_or_throw_().get();
+            }
     };
 
     template<>
-    class shared_future<void>
+    class shared_future<void>: public aux::shared_future_base<void>
     {
+        public:
+            shared_future() noexcept = default;
+            shared_future(const shared_future&) noexcept = default;
+            shared_future(shared_future&&) noexcept = default;
+
+            shared_future(future<void>&& other) noexcept
+                : aux::shared_future_base<void>{move(other)}
+            { /* DUMMY BODY */ }
+
+            shared_future& operator=(const shared_future&) noexcept = default;
+            shared_future& operator=(shared_future&&) noexcept = default;
+
+            void get() const
+            {
+                this->state_or_throw_().get();
+            }
     };
 
+    inline shared_future<void> future<void>::share()
+    {
+        return shared_future<void>{move(*this)};
+    }
+
+    /**
+     * 30.6.9, class template packaged_task:
+     */
+
     template<class>
     class packaged_task; // undefined
 
     template<class R, class... Args>
     class packaged_task<R(Args...)>
     {
+        public:
+            packaged_task() noexcept
+                : state_{}
+            { /* DUMMY BODY */ }
+
+            template<
+                class F, class = enable_if_t<
+                    !is_same_v<decay_t<F>, packaged_task>
+                >
+            >
+            explicit packaged_task(F&& f)
+                : state_{new aux::packaged_state<decay_t<F>, R, Args...>{forward<F>(f)}}
+            { /* DUMMY BODY */ }
+
+            packaged_task(const packaged_task&) = delete;
+
+            packaged_task(packaged_task&& other) noexcept
+                : state_{other.state_}
+            {
+                other.state_ = nullptr;
+            }
+
+            ~packaged_task()
+            {
+                release_();
+            }
+
+            packaged_task& operator=(const packaged_task&) = delete;
+
+            packaged_task& operator=(packaged_task&& rhs) noexcept
+            {
+                if (this != &rhs)
+                {
+                    release_();
+
+                    state_ = rhs.state_;
+                    rhs.state_ = nullptr;
+                }
+
+                return *this;
+            }
+
+            void swap(packaged_task& other) noexcept
+            {
+                std::swap(state_, other.state_);
+            }
+
+            bool valid() const noexcept
+            {
+                return state_ != nullptr;
+            }
+
+            future<R> get_future()
+            {
+                if (!state_)
+                {
+                    throw future_error{make_error_code(future_errc::no_state)};
+
+                    return future<R>{};
+                }
+
+                if (!state_->retrieve())
+                {
+                    throw future_error{
+                        make_error_code(future_errc::future_already_retrieved)
+                    };
+
+                    return future<R>{};
+                }
+
+                return aux::make_future<R>(state_);
+            }
+
+            void operator()(Args... args)
+            {
+                if (!state_)
+                {
+                    throw future_error{make_error_code(future_errc::no_state)};
+
+                    return;
+                }
+
+                state_->call(forward<Args>(args)...);
+            }
+
+            /**
+             * Note: The future of the old state sees
+             *       a broken promise if it was not run.
+             */
+            void reset()
+            {
+                if (!state_)
+                {
+                    throw future_error{make_error_code(future_errc::no_state)};
+
+                    return;
+                }
+
+                auto state = state_->reset();
+                release_();
+                state_ = state;
+            }
+
+        private:
+            aux::packaged_state_base<R, Args...>* state_;
+
+            void release_()
+            {
+                if (state_)
+                {
+                    state_->abandon();
+                    state_->release();
+                    state_ = nullptr;
+                }
+            }
     };
 
     template<class R, class... Args>
     void swap(packaged_task<R(Args...)>& lhs, packaged_task<R(Args...)>& rhs) noexcept
     {
         lhs.swap(rhs);
-    };
+    }
 
     template<class R, class Alloc>
     struct uses_allocator<packaged_task<R>, Alloc>: true_type
     { /* DUMMY BODY */ };
 
+    /**
+     * 30.6.8, function template async:
+     * Note: Asynchronous calls are run by the executor's
+     *       worker fibrils rather than by new threads.
+     */
+
     template<class F, class... Args>
     future<result_of_t<decay_t<F>(decay_t<Args>...)>>
-    async(F&& f, Args&&... args)
+    async(launch policy, F&& f, Args&&... args)
+    {
+        using result_type = result_of_t<decay_t<F>(decay_t<Args>...)>;
+        using state_type = aux::async_state<result_type, decay_t<F>, decay_t<Args>...>;
+
+        auto state = new state_type{forward<F>(f), forward<Args>(args)...};
+        auto fut = aux::make_future<result_type>(state);
+
+        if ((policy & launch::async) == launch::async)
+        {
+            auto& exec = aux::executor::instance();
+            state->set_executor(exec);
+
+            // The future holds one reference, the task the other.
+            exec.submit([state](){
+                state->execute();
+                state->release();
+            });
+        }
+        else
+        {
+            state->set_deferred();
+            state->release();
+        }
+
+        return fut;
+    }
+
+    namespace aux
     {
-        // TODO: implement
+        /**
+         * Only instantiated if the first argument of async
+         * is not a launch policy, where the result_of would
+         * be a hard error.
+         */
+        template<class F, class... Args>
+        struct async_future
+            : type_is<future<result_of_t<decay_t<F>(decay_t<Args>...)>>>
+        { /* DUMMY BODY */ };
     }
 
     template<class F, class... Args>
-    future<result_of_t<decay_t<F>(decay_t<Args>...)>>
-    async(launch, F&& f, Args&&... args)
+    typename enable_if_t<
+        !is_same_v<decay_t<F>, launch>,
+        aux::async_future<F, Args...>
+    >::type
+    async(F&& f, Args&&... args)
     {
-        // TODO: implement
+        return async(
+            launch::async | launch::deferred,
+            forward<F>(f), forward<Args>(args)...
+        );
     }
 }
 
@@ -96,15 +96,24 @@ namespace std
                     : joinable_wrapper{}, callable_{forward<Callable>(clbl)}
                 { /* DUMMY BODY */ }
 
-                void operator()()
+                /**
+                 * Returns true if the thread was detached and
+                 * the wrapper should be deleted by the caller.
+                 * Note: Once the joiner is woken up it may delete
+                 *       the wrapper, so we must not touch it after
+                 *       releasing the mutex.
+                 */
+                bool operator()()
                 {
                     callable_();
 
                     aux::threading::mutex::lock(join_mtx_);
                     finished_ = true;
+                    bool detached = detached_;
+                    aux::threading::condvar::broadcast(join_cv_);
                     aux::threading::mutex::unlock(join_mtx_);
 
-                    aux::threading::condvar::broadcast(join_cv_);
+                    return detached;
                 }
 
             private:
@@ -195,9 +204,7 @@ namespace std
                 return 1;
 
             auto callable = static_cast<CallablePtr>(clbl);
-            (*callable)();
-
-            if (callable->detached())
+            if ((*callable)())
                 delete callable;
 
             return 0;
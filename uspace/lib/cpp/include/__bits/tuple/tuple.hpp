@@ -432,6 +432,21 @@ namespace std
             }
     };
 
+    /**
+     * Note: The primary template cannot be instantiated
+     *       without elements, as some of its constructors
+     *       would be ill-formed then.
+     */
+    template<>
+    class tuple<>
+    {
+        public:
+            constexpr tuple() = default;
+
+            void swap(tuple&) noexcept
+            { /* DUMMY BODY */ }
+    };
+
     /**
      * 20.4.2.7, relational operators:
      */
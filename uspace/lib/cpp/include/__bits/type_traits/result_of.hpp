@@ -58,7 +58,7 @@ namespace std
     template<class F, class... ArgTypes>
     struct result_of<F(ArgTypes...)>: aux::type_is<
         typename enable_if<
-            is_function<typename decay<typename remove_pointer<F>::type>::type>::value ||
+            is_function<typename remove_pointer<typename decay<F>::type>::type>::value ||
             is_class<typename decay<F>::type>::value ||
             is_member_pointer<typename decay<F>::type>::value,
             decltype(aux::INVOKE(declval<F>(), declval<ArgTypes>()...))
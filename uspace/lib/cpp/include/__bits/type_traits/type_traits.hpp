@@ -531,7 +531,7 @@ namespace std
     inline constexpr bool is_trivial_v = is_trivial<T>::value;
 
     template<class T>
-    struct is_trivially_copyable: aux::value_is<bool, __has_trivial_copy(T)>
+    struct is_trivially_copyable: aux::value_is<bool, __is_trivially_copyable(T)>
     { /* DUMMY BODY */ };
 
     template<class T>
@@ -650,12 +650,12 @@ namespace std
 
     template<class T>
     struct is_copy_constructible
-        : is_constructible<T, add_lvalue_reference<const T>>
+        : is_constructible<T, add_lvalue_reference_t<const T>>
     { /* DUMMY BODY */ };
 
     template<class T>
     struct is_move_constructible
-        : is_constructible<T, add_rvalue_reference<T>>
+        : is_constructible<T, add_rvalue_reference_t<T>>
     { /* DUMMY BODY */ };
 
     template<class T, class U, class = void>
@@ -734,12 +734,27 @@ namespace std
     template<class T>
     inline constexpr bool is_trivially_destructible_v = is_trivially_destructible<T>::value;
 
+    namespace aux
+    {
+        template<class, class T, class... Args>
+        struct is_nothrow_constructible: false_type
+        { /* DUMMY BODY */ };
+
+        template<class T, class... Args>
+        struct is_nothrow_constructible<
+            void_t<decltype(T(declval<Args>()...))>,
+            T, Args...
+        >
+            : value_is<bool, noexcept(T(declval<Args>()...))>
+        { /* DUMMY BODY */ };
+    }
+
     template<class T, class... Args>
-    struct is_nothrow_constructible: aux::value_is<bool, __has_nothrow_constructor(T)>
+    struct is_nothrow_constructible: aux::is_nothrow_constructible<void_t<>, T, Args...>
     { /* DUMMY BODY */ };
 
-    template<class T>
-    inline constexpr bool is_nothrow_constructible_v = is_nothrow_constructible<T>::value;
+    template<class T, class... Args>
+    inline constexpr bool is_nothrow_constructible_v = is_nothrow_constructible<T, Args...>::value;
 
     template<class T>
     struct is_nothrow_default_constructible
@@ -747,7 +762,8 @@ namespace std
     { /* DUMMY BODY */ };
 
     template<class T>
-    struct is_nothrow_copy_constructible: aux::value_is<bool, __has_nothrow_copy(T)>
+    struct is_nothrow_copy_constructible
+        : is_nothrow_constructible<T, add_lvalue_reference_t<const T>>
     { /* DUMMY BODY */ };
 
     template<class T>
@@ -755,7 +771,7 @@ namespace std
 
     template<class T>
     struct is_nothrow_move_constructible
-        : is_nothrow_constructible<add_lvalue_reference_t<T>, add_rvalue_reference_t<T>>
+        : is_nothrow_constructible<T, add_rvalue_reference_t<T>>
     { /* DUMMY BODY */ };
 
     template<class T, class U>
@@ -999,7 +1015,7 @@ namespace std
     using make_signed_t = typename make_signed<T>::type;
 
     template<class T>
-    using make_unsigned_t = typename make_signed<T>::type;
+    using make_unsigned_t = typename make_unsigned<T>::type;
 
     /**
      * 20.10.7.4, array modifications:
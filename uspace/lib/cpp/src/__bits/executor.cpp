@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/thread/executor.hpp>
+#include <thread>
+
+namespace std::aux
+{
+    namespace
+    {
+        /**
+         * Queue of the worker running in the current fibril,
+         * null in fibrils that are not workers.
+         */
+        fibril_local work_queue* current_queue{};
+
+        constexpr size_t initial_queue_capacity{32};
+
+        /**
+         * Used when the number of processors is unknown,
+         * it matches the number of fibril runners we get
+         * from fibril_enable_multithreaded().
+         */
+        constexpr size_t default_worker_count{4};
+    }
+
+    work_queue::work_queue()
+        : mtx_{}, tasks_{}, capacity_{initial_queue_capacity},
+          head_{}, size_{}, owner_{}, index_{}
+    {
+        threading::mutex::init(mtx_);
+        tasks_ = new executor_task*[capacity_];
+    }
+
+    work_queue::~work_queue()
+    {
+        delete[] tasks_;
+    }
+
+    void work_queue::push(executor_task* task)
+    {
+        threading::mutex::lock(mtx_);
+
+        if (size_ == capacity_)
+            grow_();
+        tasks_[(head_ + size_) & (capacity_ - 1)] = task;
+        __atomic_store_n(&size_, size_ + 1, __ATOMIC_RELAXED);
+
+        threading::mutex::unlock(mtx_);
+    }
+
+    executor_task* work_queue::pop()
+    {
+        executor_task* res{};
+
+        threading::mutex::lock(mtx_);
+
+        if (size_ > 0)
+        {
+            __atomic_store_n(&size_, size_ - 1, __ATOMIC_RELAXED);
+            res = tasks_[(head_ + size_) & (capacity_ - 1)];
+        }
+
+        threading::mutex::unlock(mtx_);
+
+        return res;
+    }
+
+    executor_task* work_queue::steal()
+    {
+        /**
+         * Peek without the lock first, so that idle workers
+         * scanning empty queues do not contend with owners
+         * (size_ is only ever stored atomically for this).
+         */
+        if (__atomic_load_n(&size_, __ATOMIC_RELAXED) == 0)
+            return nullptr;
+
+        executor_task* res{};
+
+        threading::mutex::lock(mtx_);
+
+        if (size_ > 0)
+        {
+            res = tasks_[head_];
+            head_ = (head_ + 1) & (capacity_ - 1);
+            __atomic_store_n(&size_, size_ - 1, __ATOMIC_RELAXED);
+        }
+
+        threading::mutex::unlock(mtx_);
+
+        return res;
+    }
+
+    void work_queue::grow_()
+    {
+        // Capacity stays a power of two, so we can mask.
+        auto new_capacity = capacity_ * 2;
+        auto new_tasks = new executor_task*[new_capacity];
+
+        for (size_t i = 0; i < size_; ++i)
+            new_tasks[i] = tasks_[(head_ + i) & (capacity_ - 1)];
+
+        delete[] tasks_;
+        tasks_ = new_tasks;
+        capacity_ = new_capacity;
+        head_ = 0;
+    }
+
+    executor& executor::instance()
+    {
+        static executor exec{thread::hardware_concurrency()};
+
+        return exec;
+    }
+
+    executor::executor(size_t workers)
+        : queues_{}, workers_{workers ? workers : default_worker_count},
+          next_queue_{}, queued_{}, sleeping_{}, idle_mtx_{}, idle_cv_{}
+    {
+        threading::mutex::init(idle_mtx_);
+        threading::condvar::init(idle_cv_);
+
+        hel::fibril_enable_multithreaded();
+
+        queues_ = new work_queue[workers_];
+        for (size_t i = 0; i < workers_; ++i)
+        {
+            queues_[i].owner_ = this;
+            queues_[i].index_ = i;
+
+            auto fid = hel::fibril_create(&executor::worker_main_, &queues_[i]);
+            hel::fibril_add_ready(fid);
+        }
+    }
+
+    void executor::submit_task(executor_task* task)
+    {
+        /**
+         * Workers keep their subtasks local, everyone else
+         * spreads their tasks over the workers.
+         */
+        auto queue = current_queue;
+        if (!queue || queue->owner_ != this)
+        {
+            auto idx = __atomic_fetch_add(&next_queue_, 1, __ATOMIC_RELAXED);
+            queue = &queues_[idx % workers_];
+        }
+
+        queue->push(task);
+
+        /**
+         * This and the sequence in worker_main_ (increment
+         * sleeping_, then check queued_) make sure that either
+         * we see the sleeping worker or it sees our task.
+         */
+        __atomic_add_fetch(&queued_, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sleeping_, __ATOMIC_SEQ_CST) > 0)
+            wake_();
+    }
+
+    bool executor::run_one()
+    {
+        auto task = find_task_();
+        if (!task)
+            return false;
+
+        __atomic_sub_fetch(&queued_, 1, __ATOMIC_RELAXED);
+
+        task->run();
+        delete task;
+
+        return true;
+    }
+
+    executor_task* executor::find_task_()
+    {
+        auto own = current_queue;
+        size_t start{};
+        if (own && own->owner_ == this)
+        {
+            auto task = own->pop();
+            if (task)
+                return task;
+
+            start = own->index_ + 1;
+        }
+
+        /**
+         * Steal starting with the next worker, so that
+         * thieves do not all go after the same victim.
+         */
+        for (size_t i = 0; i < workers_; ++i)
+        {
+            auto& victim = queues_[(start + i) % workers_];
+            if (&victim == own)
+                continue;
+
+            auto task = victim.steal();
+            if (task)
+                return task;
+        }
+
+        return nullptr;
+    }
+
+    void executor::wake_()
+    {
+        threading::mutex::lock(idle_mtx_);
+        threading::condvar::signal(idle_cv_);
+        threading::mutex::unlock(idle_mtx_);
+    }
+
+    int executor::worker_main_(void* arg)
+    {
+        auto queue = static_cast<work_queue*>(arg);
+        auto exec = queue->owner_;
+        current_queue = queue;
+
+        while (true)
+        {
+            if (exec->run_one())
+                continue;
+
+            threading::mutex::lock(exec->idle_mtx_);
+
+            __atomic_add_fetch(&exec->sleeping_, 1, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&exec->queued_, __ATOMIC_SEQ_CST) == 0)
+                threading::condvar::wait(exec->idle_cv_, exec->idle_mtx_);
+            __atomic_sub_fetch(&exec->sleeping_, 1, __ATOMIC_SEQ_CST);
+
+            threading::mutex::unlock(exec->idle_mtx_);
+        }
+
+        return 0;
+    }
+
+    task_group::task_group(executor& exec)
+        : exec_{exec}, pending_{}, mtx_{}, cv_{}
+    {
+        threading::mutex::init(mtx_);
+        threading::condvar::init(cv_);
+    }
+
+    task_group::~task_group()
+    {
+        wait();
+    }
+
+    void task_group::wait()
+    {
+        while (__atomic_load_n(&pending_, __ATOMIC_ACQUIRE) > 0)
+        {
+            if (exec_.run_one())
+                continue;
+
+            /**
+             * Nothing left to steal, so the remaining tasks
+             * are already running elsewhere.
+             */
+            threading::mutex::lock(mtx_);
+            while (__atomic_load_n(&pending_, __ATOMIC_ACQUIRE) > 0)
+                threading::condvar::wait(cv_, mtx_);
+            threading::mutex::unlock(mtx_);
+        }
+
+        /**
+         * The last done_() might still hold the mutex, we must
+         * not let the group be destroyed before it is released.
+         */
+        threading::mutex::lock(mtx_);
+        threading::mutex::unlock(mtx_);
+    }
+
+    void task_group::done_()
+    {
+        threading::mutex::lock(mtx_);
+        if (__atomic_sub_fetch(&pending_, 1, __ATOMIC_ACQ_REL) == 0)
+            threading::condvar::broadcast(cv_);
+        threading::mutex::unlock(mtx_);
+    }
+}
@@ -29,8 +29,12 @@
 #include <__bits/test/tests.hpp>
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace std::test
 {
@@ -41,6 +45,8 @@ namespace std::test
 
         test_non_modifying();
         test_mutating();
+        test_sorting();
+        bench_sorting();
 
         return end();
     }
@@ -293,4 +299,209 @@ namespace std::test
         );
         test_eq("transform pt2", res6, data10.end());
     }
+
+    namespace
+    {
+        struct sort_elem
+        {
+            int key;
+            int idx;
+        };
+
+        std::vector<int> sort_data(std::size_t count, int pattern)
+        {
+            std::vector<int> res{};
+            res.reserve(count);
+
+            std::uint32_t seed{1};
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                seed = seed * 1103515245u + 12345u;
+                auto val = static_cast<int>(seed >> 8);
+
+                switch (pattern)
+                {
+                    case 0: // Random.
+                        res.push_back(val);
+                        break;
+                    case 1: // Sorted.
+                        res.push_back(static_cast<int>(i));
+                        break;
+                    case 2: // Reversed.
+                        res.push_back(static_cast<int>(count - i));
+                        break;
+                    default: // Few distinct values.
+                        res.push_back(val % 4);
+                        break;
+                }
+            }
+
+            return res;
+        }
+
+        template<class F>
+        long sort_time(F f)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto stop = std::chrono::steady_clock::now();
+
+            return static_cast<long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    stop - start
+                ).count()
+            );
+        }
+    }
+
+    void algorithm_test::test_sorting()
+    {
+        auto check1 = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+        std::array<int, 9> data1{5, 2, 9, 1, 7, 3, 8, 6, 4};
+
+        std::sort(data1.begin(), data1.end());
+        test_eq(
+            "sort small",
+            check1.begin(), check1.end(),
+            data1.begin(), data1.end()
+        );
+
+        bool sorted{true};
+        for (int pattern = 0; pattern < 4; ++pattern)
+        {
+            auto data2 = sort_data(1000, pattern);
+            std::sort(data2.begin(), data2.end());
+
+            sorted = sorted && std::is_sorted(data2.begin(), data2.end());
+        }
+        test("sort large", sorted);
+
+        auto data3 = sort_data(1000, 0);
+        std::sort(data3.begin(), data3.end(), [](auto x, auto y){ return x > y; });
+        test(
+            "sort comp",
+            std::is_sorted(data3.begin(), data3.end(),
+                           [](auto x, auto y){ return x > y; })
+        );
+
+        std::vector<sort_elem> data4{};
+        for (int i = 0; i < 500; ++i)
+            data4.push_back(sort_elem{(i * 37) % 7, i});
+
+        std::stable_sort(
+            data4.begin(), data4.end(),
+            [](const auto& x, const auto& y){ return x.key < y.key; }
+        );
+
+        bool stable{true};
+        for (std::size_t i = 1; i < data4.size(); ++i)
+        {
+            if (data4[i - 1].key > data4[i].key ||
+                (data4[i - 1].key == data4[i].key &&
+                 data4[i - 1].idx > data4[i].idx))
+            {
+                stable = false;
+                break;
+            }
+        }
+        test("stable_sort", stable);
+
+        auto check5 = {1, 2, 3, 4};
+        std::array<int, 9> data5{5, 2, 9, 1, 7, 3, 8, 6, 4};
+
+        std::partial_sort(data5.begin(), data5.begin() + 4, data5.end());
+        test_eq(
+            "partial_sort",
+            check5.begin(), check5.end(),
+            data5.begin(), data5.begin() + 4
+        );
+
+        auto data6 = sort_data(1000, 0);
+        auto data7 = data6;
+        std::sort(data7.begin(), data7.end());
+
+        std::nth_element(data6.begin(), data6.begin() + 333, data6.end());
+        test_eq("nth_element pt1", data6[333], data7[333]);
+        test(
+            "nth_element pt2",
+            std::all_of(
+                data6.begin(), data6.begin() + 333,
+                [&](auto x){ return x <= data7[333]; }
+            ) &&
+            std::all_of(
+                data6.begin() + 333, data6.end(),
+                [&](auto x){ return x >= data7[333]; }
+            )
+        );
+
+        auto check8 = {3, 4, 5, 1, 2};
+        std::array<int, 5> data8{1, 2, 3, 4, 5};
+
+        auto res8 = std::rotate(data8.begin(), data8.begin() + 2, data8.end());
+        test_eq(
+            "rotate pt1",
+            check8.begin(), check8.end(),
+            data8.begin(), data8.end()
+        );
+        test_eq("rotate pt2", res8, data8.begin() + 3);
+
+        std::array<int, 6> data9{1, 2, 2, 2, 3, 5};
+        test_eq(
+            "lower_bound",
+            std::lower_bound(data9.begin(), data9.end(), 2),
+            data9.begin() + 1
+        );
+        test_eq(
+            "upper_bound",
+            std::upper_bound(data9.begin(), data9.end(), 2),
+            data9.begin() + 4
+        );
+    }
+
+    void algorithm_test::bench_sorting()
+    {
+        /**
+         * Timings only, these do not fail. Compares the
+         * sorting algorithms against the heap sort that
+         * std::sort used to be.
+         */
+        if (!report_)
+            return;
+
+        constexpr std::size_t count{100000};
+        const char* patterns[] = {"random", "sorted", "reversed", "few"};
+
+        for (int pattern = 0; pattern < 4; ++pattern)
+        {
+            auto data = sort_data(count, pattern);
+            auto work = data;
+
+            auto heap = sort_time([&]{
+                std::make_heap(work.begin(), work.end());
+                std::sort_heap(work.begin(), work.end());
+            });
+
+            work = data;
+            auto intro = sort_time([&]{
+                std::sort(work.begin(), work.end());
+            });
+
+            work = data;
+            auto stable = sort_time([&]{
+                std::stable_sort(work.begin(), work.end());
+            });
+
+            work = data;
+            auto nth = sort_time([&]{
+                std::nth_element(work.begin(), work.begin() + count / 2,
+                                 work.end());
+            });
+
+            std::printf(
+                "[%s][bench %s] heap %ldus sort %ldus stable_sort %ldus "
+                "nth_element %ldus\n", name(), patterns[pattern],
+                heap, intro, stable, nth
+            );
+        }
+    }
 }
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <flat_hash_map>
+#include <flat_hash_set>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace std::test
+{
+    bool flat_hash_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_constructors_and_assignment();
+        test_emplace_insert();
+        test_erase();
+        test_set();
+        bench_maps();
+
+        return end();
+    }
+
+    const char* flat_hash_test::name()
+    {
+        return "flat_hash";
+    }
+
+    namespace
+    {
+        std::vector<std::uint32_t> hash_keys(std::size_t count)
+        {
+            std::vector<std::uint32_t> res{};
+            res.reserve(count);
+
+            std::uint32_t seed{1};
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                seed = seed * 1103515245u + 12345u;
+                res.push_back(seed);
+            }
+
+            return res;
+        }
+
+        template<class F>
+        long hash_time(F f)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto stop = std::chrono::steady_clock::now();
+
+            return static_cast<long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    stop - start
+                ).count()
+            );
+        }
+    }
+
+    void flat_hash_test::test_constructors_and_assignment()
+    {
+        auto check1 = {1, 2, 3, 4, 5, 6, 7};
+        std::initializer_list<std::pair<const int, int>> src1 = {
+            {3, 3}, {1, 1}, {5, 5}, {2, 2}, {7, 7}, {6, 6}, {4, 4}
+        };
+
+        std::hel::flat_hash_map<int, int> m1{src1};
+        test_contains(
+            "initializer list initialization",
+            check1.begin(), check1.end(), m1
+        );
+        test_eq("size", m1.size(), 7U);
+
+        std::hel::flat_hash_map<int, int> m2{src1.begin(), src1.end()};
+        test_contains(
+            "iterator range initialization",
+            check1.begin(), check1.end(), m2
+        );
+
+        std::hel::flat_hash_map<int, int> m3{m1};
+        test_contains(
+            "copy initialization",
+            check1.begin(), check1.end(), m3
+        );
+        test("copy equality", m1 == m3);
+
+        std::hel::flat_hash_map<int, int> m4{std::move(m1)};
+        test_contains(
+            "move initialization",
+            check1.begin(), check1.end(), m4
+        );
+        test_eq("move initialization - origin empty", m1.size(), 0U);
+        test_eq("empty", m1.empty(), true);
+
+        m1 = m4;
+        test_contains(
+            "copy assignment",
+            check1.begin(), check1.end(), m1
+        );
+
+        m4 = std::move(m1);
+        test_contains(
+            "move assignment",
+            check1.begin(), check1.end(), m4
+        );
+        test_eq("move assignment - origin empty", m1.size(), 0U);
+
+        m1 = src1;
+        test_contains(
+            "initializer list assignment",
+            check1.begin(), check1.end(), m1
+        );
+
+        std::size_t visited{};
+        int sum{};
+        for (const auto& x: m1)
+        {
+            ++visited;
+            sum += x.second;
+        }
+        test_eq("iteration count", visited, 7U);
+        test_eq("iteration sum", sum, 28);
+
+        std::hel::flat_hash_map<int, int> m5{};
+        m5.reserve(100);
+        auto capacity = m5.capacity();
+        for (int i = 0; i < 100; ++i)
+            m5[i] = i;
+        test_eq("reserve", m5.capacity(), capacity);
+        test("load factor", m5.load_factor() <= m5.max_load_factor());
+    }
+
+    void flat_hash_test::test_emplace_insert()
+    {
+        std::hel::flat_hash_map<int, std::string> map1{};
+
+        auto res1 = map1.emplace(1, "A");
+        test_eq("first emplace succession", res1.second, true);
+        test_eq("first emplace equivalence pt1", res1.first->first, 1);
+        test_eq("first emplace equivalence pt2", res1.first->second, std::string{"A"});
+
+        auto res2 = map1.emplace(1, "B");
+        test_eq("second emplace failure", res2.second, false);
+        test_eq("second emplace equivalence", res2.first->second, std::string{"A"});
+
+        auto res3 = map1.insert(std::pair<const int, std::string>{2, "C"});
+        test_eq("insert succession", res3.second, true);
+        test_eq("insert equivalence", res3.first->second, std::string{"C"});
+
+        auto res4 = map1.try_emplace(3, 2, 'D');
+        test_eq("try_emplace succession", res4.second, true);
+        test_eq("try_emplace equivalence", res4.first->second, std::string{"DD"});
+
+        auto res5 = map1.try_emplace(3, 2, 'E');
+        test_eq("try_emplace failure", res5.second, false);
+        test_eq("try_emplace no change", res5.first->second, std::string{"DD"});
+
+        auto res6 = map1.insert_or_assign(3, "F");
+        test_eq("insert_or_assign assign", res6.second, false);
+        test_eq("insert_or_assign equivalence", res6.first->second, std::string{"F"});
+
+        map1[4] = "G";
+        test_eq("operator[] insert", map1.at(4), std::string{"G"});
+        test_eq("operator[] access", map1[1], std::string{"A"});
+        test_eq("size", map1.size(), 4U);
+
+        test_eq("count pt1", map1.count(2), 1U);
+        test_eq("count pt2", map1.count(5), 0U);
+        test("contains", map1.contains(4) && !map1.contains(5));
+
+        /**
+         * Enough elements to grow the table a few
+         * times and to fill groups on probe paths.
+         */
+        std::hel::flat_hash_map<std::uint32_t, std::uint32_t> map2{};
+        auto keys = hash_keys(5000);
+        for (auto key: keys)
+            map2[key] = key ^ 0x5A5A5A5Au;
+
+        bool found{true};
+        for (auto key: keys)
+        {
+            auto it = map2.find(key);
+            found = found && it != map2.end() && it->second == (key ^ 0x5A5A5A5Au);
+        }
+        test("large insert", found);
+        test_eq("large size", map2.size(), keys.size());
+        test("large missing", map2.find(0xFFFFFFFFu) == map2.end());
+    }
+
+    void flat_hash_test::test_erase()
+    {
+        std::hel::flat_hash_map<int, int> map1{
+            {1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}
+        };
+
+        auto res1 = map1.erase(3);
+        test_eq("erase by key pt1", res1, 1U);
+        test_eq("erase by key pt2", map1.count(3), 0U);
+        test_eq("erase by key pt3", map1.size(), 4U);
+
+        auto res2 = map1.erase(3);
+        test_eq("erase missing key", res2, 0U);
+
+        auto it = map1.erase(map1.find(1));
+        test("erase by iterator pt1", map1.find(1) == map1.end());
+        test("erase by iterator pt2", it == map1.end() || it->first != 1);
+        test_eq("erase by iterator pt3", map1.size(), 3U);
+
+        map1.erase(map1.begin(), map1.end());
+        test_eq("erase range", map1.size(), 0U);
+        test("erase range begin", map1.begin() == map1.end());
+
+        /**
+         * Random inserts and erases checked against std::map,
+         * this leaves plenty of tombstones behind and makes
+         * the table rehash in place.
+         */
+        constexpr std::size_t key_count{2048};
+        std::hel::flat_hash_map<std::uint32_t, int> map2{};
+        std::map<std::uint32_t, int> check{};
+        auto keys = hash_keys(20000);
+
+        bool same{true};
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            auto key = keys[i] % key_count;
+            if (keys[i] & 0x100000)
+                same = same && map2.erase(key) == check.erase(key);
+            else
+            {
+                map2[key] = static_cast<int>(i);
+                check[key] = static_cast<int>(i);
+            }
+        }
+        test("erase mix size", same && map2.size() == check.size());
+
+        auto matches = [&](const std::hel::flat_hash_map<std::uint32_t, int>& map){
+            bool res{map.size() == check.size()};
+            for (std::uint32_t key = 0; key < key_count; ++key)
+            {
+                auto it1 = check.find(key);
+                auto it2 = map.find(key);
+                if (it1 != check.end())
+                    res = res && it2 != map.end() && it2->second == it1->second;
+                else
+                    res = res && it2 == map.end();
+            }
+
+            return res;
+        };
+        test("erase mix contents", matches(map2));
+
+        /**
+         * Copies keep the tombstones of the original, keys
+         * placed past them must still be found.
+         */
+        auto map3 = map2;
+        test("copy after erase", matches(map3));
+
+        std::hel::flat_hash_map<std::uint32_t, int> map4{};
+        map4 = map2;
+        test("copy assignment after erase", matches(map4));
+
+        map3[key_count] = 0;
+        map3.erase(key_count);
+        test("copy insert after erase", map3.size() == check.size() &&
+            map3.count(key_count) == 0U);
+
+        auto capacity = map2.capacity();
+        map2.rehash(0);
+        test("rehash keeps contents", matches(map2));
+        test("rehash shrinks", map2.capacity() <= capacity);
+
+        map2.clear();
+        test_eq("clear", map2.size(), 0U);
+        test("clear begin", map2.begin() == map2.end());
+    }
+
+    void flat_hash_test::test_set()
+    {
+        auto check1 = {1, 2, 3, 4, 5, 6, 7};
+        auto src1 = {3, 1, 5, 2, 7, 6, 4, 3, 1};
+
+        std::hel::flat_hash_set<int> s1{src1};
+        test_contains(
+            "set initializer list initialization",
+            check1.begin(), check1.end(), s1
+        );
+        test_eq("set size", s1.size(), 7U);
+
+        auto res1 = s1.emplace(8);
+        test_eq("set emplace succession", res1.second, true);
+        test_eq("set emplace equivalence", *res1.first, 8);
+
+        auto res2 = s1.insert(8);
+        test_eq("set insert failure", res2.second, false);
+
+        test_eq("set erase", s1.erase(8), 1U);
+        test_eq("set count", s1.count(8), 0U);
+
+        std::hel::flat_hash_set<std::string> s2{"alpha", "beta", "gamma"};
+        test("set strings", s2.contains("beta") && !s2.contains("delta"));
+
+        auto s3 = s2;
+        test("set copy equality", s3 == s2);
+        s3.erase("alpha");
+        test("set inequality", s3 != s2);
+    }
+
+    void flat_hash_test::bench_maps()
+    {
+        /**
+         * Timings only, these do not fail. Compares the flat
+         * table against the node based unordered_map on the
+         * same random keys, lookups are half hits, half misses.
+         */
+        if (!report_)
+            return;
+
+        constexpr std::size_t count{100000};
+        auto keys = hash_keys(2 * count);
+
+        std::hel::flat_hash_map<std::uint32_t, std::uint32_t> flat{};
+        std::unordered_map<std::uint32_t, std::uint32_t> node{};
+
+        auto flat_insert = hash_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+                flat[keys[i]] = i;
+        });
+        auto node_insert = hash_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+                node[keys[i]] = i;
+        });
+
+        std::size_t flat_hits{};
+        auto flat_find = hash_time([&]{
+            for (std::size_t i = count / 2; i < count + count / 2; ++i)
+                flat_hits += flat.count(keys[i]);
+        });
+        std::size_t node_hits{};
+        auto node_find = hash_time([&]{
+            for (std::size_t i = count / 2; i < count + count / 2; ++i)
+                node_hits += node.count(keys[i]);
+        });
+
+        /**
+         * Memory per entry: the flat table pays for its slots
+         * and control bytes, the node table for a list node
+         * per element and a pointer per bucket.
+         */
+        auto flat_bytes = flat.capacity() *
+            (sizeof(decltype(flat)::value_type) + 1);
+        auto node_bytes = node.size() *
+            sizeof(aux::list_node<decltype(node)::value_type>) +
+            node.bucket_count() * sizeof(void*);
+
+        auto flat_erase = hash_time([&]{
+            for (std::size_t i = 0; i < count; i += 2)
+                flat.erase(keys[i]);
+        });
+        auto node_erase = hash_time([&]{
+            for (std::size_t i = 0; i < count; i += 2)
+                node.erase(keys[i]);
+        });
+
+        std::printf(
+            "[%s][bench] insert flat %ldus node %ldus, find flat %ldus "
+            "node %ldus (%zu/%zu hits), erase flat %ldus node %ldus\n",
+            name(), flat_insert, node_insert, flat_find, node_find,
+            flat_hits, node_hits, flat_erase, node_erase
+        );
+        std::printf(
+            "[%s][bench] bytes per entry flat %zu node %zu\n",
+            name(), flat_bytes / count, node_bytes / count
+        );
+    }
+}
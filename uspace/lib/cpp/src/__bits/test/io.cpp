@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace std::test
+{
+    bool io_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_to_chars();
+        test_from_chars();
+        test_formatting();
+        test_filebuf();
+        bench_output();
+
+        return end();
+    }
+
+    const char* io_test::name()
+    {
+        return "io";
+    }
+
+    namespace
+    {
+        template<class T>
+        std::string io_to_chars(T value)
+        {
+            char buf[64];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+
+            return std::string(buf, res.ptr);
+        }
+
+        template<class T>
+        std::string io_to_chars(T value, std::chars_format fmt)
+        {
+            char buf[400];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value, fmt);
+
+            return std::string(buf, res.ptr);
+        }
+
+        template<class F>
+        long io_time(F f)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto stop = std::chrono::steady_clock::now();
+
+            return static_cast<long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    stop - start
+                ).count()
+            );
+        }
+    }
+
+    void io_test::test_to_chars()
+    {
+        test_eq("to_chars zero", io_to_chars(0), std::string{"0"});
+        test_eq("to_chars negative", io_to_chars(-1234567), std::string{"-1234567"});
+        test_eq("to_chars long long min", io_to_chars(LLONG_MIN),
+                std::string{"-9223372036854775808"});
+        test_eq("to_chars unsigned max", io_to_chars(ULLONG_MAX),
+                std::string{"18446744073709551615"});
+
+        char buf[70];
+        auto res = std::to_chars(buf, buf + sizeof(buf), 255, 16);
+        test_eq("to_chars hex", std::string(buf, res.ptr), std::string{"ff"});
+        res = std::to_chars(buf, buf + sizeof(buf), -35, 36);
+        test_eq("to_chars base 36", std::string(buf, res.ptr), std::string{"-z"});
+        res = std::to_chars(buf, buf + sizeof(buf), 5u, 2);
+        test_eq("to_chars binary", std::string(buf, res.ptr), std::string{"101"});
+
+        res = std::to_chars(buf, buf + 2, 123);
+        test("to_chars too small", res.ec == std::errc::value_too_large);
+        test("to_chars too small ptr", res.ptr == buf + 2);
+
+        test_eq("to_chars double simple", io_to_chars(0.1), std::string{"0.1"});
+        test_eq("to_chars double decimal", io_to_chars(123.456), std::string{"123.456"});
+        test_eq("to_chars double integral", io_to_chars(123456.0), std::string{"123456"});
+        test_eq("to_chars double large", io_to_chars(1e22), std::string{"1e+22"});
+        test_eq("to_chars double small", io_to_chars(1.5e-7), std::string{"1.5e-07"});
+        test_eq("to_chars double tiny", io_to_chars(5e-324), std::string{"5e-324"});
+        test_eq("to_chars double exact integer", io_to_chars(9007199254740992.0),
+                std::string{"9007199254740992"});
+        test_eq("to_chars double min", io_to_chars(2.2250738585072014e-308),
+                std::string{"2.2250738585072014e-308"});
+        test_eq("to_chars double negative zero", io_to_chars(-0.0), std::string{"-0"});
+        test_eq("to_chars double fraction", io_to_chars(-2.5), std::string{"-2.5"});
+        test_eq("to_chars double fixed", io_to_chars(1e22, std::chars_format::fixed),
+                std::string{"10000000000000000000000"});
+        test_eq("to_chars double scientific", io_to_chars(100.0, std::chars_format::scientific),
+                std::string{"1e+02"});
+        test_eq("to_chars double fixed small", io_to_chars(0.00125, std::chars_format::fixed),
+                std::string{"0.00125"});
+
+        test_eq("to_chars float simple", io_to_chars(0.3f), std::string{"0.3"});
+        test_eq("to_chars float third", io_to_chars(1.0f / 3.0f), std::string{"0.33333334"});
+        test_eq("to_chars float large", io_to_chars(3.4028235e38f), std::string{"3.4028235e+38"});
+        test_eq("to_chars float tiny", io_to_chars(1e-45f), std::string{"1e-45"});
+        test_eq("to_chars float carry", io_to_chars(9.999999e-5f), std::string{"9.999999e-05"});
+    }
+
+    void io_test::test_from_chars()
+    {
+        const char* str = "12345abc";
+        int i{};
+        auto res = std::from_chars(str, str + std::char_traits<char>::length(str), i);
+        test_eq("from_chars value", i, 12345);
+        test("from_chars ptr", res.ptr == str + 5);
+        test("from_chars ok", res.ec == std::errc{});
+
+        str = "-2147483648";
+        res = std::from_chars(str, str + std::char_traits<char>::length(str), i);
+        test_eq("from_chars int min", i, INT_MIN);
+
+        str = "2147483648";
+        i = 7;
+        res = std::from_chars(str, str + std::char_traits<char>::length(str), i);
+        test("from_chars overflow", res.ec == std::errc::result_out_of_range);
+        test("from_chars overflow ptr", res.ptr == str + 10);
+        test_eq("from_chars overflow untouched", i, 7);
+
+        str = "-5";
+        unsigned u{3};
+        res = std::from_chars(str, str + 2, u);
+        test("from_chars unsigned minus", res.ec == std::errc::invalid_argument);
+        test("from_chars invalid ptr", res.ptr == str);
+
+        str = "7fFfz";
+        res = std::from_chars(str, str + 5, u, 16);
+        test_eq("from_chars hex", u, 0x7fffU);
+
+        for (long long v: {0LL, 1LL, -1LL, LLONG_MAX, LLONG_MIN, 1234567890123LL})
+        {
+            char buf[32];
+            auto end = std::to_chars(buf, buf + sizeof(buf), v).ptr;
+            long long w{};
+            std::from_chars(buf, end, w);
+            test_eq("from_chars round trip", w, v);
+        }
+    }
+
+    void io_test::test_formatting()
+    {
+        std::ostringstream oss{};
+        oss << 42 << ' ' << -7L << ' ' << 18446744073709551615ULL;
+        test_eq("ostream integers", oss.str(), std::string{"42 -7 18446744073709551615"});
+
+        oss.str("");
+        oss << std::setw(6) << std::setfill('*') << -42 << '|'
+            << std::left << std::setw(6) << -42 << '|'
+            << std::internal << std::setw(6) << -42;
+        test_eq("ostream padding", oss.str(), std::string{"***-42|-42***|-***42"});
+
+        oss.str("");
+        oss << std::hex << 255 << ' ' << std::uppercase << 255 << ' '
+            << std::nouppercase << std::oct << 8 << ' ' << std::hex << -1;
+        test_eq("ostream bases", oss.str(), std::string{"ff FF 10 ffffffff"});
+
+        oss.str("");
+        oss << std::dec << 0.5 << ' ' << std::setprecision(3) << 3.14159 << ' '
+            << std::fixed << std::setprecision(2) << 2.5 << ' '
+            << std::scientific << 1234.5;
+        test_eq("ostream floating", oss.str(), std::string{"0.5 3.14 2.50 1.23e+03"});
+
+        oss.str("");
+        oss << std::defaultfloat << std::setprecision(6) << 1e300 << ' ' << 0.1f;
+        test_eq("ostream default float", oss.str(), std::string{"1e+300 0.1"});
+
+        std::string big(20000, 'x');
+        oss.str("");
+        oss << big << 1;
+        test_eq("ostream large string", oss.str().size(), big.size() + 1);
+    }
+
+    void io_test::test_filebuf()
+    {
+        const char* path = "/tmp/cpptest_io.txt";
+        constexpr int lines{20000};
+
+        {
+            std::ofstream out{path};
+            test("filebuf open out", out.is_open());
+
+            for (int i = 0; i < lines; ++i)
+                out << "line " << i << '\n';
+
+            std::string big(10000, 'z');
+            out << big << '\n';
+        }
+
+        std::ifstream in{path};
+        test("filebuf open in", in.is_open());
+
+        std::string line{};
+        int count{};
+        bool ok{true};
+        while (count < lines && std::getline(in, line))
+        {
+            if (line != "line " + std::to_string(count))
+                ok = false;
+            ++count;
+        }
+        test_eq("filebuf line count", count, lines);
+        test("filebuf line content", ok);
+
+        std::getline(in, line);
+        test_eq("filebuf large write", line.size(), std::size_t{10000});
+        test("filebuf large write content", line.find_first_not_of('z') == std::string::npos);
+
+        in.close();
+        std::remove(path);
+    }
+
+    void io_test::bench_output()
+    {
+        /**
+         * Timings only, these do not fail. Formats the same
+         * integers and doubles with iostreams, to_chars and
+         * snprintf.
+         */
+        if (!report_)
+            return;
+
+        constexpr std::size_t count{200000};
+        std::uint32_t seed{17};
+        auto next = [&seed]{
+            seed = seed * 1103515245u + 12345u;
+            return seed;
+        };
+
+        std::size_t sizes[4]{};
+        std::ostringstream oss{};
+        auto stream_ints = io_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+                oss << static_cast<int>(next()) << ' ';
+        });
+        sizes[0] = oss.str().size();
+
+        char buf[64];
+        seed = 17;
+        auto printf_ints = io_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+                sizes[1] += std::snprintf(buf, sizeof(buf), "%d ", static_cast<int>(next()));
+        });
+
+        seed = 17;
+        auto chars_doubles = io_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                double d = static_cast<double>(next()) / 1e3;
+                sizes[2] += std::to_chars(buf, buf + sizeof(buf), d).ptr - buf;
+            }
+        });
+
+        seed = 17;
+        auto printf_doubles = io_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                double d = static_cast<double>(next()) / 1e3;
+                sizes[3] += std::snprintf(buf, sizeof(buf), "%.17g", d);
+            }
+        });
+
+        std::printf(
+            "[%s][bench] %zu values, ostream ints %ldus (%zu bytes), "
+            "snprintf ints %ldus (%zu bytes), to_chars doubles %ldus "
+            "(%zu bytes), snprintf %%.17g doubles %ldus (%zu bytes)\n",
+            name(), count, stream_ints, sizes[0], printf_ints, sizes[1],
+            chars_doubles, sizes[2], printf_doubles, sizes[3]
+        );
+    }
+}
@@ -220,12 +220,26 @@ namespace std::test
         test_eq("erase root by iterator pt1", res14, map3.end());
         test_eq("erase root by iterator pt2", map3.empty(), true);
 
+        /**
+         * The root has two children and its
+         * successor is its right child.
+         */
+        map3[2] = 2;
+        map3[1] = 1;
+        map3[3] = 3;
+        auto res15 = map3.erase(map3.find(2));
+        test_eq("erase inner root pt1", res15->first, 3);
+        test_eq("erase inner root pt2", map3.size(), 2U);
+        test_eq("erase inner root pt3", map3.begin()->first, 1);
+        test_eq("erase inner root pt4", map3.count(3), 1U);
+        map3.clear();
+
         map2.clear();
         test_eq("clear", map2.empty(), true);
 
         map3[1] = 1;
-        auto res15 = map3.count(1);
-        test_eq("count", res15, 1U);
+        auto res16 = map3.count(1);
+        test_eq("count", res16, 1U);
     }
 
     void map_test::test_bounds_and_ranges()
@@ -30,8 +30,10 @@
 #include <__bits/test/tests.hpp>
 #include <initializer_list>
 #include <memory>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace std::test
 {
@@ -92,6 +94,7 @@ namespace std::test
         test_unique_ptr();
         test_shared_ptr();
         test_weak_ptr();
+        test_shared_ptr_concurrency();
         test_allocators();
         test_pointers();
 
@@ -177,6 +180,20 @@ namespace std::test
             test_eq("shared_ptr copy out of scope", mock::destructor_calls, 0U);
         }
         test_eq("shared_ptr original out of scope", mock::destructor_calls, 1U);
+
+        mock::clear();
+        allocation_counter::clear();
+        {
+            auto ptr1 = std::allocate_shared<mock>(counting_allocator<mock>{});
+            test_eq("allocate_shared single allocation", allocation_counter::allocations, 1U);
+            test_eq("allocate_shared construction", mock::constructor_calls, 1U);
+
+            std::weak_ptr<mock> wptr{ptr1};
+            ptr1.reset();
+            test_eq("allocate_shared object destroyed", mock::destructor_calls, 1U);
+            test_eq("allocate_shared block kept by weak_ptr", allocation_counter::deallocations, 0U);
+        }
+        test_eq("allocate_shared block deallocated", allocation_counter::deallocations, 1U);
     }
 
     void memory_test::test_weak_ptr()
@@ -198,6 +215,119 @@ namespace std::test
             }
             test_eq("weak_ptr expired after all shared_ptrs die", wptr1.expired(), true);
             test_eq("shared object destroyed while weak_ptr exists", mock::destructor_calls, 1U);
+            test_eq("lock of expired weak_ptr", (bool)wptr1.lock(), false);
+        }
+
+        std::weak_ptr<mock> wptr{};
+        test_eq("lock of empty weak_ptr", (bool)wptr.lock(), false);
+        wptr = wptr;
+        test_eq("weak_ptr self assignment", wptr.expired(), true);
+    }
+
+    void memory_test::test_shared_ptr_concurrency()
+    {
+        /**
+         * Without additional runners all fibrils run
+         * on one thread and the counts are updated
+         * non-atomically, so we need them to actually
+         * race here.
+         */
+        if (!hel::fibril_is_multithreaded())
+            hel::fibril_test_spawn_runners(3);
+
+        constexpr size_t thread_count{4};
+        constexpr size_t iterations{50000};
+
+        /**
+         * The threads wait until all of them are created
+         * so that they don't just run one after another.
+         */
+        bool start{};
+        auto wait_for_start = [&start](){
+            while (!__atomic_load_n(&start, __ATOMIC_ACQUIRE))
+                std::this_thread::yield();
+        };
+
+        mock::clear();
+        {
+            auto ptr = std::make_shared<mock>();
+            std::weak_ptr<mock> wptr{ptr};
+            const std::shared_ptr<mock>* shared = &ptr;
+            const std::weak_ptr<mock>* weak = &wptr;
+
+            std::vector<std::thread> threads{};
+            for (size_t i = 0; i < thread_count; ++i)
+            {
+                threads.emplace_back([shared, weak, wait_for_start](){
+                    wait_for_start();
+                    for (size_t j = 0; j < iterations; ++j)
+                    {
+                        std::shared_ptr<mock> copy{*shared};
+                        std::weak_ptr<mock> wcopy{copy};
+                        auto locked = weak->lock();
+                        copy.reset();
+                        locked = wcopy.lock();
+                    }
+                });
+            }
+
+            __atomic_store_n(&start, true, __ATOMIC_RELEASE);
+            for (auto& thr: threads)
+                thr.join();
+            start = false;
+
+            test_eq("concurrent copies use count", ptr.use_count(), 1L);
+            test_eq("concurrent copies no destruction", mock::destructor_calls, 0U);
+
+            ptr.reset();
+            test_eq("concurrent copies destroyed once", mock::destructor_calls, 1U);
+            test_eq("concurrent copies weak_ptr expired", wptr.expired(), true);
+        }
+
+        mock::clear();
+        {
+            std::vector<std::shared_ptr<mock>> ptrs{};
+            std::vector<std::weak_ptr<mock>> weaks{};
+            for (size_t i = 0; i < thread_count; ++i)
+            {
+                ptrs.push_back(std::make_shared<mock>());
+                weaks.push_back(ptrs.back());
+            }
+
+            /**
+             * Every thread drops the only shared_ptr to
+             * one of the objects midway while the others
+             * keep locking all of the weak_ptrs.
+             */
+            std::vector<std::thread> threads{};
+            for (size_t i = 0; i < thread_count; ++i)
+            {
+                auto own = &ptrs[i];
+                auto weak = weaks.data();
+                threads.emplace_back([own, weak, wait_for_start](){
+                    wait_for_start();
+                    for (size_t j = 0; j < iterations; ++j)
+                    {
+                        if (j == iterations / 2)
+                            own->reset();
+
+                        for (size_t k = 0; k < thread_count; ++k)
+                            weak[k].lock();
+                    }
+                });
+            }
+
+            __atomic_store_n(&start, true, __ATOMIC_RELEASE);
+            for (auto& thr: threads)
+                thr.join();
+            start = false;
+
+            bool all_expired{true};
+            for (auto& wptr: weaks)
+                all_expired = all_expired && wptr.expired();
+
+            test("concurrent locks all expired", all_expired);
+            test_eq("concurrent locks destroyed once", mock::destructor_calls, thread_count);
         }
     }
 
@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <execution>
+#include <functional>
+#include <future>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace std::test
+{
+    bool parallel_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_async();
+        test_promise();
+        test_shared_future();
+        test_packaged_task();
+        test_algorithms();
+        bench_scaling();
+
+        return end();
+    }
+
+    const char* parallel_test::name()
+    {
+        return "parallel";
+    }
+
+    namespace
+    {
+        std::vector<std::uint32_t> parallel_values(std::size_t count)
+        {
+            std::vector<std::uint32_t> res{};
+            res.reserve(count);
+
+            std::uint32_t seed{7};
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                seed = seed * 1103515245u + 12345u;
+                res.push_back(seed >> 8);
+            }
+
+            return res;
+        }
+
+        template<class F>
+        long parallel_time(F f)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto stop = std::chrono::steady_clock::now();
+
+            return static_cast<long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    stop - start
+                ).count()
+            );
+        }
+
+        /**
+         * Every level waits for the futures of its children,
+         * which only finishes if waiting workers run queued
+         * tasks instead of just blocking.
+         */
+        unsigned parallel_fib(unsigned n)
+        {
+            if (n < 2)
+                return n;
+
+            auto lhs = std::async(std::launch::async, parallel_fib, n - 1);
+            auto rhs = parallel_fib(n - 2);
+
+            return lhs.get() + rhs;
+        }
+    }
+
+    void parallel_test::test_async()
+    {
+        auto f1 = std::async(std::launch::async, [](int a, int b){
+            return a + b;
+        }, 2, 3);
+        test("async valid", f1.valid());
+        test_eq("async get", f1.get(), 5);
+        test("async invalid after get", !f1.valid());
+
+        bool called{false};
+        auto f2 = std::async(std::launch::deferred, [&called](){
+            called = true;
+
+            return 7;
+        });
+        test_eq(
+            "deferred wait_for", f2.wait_for(std::chrono::milliseconds{1}),
+            std::future_status::deferred
+        );
+        test("deferred not called before get", !called);
+        test_eq("deferred get", f2.get(), 7);
+        test("deferred called by get", called);
+
+        int value{};
+        auto f3 = std::async([&value](){ value = 3; });
+        f3.wait();
+        test_eq("async void", value, 3);
+
+        std::vector<std::future<std::size_t>> futures{};
+        for (std::size_t i = 0; i < 100; ++i)
+            futures.push_back(std::async(std::launch::async, [i](){ return i * i; }));
+
+        std::size_t sum{};
+        for (auto& fut: futures)
+            sum += fut.get();
+        test_eq("many async tasks", sum, 328350U);
+
+        test_eq("nested async", parallel_fib(15), 610U);
+
+        int counter{};
+        {
+            auto f4 = std::async(std::launch::async, [&counter](){ counter = 1; });
+        }
+        test_eq("async future destructor waits", counter, 1);
+    }
+
+    void parallel_test::test_promise()
+    {
+        std::promise<int> p1{};
+        auto f1 = p1.get_future();
+        test_eq(
+            "promise not ready", f1.wait_for(std::chrono::microseconds{1}),
+            std::future_status::timeout
+        );
+
+        auto setter = std::async(std::launch::async, [&p1](){ p1.set_value(42); });
+        test_eq("promise get", f1.get(), 42);
+
+        int x{};
+        std::promise<int&> p2{};
+        auto f2 = p2.get_future();
+        p2.set_value(x);
+        f2.get() = 5;
+        test_eq("promise reference", x, 5);
+
+        std::promise<void> p3{};
+        auto f3 = p3.get_future();
+        p3.set_value();
+        test_eq(
+            "promise void ready", f3.wait_for(std::chrono::microseconds{1}),
+            std::future_status::ready
+        );
+        f3.get();
+
+        std::promise<int> p4{};
+        auto f4 = p4.get_future();
+        auto p5 = std::move(p4);
+        p5.set_value(1);
+        test_eq("moved promise", f4.get(), 1);
+    }
+
+    void parallel_test::test_shared_future()
+    {
+        std::promise<int> p1{};
+        std::shared_future<int> f1 = p1.get_future().share();
+        auto f2 = f1;
+        test("shared future valid", f1.valid() && f2.valid());
+
+        auto reader = std::async(std::launch::async, [f2](){ return f2.get() + 1; });
+        p1.set_value(41);
+        test_eq("shared future get", f1.get(), 41);
+        test_eq("shared future get again", f1.get(), 41);
+        test_eq("shared future copy", reader.get(), 42);
+        test("shared future valid after get", f1.valid());
+
+        int x{};
+        std::promise<int&> p2{};
+        std::shared_future<int&> f3{p2.get_future()};
+        p2.set_value(x);
+        f3.get() = 7;
+        test_eq("shared future reference", x, 7);
+
+        auto f4 = std::async(std::launch::async, [](){ /* DUMMY BODY */ }).share();
+        f4.get();
+        test("shared future void", f4.valid());
+
+        std::shared_future<int> f5{};
+        test("shared future default", !f5.valid());
+    }
+
+    void parallel_test::test_packaged_task()
+    {
+        std::packaged_task<int(int, int)> t1{[](int a, int b){ return a * b; }};
+        test("packaged task valid", t1.valid());
+        auto f1 = t1.get_future();
+        t1(6, 7);
+        test_eq("packaged task get", f1.get(), 42);
+
+        t1.reset();
+        auto f2 = t1.get_future();
+        auto t2 = std::move(t1);
+        test("packaged task moved", !t1.valid() && t2.valid());
+
+        auto runner = std::async(std::launch::async, [&t2](){ t2(2, 3); });
+        test_eq("packaged task async", f2.get(), 6);
+
+        int value{};
+        std::packaged_task<void(int&)> t3{[](int& v){ v = 3; }};
+        auto f3 = t3.get_future();
+        t3(value);
+        f3.get();
+        test_eq("packaged task void", value, 3);
+
+        std::packaged_task<int()> t4{};
+        test("packaged task default", !t4.valid());
+    }
+
+    void parallel_test::test_algorithms()
+    {
+        constexpr std::size_t count{100000};
+        auto data = parallel_values(count);
+
+        auto expected = data;
+        for (auto& x: expected)
+            x += 1;
+        auto actual = data;
+        std::for_each(std::execution::par, actual.begin(), actual.end(),
+                      [](auto& x){ x += 1; });
+        test("parallel for_each", actual == expected);
+
+        std::vector<std::uint32_t> res(count);
+        std::transform(std::execution::par, data.begin(), data.end(), res.begin(),
+                       [](auto x){ return x / 3; });
+        std::transform(data.begin(), data.end(), expected.begin(),
+                       [](auto x){ return x / 3; });
+        test("parallel transform", res == expected);
+
+        std::transform(std::execution::par, data.begin(), data.end(), res.begin(),
+                       res.begin(), [](auto x, auto y){ return x ^ y; });
+        std::transform(data.begin(), data.end(), expected.begin(), expected.begin(),
+                       [](auto x, auto y){ return x ^ y; });
+        test("parallel binary transform", res == expected);
+
+        auto sum = std::accumulate(data.begin(), data.end(), std::uint64_t{});
+        test_eq(
+            "parallel reduce",
+            std::reduce(std::execution::par, data.begin(), data.end(), std::uint64_t{}),
+            sum
+        );
+        test_eq(
+            "sequenced reduce",
+            std::reduce(std::execution::seq, data.begin(), data.end(), std::uint64_t{}),
+            sum
+        );
+        test_eq(
+            "parallel reduce with op",
+            std::reduce(std::execution::par, data.begin(), data.end(), std::uint32_t{},
+                        [](auto x, auto y){ return x > y ? x : y; }),
+            std::accumulate(data.begin(), data.end(), std::uint32_t{},
+                            [](auto x, auto y){ return x > y ? x : y; })
+        );
+
+        std::vector<int> small{3, 1, 2};
+        test_eq("parallel reduce small", std::reduce(std::execution::par, small.begin(), small.end()), 6);
+
+        expected = data;
+        std::sort(expected.begin(), expected.end());
+        actual = data;
+        std::sort(std::execution::par, actual.begin(), actual.end());
+        test("parallel sort", actual == expected);
+
+        std::sort(expected.begin(), expected.end(), std::greater<std::uint32_t>{});
+        std::sort(std::execution::par_unseq, actual.begin(), actual.end(),
+                  std::greater<std::uint32_t>{});
+        test("parallel sort with comparator", actual == expected);
+
+        std::sort(std::execution::par, small.begin(), small.end());
+        test("parallel sort small", small == std::vector<int>{1, 2, 3});
+    }
+
+    void parallel_test::bench_scaling()
+    {
+        /**
+         * Timings only, these do not fail. Compares the
+         * sequential algorithms with their parallel versions.
+         */
+        if (!report_)
+            return;
+
+        constexpr std::size_t count{1000000};
+        auto data = parallel_values(count);
+        std::vector<std::uint32_t> res(count);
+
+        auto transform_seq = parallel_time([&]{
+            std::transform(data.begin(), data.end(), res.begin(),
+                           [](auto x){ return x * x + 1; });
+        });
+        auto transform_par = parallel_time([&]{
+            std::transform(std::execution::par, data.begin(), data.end(), res.begin(),
+                           [](auto x){ return x * x + 1; });
+        });
+
+        std::uint64_t sums[2]{};
+        auto reduce_seq = parallel_time([&]{
+            sums[0] = std::reduce(data.begin(), data.end(), std::uint64_t{});
+        });
+        auto reduce_par = parallel_time([&]{
+            sums[1] = std::reduce(std::execution::par, data.begin(), data.end(),
+                                  std::uint64_t{});
+        });
+
+        res = data;
+        auto sort_seq = parallel_time([&]{
+            std::sort(res.begin(), res.end());
+        });
+        res = data;
+        auto sort_par = parallel_time([&]{
+            std::sort(std::execution::par, res.begin(), res.end());
+        });
+
+        std::printf(
+            "[%s][bench] %zu workers, transform seq %ldus par %ldus, "
+            "reduce seq %ldus par %ldus, sort seq %ldus par %ldus\n",
+            name(), aux::executor::instance().workers(),
+            transform_seq, transform_par, reduce_seq, reduce_par,
+            sort_seq, sort_par
+        );
+    }
+}
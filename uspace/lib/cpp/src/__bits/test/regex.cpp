@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace std::test
+{
+    bool regex_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_match();
+        test_search();
+        test_captures();
+        test_replace();
+        test_iterator();
+        test_errors();
+        test_long();
+        bench_logs();
+
+        return end();
+    }
+
+    const char* regex_test::name()
+    {
+        return "regex";
+    }
+
+    namespace
+    {
+        const char* regex_levels[] = {"debug", "info", "info", "info", "warn", "error"};
+        const char* regex_sources[] = {"net", "vfs", "devman", "hound", "kernel"};
+
+        /**
+         * Synthetic log corpus, one line per entry
+         * generated from a simple LCG.
+         */
+        std::vector<std::string> regex_corpus(std::size_t count)
+        {
+            std::vector<std::string> res{};
+            res.reserve(count);
+
+            std::uint32_t seed{11};
+            auto next = [&seed](std::uint32_t mod){
+                seed = seed * 1103515245u + 12345u;
+                return (seed >> 8) % mod;
+            };
+
+            char buf[160];
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                std::snprintf(
+                    buf, sizeof(buf),
+                    "2026-10-%02u %02u:%02u:%02u [%s] %s: request %u took %u us from 10.0.%u.%u",
+                    next(28) + 1, next(24), next(60), next(60),
+                    regex_levels[next(6)], regex_sources[next(5)],
+                    next(100000), next(5000), next(256), next(256)
+                );
+                res.emplace_back(buf);
+            }
+
+            return res;
+        }
+
+        template<class F>
+        long regex_time(F f)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto stop = std::chrono::steady_clock::now();
+
+            return static_cast<long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    stop - start
+                ).count()
+            );
+        }
+    }
+
+    void regex_test::test_match()
+    {
+        std::regex re1{"abc"};
+        test("match literal", std::regex_match("abc", re1));
+        test("match literal prefix", !std::regex_match("abcd", re1));
+        test("match literal short", !std::regex_match("ab", re1));
+
+        std::regex re2{"a(b|c)*d"};
+        test("match star", std::regex_match("abcbcd", re2));
+        test("match star empty", std::regex_match("ad", re2));
+        test("match star bad", !std::regex_match("abxd", re2));
+
+        std::regex re3{"[a-f0-9]{2,4}-\\d+"};
+        test("match class repeat", std::regex_match("c0de-42", re3));
+        test("match class too long", !std::regex_match("c0def-42", re3));
+        test("match class too short", !std::regex_match("c-42", re3));
+
+        std::regex re4{"[^\\s]+\\s*"};
+        test("match negated class", std::regex_match("word  ", re4));
+        test("match negated class bad", !std::regex_match(" word", re4));
+
+        std::regex re5{"hello world", std::regex::icase};
+        test("match icase", std::regex_match("HeLLo WORLD", re5));
+
+        std::regex re6{"a.c"};
+        test("match dot", std::regex_match("a-c", re6));
+        test("match dot newline", !std::regex_match("a\nc", re6));
+
+        std::regex re7{"(\\w+)=\\1"};
+        test("match backref", std::regex_match("abc=abc", re7));
+        test("match backref bad", !std::regex_match("abc=abd", re7));
+
+        std::regex re8{"x*"};
+        test("match empty", std::regex_match("", re8));
+
+        std::regex re9{"[[:digit:][:upper:]]+"};
+        test("match class names", std::regex_match("A1B2", re9));
+        test("match class names bad", !std::regex_match("a1", re9));
+
+        std::string str{"key: value"};
+        std::smatch m{};
+        std::regex re10{"(\\w+): (\\w+)"};
+        test("match string", std::regex_match(str, m, re10));
+        test_eq("match string size", m.size(), 3U);
+        test_eq("match string group", m.str(2), std::string{"value"});
+    }
+
+    void regex_test::test_search()
+    {
+        std::regex re1{"error|warn"};
+        test("search alternation", std::regex_search("x [warn] y", re1));
+        test("search none", !std::regex_search("x [info] y", re1));
+
+        std::regex re2{"^abc"};
+        test("search bol", std::regex_search("abcdef", re2));
+        test("search bol bad", !std::regex_search("xabc", re2));
+        test("search not_bol", !std::regex_search("abc", re2, std::regex_constants::match_not_bol));
+
+        std::regex re3{"def$"};
+        test("search eol", std::regex_search("abcdef", re3));
+        test("search eol bad", !std::regex_search("defabc", re3));
+
+        std::regex re4{"^line$", std::regex::multiline};
+        test("search multiline", std::regex_search("first\nline\nlast", re4));
+
+        std::regex re5{"\\bcat\\b"};
+        test("search word boundary", std::regex_search("a cat sat", re5));
+        test("search word boundary bad", !std::regex_search("concatenate", re5));
+
+        std::cmatch m{};
+        std::regex re6{"a+"};
+        test("search leftmost", std::regex_search("xxaaayaa", m, re6));
+        test_eq("search leftmost position", m.position(0), 2L);
+        test_eq("search leftmost length", m.length(0), 3L);
+        test_eq("search prefix", m.prefix().str(), std::string{"xx"});
+        test_eq("search suffix", m.suffix().str(), std::string{"yaa"});
+
+        std::regex re7{"a+?"};
+        test("search lazy", std::regex_search("aaa", m, re7));
+        test_eq("search lazy length", m.length(0), 1L);
+
+        std::regex re8{"(a|ab)(c|bcd)(d*)"};
+        test("search ecmascript order", std::regex_search("abcd", m, re8));
+        test_eq("search ecmascript order str", m.str(0), std::string{"abcd"});
+        test_eq("search ecmascript order group", m.str(1), std::string{"a"});
+
+        /**
+         * Exponential for naive backtracking,
+         * fast with the visited bitmap.
+         */
+        std::string hard(30, 'a');
+        std::regex re9{"(a*)*b"};
+        test("search pathological", !std::regex_search(hard, re9));
+        test("search pathological results", !std::regex_search(hard.cbegin(), hard.cend(), re9));
+        std::smatch sm{};
+        test("search pathological captures", !std::regex_search(hard, sm, re9));
+        test("search failed ready", sm.ready() && sm.empty());
+    }
+
+    void regex_test::test_captures()
+    {
+        std::regex re{"(\\d{4})-(\\d\\d)-(\\d\\d)(?: (\\d\\d):(\\d\\d))?"};
+        std::cmatch m{};
+
+        test("captures pt1", std::regex_match("2026-10-19 12:30", m, re));
+        test_eq("captures pt2", m.size(), 6U);
+        test_eq("captures pt3", m.str(1), std::string{"2026"});
+        test_eq("captures pt4", m.str(3), std::string{"19"});
+        test_eq("captures pt5", m.str(5), std::string{"30"});
+
+        test("captures optional pt1", std::regex_match("2026-10-19", m, re));
+        test("captures optional pt2", !m[4].matched);
+        test_eq("captures optional pt3", m.str(4), std::string{});
+        test("captures out of range", !m[42].matched);
+
+        std::regex re2{"(a)|(b)"};
+        test("captures alternation pt1", std::regex_search("b", m, re2));
+        test("captures alternation pt2", !m[1].matched && m[2].matched);
+
+        std::regex re3{"(\\w)+"};
+        test("captures last iteration pt1", std::regex_match("abc", m, re3));
+        test_eq("captures last iteration pt2", m.str(1), std::string{"c"});
+
+        std::regex re4{"(a)(b)", std::regex::nosubs};
+        test_eq("captures nosubs pt1", re4.mark_count(), 0U);
+        test("captures nosubs pt2", std::regex_match("ab", m, re4));
+        test_eq("captures nosubs pt3", m.size(), 1U);
+    }
+
+    void regex_test::test_replace()
+    {
+        std::regex re1{"(\\w+)@(\\w+)"};
+        std::string str{"mail bob@host and eve@box now"};
+
+        auto res1 = std::regex_replace(str, re1, "$2!$1");
+        test_eq("replace groups", res1, std::string{"mail host!bob and box!eve now"});
+
+        auto res2 = std::regex_replace(str, re1, "<$&>",
+                                       std::regex_constants::format_first_only);
+        test_eq("replace first only", res2, std::string{"mail <bob@host> and eve@box now"});
+
+        auto res3 = std::regex_replace(str, re1, "[$1]",
+                                       std::regex_constants::format_no_copy);
+        test_eq("replace no copy", res3, std::string{"[bob][eve]"});
+
+        auto res4 = std::regex_replace(std::string{"a.b"}, std::regex{"\\."}, "$$");
+        test_eq("replace dollar", res4, std::string{"a$b"});
+
+        auto res5 = std::regex_replace(std::string{"abc"}, std::regex{"x*"}, "-");
+        test_eq("replace empty matches", res5, std::string{"-a-b-c-"});
+
+        auto res6 = std::regex_replace("no match here", std::regex{"\\d"}, "#");
+        test_eq("replace no match", res6, std::string{"no match here"});
+
+        auto res7 = std::regex_replace(std::string{"a1b22"}, std::regex{"(\\d)"}, "<\\1&>",
+                                       std::regex_constants::format_sed);
+        test_eq("replace sed", res7, std::string{"a<11>b<22><22>"});
+    }
+
+    void regex_test::test_iterator()
+    {
+        std::string str{"k1=v1; k2=v2; k3=v3"};
+        std::regex re{"(\\w+)=(\\w+)"};
+
+        std::vector<std::string> keys{};
+        std::vector<long> positions{};
+        for (std::sregex_iterator it{str.begin(), str.end(), re}, end{}; it != end; ++it)
+        {
+            keys.push_back(it->str(1));
+            positions.push_back(it->position(0));
+        }
+
+        auto check_keys = {std::string{"k1"}, std::string{"k2"}, std::string{"k3"}};
+        auto check_positions = {0L, 7L, 14L};
+        test_eq("iterator keys", keys.begin(), keys.end(),
+                check_keys.begin(), check_keys.end());
+        test_eq("iterator positions", positions.begin(), positions.end(),
+                check_positions.begin(), check_positions.end());
+
+        const char* text{"one two three"};
+        std::regex words{"\\b\\w"};
+        auto count = std::distance(
+            std::cregex_iterator{text, text + 13, words},
+            std::cregex_iterator{}
+        );
+        test_eq("iterator word starts", count, 3L);
+    }
+
+    void regex_test::test_errors()
+    {
+        /**
+         * Note: Without exceptions the regex is left invalid
+         *       and never matches, which is what we check.
+         */
+        std::regex bad1{"a(b"};
+        test("error paren", !std::regex_search("ab", bad1));
+        std::regex bad2{"[abc"};
+        test("error brack", !std::regex_search("a", bad2));
+        std::regex bad3{"*a"};
+        test("error badrepeat", !std::regex_search("a", bad3));
+        std::regex bad4{"a{3,1}"};
+        test("error badbrace", !std::regex_search("aaa", bad4));
+        std::regex bad5{"(a)\\2"};
+        test("error backref", !std::regex_search("aa", bad5));
+        std::regex bad6{"[z-a]"};
+        test("error range", !std::regex_search("m", bad6));
+    }
+
+    void regex_test::test_long()
+    {
+        /**
+         * Inputs too long for the visited bitmap of the
+         * backtracker, these used to fail with error_complexity
+         * once enough steps accumulated over the start positions.
+         */
+        std::string big(std::size_t{1} << 22, 'a');
+        big += "b";
+        auto end = static_cast<long>(big.size());
+        std::smatch m{};
+
+        std::regex re1{"(a)\\1b"};
+        test("long backref", std::regex_search(big, m, re1));
+        test_eq("long backref position", m.position(0), end - 3);
+        test_eq("long backref group", m.str(1), std::string{"a"});
+
+        std::regex re2{"(a)(a)b"};
+        test("long search", std::regex_search(big, m, re2));
+        test_eq("long search position", m.position(0), end - 3);
+        test_eq("long search group", m.str(2), std::string{"a"});
+
+        std::regex re3{"(a+?)(a*)b"};
+        test("long match", std::regex_match(big, m, re3));
+        test_eq("long match lazy", m.length(1), 1L);
+        test_eq("long match greedy", m.length(2), end - 2);
+
+        std::regex re4{"(a|b)*c"};
+        test("long match none", !std::regex_match(big, m, re4));
+        test("long search none", !std::regex_search(big, m, re4));
+    }
+
+    void regex_test::bench_logs()
+    {
+        /**
+         * Timings only, these do not fail. Counts matching
+         * lines of a log corpus the way a log filter would.
+         */
+        if (!report_)
+            return;
+
+        constexpr std::size_t count{20000};
+        auto lines = regex_corpus(count);
+        std::size_t bytes{};
+        for (const auto& line: lines)
+            bytes += line.size();
+
+        std::size_t hits[4]{};
+
+        // Answered by the DFA alone.
+        std::regex level{"\\[(error|warn)\\]"};
+        auto filter = regex_time([&]{
+            for (const auto& line: lines)
+                hits[0] += std::regex_search(line, level);
+        });
+
+        // Same, but the captures need the backtracker.
+        std::smatch m{};
+        auto filter_captures = regex_time([&]{
+            for (const auto& line: lines)
+                hits[3] += std::regex_search(line, m, level);
+        });
+
+        std::regex fields{
+            "(\\d{4})-(\\d\\d)-(\\d\\d) (\\d\\d):(\\d\\d):(\\d\\d) "
+            "\\[(\\w+)\\] (\\w+): (.*)"
+        };
+        auto parse = regex_time([&]{
+            for (const auto& line: lines)
+                hits[1] += std::regex_match(line, m, fields) && m.str(7) == "error";
+        });
+
+        std::regex repeated{"(\\d)\\1\\1"};
+        auto backref = regex_time([&]{
+            for (const auto& line: lines)
+                hits[2] += std::regex_search(line, repeated);
+        });
+
+        auto rate = [bytes](long us){
+            return us > 0 ? static_cast<unsigned long>(bytes / us) : 0UL;
+        };
+
+        std::printf(
+            "[%s][bench] %zu lines (%zu bytes), filter %ldus (%lu MB/s, %zu hits), "
+            "filter with captures %ldus (%lu MB/s, %zu hits), parse %ldus (%lu MB/s, "
+            "%zu hits), backref %ldus (%lu MB/s, %zu hits)\n",
+            name(), count, bytes, filter, rate(filter), hits[0],
+            filter_captures, rate(filter_captures), hits[3],
+            parse, rate(parse), hits[1], backref, rate(backref), hits[2]
+        );
+    }
+}
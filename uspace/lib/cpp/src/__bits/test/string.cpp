@@ -27,9 +27,12 @@
  */
 
 #include <initializer_list>
+#include <__bits/test/mock.hpp>
 #include <__bits/test/tests.hpp>
+#include <functional>
 #include <string>
 #include <cstdio>
+#include <utility>
 
 namespace std::test
 {
@@ -47,6 +50,8 @@ namespace std::test
         test_find();
         test_substr();
         test_compare();
+        test_allocation();
+        test_hash();
 
         return end();
     }
@@ -703,4 +708,86 @@ namespace std::test
             res, 0
         );
     }
+
+    void string_test::test_allocation()
+    {
+        using string_type = std::basic_string<
+            char, std::char_traits<char>, counting_allocator<char>
+        >;
+
+        allocation_counter::clear();
+        {
+            string_type str1{};
+            test_eq("default constructor allocations", allocation_counter::allocations, 0U);
+
+            string_type str2{"hello"};
+            string_type str3{"fifteen chars.."};
+            test_eq("short string allocations", allocation_counter::allocations, 0U);
+            test_eq(
+                "short string contents",
+                str3.begin(), str3.end(),
+                "fifteen chars..", "fifteen chars.." + 15
+            );
+
+            string_type str4{str2};
+            str4 += " world";
+            test_eq("short copy and append allocations", allocation_counter::allocations, 0U);
+            test_eq("short append c_str", std::string{str4.c_str()}, std::string{"hello world"});
+
+            string_type str5{"sixteen chars..."};
+            test_eq("long string allocations", allocation_counter::allocations, 1U);
+
+            string_type str6{std::move(str5)};
+            test_eq("long move allocations", allocation_counter::allocations, 1U);
+            test("long move source empty", str5.empty() && *str5.c_str() == '\0');
+            test_eq("long move size", str6.size(), 16U);
+
+            string_type str7{std::move(str2)};
+            test_eq("short move allocations", allocation_counter::allocations, 1U);
+            test_eq("short move c_str", std::string{str7.c_str()}, std::string{"hello"});
+            test("short move source empty", str2.empty());
+
+            str7.swap(str6);
+            test_eq("mixed swap allocations", allocation_counter::allocations, 1U);
+            test_eq("mixed swap pt1", std::string{str7.c_str()}, std::string{"sixteen chars..."});
+            test_eq("mixed swap pt2", std::string{str6.c_str()}, std::string{"hello"});
+
+            str3 = std::move(str7);
+            test_eq("move assignment allocations", allocation_counter::allocations, 1U);
+            test_eq("move assignment c_str", std::string{str3.c_str()}, std::string{"sixteen chars..."});
+
+            for (int i = 0; i < 10; ++i)
+                str1.push_back('a' + i);
+            test_eq("push_back within buffer allocations", allocation_counter::allocations, 1U);
+
+            for (int i = 0; i < 10; ++i)
+                str1.push_back('a' + i);
+            test_eq("push_back growth allocations", allocation_counter::allocations, 2U);
+            test_eq("push_back growth c_str", std::string{str1.c_str()}, std::string{"abcdefghijabcdefghij"});
+
+            str1.resize(4);
+            str1.shrink_to_fit();
+            test_eq("shrink_to_fit deallocations", allocation_counter::deallocations, 1U);
+            test_eq("shrink_to_fit c_str", std::string{str1.c_str()}, std::string{"abcd"});
+        }
+        test_eq(
+            "balanced allocations",
+            allocation_counter::allocations, allocation_counter::deallocations
+        );
+    }
+
+    void string_test::test_hash()
+    {
+        std::hash<std::string> hasher{};
+
+        std::string str1{"helenos"};
+        std::string str2{"helen"};
+        str2 += "os";
+        test_eq("hash of equal strings", hasher(str1), hasher(str2));
+
+        std::string str3{"a longer string that spans a few words"};
+        std::string str4{"a longer string that spans a few wordz"};
+        test("hash of different strings", hasher(str3) != hasher(str4));
+        test("hash of prefix", hasher(str1) != hasher(std::string{"helen"}));
+    }
 }
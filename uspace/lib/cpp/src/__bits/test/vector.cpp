@@ -26,9 +26,13 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <__bits/test/mock.hpp>
 #include <__bits/test/tests.hpp>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <initializer_list>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -42,6 +46,8 @@ namespace std::test
         test_construction_and_assignment();
         test_insert();
         test_erase();
+        test_element_lifetime();
+        bench_operations();
 
         return end();
     }
@@ -85,7 +91,19 @@ namespace std::test
             check3.begin(), check3.end()
         );
 
-        // TODO: iterator constructor when implemented
+        std::vector<int> vec5(check1.begin(), check1.end());
+        test_eq(
+            "iterator constructor",
+            vec5.begin(), vec5.end(),
+            check1.begin(), check1.end()
+        );
+
+        std::vector<int> vec11(4, 5);
+        test_eq(
+            "replication constructor with ints",
+            vec11.begin(), vec11.end(),
+            check3.begin(), check3.end()
+        );
 
         std::vector<int> vec6{vec4};
         test_eq(
@@ -227,4 +245,185 @@ namespace std::test
             check3.begin(), check3.end()
         );
     }
+
+    namespace
+    {
+        /**
+         * Unlike mock, this one can be moved without
+         * the risk of an exception.
+         */
+        struct nothrow_mock
+        {
+            static std::size_t copies;
+            static std::size_t moves;
+            static std::size_t alive;
+
+            int value;
+
+            nothrow_mock(int val = 0)
+                : value{val}
+            {
+                ++alive;
+            }
+
+            nothrow_mock(const nothrow_mock& other)
+                : value{other.value}
+            {
+                ++copies;
+                ++alive;
+            }
+
+            nothrow_mock(nothrow_mock&& other) noexcept
+                : value{other.value}
+            {
+                ++moves;
+                ++alive;
+            }
+
+            nothrow_mock& operator=(const nothrow_mock&) = default;
+            nothrow_mock& operator=(nothrow_mock&&) = default;
+
+            ~nothrow_mock()
+            {
+                --alive;
+            }
+        };
+
+        std::size_t nothrow_mock::copies{};
+        std::size_t nothrow_mock::moves{};
+        std::size_t nothrow_mock::alive{};
+
+        template<class F>
+        long vector_time(F f)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto stop = std::chrono::steady_clock::now();
+
+            return static_cast<long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    stop - start
+                ).count()
+            );
+        }
+    }
+
+    void vector_test::test_element_lifetime()
+    {
+        mock::clear();
+        {
+            std::vector<mock> vec1{};
+            for (int i = 0; i < 20; ++i)
+                vec1.emplace_back();
+
+            test_eq("emplace_back constructs in place", mock::constructor_calls, 20U);
+            test_eq(
+                "reallocation copies throwing moves",
+                mock::move_constructor_calls, 0U
+            );
+        }
+        test_eq(
+            "every element destroyed",
+            mock::destructor_calls,
+            mock::constructor_calls + mock::copy_constructor_calls +
+            mock::move_constructor_calls
+        );
+
+        {
+            std::vector<nothrow_mock> vec2{};
+            for (int i = 0; i < 20; ++i)
+                vec2.emplace_back(i);
+            vec2.insert(vec2.begin() + 5, nothrow_mock{100});
+            vec2.erase(vec2.begin(), vec2.begin() + 3);
+
+            test_eq("reallocation moves nothrow moves", nothrow_mock::copies, 0U);
+            test("reallocation moves", nothrow_mock::moves > 0);
+            test_eq("insert and erase keep order", vec2[2].value, 100);
+            test_eq("live elements", nothrow_mock::alive, vec2.size());
+        }
+        test_eq("no leaked elements", nothrow_mock::alive, 0U);
+
+        auto check1 = {
+            "zero", "one", "two", "a rather long string number three", "four"
+        };
+        std::vector<std::string> vec3{};
+        for (auto str: check1)
+            vec3.push_back(str);
+        test_eq(
+            "strings push_back",
+            vec3.begin(), vec3.end(),
+            check1.begin(), check1.end()
+        );
+
+        vec3.insert(vec3.begin() + 1, vec3[3]);
+        test_eq("insert own element pt1", vec3[1], vec3[4]);
+        test_eq("insert own element pt2", vec3.size(), 6U);
+
+        vec3.erase(vec3.begin() + 1);
+        test_eq(
+            "strings erase",
+            vec3.begin(), vec3.end(),
+            check1.begin(), check1.end()
+        );
+
+        vec3.resize(7, vec3[0]);
+        test_eq("resize with value", vec3[6], std::string{"zero"});
+        vec3.resize(2);
+        test_eq("resize shrink", vec3.size(), 2U);
+        vec3.resize(4);
+        test_eq("resize grow", vec3[3], std::string{});
+
+        vec3.shrink_to_fit();
+        test_eq("shrink_to_fit", vec3.capacity(), 4U);
+        test_eq("shrink_to_fit keeps elements", vec3[1], std::string{"one"});
+    }
+
+    void vector_test::bench_operations()
+    {
+        /**
+         * Timings only, these do not fail. Elements of
+         * trivially copyable types are relocated with memmove,
+         * strings are moved one by one.
+         */
+        if (!report_)
+            return;
+
+        constexpr std::size_t count{100000};
+        constexpr std::size_t middle_count{2000};
+
+        std::vector<int> ints{};
+        auto int_push = vector_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+                ints.push_back(static_cast<int>(i));
+        });
+        auto int_insert = vector_time([&]{
+            for (std::size_t i = 0; i < middle_count; ++i)
+                ints.insert(ints.begin() + ints.size() / 2, static_cast<int>(i));
+        });
+        auto int_erase = vector_time([&]{
+            for (std::size_t i = 0; i < middle_count; ++i)
+                ints.erase(ints.begin() + ints.size() / 2);
+        });
+
+        std::vector<std::string> strings{};
+        auto string_push = vector_time([&]{
+            for (std::size_t i = 0; i < count; ++i)
+                strings.push_back("a string");
+        });
+        auto string_insert = vector_time([&]{
+            for (std::size_t i = 0; i < middle_count; ++i)
+                strings.insert(strings.begin() + strings.size() / 2, "a string");
+        });
+        auto string_erase = vector_time([&]{
+            for (std::size_t i = 0; i < middle_count; ++i)
+                strings.erase(strings.begin() + strings.size() / 2);
+        });
+
+        std::printf(
+            "[%s][bench] int push_back %ldus insert %ldus erase %ldus, "
+            "string push_back %ldus insert %ldus erase %ldus\n",
+            name(), int_push, int_insert, int_erase,
+            string_push, string_insert, string_erase
+        );
+    }
 }
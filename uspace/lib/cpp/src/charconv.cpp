@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <charconv>
+
+namespace std::hel
+{
+    extern "C" {
+        #include <double_to_str.h>
+        #include <ieee_double.h>
+    }
+}
+
+namespace std
+{
+    namespace
+    {
+        /**
+         * Decimal digits of a non-negative finite number,
+         * whose value is digits * 10^exp.
+         */
+        struct decimal
+        {
+            char digits[MAX_DOUBLE_STR_BUF_SIZE];
+            int len;
+            int exp;
+        };
+
+        to_chars_result put_string(char* first, char* last, const char* str)
+        {
+            auto len = hel::str_size(str);
+            if (static_cast<size_t>(last - first) < len)
+                return {last, errc::value_too_large};
+
+            std::memcpy(first, str, len);
+
+            return {first + len, errc{}};
+        }
+
+        void shortest_double(const hel::ieee_double_t& val, decimal& dec)
+        {
+            dec.len = hel::double_to_short_str(
+                val, dec.digits, sizeof(dec.digits), &dec.exp
+            );
+        }
+
+        double pow10(int exp)
+        {
+            static constexpr double exact[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+                1e20, 1e21, 1e22
+            };
+
+            double res = 1.0;
+            while (exp > 22)
+            {
+                res *= exact[22];
+                exp -= 22;
+            }
+
+            return res * exact[exp];
+        }
+
+        /**
+         * Note: The libc conversion only knows doubles and the shortest
+         *       digits of a float widened to double are usually too
+         *       long (0.1f would become 0.100000001490116...). We round
+         *       those digits to 1, 2, ... significant places and keep
+         *       the first prefix that converts back to the same float;
+         *       nine digits always do.
+         */
+        void shortest_float(float value, const hel::ieee_double_t& val, decimal& dec)
+        {
+            shortest_double(val, dec);
+            if (dec.len <= 1)
+                return;
+
+            char digits[MAX_DOUBLE_STR_BUF_SIZE];
+            for (int p = 1; p < dec.len; ++p)
+            {
+                std::memcpy(digits, dec.digits, p);
+                int exp = dec.exp + dec.len - p;
+                int len = p;
+
+                if (dec.digits[p] >= '5')
+                {
+                    int i = p - 1;
+                    while (i >= 0 && digits[i] == '9')
+                        digits[i--] = '0';
+
+                    if (i >= 0)
+                        ++digits[i];
+                    else
+                    {
+                        digits[0] = '1';
+                        exp += len;
+                        len = 1;
+                    }
+                }
+
+                while (len > 1 && digits[len - 1] == '0')
+                {
+                    --len;
+                    ++exp;
+                }
+
+                if (p < 9)
+                {
+                    uint64_t m{};
+                    for (int i = 0; i < len; ++i)
+                        m = m * 10 + static_cast<uint64_t>(digits[i] - '0');
+
+                    double d = static_cast<double>(m);
+                    if (exp >= 0)
+                        d *= pow10(exp);
+                    else
+                        d /= pow10(-exp);
+
+                    if (static_cast<float>(d) != value)
+                        continue;
+                }
+
+                std::memcpy(dec.digits, digits, len);
+                dec.len = len;
+                dec.exp = exp;
+
+                return;
+            }
+        }
+
+        char* put_exponent(char* it, int exp)
+        {
+            *it++ = 'e';
+            if (exp < 0)
+            {
+                *it++ = '-';
+                exp = -exp;
+            }
+            else
+                *it++ = '+';
+
+            if (exp >= 100)
+            {
+                *it++ = static_cast<char>('0' + exp / 100);
+                exp %= 100;
+            }
+
+            *it++ = aux::charconv_pairs[exp * 2];
+            *it++ = aux::charconv_pairs[exp * 2 + 1];
+
+            return it;
+        }
+
+        to_chars_result put_decimal(char* first, char* last, bool negative,
+                                    const decimal& dec, chars_format fmt)
+        {
+            int len = dec.len;
+            int exp = dec.exp;
+
+            // d.ddde+XX
+            int sci_exp = len + exp - 1;
+            int sci_exp_abs = sci_exp < 0 ? -sci_exp : sci_exp;
+            size_t sci_size = static_cast<size_t>(
+                len + (len > 1 ? 1 : 0) + 2 + (sci_exp_abs >= 100 ? 3 : 2)
+            );
+
+            size_t fixed_size{};
+            if (exp >= 0)
+                fixed_size = static_cast<size_t>(len + exp);
+            else if (len + exp > 0)
+                fixed_size = static_cast<size_t>(len + 1);
+            else
+                fixed_size = static_cast<size_t>(2 - exp);
+
+            bool scientific = (fmt == chars_format::scientific) ||
+                (fmt == chars_format::general && sci_size < fixed_size);
+
+            size_t size = (scientific ? sci_size : fixed_size) + (negative ? 1 : 0);
+            if (static_cast<size_t>(last - first) < size)
+                return {last, errc::value_too_large};
+
+            auto it = first;
+            if (negative)
+                *it++ = '-';
+
+            if (scientific)
+            {
+                *it++ = dec.digits[0];
+                if (len > 1)
+                {
+                    *it++ = '.';
+                    std::memcpy(it, dec.digits + 1, len - 1);
+                    it += len - 1;
+                }
+
+                it = put_exponent(it, sci_exp);
+            }
+            else if (exp >= 0)
+            {
+                std::memcpy(it, dec.digits, len);
+                it += len;
+                std::memset(it, '0', exp);
+                it += exp;
+            }
+            else if (len + exp > 0)
+            {
+                std::memcpy(it, dec.digits, len + exp);
+                it += len + exp;
+                *it++ = '.';
+                std::memcpy(it, dec.digits + len + exp, -exp);
+                it += -exp;
+            }
+            else
+            {
+                *it++ = '0';
+                *it++ = '.';
+                std::memset(it, '0', -(len + exp));
+                it += -(len + exp);
+                std::memcpy(it, dec.digits, len);
+                it += len;
+            }
+
+            return {it, errc{}};
+        }
+
+        template<class T>
+        to_chars_result to_chars_floating(char* first, char* last, T value,
+                                          chars_format fmt)
+        {
+            if (fmt == chars_format::hex)
+                return {last, errc::invalid_argument};
+
+            auto val = hel::extract_ieee_double(static_cast<double>(value));
+            if (val.is_nan)
+                return put_string(first, last, val.is_negative ? "-nan" : "nan");
+            else if (val.is_infinity)
+                return put_string(first, last, val.is_negative ? "-inf" : "inf");
+
+            decimal dec{};
+            if constexpr (is_same_v<T, float>)
+                shortest_float(val.is_negative ? -value : value, val, dec);
+            else
+                shortest_double(val, dec);
+
+            if (dec.len <= 0)
+                return {last, errc::value_too_large};
+
+            return put_decimal(first, last, val.is_negative, dec, fmt);
+        }
+    }
+
+    to_chars_result to_chars(char* first, char* last, double value)
+    {
+        return to_chars_floating(first, last, value, chars_format::general);
+    }
+
+    to_chars_result to_chars(char* first, char* last, double value,
+                             chars_format fmt)
+    {
+        return to_chars_floating(first, last, value, fmt);
+    }
+
+    to_chars_result to_chars(char* first, char* last, float value)
+    {
+        return to_chars_floating(first, last, value, chars_format::general);
+    }
+
+    to_chars_result to_chars(char* first, char* last, float value,
+                             chars_format fmt)
+    {
+        return to_chars_floating(first, last, value, fmt);
+    }
+}
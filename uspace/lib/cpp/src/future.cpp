@@ -26,6 +26,7 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstdlib>
 #include <future>
 #include <string>
 #include <system_error>
@@ -80,4 +81,122 @@ namespace std
     {
         return code_;
     }
+
+    namespace aux
+    {
+        shared_state_base::shared_state_base()
+            : mtx_{}, cv_{}, exec_{}, refs_{1}, ready_{false},
+              deferred_{false}, retrieved_{false}, broken_{false}
+        {
+            threading::mutex::init(mtx_);
+            threading::condvar::init(cv_);
+        }
+
+        void shared_state_base::increment() noexcept
+        {
+            refcount_increment(refs_);
+        }
+
+        void shared_state_base::release() noexcept
+        {
+            if (refcount_decrement(refs_))
+                delete this;
+        }
+
+        void shared_state_base::wait()
+        {
+            if (deferred_)
+            {
+                if (!is_ready())
+                    run_deferred_();
+
+                return;
+            }
+
+            while (!is_ready())
+            {
+                /**
+                 * If we are a worker, blocking here could leave
+                 * the task we wait for in our own queue, so help
+                 * until there is nothing left to run.
+                 */
+                if (exec_ && exec_->run_one())
+                    continue;
+
+                threading::mutex::lock(mtx_);
+                while (!ready_)
+                    threading::condvar::wait(cv_, mtx_);
+                threading::mutex::unlock(mtx_);
+            }
+        }
+
+        future_status shared_state_base::wait_for(time_unit_t timeout)
+        {
+            if (deferred_)
+                return future_status::deferred;
+
+            threading::mutex::lock(mtx_);
+            if (!ready_)
+                threading::condvar::wait_for(cv_, mtx_, timeout);
+            bool ready = ready_;
+            threading::mutex::unlock(mtx_);
+
+            return ready ? future_status::ready : future_status::timeout;
+        }
+
+        bool shared_state_base::is_ready() const noexcept
+        {
+            return __atomic_load_n(&ready_, __ATOMIC_ACQUIRE);
+        }
+
+        bool shared_state_base::retrieve() noexcept
+        {
+            threading::mutex::lock(mtx_);
+            bool res = !retrieved_;
+            retrieved_ = true;
+            threading::mutex::unlock(mtx_);
+
+            return res;
+        }
+
+        void shared_state_base::abandon()
+        {
+            if (begin_set_())
+            {
+                broken_ = true;
+                finish_set_();
+            }
+        }
+
+        void shared_state_base::check_value()
+        {
+            if (broken_)
+            {
+                throw future_error{make_error_code(future_errc::broken_promise)};
+
+                // Without exceptions there is no value to return.
+                abort();
+            }
+        }
+
+        bool shared_state_base::begin_set_()
+        {
+            threading::mutex::lock(mtx_);
+            if (ready_)
+            {
+                threading::mutex::unlock(mtx_);
+
+                return false;
+            }
+
+            return true;
+        }
+
+        void shared_state_base::finish_set_()
+        {
+            __atomic_store_n(&ready_, true, __ATOMIC_RELEASE);
+            threading::condvar::broadcast(cv_);
+            threading::mutex::unlock(mtx_);
+        }
+    }
 }
@@ -31,6 +31,14 @@
 #include <iostream>
 #include <new>
 
+namespace std::hel
+{
+    extern "C" {
+        #include <errno.h>
+        #include <vfs/vfs.h>
+    }
+}
+
 namespace std
 {
     istream cin{nullptr};
@@ -39,6 +47,30 @@ namespace std
     namespace aux
     {
         ios_base::Init init{};
+
+        namespace
+        {
+            stdout_streambuf<char>* cout_buf{};
+        }
+
+        bool write_fd(int fd, uint64_t& pos, const void* data, size_t size)
+        {
+            size_t written{};
+            auto rc = hel::vfs_write(fd, &pos, data, size, &written);
+
+            return rc == EOK && written == size;
+        }
+    }
+
+    bool ios_base::sync_with_stdio(bool sync)
+    {
+        auto old = sync_;
+        sync_ = sync;
+
+        if (old != sync && aux::cout_buf)
+            aux::cout_buf->synchronize(sync);
+
+        return old;
     }
 
     int ios_base::Init::init_cnt_{};
@@ -50,7 +82,11 @@ namespace std
             // TODO: These buffers should be static too
             //       in case somebody reassigns to cout/cin.
             ::new(&cin) istream{::new aux::stdin_streambuf<char>{}};
-            ::new(&cout) ostream{::new aux::stdout_streambuf<char>{}};
+            aux::cout_buf = ::new aux::stdout_streambuf<char>{};
+            ::new(&cout) ostream{aux::cout_buf};
+
+            if (!sync_)
+                aux::cout_buf->synchronize(false);
 
             cin.tie(&cout);
         }
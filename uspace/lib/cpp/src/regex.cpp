@@ -0,0 +1,1413 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/regex/program.hpp>
+#include <algorithm>
+#include <flat_hash_map>
+#include <regex>
+#include <vector>
+
+namespace std
+{
+    namespace
+    {
+        const char* regex_error_message(regex_constants::error_type code)
+        {
+            switch (code)
+            {
+                case regex_constants::error_collate:
+                    return "regex_error: invalid collating element name";
+                case regex_constants::error_ctype:
+                    return "regex_error: invalid character class name";
+                case regex_constants::error_escape:
+                    return "regex_error: invalid escape sequence";
+                case regex_constants::error_backref:
+                    return "regex_error: invalid backreference";
+                case regex_constants::error_brack:
+                    return "regex_error: mismatched [ and ]";
+                case regex_constants::error_paren:
+                    return "regex_error: mismatched ( and )";
+                case regex_constants::error_brace:
+                    return "regex_error: mismatched { and }";
+                case regex_constants::error_badbrace:
+                    return "regex_error: invalid range in {}";
+                case regex_constants::error_range:
+                    return "regex_error: invalid character range";
+                case regex_constants::error_space:
+                    return "regex_error: pattern too large";
+                case regex_constants::error_badrepeat:
+                    return "regex_error: nothing to repeat";
+                case regex_constants::error_complexity:
+                    return "regex_error: match too complex";
+                case regex_constants::error_stack:
+                    return "regex_error: pattern nested too deeply";
+            }
+
+            return "regex_error";
+        }
+    }
+
+    regex_error::regex_error(regex_constants::error_type ecode)
+        : runtime_error{regex_error_message(ecode)}, code_{ecode}
+    { /* DUMMY BODY */ }
+}
+
+namespace std::aux
+{
+    void regex_class::add(uint32_t first, uint32_t last)
+    {
+        for (; first <= last && first < 256; ++first)
+            add(first);
+
+        if (first <= last)
+            ranges.emplace_back(first, last);
+    }
+
+    namespace
+    {
+        constexpr uint32_t unbounded{static_cast<uint32_t>(-1)};
+        constexpr size_t max_insts{size_t{1} << 16};
+        constexpr size_t max_depth{256};
+        constexpr size_t max_dfa_states{1024};
+
+        struct regex_node
+        {
+            enum kind_t: uint8_t
+            {
+                empty, chr, any, cls, concat, alt, repeat,
+                group, bol, eol, wordb, nwordb, backref
+            };
+
+            kind_t kind;
+            uint32_t value;
+            uint32_t min;
+            uint32_t max;
+            bool greedy;
+            vector<size_t> children;
+        };
+
+        /**
+         * Recursive descent parser of the ECMAScript grammar
+         * (28.13) that produces a syntax tree, the tree is then
+         * emitted as a program by regex_emitter. Lookahead
+         * assertions are not supported.
+         */
+        class regex_parser
+        {
+            public:
+                regex_parser(regex_program& prog, const uint32_t* pattern, size_t size)
+                    : prog_{prog}, pattern_{pattern}, size_{size}, pos_{},
+                      depth_{}, groups_{1}, max_backref_{}, failed_{},
+                      nodes_{}
+                {
+                    // Index 0 is a shared empty node returned on errors.
+                    new_node_(regex_node::empty);
+                }
+
+                size_t parse()
+                {
+                    auto root = disjunction_();
+
+                    if (!failed_ && pos_ < size_)
+                        fail_(regex_constants::error_paren);
+                    if (!failed_ && max_backref_ >= groups_)
+                        fail_(regex_constants::error_backref);
+
+                    return root;
+                }
+
+                bool failed() const
+                {
+                    return failed_;
+                }
+
+                size_t groups() const
+                {
+                    return groups_;
+                }
+
+                bool has_backrefs() const
+                {
+                    return max_backref_ > 0;
+                }
+
+                const vector<regex_node>& nodes() const
+                {
+                    return nodes_;
+                }
+
+            private:
+                regex_program& prog_;
+                const uint32_t* pattern_;
+                size_t size_;
+                size_t pos_;
+                size_t depth_;
+                size_t groups_;
+                size_t max_backref_;
+                bool failed_;
+                vector<regex_node> nodes_;
+
+                size_t new_node_(regex_node::kind_t kind, uint32_t value = 0)
+                {
+                    nodes_.push_back(regex_node{kind, value, 0, 0, true, {}});
+
+                    return nodes_.size() - 1;
+                }
+
+                size_t fail_(regex_constants::error_type err)
+                {
+                    if (!failed_)
+                    {
+                        failed_ = true;
+                        prog_.error = err;
+                    }
+                    pos_ = size_;
+
+                    return 0;
+                }
+
+                bool at_end_() const
+                {
+                    return pos_ >= size_;
+                }
+
+                uint32_t peek_() const
+                {
+                    return pattern_[pos_];
+                }
+
+                bool eat_(uint32_t c)
+                {
+                    if (!at_end_() && peek_() == c)
+                    {
+                        ++pos_;
+                        return true;
+                    }
+
+                    return false;
+                }
+
+                size_t disjunction_()
+                {
+                    if (++depth_ > max_depth)
+                        return fail_(regex_constants::error_stack);
+
+                    auto first = alternative_();
+                    if (at_end_() || peek_() != '|')
+                    {
+                        --depth_;
+                        return first;
+                    }
+
+                    auto res = new_node_(regex_node::alt);
+                    nodes_[res].children.push_back(first);
+                    while (eat_('|'))
+                    {
+                        auto next = alternative_();
+                        nodes_[res].children.push_back(next);
+                    }
+                    --depth_;
+
+                    return res;
+                }
+
+                size_t alternative_()
+                {
+                    auto res = new_node_(regex_node::concat);
+                    while (!failed_ && !at_end_() && peek_() != '|' && peek_() != ')')
+                    {
+                        auto term = term_();
+                        nodes_[res].children.push_back(term);
+                    }
+
+                    if (nodes_[res].children.size() == 1)
+                        return nodes_[res].children[0];
+
+                    return res;
+                }
+
+                size_t term_()
+                {
+                    size_t atom{};
+                    bool assertion{false};
+
+                    auto c = peek_();
+                    if (c == '^' || c == '$')
+                    {
+                        ++pos_;
+                        atom = new_node_(c == '^' ? regex_node::bol : regex_node::eol);
+                        assertion = true;
+                    }
+                    else if (c == '\\' && pos_ + 1 < size_ &&
+                             (pattern_[pos_ + 1] == 'b' || pattern_[pos_ + 1] == 'B'))
+                    {
+                        atom = new_node_(pattern_[pos_ + 1] == 'b' ?
+                                         regex_node::wordb : regex_node::nwordb);
+                        pos_ += 2;
+                        assertion = true;
+                    }
+                    else
+                        atom = atom_();
+
+                    if (failed_ || at_end_())
+                        return atom;
+
+                    c = peek_();
+                    if (c != '*' && c != '+' && c != '?' && c != '{')
+                        return atom;
+                    if (assertion)
+                        return fail_(regex_constants::error_badrepeat);
+
+                    uint32_t min{}, max{};
+                    ++pos_;
+                    if (c == '*')
+                    {
+                        min = 0;
+                        max = unbounded;
+                    }
+                    else if (c == '+')
+                    {
+                        min = 1;
+                        max = unbounded;
+                    }
+                    else if (c == '?')
+                    {
+                        min = 0;
+                        max = 1;
+                    }
+                    else if (!braces_(min, max))
+                        return 0;
+
+                    auto res = new_node_(regex_node::repeat);
+                    nodes_[res].min = min;
+                    nodes_[res].max = max;
+                    nodes_[res].greedy = !eat_('?');
+                    nodes_[res].children.push_back(atom);
+
+                    if (!at_end_())
+                    {
+                        c = peek_();
+                        if (c == '*' || c == '+' || c == '?' || c == '{')
+                            return fail_(regex_constants::error_badrepeat);
+                    }
+
+                    return res;
+                }
+
+                bool number_(uint32_t& res)
+                {
+                    if (at_end_() || peek_() < '0' || peek_() > '9')
+                        return false;
+
+                    res = 0;
+                    while (!at_end_() && '0' <= peek_() && peek_() <= '9')
+                    {
+                        // Anything this large is rejected by max_insts anyway.
+                        if (res < 100000)
+                            res = res * 10 + (peek_() - '0');
+                        ++pos_;
+                    }
+
+                    return true;
+                }
+
+                bool braces_(uint32_t& min, uint32_t& max)
+                {
+                    if (!number_(min))
+                    {
+                        fail_(regex_constants::error_badbrace);
+                        return false;
+                    }
+
+                    max = min;
+                    if (eat_(','))
+                    {
+                        if (!number_(max))
+                            max = unbounded;
+                    }
+
+                    if (!eat_('}'))
+                    {
+                        fail_(at_end_() ? regex_constants::error_brace :
+                                          regex_constants::error_badbrace);
+                        return false;
+                    }
+
+                    if (max < min)
+                    {
+                        fail_(regex_constants::error_badbrace);
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                size_t atom_()
+                {
+                    auto c = peek_();
+                    ++pos_;
+
+                    switch (c)
+                    {
+                        case '.':
+                            return new_node_(regex_node::any);
+                        case '(':
+                            return group_();
+                        case ')':
+                            return fail_(regex_constants::error_paren);
+                        case '[':
+                            return bracket_();
+                        case '\\':
+                            return atom_escape_();
+                        case '*':
+                        case '+':
+                        case '?':
+                            return fail_(regex_constants::error_badrepeat);
+                        case '{':
+                            return fail_(regex_constants::error_badrepeat);
+                        default:
+                            return new_node_(regex_node::chr, c);
+                    }
+                }
+
+                size_t group_()
+                {
+                    size_t number{};
+                    if (eat_('?'))
+                    {
+                        if (!eat_(':'))
+                        {
+                            // (?= and (?! are not supported.
+                            return fail_(regex_constants::error_complexity);
+                        }
+                    }
+                    else
+                        number = groups_++;
+
+                    auto inner = disjunction_();
+                    if (failed_)
+                        return 0;
+                    if (!eat_(')'))
+                        return fail_(regex_constants::error_paren);
+
+                    if (number == 0)
+                        return inner;
+
+                    auto res = new_node_(regex_node::group, number);
+                    nodes_[res].children.push_back(inner);
+
+                    return res;
+                }
+
+                size_t new_class_()
+                {
+                    prog_.classes.emplace_back();
+
+                    return prog_.classes.size() - 1;
+                }
+
+                static void add_digits_(regex_class& cls)
+                {
+                    cls.add('0', '9');
+                }
+
+                static void add_spaces_(regex_class& cls)
+                {
+                    cls.add('\t', '\r');
+                    cls.add(' ');
+                    cls.add(0x2028, 0x2029);
+                    cls.add(0xFEFF);
+                }
+
+                static void add_word_(regex_class& cls)
+                {
+                    cls.add('a', 'z');
+                    cls.add('A', 'Z');
+                    cls.add('0', '9');
+                    cls.add('_');
+                }
+
+                /**
+                 * Adds the complement of the class given by adder,
+                 * used for \D, \S and \W.
+                 */
+                template<class Adder>
+                static void add_complement_(regex_class& cls, Adder adder)
+                {
+                    regex_class tmp{};
+                    adder(tmp);
+
+                    for (uint32_t c = 0; c < 256; ++c)
+                    {
+                        if (!tmp.contains(c))
+                            cls.add(c);
+                    }
+
+                    uint32_t from{256};
+                    for (const auto& r: tmp.ranges)
+                    {
+                        if (from < r.first)
+                            cls.ranges.emplace_back(from, r.first - 1);
+                        from = r.second + 1;
+                    }
+                    cls.ranges.emplace_back(from, unbounded);
+                }
+
+                /**
+                 * Handles \d, \D, \s, \S, \w and \W, returns
+                 * false if c is none of them.
+                 */
+                static bool class_escape_(regex_class& cls, uint32_t c)
+                {
+                    switch (c)
+                    {
+                        case 'd':
+                            add_digits_(cls);
+                            return true;
+                        case 'D':
+                            add_complement_(cls, add_digits_);
+                            return true;
+                        case 's':
+                            add_spaces_(cls);
+                            return true;
+                        case 'S':
+                            add_complement_(cls, add_spaces_);
+                            return true;
+                        case 'w':
+                            add_word_(cls);
+                            return true;
+                        case 'W':
+                            add_complement_(cls, add_word_);
+                            return true;
+                        default:
+                            return false;
+                    }
+                }
+
+                bool hex_(size_t digits, uint32_t& res)
+                {
+                    res = 0;
+                    for (size_t i = 0; i < digits; ++i)
+                    {
+                        if (at_end_())
+                            return false;
+
+                        auto c = peek_();
+                        if ('0' <= c && c <= '9')
+                            res = res * 16 + (c - '0');
+                        else if ('a' <= c && c <= 'f')
+                            res = res * 16 + (c - 'a' + 10);
+                        else if ('A' <= c && c <= 'F')
+                            res = res * 16 + (c - 'A' + 10);
+                        else
+                            return false;
+                        ++pos_;
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Character escapes shared by atoms and bracket
+                 * expressions, the backslash is already consumed.
+                 */
+                bool character_escape_(uint32_t& res)
+                {
+                    if (at_end_())
+                        return false;
+
+                    auto c = peek_();
+                    ++pos_;
+                    switch (c)
+                    {
+                        case 't':
+                            res = '\t';
+                            return true;
+                        case 'n':
+                            res = '\n';
+                            return true;
+                        case 'v':
+                            res = '\v';
+                            return true;
+                        case 'f':
+                            res = '\f';
+                            return true;
+                        case 'r':
+                            res = '\r';
+                            return true;
+                        case '0':
+                            res = 0;
+                            return true;
+                        case 'c':
+                            if (at_end_() || !(('a' <= peek_() && peek_() <= 'z') ||
+                                               ('A' <= peek_() && peek_() <= 'Z')))
+                                return false;
+                            res = peek_() % 32;
+                            ++pos_;
+                            return true;
+                        case 'x':
+                            return hex_(2, res);
+                        case 'u':
+                            return hex_(4, res);
+                        default:
+                            // Identity escapes of letters and digits are errors.
+                            if (regex_is_word(c))
+                                return false;
+                            res = c;
+                            return true;
+                    }
+                }
+
+                size_t atom_escape_()
+                {
+                    if (at_end_())
+                        return fail_(regex_constants::error_escape);
+
+                    auto c = peek_();
+                    if ('1' <= c && c <= '9')
+                    {
+                        uint32_t group{};
+                        number_(group);
+                        if (group > max_backref_)
+                            max_backref_ = group;
+
+                        return new_node_(regex_node::backref, group);
+                    }
+
+                    regex_class tmp{};
+                    if (class_escape_(tmp, c))
+                    {
+                        ++pos_;
+                        auto idx = new_class_();
+                        prog_.classes[idx] = move(tmp);
+
+                        return new_node_(regex_node::cls, idx);
+                    }
+
+                    uint32_t res{};
+                    if (!character_escape_(res))
+                        return fail_(regex_constants::error_escape);
+
+                    return new_node_(regex_node::chr, res);
+                }
+
+                bool class_name_(regex_class& cls)
+                {
+                    size_t start = pos_;
+                    while (pos_ + 1 < size_ && !(pattern_[pos_] == ':' && pattern_[pos_ + 1] == ']'))
+                        ++pos_;
+                    if (pos_ + 1 >= size_)
+                    {
+                        fail_(regex_constants::error_brack);
+                        return false;
+                    }
+
+                    char name[8]{};
+                    size_t len = pos_ - start;
+                    pos_ += 2;
+                    if (len >= sizeof(name))
+                    {
+                        fail_(regex_constants::error_ctype);
+                        return false;
+                    }
+                    for (size_t i = 0; i < len; ++i)
+                        name[i] = static_cast<char>(pattern_[start + i]);
+
+                    auto is = [&name](const char* str){
+                        size_t i{};
+                        for (; name[i] && name[i] == str[i]; ++i)
+                        { /* DUMMY BODY */ }
+
+                        return name[i] == str[i];
+                    };
+
+                    if (is("alpha"))
+                    {
+                        cls.add('a', 'z');
+                        cls.add('A', 'Z');
+                    }
+                    else if (is("digit") || is("d"))
+                        add_digits_(cls);
+                    else if (is("alnum"))
+                    {
+                        cls.add('a', 'z');
+                        cls.add('A', 'Z');
+                        add_digits_(cls);
+                    }
+                    else if (is("space") || is("s"))
+                        add_spaces_(cls);
+                    else if (is("w"))
+                        add_word_(cls);
+                    else if (is("upper"))
+                        cls.add('A', 'Z');
+                    else if (is("lower"))
+                        cls.add('a', 'z');
+                    else if (is("xdigit"))
+                    {
+                        add_digits_(cls);
+                        cls.add('a', 'f');
+                        cls.add('A', 'F');
+                    }
+                    else if (is("punct"))
+                    {
+                        cls.add('!', '/');
+                        cls.add(':', '@');
+                        cls.add('[', '`');
+                        cls.add('{', '~');
+                    }
+                    else if (is("blank"))
+                    {
+                        cls.add(' ');
+                        cls.add('\t');
+                    }
+                    else if (is("cntrl"))
+                    {
+                        cls.add(0, 0x1F);
+                        cls.add(0x7F);
+                    }
+                    else if (is("print"))
+                        cls.add(' ', '~');
+                    else if (is("graph"))
+                        cls.add('!', '~');
+                    else
+                    {
+                        fail_(regex_constants::error_ctype);
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Parses one element of a bracket expression, returns
+                 * false on error. If the element is a class (and so
+                 * cannot be a range endpoint), single is false.
+                 */
+                bool class_atom_(regex_class& cls, uint32_t& res, bool& single)
+                {
+                    single = true;
+                    auto c = peek_();
+                    ++pos_;
+
+                    if (c == '[' && !at_end_() && peek_() == ':')
+                    {
+                        ++pos_;
+                        single = false;
+
+                        return class_name_(cls);
+                    }
+                    else if (c == '\\')
+                    {
+                        if (at_end_())
+                        {
+                            fail_(regex_constants::error_escape);
+                            return false;
+                        }
+
+                        if (class_escape_(cls, peek_()))
+                        {
+                            ++pos_;
+                            single = false;
+
+                            return true;
+                        }
+                        else if (peek_() == 'b')
+                        {
+                            ++pos_;
+                            res = '\b';
+
+                            return true;
+                        }
+                        else if (peek_() == '-')
+                        {
+                            ++pos_;
+                            res = '-';
+
+                            return true;
+                        }
+                        else if (!character_escape_(res))
+                        {
+                            fail_(regex_constants::error_escape);
+                            return false;
+                        }
+
+                        return true;
+                    }
+
+                    res = c;
+
+                    return true;
+                }
+
+                size_t bracket_()
+                {
+                    regex_class cls{};
+                    bool negated = eat_('^');
+
+                    while (true)
+                    {
+                        if (at_end_())
+                            return fail_(regex_constants::error_brack);
+                        if (eat_(']'))
+                            break;
+
+                        uint32_t lo{};
+                        bool single{};
+                        if (!class_atom_(cls, lo, single))
+                            return 0;
+
+                        if (at_end_())
+                            return fail_(regex_constants::error_brack);
+
+                        bool range = peek_() == '-' && pos_ + 1 < size_ &&
+                                     pattern_[pos_ + 1] != ']';
+                        if (!range)
+                        {
+                            if (single)
+                                cls.add(lo);
+                            continue;
+                        }
+
+                        ++pos_;
+                        uint32_t hi{};
+                        bool single_hi{};
+                        if (!class_atom_(cls, hi, single_hi))
+                            return 0;
+                        if (!single || !single_hi || hi < lo)
+                            return fail_(regex_constants::error_range);
+
+                        cls.add(lo, hi);
+                    }
+
+                    if (prog_.flags & regex_constants::icase)
+                    {
+                        for (uint32_t c = 'a'; c <= 'z'; ++c)
+                        {
+                            uint32_t u = c - ('a' - 'A');
+                            if (cls.contains(c) || cls.contains(u))
+                            {
+                                cls.add(c);
+                                cls.add(u);
+                            }
+                        }
+                    }
+
+                    if (negated)
+                    {
+                        for (auto& word: cls.bits)
+                            word = ~word;
+                        cls.negated = true;
+                    }
+
+                    auto idx = new_class_();
+                    prog_.classes[idx] = move(cls);
+
+                    return new_node_(regex_node::cls, idx);
+                }
+        };
+
+        /**
+         * Turns the syntax tree into the instruction
+         * sequence described in program.hpp.
+         */
+        class regex_emitter
+        {
+            public:
+                regex_emitter(regex_program& prog, const vector<regex_node>& nodes,
+                              bool captures)
+                    : prog_{prog}, nodes_{nodes}, captures_{captures}, failed_{}
+                { /* DUMMY BODY */ }
+
+                bool emit(size_t root)
+                {
+                    emit_(root);
+                    add_(regex_op::match);
+
+                    if (failed_)
+                        prog_.error = regex_constants::error_space;
+
+                    return !failed_;
+                }
+
+            private:
+                regex_program& prog_;
+                const vector<regex_node>& nodes_;
+                bool captures_;
+                bool failed_;
+
+                size_t add_(regex_op op, uint32_t x = 0, uint32_t y = 0)
+                {
+                    if (prog_.insts.size() >= max_insts)
+                    {
+                        failed_ = true;
+                        return 0;
+                    }
+                    prog_.insts.push_back(regex_inst{op, x, y});
+
+                    return prog_.insts.size() - 1;
+                }
+
+                uint32_t here_() const
+                {
+                    return static_cast<uint32_t>(prog_.insts.size());
+                }
+
+                void emit_chr_(uint32_t c)
+                {
+                    bool icase = prog_.flags & regex_constants::icase;
+                    if (icase && regex_fold(c) != c)
+                        c = regex_fold(c);
+
+                    if (icase && 'a' <= c && c <= 'z')
+                    {
+                        regex_class cls{};
+                        cls.add(c);
+                        cls.add(c - ('a' - 'A'));
+                        prog_.classes.push_back(move(cls));
+                        add_(regex_op::cls, prog_.classes.size() - 1);
+                    }
+                    else
+                        add_(regex_op::chr, c);
+                }
+
+                /**
+                 * Emits split that prefers continuing to the next
+                 * instruction if greedy, the other target is patched
+                 * later through the returned index.
+                 */
+                size_t split_(bool greedy)
+                {
+                    auto pc = add_(regex_op::split);
+                    if (failed_)
+                        return pc;
+
+                    if (greedy)
+                        prog_.insts[pc].x = pc + 1;
+                    else
+                        prog_.insts[pc].y = pc + 1;
+
+                    return pc;
+                }
+
+                void patch_(size_t pc, bool greedy, uint32_t target)
+                {
+                    if (failed_)
+                        return;
+
+                    if (greedy)
+                        prog_.insts[pc].y = target;
+                    else
+                        prog_.insts[pc].x = target;
+                }
+
+                void emit_repeat_(const regex_node& node)
+                {
+                    auto child = node.children[0];
+                    for (uint32_t i = 0; i < node.min && !failed_; ++i)
+                        emit_(child);
+
+                    if (node.max == unbounded)
+                    {
+                        auto loop = split_(node.greedy);
+                        emit_(child);
+                        add_(regex_op::jmp, static_cast<uint32_t>(loop));
+                        patch_(loop, node.greedy, here_());
+
+                        return;
+                    }
+
+                    vector<size_t> splits{};
+                    for (uint32_t i = node.min; i < node.max && !failed_; ++i)
+                    {
+                        splits.push_back(split_(node.greedy));
+                        emit_(child);
+                    }
+
+                    auto end = here_();
+                    for (auto pc: splits)
+                        patch_(pc, node.greedy, end);
+                }
+
+                void emit_alt_(const regex_node& node)
+                {
+                    vector<size_t> jumps{};
+                    auto count = node.children.size();
+                    for (size_t i = 0; i + 1 < count && !failed_; ++i)
+                    {
+                        auto pc = split_(true);
+                        emit_(node.children[i]);
+                        jumps.push_back(add_(regex_op::jmp));
+                        patch_(pc, true, here_());
+                    }
+                    emit_(node.children[count - 1]);
+
+                    auto end = here_();
+                    if (!failed_)
+                    {
+                        for (auto pc: jumps)
+                            prog_.insts[pc].x = end;
+                    }
+                }
+
+                void emit_(size_t idx)
+                {
+                    if (failed_)
+                        return;
+
+                    const auto& node = nodes_[idx];
+                    switch (node.kind)
+                    {
+                        case regex_node::empty:
+                            break;
+                        case regex_node::chr:
+                            emit_chr_(node.value);
+                            break;
+                        case regex_node::any:
+                            add_(regex_op::any);
+                            break;
+                        case regex_node::cls:
+                            add_(regex_op::cls, node.value);
+                            break;
+                        case regex_node::concat:
+                            for (auto child: node.children)
+                                emit_(child);
+                            break;
+                        case regex_node::alt:
+                            emit_alt_(node);
+                            break;
+                        case regex_node::repeat:
+                            emit_repeat_(node);
+                            break;
+                        case regex_node::group:
+                            if (captures_)
+                                add_(regex_op::save, 2 * node.value);
+                            emit_(node.children[0]);
+                            if (captures_)
+                                add_(regex_op::save, 2 * node.value + 1);
+                            break;
+                        case regex_node::bol:
+                            add_(regex_op::bol);
+                            break;
+                        case regex_node::eol:
+                            add_(regex_op::eol);
+                            break;
+                        case regex_node::wordb:
+                            add_(regex_op::word_boundary);
+                            break;
+                        case regex_node::nwordb:
+                            add_(regex_op::not_word_boundary);
+                            break;
+                        case regex_node::backref:
+                            add_(regex_op::backref, node.value);
+                            break;
+                    }
+                }
+        };
+
+        void set_byte(uint64_t* bits, uint32_t c)
+        {
+            bits[c >> 6] |= uint64_t{1} << (c & 63);
+        }
+
+        /**
+         * Epsilon closures over the program, used for the set
+         * of possible first bytes and for the DFA construction.
+         */
+        class regex_closure
+        {
+            public:
+                regex_closure(const regex_program& prog)
+                    : prog_{prog}, mark_(prog.insts.size(), 0),
+                      generation_{}, stack_{}
+                { /* DUMMY BODY */ }
+
+                /**
+                 * Adds the closure of pc to res. Only instructions
+                 * that consume input, match and (unless at_end) eol
+                 * end up in res, assertions are resolved using at_begin
+                 * and at_end, other instructions are followed.
+                 */
+                void add(vector<uint32_t>& res, uint32_t pc, bool at_begin, bool at_end)
+                {
+                    stack_.push_back(pc);
+                    while (!stack_.empty())
+                    {
+                        pc = stack_.back();
+                        stack_.pop_back();
+
+                        if (mark_[pc] == generation_)
+                            continue;
+                        mark_[pc] = generation_;
+
+                        const auto& inst = prog_.insts[pc];
+                        switch (inst.op)
+                        {
+                            case regex_op::split:
+                                stack_.push_back(inst.y);
+                                stack_.push_back(inst.x);
+                                break;
+                            case regex_op::jmp:
+                                stack_.push_back(inst.x);
+                                break;
+                            case regex_op::save:
+                                stack_.push_back(pc + 1);
+                                break;
+                            case regex_op::bol:
+                                if (at_begin)
+                                    stack_.push_back(pc + 1);
+                                break;
+                            case regex_op::eol:
+                                if (at_end)
+                                    stack_.push_back(pc + 1);
+                                else
+                                    res.push_back(pc);
+                                break;
+                            default:
+                                res.push_back(pc);
+                                break;
+                        }
+                    }
+                }
+
+                void reset()
+                {
+                    if (++generation_ == 0)
+                    {
+                        for (auto& m: mark_)
+                            m = 0;
+                        generation_ = 1;
+                    }
+                }
+
+            private:
+                const regex_program& prog_;
+                vector<uint32_t> mark_;
+                uint32_t generation_;
+                vector<uint32_t> stack_;
+        };
+
+        bool consumes(const regex_program& prog, uint32_t pc, uint32_t c)
+        {
+            const auto& inst = prog.insts[pc];
+            switch (inst.op)
+            {
+                case regex_op::chr:
+                    return inst.x == c;
+                case regex_op::any:
+                    return !regex_is_line_terminator(c);
+                case regex_op::cls:
+                    return prog.classes[inst.x].contains(c);
+                default:
+                    return false;
+            }
+        }
+
+        void compute_first_bytes(regex_program& prog)
+        {
+            // Assertions are treated as passable, the set is only a filter.
+            vector<uint32_t> mark(prog.insts.size(), 0);
+            vector<uint32_t> stack{0};
+            bool all{false};
+
+            while (!stack.empty() && !all)
+            {
+                auto pc = stack.back();
+                stack.pop_back();
+                if (mark[pc])
+                    continue;
+                mark[pc] = 1;
+
+                const auto& inst = prog.insts[pc];
+                switch (inst.op)
+                {
+                    case regex_op::match:
+                    case regex_op::backref:
+                        all = true;
+                        break;
+                    case regex_op::split:
+                        stack.push_back(inst.x);
+                        stack.push_back(inst.y);
+                        break;
+                    case regex_op::jmp:
+                        stack.push_back(inst.x);
+                        break;
+                    case regex_op::save:
+                    case regex_op::bol:
+                    case regex_op::eol:
+                    case regex_op::word_boundary:
+                    case regex_op::not_word_boundary:
+                        stack.push_back(pc + 1);
+                        break;
+                    default:
+                        for (uint32_t c = 0; c < 256; ++c)
+                        {
+                            if (consumes(prog, pc, c))
+                                set_byte(prog.first_bytes, c);
+                        }
+                        break;
+                }
+            }
+
+            if (all)
+            {
+                for (auto& word: prog.first_bytes)
+                    word = ~uint64_t{};
+            }
+        }
+
+        struct state_hash
+        {
+            size_t operator()(const vector<uint32_t>& state) const
+            {
+                size_t res{14695981039346656037ULL & ~size_t{}};
+                for (auto pc: state)
+                    res = (res ^ pc) * (1099511628211ULL & ~size_t{});
+
+                return res;
+            }
+        };
+
+        /**
+         * Subset construction of a DFA over byte equivalence
+         * classes. Unanchored DFAs restart the program at every
+         * position, so they accept as soon as a match ends anywhere.
+         * The construction gives up (leaving dfa.built false) if
+         * the automaton would have too many states, matching then
+         * falls back to the backtracker.
+         */
+        class regex_dfa_builder
+        {
+            public:
+                regex_dfa_builder(const regex_program& prog, regex_dfa& dfa,
+                                  bool unanchored)
+                    : prog_{prog}, dfa_{dfa}, unanchored_{unanchored},
+                      closure_{prog}, states_{}, ids_{}, restart_{},
+                      representative_{}
+                { /* DUMMY BODY */ }
+
+                bool build()
+                {
+                    compute_classes_();
+
+                    // The dead state.
+                    add_state_(vector<uint32_t>{});
+
+                    closure_.reset();
+                    closure_.add(restart_, 0, false, false);
+                    sort_(restart_);
+
+                    vector<uint32_t> start{};
+                    closure_.reset();
+                    closure_.add(start, 0, true, false);
+                    sort_(start);
+                    dfa_.start_bol = add_state_(move(start));
+                    dfa_.start_not_bol = add_state_(restart_);
+
+                    for (uint32_t s = 1; s < states_.size(); ++s)
+                    {
+                        if (states_.size() > max_dfa_states)
+                            return false;
+
+                        for (uint32_t k = 0; k < dfa_.classes; ++k)
+                        {
+                            // Note: step_ can grow the table.
+                            auto next = step_(s, k);
+                            dfa_.next[s * dfa_.classes + k] = next;
+                        }
+                    }
+
+                    if (states_.size() > max_dfa_states)
+                        return false;
+
+                    dfa_.built = true;
+
+                    return true;
+                }
+
+            private:
+                const regex_program& prog_;
+                regex_dfa& dfa_;
+                bool unanchored_;
+                regex_closure closure_;
+                vector<vector<uint32_t>> states_;
+                hel::flat_hash_map<vector<uint32_t>, uint32_t, state_hash> ids_;
+                vector<uint32_t> restart_;
+                uint8_t representative_[256];
+
+                static void sort_(vector<uint32_t>& state)
+                {
+                    sort(state.begin(), state.end());
+                }
+
+                void compute_classes_()
+                {
+                    bool boundary[257]{};
+                    for (uint32_t pc = 0; pc < prog_.insts.size(); ++pc)
+                    {
+                        auto op = prog_.insts[pc].op;
+                        if (op != regex_op::chr && op != regex_op::any && op != regex_op::cls)
+                            continue;
+
+                        bool prev = consumes(prog_, pc, 0);
+                        for (uint32_t c = 1; c < 256; ++c)
+                        {
+                            bool curr = consumes(prog_, pc, c);
+                            if (curr != prev)
+                                boundary[c] = true;
+                            prev = curr;
+                        }
+                    }
+
+                    uint32_t cls{};
+                    for (uint32_t c = 0; c < 256; ++c)
+                    {
+                        if (c > 0 && boundary[c])
+                            ++cls;
+                        if (c == 0 || boundary[c])
+                            representative_[cls] = static_cast<uint8_t>(c);
+                        dfa_.byte_class[c] = static_cast<uint8_t>(cls);
+                    }
+                    dfa_.classes = cls + 1;
+                }
+
+                bool accepts_(const vector<uint32_t>& state, bool at_end)
+                {
+                    vector<uint32_t> tmp{};
+                    for (auto pc: state)
+                    {
+                        auto op = prog_.insts[pc].op;
+                        if (op == regex_op::match)
+                            return true;
+                        if (at_end && op == regex_op::eol)
+                        {
+                            closure_.reset();
+                            tmp.clear();
+                            closure_.add(tmp, pc + 1, false, true);
+                            for (auto next: tmp)
+                            {
+                                if (prog_.insts[next].op == regex_op::match)
+                                    return true;
+                            }
+                        }
+                    }
+
+                    return false;
+                }
+
+                uint32_t add_state_(vector<uint32_t> state)
+                {
+                    auto it = ids_.find(state);
+                    if (it != ids_.end())
+                        return it->second;
+
+                    auto id = static_cast<uint32_t>(states_.size());
+                    dfa_.accept.push_back(accepts_(state, false));
+                    dfa_.accept_at_end.push_back(accepts_(state, true));
+                    dfa_.next.resize(dfa_.next.size() + dfa_.classes, 0);
+                    ids_.emplace(state, id);
+                    states_.push_back(move(state));
+
+                    return id;
+                }
+
+                uint32_t step_(uint32_t s, uint32_t k)
+                {
+                    // Search stops at the first accepting state.
+                    if (unanchored_ && dfa_.accept[s])
+                        return s;
+
+                    uint32_t c = representative_[k];
+                    vector<uint32_t> next{};
+
+                    closure_.reset();
+                    for (auto pc: states_[s])
+                    {
+                        if (consumes(prog_, pc, c))
+                            closure_.add(next, pc + 1, false, false);
+                    }
+
+                    if (unanchored_)
+                    {
+                        for (auto pc: restart_)
+                            closure_.add(next, pc, false, false);
+                    }
+                    sort_(next);
+
+                    return add_state_(move(next));
+                }
+        };
+
+        void build_dfa(const regex_program& prog, regex_dfa& dfa, bool unanchored)
+        {
+            regex_dfa_builder builder{prog, dfa, unanchored};
+            if (!builder.build())
+                dfa = regex_dfa{};
+        }
+    }
+
+    void regex_compile(regex_program& prog, const uint32_t* pattern,
+                       size_t size, regex_constants::syntax_option_type flags,
+                       bool narrow)
+    {
+        prog = regex_program{};
+        prog.flags = flags;
+
+        regex_parser parser{prog, pattern, size};
+        auto root = parser.parse();
+        if (parser.failed())
+            return;
+
+        // Without backreferences nosubs lets us drop the captures.
+        bool captures = !(flags & regex_constants::nosubs) || parser.has_backrefs();
+        prog.groups = captures ? parser.groups() : 1;
+        prog.has_backrefs = parser.has_backrefs();
+
+        regex_emitter emitter{prog, parser.nodes(), captures};
+        if (!emitter.emit(root))
+            return;
+
+        compute_first_bytes(prog);
+
+        bool dfa_ok = narrow && !prog.has_backrefs &&
+                      !(flags & regex_constants::multiline);
+        for (const auto& inst: prog.insts)
+        {
+            if (inst.op == regex_op::word_boundary ||
+                inst.op == regex_op::not_word_boundary)
+                dfa_ok = false;
+        }
+
+        if (dfa_ok)
+        {
+            build_dfa(prog, prog.anchored, false);
+            build_dfa(prog, prog.unanchored, true);
+        }
+
+        prog.valid = true;
+    }
+}
@@ -36,9 +36,13 @@
 #include <assert.h>
 #include <adt/list.h>
 #include <stdlib.h>
+#include <mem.h>
 
 #include "drawctx.h"
 
+/** Number of pixels drawn at once by drawctx_transfer(). */
+#define DRAWCTX_SPAN_SIZE  256
+
 void drawctx_init(drawctx_t *context, surface_t *surface)
 {
 	assert(surface);
@@ -133,16 +137,41 @@ void drawctx_transfer(drawctx_t *context,
 	    (context->mask == NULL) &&
 	    (context->compose == compose_src || context->compose == compose_over);
 
+	bool transfer_span = (context->shall_clip == false) &&
+	    (context->mask == NULL);
+
 	if (transfer_fast) {
 
 		for (sysarg_t _y = y; _y < y + height; ++_y) {
 			pixel_t *src = source_direct_access(context->source, x, _y);
 			pixel_t *dst = pixelmap_pixel_at(surface_pixmap_access(context->surface), x, _y);
 			if (src && dst) {
-				sysarg_t count = width;
-				while (count-- != 0) {
-					*dst++ = *src++;
-				}
+				memcpy(dst, src, width * sizeof(pixel_t));
+			}
+		}
+		surface_add_damaged_region(context->surface, x, y, width, height);
+
+	} else if (transfer_span) {
+
+		/* Restrict the transfer to the surface, pixels outside are dropped. */
+		sysarg_t surface_width, surface_height;
+		surface_get_resolution(context->surface, &surface_width, &surface_height);
+		if (x >= surface_width || y >= surface_height)
+			return;
+		width = width < surface_width - x ? width : surface_width - x;
+		height = height < surface_height - y ? height : surface_height - y;
+		if (width == 0 || height == 0)
+			return;
+
+		pixel_t span[DRAWCTX_SPAN_SIZE];
+
+		for (sysarg_t _y = y; _y < y + height; ++_y) {
+			pixel_t *dst = pixelmap_pixel_at(surface_pixmap_access(context->surface), x, _y);
+			for (sysarg_t done = 0; done < width; done += DRAWCTX_SPAN_SIZE) {
+				sysarg_t count = width - done < DRAWCTX_SPAN_SIZE ?
+				    width - done : DRAWCTX_SPAN_SIZE;
+				source_determine_span(context->source, x + done, _y, span, count);
+				compose_span(context->compose, dst + done, span, count);
 			}
 		}
 		surface_add_damaged_region(context->surface, x, y, width, height);
@@ -35,11 +35,14 @@
  */
 
 #include <errno.h>
+#include <macros.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <str.h>
 
 #include "font.h"
 #include "font/embedded.h"
+#include "font/glyph_atlas.h"
 #include "drawctx.h"
 
 font_t *font_create(font_backend_t *backend, void *backend_data)
@@ -56,6 +59,7 @@ font_t *font_create(font_backend_t *backend, void *backend_data)
 
 void font_release(font_t *font)
 {
+	glyph_atlas_purge(font);
 	font->backend->release(font->backend_data);
 }
 
@@ -121,18 +125,72 @@ errno_t font_get_box(font_t *font, char *text, sysarg_t *width, sysarg_t *height
 	return EOK;
 }
 
+/** Test whether text can be drawn from the glyph atlas.
+ *
+ * Only text of a solid colour drawn without clipping is cached, other
+ * text is rendered by the font backend glyph by glyph.
+ */
+static bool font_text_cacheable(drawctx_t *context, source_t *source)
+{
+	return (source->texture == NULL) && (source->mask == NULL) &&
+	    (ALPHA(source->alpha) == 255) && (source->filter == filter_nearest) &&
+	    (context->mask == NULL) && (!context->shall_clip);
+}
+
+/** Compose glyph pixels from the atlas onto the surface.
+ *
+ * @return False if the glyph lies entirely outside of the surface.
+ */
+static bool font_blit_glyph(drawctx_t *context, const pixel_t *pixels,
+    sysarg_t stride, native_t x, native_t y, native_t width, native_t height)
+{
+	sysarg_t surface_width;
+	sysarg_t surface_height;
+	surface_get_resolution(context->surface, &surface_width,
+	    &surface_height);
+
+	native_t x0 = max(x, 0);
+	native_t y0 = max(y, 0);
+	native_t x1 = min(x + width, (native_t) surface_width);
+	native_t y1 = min(y + height, (native_t) surface_height);
+	if ((x0 >= x1) || (y0 >= y1))
+		return false;
+
+	pixelmap_t *pixmap = surface_pixmap_access(context->surface);
+	for (native_t row = y0; row < y1; row++) {
+		const pixel_t *src = pixels + (row - y) * stride + (x0 - x);
+		pixel_t *dst = pixelmap_pixel_at(pixmap, x0, row);
+		compose_span(context->compose, dst, src, x1 - x0);
+	}
+
+	return true;
+}
+
 /* TODO this is bad interface */
 errno_t font_draw_text(font_t *font, drawctx_t *context, source_t *source,
     const char *text, sysarg_t sx, sysarg_t sy)
 {
-	drawctx_save(context);
-	drawctx_set_compose(context, compose_over);
-
 	font_metrics_t fm;
 	errno_t rc = font_get_metrics(font, &fm);
 	if (rc != EOK)
 		return rc;
 
+	drawctx_save(context);
+	drawctx_set_compose(context, compose_over);
+
+	/*
+	 * Text of a solid colour is composed from the glyph atlas, the atlas
+	 * stays locked for the whole run and the damage is reported once.
+	 */
+	bool cached = font_text_cacheable(context, source);
+	if (cached)
+		glyph_atlas_lock();
+
+	native_t damage_x0 = INT32_MAX;
+	native_t damage_y0 = INT32_MAX;
+	native_t damage_x1 = INT32_MIN;
+	native_t damage_y1 = INT32_MIN;
+
 	native_t baseline = sy + fm.ascender;
 	native_t x = sx;
 
@@ -146,29 +204,59 @@ errno_t font_draw_text(font_t *font, drawctx_t *context, source_t *source,
 		rc = font_resolve_glyph(font, c, &glyph_id);
 		if (rc != EOK) {
 			errno_t rc2 = font_resolve_glyph(font, U_SPECIAL, &glyph_id);
-			if (rc2 != EOK) {
-				return rc;
-			}
+			if (rc2 != EOK)
+				break;
 		}
 
 		glyph_metrics_t glyph_metrics;
 		rc = font_get_glyph_metrics(font, glyph_id, &glyph_metrics);
 		if (rc != EOK)
-			return rc;
+			break;
 
-		rc = font_render_glyph(font, context, source, x, baseline,
-		    glyph_id);
-		if (rc != EOK)
-			return rc;
+		const pixel_t *pixels;
+		sysarg_t stride;
+		if (cached && glyph_atlas_get(font, glyph_id, source->color,
+		    &glyph_metrics, &pixels, &stride) == EOK) {
+			native_t gx = x + glyph_metrics.left_side_bearing;
+			native_t gy = baseline - glyph_metrics.ascender;
+			if (font_blit_glyph(context, pixels, stride, gx, gy,
+			    glyph_metrics.width, glyph_metrics.height)) {
+				damage_x0 = min(damage_x0, gx);
+				damage_y0 = min(damage_y0, gy);
+				damage_x1 = max(damage_x1, gx + glyph_metrics.width);
+				damage_y1 = max(damage_y1, gy + glyph_metrics.height);
+			}
+		} else {
+			rc = font_render_glyph(font, context, source, x, baseline,
+			    glyph_id);
+			if (rc != EOK)
+				break;
+		}
 
 		x += glyph_metrics_get_advancement(&glyph_metrics);
+	}
+
+	if (cached)
+		glyph_atlas_unlock();
 
+	if (damage_x0 < damage_x1) {
+		sysarg_t surface_width;
+		sysarg_t surface_height;
+		surface_get_resolution(context->surface, &surface_width,
+		    &surface_height);
+
+		damage_x0 = max(damage_x0, 0);
+		damage_y0 = max(damage_y0, 0);
+		damage_x1 = min(damage_x1, (native_t) surface_width);
+		damage_y1 = min(damage_y1, (native_t) surface_height);
+		surface_add_damaged_region(context->surface, damage_x0, damage_y0,
+		    damage_x1 - damage_x0, damage_y1 - damage_y0);
 	}
 
 	drawctx_restore(context);
 	source_set_mask(source, NULL, false);
 
-	return EOK;
+	return rc;
 }
 
 /** @}
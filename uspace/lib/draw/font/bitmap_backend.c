@@ -134,6 +134,7 @@ static errno_t get_glyph_surface(bitmap_backend_data_t *data, glyph_id_t glyph_i
 	surface_get_resolution(raw_surface, &w, &h);
 
 	if (!data->scale) {
+		data->glyph_cache[glyph_id].surface = raw_surface;
 		*result = raw_surface;
 		return EOK;
 	}
@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup draw
+ * @{
+ */
+/**
+ * @file Cache of coloured glyphs.
+ *
+ * Glyphs drawn by a solid colour are kept in a single atlas surface, so that
+ * text can be drawn by composing rows of ready pixels instead of filtering
+ * the glyph mask pixel by pixel. The atlas is divided into horizontal
+ * shelves, each holding glyphs of similar height side by side. When the
+ * atlas is full, the least recently used shelf is emptied.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <align.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+
+#include "../drawctx.h"
+#include "../source.h"
+#include "../surface.h"
+#include "glyph_atlas.h"
+
+#define GLYPH_ATLAS_WIDTH   512
+#define GLYPH_ATLAS_HEIGHT  512
+
+/** Shelf heights are rounded up to a multiple of this. */
+#define GLYPH_SHELF_ALIGN  4
+
+typedef struct {
+	/** Link in the list of shelves, least recently used first */
+	link_t link;
+	sysarg_t y;
+	sysarg_t height;
+	/** Width already taken by glyphs */
+	sysarg_t used;
+	/** Glyphs on the shelf */
+	list_t glyphs;
+} glyph_shelf_t;
+
+typedef struct {
+	font_t *font;
+	glyph_id_t glyph_id;
+	pixel_t color;
+} glyph_key_t;
+
+typedef struct {
+	ht_link_t link;
+	link_t shelf_link;
+	glyph_shelf_t *shelf;
+	glyph_key_t key;
+	sysarg_t x;
+} glyph_entry_t;
+
+static FIBRIL_MUTEX_INITIALIZE(atlas_lock);
+static surface_t *atlas_surface;
+static hash_table_t atlas_glyphs;
+static LIST_INITIALIZE(atlas_shelves);
+/** Height of the atlas already divided into shelves */
+static sysarg_t atlas_height;
+
+static size_t glyph_key_hash(void *arg)
+{
+	glyph_key_t *key = (glyph_key_t *) arg;
+
+	size_t hash = hash_mix((uintptr_t) key->font);
+	hash = hash_combine(hash, key->glyph_id);
+	return hash_combine(hash, key->color);
+}
+
+static size_t glyph_hash(const ht_link_t *item)
+{
+	glyph_entry_t *entry = hash_table_get_inst(item, glyph_entry_t, link);
+	return glyph_key_hash(&entry->key);
+}
+
+static bool glyph_key_equal(void *arg, const ht_link_t *item)
+{
+	glyph_key_t *key = (glyph_key_t *) arg;
+	glyph_entry_t *entry = hash_table_get_inst(item, glyph_entry_t, link);
+
+	return (key->font == entry->key.font) &&
+	    (key->glyph_id == entry->key.glyph_id) &&
+	    (key->color == entry->key.color);
+}
+
+static bool glyph_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	glyph_entry_t *entry = hash_table_get_inst(item1, glyph_entry_t, link);
+	return glyph_key_equal(&entry->key, item2);
+}
+
+static void glyph_remove(ht_link_t *item)
+{
+	glyph_entry_t *entry = hash_table_get_inst(item, glyph_entry_t, link);
+
+	list_remove(&entry->shelf_link);
+	free(entry);
+}
+
+static hash_table_ops_t atlas_glyphs_ops = {
+	.hash = glyph_hash,
+	.key_hash = glyph_key_hash,
+	.equal = glyph_equal,
+	.key_equal = glyph_key_equal,
+	.remove_callback = glyph_remove
+};
+
+void glyph_atlas_lock(void)
+{
+	fibril_mutex_lock(&atlas_lock);
+}
+
+void glyph_atlas_unlock(void)
+{
+	fibril_mutex_unlock(&atlas_lock);
+}
+
+static errno_t glyph_atlas_init(void)
+{
+	if (atlas_surface != NULL)
+		return EOK;
+
+	if (!hash_table_create(&atlas_glyphs, 0, 0, &atlas_glyphs_ops))
+		return ENOMEM;
+
+	atlas_surface = surface_create(GLYPH_ATLAS_WIDTH, GLYPH_ATLAS_HEIGHT,
+	    NULL, 0);
+	if (atlas_surface == NULL) {
+		hash_table_destroy(&atlas_glyphs);
+		return ENOMEM;
+	}
+
+	return EOK;
+}
+
+static void glyph_shelf_clear(glyph_shelf_t *shelf)
+{
+	while (!list_empty(&shelf->glyphs)) {
+		glyph_entry_t *entry = list_get_instance(list_first(&shelf->glyphs),
+		    glyph_entry_t, shelf_link);
+		hash_table_remove_item(&atlas_glyphs, &entry->link);
+	}
+
+	shelf->used = 0;
+}
+
+/** Find room for a glyph in the atlas.
+ *
+ * A shelf with enough room and not much taller than the glyph is used
+ * if there is one. Otherwise a new shelf is added below the others or,
+ * when the atlas is full, the least recently used shelf tall enough is
+ * emptied.
+ */
+static glyph_shelf_t *glyph_shelf_find(sysarg_t width, sysarg_t height)
+{
+	sysarg_t shelf_height = ALIGN_UP(height, GLYPH_SHELF_ALIGN);
+
+	list_foreach(atlas_shelves, link, glyph_shelf_t, shelf) {
+		if ((shelf->height >= height) &&
+		    (shelf->height <= shelf_height + shelf_height / 2) &&
+		    (GLYPH_ATLAS_WIDTH - shelf->used >= width))
+			return shelf;
+	}
+
+	if (GLYPH_ATLAS_HEIGHT - atlas_height >= shelf_height) {
+		glyph_shelf_t *shelf = malloc(sizeof(glyph_shelf_t));
+		if (shelf == NULL)
+			return NULL;
+
+		link_initialize(&shelf->link);
+		shelf->y = atlas_height;
+		shelf->height = shelf_height;
+		shelf->used = 0;
+		list_initialize(&shelf->glyphs);
+
+		list_append(&shelf->link, &atlas_shelves);
+		atlas_height += shelf_height;
+		return shelf;
+	}
+
+	list_foreach(atlas_shelves, link, glyph_shelf_t, shelf) {
+		if (shelf->height >= height) {
+			glyph_shelf_clear(shelf);
+			return shelf;
+		}
+	}
+
+	return NULL;
+}
+
+/** Get coloured glyph from the atlas.
+ *
+ * If the glyph is not cached yet, it is rendered to the atlas by the font
+ * backend, with a source of the given colour. The atlas must be locked
+ * while the returned pixels are used.
+ *
+ * @param font     Font of the glyph.
+ * @param glyph_id Glyph to get.
+ * @param color    Colour of the glyph.
+ * @param gm       Metrics of the glyph (width and height are used).
+ * @param pixels   Place to store pointer to the top left pixel of the glyph.
+ * @param stride   Place to store distance between rows (in pixels).
+ *
+ * @return EOK on success, ENOMEM if the glyph cannot be cached, an error
+ *         code from the font backend otherwise.
+ */
+errno_t glyph_atlas_get(font_t *font, glyph_id_t glyph_id, pixel_t color,
+    glyph_metrics_t *gm, const pixel_t **pixels, sysarg_t *stride)
+{
+	if ((gm->width <= 0) || (gm->height <= 0) ||
+	    (gm->width > GLYPH_ATLAS_WIDTH) || (gm->height > GLYPH_ATLAS_HEIGHT))
+		return ENOMEM;
+
+	errno_t rc = glyph_atlas_init();
+	if (rc != EOK)
+		return rc;
+
+	glyph_key_t key = {
+		.font = font,
+		.glyph_id = glyph_id,
+		.color = color
+	};
+
+	glyph_entry_t *entry;
+	ht_link_t *item = hash_table_find(&atlas_glyphs, &key);
+	if (item != NULL) {
+		entry = hash_table_get_inst(item, glyph_entry_t, link);
+	} else {
+		entry = malloc(sizeof(glyph_entry_t));
+		if (entry == NULL)
+			return ENOMEM;
+
+		glyph_shelf_t *shelf = glyph_shelf_find(gm->width, gm->height);
+		if (shelf == NULL) {
+			free(entry);
+			return ENOMEM;
+		}
+
+		sysarg_t x = shelf->used;
+
+		source_t source;
+		source_init(&source);
+		source_set_color(&source, color);
+
+		drawctx_t context;
+		drawctx_init(&context, atlas_surface);
+		drawctx_set_source(&context, &source);
+
+		/* The backend draws the glyph relative to its origin. */
+		rc = font_render_glyph(font, &context, &source,
+		    x - gm->left_side_bearing, shelf->y + gm->ascender, glyph_id);
+		if (rc != EOK) {
+			free(entry);
+			return rc;
+		}
+
+		entry->key = key;
+		entry->shelf = shelf;
+		entry->x = x;
+		link_initialize(&entry->shelf_link);
+		list_append(&entry->shelf_link, &shelf->glyphs);
+		hash_table_insert(&atlas_glyphs, &entry->link);
+
+		shelf->used += gm->width;
+	}
+
+	/* Keep the shelves ordered by their last use. */
+	list_remove(&entry->shelf->link);
+	list_append(&entry->shelf->link, &atlas_shelves);
+
+	*pixels = pixelmap_pixel_at(surface_pixmap_access(atlas_surface),
+	    entry->x, entry->shelf->y);
+	*stride = GLYPH_ATLAS_WIDTH;
+	return EOK;
+}
+
+/** Remove all glyphs of a font from the atlas. */
+void glyph_atlas_purge(font_t *font)
+{
+	fibril_mutex_lock(&atlas_lock);
+
+	if (atlas_surface != NULL) {
+		list_foreach(atlas_shelves, link, glyph_shelf_t, shelf) {
+			list_foreach_safe(shelf->glyphs, cur, next) {
+				glyph_entry_t *entry = list_get_instance(cur,
+				    glyph_entry_t, shelf_link);
+				if (entry->key.font == font)
+					hash_table_remove_item(&atlas_glyphs, &entry->link);
+			}
+		}
+	}
+
+	fibril_mutex_unlock(&atlas_lock);
+}
+
+/** @}
+ */
@@ -148,5 +148,40 @@ pixel_t source_determine_pixel(source_t *source, double x, double y)
 	}
 }
 
+/** Determine a row of source pixels.
+ *
+ * Same as calling source_determine_pixel() for (x + i, y), but textures
+ * without a mask are filtered as a whole span.
+ *
+ * @param source Source to determine the pixels of.
+ * @param x      Horizontal position of the first pixel.
+ * @param y      Vertical position of the row.
+ * @param dst    Buffer for the pixels.
+ * @param count  Number of pixels.
+ */
+void source_determine_span(source_t *source, double x, double y,
+    pixel_t *dst, size_t count)
+{
+	if (source->mask || !source->texture || !ALPHA(source->alpha)) {
+		for (size_t i = 0; i < count; i++)
+			dst[i] = source_determine_pixel(source, x + i, y);
+		return;
+	}
+
+	transform_apply_affine(&source->transform, &x, &y);
+	filter_span(source->filter, surface_pixmap_access(source->texture),
+	    x, y, source->transform.matrix[0][0], source->transform.matrix[1][0],
+	    source->texture_extend, dst, count);
+
+	if (ALPHA(source->alpha) < 255) {
+		double ratio = ((double) ALPHA(source->alpha)) / 255.0;
+		for (size_t i = 0; i < count; i++) {
+			double res_a = ratio * ((double) ALPHA(dst[i]));
+			dst[i] = PIXEL((unsigned) res_a,
+			    RED(dst[i]), GREEN(dst[i]), BLUE(dst[i]));
+		}
+	}
+}
+
 /** @}
  */
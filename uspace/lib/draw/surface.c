@@ -54,6 +54,9 @@ struct surface {
 surface_t *surface_create(surface_coord_t width, surface_coord_t height,
     pixel_t *pixbuf, surface_flags_t flags)
 {
+	if (!pixbuf && (flags & SURFACE_FLAG_VIEW) == SURFACE_FLAG_VIEW)
+		return NULL;
+
 	surface_t *surface = (surface_t *) malloc(sizeof(surface_t));
 	if (!surface) {
 		return NULL;
@@ -96,10 +99,12 @@ void surface_destroy(surface_t *surface)
 {
 	pixel_t *pixbuf = surface->pixmap.data;
 
-	if ((surface->flags & SURFACE_FLAG_SHARED) == SURFACE_FLAG_SHARED)
-		as_area_destroy((void *) pixbuf);
-	else
-		free(pixbuf);
+	if ((surface->flags & SURFACE_FLAG_VIEW) != SURFACE_FLAG_VIEW) {
+		if ((surface->flags & SURFACE_FLAG_SHARED) == SURFACE_FLAG_SHARED)
+			as_area_destroy((void *) pixbuf);
+		else
+			free(pixbuf);
+	}
 
 	free(surface);
 }
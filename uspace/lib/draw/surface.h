@@ -47,7 +47,9 @@ typedef sysarg_t surface_coord_t;
 
 typedef enum {
 	SURFACE_FLAG_NONE = 0,
-	SURFACE_FLAG_SHARED = 1
+	SURFACE_FLAG_SHARED = 1,
+	/** Pixel buffer is borrowed from another surface and not freed. */
+	SURFACE_FLAG_VIEW = 2
 } surface_flags_t;
 
 extern surface_t *surface_create(surface_coord_t, surface_coord_t, pixel_t *, surface_flags_t);
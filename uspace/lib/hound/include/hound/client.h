@@ -37,6 +37,7 @@
 #define LIBHOUND_CLIENT_H_
 
 #include <async.h>
+#include <time.h>
 #include <pcm/format.h>
 #include <hound/protocol.h>
 
@@ -46,6 +47,16 @@
 typedef struct hound_context hound_context_t;
 typedef struct hound_stream hound_stream_t;
 
+/** Statistics of a shared stream */
+typedef struct {
+	/** Number of times the server ran out of data */
+	unsigned xruns;
+	/** Frames waiting in the shared ring */
+	size_t queued;
+	/** Time before newly written data get played */
+	usec_t latency;
+} hound_stream_stats_t;
+
 hound_context_t *hound_context_create_playback(const char *name,
     pcm_format_t format, size_t bsize);
 hound_context_t *hound_context_create_capture(const char *name,
@@ -65,11 +76,15 @@ errno_t hound_context_disconnect_target(hound_context_t *hound, const char *targ
 
 hound_stream_t *hound_stream_create(hound_context_t *hound, unsigned flags,
     pcm_format_t format, size_t bsize);
+hound_stream_t *hound_stream_create_shared(hound_context_t *hound,
+    unsigned flags, pcm_format_t format, size_t period, size_t periods);
 void hound_stream_destroy(hound_stream_t *stream);
 
 errno_t hound_stream_write(hound_stream_t *stream, const void *data, size_t size);
 errno_t hound_stream_read(hound_stream_t *stream, void *data, size_t size);
 errno_t hound_stream_drain(hound_stream_t *stream);
+errno_t hound_stream_get_stats(hound_stream_t *stream,
+    hound_stream_stats_t *stats);
 
 errno_t hound_write_main_stream(hound_context_t *hound,
     const void *data, size_t size);
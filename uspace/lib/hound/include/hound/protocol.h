@@ -38,6 +38,7 @@
 
 #include <async.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <pcm/format.h>
 
 extern const char *HOUND_SERVICE;
@@ -56,6 +57,38 @@ typedef enum {
 
 typedef async_sess_t hound_sess_t;
 
+/** Header of a shared stream ring.
+ *
+ * The ring lives in memory shared between the client and the server,
+ * audio data follow the header. The client advances @c write, the server
+ * mixes the data directly to the device buffer and advances @c read. Both
+ * positions are free running frame counters.
+ */
+typedef struct {
+	/** Frames written by the client */
+	atomic_size_t write;
+	/** Frames consumed by the server */
+	atomic_size_t read;
+	/** Number of times the server found the ring empty */
+	atomic_uint xruns;
+	/** Frames mixed by the server that are not played yet (upper bound) */
+	atomic_size_t delay;
+	/** Size of a period in frames */
+	size_t period;
+	/** Number of periods in the ring */
+	size_t periods;
+} hound_ring_t;
+
+/**
+ * Get audio data area of a shared stream ring.
+ * @param ring The ring.
+ * @return Pointer to the first frame of the ring.
+ */
+static inline void *hound_ring_data(hound_ring_t *ring)
+{
+	return (uint8_t *) ring + sizeof(hound_ring_t);
+}
+
 typedef struct {
 } *hound_context_id_t;
 
@@ -90,6 +123,9 @@ errno_t hound_service_disconnect_source_sink(hound_sess_t *sess, const char *sou
 
 errno_t hound_service_stream_enter(async_exch_t *exch, hound_context_id_t id,
     int flags, pcm_format_t format, size_t bsize);
+errno_t hound_service_stream_enter_shared(async_exch_t *exch,
+    hound_context_id_t id, int flags, pcm_format_t format, size_t period,
+    size_t periods, hound_ring_t **ring);
 errno_t hound_service_stream_drain(async_exch_t *exch);
 errno_t hound_service_stream_exit(async_exch_t *exch);
 
@@ -117,6 +153,8 @@ typedef struct hound_server_iface {
 	    void **);
 	/** Destroy existing stream */
 	errno_t (*rem_stream)(void *, void *);
+	/** Feed the stream from a shared ring */
+	errno_t (*share_stream)(void *, hound_ring_t *);
 	/** Block until the stream buffer is empty */
 	errno_t (*drain_stream)(void *);
 	/** Write new data to the stream */
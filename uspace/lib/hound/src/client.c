@@ -34,9 +34,13 @@
  * Common USB functions.
  */
 #include <adt/list.h>
+#include <as.h>
 #include <errno.h>
+#include <fibril.h>
 #include <inttypes.h>
 #include <loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <str.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -58,6 +62,8 @@ struct hound_stream {
 	hound_context_t *context;
 	/** Stream flags */
 	int flags;
+	/** Ring shared with the server, NULL for IPC streams */
+	hound_ring_t *ring;
 };
 
 /**
@@ -304,6 +310,7 @@ hound_stream_t *hound_stream_create(hound_context_t *hound, unsigned flags,
 		new_stream->format = format;
 		new_stream->context = hound;
 		new_stream->flags = flags;
+		new_stream->ring = NULL;
 		const errno_t ret = hound_service_stream_enter(new_stream->exch,
 		    hound->id, flags, format, bsize);
 		if (ret != EOK) {
@@ -316,6 +323,50 @@ hound_stream_t *hound_stream_create(hound_context_t *hound, unsigned flags,
 	return new_stream;
 }
 
+/**
+ * Create a new low latency stream associated with the context.
+ * @param hound Hound context.
+ * @param flags new stream flags.
+ * @param format new stream PCM format.
+ * @param period Size of a period in frames.
+ * @param periods Number of periods in the ring.
+ * @return Valid pointer to a stream instance, NULL on failure.
+ *
+ * Data written to the stream go to a ring shared with the server, which
+ * mixes them directly to the device buffer. Writes block only if the
+ * ring is full. Only playback contexts support shared streams.
+ */
+hound_stream_t *hound_stream_create_shared(hound_context_t *hound,
+    unsigned flags, pcm_format_t format, size_t period, size_t periods)
+{
+	assert(hound);
+	if (hound->record)
+		return NULL;
+	async_exch_t *stream_exch = async_exchange_begin(hound->session);
+	if (!stream_exch)
+		return NULL;
+	hound_stream_t *new_stream = malloc(sizeof(hound_stream_t));
+	if (new_stream) {
+		link_initialize(&new_stream->link);
+		new_stream->exch = stream_exch;
+		new_stream->format = format;
+		new_stream->context = hound;
+		new_stream->flags = flags;
+		const errno_t ret = hound_service_stream_enter_shared(
+		    new_stream->exch, hound->id, flags, format, period,
+		    periods, &new_stream->ring);
+		if (ret != EOK) {
+			async_exchange_end(new_stream->exch);
+			free(new_stream);
+			return NULL;
+		}
+		list_append(&new_stream->link, &hound->stream_list);
+	} else {
+		async_exchange_end(stream_exch);
+	}
+	return new_stream;
+}
+
 /**
  * Destroy existing stream
  * @param stream The stream to destroy.
@@ -330,11 +381,60 @@ void hound_stream_destroy(hound_stream_t *stream)
 			hound_service_stream_drain(stream->exch);
 		hound_service_stream_exit(stream->exch);
 		async_exchange_end(stream->exch);
+		if (stream->ring)
+			as_area_destroy(stream->ring);
 		list_remove(&stream->link);
 		free(stream);
 	}
 }
 
+/**
+ * Copy data to the ring shared with the server.
+ * @param stream The target stream.
+ * @param data data buffer
+ * @param size size of the @p data buffer.
+ * @return error code.
+ *
+ * Waits for the server to make room in the ring if it is full.
+ */
+static errno_t hound_stream_ring_write(hound_stream_t *stream,
+    const void *data, size_t size)
+{
+	hound_ring_t *ring = stream->ring;
+	const size_t frame_size = pcm_format_frame_size(&stream->format);
+	const size_t ring_frames = ring->period * ring->periods;
+	const usec_t period_time = max(1, (usec_t) ring->period * 1000000 /
+	    stream->format.sampling_rate);
+	uint8_t *buffer = hound_ring_data(ring);
+	const uint8_t *src = data;
+
+	if (size % frame_size != 0)
+		return EINVAL;
+
+	size_t frames = size / frame_size;
+	while (frames > 0) {
+		const size_t write =
+		    atomic_load_explicit(&ring->write, memory_order_relaxed);
+		const size_t read =
+		    atomic_load_explicit(&ring->read, memory_order_acquire);
+		const size_t room = ring_frames - (write - read);
+		if (room == 0) {
+			fibril_usleep(period_time / 2);
+			continue;
+		}
+
+		const size_t pos = write % ring_frames;
+		const size_t count = min(min(room, frames), ring_frames - pos);
+		memcpy(buffer + pos * frame_size, src, count * frame_size);
+		atomic_store_explicit(&ring->write, write + count,
+		    memory_order_release);
+
+		src += count * frame_size;
+		frames -= count;
+	}
+	return EOK;
+}
+
 /**
  * Send new data to a stream.
  * @param stream The target stream
@@ -347,9 +447,37 @@ errno_t hound_stream_write(hound_stream_t *stream, const void *data, size_t size
 	assert(stream);
 	if (!data || size == 0)
 		return EBADMEM;
+	if (stream->ring)
+		return hound_stream_ring_write(stream, data, size);
 	return hound_service_stream_write(stream->exch, data, size);
 }
 
+/**
+ * Get playback statistics of a shared stream.
+ * @param stream The stream created by hound_stream_create_shared().
+ * @param[out] stats Current statistics.
+ * @return Error code, ENOTSUP for streams without a shared ring.
+ */
+errno_t hound_stream_get_stats(hound_stream_t *stream,
+    hound_stream_stats_t *stats)
+{
+	assert(stream);
+	assert(stats);
+	hound_ring_t *ring = stream->ring;
+	if (!ring)
+		return ENOTSUP;
+
+	const size_t read = atomic_load(&ring->read);
+	const size_t write = atomic_load(&ring->write);
+	const size_t delay = atomic_load(&ring->delay);
+
+	stats->xruns = atomic_load(&ring->xruns);
+	stats->queued = write - read;
+	stats->latency = (usec_t) (stats->queued + delay) * 1000000 /
+	    stream->format.sampling_rate;
+	return EOK;
+}
+
 /**
  * Get data from a stream.
  * @param stream The target stream.
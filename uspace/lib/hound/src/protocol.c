@@ -34,6 +34,7 @@
  * Common USB functions.
  */
 #include <adt/list.h>
+#include <as.h>
 #include <errno.h>
 #include <loc.h>
 #include <macros.h>
@@ -64,8 +65,13 @@ enum ipc_methods {
 	IPC_M_HOUND_STREAM_EXIT,
 	/** Wait until there is no data in the stream */
 	IPC_M_HOUND_STREAM_DRAIN,
+	/** Switch IPC pipe to stream mode fed from a shared ring */
+	IPC_M_HOUND_STREAM_ENTER_SHARED,
 };
 
+/** Largest shared ring (in frames) the server accepts */
+#define HOUND_RING_MAX_FRAMES  (256 * 1024)
+
 /** PCM format conversion helper structure */
 typedef union {
 	struct {
@@ -318,6 +324,62 @@ errno_t hound_service_stream_enter(async_exch_t *exch, hound_context_id_t id,
 	    flags, c.arg, bsize);
 }
 
+/**
+ * Switch IPC exchange to a STREAM mode fed from a shared ring.
+ * @param exch IPC exchange.
+ * @param id context id this stream should be associated with
+ * @param flags set stream properties
+ * @param format format of the new stream.
+ * @param period Size of a period in frames.
+ * @param periods Number of periods in the ring.
+ * @param[out] ring The ring shared with the server.
+ * @return Error code.
+ *
+ * Only playback streams can be fed from a ring. The ring is released
+ * after the stream exits STREAM mode.
+ */
+errno_t hound_service_stream_enter_shared(async_exch_t *exch,
+    hound_context_id_t id, int flags, pcm_format_t format, size_t period,
+    size_t periods, hound_ring_t **ring)
+{
+	assert(ring);
+	if (period == 0 || periods < 2 ||
+	    period > HOUND_RING_MAX_FRAMES / periods)
+		return EINVAL;
+
+	const format_convert_t c = {
+		.f = {
+			.channels = format.channels,
+			.rate = format.sampling_rate / 100,
+			.format = format.sample_format,
+		}
+	};
+	const size_t size = sizeof(hound_ring_t) +
+	    period * periods * pcm_format_frame_size(&format);
+
+	ipc_call_t call;
+	aid_t mid = async_send_5(exch, IPC_M_HOUND_STREAM_ENTER_SHARED,
+	    CAP_HANDLE_RAW(id), flags, c.arg, period, periods, &call);
+	if (!mid)
+		return EPARTY;
+
+	void *area = NULL;
+	errno_t ret = async_share_in_start_0_0(exch, size, &area);
+	errno_t ret_call;
+	async_wait_for(mid, &ret_call);
+	if (ret == EOK)
+		ret = ret_call;
+
+	if (ret != EOK) {
+		if (area && area != AS_MAP_FAILED)
+			as_area_destroy(area);
+		return ret;
+	}
+
+	*ring = area;
+	return EOK;
+}
+
 /**
  * Destroy existing stream and return IPC exchange to general mode.
  * @param exch IPC exchange.
@@ -368,6 +430,7 @@ errno_t hound_service_stream_read(async_exch_t *exch, void *data, size_t size)
 
 static void hound_server_read_data(void *stream);
 static void hound_server_write_data(void *stream);
+static void hound_server_shared_stream(ipc_call_t *icall);
 static const hound_server_iface_t *server_iface;
 
 /**
@@ -608,6 +671,17 @@ void hound_connection_handler(ipc_call_t *icall, void *arg)
 				}
 			}
 			break;
+		case IPC_M_HOUND_STREAM_ENTER_SHARED:
+			/* check interface functions */
+			if (!server_iface || !server_iface->is_record_context ||
+			    !server_iface->add_stream ||
+			    !server_iface->rem_stream ||
+			    !server_iface->share_stream) {
+				async_answer_0(&call, ENOTSUP);
+				break;
+			}
+			hound_server_shared_stream(&call);
+			break;
 		case IPC_M_HOUND_STREAM_EXIT:
 		case IPC_M_HOUND_STREAM_DRAIN:
 			/* Stream exit/drain is only allowed in stream context*/
@@ -620,6 +694,86 @@ void hound_connection_handler(ipc_call_t *icall, void *arg)
 	}
 }
 
+/**
+ * Create a stream fed from a ring shared with the client.
+ * @param icall IPC_M_HOUND_STREAM_ENTER_SHARED call.
+ *
+ * Shares the ring with the client and keeps the IPC pipe in STREAM mode
+ * until the client exits it. The ring is destroyed together with the
+ * stream.
+ */
+static void hound_server_shared_stream(ipc_call_t *icall)
+{
+	const hound_context_id_t context =
+	    (hound_context_id_t) IPC_GET_ARG1(*icall);
+	const int flags = IPC_GET_ARG2(*icall);
+	const format_convert_t c = { .arg = IPC_GET_ARG3(*icall) };
+	const pcm_format_t f = {
+		.sampling_rate = c.f.rate * 100,
+		.channels = c.f.channels,
+		.sample_format = c.f.format,
+	};
+	const size_t period = IPC_GET_ARG4(*icall);
+	const size_t periods = IPC_GET_ARG5(*icall);
+
+	ipc_call_t share;
+	size_t size = 0;
+	if (!async_share_in_receive(&share, &size)) {
+		async_answer_0(&share, EPARTY);
+		async_answer_0(icall, EPARTY);
+		return;
+	}
+
+	/* Only playback streams can be fed from a ring */
+	if (server_iface->is_record_context(server_iface->server, context) ||
+	    period == 0 || periods < 2 ||
+	    period > HOUND_RING_MAX_FRAMES / periods ||
+	    size != sizeof(hound_ring_t) +
+	    period * periods * pcm_format_frame_size(&f)) {
+		async_answer_0(&share, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	hound_ring_t *ring = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (ring == AS_MAP_FAILED) {
+		async_answer_0(&share, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+	atomic_init(&ring->write, 0);
+	atomic_init(&ring->read, 0);
+	atomic_init(&ring->xruns, 0);
+	atomic_init(&ring->delay, 0);
+	ring->period = period;
+	ring->periods = periods;
+
+	void *stream;
+	errno_t ret = server_iface->add_stream(server_iface->server, context,
+	    flags, f, 0, &stream);
+	if (ret == EOK) {
+		ret = server_iface->share_stream(stream, ring);
+		if (ret != EOK)
+			server_iface->rem_stream(server_iface->server, stream);
+	}
+	if (ret != EOK) {
+		async_answer_0(&share, ret);
+		async_answer_0(icall, ret);
+		as_area_destroy(ring);
+		return;
+	}
+
+	ret = async_share_in_finalize(&share, ring,
+	    AS_AREA_READ | AS_AREA_WRITE);
+	async_answer_0(icall, ret);
+	/* Drain and exit are accepted as for any other playback stream */
+	if (ret == EOK)
+		hound_server_read_data(stream);
+	server_iface->rem_stream(server_iface->server, stream);
+	as_area_destroy(ring);
+}
+
 /**
  * Read data and push it to the stream.
  * @param stream target stream, will push data there.
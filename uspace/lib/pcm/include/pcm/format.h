@@ -100,6 +100,10 @@ void pcm_format_silence(void *dst, size_t size, const pcm_format_t *f);
 errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
     size_t src_size, const pcm_format_t *sf, const pcm_format_t *df);
 errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format_t *f);
+errno_t pcm_format_to_float(float *dst, const void *src, size_t frames,
+    const pcm_format_t *f);
+errno_t pcm_format_mix_float(void *dst, size_t dst_size, const float *src,
+    size_t frames, unsigned channels, const pcm_format_t *df);
 errno_t pcm_format_convert(pcm_format_t a, void *srca, size_t sizea,
     pcm_format_t b, void *srcb, size_t *sizeb);
 
@@ -37,20 +37,20 @@
 #include <byteorder.h>
 #include <errno.h>
 #include <macros.h>
+#include <mem.h>
 #include <stdio.h>
 #include <inttypes.h>
 
-#include "format.h"
-
-// TODO float endian?
-#define float_le2host(x) (x)
-#define float_be2host(x) (x)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
-#define host2float_le(x) (x)
-#define host2float_be(x) (x)
+#include "format.h"
 
-#define from(x, type, endian) (float)(type ## _ ## endian ## 2host(x))
-#define to(x, type, endian) (float)(host2 ## type ## _ ## endian(x))
+/** Number of samples converted at once by the generic code. */
+#define SAMPLE_BLOCK 256
 
 /** Default linear PCM format */
 const pcm_format_t AUDIO_FORMAT_DEFAULT = {
@@ -68,8 +68,8 @@ const pcm_format_t AUDIO_FORMAT_ANY = {
 	.sample_format = 0,
 };
 
-static float get_normalized_sample(const void *buffer, size_t size,
-    unsigned frame, unsigned channel, const pcm_format_t *f);
+/** Mix samples of one format into samples of another format. */
+typedef void (*mix_kernel_t)(void *dst, const void *src, size_t count);
 
 /**
  * Compare PCM format attribtues.
@@ -87,67 +87,491 @@ bool pcm_format_same(const pcm_format_t *a, const pcm_format_t *b)
 	    a->sample_format == b->sample_format;
 }
 
+static inline uint32_t get_u24_le(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | ((uint32_t) p[2] << 16);
+}
+
+static inline uint32_t get_u24_be(const uint8_t *p)
+{
+	return ((uint32_t) p[0] << 16) | (p[1] << 8) | p[2];
+}
+
+static inline void put_u24_le(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+}
+
+static inline void put_u24_be(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 16;
+	p[1] = v >> 8;
+	p[2] = v;
+}
+
+/** Sign-extend a 24-bit sample. */
+static inline int32_t s24(uint32_t v)
+{
+	return (int32_t) (v << 8) >> 8;
+}
+
 /**
- * Fill audio buffer with silence in the specified format.
- * @param dst Destination audio buffer.
- * @param size Size of the destination audio buffer.
- * @param f Pointer to the format description.
+ * Scale normalized sample to an integer range.
+ * @param x Normalized sample.
+ * @param scale 2^(bits - 1).
+ * @param high Largest value of the range (smallest is -scale).
+ * @return Rounded and clipped sample.
  */
-void pcm_format_silence(void *dst, size_t size, const pcm_format_t *f)
+static inline int32_t denormalize(float x, float scale, int32_t high)
+{
+	const float v = x * scale;
+	if (v >= (float) high)
+		return high;
+	if (v <= -scale)
+		return -high - 1;
+	return (int32_t) (v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+/**
+ * Convert samples to float <-1,1>.
+ * @param dst Destination array.
+ * @param src Audio data.
+ * @param count Number of samples.
+ * @param format Sample format of @p src.
+ * @return Error code.
+ */
+static errno_t samples_to_float(float *dst, const void *src, size_t count,
+    pcm_sample_format_t format)
 {
-#define SET_NULL(type, endian, nullv) \
+#define TO_FLOAT(type, conv, scale) \
 do { \
-	type *buffer = dst; \
-	const size_t sample_count = size / sizeof(type); \
-	for (unsigned i = 0; i < sample_count; ++i) { \
-		buffer[i] = to((type)nullv, type, endian); \
-	} \
+	const type *buffer = src; \
+	for (size_t i = 0; i < count; ++i) \
+		dst[i] = (float) (conv) * (1.0f / (scale)); \
 } while (0)
 
-	switch (f->sample_format) {
+	const uint8_t *bytes = src;
+
+	switch (format) {
 	case PCM_SAMPLE_UINT8:
-		SET_NULL(uint8_t, le, INT8_MIN);
+		TO_FLOAT(uint8_t, (int) buffer[i] - 0x80, 0x80);
 		break;
 	case PCM_SAMPLE_SINT8:
-		SET_NULL(int8_t, le, 0);
+		TO_FLOAT(int8_t, buffer[i], 0x80);
 		break;
 	case PCM_SAMPLE_UINT16_LE:
-		SET_NULL(uint16_t, le, INT16_MIN);
+		TO_FLOAT(uint16_t, (int) uint16_t_le2host(buffer[i]) - 0x8000,
+		    0x8000);
 		break;
 	case PCM_SAMPLE_SINT16_LE:
-		SET_NULL(int16_t, le, 0);
+		TO_FLOAT(uint16_t, (int16_t) uint16_t_le2host(buffer[i]), 0x8000);
 		break;
 	case PCM_SAMPLE_UINT16_BE:
-		SET_NULL(uint16_t, be, INT16_MIN);
+		TO_FLOAT(uint16_t, (int) uint16_t_be2host(buffer[i]) - 0x8000,
+		    0x8000);
 		break;
 	case PCM_SAMPLE_SINT16_BE:
-		SET_NULL(int16_t, be, 0);
+		TO_FLOAT(uint16_t, (int16_t) uint16_t_be2host(buffer[i]), 0x8000);
 		break;
-	case PCM_SAMPLE_UINT32_LE:
-		SET_NULL(uint32_t, le, INT32_MIN);
+	case PCM_SAMPLE_UINT24_LE:
+		for (size_t i = 0; i < count; ++i) {
+			dst[i] = (float) ((int32_t) get_u24_le(bytes + 3 * i) -
+			    0x800000) * (1.0f / 0x800000);
+		}
 		break;
-	case PCM_SAMPLE_SINT32_LE:
-		SET_NULL(int32_t, le, 0);
+	case PCM_SAMPLE_SINT24_LE:
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = (float) s24(get_u24_le(bytes + 3 * i)) *
+			    (1.0f / 0x800000);
 		break;
-	case PCM_SAMPLE_UINT32_BE:
-		SET_NULL(uint32_t, be, INT32_MIN);
+	case PCM_SAMPLE_UINT24_BE:
+		for (size_t i = 0; i < count; ++i) {
+			dst[i] = (float) ((int32_t) get_u24_be(bytes + 3 * i) -
+			    0x800000) * (1.0f / 0x800000);
+		}
 		break;
-	case PCM_SAMPLE_SINT32_BE:
-		SET_NULL(int32_t, le, 0);
+	case PCM_SAMPLE_SINT24_BE:
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = (float) s24(get_u24_be(bytes + 3 * i)) *
+			    (1.0f / 0x800000);
 		break;
 	case PCM_SAMPLE_UINT24_32_LE:
+		TO_FLOAT(uint32_t, (int32_t) (uint32_t_le2host(buffer[i]) &
+		    0xffffff) - 0x800000, 0x800000);
+		break;
 	case PCM_SAMPLE_SINT24_32_LE:
+		TO_FLOAT(uint32_t, s24(uint32_t_le2host(buffer[i])), 0x800000);
+		break;
 	case PCM_SAMPLE_UINT24_32_BE:
+		TO_FLOAT(uint32_t, (int32_t) (uint32_t_be2host(buffer[i]) &
+		    0xffffff) - 0x800000, 0x800000);
+		break;
 	case PCM_SAMPLE_SINT24_32_BE:
+		TO_FLOAT(uint32_t, s24(uint32_t_be2host(buffer[i])), 0x800000);
+		break;
+	case PCM_SAMPLE_UINT32_LE:
+		TO_FLOAT(uint32_t, (int32_t) (uint32_t_le2host(buffer[i]) ^
+		    0x80000000), 2147483648.0f);
+		break;
+	case PCM_SAMPLE_SINT32_LE:
+		TO_FLOAT(uint32_t, (int32_t) uint32_t_le2host(buffer[i]),
+		    2147483648.0f);
+		break;
+	case PCM_SAMPLE_UINT32_BE:
+		TO_FLOAT(uint32_t, (int32_t) (uint32_t_be2host(buffer[i]) ^
+		    0x80000000), 2147483648.0f);
+		break;
+	case PCM_SAMPLE_SINT32_BE:
+		TO_FLOAT(uint32_t, (int32_t) uint32_t_be2host(buffer[i]),
+		    2147483648.0f);
+		break;
+	case PCM_SAMPLE_FLOAT32:
+		/* Float samples are stored in host byte order. */
+		memcpy(dst, src, count * sizeof(float));
+		break;
+	default:
+		return ENOTSUP;
+	}
+	return EOK;
+#undef TO_FLOAT
+}
+
+/**
+ * Convert float <-1,1> samples to a sample format.
+ * @param dst Destination audio buffer.
+ * @param src Normalized samples, values outside <-1,1> are clipped.
+ * @param count Number of samples.
+ * @param format Sample format of @p dst.
+ * @return Error code.
+ */
+static errno_t samples_from_float(void *dst, const float *src, size_t count,
+    pcm_sample_format_t format)
+{
+#define FROM_FLOAT(type, conv) \
+do { \
+	type *buffer = dst; \
+	for (size_t i = 0; i < count; ++i) { \
+		const float x = src[i]; \
+		buffer[i] = (conv); \
+	} \
+} while (0)
+
+	uint8_t *bytes = dst;
+
+	switch (format) {
+	case PCM_SAMPLE_UINT8:
+		FROM_FLOAT(uint8_t, denormalize(x, 0x80, INT8_MAX) + 0x80);
+		break;
+	case PCM_SAMPLE_SINT8:
+		FROM_FLOAT(int8_t, denormalize(x, 0x80, INT8_MAX));
+		break;
+	case PCM_SAMPLE_UINT16_LE:
+		FROM_FLOAT(uint16_t, host2uint16_t_le(
+		    denormalize(x, 0x8000, INT16_MAX) + 0x8000));
+		break;
+	case PCM_SAMPLE_SINT16_LE:
+		FROM_FLOAT(uint16_t, host2uint16_t_le(
+		    (uint16_t) denormalize(x, 0x8000, INT16_MAX)));
+		break;
+	case PCM_SAMPLE_UINT16_BE:
+		FROM_FLOAT(uint16_t, host2uint16_t_be(
+		    denormalize(x, 0x8000, INT16_MAX) + 0x8000));
+		break;
+	case PCM_SAMPLE_SINT16_BE:
+		FROM_FLOAT(uint16_t, host2uint16_t_be(
+		    (uint16_t) denormalize(x, 0x8000, INT16_MAX)));
+		break;
 	case PCM_SAMPLE_UINT24_LE:
+		for (size_t i = 0; i < count; ++i)
+			put_u24_le(bytes + 3 * i,
+			    denormalize(src[i], 0x800000, 0x7fffff) + 0x800000);
+		break;
 	case PCM_SAMPLE_SINT24_LE:
+		for (size_t i = 0; i < count; ++i)
+			put_u24_le(bytes + 3 * i,
+			    denormalize(src[i], 0x800000, 0x7fffff));
+		break;
 	case PCM_SAMPLE_UINT24_BE:
+		for (size_t i = 0; i < count; ++i)
+			put_u24_be(bytes + 3 * i,
+			    denormalize(src[i], 0x800000, 0x7fffff) + 0x800000);
+		break;
 	case PCM_SAMPLE_SINT24_BE:
+		for (size_t i = 0; i < count; ++i)
+			put_u24_be(bytes + 3 * i,
+			    denormalize(src[i], 0x800000, 0x7fffff));
+		break;
+	case PCM_SAMPLE_UINT24_32_LE:
+		FROM_FLOAT(uint32_t, host2uint32_t_le(
+		    denormalize(x, 0x800000, 0x7fffff) + 0x800000));
+		break;
+	case PCM_SAMPLE_SINT24_32_LE:
+		FROM_FLOAT(uint32_t, host2uint32_t_le(
+		    (uint32_t) denormalize(x, 0x800000, 0x7fffff)));
+		break;
+	case PCM_SAMPLE_UINT24_32_BE:
+		FROM_FLOAT(uint32_t, host2uint32_t_be(
+		    denormalize(x, 0x800000, 0x7fffff) + 0x800000));
+		break;
+	case PCM_SAMPLE_SINT24_32_BE:
+		FROM_FLOAT(uint32_t, host2uint32_t_be(
+		    (uint32_t) denormalize(x, 0x800000, 0x7fffff)));
+		break;
+	case PCM_SAMPLE_UINT32_LE:
+		FROM_FLOAT(uint32_t, host2uint32_t_le(
+		    (uint32_t) denormalize(x, 2147483648.0f, INT32_MAX) ^
+		    0x80000000));
+		break;
+	case PCM_SAMPLE_SINT32_LE:
+		FROM_FLOAT(uint32_t, host2uint32_t_le(
+		    (uint32_t) denormalize(x, 2147483648.0f, INT32_MAX)));
+		break;
+	case PCM_SAMPLE_UINT32_BE:
+		FROM_FLOAT(uint32_t, host2uint32_t_be(
+		    (uint32_t) denormalize(x, 2147483648.0f, INT32_MAX) ^
+		    0x80000000));
+		break;
+	case PCM_SAMPLE_SINT32_BE:
+		FROM_FLOAT(uint32_t, host2uint32_t_be(
+		    (uint32_t) denormalize(x, 2147483648.0f, INT32_MAX)));
+		break;
 	case PCM_SAMPLE_FLOAT32:
-	default:
+		FROM_FLOAT(float, x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x));
 		break;
+	default:
+		return ENOTSUP;
+	}
+	return EOK;
+#undef FROM_FLOAT
+}
+
+/**
+ * Fill audio buffer with silence in the specified format.
+ * @param dst Destination audio buffer.
+ * @param size Size of the destination audio buffer.
+ * @param f Pointer to the format description.
+ */
+void pcm_format_silence(void *dst, size_t size, const pcm_format_t *f)
+{
+	const size_t sample_size = pcm_sample_format_size(f->sample_format);
+	if (sample_size == 0)
+		return;
+
+	if (pcm_sample_format_is_signed(f->sample_format) ||
+	    f->sample_format == PCM_SAMPLE_FLOAT32) {
+		memset(dst, 0, size);
+		return;
+	}
+
+	/* Unsigned silence is the middle of the range. */
+	const float zero = 0.0f;
+	uint8_t sample[4];
+	samples_from_float(sample, &zero, 1, f->sample_format);
+
+	uint8_t *buffer = dst;
+	for (size_t i = 0; i + sample_size <= size; i += sample_size)
+		memcpy(buffer + i, sample, sample_size);
+}
+
+/** Mix signed 16-bit samples in host byte order with saturation. */
+static void mix_s16_s16(void *dst, const void *src, size_t count)
+{
+	int16_t *d = dst;
+	const int16_t *s = src;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	for (; i + 8 <= count; i += 8) {
+		const __m128i a = _mm_loadu_si128((const __m128i *) (d + i));
+		const __m128i b = _mm_loadu_si128((const __m128i *) (s + i));
+		_mm_storeu_si128((__m128i *) (d + i), _mm_adds_epi16(a, b));
+	}
+#elif defined(__ARM_NEON)
+	for (; i + 8 <= count; i += 8)
+		vst1q_s16(d + i, vqaddq_s16(vld1q_s16(d + i), vld1q_s16(s + i)));
+#endif
+	for (; i < count; ++i) {
+		const int32_t c = d[i] + s[i];
+		d[i] = min(max(c, INT16_MIN), INT16_MAX);
+	}
+}
+
+/** Mix float samples, clipping the result to <-1,1>. */
+static void mix_f32_f32(void *dst, const void *src, size_t count)
+{
+	float *d = dst;
+	const float *s = src;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 low = _mm_set1_ps(-1.0f);
+	const __m128 high = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		const __m128 c = _mm_add_ps(_mm_loadu_ps(d + i),
+		    _mm_loadu_ps(s + i));
+		_mm_storeu_ps(d + i, _mm_min_ps(_mm_max_ps(c, low), high));
+	}
+#elif defined(__ARM_NEON)
+	const float32x4_t low = vdupq_n_f32(-1.0f);
+	const float32x4_t high = vdupq_n_f32(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		const float32x4_t c = vaddq_f32(vld1q_f32(d + i),
+		    vld1q_f32(s + i));
+		vst1q_f32(d + i, vminq_f32(vmaxq_f32(c, low), high));
+	}
+#endif
+	for (; i < count; ++i) {
+		const float c = d[i] + s[i];
+		d[i] = c < -1.0f ? -1.0f : (c > 1.0f ? 1.0f : c);
 	}
-#undef SET_NULL
+}
+
+/** Mix signed 16-bit samples in host byte order into float samples. */
+static void mix_s16_f32(void *dst, const void *src, size_t count)
+{
+	float *d = dst;
+	const int16_t *s = src;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(1.0f / 0x8000);
+	const __m128 low = _mm_set1_ps(-1.0f);
+	const __m128 high = _mm_set1_ps(1.0f);
+	for (; i + 8 <= count; i += 8) {
+		const __m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+		/* Sign-extend to 32 bits by shifting the high halves down. */
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		__m128 a = _mm_add_ps(_mm_loadu_ps(d + i),
+		    _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		__m128 b = _mm_add_ps(_mm_loadu_ps(d + i + 4),
+		    _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+		_mm_storeu_ps(d + i, _mm_min_ps(_mm_max_ps(a, low), high));
+		_mm_storeu_ps(d + i + 4, _mm_min_ps(_mm_max_ps(b, low), high));
+	}
+#elif defined(__ARM_NEON)
+	const float32x4_t low = vdupq_n_f32(-1.0f);
+	const float32x4_t high = vdupq_n_f32(1.0f);
+	for (; i + 8 <= count; i += 8) {
+		const int16x8_t v = vld1q_s16(s + i);
+		float32x4_t a = vmlaq_n_f32(vld1q_f32(d + i),
+		    vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), 1.0f / 0x8000);
+		float32x4_t b = vmlaq_n_f32(vld1q_f32(d + i + 4),
+		    vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), 1.0f / 0x8000);
+		vst1q_f32(d + i, vminq_f32(vmaxq_f32(a, low), high));
+		vst1q_f32(d + i + 4, vminq_f32(vmaxq_f32(b, low), high));
+	}
+#endif
+	for (; i < count; ++i) {
+		const float c = d[i] + s[i] * (1.0f / 0x8000);
+		d[i] = c < -1.0f ? -1.0f : (c > 1.0f ? 1.0f : c);
+	}
+}
+
+/** Mix float samples into signed 16-bit samples in host byte order. */
+static void mix_f32_s16(void *dst, const void *src, size_t count)
+{
+	int16_t *d = dst;
+	const float *s = src;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(0x8000);
+	const __m128 low = _mm_set1_ps(INT16_MIN);
+	const __m128 high = _mm_set1_ps(INT16_MAX);
+	for (; i + 8 <= count; i += 8) {
+		/*
+		 * Clamp before the conversion, which turns out of range
+		 * values into INT32_MIN instead of saturating them.
+		 */
+		const __m128 fa = _mm_mul_ps(_mm_loadu_ps(s + i), scale);
+		const __m128 fb = _mm_mul_ps(_mm_loadu_ps(s + i + 4), scale);
+		const __m128i a = _mm_cvtps_epi32(
+		    _mm_min_ps(_mm_max_ps(fa, low), high));
+		const __m128i b = _mm_cvtps_epi32(
+		    _mm_min_ps(_mm_max_ps(fb, low), high));
+		const __m128i v = _mm_packs_epi32(a, b);
+		const __m128i o = _mm_loadu_si128((const __m128i *) (d + i));
+		_mm_storeu_si128((__m128i *) (d + i), _mm_adds_epi16(o, v));
+	}
+#elif defined(__ARM_NEON)
+	const float32x4_t scale = vdupq_n_f32(0x8000);
+	for (; i + 8 <= count; i += 8) {
+		const int32x4_t a = vcvtq_s32_f32(vmulq_f32(vld1q_f32(s + i),
+		    scale));
+		const int32x4_t b = vcvtq_s32_f32(vmulq_f32(
+		    vld1q_f32(s + i + 4), scale));
+		const int16x8_t v = vcombine_s16(vqmovn_s32(a), vqmovn_s32(b));
+		vst1q_s16(d + i, vqaddq_s16(vld1q_s16(d + i), v));
+	}
+#endif
+	for (; i < count; ++i) {
+		const int32_t c = d[i] + denormalize(s[i], 0x8000, INT16_MAX);
+		d[i] = min(max(c, INT16_MIN), INT16_MAX);
+	}
+}
+
+/**
+ * Find specialized kernel for mixing samples of the same channel layout.
+ * @param sf Sample format of the source data.
+ * @param df Sample format of the destination data.
+ * @return Mixing function, NULL if the generic code should be used.
+ */
+static mix_kernel_t mix_kernel(pcm_sample_format_t sf, pcm_sample_format_t df)
+{
+#ifdef __LE__
+	const pcm_sample_format_t s16 = PCM_SAMPLE_SINT16_LE;
+#else
+	const pcm_sample_format_t s16 = PCM_SAMPLE_SINT16_BE;
+#endif
+	const pcm_sample_format_t f32 = PCM_SAMPLE_FLOAT32;
+
+	if (sf == s16 && df == s16)
+		return mix_s16_s16;
+	if (sf == f32 && df == f32)
+		return mix_f32_f32;
+	if (sf == s16 && df == f32)
+		return mix_s16_f32;
+	if (sf == f32 && df == s16)
+		return mix_f32_s16;
+	return NULL;
+}
+
+/**
+ * Mix normalized samples into audio data.
+ * @param dst Destination audio buffer.
+ * @param src Normalized samples.
+ * @param count Number of samples.
+ * @param format Sample format of @p dst.
+ * @return Error code.
+ */
+static errno_t samples_mix_float(void *dst, const float *src, size_t count,
+    pcm_sample_format_t format)
+{
+	if (format == PCM_SAMPLE_FLOAT32) {
+		mix_f32_f32(dst, src, count);
+		return EOK;
+	}
+
+	const size_t sample_size = pcm_sample_format_size(format);
+	float mix[SAMPLE_BLOCK];
+
+	while (count > 0) {
+		const size_t n = min(count, (size_t) SAMPLE_BLOCK);
+		const errno_t ret = samples_to_float(mix, dst, n, format);
+		if (ret != EOK)
+			return ret;
+		for (size_t i = 0; i < n; ++i)
+			mix[i] += src[i];
+		samples_from_float(dst, mix, n, format);
+
+		dst += n * sample_size;
+		src += n;
+		count -= n;
+	}
+	return EOK;
 }
 
 /**
@@ -163,6 +587,79 @@ errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format
 	return pcm_format_convert_and_mix(dst, size, src, size, f, f);
 }
 
+/**
+ * Convert audio data to normalized float samples.
+ * @param dst Destination array of @p frames times channels samples.
+ * @param src Source audio data.
+ * @param frames Number of frames to convert.
+ * @param f Pointer to the source format descriptor.
+ * @return Error code.
+ *
+ * Samples of a frame stay interleaved.
+ */
+errno_t pcm_format_to_float(float *dst, const void *src, size_t frames,
+    const pcm_format_t *f)
+{
+	if (!dst || !src || !f)
+		return EINVAL;
+	return samples_to_float(dst, src, frames * f->channels,
+	    f->sample_format);
+}
+
+/**
+ * Add and mix normalized float samples.
+ * @param dst Destination audio buffer.
+ * @param dst_size Size of the destination buffer.
+ * @param src Interleaved normalized samples.
+ * @param frames Number of frames in @p src.
+ * @param channels Number of channels in @p src.
+ * @param df Pointer to the destination format descriptor.
+ * @return Error code.
+ *
+ * Channels missing in the source are left intact, extra channels
+ * are ignored.
+ */
+errno_t pcm_format_mix_float(void *dst, size_t dst_size, const float *src,
+    size_t frames, unsigned channels, const pcm_format_t *df)
+{
+	if (!dst || !src || !df)
+		return EINVAL;
+	const size_t dst_frame_size = pcm_format_frame_size(df);
+	if (dst_frame_size == 0 || (dst_size % dst_frame_size) != 0)
+		return EINVAL;
+
+	frames = min(frames, dst_size / dst_frame_size);
+	if (channels == df->channels)
+		return samples_mix_float(dst, src, frames * channels,
+		    df->sample_format);
+
+	/* Remap channels one block at a time. */
+	const unsigned common = min(channels, df->channels);
+	const size_t block = SAMPLE_BLOCK / df->channels;
+	float mix[SAMPLE_BLOCK];
+	if (block == 0)
+		return ENOTSUP;
+
+	while (frames > 0) {
+		const size_t n = min(frames, block);
+		for (size_t i = 0; i < n; ++i) {
+			for (unsigned j = 0; j < df->channels; ++j) {
+				mix[i * df->channels + j] = (j < common) ?
+				    src[i * channels + j] : 0.0f;
+			}
+		}
+		const errno_t ret = samples_mix_float(dst, mix,
+		    n * df->channels, df->sample_format);
+		if (ret != EOK)
+			return ret;
+
+		dst += n * dst_frame_size;
+		src += n * channels;
+		frames -= n;
+	}
+	return EOK;
+}
+
 /**
  * Add and mix audio data.
  * @param dst Destination audio buffer
@@ -182,155 +679,51 @@ errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
 	if (!dst || !src || !sf || !df)
 		return EINVAL;
 	const size_t src_frame_size = pcm_format_frame_size(sf);
-	if ((src_size % src_frame_size) != 0)
+	if (src_frame_size == 0 || (src_size % src_frame_size) != 0)
 		return EINVAL;
 
 	const size_t dst_frame_size = pcm_format_frame_size(df);
-	if ((dst_size % dst_frame_size) != 0)
+	if (dst_frame_size == 0 || (dst_size % dst_frame_size) != 0)
 		return EINVAL;
 
-	/*
-	 * This is so ugly it eats kittens, and puppies, and ducklings,
-	 * and all little fluffy things...
-	 */
-#define LOOP_ADD(type, endian, low, high) \
-do { \
-	const unsigned frame_count = dst_size / dst_frame_size; \
-	for (size_t i = 0; i < frame_count; ++i) { \
-		for (unsigned j = 0; j < df->channels; ++j) { \
-			const float a = \
-			    get_normalized_sample(dst, dst_size, i, j, df);\
-			const float b = \
-			    get_normalized_sample(src, src_size, i, j, sf);\
-			float c = (a + b); \
-			if (c < -1.0) c = -1.0; \
-			if (c > 1.0) c = 1.0; \
-			c += 1.0; \
-			c *= ((float)(type)high - (float)(type)low) / 2; \
-			c += (float)(type)low; \
-			type *dst_buf = dst; \
-			const unsigned pos = i * df->channels  + j; \
-			if (pos < (dst_size / sizeof(type))) \
-				dst_buf[pos] = to((type)c, type, endian); \
-		} \
-	} \
-} while (0)
+	/* Missing source frames are silent, nothing to add there. */
+	const size_t frames = min(dst_size / dst_frame_size,
+	    src_size / src_frame_size);
 
-	switch (df->sample_format) {
-	case PCM_SAMPLE_UINT8:
-		LOOP_ADD(uint8_t, le, UINT8_MIN, UINT8_MAX);
-		break;
-	case PCM_SAMPLE_SINT8:
-		LOOP_ADD(uint8_t, le, INT8_MIN, INT8_MAX);
-		break;
-	case PCM_SAMPLE_UINT16_LE:
-		LOOP_ADD(uint16_t, le, UINT16_MIN, UINT16_MAX);
-		break;
-	case PCM_SAMPLE_SINT16_LE:
-		LOOP_ADD(int16_t, le, INT16_MIN, INT16_MAX);
-		break;
-	case PCM_SAMPLE_UINT16_BE:
-		LOOP_ADD(uint16_t, be, UINT16_MIN, UINT16_MAX);
-		break;
-	case PCM_SAMPLE_SINT16_BE:
-		LOOP_ADD(int16_t, be, INT16_MIN, INT16_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_32_LE:
-	case PCM_SAMPLE_UINT32_LE: // TODO this are not right for 24bit
-		LOOP_ADD(uint32_t, le, UINT32_MIN, UINT32_MAX);
-		break;
-	case PCM_SAMPLE_SINT24_32_LE:
-	case PCM_SAMPLE_SINT32_LE:
-		LOOP_ADD(int32_t, le, INT32_MIN, INT32_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_32_BE:
-	case PCM_SAMPLE_UINT32_BE:
-		LOOP_ADD(uint32_t, be, UINT32_MIN, UINT32_MAX);
-		break;
-	case PCM_SAMPLE_SINT24_32_BE:
-	case PCM_SAMPLE_SINT32_BE:
-		LOOP_ADD(int32_t, be, INT32_MIN, INT32_MAX);
-		break;
-	case PCM_SAMPLE_UINT24_LE:
-	case PCM_SAMPLE_SINT24_LE:
-	case PCM_SAMPLE_UINT24_BE:
-	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
-	default:
-		return ENOTSUP;
+	if (sf->channels == df->channels) {
+		const mix_kernel_t kernel =
+		    mix_kernel(sf->sample_format, df->sample_format);
+		if (kernel) {
+			kernel(dst, src, frames * df->channels);
+			return EOK;
+		}
 	}
-	return EOK;
-#undef LOOP_ADD
-}
 
-/**
- * Converts all sample formats to float <-1,1>
- * @param buffer Audio data
- * @param size Size of the buffer
- * @param frame Index of the frame to read
- * @param channel Channel within the frame
- * @param f Pointer to a format descriptor
- * @return Normalized sample <-1,1>, 0.0 if the data could not be read
- */
-static float get_normalized_sample(const void *buffer, size_t size,
-    unsigned frame, unsigned channel, const pcm_format_t *f)
-{
-	assert(f);
-	assert(buffer);
-	if (channel >= f->channels)
-		return 0.0f;
-#define GET(type, endian, low, high) \
-do { \
-	const type *src = buffer; \
-	const size_t sample_count = size / sizeof(type); \
-	const size_t sample_pos = frame * f->channels + channel; \
-	if (sample_pos >= sample_count) {\
-		return 0.0f; \
-	} \
-	float sample = from(src[sample_pos], type, endian); \
-	/* This makes it positive */ \
-	sample -= (float)(type)low; \
-	/* This makes it <0,2> */ \
-	sample /= (((float)(type)high - (float)(type)low) / 2.0f); \
-	return sample - 1.0f; \
-} while (0)
+	/* Generic path, convert a block of frames at a time. */
+	const size_t block = SAMPLE_BLOCK / sf->channels;
+	float samples[SAMPLE_BLOCK];
+	if (block == 0)
+		return ENOTSUP;
 
-	switch (f->sample_format) {
-	case PCM_SAMPLE_UINT8:
-		GET(uint8_t, le, UINT8_MIN, UINT8_MAX);
-	case PCM_SAMPLE_SINT8:
-		GET(int8_t, le, INT8_MIN, INT8_MAX);
-	case PCM_SAMPLE_UINT16_LE:
-		GET(uint16_t, le, UINT16_MIN, UINT16_MAX);
-	case PCM_SAMPLE_SINT16_LE:
-		GET(int16_t, le, INT16_MIN, INT16_MAX);
-	case PCM_SAMPLE_UINT16_BE:
-		GET(uint16_t, be, UINT16_MIN, UINT16_MAX);
-	case PCM_SAMPLE_SINT16_BE:
-		GET(int16_t, be, INT16_MIN, INT16_MAX);
-	case PCM_SAMPLE_UINT24_32_LE:
-	case PCM_SAMPLE_UINT32_LE:
-		GET(uint32_t, le, UINT32_MIN, UINT32_MAX);
-	case PCM_SAMPLE_SINT24_32_LE:
-	case PCM_SAMPLE_SINT32_LE:
-		GET(int32_t, le, INT32_MIN, INT32_MAX);
-	case PCM_SAMPLE_UINT24_32_BE:
-	case PCM_SAMPLE_UINT32_BE:
-		GET(uint32_t, be, UINT32_MIN, UINT32_MAX);
-	case PCM_SAMPLE_SINT24_32_BE:
-	case PCM_SAMPLE_SINT32_BE:
-		GET(int32_t, le, INT32_MIN, INT32_MAX);
-	case PCM_SAMPLE_UINT24_LE:
-	case PCM_SAMPLE_SINT24_LE:
-	case PCM_SAMPLE_UINT24_BE:
-	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
-	default:
-		break;
+	size_t done = 0;
+	while (done < frames) {
+		const size_t n = min(frames - done, block);
+		errno_t ret = samples_to_float(samples, src, n * sf->channels,
+		    sf->sample_format);
+		if (ret == EOK) {
+			ret = pcm_format_mix_float(dst, n * dst_frame_size,
+			    samples, n, sf->channels, df);
+		}
+		if (ret != EOK)
+			return ret;
+
+		dst += n * dst_frame_size;
+		src += n * src_frame_size;
+		done += n;
 	}
-	return 0;
-#undef GET
+	return EOK;
 }
+
 /**
  * @}
  */
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup audio
+ * @brief PCM sample rate conversion
+ * @{
+ */
+/** @file
+ * Polyphase sample rate converter.
+ *
+ * Conversion by the ratio L/M (reduced dst_rate/src_rate) is done by
+ * upsampling by L, low-pass filtering and decimating by M. Only the
+ * filter taps that hit non-zero samples are ever evaluated, which splits
+ * the filter into L phases of TAPS coefficients each.
+ */
+
+#include <adt/gcdlcm.h>
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "resampler.h"
+
+/** Number of filter coefficients per phase (multiple of 4). */
+#define TAPS 16
+
+/** Largest supported number of phases. */
+#define MAX_PHASES 1024
+
+/** Cutoff frequency relative to the lower of the two Nyquist frequencies. */
+#define CUTOFF 0.95
+
+struct pcm_resampler {
+	/** Number of interleaved channels */
+	unsigned channels;
+	/** Upsampling factor (L) */
+	unsigned phases;
+	/** Downsampling factor (M) */
+	unsigned step;
+	/** Phase of the next output frame */
+	unsigned phase;
+	/** Input frames to take before the next output frame */
+	unsigned pending;
+	/** Filter coefficients, TAPS per phase, oldest sample first */
+	float *coeffs;
+	/** Last TAPS input samples of every channel, stored twice */
+	float *history;
+	/** Position of the oldest sample in history */
+	unsigned pos;
+};
+
+/** Blackman-windowed sinc low-pass filter.
+ * @param x Distance from the filter center in input samples.
+ * @param fc Cutoff frequency relative to the input Nyquist frequency.
+ * @param width Half-width of the window in input samples.
+ * @return Filter coefficient.
+ */
+static double lowpass(double x, double fc, double width)
+{
+	const double w = x / width;
+	const double window = 0.42 + 0.5 * cos(M_PI * w) +
+	    0.08 * cos(2.0 * M_PI * w);
+	if (x == 0.0)
+		return fc * window;
+	return sin(M_PI * fc * x) / (M_PI * x) * window;
+}
+
+/**
+ * Create a sample rate converter.
+ * @param src_rate Sampling rate of the input.
+ * @param dst_rate Sampling rate of the output.
+ * @param channels Number of interleaved channels.
+ * @param resampler Place to store the new converter.
+ * @return Error code.
+ */
+errno_t pcm_resampler_create(unsigned src_rate, unsigned dst_rate,
+    unsigned channels, pcm_resampler_t **resampler)
+{
+	if (!resampler || src_rate == 0 || dst_rate == 0 || channels == 0)
+		return EINVAL;
+
+	const unsigned g = gcd32(src_rate, dst_rate);
+	const unsigned phases = dst_rate / g;
+	const unsigned step = src_rate / g;
+	if (phases > MAX_PHASES)
+		return ENOTSUP;
+
+	pcm_resampler_t *r = malloc(sizeof(pcm_resampler_t));
+	if (!r)
+		return ENOMEM;
+	r->coeffs = malloc(sizeof(float) * TAPS * phases);
+	r->history = calloc(2 * TAPS * channels, sizeof(float));
+	if (!r->coeffs || !r->history) {
+		free(r->coeffs);
+		free(r->history);
+		free(r);
+		return ENOMEM;
+	}
+
+	r->channels = channels;
+	r->phases = phases;
+	r->step = step;
+	r->phase = 0;
+	r->pending = 1;
+	r->pos = 0;
+
+	/* Downsampling needs to cut off above the output Nyquist frequency. */
+	const double fc = CUTOFF * (step > phases ? (double) phases / step : 1.0);
+
+	for (unsigned p = 0; p < phases; ++p) {
+		float *c = r->coeffs + p * TAPS;
+		double sum = 0.0;
+		for (unsigned k = 0; k < TAPS; ++k) {
+			/*
+			 * Tap k of phase p weighs the input sample k samples
+			 * older than the newest one, p/L samples past it.
+			 */
+			const double x = k + (double) p / phases - TAPS / 2;
+			const double v = lowpass(x, fc, TAPS / 2 + 1);
+			c[TAPS - 1 - k] = v;
+			sum += v;
+		}
+		/* Unity gain in every phase. */
+		for (unsigned k = 0; k < TAPS; ++k)
+			c[k] /= sum;
+	}
+
+	*resampler = r;
+	return EOK;
+}
+
+/**
+ * Destroy a sample rate converter.
+ * @param resampler The converter.
+ */
+void pcm_resampler_destroy(pcm_resampler_t *resampler)
+{
+	if (resampler) {
+		free(resampler->coeffs);
+		free(resampler->history);
+		free(resampler);
+	}
+}
+
+/** Compute one output sample. */
+static inline float dot(const float *c, const float *x)
+{
+#if defined(__SSE2__)
+	__m128 acc = _mm_mul_ps(_mm_loadu_ps(c), _mm_loadu_ps(x));
+	for (unsigned k = 4; k < TAPS; k += 4) {
+		acc = _mm_add_ps(acc,
+		    _mm_mul_ps(_mm_loadu_ps(c + k), _mm_loadu_ps(x + k)));
+	}
+	acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+	acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+	return _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON)
+	float32x4_t acc = vmulq_f32(vld1q_f32(c), vld1q_f32(x));
+	for (unsigned k = 4; k < TAPS; k += 4)
+		acc = vmlaq_f32(acc, vld1q_f32(c + k), vld1q_f32(x + k));
+	const float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+	return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+	float acc = 0.0f;
+	for (unsigned k = 0; k < TAPS; ++k)
+		acc += c[k] * x[k];
+	return acc;
+#endif
+}
+
+/**
+ * Convert sampling rate of a block of audio.
+ * @param resampler The converter.
+ * @param src Interleaved input samples.
+ * @param src_frames Number of input frames.
+ * @param src_used Place to store the number of input frames consumed.
+ * @param dst Place for interleaved output samples.
+ * @param dst_frames Maximum number of output frames.
+ * @return Number of output frames produced.
+ *
+ * Stops when either the input is used up or the output is full, input
+ * that was consumed is remembered for the following calls.
+ */
+size_t pcm_resampler_process(pcm_resampler_t *resampler, const float *src,
+    size_t src_frames, size_t *src_used, float *dst, size_t dst_frames)
+{
+	assert(resampler);
+	assert(src_used);
+	pcm_resampler_t *r = resampler;
+	const unsigned channels = r->channels;
+	size_t used = 0;
+	size_t produced = 0;
+
+	while (produced < dst_frames) {
+		while (r->pending > 0 && used < src_frames) {
+			/* Keep the window contiguous by storing every sample twice. */
+			for (unsigned j = 0; j < channels; ++j) {
+				float *h = r->history + j * 2 * TAPS;
+				h[r->pos] = h[r->pos + TAPS] = src[used * channels + j];
+			}
+			r->pos = (r->pos + 1) % TAPS;
+			--r->pending;
+			++used;
+		}
+		if (r->pending > 0)
+			break;
+
+		const float *c = r->coeffs + r->phase * TAPS;
+		for (unsigned j = 0; j < channels; ++j) {
+			dst[produced * channels + j] =
+			    dot(c, r->history + j * 2 * TAPS + r->pos);
+		}
+		++produced;
+
+		r->phase += r->step;
+		r->pending = r->phase / r->phases;
+		r->phase %= r->phases;
+	}
+
+	*src_used = used;
+	return produced;
+}
+
+/**
+ * @}
+ */
@@ -35,8 +35,6 @@
 
 #include <libc/dlfcn.h>
 
-#define RTLD_LAZY 1
-#define RTLD_NOW 2
 #define RTLD_GLOBAL 32
 #define RTLD_LOCAL 0
 
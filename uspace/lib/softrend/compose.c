@@ -33,8 +33,18 @@
  * @file
  */
 
+#include <mem.h>
 #include "compose.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** Divide product of two channels by 255, exact for values up to 255 * 255. */
+#define DIV255(val)  (((val) + 1 + ((val) >> 8)) >> 8)
+
 pixel_t compose_clr(pixel_t fg, pixel_t bg)
 {
 	return 0;
@@ -94,8 +104,244 @@ pixel_t compose_xor(pixel_t fg, pixel_t bg)
 
 pixel_t compose_add(pixel_t fg, pixel_t bg)
 {
-	// TODO
-	return 0;
+	unsigned res_a = ALPHA(fg) + ALPHA(bg);
+	unsigned res_r = DIV255(RED(fg) * ALPHA(fg)) + DIV255(RED(bg) * ALPHA(bg));
+	unsigned res_g = DIV255(GREEN(fg) * ALPHA(fg)) + DIV255(GREEN(bg) * ALPHA(bg));
+	unsigned res_b = DIV255(BLUE(fg) * ALPHA(fg)) + DIV255(BLUE(bg) * ALPHA(bg));
+
+	return PIXEL(res_a < 255 ? res_a : 255, res_r < 255 ? res_r : 255,
+	    res_g < 255 ? res_g : 255, res_b < 255 ? res_b : 255);
+}
+
+/*
+ * Span kernels
+ *
+ * Pixels are stored with straight (not premultiplied) alpha, so the kernels
+ * premultiply the foreground in registers. The results are exactly those of
+ * the per-pixel operators above.
+ */
+
+/** Compose pixel over opaque background (same as compose_over()). */
+static inline pixel_t compose_over_opaque(pixel_t fg, pixel_t bg)
+{
+	unsigned alpha = ALPHA(fg);
+	unsigned alpha_inv = 255 - alpha;
+
+	return PIXEL(255,
+	    DIV255(RED(fg) * alpha) + DIV255(RED(bg) * alpha_inv),
+	    DIV255(GREEN(fg) * alpha) + DIV255(GREEN(bg) * alpha_inv),
+	    DIV255(BLUE(fg) * alpha) + DIV255(BLUE(bg) * alpha_inv));
+}
+
+static inline void compose_over_span_scalar(pixel_t *dst, const pixel_t *src,
+    size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		pixel_t fg = src[i];
+
+		if (ALPHA(fg) == 255)
+			dst[i] = fg;
+		else if (ALPHA(dst[i]) == 255)
+			dst[i] = ALPHA(fg) ? compose_over_opaque(fg, dst[i]) : dst[i];
+		else
+			dst[i] = compose_over(fg, dst[i]);
+	}
+}
+
+static inline void compose_add_span_scalar(pixel_t *dst, const pixel_t *src,
+    size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = compose_add(src[i], dst[i]);
+}
+
+#if defined(__AVX2__)
+
+/** Number of pixels processed by one vector operation. */
+#define SPAN_VECTOR  8
+
+typedef __m256i vpixels_t;
+
+#define VLOAD(ptr)  _mm256_loadu_si256((const __m256i *) (ptr))
+#define VSTORE(ptr, val)  _mm256_storeu_si256((__m256i *) (ptr), (val))
+#define VSET1(val)  _mm256_set1_epi32(val)
+#define VZERO()  _mm256_setzero_si256()
+#define VAND(a, b)  _mm256_and_si256((a), (b))
+#define VOR(a, b)  _mm256_or_si256((a), (b))
+#define VXOR(a, b)  _mm256_xor_si256((a), (b))
+#define VADD16(a, b)  _mm256_add_epi16((a), (b))
+#define VMUL16(a, b)  _mm256_mullo_epi16((a), (b))
+#define VSRL16(a, n)  _mm256_srli_epi16((a), (n))
+#define VADDS8(a, b)  _mm256_adds_epu8((a), (b))
+#define VCMPEQ32(a, b)  _mm256_cmpeq_epi32((a), (b))
+#define VUNPACKLO8(a, b)  _mm256_unpacklo_epi8((a), (b))
+#define VUNPACKHI8(a, b)  _mm256_unpackhi_epi8((a), (b))
+#define VPACKUS16(a, b)  _mm256_packus_epi16((a), (b))
+#define VMASK(a)  ((unsigned) _mm256_movemask_epi8(a))
+#define VMASK_ALL  0xffffffffU
+#define VALPHA16(a) \
+	_mm256_shufflehi_epi16(_mm256_shufflelo_epi16((a), 0xff), 0xff)
+
+#elif defined(__SSE2__)
+
+/** Number of pixels processed by one vector operation. */
+#define SPAN_VECTOR  4
+
+typedef __m128i vpixels_t;
+
+#define VLOAD(ptr)  _mm_loadu_si128((const __m128i *) (ptr))
+#define VSTORE(ptr, val)  _mm_storeu_si128((__m128i *) (ptr), (val))
+#define VSET1(val)  _mm_set1_epi32(val)
+#define VZERO()  _mm_setzero_si128()
+#define VAND(a, b)  _mm_and_si128((a), (b))
+#define VOR(a, b)  _mm_or_si128((a), (b))
+#define VXOR(a, b)  _mm_xor_si128((a), (b))
+#define VADD16(a, b)  _mm_add_epi16((a), (b))
+#define VMUL16(a, b)  _mm_mullo_epi16((a), (b))
+#define VSRL16(a, n)  _mm_srli_epi16((a), (n))
+#define VADDS8(a, b)  _mm_adds_epu8((a), (b))
+#define VCMPEQ32(a, b)  _mm_cmpeq_epi32((a), (b))
+#define VUNPACKLO8(a, b)  _mm_unpacklo_epi8((a), (b))
+#define VUNPACKHI8(a, b)  _mm_unpackhi_epi8((a), (b))
+#define VPACKUS16(a, b)  _mm_packus_epi16((a), (b))
+#define VMASK(a)  ((unsigned) _mm_movemask_epi8(a))
+#define VMASK_ALL  0xffffU
+#define VALPHA16(a)  _mm_shufflehi_epi16(_mm_shufflelo_epi16((a), 0xff), 0xff)
+
+#endif
+
+#if defined(SPAN_VECTOR)
+
+/** Exact division of 16-bit lanes by 255 (see DIV255). */
+static inline vpixels_t vdiv255(vpixels_t val)
+{
+	vpixels_t one = VSRL16(VCMPEQ32(VZERO(), VZERO()), 15);
+	return VSRL16(VADD16(VADD16(val, one), VSRL16(val, 8)), 8);
+}
+
+/** Multiply channels by alpha of their pixel (16-bit lanes). */
+static inline vpixels_t vpremultiply(vpixels_t pix, vpixels_t alpha)
+{
+	return vdiv255(VMUL16(pix, alpha));
+}
+
+static void compose_over_span_vector(pixel_t *dst, const pixel_t *src,
+    size_t count)
+{
+	const vpixels_t alpha_mask = VSET1(0xff000000);
+	const vpixels_t inv_mask = VSET1(0x00ff00ff);
+	const vpixels_t zero = VZERO();
+	size_t i;
+
+	for (i = 0; i + SPAN_VECTOR <= count; i += SPAN_VECTOR) {
+		vpixels_t fg = VLOAD(src + i);
+		vpixels_t fg_alpha = VAND(fg, alpha_mask);
+
+		unsigned opaque = VMASK(VCMPEQ32(fg_alpha, alpha_mask));
+		if (opaque == VMASK_ALL) {
+			VSTORE(dst + i, fg);
+			continue;
+		}
+
+		vpixels_t bg = VLOAD(dst + i);
+		if (VMASK(VCMPEQ32(VAND(bg, alpha_mask), alpha_mask)) != VMASK_ALL) {
+			/* Translucent background is rare, leave it to the scalar code. */
+			compose_over_span_scalar(dst + i, src + i, SPAN_VECTOR);
+			continue;
+		}
+
+		if (VMASK(VCMPEQ32(fg_alpha, zero)) == VMASK_ALL)
+			continue;
+
+		vpixels_t fg_lo = VUNPACKLO8(fg, zero);
+		vpixels_t fg_hi = VUNPACKHI8(fg, zero);
+		vpixels_t bg_lo = VUNPACKLO8(bg, zero);
+		vpixels_t bg_hi = VUNPACKHI8(bg, zero);
+
+		vpixels_t alpha_lo = VALPHA16(fg_lo);
+		vpixels_t alpha_hi = VALPHA16(fg_hi);
+
+		/* 255 - alpha, alpha being at most 255 */
+		vpixels_t alpha_inv_lo = VXOR(alpha_lo, inv_mask);
+		vpixels_t alpha_inv_hi = VXOR(alpha_hi, inv_mask);
+
+		vpixels_t res_lo = VADD16(vpremultiply(fg_lo, alpha_lo),
+		    vpremultiply(bg_lo, alpha_inv_lo));
+		vpixels_t res_hi = VADD16(vpremultiply(fg_hi, alpha_hi),
+		    vpremultiply(bg_hi, alpha_inv_hi));
+
+		VSTORE(dst + i, VOR(VPACKUS16(res_lo, res_hi), alpha_mask));
+	}
+
+	compose_over_span_scalar(dst + i, src + i, count - i);
+}
+
+static void compose_add_span_vector(pixel_t *dst, const pixel_t *src,
+    size_t count)
+{
+	const vpixels_t alpha_mask = VSET1(0xff000000);
+	const vpixels_t zero = VZERO();
+	size_t i;
+
+	for (i = 0; i + SPAN_VECTOR <= count; i += SPAN_VECTOR) {
+		vpixels_t fg = VLOAD(src + i);
+		vpixels_t bg = VLOAD(dst + i);
+
+		vpixels_t fg_lo = VUNPACKLO8(fg, zero);
+		vpixels_t fg_hi = VUNPACKHI8(fg, zero);
+		vpixels_t bg_lo = VUNPACKLO8(bg, zero);
+		vpixels_t bg_hi = VUNPACKHI8(bg, zero);
+
+		vpixels_t fg_pre = VPACKUS16(vpremultiply(fg_lo, VALPHA16(fg_lo)),
+		    vpremultiply(fg_hi, VALPHA16(fg_hi)));
+		vpixels_t bg_pre = VPACKUS16(vpremultiply(bg_lo, VALPHA16(bg_lo)),
+		    vpremultiply(bg_hi, VALPHA16(bg_hi)));
+
+		/* Alpha is added as it is, not premultiplied by itself. */
+		fg_pre = VOR(VAND(fg_pre, VSET1(0x00ffffff)), VAND(fg, alpha_mask));
+		bg_pre = VOR(VAND(bg_pre, VSET1(0x00ffffff)), VAND(bg, alpha_mask));
+
+		VSTORE(dst + i, VADDS8(fg_pre, bg_pre));
+	}
+
+	compose_add_span_scalar(dst + i, src + i, count - i);
+}
+
+#endif
+
+/** Compose a span of pixels.
+ *
+ * Equivalent to dst[i] = compose(src[i], dst[i]) for each pixel, but
+ * the common operators are handled by kernels working on whole spans.
+ *
+ * @param compose Compose operator.
+ * @param dst     Background pixels, overwritten by the result.
+ * @param src     Foreground pixels.
+ * @param count   Number of pixels.
+ */
+void compose_span(compose_t compose, pixel_t *dst, const pixel_t *src,
+    size_t count)
+{
+	if (compose == compose_src) {
+		memcpy(dst, src, count * sizeof(pixel_t));
+	} else if (compose == compose_dst) {
+		return;
+	} else if (compose == compose_over) {
+#if defined(SPAN_VECTOR)
+		compose_over_span_vector(dst, src, count);
+#else
+		compose_over_span_scalar(dst, src, count);
+#endif
+	} else if (compose == compose_add) {
+#if defined(SPAN_VECTOR)
+		compose_add_span_vector(dst, src, count);
+#else
+		compose_add_span_scalar(dst, src, count);
+#endif
+	} else {
+		for (size_t i = 0; i < count; i++)
+			dst[i] = compose(src[i], dst[i]);
+	}
 }
 
 /** @}
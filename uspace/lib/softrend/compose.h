@@ -36,6 +36,7 @@
 #ifndef SOFTREND_COMPOSE_H_
 #define SOFTREND_COMPOSE_H_
 
+#include <stddef.h>
 #include <io/pixel.h>
 
 typedef pixel_t (*compose_t)(pixel_t, pixel_t);
@@ -51,6 +52,8 @@ extern pixel_t compose_atop(pixel_t, pixel_t);
 extern pixel_t compose_xor(pixel_t, pixel_t);
 extern pixel_t compose_add(pixel_t, pixel_t);
 
+extern void compose_span(compose_t, pixel_t *, const pixel_t *, size_t);
+
 #endif
 
 /** @}
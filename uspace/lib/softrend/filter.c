@@ -58,19 +58,22 @@ static long _ceil(double val)
 	return lval;
 }
 
-static inline pixel_t blend_pixels(size_t count, float *weights,
-    pixel_t *pixels)
+/** Interpolate between two pixels, weight of the second one is w / 256.
+ *
+ * Two channels are interpolated at once in each 32-bit word, there is
+ * enough room between them for the products.
+ */
+static inline pixel_t lerp_pixels(pixel_t p1, pixel_t p2, unsigned w)
 {
-	float alpha = 0, red = 0, green = 0, blue = 0;
-	for (size_t index = 0; index < count; index++) {
-		alpha += weights[index] * ALPHA(pixels[index]);
-		red   += weights[index] *   RED(pixels[index]);
-		green += weights[index] * GREEN(pixels[index]);
-		blue  += weights[index] *  BLUE(pixels[index]);
-	}
+	uint32_t rb1 = p1 & 0x00ff00ff;
+	uint32_t ag1 = (p1 >> 8) & 0x00ff00ff;
+	uint32_t rb2 = p2 & 0x00ff00ff;
+	uint32_t ag2 = (p2 >> 8) & 0x00ff00ff;
 
-	return PIXEL((uint8_t) alpha, (uint8_t) red, (uint8_t) green,
-	    (uint8_t) blue);
+	uint32_t rb = ((rb1 * (256 - w) + rb2 * w) >> 8) & 0x00ff00ff;
+	uint32_t ag = (ag1 * (256 - w) + ag2 * w) & 0xff00ff00;
+
+	return rb | ag;
 }
 
 pixel_t filter_nearest(pixelmap_t *pixmap, double x, double y,
@@ -92,22 +95,17 @@ pixel_t filter_bilinear(pixelmap_t *pixmap, double x, double y,
 		    (sysarg_t) x1, (sysarg_t) y1, extend);
 	}
 
-	double x_delta = x - x1;
-	double y_delta = y - y1;
-
-	pixel_t pixels[4];
-	pixels[0] = pixelmap_get_extended_pixel(pixmap, x1, y1, extend);
-	pixels[1] = pixelmap_get_extended_pixel(pixmap, x2, y1, extend);
-	pixels[2] = pixelmap_get_extended_pixel(pixmap, x1, y2, extend);
-	pixels[3] = pixelmap_get_extended_pixel(pixmap, x2, y2, extend);
+	unsigned x_weight = (unsigned) ((x - x1) * 256);
+	unsigned y_weight = (unsigned) ((y - y1) * 256);
 
-	float weights[4];
-	weights[0] = (1 - x_delta) * (1 - y_delta);
-	weights[1] = x_delta       * (1 - y_delta);
-	weights[2] = (1 - x_delta) * y_delta;
-	weights[3] = x_delta       * y_delta;
+	pixel_t top = lerp_pixels(
+	    pixelmap_get_extended_pixel(pixmap, x1, y1, extend),
+	    pixelmap_get_extended_pixel(pixmap, x2, y1, extend), x_weight);
+	pixel_t bottom = lerp_pixels(
+	    pixelmap_get_extended_pixel(pixmap, x1, y2, extend),
+	    pixelmap_get_extended_pixel(pixmap, x2, y2, extend), x_weight);
 
-	return blend_pixels(4, weights, pixels);
+	return lerp_pixels(top, bottom, y_weight);
 }
 
 pixel_t filter_bicubic(pixelmap_t *pixmap, double x, double y,
@@ -117,5 +115,65 @@ pixel_t filter_bicubic(pixelmap_t *pixmap, double x, double y,
 	return 0;
 }
 
+/** Bilinear filtering of a span.
+ *
+ * Pixels whose neighbourhood lies within the pixmap are read directly,
+ * only those at the edges go through the pixmap extension.
+ */
+static void filter_bilinear_span(pixelmap_t *pixmap, double x, double y,
+    double dx, double dy, pixelmap_extend_t extend, pixel_t *dst, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		double sx = x + i * dx;
+		double sy = y + i * dy;
+		long x1 = _floor(sx);
+		long y1 = _floor(sy);
+
+		if ((x1 < 0) || (y1 < 0) ||
+		    ((sysarg_t) x1 + 1 >= pixmap->width) ||
+		    ((sysarg_t) y1 + 1 >= pixmap->height)) {
+			dst[i] = filter_bilinear(pixmap, sx, sy, extend);
+			continue;
+		}
+
+		unsigned x_weight = (unsigned) ((sx - x1) * 256);
+		unsigned y_weight = (unsigned) ((sy - y1) * 256);
+		pixel_t *row = pixmap->data + y1 * pixmap->width + x1;
+
+		pixel_t top = lerp_pixels(row[0], row[1], x_weight);
+		pixel_t bottom = lerp_pixels(row[pixmap->width],
+		    row[pixmap->width + 1], x_weight);
+
+		dst[i] = lerp_pixels(top, bottom, y_weight);
+	}
+}
+
+/** Filter a span of pixels.
+ *
+ * The pixel i of the span is filtered at (x + i * dx, y + i * dy), that is
+ * the span may follow any line through the pixmap.
+ *
+ * @param filter Filter to use.
+ * @param pixmap Filtered pixmap.
+ * @param x      Horizontal position of the first pixel in the pixmap.
+ * @param y      Vertical position of the first pixel in the pixmap.
+ * @param dx     Horizontal distance between pixels of the span.
+ * @param dy     Vertical distance between pixels of the span.
+ * @param extend How to treat pixels outside of the pixmap.
+ * @param dst    Buffer for the filtered pixels.
+ * @param count  Number of pixels.
+ */
+void filter_span(filter_t filter, pixelmap_t *pixmap, double x, double y,
+    double dx, double dy, pixelmap_extend_t extend, pixel_t *dst, size_t count)
+{
+	if (filter == filter_bilinear) {
+		filter_bilinear_span(pixmap, x, y, dx, dy, extend, dst, count);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		dst[i] = filter(pixmap, x + i * dx, y + i * dy, extend);
+}
+
 /** @}
  */
@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup softrend
+ * @{
+ */
+/**
+ * @file Region arithmetic.
+ *
+ * A region is kept as an unsorted array of disjoint rectangles. The
+ * regions handled by the compositor consist of a few rectangles only,
+ * so the simple quadratic algorithms below are preferred to banded
+ * representations.
+ */
+
+#include <stdlib.h>
+#include <mem.h>
+#include "rectangle.h"
+#include "region.h"
+
+/** Number of rectangles allocated for a region at first. */
+#define REGION_INITIAL_SIZE  8
+
+/** Largest coordinate a rectangle can extend to. */
+#define REGION_COORD_MAX  ((sysarg_t) -1)
+
+/** Make sure the region can hold the given number of rectangles. */
+static errno_t region_reserve(region_t *region, size_t count)
+{
+	if (count <= region->size)
+		return EOK;
+
+	size_t size = region->size > 0 ? region->size : REGION_INITIAL_SIZE;
+	while (size < count)
+		size *= 2;
+
+	region_rect_t *rects = realloc(region->rects,
+	    size * sizeof(region_rect_t));
+	if (rects == NULL)
+		return ENOMEM;
+
+	region->rects = rects;
+	region->size = size;
+	return EOK;
+}
+
+/** Append rectangle to the region, space must be reserved by the caller. */
+static void region_append(region_t *region,
+    sysarg_t x, sysarg_t y, sysarg_t w, sysarg_t h)
+{
+	region_rect_t *rect = &region->rects[region->count++];
+	rect->x = x;
+	rect->y = y;
+	rect->w = w;
+	rect->h = h;
+}
+
+/** Cut rectangle size so that it does not wrap around. */
+static void region_clamp(sysarg_t x, sysarg_t y, sysarg_t *w, sysarg_t *h)
+{
+	if (*w > REGION_COORD_MAX - x)
+		*w = REGION_COORD_MAX - x;
+	if (*h > REGION_COORD_MAX - y)
+		*h = REGION_COORD_MAX - y;
+}
+
+/** Append those parts of a rectangle not covered by another rectangle.
+ *
+ * At most four rectangles are appended (above, below, left and right
+ * of the covered part), space must be reserved by the caller.
+ */
+static void region_append_difference(region_t *region,
+    const region_rect_t *rect, sysarg_t x, sysarg_t y, sysarg_t w, sysarg_t h)
+{
+	sysarg_t ix, iy, iw, ih;
+	if (!rectangle_intersect(rect->x, rect->y, rect->w, rect->h,
+	    x, y, w, h, &ix, &iy, &iw, &ih)) {
+		region->rects[region->count++] = *rect;
+		return;
+	}
+
+	if (iy > rect->y)
+		region_append(region, rect->x, rect->y, rect->w, iy - rect->y);
+
+	if (iy + ih < rect->y + rect->h) {
+		region_append(region, rect->x, iy + ih, rect->w,
+		    rect->y + rect->h - (iy + ih));
+	}
+
+	if (ix > rect->x)
+		region_append(region, rect->x, iy, ix - rect->x, ih);
+
+	if (ix + iw < rect->x + rect->w) {
+		region_append(region, ix + iw, iy,
+		    rect->x + rect->w - (ix + iw), ih);
+	}
+}
+
+/** Merge neighbouring rectangles which together form a rectangle. */
+static void region_coalesce(region_t *region)
+{
+	bool merged;
+
+	do {
+		merged = false;
+
+		for (size_t i = 0; i < region->count; i++) {
+			region_rect_t *a = &region->rects[i];
+			size_t j = i + 1;
+
+			while (j < region->count) {
+				region_rect_t *b = &region->rects[j];
+
+				if ((a->y == b->y) && (a->h == b->h) &&
+				    ((a->x + a->w == b->x) || (b->x + b->w == a->x))) {
+					a->x = a->x < b->x ? a->x : b->x;
+					a->w += b->w;
+				} else if ((a->x == b->x) && (a->w == b->w) &&
+				    ((a->y + a->h == b->y) || (b->y + b->h == a->y))) {
+					a->y = a->y < b->y ? a->y : b->y;
+					a->h += b->h;
+				} else {
+					j++;
+					continue;
+				}
+
+				*b = region->rects[--region->count];
+				merged = true;
+			}
+		}
+	} while (merged);
+}
+
+/** Initialize empty region. */
+void region_init(region_t *region)
+{
+	region->rects = NULL;
+	region->count = 0;
+	region->size = 0;
+}
+
+/** Release memory held by the region. */
+void region_fini(region_t *region)
+{
+	free(region->rects);
+	region_init(region);
+}
+
+/** Remove all rectangles from the region, keeping its memory. */
+void region_clear(region_t *region)
+{
+	region->count = 0;
+}
+
+bool region_empty(const region_t *region)
+{
+	return region->count == 0;
+}
+
+/** Replace the contents of a region by another region.
+ *
+ * @param dst Region to be overwritten.
+ * @param src Region to be copied.
+ *
+ * @return EOK on success, ENOMEM if out of memory (@a dst is unchanged).
+ */
+errno_t region_copy(region_t *dst, const region_t *src)
+{
+	errno_t rc = region_reserve(dst, src->count);
+	if (rc != EOK)
+		return rc;
+
+	if (src->count > 0)
+		memcpy(dst->rects, src->rects, src->count * sizeof(region_rect_t));
+	dst->count = src->count;
+	return EOK;
+}
+
+/** Add rectangle to the region.
+ *
+ * Only the part not yet covered by the region is added, so that the
+ * rectangles stay disjoint. Adjacent rectangles are merged afterwards.
+ *
+ * @return EOK on success, ENOMEM if out of memory (region is unchanged).
+ */
+errno_t region_add(region_t *region,
+    sysarg_t x, sysarg_t y, sysarg_t w, sysarg_t h)
+{
+	region_clamp(x, y, &w, &h);
+	if ((w == 0) || (h == 0))
+		return EOK;
+
+	region_t add;
+	region_init(&add);
+
+	errno_t rc = region_reserve(&add, 1);
+	if (rc != EOK)
+		return rc;
+
+	region_append(&add, x, y, w, h);
+
+	for (size_t i = 0; i < region->count; i++) {
+		const region_rect_t *rect = &region->rects[i];
+		rc = region_subtract(&add, rect->x, rect->y, rect->w, rect->h);
+		if ((rc != EOK) || region_empty(&add))
+			break;
+	}
+
+	if (rc == EOK)
+		rc = region_reserve(region, region->count + add.count);
+
+	if (rc == EOK) {
+		for (size_t i = 0; i < add.count; i++)
+			region->rects[region->count++] = add.rects[i];
+		region_coalesce(region);
+	}
+
+	region_fini(&add);
+	return rc;
+}
+
+/** Remove rectangle from the region.
+ *
+ * @return EOK on success, ENOMEM if out of memory (region is unchanged).
+ */
+errno_t region_subtract(region_t *region,
+    sysarg_t x, sysarg_t y, sysarg_t w, sysarg_t h)
+{
+	region_clamp(x, y, &w, &h);
+	if ((w == 0) || (h == 0) || region_empty(region))
+		return EOK;
+
+	region_t res;
+	region_init(&res);
+
+	errno_t rc = region_reserve(&res, region->count * 4);
+	if (rc != EOK)
+		return rc;
+
+	for (size_t i = 0; i < region->count; i++)
+		region_append_difference(&res, &region->rects[i], x, y, w, h);
+
+	region_fini(region);
+	*region = res;
+	return EOK;
+}
+
+/** Restrict the region to a rectangle. */
+void region_intersect(region_t *region,
+    sysarg_t x, sysarg_t y, sysarg_t w, sysarg_t h)
+{
+	region_clamp(x, y, &w, &h);
+
+	size_t i = 0;
+	while (i < region->count) {
+		region_rect_t *rect = &region->rects[i];
+
+		if (rectangle_intersect(rect->x, rect->y, rect->w, rect->h,
+		    x, y, w, h, &rect->x, &rect->y, &rect->w, &rect->h))
+			i++;
+		else
+			*rect = region->rects[--region->count];
+	}
+}
+
+/** Split rectangles of the region into tiles of limited size.
+ *
+ * Tiles are aligned to the origin of the rectangle they are cut from.
+ *
+ * @param region Region to be split.
+ * @param tile_w Maximal width of a tile.
+ * @param tile_h Maximal height of a tile.
+ *
+ * @return EOK on success, ENOMEM if out of memory (region is unchanged).
+ */
+errno_t region_split(region_t *region, sysarg_t tile_w, sysarg_t tile_h)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < region->count; i++) {
+		const region_rect_t *rect = &region->rects[i];
+		count += ((rect->w + tile_w - 1) / tile_w) *
+		    ((rect->h + tile_h - 1) / tile_h);
+	}
+
+	if (count == region->count)
+		return EOK;
+
+	region_t res;
+	region_init(&res);
+
+	errno_t rc = region_reserve(&res, count);
+	if (rc != EOK)
+		return rc;
+
+	for (size_t i = 0; i < region->count; i++) {
+		const region_rect_t *rect = &region->rects[i];
+
+		for (sysarg_t y = 0; y < rect->h; y += tile_h) {
+			sysarg_t h = rect->h - y < tile_h ? rect->h - y : tile_h;
+
+			for (sysarg_t x = 0; x < rect->w; x += tile_w) {
+				sysarg_t w = rect->w - x < tile_w ?
+				    rect->w - x : tile_w;
+				region_append(&res, rect->x + x, rect->y + y, w, h);
+			}
+		}
+	}
+
+	region_fini(region);
+	*region = res;
+	return EOK;
+}
+
+/** Limit the number of rectangles of the region.
+ *
+ * If the region consists of more rectangles than allowed, it is
+ * replaced by its bounding rectangle. The resulting region thus may
+ * cover more than the original one, which is fine for damage tracking,
+ * but not for computing what is covered.
+ *
+ * @param region Region to be limited.
+ * @param max    Maximal number of rectangles (at least one).
+ */
+void region_limit(region_t *region, size_t max)
+{
+	if (region->count <= max)
+		return;
+
+	region_rect_t bounds;
+	region_bounds(region, &bounds.x, &bounds.y, &bounds.w, &bounds.h);
+
+	region->rects[0] = bounds;
+	region->count = 1;
+}
+
+/** Get bounding rectangle of the region (all zeros for empty region). */
+void region_bounds(const region_t *region,
+    sysarg_t *x_out, sysarg_t *y_out, sysarg_t *w_out, sysarg_t *h_out)
+{
+	if (region_empty(region)) {
+		*x_out = 0;
+		*y_out = 0;
+		*w_out = 0;
+		*h_out = 0;
+		return;
+	}
+
+	sysarg_t x = region->rects[0].x;
+	sysarg_t y = region->rects[0].y;
+	sysarg_t w = region->rects[0].w;
+	sysarg_t h = region->rects[0].h;
+
+	for (size_t i = 1; i < region->count; i++) {
+		const region_rect_t *rect = &region->rects[i];
+		rectangle_union(x, y, w, h, rect->x, rect->y, rect->w, rect->h,
+		    &x, &y, &w, &h);
+	}
+
+	*x_out = x;
+	*y_out = y;
+	*w_out = w;
+	*h_out = h;
+}
+
+/** Get number of pixels covered by the region. */
+uint64_t region_area(const region_t *region)
+{
+	uint64_t area = 0;
+
+	for (size_t i = 0; i < region->count; i++)
+		area += (uint64_t) region->rects[i].w * region->rects[i].h;
+
+	return area;
+}
+
+/** @}
+ */
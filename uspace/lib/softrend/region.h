@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup softrend
+ * @{
+ */
+/**
+ * @file
+ */
+
+#ifndef SOFTREND_REGION_H_
+#define SOFTREND_REGION_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types/common.h>
+
+/** Rectangle of a region. */
+typedef struct {
+	sysarg_t x;
+	sysarg_t y;
+	sysarg_t w;
+	sysarg_t h;
+} region_rect_t;
+
+/** Area described by a set of disjoint rectangles. */
+typedef struct {
+	region_rect_t *rects;
+	size_t count;
+	size_t size;
+} region_t;
+
+extern void region_init(region_t *);
+extern void region_fini(region_t *);
+extern void region_clear(region_t *);
+extern bool region_empty(const region_t *);
+extern errno_t region_copy(region_t *, const region_t *);
+extern errno_t region_add(region_t *, sysarg_t, sysarg_t, sysarg_t, sysarg_t);
+extern errno_t region_subtract(region_t *,
+    sysarg_t, sysarg_t, sysarg_t, sysarg_t);
+extern void region_intersect(region_t *,
+    sysarg_t, sysarg_t, sysarg_t, sysarg_t);
+extern errno_t region_split(region_t *, sysarg_t, sysarg_t);
+extern void region_limit(region_t *, size_t);
+extern void region_bounds(const region_t *,
+    sysarg_t *, sysarg_t *, sysarg_t *, sysarg_t *);
+extern uint64_t region_area(const region_t *);
+
+#endif
+
+/** @}
+ */
@@ -68,13 +68,13 @@ void usb_dump_standard_descriptor(FILE *, const char *, const char *,
 #define usb_log_info(format, ...) \
 	usb_log_printf(USB_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
 
-/** Log debugging message. */
+/** Log debugging message (formatted by the logger). */
 #define usb_log_debug(format, ...) \
-	usb_log_printf(USB_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+	log_msg_bin(LOG_DEFAULT, USB_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
 
-/** Log verbose debugging message. */
+/** Log verbose debugging message (formatted by the logger). */
 #define usb_log_debug2(format, ...) \
-	usb_log_printf(USB_LOG_LEVEL_DEBUG2, format, ##__VA_ARGS__)
+	log_msg_bin(LOG_DEFAULT, USB_LOG_LEVEL_DEBUG2, format, ##__VA_ARGS__)
 
 const char *usb_debug_str_buffer(const uint8_t *, size_t, size_t);
 
@@ -35,6 +35,7 @@
 
 #include <macros.h>
 #include <stdlib.h>
+#include <str_error.h>
 
 #include "audio_data.h"
 #include "log.h"
@@ -175,6 +176,64 @@ static inline size_t audio_data_link_available_frames(audio_data_link_t *alink)
 
 /* Audio Pipe */
 
+/** Number of frames converted at once when resampling. */
+#define RESAMPLE_BLOCK 256
+
+/**
+ * Release the sample rate converter of a pipe.
+ * @param pipe The audio pipe.
+ */
+static void audio_pipe_resampler_fini(audio_pipe_t *pipe)
+{
+	pcm_resampler_destroy(pipe->resampler);
+	free(pipe->resampler_in);
+	free(pipe->resampler_out);
+	pipe->resampler = NULL;
+	pipe->resampler_in = NULL;
+	pipe->resampler_out = NULL;
+}
+
+/**
+ * Prepare sample rate converter for the given formats.
+ * @param pipe The audio pipe.
+ * @param sf Format of the data in the pipe.
+ * @param rate Target sampling rate.
+ * @return Error code.
+ *
+ * The converter is kept as long as the formats do not change, so that
+ * its state carries over between chunks of data.
+ */
+static errno_t audio_pipe_resampler_setup(audio_pipe_t *pipe,
+    const pcm_format_t *sf, unsigned rate)
+{
+	if (pipe->resampler &&
+	    pipe->resampler_format.sampling_rate == sf->sampling_rate &&
+	    pipe->resampler_format.channels == sf->channels &&
+	    pipe->resampler_rate == rate)
+		return EOK;
+
+	audio_pipe_resampler_fini(pipe);
+
+	errno_t ret = pcm_resampler_create(sf->sampling_rate, rate,
+	    sf->channels, &pipe->resampler);
+	if (ret != EOK)
+		return ret;
+
+	pipe->resampler_in =
+	    malloc(RESAMPLE_BLOCK * sf->channels * sizeof(float));
+	pipe->resampler_out =
+	    malloc(RESAMPLE_BLOCK * sf->channels * sizeof(float));
+	if (!pipe->resampler_in || !pipe->resampler_out) {
+		audio_pipe_resampler_fini(pipe);
+		return ENOMEM;
+	}
+
+	pipe->resampler_format = *sf;
+	pipe->resampler_rate = rate;
+	log_verbose("Resampling %uHz to %uHz", sf->sampling_rate, rate);
+	return EOK;
+}
+
 /**
  * Initialize audio pipe structure.
  * @param pipe The pipe structure to initialize.
@@ -186,6 +245,9 @@ void audio_pipe_init(audio_pipe_t *pipe)
 	fibril_mutex_initialize(&pipe->guard);
 	pipe->frames = 0;
 	pipe->bytes = 0;
+	pipe->resampler = NULL;
+	pipe->resampler_in = NULL;
+	pipe->resampler_out = NULL;
 }
 
 /**
@@ -199,6 +261,7 @@ void audio_pipe_fini(audio_pipe_t *pipe)
 		audio_data_t *adata = audio_pipe_pop(pipe);
 		audio_data_unref(adata);
 	}
+	audio_pipe_resampler_fini(pipe);
 }
 
 /**
@@ -271,33 +334,62 @@ size_t audio_pipe_mix_data(audio_pipe_t *pipe, void *data,
 		audio_data_link_t *alink = audio_data_link_list_instance(l);
 
 		/* Get audio chunk metadata */
-		const size_t src_frame_size =
-		    pcm_format_frame_size(&alink->adata->format);
+		const pcm_format_t *sf = &alink->adata->format;
+		const size_t src_frame_size = pcm_format_frame_size(sf);
 		const size_t available_frames =
 		    audio_data_link_available_frames(alink);
-		const size_t copy_frames = min(available_frames, needed_frames);
+		size_t copy_frames = min(available_frames, needed_frames);
+		size_t src_frames = copy_frames;
+
+		if (sf->sampling_rate != f->sampling_rate) {
+			if (audio_pipe_resampler_setup(pipe, sf,
+			    f->sampling_rate) != EOK) {
+				log_error("Failed to resample %uHz to %uHz",
+				    sf->sampling_rate, f->sampling_rate);
+				break;
+			}
+
+			/* Convert a block, the converter keeps what it used. */
+			src_frames = min(available_frames, RESAMPLE_BLOCK);
+			errno_t rc = pcm_format_to_float(pipe->resampler_in,
+			    audio_data_link_start(alink), src_frames, sf);
+			if (rc != EOK) {
+				log_error("Failed to convert data for "
+				    "resampling: %s", str_error(rc));
+				break;
+			}
+			copy_frames = pcm_resampler_process(pipe->resampler,
+			    pipe->resampler_in, src_frames, &src_frames,
+			    pipe->resampler_out,
+			    min(needed_frames, RESAMPLE_BLOCK));
+			pcm_format_mix_float(data, copy_frames * dst_frame_size,
+			    pipe->resampler_out, copy_frames, sf->channels, f);
+		} else {
+			/* Copy audio data */
+			pcm_format_convert_and_mix(data,
+			    copy_frames * dst_frame_size,
+			    audio_data_link_start(alink),
+			    copy_frames * src_frame_size, sf, f);
+		}
+
 		const size_t dst_copy_size = copy_frames * dst_frame_size;
-		const size_t src_copy_size = copy_frames * src_frame_size;
+		const size_t src_copy_size = src_frames * src_frame_size;
 
 		assert(src_copy_size <= audio_data_link_remain_size(alink));
 
-		/* Copy audio data */
-		pcm_format_convert_and_mix(data, dst_copy_size,
-		    audio_data_link_start(alink), src_copy_size,
-		    &alink->adata->format, f);
-
 		/* Update values */
 		needed_frames -= copy_frames;
 		copied_size += dst_copy_size;
 		data += dst_copy_size;
 		alink->position += src_copy_size;
 		pipe->bytes -= src_copy_size;
-		pipe->frames -= copy_frames;
+		pipe->frames -= src_frames;
 		if (audio_data_link_remain_size(alink) == 0) {
 			list_remove(&alink->link);
 			audio_data_link_destroy(alink);
 		} else {
-			assert(needed_frames == 0);
+			assert(needed_frames == 0 ||
+			    sf->sampling_rate != f->sampling_rate);
 		}
 	}
 	fibril_mutex_unlock(&pipe->guard);
@@ -41,6 +41,7 @@
 #include <errno.h>
 #include <fibril_synch.h>
 #include <pcm/format.h>
+#include <pcm/resampler.h>
 
 /** Reference counted audio buffer */
 typedef struct {
@@ -64,6 +65,15 @@ typedef struct {
 	size_t frames;
 	/** List access synchronization */
 	fibril_mutex_t guard;
+	/** Sample rate converter for data of a different sampling rate */
+	pcm_resampler_t *resampler;
+	/** Input format of the converter */
+	pcm_format_t resampler_format;
+	/** Output sampling rate of the converter */
+	unsigned resampler_rate;
+	/** Converter input and output buffers */
+	float *resampler_in;
+	float *resampler_out;
 } audio_pipe_t;
 
 audio_data_t *audio_data_create(void *data, size_t size,
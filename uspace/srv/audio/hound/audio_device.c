@@ -49,12 +49,14 @@
 
 /* hardwired to provide ~21ms per fragment */
 #define BUFFER_PARTS   16
+/* Most fragments a buffer is split to when a period is requested */
+#define BUFFER_PARTS_MAX   256
 
 static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new);
 static errno_t device_source_connection_callback(audio_source_t *source, bool new);
 static void device_event_callback(ipc_call_t *icall, void *arg);
 static errno_t device_check_format(audio_sink_t *sink);
-static errno_t get_buffer(audio_device_t *dev);
+static errno_t get_buffer(audio_device_t *dev, const pcm_format_t *f);
 static errno_t release_buffer(audio_device_t *dev);
 static void advance_buffer(audio_device_t *dev, size_t size);
 static inline bool is_running(audio_device_t *dev)
@@ -69,14 +71,17 @@ static inline bool is_running(audio_device_t *dev)
  * @param dev The structure to initialize.
  * @param id Location service id of the device driver.
  * @param name Name of the device.
+ * @param period Requested fragment duration, 0 for the default.
  * @return Error code.
  */
-errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name)
+errno_t audio_device_init(audio_device_t *dev, service_id_t id,
+    const char *name, usec_t period)
 {
 	assert(dev);
 	link_initialize(&dev->link);
 	dev->id = id;
 	dev->name = str_dup(name);
+	dev->period = period;
 	dev->sess = audio_pcm_open_service(id);
 	if (!dev->sess) {
 		log_debug("Failed to connect to device \"%s\"", name);
@@ -159,7 +164,7 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 	if (new && list_count(&sink->connections) == 1) {
 		log_verbose("First connection on device sink '%s'", sink->name);
 
-		errno_t ret = get_buffer(dev);
+		errno_t ret = get_buffer(dev, &dev->sink.format);
 		if (ret != EOK) {
 			log_error("Failed to get device buffer: %s",
 			    str_error(ret));
@@ -221,7 +226,7 @@ static errno_t device_source_connection_callback(audio_source_t *source, bool ne
 	assert(source);
 	audio_device_t *dev = source->private_data;
 	if (new && list_count(&source->connections) == 1) {
-		errno_t ret = get_buffer(dev);
+		errno_t ret = get_buffer(dev, &dev->source.format);
 		if (ret != EOK) {
 			log_error("Failed to get device buffer: %s",
 			    str_error(ret));
@@ -339,12 +344,36 @@ static errno_t device_check_format(audio_sink_t *sink)
 	    &sink->format.sampling_rate, &sink->format.sample_format);
 }
 
+/**
+ * Pick fragment size for the device buffer.
+ * @param dev Audio device, the buffer size must be known.
+ * @param f Format of the data in the buffer.
+ * @return Fragment size in bytes.
+ *
+ * The buffer is split to a power of two number of fragments, the smallest
+ * ones that still cover the requested period.
+ */
+static size_t fragment_size(audio_device_t *dev, const pcm_format_t *f)
+{
+	if (dev->period == 0 || pcm_format_is_any(f))
+		return dev->buffer.size / BUFFER_PARTS;
+
+	const size_t wanted = pcm_format_frame_size(f) *
+	    (size_t) ((uint64_t) f->sampling_rate * dev->period / 1000000);
+	size_t parts = 2;
+	while (parts < BUFFER_PARTS_MAX &&
+	    dev->buffer.size / (parts * 2) >= wanted)
+		parts *= 2;
+	return dev->buffer.size / parts;
+}
+
 /**
  * Get access to device buffer.
  * @param dev Audio device.
+ * @param f Format of the data in the buffer.
  * @return Error code.
  */
-static errno_t get_buffer(audio_device_t *dev)
+static errno_t get_buffer(audio_device_t *dev, const pcm_format_t *f)
 {
 	assert(dev);
 	if (!dev->sess) {
@@ -363,7 +392,7 @@ static errno_t get_buffer(audio_device_t *dev)
 	    &preferred_size);
 	if (ret == EOK) {
 		dev->buffer.size = preferred_size;
-		dev->buffer.fragment_size = dev->buffer.size / BUFFER_PARTS;
+		dev->buffer.fragment_size = fragment_size(dev, f);
 		dev->buffer.position = dev->buffer.base;
 	}
 	return ret;
@@ -41,6 +41,7 @@
 #include <fibril_synch.h>
 #include <errno.h>
 #include <ipc/loc.h>
+#include <time.h>
 #include <audio_pcm_iface.h>
 
 #include "audio_source.h"
@@ -56,6 +57,8 @@ typedef struct {
 	audio_pcm_sess_t *sess;
 	/** Device name */
 	char *name;
+	/** Requested fragment duration, 0 for the default */
+	usec_t period;
 	/** Device buffer */
 	struct {
 		void *base;
@@ -75,7 +78,8 @@ static inline audio_device_t *audio_device_list_instance(link_t *l)
 	return l ? list_get_instance(l, audio_device_t, link) : NULL;
 }
 
-errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name);
+errno_t audio_device_init(audio_device_t *dev, service_id_t id,
+    const char *name, usec_t period);
 void audio_device_fini(audio_device_t *dev);
 audio_source_t *audio_device_get_source(audio_device_t *dev);
 audio_sink_t *audio_device_get_sink(audio_device_t *dev);
@@ -73,6 +73,7 @@ errno_t audio_source_init(audio_source_t *source, const char *name, void *data,
 	source->private_data = data;
 	source->connection_change = connection_change;
 	source->update_available_data = update_available_data;
+	source->mix_data = NULL;
 	source->format = *f;
 	log_verbose("Initialized source (%p) '%s'", source, source->name);
 	return EOK;
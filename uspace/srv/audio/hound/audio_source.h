@@ -57,6 +57,9 @@ struct audio_source {
 	errno_t (*connection_change)(audio_source_t *source, bool added);
 	/** Ask backend for more data */
 	errno_t (*update_available_data)(audio_source_t *source, size_t size);
+	/** Mix data directly to the destination buffer (optional) */
+	errno_t (*mix_data)(audio_source_t *source, void *dest, size_t size,
+	    const pcm_format_t *f);
 };
 
 /**
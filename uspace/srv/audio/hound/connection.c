@@ -106,6 +106,15 @@ errno_t connection_add_source_data(connection_t *connection, void *data,
 	assert(connection);
 	if (!data)
 		return EBADMEM;
+	audio_source_t *source = connection->source;
+	/*
+	 * A source that feeds only this connection can mix straight to the
+	 * destination, nobody else needs a copy of the data.
+	 */
+	if (source->mix_data && audio_pipe_bytes(&connection->fifo) == 0 &&
+	    list_count(&source->connections) == 1)
+		return source->mix_data(source, data, size, &format);
+
 	const size_t needed_frames = pcm_format_size_to_frames(size, &format);
 	if (needed_frames > audio_pipe_frames(&connection->fifo) &&
 	    connection->source->update_available_data) {
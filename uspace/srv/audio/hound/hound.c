@@ -171,6 +171,7 @@ errno_t hound_init(hound_t *hound)
 	list_initialize(&hound->sources);
 	list_initialize(&hound->sinks);
 	list_initialize(&hound->connections);
+	hound->period = 0;
 	return EOK;
 }
 
@@ -283,7 +284,7 @@ errno_t hound_add_device(hound_t *hound, service_id_t id, const char *name)
 		return ENOMEM;
 	}
 
-	const errno_t ret = audio_device_init(dev, id, name);
+	const errno_t ret = audio_device_init(dev, id, name, hound->period);
 	if (ret != EOK) {
 		log_debug("Failed to initialize new audio device: %s",
 		    str_error(ret));
@@ -43,6 +43,7 @@
 #include <fibril_synch.h>
 #include <pcm/format.h>
 #include <hound/protocol.h>
+#include <time.h>
 
 #include "hound_ctx.h"
 #include "audio_source.h"
@@ -62,6 +63,8 @@ typedef struct {
 	list_t sinks;
 	/** Existing connections. */
 	list_t connections;
+	/** Requested device fragment duration, 0 for the default */
+	usec_t period;
 } hound_t;
 
 errno_t hound_init(hound_t *hound);
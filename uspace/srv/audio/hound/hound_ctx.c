@@ -45,6 +45,8 @@
 #include "log.h"
 
 static errno_t update_data(audio_source_t *source, size_t size);
+static errno_t mix_data(audio_source_t *source, void *dest, size_t size,
+    const pcm_format_t *f);
 static errno_t new_data(audio_sink_t *sink);
 
 /**
@@ -105,6 +107,7 @@ hound_ctx_t *hound_playback_ctx_get(const char *name)
 			free(ctx);
 			return NULL;
 		}
+		ctx->source->mix_data = mix_data;
 	}
 	return ctx;
 }
@@ -171,6 +174,19 @@ typedef struct hound_ctx_stream {
 	fibril_mutex_t guard;
 	/** buffer status change condition */
 	fibril_condvar_t change;
+	/** Ring shared with the client, NULL for IPC streams */
+	hound_ring_t *ring;
+	/**
+	 * Geometry of the ring. The client can write to the ring header,
+	 * so only the positions are read from there.
+	 */
+	size_t ring_period;
+	size_t ring_periods;
+	size_t ring_frames;
+	/** The ring ran out of data last time */
+	bool underrun;
+	/** No more data are expected */
+	bool draining;
 } hound_ctx_stream_t;
 
 /**
@@ -257,6 +273,9 @@ hound_ctx_stream_t *hound_ctx_create_stream(hound_ctx_t *ctx, int flags,
 		stream->flags = flags;
 		stream->format = format;
 		stream->allowed_size = buffer_size;
+		stream->ring = NULL;
+		stream->underrun = false;
+		stream->draining = false;
 		stream_append(ctx, stream);
 		log_verbose("CTX: %p added stream; flags:%#x ch: %u r:%u f:%s",
 		    ctx, flags, format.channels, format.sampling_rate,
@@ -288,6 +307,131 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream)
 	}
 }
 
+/**
+ * Feed the stream from a ring shared with the client.
+ * @param stream The stream.
+ * @param ring Initialized ring, the stream format describes its data.
+ * @return Error code.
+ */
+errno_t hound_ctx_stream_share(hound_ctx_stream_t *stream, hound_ring_t *ring)
+{
+	assert(stream);
+	assert(ring);
+	if (hound_ctx_is_record(stream->ctx))
+		return EINVAL;
+
+	/* The client has no access to the ring yet */
+	fibril_mutex_lock(&stream->guard);
+	stream->ring = ring;
+	stream->ring_period = ring->period;
+	stream->ring_periods = ring->periods;
+	stream->ring_frames = ring->period * ring->periods;
+	fibril_mutex_unlock(&stream->guard);
+	log_verbose("CTX: %p shared stream; period: %zu periods: %zu",
+	    stream->ctx, stream->ring_period, stream->ring_periods);
+	return EOK;
+}
+
+/**
+ * Number of frames waiting in the shared ring.
+ * @param stream The stream.
+ * @return Number of frames, 0 if there is no ring.
+ */
+static size_t stream_ring_frames(hound_ctx_stream_t *stream)
+{
+	if (!stream->ring)
+		return 0;
+	return min(stream->ring_frames,
+	    atomic_load_explicit(&stream->ring->write, memory_order_acquire) -
+	    atomic_load_explicit(&stream->ring->read, memory_order_relaxed));
+}
+
+/**
+ * Mix data from the shared ring to the destination buffer.
+ * @param stream The source stream, guard must be held.
+ * @param data Destination audio buffer.
+ * @param size Size of the @p data buffer.
+ * @param f Destination data format.
+ * @return Size of the destination buffer touched with stream's data.
+ *
+ * Data of the same sampling rate are mixed straight from the ring. Other
+ * data are moved to the stream pipe which knows how to resample them.
+ */
+static size_t stream_ring_mix(hound_ctx_stream_t *stream, void *data,
+    size_t size, const pcm_format_t *f)
+{
+	hound_ring_t *ring = stream->ring;
+	const pcm_format_t *sf = &stream->format;
+	const size_t ring_frames = stream->ring_frames;
+	const size_t src_frame_size = pcm_format_frame_size(sf);
+	const size_t dst_frame_size = pcm_format_frame_size(f);
+	const size_t needed = pcm_format_size_to_frames(size, f);
+	const size_t read =
+	    atomic_load_explicit(&ring->read, memory_order_relaxed);
+	const size_t write =
+	    atomic_load_explicit(&ring->write, memory_order_acquire);
+	uint8_t *buffer = hound_ring_data(ring);
+	/* A client can never have more than the whole ring ready */
+	size_t frames = min(write - read, ring_frames);
+	size_t mixed;
+
+	if (sf->sampling_rate != f->sampling_rate) {
+		/* Keep at most one ring of data in the pipe */
+		if (audio_pipe_bytes(&stream->fifo) >= ring_frames * src_frame_size)
+			frames = 0;
+		for (size_t done = 0; done < frames; ) {
+			const size_t pos = (read + done) % ring_frames;
+			const size_t count = min(frames - done, ring_frames - pos);
+			if (audio_pipe_push_data(&stream->fifo,
+			    buffer + pos * src_frame_size,
+			    count * src_frame_size, *sf) != EOK) {
+				frames = done;
+				break;
+			}
+			done += count;
+		}
+		atomic_store_explicit(&ring->read, read + frames,
+		    memory_order_release);
+		mixed = audio_pipe_mix_data(&stream->fifo, data, size, f) /
+		    dst_frame_size;
+	} else {
+		frames = min(frames, needed);
+		for (size_t done = 0; done < frames; ) {
+			const size_t pos = (read + done) % ring_frames;
+			const size_t count = min(frames - done, ring_frames - pos);
+			pcm_format_convert_and_mix(
+			    (uint8_t *) data + done * dst_frame_size,
+			    count * dst_frame_size,
+			    buffer + pos * src_frame_size,
+			    count * src_frame_size, sf, f);
+			done += count;
+		}
+		atomic_store_explicit(&ring->read, read + frames,
+		    memory_order_release);
+		mixed = frames;
+	}
+
+	/* Count every run out of data once, the end of stream is not one. */
+	if (mixed < needed && write != 0 && !stream->draining &&
+	    !(stream->flags & HOUND_STREAM_IGNORE_UNDERFLOW)) {
+		if (!stream->underrun)
+			atomic_fetch_add(&ring->xruns, 1);
+		stream->underrun = true;
+	} else if (mixed == needed) {
+		stream->underrun = false;
+	}
+
+	/*
+	 * Devices are mixed one fragment ahead, so the data leave the
+	 * speaker at most two destination buffers later.
+	 */
+	atomic_store(&ring->delay,
+	    (size_t) ((uint64_t) 2 * needed * sf->sampling_rate /
+	    f->sampling_rate));
+
+	return mixed * dst_frame_size;
+}
+
 /**
  * Write new data to a stream.
  * @param stream The destination stream.
@@ -361,7 +505,9 @@ size_t hound_ctx_stream_add_self(hound_ctx_stream_t *stream, void *data,
 {
 	assert(stream);
 	fibril_mutex_lock(&stream->guard);
-	const size_t ret = audio_pipe_mix_data(&stream->fifo, data, size, f);
+	const size_t ret = stream->ring ?
+	    stream_ring_mix(stream, data, size, f) :
+	    audio_pipe_mix_data(&stream->fifo, data, size, f);
 	fibril_condvar_signal(&stream->change);
 	fibril_mutex_unlock(&stream->guard);
 	return ret;
@@ -376,8 +522,10 @@ void hound_ctx_stream_drain(hound_ctx_stream_t *stream)
 	assert(stream);
 	log_debug("Draining stream");
 	fibril_mutex_lock(&stream->guard);
-	while (audio_pipe_bytes(&stream->fifo))
+	stream->draining = true;
+	while (audio_pipe_bytes(&stream->fifo) || stream_ring_frames(stream))
 		fibril_condvar_wait(&stream->change, &stream->guard);
+	stream->draining = false;
 	fibril_mutex_unlock(&stream->guard);
 }
 
@@ -423,6 +571,35 @@ errno_t update_data(audio_source_t *source, size_t size)
 	return EOK;
 }
 
+/**
+ * Mix data from all streams directly to the destination buffer.
+ * @param source Source abstraction.
+ * @param dest Destination audio buffer.
+ * @param size Size of the @p dest buffer.
+ * @param f Format of the @p dest buffer.
+ * @return Error code.
+ *
+ * Used instead of update_data() when the context feeds a single sink,
+ * this saves the intermediate buffer and one format conversion.
+ */
+static errno_t mix_data(audio_source_t *source, void *dest, size_t size,
+    const pcm_format_t *f)
+{
+	assert(source);
+	assert(source->private_data);
+	hound_ctx_t *ctx = source->private_data;
+
+	fibril_mutex_lock(&ctx->guard);
+	list_foreach(ctx->streams, link, hound_ctx_stream_t, stream) {
+		const size_t copied =
+		    hound_ctx_stream_add_self(stream, dest, size, f);
+		if (copied != size && !stream->ring)
+			log_warning("Not enough data in stream buffer");
+	}
+	fibril_mutex_unlock(&ctx->guard);
+	return EOK;
+}
+
 errno_t new_data(audio_sink_t *sink)
 {
 	assert(sink);
@@ -69,6 +69,7 @@ bool hound_ctx_is_record(hound_ctx_t *ctx);
 hound_ctx_stream_t *hound_ctx_create_stream(hound_ctx_t *ctx, int flags,
     pcm_format_t format, size_t buffer_size);
 void hound_ctx_destroy_stream(hound_ctx_stream_t *stream);
+errno_t hound_ctx_stream_share(hound_ctx_stream_t *stream, hound_ring_t *ring);
 
 errno_t hound_ctx_stream_write(hound_ctx_stream_t *stream, void *buffer,
     size_t size);
@@ -135,6 +135,11 @@ static errno_t iface_rem_stream(void *server, void *stream)
 	return EOK;
 }
 
+static errno_t iface_share_stream(void *stream, hound_ring_t *ring)
+{
+	return hound_ctx_stream_share(stream, ring);
+}
+
 static errno_t iface_drain_stream(void *stream)
 {
 	hound_ctx_stream_drain(stream);
@@ -160,6 +165,7 @@ hound_server_iface_t hound_iface = {
 	.disconnect = iface_disconnect,
 	.add_stream = iface_add_stream,
 	.rem_stream = iface_rem_stream,
+	.share_stream = iface_share_stream,
 	.drain_stream = iface_drain_stream,
 	.stream_data_write = iface_stream_data_write,
 	.stream_data_read = iface_stream_data_read,
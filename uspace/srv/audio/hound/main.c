@@ -36,6 +36,7 @@
 
 #include <async.h>
 #include <errno.h>
+#include <getopt.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -66,6 +67,12 @@ static void scan_for_devices(void *arg)
 	hound_server_devices_iterate(device_callback);
 }
 
+static void print_syntax(void)
+{
+	printf("Syntax: %s [-p <period>]\n", NAME);
+	printf("\t-p <period>\tDevice fragment duration in microseconds\n");
+}
+
 int main(int argc, char **argv)
 {
 	printf("%s: HelenOS sound service\n", NAME);
@@ -82,6 +89,21 @@ int main(int argc, char **argv)
 		return -ret;
 	}
 
+	int c;
+	optind = 0;
+	while ((c = getopt(argc, argv, "p:")) != -1) {
+		switch (c) {
+		case 'p':
+			hound.period = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			print_syntax();
+			return 1;
+		}
+	}
+	if (hound.period)
+		log_info("Device fragment duration %lld us", hound.period);
+
 	hound_iface.server = &hound;
 	hound_service_set_server_iface(&hound_iface);
 	async_set_fallback_port_handler(hound_connection_handler, NULL);
@@ -45,6 +45,8 @@
 #include <align.h>
 #include <as.h>
 #include <stdlib.h>
+#include <getopt.h>
+#include <time.h>
 
 #include <refcount.h>
 #include <fibril_synch.h>
@@ -66,6 +68,7 @@
 
 #include <transform.h>
 #include <rectangle.h>
+#include <region.h>
 #include <surface.h>
 #include <cursor.h>
 #include <source.h>
@@ -381,209 +384,527 @@ static void comp_restrict_pointers(void)
 	fibril_mutex_unlock(&pointer_list_mtx);
 }
 
+/** Maximal number of rectangles the accumulated damage is kept as. */
+#define DAMAGE_RECTS_MAX  16
+
+/** Shortest time between two frames (in microseconds). */
+#define FRAME_PERIOD  10000
+
+/** Maximal size of the tiles the worker fibrils draw. */
+#define TILE_WIDTH   256
+#define TILE_HEIGHT  64
+
+/** Maximal number of threads drawing a frame. */
+#define THREADS_MAX  16
+
+/** Number of frames drawn by the benchmark for each configuration. */
+#define BENCH_FRAMES  100
+
+/** Damage accumulated since the last frame. */
+static FIBRIL_MUTEX_INITIALIZE(damage_mtx);
+static FIBRIL_CONDVAR_INITIALIZE(damage_cv);
+static region_t damage;
+
+/** Whether windows hidden behind opaque windows are skipped. */
+static bool occlusion = true;
+
+/** Window visible in a frame. */
+typedef struct {
+	window_t *win;
+	/** Part of the damaged area the window is drawn to. */
+	region_t region;
+} layer_t;
+
+/** Frame being drawn to a viewport (all regions in global coordinates). */
+typedef struct {
+	viewport_t *vp;
+	/** Damaged area of the viewport. */
+	region_t damage;
+	/** Part of the damaged area not covered by any opaque window. */
+	region_t background;
+	/** Visible windows from the top. */
+	layer_t *layers;
+	size_t layer_size;
+	size_t layer_count;
+	/** Damaged area split to the pieces drawn independently. */
+	region_t tiles;
+	/** Views of the viewport surface, one for each tile. */
+	surface_t **views;
+	size_t view_count;
+} frame_t;
+
+/** Number of worker fibrils helping to draw tiles of a frame. */
+static size_t render_workers = 0;
+static FIBRIL_MUTEX_INITIALIZE(render_mtx);
+static FIBRIL_CONDVAR_INITIALIZE(render_start_cv);
+static FIBRIL_CONDVAR_INITIALIZE(render_done_cv);
+static frame_t *render_frame;
+static size_t render_next;
+static size_t render_busy;
+static unsigned int render_generation = 0;
+
+/** Number of synthetic windows drawn by the benchmark. */
+static size_t bench_windows = 0;
+
+/** Mark area of the desktop to be redrawn in the next frame.
+ *
+ * @param x_dmg_glob Left edge of the damaged area (global coordinates).
+ * @param y_dmg_glob Top edge of the damaged area (global coordinates).
+ * @param w_dmg_glob Width of the damaged area.
+ * @param h_dmg_glob Height of the damaged area.
+ */
 static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
     sysarg_t w_dmg_glob, sysarg_t h_dmg_glob)
 {
-	fibril_mutex_lock(&viewport_list_mtx);
-	fibril_mutex_lock(&window_list_mtx);
-	fibril_mutex_lock(&pointer_list_mtx);
+	fibril_mutex_lock(&damage_mtx);
 
-	list_foreach(viewport_list, link, viewport_t, vp) {
-		/* Determine what part of the viewport must be updated. */
-		sysarg_t x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp;
-		surface_get_resolution(vp->surface, &w_dmg_vp, &h_dmg_vp);
-		bool isec_vp = rectangle_intersect(
-		    x_dmg_glob, y_dmg_glob, w_dmg_glob, h_dmg_glob,
-		    vp->pos.x, vp->pos.y, w_dmg_vp, h_dmg_vp,
-		    &x_dmg_vp, &y_dmg_vp, &w_dmg_vp, &h_dmg_vp);
-
-		if (isec_vp) {
-
-			/* Paint background color. */
-			for (sysarg_t y = y_dmg_vp - vp->pos.y; y <  y_dmg_vp - vp->pos.y + h_dmg_vp; ++y) {
-				pixel_t *dst = pixelmap_pixel_at(
-				    surface_pixmap_access(vp->surface), x_dmg_vp - vp->pos.x, y);
-				sysarg_t count = w_dmg_vp;
-				while (count-- != 0) {
-					*dst++ = bg_color;
-				}
-			}
-			surface_add_damaged_region(vp->surface,
-			    x_dmg_vp - vp->pos.x, y_dmg_vp - vp->pos.y, w_dmg_vp, h_dmg_vp);
+	if (region_add(&damage, x_dmg_glob, y_dmg_glob,
+	    w_dmg_glob, h_dmg_glob) == EOK) {
+		region_limit(&damage, DAMAGE_RECTS_MAX);
+		fibril_condvar_signal(&damage_cv);
+	}
+
+	fibril_mutex_unlock(&damage_mtx);
+}
+
+/** Whether the window covers its bounding rectangle with opaque pixels.
+ *
+ * Such a window is copied to the viewport without blending (see
+ * drawctx_transfer()), so nothing below it needs to be drawn.
+ */
+static bool comp_window_opaque(window_t *win)
+{
+	return (win->opacity == 255) && transform_is_fast(&win->transform);
+}
+
+static void comp_paint_background(viewport_t *vp,
+    sysarg_t x_dmg, sysarg_t y_dmg, sysarg_t w_dmg, sysarg_t h_dmg)
+{
+	for (sysarg_t y = y_dmg - vp->pos.y; y < y_dmg - vp->pos.y + h_dmg; ++y) {
+		pixel_t *dst = pixelmap_pixel_at(
+		    surface_pixmap_access(vp->surface), x_dmg - vp->pos.x, y);
+		sysarg_t count = w_dmg;
+		while (count-- != 0) {
+			*dst++ = bg_color;
+		}
+	}
+}
+
+static void comp_paint_ghost(viewport_t *vp, surface_t *dst, pointer_t *ptr,
+    sysarg_t x_dmg, sysarg_t y_dmg, sysarg_t w_dmg, sysarg_t h_dmg)
+{
+	sysarg_t x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost;
+	sysarg_t x_dmg_ghost, y_dmg_ghost, w_dmg_ghost, h_dmg_ghost;
+	surface_get_resolution(ptr->ghost.surface, &w_bnd_ghost, &h_bnd_ghost);
+	comp_coord_bounding_rect(0, 0, w_bnd_ghost, h_bnd_ghost, ptr->ghost.transform,
+	    &x_bnd_ghost, &y_bnd_ghost, &w_bnd_ghost, &h_bnd_ghost);
+	bool isec_ghost = rectangle_intersect(
+	    x_dmg, y_dmg, w_dmg, h_dmg,
+	    x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost,
+	    &x_dmg_ghost, &y_dmg_ghost, &w_dmg_ghost, &h_dmg_ghost);
+
+	if (!isec_ghost)
+		return;
+
+	/*
+	 * FIXME: Ghost is currently drawn based on the bounding
+	 * rectangle of the window, which is sufficient as long
+	 * as the windows can be rotated only by 90 degrees.
+	 * For ghost to be compatible with arbitrary-angle
+	 * rotation, it should be drawn as four lines adjusted
+	 * by the transformation matrix. That would however
+	 * require to equip libdraw with line drawing functionality.
+	 */
+
+	pixel_t ghost_color;
+
+	if (y_bnd_ghost == y_dmg_ghost) {
+		for (sysarg_t x = x_dmg_ghost - vp->pos.x;
+		    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
+			ghost_color = surface_get_pixel(dst,
+			    x, y_dmg_ghost - vp->pos.y);
+			surface_put_pixel(dst,
+			    x, y_dmg_ghost - vp->pos.y, INVERT(ghost_color));
+		}
+	}
+
+	if (y_bnd_ghost + h_bnd_ghost == y_dmg_ghost + h_dmg_ghost) {
+		for (sysarg_t x = x_dmg_ghost - vp->pos.x;
+		    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
+			ghost_color = surface_get_pixel(dst,
+			    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1);
+			surface_put_pixel(dst,
+			    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1, INVERT(ghost_color));
+		}
+	}
+
+	if (x_bnd_ghost == x_dmg_ghost) {
+		for (sysarg_t y = y_dmg_ghost - vp->pos.y;
+		    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
+			ghost_color = surface_get_pixel(dst,
+			    x_dmg_ghost - vp->pos.x, y);
+			surface_put_pixel(dst,
+			    x_dmg_ghost - vp->pos.x, y, INVERT(ghost_color));
+		}
+	}
+
+	if (x_bnd_ghost + w_bnd_ghost == x_dmg_ghost + w_dmg_ghost) {
+		for (sysarg_t y = y_dmg_ghost - vp->pos.y;
+		    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
+			ghost_color = surface_get_pixel(dst,
+			    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y);
+			surface_put_pixel(dst,
+			    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y, INVERT(ghost_color));
+		}
+	}
+}
+
+static void comp_paint_pointer(viewport_t *vp, pointer_t *ptr,
+    sysarg_t x_dmg, sysarg_t y_dmg, sysarg_t w_dmg, sysarg_t h_dmg)
+{
+	/*
+	 * Determine what part of the pointer intersects with the
+	 * updated area of the current viewport.
+	 */
+	sysarg_t x_dmg_ptr, y_dmg_ptr, w_dmg_ptr, h_dmg_ptr;
+	surface_t *sf_ptr = ptr->cursor.states[ptr->state];
+	surface_get_resolution(sf_ptr, &w_dmg_ptr, &h_dmg_ptr);
+	bool isec_ptr = rectangle_intersect(
+	    x_dmg, y_dmg, w_dmg, h_dmg,
+	    ptr->pos.x, ptr->pos.y, w_dmg_ptr, h_dmg_ptr,
+	    &x_dmg_ptr, &y_dmg_ptr, &w_dmg_ptr, &h_dmg_ptr);
+
+	if (!isec_ptr)
+		return;
+
+	/*
+	 * Pointer is currently painted directly by copying pixels.
+	 * However, it is possible to draw the pointer similarly
+	 * as window by using drawctx_transfer. It would allow
+	 * more sophisticated control over drawing, but would also
+	 * cost more regarding the performance.
+	 */
+
+	sysarg_t x_vp = x_dmg_ptr - vp->pos.x;
+	sysarg_t y_vp = y_dmg_ptr - vp->pos.y;
+	sysarg_t x_ptr = x_dmg_ptr - ptr->pos.x;
+	sysarg_t y_ptr = y_dmg_ptr - ptr->pos.y;
+
+	for (sysarg_t y = 0; y < h_dmg_ptr; ++y) {
+		pixel_t *src = pixelmap_pixel_at(
+		    surface_pixmap_access(sf_ptr), x_ptr, y_ptr + y);
+		pixel_t *dst = pixelmap_pixel_at(
+		    surface_pixmap_access(vp->surface), x_vp, y_vp + y);
+		sysarg_t count = w_dmg_ptr;
+		while (count-- != 0) {
+			*dst = (*src & 0xff000000) ? *src : *dst;
+			++dst;
+			++src;
+		}
+	}
+}
+
+static void comp_frame_init(frame_t *frame, viewport_t *vp)
+{
+	frame->vp = vp;
+	region_init(&frame->damage);
+	region_init(&frame->background);
+	region_init(&frame->tiles);
+	frame->views = NULL;
+	frame->view_count = 0;
+	frame->layers = NULL;
+	frame->layer_size = 0;
+	frame->layer_count = 0;
+}
+
+static void comp_frame_fini(frame_t *frame)
+{
+	for (size_t i = 0; i < frame->layer_size; ++i)
+		region_fini(&frame->layers[i].region);
+
+	for (size_t i = 0; i < frame->view_count; ++i)
+		surface_destroy(frame->views[i]);
+
+	free(frame->views);
+	free(frame->layers);
+	region_fini(&frame->tiles);
+	region_fini(&frame->background);
+	region_fini(&frame->damage);
+}
+
+/** Determine what has to be drawn to the viewport of the frame.
+ *
+ * Windows are walked from the top. The part of the damaged area hidden
+ * by an opaque window is not drawn below it.
+ */
+static errno_t comp_frame_build(frame_t *frame, const region_t *dmg)
+{
+	/* window_list_mtx locked by caller */
+
+	viewport_t *vp = frame->vp;
+	sysarg_t w_vp, h_vp;
+	surface_get_resolution(vp->surface, &w_vp, &h_vp);
+
+	errno_t rc = region_copy(&frame->damage, dmg);
+	if (rc != EOK)
+		return rc;
+
+	region_intersect(&frame->damage, vp->pos.x, vp->pos.y, w_vp, h_vp);
+	if (region_empty(&frame->damage))
+		return EOK;
+
+	rc = region_copy(&frame->background, &frame->damage);
+	if (rc != EOK)
+		return rc;
 
-			transform_t transform;
-			source_t source;
-			drawctx_t context;
+	size_t count = list_count(&window_list);
+	if (count > 0) {
+		frame->layers = (layer_t *) calloc(count, sizeof(layer_t));
+		if (!frame->layers)
+			return ENOMEM;
 
-			source_init(&source);
-			source_set_filter(&source, filter);
-			drawctx_init(&context, vp->surface);
-			drawctx_set_compose(&context, compose_over);
-			drawctx_set_source(&context, &source);
+		frame->layer_size = count;
+		for (size_t i = 0; i < count; ++i)
+			region_init(&frame->layers[i].region);
+	}
 
-			/* For each window. */
-			for (link_t *link = window_list.head.prev;
-			    link != &window_list.head; link = link->prev) {
+	list_foreach(window_list, link, window_t, win) {
+		if (region_empty(&frame->background))
+			break;
 
+		if (!win->surface)
+			continue;
+
+		sysarg_t x_win, y_win, w_win, h_win;
+		surface_get_resolution(win->surface, &w_win, &h_win);
+		comp_coord_bounding_rect(0, 0, w_win, h_win, win->transform,
+		    &x_win, &y_win, &w_win, &h_win);
+
+		layer_t *layer = &frame->layers[frame->layer_count];
+		rc = region_copy(&layer->region, &frame->background);
+		if (rc != EOK)
+			return rc;
+
+		region_intersect(&layer->region, x_win, y_win, w_win, h_win);
+		if (region_empty(&layer->region))
+			continue;
+
+		layer->win = win;
+		frame->layer_count++;
+
+		if (occlusion && comp_window_opaque(win)) {
+			rc = region_subtract(&frame->background,
+			    x_win, y_win, w_win, h_win);
+			if (rc != EOK)
+				return rc;
+		}
+	}
+
+	rc = region_copy(&frame->tiles, &frame->damage);
+	if ((rc == EOK) && (render_workers > 0))
+		rc = region_split(&frame->tiles, TILE_WIDTH, TILE_HEIGHT);
+	if ((rc != EOK) || (frame->tiles.count == 0))
+		return rc;
+
+	/*
+	 * Each tile is drawn through its own view of the viewport pixels,
+	 * so the drawing does not race on the damage of the viewport surface.
+	 */
+	frame->views = (surface_t **) calloc(frame->tiles.count,
+	    sizeof(surface_t *));
+	if (!frame->views)
+		return ENOMEM;
+
+	pixel_t *pixels = surface_direct_access(vp->surface);
+	for (size_t i = 0; i < frame->tiles.count; ++i) {
+		frame->views[i] = surface_create(w_vp, h_vp, pixels,
+		    SURFACE_FLAG_VIEW);
+		if (!frame->views[i])
+			return ENOMEM;
+
+		frame->view_count++;
+	}
+
+	return EOK;
+}
+
+/** Draw one tile of the frame.
+ *
+ * Tiles of a frame are disjoint, so they can be drawn concurrently.
+ * The tile is drawn through its own view of the viewport pixels, the
+ * damage of the viewport surface is set for the whole frame by the
+ * caller once all tiles are drawn.
+ */
+static void comp_render_tile(frame_t *frame, size_t idx)
+{
+	/* window_list_mtx locked by caller */
+	/* pointer_list_mtx locked by caller */
+
+	viewport_t *vp = frame->vp;
+	surface_t *view = frame->views[idx];
+	const region_rect_t *tile = &frame->tiles.rects[idx];
+	sysarg_t x, y, w, h;
+
+	for (size_t i = 0; i < frame->background.count; ++i) {
+		const region_rect_t *rect = &frame->background.rects[i];
+		if (rectangle_intersect(rect->x, rect->y, rect->w, rect->h,
+		    tile->x, tile->y, tile->w, tile->h, &x, &y, &w, &h))
+			comp_paint_background(vp, x, y, w, h);
+	}
+
+	source_t source;
+	drawctx_t context;
+
+	source_init(&source);
+	source_set_filter(&source, filter);
+	drawctx_init(&context, view);
+	drawctx_set_compose(&context, compose_over);
+	drawctx_set_source(&context, &source);
+
+	/* For each visible window from the bottom. */
+	for (size_t i = frame->layer_count; i-- > 0;) {
+		layer_t *layer = &frame->layers[i];
+		window_t *win = layer->win;
+		bool prepared = false;
+
+		for (size_t j = 0; j < layer->region.count; ++j) {
+			const region_rect_t *rect = &layer->region.rects[j];
+			if (!rectangle_intersect(rect->x, rect->y, rect->w, rect->h,
+			    tile->x, tile->y, tile->w, tile->h, &x, &y, &w, &h))
+				continue;
+
+			if (!prepared) {
 				/*
-				 * Determine what part of the window intersects with the
-				 * updated area of the current viewport.
+				 * Prepare conversion from global coordinates to viewport
+				 * coordinates.
 				 */
-				window_t *win = list_get_instance(link, window_t, link);
-				if (!win->surface) {
-					continue;
-				}
-				sysarg_t x_dmg_win, y_dmg_win, w_dmg_win, h_dmg_win;
-				surface_get_resolution(win->surface, &w_dmg_win, &h_dmg_win);
-				comp_coord_bounding_rect(0, 0, w_dmg_win, h_dmg_win, win->transform,
-				    &x_dmg_win, &y_dmg_win, &w_dmg_win, &h_dmg_win);
-				bool isec_win = rectangle_intersect(
-				    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-				    x_dmg_win, y_dmg_win, w_dmg_win, h_dmg_win,
-				    &x_dmg_win, &y_dmg_win, &w_dmg_win, &h_dmg_win);
-
-				if (isec_win) {
-					/*
-					 * Prepare conversion from global coordinates to viewport
-					 * coordinates.
-					 */
-					transform = win->transform;
-					double_point_t pos;
-					pos.x = vp->pos.x;
-					pos.y = vp->pos.y;
-					transform_translate(&transform, -pos.x, -pos.y);
-
-					source_set_transform(&source, transform);
-					source_set_texture(&source, win->surface,
-					    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
-					source_set_alpha(&source, PIXEL(win->opacity, 0, 0, 0));
-
-					drawctx_transfer(&context,
-					    x_dmg_win - vp->pos.x, y_dmg_win - vp->pos.y, w_dmg_win, h_dmg_win);
-				}
+				transform_t transform = win->transform;
+				double_point_t pos;
+				pos.x = vp->pos.x;
+				pos.y = vp->pos.y;
+				transform_translate(&transform, -pos.x, -pos.y);
+
+				source_set_transform(&source, transform);
+				source_set_texture(&source, win->surface,
+				    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
+				source_set_alpha(&source, PIXEL(win->opacity, 0, 0, 0));
+				prepared = true;
 			}
 
-			list_foreach(pointer_list, link, pointer_t, ptr) {
-				if (ptr->ghost.surface) {
-
-					sysarg_t x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost;
-					sysarg_t x_dmg_ghost, y_dmg_ghost, w_dmg_ghost, h_dmg_ghost;
-					surface_get_resolution(ptr->ghost.surface, &w_bnd_ghost, &h_bnd_ghost);
-					comp_coord_bounding_rect(0, 0, w_bnd_ghost, h_bnd_ghost, ptr->ghost.transform,
-					    &x_bnd_ghost, &y_bnd_ghost, &w_bnd_ghost, &h_bnd_ghost);
-					bool isec_ghost = rectangle_intersect(
-					    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-					    x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost,
-					    &x_dmg_ghost, &y_dmg_ghost, &w_dmg_ghost, &h_dmg_ghost);
-
-					if (isec_ghost) {
-						/*
-						 * FIXME: Ghost is currently drawn based on the bounding
-						 * rectangle of the window, which is sufficient as long
-						 * as the windows can be rotated only by 90 degrees.
-						 * For ghost to be compatible with arbitrary-angle
-						 * rotation, it should be drawn as four lines adjusted
-						 * by the transformation matrix. That would however
-						 * require to equip libdraw with line drawing functionality.
-						 */
-
-						transform_t transform = ptr->ghost.transform;
-						double_point_t pos;
-						pos.x = vp->pos.x;
-						pos.y = vp->pos.y;
-						transform_translate(&transform, -pos.x, -pos.y);
-
-						pixel_t ghost_color;
-
-						if (y_bnd_ghost == y_dmg_ghost) {
-							for (sysarg_t x = x_dmg_ghost - vp->pos.x;
-							    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y);
-								surface_put_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y, INVERT(ghost_color));
-							}
-						}
-
-						if (y_bnd_ghost + h_bnd_ghost == y_dmg_ghost + h_dmg_ghost) {
-							for (sysarg_t x = x_dmg_ghost - vp->pos.x;
-							    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1);
-								surface_put_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1, INVERT(ghost_color));
-							}
-						}
-
-						if (x_bnd_ghost == x_dmg_ghost) {
-							for (sysarg_t y = y_dmg_ghost - vp->pos.y;
-							    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x, y);
-								surface_put_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x, y, INVERT(ghost_color));
-							}
-						}
-
-						if (x_bnd_ghost + w_bnd_ghost == x_dmg_ghost + w_dmg_ghost) {
-							for (sysarg_t y = y_dmg_ghost - vp->pos.y;
-							    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y);
-								surface_put_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y, INVERT(ghost_color));
-							}
-						}
-					}
+			drawctx_transfer(&context, x - vp->pos.x, y - vp->pos.y, w, h);
+		}
+	}
 
-				}
-			}
+	list_foreach(pointer_list, link, pointer_t, ptr) {
+		if (ptr->ghost.surface) {
+			comp_paint_ghost(vp, view, ptr,
+			    tile->x, tile->y, tile->w, tile->h);
+		}
+	}
+
+	list_foreach(pointer_list, link, pointer_t, ptr) {
+		comp_paint_pointer(vp, ptr, tile->x, tile->y, tile->w, tile->h);
+	}
+}
+
+/** Draw tiles of the current frame until there are none left.
+ *
+ * @return Number of tiles drawn.
+ */
+static size_t comp_render_next_tiles(void)
+{
+	/* render_mtx locked by caller */
 
-			list_foreach(pointer_list, link, pointer_t, ptr) {
+	frame_t *frame = render_frame;
+	size_t count = 0;
 
-				/*
-				 * Determine what part of the pointer intersects with the
-				 * updated area of the current viewport.
-				 */
-				sysarg_t x_dmg_ptr, y_dmg_ptr, w_dmg_ptr, h_dmg_ptr;
-				surface_t *sf_ptr = ptr->cursor.states[ptr->state];
-				surface_get_resolution(sf_ptr, &w_dmg_ptr, &h_dmg_ptr);
-				bool isec_ptr = rectangle_intersect(
-				    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-				    ptr->pos.x, ptr->pos.y, w_dmg_ptr, h_dmg_ptr,
-				    &x_dmg_ptr, &y_dmg_ptr, &w_dmg_ptr, &h_dmg_ptr);
-
-				if (isec_ptr) {
-					/*
-					 * Pointer is currently painted directly by copying pixels.
-					 * However, it is possible to draw the pointer similarly
-					 * as window by using drawctx_transfer. It would allow
-					 * more sophisticated control over drawing, but would also
-					 * cost more regarding the performance.
-					 */
-
-					sysarg_t x_vp = x_dmg_ptr - vp->pos.x;
-					sysarg_t y_vp = y_dmg_ptr - vp->pos.y;
-					sysarg_t x_ptr = x_dmg_ptr - ptr->pos.x;
-					sysarg_t y_ptr = y_dmg_ptr - ptr->pos.y;
-
-					for (sysarg_t y = 0; y < h_dmg_ptr; ++y) {
-						pixel_t *src = pixelmap_pixel_at(
-						    surface_pixmap_access(sf_ptr), x_ptr, y_ptr + y);
-						pixel_t *dst = pixelmap_pixel_at(
-						    surface_pixmap_access(vp->surface), x_vp, y_vp + y);
-						sysarg_t count = w_dmg_ptr;
-						while (count-- != 0) {
-							*dst = (*src & 0xff000000) ? *src : *dst;
-							++dst;
-							++src;
-						}
-					}
-					surface_add_damaged_region(vp->surface, x_vp, y_vp, w_dmg_ptr, h_dmg_ptr);
-				}
+	while (render_next < frame->tiles.count) {
+		size_t idx = render_next++;
 
+		fibril_mutex_unlock(&render_mtx);
+		comp_render_tile(frame, idx);
+		fibril_mutex_lock(&render_mtx);
+
+		++count;
+	}
+
+	return count;
+}
+
+static errno_t comp_render_worker(void *arg)
+{
+	unsigned int generation = 0;
+
+	fibril_mutex_lock(&render_mtx);
+
+	while (true) {
+		while (render_generation == generation)
+			fibril_condvar_wait(&render_start_cv, &render_mtx);
+
+		generation = render_generation;
+		comp_render_next_tiles();
+
+		if (--render_busy == 0)
+			fibril_condvar_broadcast(&render_done_cv);
+	}
+
+	return EOK;
+}
+
+static void comp_render_tiles(frame_t *frame)
+{
+	if ((render_workers == 0) || (frame->tiles.count < 2)) {
+		for (size_t i = 0; i < frame->tiles.count; ++i)
+			comp_render_tile(frame, i);
+		return;
+	}
+
+	fibril_mutex_lock(&render_mtx);
+
+	render_frame = frame;
+	render_next = 0;
+	render_busy = render_workers;
+	++render_generation;
+	fibril_condvar_broadcast(&render_start_cv);
+
+	/* Help the workers instead of just waiting for them. */
+	comp_render_next_tiles();
+
+	while (render_busy > 0)
+		fibril_condvar_wait(&render_done_cv, &render_mtx);
+
+	render_frame = NULL;
+	fibril_mutex_unlock(&render_mtx);
+}
+
+/** Draw damaged region to all viewports and notify the visualizers. */
+static errno_t comp_render(const region_t *dmg)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&viewport_list_mtx);
+	fibril_mutex_lock(&window_list_mtx);
+	fibril_mutex_lock(&pointer_list_mtx);
+
+	list_foreach(viewport_list, link, viewport_t, vp) {
+		frame_t frame;
+		comp_frame_init(&frame, vp);
+
+		rc = comp_frame_build(&frame, dmg);
+		if (rc == EOK) {
+			comp_render_tiles(&frame);
+
+			for (size_t i = 0; i < frame.damage.count; ++i) {
+				const region_rect_t *rect = &frame.damage.rects[i];
+				surface_add_damaged_region(vp->surface,
+				    rect->x - vp->pos.x, rect->y - vp->pos.y,
+				    rect->w, rect->h);
 			}
 		}
+
+		comp_frame_fini(&frame);
+		if (rc != EOK)
+			break;
 	}
 
 	fibril_mutex_unlock(&pointer_list_mtx);
@@ -601,6 +922,51 @@ static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
 	}
 
 	fibril_mutex_unlock(&viewport_list_mtx);
+	return rc;
+}
+
+/** Render the accumulated damage, at most once per frame period. */
+static errno_t comp_render_fibril(void *arg)
+{
+	region_t frame_damage;
+	region_init(&frame_damage);
+
+	struct timespec last;
+	getuptime(&last);
+
+	while (true) {
+		fibril_mutex_lock(&damage_mtx);
+		while (region_empty(&damage))
+			fibril_condvar_wait(&damage_cv, &damage_mtx);
+		fibril_mutex_unlock(&damage_mtx);
+
+		/* Let the damage reported shortly after each other accumulate. */
+		struct timespec now;
+		getuptime(&now);
+		usec_t elapsed = NSEC2USEC(ts_sub_diff(&now, &last));
+		if (elapsed < FRAME_PERIOD)
+			fibril_usleep(FRAME_PERIOD - elapsed);
+
+		fibril_mutex_lock(&damage_mtx);
+		region_t tmp = frame_damage;
+		frame_damage = damage;
+		damage = tmp;
+		fibril_mutex_unlock(&damage_mtx);
+
+		getuptime(&last);
+
+		if (comp_render(&frame_damage) != EOK) {
+			/* Try again in the next frame. */
+			for (size_t i = 0; i < frame_damage.count; ++i) {
+				const region_rect_t *rect = &frame_damage.rects[i];
+				comp_damage(rect->x, rect->y, rect->w, rect->h);
+			}
+		}
+
+		region_clear(&frame_damage);
+	}
+
+	return EOK;
 }
 
 static void comp_window_get_event(window_t *win, ipc_call_t *icall)
@@ -2268,7 +2634,179 @@ static void category_change_cb(void *arg)
 	discover_viewports();
 }
 
-static errno_t compositor_srv_init(char *input_svc, char *name)
+static errno_t comp_render_start(size_t threads)
+{
+	fid_t fid = fibril_create(comp_render_fibril, NULL);
+	if (fid == 0)
+		return ENOMEM;
+
+	fibril_add_ready(fid);
+
+	if (threads < 2)
+		return EOK;
+
+	/*
+	 * The renderer draws tiles as well, so one worker fewer is needed.
+	 * Note that with more threads, all fibrils of the compositor may run
+	 * in parallel, which is why drawing on several threads is optional.
+	 */
+	fibril_enable_multithreaded();
+
+	for (size_t i = 1; i < threads; ++i) {
+		fid = fibril_create(comp_render_worker, NULL);
+		if (fid == 0)
+			break;
+
+		fibril_add_ready(fid);
+		++render_workers;
+	}
+
+	return EOK;
+}
+
+static window_t *comp_bench_window_create(sysarg_t x, sysarg_t y,
+    sysarg_t width, sysarg_t height, pixel_t color)
+{
+	window_t *win = window_create();
+	if (!win)
+		return NULL;
+
+	win->surface = surface_create(width, height, NULL, 0);
+	if (!win->surface) {
+		window_destroy(win);
+		return NULL;
+	}
+
+	for (sysarg_t row = 0; row < height; ++row) {
+		pixel_t *dst = pixelmap_pixel_at(
+		    surface_pixmap_access(win->surface), 0, row);
+		sysarg_t count = width;
+		while (count-- != 0) {
+			*dst++ = color;
+		}
+	}
+
+	win->flags = WINDOW_DECORATED;
+	win->in_dsid = 0;
+	win->out_dsid = 0;
+	transform_identity(&win->transform);
+	transform_translate(&win->transform, x, y);
+	win->dx = x;
+	win->dy = y;
+
+	return win;
+}
+
+/** Draw the whole desktop repeatedly and print the frame times. */
+static void comp_bench_frames(const region_t *full, bool cull)
+{
+	usec_t min = 0;
+	usec_t max = 0;
+	usec_t total = 0;
+	unsigned int frames;
+
+	occlusion = cull;
+
+	for (frames = 0; frames < BENCH_FRAMES; ++frames) {
+		struct timespec start;
+		struct timespec end;
+
+		getuptime(&start);
+		errno_t rc = comp_render(full);
+		getuptime(&end);
+
+		if (rc != EOK) {
+			printf("%s: Unable to draw frame (%s)\n", NAME, str_error(rc));
+			break;
+		}
+
+		usec_t time = NSEC2USEC(ts_sub_diff(&end, &start));
+		min = ((frames == 0) || (time < min)) ? time : min;
+		max = (time > max) ? time : max;
+		total += time;
+	}
+
+	occlusion = true;
+
+	if (frames == 0)
+		return;
+
+	printf("%s: %zu windows, %zu threads, occlusion culling %s: "
+	    "frame time min %lld us, avg %lld us, max %lld us\n", NAME,
+	    bench_windows, render_workers + 1, cull ? "on" : "off",
+	    min, total / frames, max);
+}
+
+/** Measure frame times with synthetic windows cascaded over the desktop. */
+static errno_t comp_bench_fibril(void *arg)
+{
+	sysarg_t x = viewport_bound_rect.x;
+	sysarg_t y = viewport_bound_rect.y;
+	sysarg_t width = viewport_bound_rect.w;
+	sysarg_t height = viewport_bound_rect.h;
+
+	if ((width == 0) || (height == 0)) {
+		printf("%s: No viewport to run the benchmark on\n", NAME);
+		return ENOENT;
+	}
+
+	window_t **windows = (window_t **) calloc(bench_windows,
+	    sizeof(window_t *));
+	if (!windows)
+		return ENOMEM;
+
+	region_t full;
+	region_init(&full);
+
+	errno_t rc = region_add(&full, x, y, width, height);
+	if (rc != EOK)
+		goto out;
+
+	sysarg_t w_win = width / 2;
+	sysarg_t h_win = height / 2;
+
+	for (size_t i = 0; i < bench_windows; ++i) {
+		sysarg_t x_win = x + (i * (width - w_win)) / bench_windows;
+		sysarg_t y_win = y + (i * (height - h_win)) / bench_windows;
+		pixel_t color = PIXEL(255, 64 + (i * 37) % 192,
+		    64 + (i * 59) % 192, 64 + (i * 83) % 192);
+
+		windows[i] = comp_bench_window_create(x_win, y_win,
+		    w_win, h_win, color);
+		if (!windows[i]) {
+			rc = ENOMEM;
+			goto out;
+		}
+
+		fibril_mutex_lock(&window_list_mtx);
+		list_prepend(&windows[i]->link, &window_list);
+		fibril_mutex_unlock(&window_list_mtx);
+	}
+
+	comp_bench_frames(&full, false);
+	comp_bench_frames(&full, true);
+
+out:
+	if (rc != EOK)
+		printf("%s: Unable to run the benchmark (%s)\n", NAME, str_error(rc));
+
+	for (size_t i = 0; i < bench_windows; ++i) {
+		if (windows[i]) {
+			fibril_mutex_lock(&window_list_mtx);
+			list_remove(&windows[i]->link);
+			fibril_mutex_unlock(&window_list_mtx);
+			window_destroy(windows[i]);
+		}
+	}
+
+	free(windows);
+	region_fini(&full);
+
+	comp_damage(x, y, width, height);
+	return rc;
+}
+
+static errno_t compositor_srv_init(char *input_svc, char *name, size_t threads)
 {
 	/* Coordinates of the central pixel. */
 	coord_origin = UINT32_MAX / 4;
@@ -2276,10 +2814,17 @@ static errno_t compositor_srv_init(char *input_svc, char *name)
 	/* Color of the viewport background. Must be opaque. */
 	bg_color = PIXEL(255, 69, 51, 103);
 
+	/* Start drawing frames as soon as there is any damage. */
+	errno_t rc = comp_render_start(threads);
+	if (rc != EOK) {
+		printf("%s: Unable to start renderer (%s)\n", NAME, str_error(rc));
+		return rc;
+	}
+
 	/* Register compositor server. */
 	async_set_fallback_port_handler(client_connection, NULL);
 
-	errno_t rc = loc_server_register(NAME);
+	rc = loc_server_register(NAME);
 	if (rc != EOK) {
 		printf("%s: Unable to register server (%s)\n", NAME, str_error(rc));
 		return -1;
@@ -2329,22 +2874,49 @@ static errno_t compositor_srv_init(char *input_svc, char *name)
 
 static void usage(char *name)
 {
-	printf("Usage: %s <input_dev> <server_name>\n", name);
+	printf("Usage: %s [-t <threads>] [-b <windows>] <input_dev> <server_name>\n",
+	    name);
+	printf("\t-t <threads>\tdraw large damaged areas on more threads\n");
+	printf("\t-b <windows>\tmeasure frame times with synthetic windows\n");
 }
 
 int main(int argc, char *argv[])
 {
-	if (argc < 3) {
+	size_t threads = 1;
+	int c;
+
+	while ((c = getopt(argc, argv, "t:b:")) != -1) {
+		switch (c) {
+		case 't':
+			threads = strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			bench_windows = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((argc - optind < 2) || (threads == 0) || (threads > THREADS_MAX)) {
 		usage(argv[0]);
 		return 1;
 	}
 
 	printf("%s: HelenOS Compositor server\n", NAME);
 
-	errno_t rc = compositor_srv_init(argv[1], argv[2]);
+	errno_t rc = compositor_srv_init(argv[optind], argv[optind + 1],
+	    threads);
 	if (rc != EOK)
 		return rc;
 
+	if (bench_windows > 0) {
+		fid_t fid = fibril_create(comp_bench_fibril, NULL);
+		if (fid != 0)
+			fibril_add_ready(fid);
+	}
+
 	printf("%s: Accepting connections\n", NAME);
 	task_retval(0);
 	async_manager();
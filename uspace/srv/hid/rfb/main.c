@@ -35,7 +35,14 @@
 #include <inttypes.h>
 #include <io/log.h>
 #include <str.h>
+#include <str_error.h>
 #include <task.h>
+#include <time.h>
+#include <getopt.h>
+#include <stats.h>
+#include <byteorder.h>
+#include <mem.h>
+#include <macros.h>
 
 #include <abi/fb/visuals.h>
 #include <adt/list.h>
@@ -48,10 +55,51 @@
 
 #define NAME "rfb"
 
+/** Damage of the replayed trace is sent in frames of this length */
+#define BENCH_FRAME_MS 40
+
+#define TRACE_MAGIC "RFBTRACE"
+
+/** Header of a damage trace, all values are little-endian */
+typedef struct {
+	char magic[8];
+	uint16_t width;
+	uint16_t height;
+} __attribute__((packed)) rfb_trace_header_t;
+
+/** Damage event of a trace, followed by width * height pixels */
+typedef struct {
+	/** Milliseconds since the start of the recording */
+	uint32_t time;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+} __attribute__((packed)) rfb_trace_event_t;
+
+/** Encodings the benchmark replays the trace with */
+typedef struct {
+	const char *name;
+	bool trle;
+	bool zrle;
+	bool copy_rect;
+} bench_config_t;
+
+static bench_config_t bench_configs[] = {
+	{ "raw", false, false, false },
+	{ "trle", true, false, false },
+	{ "zrle", false, true, false },
+	{ "zrle+copyrect", false, true, true }
+};
+
 static vslmode_list_element_t pixel_mode;
 static visualizer_t *vis;
 static rfb_t rfb;
 
+/** Trace damage is recorded to (if any) */
+static FILE *trace;
+static struct timespec trace_start;
+
 static errno_t rfb_claim(visualizer_t *vs)
 {
 	return EOK;
@@ -72,57 +120,50 @@ static errno_t rfb_wakeup(visualizer_t *vs)
 	return EOK;
 }
 
-static errno_t rfb_handle_damage_pixels(visualizer_t *vs,
-    sysarg_t x0, sysarg_t y0, sysarg_t width, sysarg_t height,
-    sysarg_t x_offset, sysarg_t y_offset)
+/** Append damage to the recorded trace */
+static void rfb_trace_damage(sysarg_t x0, sysarg_t y0, sysarg_t width,
+    sysarg_t height)
 {
+	struct timespec now;
+	getuptime(&now);
+
+	rfb_trace_event_t event;
+	event.time = host2uint32_t_le(NSEC2MSEC(ts_sub_diff(&now, &trace_start)));
+	event.x = host2uint16_t_le(x0);
+	event.y = host2uint16_t_le(y0);
+	event.width = host2uint16_t_le(width);
+	event.height = host2uint16_t_le(height);
+
+	pixel_t *row = malloc(width * sizeof(pixel_t));
+	if (row == NULL)
+		return;
+
+	fwrite(&event, sizeof(event), 1, trace);
+
 	fibril_mutex_lock(&rfb.lock);
+	for (sysarg_t y = y0; y < y0 + height; y++) {
+		pixel_t *src = pixelmap_pixel_at(&rfb.framebuffer, x0, y);
+		for (sysarg_t x = 0; x < width; x++)
+			row[x] = host2uint32_t_le(src[x]);
 
-	if (x0 + width > rfb.width || y0 + height > rfb.height) {
-		fibril_mutex_unlock(&rfb.lock);
-		return EINVAL;
+		fwrite(row, sizeof(pixel_t), width, trace);
 	}
+	fibril_mutex_unlock(&rfb.lock);
 
-	/* TODO update surface_t and use it */
-	if (!rfb.damage_valid) {
-		rfb.damage_rect.x = x0;
-		rfb.damage_rect.y = y0;
-		rfb.damage_rect.width = width;
-		rfb.damage_rect.height = height;
-		rfb.damage_valid = true;
-	} else {
-		if (x0 < rfb.damage_rect.x) {
-			rfb.damage_rect.width += rfb.damage_rect.x - x0;
-			rfb.damage_rect.x = x0;
-		}
-		if (y0 < rfb.damage_rect.y) {
-			rfb.damage_rect.height += rfb.damage_rect.y - y0;
-			rfb.damage_rect.y = y0;
-		}
-		sysarg_t x1 = x0 + width;
-		sysarg_t dx1 = rfb.damage_rect.x + rfb.damage_rect.width;
-		if (x1 > dx1) {
-			rfb.damage_rect.width += x1 - dx1;
-		}
-		sysarg_t y1 = y0 + height;
-		sysarg_t dy1 = rfb.damage_rect.y + rfb.damage_rect.height;
-		if (y1 > dy1) {
-			rfb.damage_rect.height += y1 - dy1;
-		}
-	}
+	free(row);
+}
 
-	pixelmap_t *map = &vs->cells;
+static errno_t rfb_handle_damage_pixels(visualizer_t *vs,
+    sysarg_t x0, sysarg_t y0, sysarg_t width, sysarg_t height,
+    sysarg_t x_offset, sysarg_t y_offset)
+{
+	errno_t rc = rfb_damage(&rfb, &vs->cells, x0, y0, width, height,
+	    x_offset, y_offset);
 
-	for (sysarg_t y = y0; y < height + y0; ++y) {
-		for (sysarg_t x = x0; x < width + x0; ++x) {
-			pixel_t pix = pixelmap_get_pixel(map, (x + x_offset) % map->width,
-			    (y + y_offset) % map->height);
-			pixelmap_put_pixel(&rfb.framebuffer, x, y, pix);
-		}
-	}
+	if (rc == EOK && trace != NULL && width > 0 && height > 0)
+		rfb_trace_damage(x0, y0, width, height);
 
-	fibril_mutex_unlock(&rfb.lock);
-	return EOK;
+	return rc;
 }
 
 static errno_t rfb_change_mode(visualizer_t *vs, vslmode_t new_mode)
@@ -141,7 +182,241 @@ static visualizer_ops_t rfb_ops = {
 
 static void syntax_print(void)
 {
-	fprintf(stderr, "Usage: %s <name> <width> <height> [port]\n", NAME);
+	fprintf(stderr, "Usage: %s [-t <threads>] [-z <level>] [-r <trace>] "
+	    "<name> <width> <height> [port]\n", NAME);
+	fprintf(stderr, "       %s [-t <threads>] [-z <level>] -b <trace>\n",
+	    NAME);
+}
+
+static errno_t bench_read_event(FILE *file, rfb_trace_event_t *event,
+    pixel_t **pixels, size_t *size)
+{
+	if (fread(event, sizeof(*event), 1, file) != 1)
+		return ENOENT;
+
+	event->time = uint32_t_le2host(event->time);
+	event->x = uint16_t_le2host(event->x);
+	event->y = uint16_t_le2host(event->y);
+	event->width = uint16_t_le2host(event->width);
+	event->height = uint16_t_le2host(event->height);
+
+	size_t count = event->width * event->height;
+	if (count > *size) {
+		pixel_t *new_pixels = realloc(*pixels, count * sizeof(pixel_t));
+		if (new_pixels == NULL)
+			return ENOMEM;
+
+		*pixels = new_pixels;
+		*size = count;
+	}
+
+	if (fread(*pixels, sizeof(pixel_t), count, file) != count)
+		return EIO;
+
+	for (size_t i = 0; i < count; i++)
+		(*pixels)[i] = uint32_t_le2host((*pixels)[i]);
+
+	return EOK;
+}
+
+static uint64_t bench_cycles(void)
+{
+	stats_task_t *stats = stats_get_task(task_get_id());
+	if (stats == NULL)
+		return 0;
+
+	uint64_t cycles = stats->ucycles + stats->kcycles;
+	free(stats);
+	return cycles;
+}
+
+/** Replay the trace once to a virtual client with the given encodings */
+static errno_t bench_replay(FILE *file, pixelmap_t *cells,
+    bench_config_t *config)
+{
+	rfb_trace_event_t event;
+	rfb_rectangle_t *rects = NULL;
+	size_t rects_size = 0;
+	pixel_t *pixels = NULL;
+	size_t pixels_size = 0;
+	rfb_client_t *client;
+	void *buf;
+	size_t size;
+
+	memset(rfb.framebuffer.data, 255,
+	    rfb.width * rfb.height * sizeof(pixel_t));
+	memset(cells->data, 255, rfb.width * rfb.height * sizeof(pixel_t));
+
+	errno_t rc = rfb_client_create(&rfb, NULL, &client);
+	if (rc != EOK)
+		return rc;
+
+	client->supports_trle = config->trle;
+	client->supports_zrle = config->zrle;
+	client->supports_copy_rect = config->copy_rect;
+
+	/* The initial screen is not part of the measurement */
+	rc = rfb_client_update(client, false, &buf, &size);
+	if (rc != EOK)
+		goto out;
+
+	free(buf);
+
+	fseek(file, sizeof(rfb_trace_header_t), SEEK_SET);
+
+	unsigned int frames = 0;
+	uint64_t bytes = 0;
+	uint64_t cycles = 0;
+	usec_t time = 0;
+
+	rc = bench_read_event(file, &event, &pixels, &pixels_size);
+	while (rc == EOK) {
+		uint32_t frame_end = event.time + BENCH_FRAME_MS;
+		size_t count = 0;
+
+		/* Collect the damage of the frame */
+		while (rc == EOK && event.time < frame_end) {
+			if (event.x + event.width > rfb.width ||
+			    event.y + event.height > rfb.height) {
+				rc = EINVAL;
+				goto out;
+			}
+
+			for (uint16_t y = 0; y < event.height; y++) {
+				memcpy(pixelmap_pixel_at(cells, event.x, event.y + y),
+				    pixels + y * event.width,
+				    event.width * sizeof(pixel_t));
+			}
+
+			if (count == rects_size) {
+				size_t new_size = max(2 * rects_size, 16);
+				rfb_rectangle_t *new_rects = realloc(rects,
+				    new_size * sizeof(rfb_rectangle_t));
+				if (new_rects == NULL) {
+					rc = ENOMEM;
+					goto out;
+				}
+
+				rects = new_rects;
+				rects_size = new_size;
+			}
+
+			rects[count].x = event.x;
+			rects[count].y = event.y;
+			rects[count].width = event.width;
+			rects[count].height = event.height;
+			count++;
+
+			rc = bench_read_event(file, &event, &pixels, &pixels_size);
+		}
+
+		if (rc != EOK && rc != ENOENT)
+			goto out;
+
+		errno_t read_rc = rc;
+
+		struct timespec start;
+		struct timespec end;
+		uint64_t start_cycles = bench_cycles();
+		getuptime(&start);
+
+		for (size_t i = 0; i < count; i++) {
+			rc = rfb_damage(&rfb, cells, rects[i].x, rects[i].y,
+			    rects[i].width, rects[i].height, 0, 0);
+			if (rc != EOK)
+				goto out;
+		}
+
+		rc = rfb_client_update(client, true, &buf, &size);
+		if (rc != EOK)
+			goto out;
+
+		getuptime(&end);
+		cycles += bench_cycles() - start_cycles;
+		time += NSEC2USEC(ts_sub_diff(&end, &start));
+
+		free(buf);
+		bytes += size;
+		frames++;
+
+		rc = read_rc;
+	}
+
+	if (rc != ENOENT)
+		goto out;
+
+	rc = EOK;
+
+	if (frames == 0) {
+		printf("%s: %s: no damage in the trace\n", NAME, config->name);
+		goto out;
+	}
+
+	printf("%s: %s: %u frames, %" PRIu64 " bytes/frame, %lld us/frame, "
+	    "%" PRIu64 " cycles/frame\n", NAME, config->name, frames,
+	    bytes / frames, time / frames, cycles / frames);
+
+out:
+	rfb_client_destroy(client);
+	free(rects);
+	free(pixels);
+	return rc;
+}
+
+/** Replay a recorded damage trace with all encodings and print the costs */
+static int bench_run(const char *path, unsigned int zlib_level)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "%s: Unable to open trace %s\n", NAME, path);
+		return 1;
+	}
+
+	rfb_trace_header_t header;
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+		fprintf(stderr, "%s: %s is not a damage trace\n", NAME, path);
+		fclose(file);
+		return 1;
+	}
+
+	uint16_t width = uint16_t_le2host(header.width);
+	uint16_t height = uint16_t_le2host(header.height);
+
+	pixelmap_t cells;
+	cells.width = width;
+	cells.height = height;
+	cells.data = malloc(width * height * sizeof(pixel_t));
+
+	errno_t rc = ENOMEM;
+	if (cells.data != NULL)
+		rc = rfb_init(&rfb, width, height, "bench");
+
+	if (rc != EOK) {
+		fprintf(stderr, "%s: Unable to allocate framebuffer\n", NAME);
+		free(cells.data);
+		fclose(file);
+		return 1;
+	}
+
+	rfb.zlib_level = zlib_level;
+
+	printf("%s: replaying %s (%" PRIu16 "x%" PRIu16 ", %d ms frames)\n",
+	    NAME, path, width, height, BENCH_FRAME_MS);
+
+	for (size_t i = 0; i < sizeof(bench_configs) / sizeof(bench_configs[0]);
+	    i++) {
+		rc = bench_replay(file, &cells, &bench_configs[i]);
+		if (rc != EOK) {
+			fprintf(stderr, "%s: Unable to replay trace (%s)\n", NAME,
+			    str_error(rc));
+			break;
+		}
+	}
+
+	free(cells.data);
+	fclose(file);
+	return (rc == EOK) ? 0 : 1;
 }
 
 static void client_connection(ipc_call_t *call, void *data)
@@ -151,24 +426,68 @@ static void client_connection(ipc_call_t *call, void *data)
 
 int main(int argc, char **argv)
 {
+	const char *bench_path = NULL;
+	const char *trace_path = NULL;
+	unsigned long threads = 1;
+	unsigned long zlib_level = DEFLATE_LEVEL_FAST;
+	int c;
+
 	log_init(NAME);
 
-	if (argc <= 3) {
+	while ((c = getopt(argc, argv, "t:z:r:b:")) != -1) {
+		switch (c) {
+		case 't':
+			threads = strtoul(optarg, NULL, 10);
+			if (threads == 0 || threads > RFB_THREADS_MAX) {
+				fprintf(stderr, "Invalid number of threads\n");
+				syntax_print();
+				return 1;
+			}
+			break;
+		case 'z':
+			zlib_level = strtoul(optarg, NULL, 10);
+			if (zlib_level > DEFLATE_LEVEL_BEST) {
+				fprintf(stderr, "Invalid compression level\n");
+				syntax_print();
+				return 1;
+			}
+			break;
+		case 'r':
+			trace_path = optarg;
+			break;
+		case 'b':
+			bench_path = optarg;
+			break;
+		default:
+			syntax_print();
+			return 1;
+		}
+	}
+
+	if (rfb_encoders_start(threads) != EOK) {
+		fprintf(stderr, "Unable to start encoding threads\n");
+		return 1;
+	}
+
+	if (bench_path != NULL)
+		return bench_run(bench_path, zlib_level);
+
+	if (argc - optind < 3) {
 		syntax_print();
 		return 1;
 	}
 
-	const char *rfb_name = argv[1];
+	const char *rfb_name = argv[optind];
 
 	char *endptr;
-	unsigned long width = strtoul(argv[2], &endptr, 0);
+	unsigned long width = strtoul(argv[optind + 1], &endptr, 0);
 	if (*endptr != 0) {
 		fprintf(stderr, "Invalid width\n");
 		syntax_print();
 		return 1;
 	}
 
-	unsigned long height = strtoul(argv[3], &endptr, 0);
+	unsigned long height = strtoul(argv[optind + 2], &endptr, 0);
 	if (*endptr != 0) {
 		fprintf(stderr, "Invalid height\n");
 		syntax_print();
@@ -176,8 +495,8 @@ int main(int argc, char **argv)
 	}
 
 	unsigned long port = 5900;
-	if (argc > 4) {
-		port = strtoul(argv[4], &endptr, 0);
+	if (argc - optind > 3) {
+		port = strtoul(argv[optind + 3], &endptr, 0);
 		if (*endptr != 0) {
 			fprintf(stderr, "Invalid port number\n");
 			syntax_print();
@@ -185,7 +504,28 @@ int main(int argc, char **argv)
 		}
 	}
 
-	rfb_init(&rfb, width, height, rfb_name);
+	errno_t rc = rfb_init(&rfb, width, height, rfb_name);
+	if (rc != EOK) {
+		fprintf(stderr, "Unable to allocate framebuffer\n");
+		return 3;
+	}
+
+	rfb.zlib_level = zlib_level;
+
+	if (trace_path != NULL) {
+		trace = fopen(trace_path, "wb");
+		if (trace == NULL) {
+			fprintf(stderr, "Unable to create trace %s\n", trace_path);
+			return 1;
+		}
+
+		rfb_trace_header_t header;
+		memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+		header.width = host2uint16_t_le(rfb.width);
+		header.height = host2uint16_t_le(rfb.height);
+		fwrite(&header, sizeof(header), 1, trace);
+		getuptime(&trace_start);
+	}
 
 	vis = malloc(sizeof(visualizer_t));
 	if (vis == NULL) {
@@ -216,7 +556,7 @@ int main(int argc, char **argv)
 
 	async_set_fallback_port_handler(client_connection, NULL);
 
-	errno_t rc = loc_server_register(NAME);
+	rc = loc_server_register(NAME);
 	if (rc != EOK) {
 		printf("%s: Unable to register server.\n", NAME);
 		return rc;
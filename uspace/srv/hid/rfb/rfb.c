@@ -25,10 +25,10 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
@@ -52,40 +52,90 @@ static tcp_cb_t conn_cb = {
 	.connected = NULL
 };
 
-/** Buffer for receiving the request. */
-#define BUFFER_SIZE  1024
+/** Mask of the colour channels of a pixel (alpha is not sent) */
+#define RGB_MASK  UINT32_C(0x00ffffff)
+
+/** Maximal number of colours of a palette tile */
+#define PALETTE_MAX  127
+
+/** Size of the hash table of the tile palette */
+#define PALETTE_HASH  256
+
+/** Shortest scroll worth sending as CopyRect (in rows) */
+#define SCROLL_ROWS_MIN  RFB_TILE_SIZE
+
+/** Smallest update the bandwidth to the client is measured with */
+#define BANDWIDTH_SAMPLE_MIN  16384
+
+/** Band of an update encoded by one worker */
+typedef struct {
+	rfb_client_t *client;
+	int32_t enctype;
+	rfb_rectangle_t area;
+	uint8_t *buf;
+	size_t size;
+} rfb_band_t;
+
+/** Damage taken for an update */
+typedef struct {
+	rfb_rectangle_t *rects;
+	size_t count;
+	/** The first rectangle is a CopyRect */
+	bool copy;
+	uint16_t src_x;
+	uint16_t src_y;
+	/** Number of pixels to encode */
+	size_t pixels;
+	/** Whether there was damage and when the oldest damage arrived */
+	bool damaged;
+	struct timespec damage_time;
+} rfb_frame_t;
+
+static const int32_t rfb_codec_enctype[RFB_CODEC_COUNT] = {
+	[RFB_CODEC_RAW] = RFB_ENCODING_RAW,
+	[RFB_CODEC_TRLE] = RFB_ENCODING_TRLE,
+	[RFB_CODEC_ZRLE] = RFB_ENCODING_ZRLE
+};
 
-static char rbuf[BUFFER_SIZE];
-static size_t rbuf_out;
-static size_t rbuf_in;
+/** Number of worker fibrils helping to encode bands of an update. */
+static size_t encode_workers = 0;
+static FIBRIL_MUTEX_INITIALIZE(encode_mtx);
+static FIBRIL_CONDVAR_INITIALIZE(encode_start_cv);
+static FIBRIL_CONDVAR_INITIALIZE(encode_done_cv);
+static rfb_band_t *encode_bands;
+static size_t encode_count;
+static size_t encode_next;
+static size_t encode_busy;
+static unsigned int encode_generation;
 
 /** Receive one character (with buffering) */
-static errno_t recv_char(tcp_conn_t *conn, char *c)
+static errno_t recv_char(rfb_client_t *client, char *c)
 {
 	size_t nrecv;
 	errno_t rc;
 
-	if (rbuf_out == rbuf_in) {
-		rbuf_out = 0;
-		rbuf_in = 0;
+	if (client->rbuf_out == client->rbuf_in) {
+		client->rbuf_out = 0;
+		client->rbuf_in = 0;
 
-		rc = tcp_conn_recv_wait(conn, rbuf, BUFFER_SIZE, &nrecv);
+		rc = tcp_conn_recv_wait(client->conn, client->rbuf, RFB_RBUF_SIZE,
+		    &nrecv);
 		if (rc != EOK)
 			return rc;
 
-		rbuf_in = nrecv;
+		client->rbuf_in = nrecv;
 	}
 
-	*c = rbuf[rbuf_out++];
+	*c = client->rbuf[client->rbuf_out++];
 	return EOK;
 }
 
 /** Receive count characters (with buffering) */
 static errno_t __attribute__((warn_unused_result))
-recv_chars(tcp_conn_t *conn, char *c, size_t count)
+recv_chars(rfb_client_t *client, char *c, size_t count)
 {
 	for (size_t i = 0; i < count; i++) {
-		errno_t rc = recv_char(conn, c);
+		errno_t rc = recv_char(client, c);
 		if (rc != EOK)
 			return rc;
 		c++;
@@ -93,11 +143,11 @@ recv_chars(tcp_conn_t *conn, char *c, size_t count)
 	return EOK;
 }
 
-static errno_t recv_skip_chars(tcp_conn_t *conn, size_t count)
+static errno_t recv_skip_chars(rfb_client_t *client, size_t count)
 {
 	for (size_t i = 0; i < count; i++) {
 		char c;
-		errno_t rc = recv_char(conn, &c);
+		errno_t rc = recv_char(client, &c);
 		if (rc != EOK)
 			return rc;
 	}
@@ -135,7 +185,7 @@ static void rfb_framebuffer_update_request_to_host(rfb_framebuffer_update_reques
     rfb_framebuffer_update_request_t *dst)
 {
 	dst->x = uint16_t_be2host(src->x);
-	dst->y = uint16_t_be2host(src->x);
+	dst->y = uint16_t_be2host(src->y);
 	dst->width = uint16_t_be2host(src->width);
 	dst->height = uint16_t_be2host(src->height);
 }
@@ -155,6 +205,12 @@ static void rfb_rectangle_to_be(rfb_rectangle_t *src, rfb_rectangle_t *dst)
 	dst->enctype = host2uint32_t_be(src->enctype);
 }
 
+static void rfb_copy_rect_to_be(rfb_copy_rect_t *src, rfb_copy_rect_t *dst)
+{
+	dst->src_x = host2uint16_t_be(src->src_x);
+	dst->src_y = host2uint16_t_be(src->src_y);
+}
+
 static void rfb_key_event_to_host(rfb_key_event_t *src, rfb_key_event_t *dst)
 {
 	dst->key = uint32_t_be2host(src->key);
@@ -176,6 +232,7 @@ errno_t rfb_init(rfb_t *rfb, uint16_t width, uint16_t height, const char *name)
 {
 	memset(rfb, 0, sizeof(rfb_t));
 	fibril_mutex_initialize(&rfb->lock);
+	list_initialize(&rfb->clients);
 
 	rfb_pixel_format_t *pf = &rfb->pixel_format;
 	pf->bpp = 32;
@@ -190,24 +247,51 @@ errno_t rfb_init(rfb_t *rfb, uint16_t width, uint16_t height, const char *name)
 	pf->b_shift = 16;
 
 	rfb->name = str_dup(name);
-	rfb->supports_trle = false;
+	rfb->zlib_level = DEFLATE_LEVEL_FAST;
 
 	return rfb_set_size(rfb, width, height);
 }
 
+/** Set size of the framebuffer
+ *
+ * The damage tracking tiles of the clients are not resized, the size
+ * must be set before any client connects.
+ *
+ */
 errno_t rfb_set_size(rfb_t *rfb, uint16_t width, uint16_t height)
 {
 	size_t new_size = width * height * sizeof(pixel_t);
+	size_t tiles_x = (width + RFB_TILE_SIZE - 1) / RFB_TILE_SIZE;
+	size_t tiles_y = (height + RFB_TILE_SIZE - 1) / RFB_TILE_SIZE;
+
 	void *pixbuf = malloc(new_size);
-	if (pixbuf == NULL)
+	uint8_t *changed = malloc(tiles_x * tiles_y);
+	uint8_t *changed_scrolled = malloc(tiles_x * tiles_y);
+	pixel_t *row = malloc(width * sizeof(pixel_t));
+	if (pixbuf == NULL || changed == NULL || changed_scrolled == NULL ||
+	    row == NULL) {
+		free(pixbuf);
+		free(changed);
+		free(changed_scrolled);
+		free(row);
 		return ENOMEM;
+	}
 
 	free(rfb->framebuffer.data);
+	free(rfb->changed);
+	free(rfb->changed_scrolled);
+	free(rfb->row);
+
 	rfb->framebuffer.data = pixbuf;
 	rfb->framebuffer.width = width;
 	rfb->framebuffer.height = height;
 	rfb->width = width;
 	rfb->height = height;
+	rfb->tiles_x = tiles_x;
+	rfb->tiles_y = tiles_y;
+	rfb->changed = changed;
+	rfb->changed_scrolled = changed_scrolled;
+	rfb->row = row;
 
 	/* Fill with white */
 	memset(rfb->framebuffer.data, 255, new_size);
@@ -216,36 +300,40 @@ errno_t rfb_set_size(rfb_t *rfb, uint16_t width, uint16_t height)
 }
 
 static errno_t __attribute__((warn_unused_result))
-recv_message(tcp_conn_t *conn, char type, void *buf, size_t size)
+recv_message(rfb_client_t *client, char type, void *buf, size_t size)
 {
 	memcpy(buf, &type, 1);
-	return recv_chars(conn, ((char *) buf) + 1, size - 1);
+	return recv_chars(client, ((char *) buf) + 1, size - 1);
 }
 
 static uint32_t rfb_scale_channel(uint8_t val, uint32_t max)
 {
+	if (max == 255)
+		return val;
+
 	return val * max / 255;
 }
 
-static void rfb_encode_index(rfb_t *rfb, uint8_t *buf, pixel_t pixel)
+static void rfb_encode_index(rfb_client_t *client, uint8_t *buf, pixel_t pixel)
 {
 	int first_free_index = -1;
 	for (size_t i = 0; i < 256; i++) {
-		bool free = ALPHA(rfb->palette[i]) == 0;
+		bool free = ALPHA(client->palette[i]) == 0;
 		if (free && first_free_index == -1) {
 			first_free_index = i;
-		} else if (!free && RED(rfb->palette[i]) == RED(pixel) &&
-		    GREEN(rfb->palette[i]) == GREEN(pixel) &&
-		    BLUE(rfb->palette[i]) == BLUE(pixel)) {
+		} else if (!free && RED(client->palette[i]) == RED(pixel) &&
+		    GREEN(client->palette[i]) == GREEN(pixel) &&
+		    BLUE(client->palette[i]) == BLUE(pixel)) {
 			*buf = i;
 			return;
 		}
 	}
 
 	if (first_free_index != -1) {
-		rfb->palette[first_free_index] = PIXEL(255, RED(pixel), GREEN(pixel),
-		    BLUE(pixel));
-		rfb->palette_used = max(rfb->palette_used, (unsigned) first_free_index + 1);
+		client->palette[first_free_index] = PIXEL(255, RED(pixel),
+		    GREEN(pixel), BLUE(pixel));
+		client->palette_used = max(client->palette_used,
+		    (unsigned) first_free_index + 1);
 		*buf = first_free_index;
 		return;
 	}
@@ -283,12 +371,12 @@ static void rfb_encode_true_color(rfb_pixel_format_t *pf, void *buf,
 	}
 }
 
-static void rfb_encode_pixel(rfb_t *rfb, void *buf, pixel_t pixel)
+static void rfb_encode_pixel(rfb_client_t *client, void *buf, pixel_t pixel)
 {
-	if (rfb->pixel_format.true_color) {
-		rfb_encode_true_color(&rfb->pixel_format, buf, pixel);
+	if (client->pixel_format.true_color) {
+		rfb_encode_true_color(&client->pixel_format, buf, pixel);
 	} else {
-		rfb_encode_index(rfb, buf, pixel);
+		rfb_encode_index(client, buf, pixel);
 	}
 }
 
@@ -307,10 +395,10 @@ static void rfb_color_map_entry_to_be(rfb_color_map_entry_t *src,
 	dst->blue = host2uint16_t_be(src->blue);
 }
 
-static void *rfb_send_palette_message(rfb_t *rfb, size_t *psize)
+static void *rfb_send_palette_message(rfb_client_t *client, size_t *psize)
 {
 	size_t size = sizeof(rfb_set_color_map_entries_t) +
-	    rfb->palette_used * sizeof(rfb_color_map_entry_t);
+	    client->palette_used * sizeof(rfb_color_map_entry_t);
 
 	void *buf = malloc(size);
 	if (buf == NULL)
@@ -321,15 +409,15 @@ static void *rfb_send_palette_message(rfb_t *rfb, size_t *psize)
 	rfb_set_color_map_entries_t *scme = pos;
 	scme->message_type = RFB_SMSG_SET_COLOR_MAP_ENTRIES;
 	scme->first_color = 0;
-	scme->color_count = rfb->palette_used;
+	scme->color_count = client->palette_used;
 	rfb_set_color_map_entries_to_be(scme, scme);
 	pos += sizeof(rfb_set_color_map_entries_t);
 
 	rfb_color_map_entry_t *entries = pos;
-	for (unsigned i = 0; i < rfb->palette_used; i++) {
-		entries[i].red = 65535 * RED(rfb->palette[i]) / 255;
-		entries[i].green = 65535 * GREEN(rfb->palette[i]) / 255;
-		entries[i].blue = 65535 * BLUE(rfb->palette[i]) / 255;
+	for (unsigned i = 0; i < client->palette_used; i++) {
+		entries[i].red = 65535 * RED(client->palette[i]) / 255;
+		entries[i].green = 65535 * GREEN(client->palette[i]) / 255;
+		entries[i].blue = 65535 * BLUE(client->palette[i]) / 255;
 		rfb_color_map_entry_to_be(&entries[i], &entries[i]);
 	}
 
@@ -337,19 +425,20 @@ static void *rfb_send_palette_message(rfb_t *rfb, size_t *psize)
 	return buf;
 }
 
-static size_t rfb_rect_encode_raw(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
+static size_t rfb_rect_encode_raw(rfb_client_t *client, rfb_rectangle_t *rect,
+    void *buf)
 {
-	size_t pixel_size = rfb->pixel_format.bpp / 8;
+	size_t pixel_size = client->pixel_format.bpp / 8;
 	size_t size = (rect->width * rect->height * pixel_size);
 
 	if (buf == NULL)
 		return size;
 
 	for (uint16_t y = 0; y < rect->height; y++) {
+		pixel_t *row = pixelmap_pixel_at(&client->shadow, rect->x,
+		    rect->y + y);
 		for (uint16_t x = 0; x < rect->width; x++) {
-			pixel_t pixel = pixelmap_get_pixel(&rfb->framebuffer,
-			    x + rect->x, y + rect->y);
-			rfb_encode_pixel(rfb, buf, pixel);
+			rfb_encode_pixel(client, buf, row[x]);
 			buf += pixel_size;
 		}
 	}
@@ -396,11 +485,11 @@ static void cpixel_context_init(cpixel_ctx_t *ctx, rfb_pixel_format_t *pixel_for
 	}
 }
 
-static void cpixel_encode(rfb_t *rfb, cpixel_ctx_t *cpixel, void *buf,
-    pixel_t pixel)
+static void cpixel_encode(rfb_client_t *client, cpixel_ctx_t *cpixel,
+    void *buf, pixel_t pixel)
 {
 	uint8_t data[4];
-	rfb_encode_pixel(rfb, data, pixel);
+	rfb_encode_pixel(client, data, pixel);
 
 	switch (cpixel->compress_type) {
 	case COMP_NONE:
@@ -412,273 +501,1602 @@ static void cpixel_encode(rfb_t *rfb, cpixel_ctx_t *cpixel, void *buf,
 	}
 }
 
-static size_t rfb_tile_encode_raw(rfb_t *rfb, cpixel_ctx_t *cpixel,
-    rfb_rectangle_t *tile, void *buf)
+/** Colours of a tile */
+typedef struct {
+	pixel_t key[PALETTE_HASH];
+	uint8_t index[PALETTE_HASH];
+	bool used[PALETTE_HASH];
+	pixel_t colors[PALETTE_MAX];
+	size_t count;
+} tile_palette_t;
+
+/** Find slot of a colour in the palette hash table */
+static inline size_t tile_palette_slot(tile_palette_t *palette, pixel_t pixel)
 {
-	size_t size = tile->width * tile->height * cpixel->size;
-	if (buf == NULL)
-		return size;
+	size_t slot = (pixel * UINT32_C(2654435761)) >> 24;
 
-	for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
-		for (uint16_t x = tile->x; x < tile->x + tile->width; x++) {
-			pixel_t pixel = pixelmap_get_pixel(&rfb->framebuffer, x, y);
-			cpixel_encode(rfb, cpixel, buf, pixel);
-		}
-	}
+	/* The table is never more than half full */
+	while (palette->used[slot] && palette->key[slot] != pixel)
+		slot = (slot + 1) % PALETTE_HASH;
 
-	return size;
+	return slot;
 }
 
-static errno_t rfb_tile_encode_solid(rfb_t *rfb, cpixel_ctx_t *cpixel,
-    rfb_rectangle_t *tile, void *buf, size_t *size)
+/** Add colour to the palette
+ *
+ * @return False if the palette is full.
+ *
+ */
+static inline bool tile_palette_add(tile_palette_t *palette, pixel_t pixel)
 {
-	/* Check if it is single color */
-	pixel_t the_color = pixelmap_get_pixel(&rfb->framebuffer, tile->x, tile->y);
-	for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
-		for (uint16_t x = tile->x; x < tile->x + tile->width; x++) {
-			if (pixelmap_get_pixel(&rfb->framebuffer, x, y) != the_color)
-				return EINVAL;
-		}
-	}
-
-	/* OK, encode it */
-	if (buf)
-		cpixel_encode(rfb, cpixel, buf, the_color);
-	*size = cpixel->size;
-	return EOK;
+	size_t slot = tile_palette_slot(palette, pixel);
+	if (palette->used[slot])
+		return true;
+
+	if (palette->count == PALETTE_MAX)
+		return false;
+
+	palette->used[slot] = true;
+	palette->key[slot] = pixel;
+	palette->index[slot] = palette->count;
+	palette->colors[palette->count] = pixel;
+	palette->count++;
+	return true;
 }
 
-static size_t rfb_rect_encode_trle(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
+/** Number of bytes encoding the length of a run */
+static inline size_t rle_length_size(size_t length)
 {
-	cpixel_ctx_t cpixel;
-	cpixel_context_init(&cpixel, &rfb->pixel_format);
+	return (length - 1) / 255 + 1;
+}
 
-	size_t size = 0;
-	for (uint16_t y = 0; y < rect->height; y += 16) {
-		for (uint16_t x = 0; x < rect->width; x += 16) {
-			rfb_rectangle_t tile = {
-				.x = x,
-				.y = y,
-				.width = (x + 16 <= rect->width ? 16 : rect->width - x),
-				.height = (y + 16 <= rect->height ? 16 : rect->height - y)
-			};
+static inline uint8_t *rle_length_write(uint8_t *buf, size_t length)
+{
+	length--;
+	while (length >= 255) {
+		*buf++ = 255;
+		length -= 255;
+	}
 
-			size += 1;
-			uint8_t *tile_enctype_ptr = buf;
-			if (buf)
-				buf +=  1;
+	*buf++ = length;
+	return buf;
+}
 
-			uint8_t tile_enctype = RFB_TILE_ENCODING_SOLID;
-			size_t tile_size;
-			errno_t rc = rfb_tile_encode_solid(rfb, &cpixel, &tile, buf,
-			    &tile_size);
-			if (rc != EOK) {
-				tile_size = rfb_tile_encode_raw(rfb, &cpixel, &tile, buf);
-				tile_enctype = RFB_TILE_ENCODING_RAW;
+/** Encode one TRLE or ZRLE tile
+ *
+ * Both encodings share the subencodings of the tiles. The smallest of raw,
+ * solid, packed palette, plain RLE and palette RLE is used.
+ *
+ * @param client Client the tile is encoded for.
+ * @param cpixel Compressed pixel format.
+ * @param tile   Tile (in framebuffer coordinates).
+ * @param buf    Buffer of at least 1 + width * height * cpixel size bytes.
+ *
+ * @return Size of the encoded tile.
+ *
+ */
+static size_t rfb_tile_encode(rfb_client_t *client, cpixel_ctx_t *cpixel,
+    rfb_rectangle_t *tile, uint8_t *buf)
+{
+	pixelmap_t *fb = &client->shadow;
+	size_t cp = cpixel->size;
+	tile_palette_t palette;
+	bool palette_valid = true;
+
+	memset(palette.used, 0, sizeof(palette.used));
+	palette.count = 0;
+
+	/* Count the runs and the colours */
+	size_t runs = 0;
+	size_t run_bytes = 0;
+	size_t long_run_bytes = 0;
+	pixel_t prev = 0;
+	size_t length = 0;
+
+	for (uint16_t y = 0; y < tile->height; y++) {
+		pixel_t *row = pixelmap_pixel_at(fb, tile->x, tile->y + y);
+		for (uint16_t x = 0; x < tile->width; x++) {
+			pixel_t pixel = row[x] & RGB_MASK;
+			if (length > 0 && pixel == prev) {
+				length++;
+				continue;
 			}
 
-			if (buf) {
-				*tile_enctype_ptr = tile_enctype;
-				buf += tile_size;
+			if (length > 0) {
+				runs++;
+				run_bytes += rle_length_size(length);
+				if (length > 1)
+					long_run_bytes += rle_length_size(length);
 			}
+
+			if (palette_valid)
+				palette_valid = tile_palette_add(&palette, pixel);
+
+			prev = pixel;
+			length = 1;
 		}
 	}
-	return size;
-}
 
-static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
-    bool incremental)
-{
-	fibril_mutex_lock(&rfb->lock);
-	if (!incremental || !rfb->damage_valid) {
-		rfb->damage_rect.x = 0;
-		rfb->damage_rect.y = 0;
-		rfb->damage_rect.width = rfb->width;
-		rfb->damage_rect.height = rfb->height;
+	runs++;
+	run_bytes += rle_length_size(length);
+	if (length > 1)
+		long_run_bytes += rle_length_size(length);
+
+	size_t count = palette.count;
+
+	if (palette_valid && count == 1) {
+		buf[0] = RFB_TILE_ENCODING_SOLID;
+		cpixel_encode(client, cpixel, buf + 1, palette.colors[0]);
+		return 1 + cp;
 	}
 
-	/* We send only single raw rectangle right now */
-	size_t buf_size = sizeof(rfb_framebuffer_update_t) +
-	    sizeof(rfb_rectangle_t) * 1 +
-	    rfb_rect_encode_raw(rfb, &rfb->damage_rect, NULL);
+	/* Find the smallest subencoding */
+	uint8_t subencoding = RFB_TILE_ENCODING_RAW;
+	size_t best = tile->width * tile->height * cp;
+	unsigned int bits = 0;
+
+	if (palette_valid && count <= 16) {
+		bits = (count == 2) ? 1 : ((count <= 4) ? 2 : 4);
+		size_t size = count * cp +
+		    tile->height * ((tile->width * bits + 7) / 8);
+		if (size < best) {
+			best = size;
+			subencoding = count;
+		}
+	}
 
-	void *buf = malloc(buf_size);
-	if (buf == NULL) {
-		fibril_mutex_unlock(&rfb->lock);
-		return ENOMEM;
+	if (runs * cp + run_bytes < best) {
+		best = runs * cp + run_bytes;
+		subencoding = RFB_TILE_ENCODING_PLAIN_RLE;
 	}
-	memset(buf, 0, buf_size);
 
-	void *pos = buf;
-	rfb_framebuffer_update_t *fbu = buf;
-	fbu->message_type = RFB_SMSG_FRAMEBUFFER_UPDATE;
-	fbu->rect_count = 1;
-	rfb_framebuffer_update_to_be(fbu, fbu);
-	pos += sizeof(rfb_framebuffer_update_t);
+	if (palette_valid && count * cp + runs + long_run_bytes < best) {
+		best = count * cp + runs + long_run_bytes;
+		subencoding = RFB_TILE_ENCODING_PLAIN_RLE + count;
+	}
 
-	rfb_rectangle_t *rect = pos;
-	pos += sizeof(rfb_rectangle_t);
+	uint8_t *pos = buf;
+	*pos++ = subencoding;
 
-	*rect = rfb->damage_rect;
+	if (subencoding == RFB_TILE_ENCODING_RAW) {
+		for (uint16_t y = 0; y < tile->height; y++) {
+			pixel_t *row = pixelmap_pixel_at(fb, tile->x, tile->y + y);
+			for (uint16_t x = 0; x < tile->width; x++) {
+				cpixel_encode(client, cpixel, pos, row[x]);
+				pos += cp;
+			}
+		}
 
-	if (rfb->supports_trle) {
-		rect->enctype = RFB_ENCODING_TRLE;
-		pos += rfb_rect_encode_trle(rfb, rect, pos);
-	} else {
-		rect->enctype = RFB_ENCODING_RAW;
-		pos += rfb_rect_encode_raw(rfb, rect, pos);
+		return pos - buf;
 	}
-	rfb_rectangle_to_be(rect, rect);
 
-	rfb->damage_valid = false;
+	if (subencoding != RFB_TILE_ENCODING_PLAIN_RLE) {
+		for (size_t i = 0; i < count; i++) {
+			cpixel_encode(client, cpixel, pos, palette.colors[i]);
+			pos += cp;
+		}
+	}
 
-	size_t send_palette_size = 0;
-	void *send_palette = NULL;
+	if (subencoding <= 16) {
+		/* Packed palette, each row starts at a byte boundary */
+		for (uint16_t y = 0; y < tile->height; y++) {
+			pixel_t *row = pixelmap_pixel_at(fb, tile->x, tile->y + y);
+			uint8_t byte = 0;
+			unsigned int nbits = 0;
+
+			for (uint16_t x = 0; x < tile->width; x++) {
+				size_t slot = tile_palette_slot(&palette,
+				    row[x] & RGB_MASK);
+				byte = (byte << bits) | palette.index[slot];
+				nbits += bits;
+				if (nbits == 8) {
+					*pos++ = byte;
+					byte = 0;
+					nbits = 0;
+				}
+			}
 
-	if (!rfb->pixel_format.true_color) {
-		send_palette = rfb_send_palette_message(rfb, &send_palette_size);
-		if (send_palette == NULL) {
-			free(buf);
-			fibril_mutex_unlock(&rfb->lock);
-			return ENOMEM;
+			if (nbits > 0)
+				*pos++ = byte << (8 - nbits);
 		}
+
+		return pos - buf;
 	}
 
-	fibril_mutex_unlock(&rfb->lock);
+	/* Plain or palette RLE, the runs continue across rows */
+	length = 0;
+	for (uint16_t y = 0; y <= tile->height; y++) {
+		pixel_t *row = (y < tile->height) ?
+		    pixelmap_pixel_at(fb, tile->x, tile->y + y) : NULL;
+		uint16_t width = (y < tile->height) ? tile->width : 1;
+
+		for (uint16_t x = 0; x < width; x++) {
+			pixel_t pixel = (row != NULL) ? (row[x] & RGB_MASK) : 0;
+			if (row != NULL && length > 0 && pixel == prev) {
+				length++;
+				continue;
+			}
 
-	if (!rfb->pixel_format.true_color) {
-		errno_t rc = tcp_conn_send(conn, send_palette, send_palette_size);
-		if (rc != EOK) {
-			free(buf);
-			return rc;
+			if (length > 0) {
+				if (subencoding == RFB_TILE_ENCODING_PLAIN_RLE) {
+					cpixel_encode(client, cpixel, pos, prev);
+					pos += cp;
+					pos = rle_length_write(pos, length);
+				} else {
+					size_t slot = tile_palette_slot(&palette, prev);
+					if (length == 1) {
+						*pos++ = palette.index[slot];
+					} else {
+						*pos++ = palette.index[slot] | 128;
+						pos = rle_length_write(pos, length);
+					}
+				}
+			}
+
+			prev = pixel;
+			length = 1;
 		}
 	}
 
-	errno_t rc = tcp_conn_send(conn, buf, buf_size);
-	free(buf);
+	return pos - buf;
+}
 
-	return rc;
+/** Maximal size of an encoded band */
+static size_t rfb_band_size_max(rfb_client_t *client, rfb_rectangle_t *area)
+{
+	size_t tiles = ((area->width + RFB_TRLE_TILE_SIZE - 1) /
+	    RFB_TRLE_TILE_SIZE) * ((area->height + RFB_TRLE_TILE_SIZE - 1) /
+	    RFB_TRLE_TILE_SIZE);
+
+	return area->width * area->height * (client->pixel_format.bpp / 8) +
+	    tiles;
 }
 
-static errno_t rfb_set_pixel_format(rfb_t *rfb, rfb_pixel_format_t *pixel_format)
+/** Encode tiles of a band of a rectangle
+ *
+ * Bands are at most RFB_TILE_SIZE rows high and start at a tile
+ * boundary of the rectangle.
+ *
+ */
+static void rfb_band_encode(rfb_band_t *band)
 {
-	rfb->pixel_format = *pixel_format;
-	if (rfb->pixel_format.true_color) {
-		free(rfb->palette);
-		rfb->palette = NULL;
-		rfb->palette_used = 0;
-		log_msg(LOG_DEFAULT, LVL_DEBUG,
-		    "changed pixel format to %d-bit true color (%x<<%d, %x<<%d, %x<<%d)",
-		    pixel_format->depth, pixel_format->r_max, pixel_format->r_shift,
-		    pixel_format->g_max, pixel_format->g_shift, pixel_format->b_max,
-		    pixel_format->b_shift);
-	} else {
-		if (rfb->palette == NULL) {
-			rfb->palette = malloc(sizeof(pixel_t) * 256);
-			if (rfb->palette == NULL)
-				return ENOMEM;
-			memset(rfb->palette, 0, sizeof(pixel_t) * 256);
-			rfb->palette_used = 0;
+	rfb_client_t *client = band->client;
+
+	if (band->enctype == RFB_ENCODING_RAW) {
+		band->size = rfb_rect_encode_raw(client, &band->area, band->buf);
+		return;
+	}
+
+	uint16_t tile_size = (band->enctype == RFB_ENCODING_TRLE) ?
+	    RFB_TRLE_TILE_SIZE : RFB_TILE_SIZE;
+
+	cpixel_ctx_t cpixel;
+	cpixel_context_init(&cpixel, &client->pixel_format);
+
+	size_t size = 0;
+	for (uint16_t y = 0; y < band->area.height; y += tile_size) {
+		for (uint16_t x = 0; x < band->area.width; x += tile_size) {
+			rfb_rectangle_t tile = {
+				.x = band->area.x + x,
+				.y = band->area.y + y,
+				.width = min(tile_size, band->area.width - x),
+				.height = min(tile_size, band->area.height - y)
+			};
+
+			size += rfb_tile_encode(client, &cpixel, &tile,
+			    band->buf + size);
 		}
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "changed pixel format to %d-bit palette",
-		    pixel_format->depth);
 	}
-	return EOK;
+
+	band->size = size;
 }
 
-static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
+/** Encode bands of the current job until there are none left. */
+static void rfb_encode_next_bands(void)
 {
-	/* Version handshake */
-	errno_t rc = tcp_conn_send(conn, "RFB 003.008\n", 12);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server version: %s",
-		    str_error(rc));
-		return;
+	/* encode_mtx locked by caller */
+
+	while (encode_next < encode_count) {
+		rfb_band_t *band = &encode_bands[encode_next++];
+
+		fibril_mutex_unlock(&encode_mtx);
+		rfb_band_encode(band);
+		fibril_mutex_lock(&encode_mtx);
 	}
+}
 
-	char client_version[12];
-	rc = recv_chars(conn, client_version, 12);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client version: %s",
-		    str_error(rc));
-		return;
+static errno_t rfb_encode_worker(void *arg)
+{
+	unsigned int generation = 0;
+
+	fibril_mutex_lock(&encode_mtx);
+
+	while (true) {
+		while (encode_generation == generation)
+			fibril_condvar_wait(&encode_start_cv, &encode_mtx);
+
+		generation = encode_generation;
+		rfb_encode_next_bands();
+
+		if (--encode_busy == 0)
+			fibril_condvar_broadcast(&encode_done_cv);
 	}
 
-	if (memcmp(client_version, "RFB 003.008\n", 12) != 0) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Client version is not RFB 3.8");
+	return EOK;
+}
+
+/** Encode bands, in parallel if there are worker fibrils */
+static void rfb_encode_bands(rfb_band_t *bands, size_t count, bool parallel)
+{
+	if (!parallel || encode_workers == 0 || count < 2) {
+		for (size_t i = 0; i < count; i++) {
+			rfb_band_encode(&bands[i]);
+
+			/* Do not hold off damage from the visualizer */
+			fibril_yield();
+		}
+
 		return;
 	}
 
+	fibril_mutex_lock(&encode_mtx);
+
+	/* Wait for another update being encoded */
+	while (encode_bands != NULL)
+		fibril_condvar_wait(&encode_done_cv, &encode_mtx);
+
+	encode_bands = bands;
+	encode_count = count;
+	encode_next = 0;
+	encode_busy = encode_workers;
+	++encode_generation;
+	fibril_condvar_broadcast(&encode_start_cv);
+
+	/* Help the workers instead of just waiting for them. */
+	rfb_encode_next_bands();
+
+	while (encode_busy > 0)
+		fibril_condvar_wait(&encode_done_cv, &encode_mtx);
+
+	encode_bands = NULL;
+	fibril_condvar_broadcast(&encode_done_cv);
+	fibril_mutex_unlock(&encode_mtx);
+}
+
+/** Start fibrils encoding updates on more threads
+ *
+ * @param threads Total number of threads encoding an update.
+ *
+ */
+errno_t rfb_encoders_start(size_t threads)
+{
+	if (threads < 2)
+		return EOK;
+
 	/*
-	 * Security handshake
-	 * 1 security type supported, which is 1 - None
+	 * The fibril sending the update encodes bands as well, so one
+	 * worker fewer is needed. Note that with more threads, all fibrils
+	 * of the server may run in parallel.
 	 */
-	char sec_types[2];
-	sec_types[0] = 1; /* length */
-	sec_types[1] = RFB_SECURITY_NONE;
-	rc = tcp_conn_send(conn, sec_types, 2);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN,
-		    "Failed sending security handshake: %s", str_error(rc));
-		return;
-	}
+	fibril_enable_multithreaded();
 
-	char selected_sec_type = 0;
-	rc = recv_char(conn, &selected_sec_type);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving security type: %s",
-		    str_error(rc));
-		return;
-	}
-	if (selected_sec_type != RFB_SECURITY_NONE) {
-		log_msg(LOG_DEFAULT, LVL_WARN,
-		    "Client selected security type other than none");
-		return;
-	}
-	uint32_t security_result = RFB_SECURITY_HANDSHAKE_OK;
-	rc = tcp_conn_send(conn, &security_result, sizeof(uint32_t));
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending security result: %s",
-		    str_error(rc));
-		return;
+	for (size_t i = 1; i < threads; ++i) {
+		fid_t fid = fibril_create(rfb_encode_worker, NULL);
+		if (fid == 0)
+			break;
+
+		fibril_add_ready(fid);
+		++encode_workers;
 	}
 
-	/* Client init */
-	char shared_flag;
-	rc = recv_char(conn, &shared_flag);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client init: %s",
-		    str_error(rc));
-		return;
+	return EOK;
+}
+
+/** Make sure a buffer has at least the given size */
+static errno_t rfb_buffer_reserve(uint8_t **buf, size_t *size, size_t needed)
+{
+	if (*size >= needed)
+		return EOK;
+
+	size_t new_size = max(needed, *size * 2);
+	uint8_t *new_buf = realloc(*buf, new_size);
+	if (new_buf == NULL)
+		return ENOMEM;
+
+	*buf = new_buf;
+	*size = new_size;
+	return EOK;
+}
+
+/** Append data to the ZRLE stream of the client
+ *
+ * @param client Client.
+ * @param data   Uncompressed data.
+ * @param size   Size of the uncompressed data.
+ * @param flush  DEFLATE_SYNC_FLUSH at the end of a rectangle.
+ * @param zlen   Length of the compressed data in client->zbuf, updated.
+ *
+ */
+static errno_t rfb_zrle_append(rfb_client_t *client, const uint8_t *data,
+    size_t size, deflate_flush_t flush, size_t *zlen)
+{
+	size_t done = 0;
+
+	while (true) {
+		errno_t rc = rfb_buffer_reserve(&client->zbuf, &client->zbuf_size,
+		    *zlen + (size - done) / 2 + 1024);
+		if (rc != EOK)
+			return rc;
+
+		size_t avail = client->zbuf_size - *zlen;
+		size_t consumed;
+		size_t produced;
+		rc = deflate_stream_process(client->zstream, data + done,
+		    size - done, &consumed, client->zbuf + *zlen, avail,
+		    &produced, flush);
+		if (rc != EOK)
+			return rc;
+
+		done += consumed;
+		*zlen += produced;
+
+		/* All output has been returned once the buffer is not full */
+		if (done == size && produced < avail)
+			return EOK;
 	}
+}
 
-	/* Server init */
-	fibril_mutex_lock(&rfb->lock);
-	size_t name_length = str_length(rfb->name);
-	size_t msg_length = sizeof(rfb_server_init_t) + name_length;
-	rfb_server_init_t *server_init = malloc(msg_length);
-	if (server_init == NULL) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Cannot allocate memory for server init");
-		fibril_mutex_unlock(&rfb->lock);
-		return;
+/** Compress the bands of a ZRLE rectangle
+ *
+ * @param client Client.
+ * @param bands  Encoded bands of the rectangle.
+ * @param count  Number of bands.
+ * @param zlen   Length of the compressed data in client->zbuf, updated.
+ *
+ */
+static errno_t rfb_zrle_compress(rfb_client_t *client, rfb_band_t *bands,
+    size_t count, size_t *zlen)
+{
+	if (client->zstream == NULL) {
+		errno_t rc = deflate_stream_create(client->rfb->zlib_level,
+		    &client->zstream);
+		if (rc != EOK)
+			return rc;
 	}
-	server_init->width = rfb->width;
-	server_init->height = rfb->height;
-	server_init->pixel_format = rfb->pixel_format;
-	server_init->name_length = name_length;
-	rfb_server_init_to_be(server_init, server_init);
-	memcpy(server_init->name, rfb->name, name_length);
-	fibril_mutex_unlock(&rfb->lock);
-	rc = tcp_conn_send(conn, server_init, msg_length);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server init: %s",
-		    str_error(rc));
-		return;
+
+	if (!client->zstream_started) {
+		/* zlib header: deflate with 32 KiB window, no dictionary */
+		errno_t rc = rfb_buffer_reserve(&client->zbuf, &client->zbuf_size,
+		    *zlen + 2);
+		if (rc != EOK)
+			return rc;
+
+		client->zbuf[(*zlen)++] = 0x78;
+		client->zbuf[(*zlen)++] = 0x01;
+		client->zstream_started = true;
 	}
 
-	while (true) {
+	for (size_t i = 0; i < count; i++) {
+		errno_t rc = rfb_zrle_append(client, bands[i].buf, bands[i].size,
+		    (i + 1 < count) ? DEFLATE_NO_FLUSH : DEFLATE_SYNC_FLUSH, zlen);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+/** Hash of a row of pixels */
+static uint32_t rfb_row_hash(pixel_t *row, sysarg_t width)
+{
+	uint32_t hash = 2166136261;
+
+	for (sysarg_t x = 0; x < width; x++)
+		hash = (hash ^ row[x]) * 16777619;
+
+	return hash;
+}
+
+/** Read row of damage from the pixel map of the visualizer
+ *
+ * The pixel map is addressed cyclically from the offsets.
+ *
+ */
+static void rfb_damage_row(pixelmap_t *map, sysarg_t x_offset,
+    sysarg_t y_offset, sysarg_t x0, sysarg_t y, sysarg_t width, pixel_t *row)
+{
+	sysarg_t sx = (x0 + x_offset) % map->width;
+	sysarg_t sy = (y + y_offset) % map->height;
+	sysarg_t done = 0;
+
+	while (done < width) {
+		sysarg_t count = min(width - done, map->width - sx);
+		memcpy(row + done, pixelmap_pixel_at(map, sx, sy),
+		    count * sizeof(pixel_t));
+		done += count;
+		sx = 0;
+	}
+}
+
+/** Detect vertical scroll of the damaged area
+ *
+ * Rows of the old and the new content are hashed and the shift matching
+ * most of the rows is chosen. The longest band of rows the shift holds for
+ * is verified and returned.
+ *
+ * @param rfb    RFB server.
+ * @param map    Pixel map of the visualizer.
+ * @param dy     Shift found, the new row y is the old row y + dy.
+ * @param band_y First row of the band.
+ * @param band_h Number of rows of the band.
+ *
+ * @return True if a scroll worth sending as CopyRect has been found.
+ *
+ */
+static bool rfb_detect_scroll(rfb_t *rfb, pixelmap_t *map, sysarg_t x0,
+    sysarg_t y0, sysarg_t width, sysarg_t height, sysarg_t x_offset,
+    sysarg_t y_offset, int *dy, sysarg_t *band_y, sysarg_t *band_h)
+{
+	size_t table_size = 1;
+	while (table_size < 2 * height)
+		table_size <<= 1;
+
+	uint32_t *old_hash = malloc((2 * height + table_size) *
+	    sizeof(uint32_t) + 2 * height * sizeof(uint16_t));
+	if (old_hash == NULL)
+		return false;
+
+	uint32_t *new_hash = old_hash + height;
+	uint32_t *table = new_hash + height;
+	uint16_t *votes = (uint16_t *) (table + table_size);
+
+	memset(table, 0, table_size * sizeof(uint32_t));
+	memset(votes, 0, 2 * height * sizeof(uint16_t));
+
+	for (sysarg_t y = 0; y < height; y++) {
+		old_hash[y] = rfb_row_hash(pixelmap_pixel_at(&rfb->framebuffer,
+		    x0, y0 + y), width);
+
+		rfb_damage_row(map, x_offset, y_offset, x0, y0 + y, width,
+		    rfb->row);
+		new_hash[y] = rfb_row_hash(rfb->row, width);
+
+		/* Remember the first occurrence of each old row (index + 1) */
+		size_t slot = old_hash[y] & (table_size - 1);
+		while (table[slot] != 0 && old_hash[table[slot] - 1] != old_hash[y])
+			slot = (slot + 1) & (table_size - 1);
+
+		if (table[slot] == 0)
+			table[slot] = y + 1;
+	}
+
+	/* Vote for the shifts, ignoring unchanged and repeated rows */
+	for (sysarg_t y = 0; y < height; y++) {
+		if (new_hash[y] == old_hash[y])
+			continue;
+
+		if (y > 0 && new_hash[y] == new_hash[y - 1])
+			continue;
+
+		size_t slot = new_hash[y] & (table_size - 1);
+		while (table[slot] != 0 && old_hash[table[slot] - 1] != new_hash[y])
+			slot = (slot + 1) & (table_size - 1);
+
+		if (table[slot] != 0)
+			votes[(table[slot] - 1) + height - y]++;
+	}
+
+	size_t best = height;
+	for (size_t i = 0; i < 2 * height; i++) {
+		if (votes[i] > votes[best])
+			best = i;
+	}
+
+	int shift = (int) best - (int) height;
+	bool found = false;
+
+	if (shift != 0 && votes[best] > 0) {
+		/* Find the longest band of verified rows */
+		sysarg_t start = 0;
+		sysarg_t length = 0;
+
+		for (sysarg_t y = 0; y <= height; y++) {
+			bool match = false;
+			sysarg_t sy = y + shift;
+
+			if (y < height && sy < height &&
+			    new_hash[y] == old_hash[sy]) {
+				rfb_damage_row(map, x_offset, y_offset, x0, y0 + y,
+				    width, rfb->row);
+				match = memcmp(rfb->row, pixelmap_pixel_at(
+				    &rfb->framebuffer, x0, y0 + sy),
+				    width * sizeof(pixel_t)) == 0;
+			}
+
+			if (match) {
+				if (length == 0)
+					start = y;
+				length++;
+				continue;
+			}
+
+			if (length > *band_h) {
+				*band_y = y0 + start;
+				*band_h = length;
+			}
+
+			length = 0;
+		}
+
+		if (*band_h >= SCROLL_ROWS_MIN) {
+			*dy = shift;
+			found = true;
+		}
+	}
+
+	free(old_hash);
+	return found;
+}
+
+/** Check whether the client has changed tiles in an area */
+static bool rfb_client_dirty_in(rfb_client_t *client, sysarg_t x, sysarg_t y,
+    sysarg_t width, sysarg_t height)
+{
+	rfb_t *rfb = client->rfb;
+
+	for (size_t ty = y / RFB_TILE_SIZE;
+	    ty <= (y + height - 1) / RFB_TILE_SIZE; ty++) {
+		for (size_t tx = x / RFB_TILE_SIZE;
+		    tx <= (x + width - 1) / RFB_TILE_SIZE; tx++) {
+			if (client->dirty[ty * rfb->tiles_x + tx])
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/** Update the framebuffer from the pixel map of the visualizer
+ *
+ * Only tiles whose pixels actually change are marked as changed for the
+ * clients. If the content of a large area has moved vertically, clients
+ * supporting CopyRect get the move instead of the changed tiles.
+ *
+ * @param rfb      RFB server.
+ * @param map      Pixel map of the visualizer.
+ * @param x0       Left column of the damaged area.
+ * @param y0       Top row of the damaged area.
+ * @param width    Width of the damaged area.
+ * @param height   Height of the damaged area.
+ * @param x_offset Horizontal offset of the pixel map.
+ * @param y_offset Vertical offset of the pixel map.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the area is outside of the framebuffer.
+ *
+ */
+errno_t rfb_damage(rfb_t *rfb, pixelmap_t *map, sysarg_t x0, sysarg_t y0,
+    sysarg_t width, sysarg_t height, sysarg_t x_offset, sysarg_t y_offset)
+{
+	fibril_mutex_lock(&rfb->lock);
+
+	if (x0 + width > rfb->width || y0 + height > rfb->height) {
+		fibril_mutex_unlock(&rfb->lock);
+		return EINVAL;
+	}
+
+	if (width == 0 || height == 0) {
+		fibril_mutex_unlock(&rfb->lock);
+		return EOK;
+	}
+
+	bool copy_rect = false;
+	list_foreach(rfb->clients, link, rfb_client_t, client) {
+		if (client->supports_copy_rect && !client->copy_valid)
+			copy_rect = true;
+	}
+
+	int dy = 0;
+	sysarg_t band_y = 0;
+	sysarg_t band_h = 0;
+	bool scroll = false;
+
+	if (copy_rect && width >= RFB_TILE_SIZE && height >= 2 * SCROLL_ROWS_MIN) {
+		scroll = rfb_detect_scroll(rfb, map, x0, y0, width, height,
+		    x_offset, y_offset, &dy, &band_y, &band_h);
+	}
+
+	size_t tiles = rfb->tiles_x * rfb->tiles_y;
+	memset(rfb->changed, 0, tiles);
+	memset(rfb->changed_scrolled, 0, tiles);
+
+	for (sysarg_t y = y0; y < y0 + height; y++) {
+		pixel_t *dst = pixelmap_pixel_at(&rfb->framebuffer, x0, y);
+		uint8_t *changed = rfb->changed + (y / RFB_TILE_SIZE) * rfb->tiles_x;
+		uint8_t *changed_scrolled = rfb->changed_scrolled +
+		    (y / RFB_TILE_SIZE) * rfb->tiles_x;
+
+		/* Rows of the scroll do not change for the clients copying it */
+		bool scrolled = scroll && y >= band_y && y < band_y + band_h;
+
+		rfb_damage_row(map, x_offset, y_offset, x0, y, width, rfb->row);
+
+		sysarg_t x = x0;
+		while (x < x0 + width) {
+			sysarg_t tx = x / RFB_TILE_SIZE;
+			sysarg_t end = min(x0 + width, (tx + 1) * RFB_TILE_SIZE);
+
+			if (memcmp(dst + (x - x0), rfb->row + (x - x0),
+			    (end - x) * sizeof(pixel_t)) != 0) {
+				changed[tx] = 1;
+				if (!scrolled)
+					changed_scrolled[tx] = 1;
+			}
+
+			x = end;
+		}
+
+		memcpy(dst, rfb->row, width * sizeof(pixel_t));
+	}
+
+	struct timespec now;
+	getuptime(&now);
+
+	list_foreach(rfb->clients, link, rfb_client_t, client) {
+		bool copy = scroll && client->supports_copy_rect &&
+		    !client->copy_valid &&
+		    !rfb_client_dirty_in(client, x0, band_y + dy, width, band_h);
+		uint8_t *changed = copy ? rfb->changed_scrolled : rfb->changed;
+		bool pending = client->dirty_count > 0 || client->copy_valid;
+		bool signal = copy;
+
+		for (size_t ty = y0 / RFB_TILE_SIZE;
+		    ty <= (y0 + height - 1) / RFB_TILE_SIZE; ty++) {
+			for (size_t tx = x0 / RFB_TILE_SIZE;
+			    tx <= (x0 + width - 1) / RFB_TILE_SIZE; tx++) {
+				size_t tile = ty * rfb->tiles_x + tx;
+				if (changed[tile] && !client->dirty[tile]) {
+					client->dirty[tile] = 1;
+					client->dirty_count++;
+					signal = true;
+				}
+			}
+		}
+
+		if (copy) {
+			client->copy_valid = true;
+			client->copy_rect.x = x0;
+			client->copy_rect.y = band_y;
+			client->copy_rect.width = width;
+			client->copy_rect.height = band_h;
+			client->copy_rect.enctype = RFB_ENCODING_COPY_RECT;
+			client->copy_src_x = x0;
+			client->copy_src_y = band_y + dy;
+		}
+
+		if (!signal)
+			continue;
+
+		/*
+		 * The damage is merged with the damage the client has not
+		 * been sent yet, there is no queue of frames to fall behind.
+		 */
+		if (pending) {
+			client->stats.coalesced++;
+		} else {
+			client->damage_time = now;
+			fibril_condvar_broadcast(&client->update_cv);
+		}
+	}
+
+	fibril_mutex_unlock(&rfb->lock);
+	return EOK;
+}
+
+errno_t rfb_client_create(rfb_t *rfb, tcp_conn_t *conn, rfb_client_t **rclient)
+{
+	rfb_client_t *client = calloc(1, sizeof(rfb_client_t));
+	if (client == NULL)
+		return ENOMEM;
+
+	size_t tiles = rfb->tiles_x * rfb->tiles_y;
+	client->dirty = malloc(tiles);
+	client->shadow.data = malloc(rfb->width * rfb->height * sizeof(pixel_t));
+	if (client->dirty == NULL || client->shadow.data == NULL) {
+		free(client->dirty);
+		free(client->shadow.data);
+		free(client);
+		return ENOMEM;
+	}
+
+	link_initialize(&client->link);
+	fibril_mutex_initialize(&client->lock);
+	fibril_condvar_initialize(&client->update_cv);
+	client->rfb = rfb;
+	client->conn = conn;
+	client->shadow.width = rfb->width;
+	client->shadow.height = rfb->height;
+
+	fibril_mutex_lock(&rfb->lock);
+
+	/* The client has not seen anything yet */
+	memset(client->dirty, 1, tiles);
+	client->dirty_count = tiles;
+	getuptime(&client->damage_time);
+	client->pixel_format = rfb->pixel_format;
+	list_append(&client->link, &rfb->clients);
+
+	fibril_mutex_unlock(&rfb->lock);
+
+	*rclient = client;
+	return EOK;
+}
+
+void rfb_client_destroy(rfb_client_t *client)
+{
+	rfb_t *rfb = client->rfb;
+
+	fibril_mutex_lock(&rfb->lock);
+	list_remove(&client->link);
+	fibril_mutex_unlock(&rfb->lock);
+
+	if (client->zstream != NULL)
+		deflate_stream_destroy(client->zstream);
+
+	free(client->dirty);
+	free(client->shadow.data);
+	free(client->palette);
+	free(client->scratch);
+	free(client->zbuf);
+	free(client);
+}
+
+/** Send the pending CopyRect of the client as changed tiles instead */
+static void rfb_client_drop_copy(rfb_client_t *client)
+{
+	rfb_t *rfb = client->rfb;
+	rfb_rectangle_t *rect = &client->copy_rect;
+
+	/* rfb->lock locked by caller */
+
+	if (!client->copy_valid)
+		return;
+
+	for (size_t ty = rect->y / RFB_TILE_SIZE;
+	    ty <= (rect->y + rect->height - 1u) / RFB_TILE_SIZE; ty++) {
+		for (size_t tx = rect->x / RFB_TILE_SIZE;
+		    tx <= (rect->x + rect->width - 1u) / RFB_TILE_SIZE; tx++) {
+			size_t tile = ty * rfb->tiles_x + tx;
+			if (!client->dirty[tile]) {
+				client->dirty[tile] = 1;
+				client->dirty_count++;
+			}
+		}
+	}
+
+	client->copy_valid = false;
+}
+
+/** Build the rectangles of an update from the changed tiles
+ *
+ * Runs of changed tiles in a row are joined and runs spanning the same
+ * columns in consecutive rows are joined as well.
+ *
+ */
+static errno_t rfb_client_rects(rfb_client_t *client, rfb_rectangle_t *rects,
+    size_t *rcount)
+{
+	rfb_t *rfb = client->rfb;
+	size_t count = 0;
+
+	int *open = malloc(2 * rfb->tiles_x * sizeof(int));
+	if (open == NULL)
+		return ENOMEM;
+
+	int *prev = open;
+	int *cur = open + rfb->tiles_x;
+
+	for (size_t tx = 0; tx < rfb->tiles_x; tx++)
+		prev[tx] = -1;
+
+	for (size_t ty = 0; ty < rfb->tiles_y; ty++) {
+		uint8_t *dirty = client->dirty + ty * rfb->tiles_x;
+
+		for (size_t tx = 0; tx < rfb->tiles_x; tx++)
+			cur[tx] = -1;
+
+		size_t tx = 0;
+		while (tx < rfb->tiles_x) {
+			if (!dirty[tx]) {
+				tx++;
+				continue;
+			}
+
+			size_t start = tx;
+			while (tx < rfb->tiles_x && dirty[tx])
+				tx++;
+
+			uint16_t x = start * RFB_TILE_SIZE;
+			uint16_t y = ty * RFB_TILE_SIZE;
+			uint16_t width = min(tx * RFB_TILE_SIZE, rfb->width) - x;
+			uint16_t height = min(y + RFB_TILE_SIZE, rfb->height) - y;
+
+			if (prev[start] >= 0 && rects[prev[start]].width == width) {
+				rects[prev[start]].height += height;
+				cur[start] = prev[start];
+				continue;
+			}
+
+			rects[count].x = x;
+			rects[count].y = y;
+			rects[count].width = width;
+			rects[count].height = height;
+			cur[start] = count;
+			count++;
+		}
+
+		int *swap = prev;
+		prev = cur;
+		cur = swap;
+	}
+
+	free(open);
+	*rcount = count;
+	return EOK;
+}
+
+/** Take the damage of the client for an update
+ *
+ * The changed pixels are copied to the shadow framebuffer of the client,
+ * so the update can be encoded and sent without holding the lock of the
+ * server. Damage arriving meanwhile goes to the next update.
+ *
+ */
+static errno_t rfb_client_capture(rfb_client_t *client, bool incremental,
+    rfb_frame_t *frame)
+{
+	rfb_t *rfb = client->rfb;
+	size_t tiles = rfb->tiles_x * rfb->tiles_y;
+
+	/* rfb->lock locked by caller */
+
+	frame->damaged = client->dirty_count > 0 || client->copy_valid;
+	frame->damage_time = client->damage_time;
+
+	if (!incremental) {
+		memset(client->dirty, 1, tiles);
+		client->dirty_count = tiles;
+		client->copy_valid = false;
+	}
+
+	/* CopyRect goes first, changed tiles are encoded after the copy */
+	frame->rects = malloc((tiles + 1) * sizeof(rfb_rectangle_t));
+	if (frame->rects == NULL)
+		return ENOMEM;
+
+	frame->count = 0;
+	frame->copy = client->copy_valid;
+	if (frame->copy) {
+		frame->rects[0] = client->copy_rect;
+		frame->src_x = client->copy_src_x;
+		frame->src_y = client->copy_src_y;
+		frame->count = 1;
+	}
+
+	size_t tile_rects;
+	errno_t rc = rfb_client_rects(client, frame->rects + frame->count,
+	    &tile_rects);
+	if (rc != EOK) {
+		free(frame->rects);
+		return rc;
+	}
+
+	frame->pixels = 0;
+	for (size_t i = frame->count; i < frame->count + tile_rects; i++) {
+		rfb_rectangle_t *rect = &frame->rects[i];
+
+		for (uint16_t y = 0; y < rect->height; y++) {
+			memcpy(pixelmap_pixel_at(&client->shadow, rect->x,
+			    rect->y + y), pixelmap_pixel_at(&rfb->framebuffer,
+			    rect->x, rect->y + y), rect->width * sizeof(pixel_t));
+		}
+
+		frame->pixels += rect->width * rect->height;
+	}
+
+	frame->count += tile_rects;
+
+	memset(client->dirty, 0, tiles);
+	client->dirty_count = 0;
+	client->copy_valid = false;
+
+	return EOK;
+}
+
+/** Encode FramebufferUpdate message of captured damage */
+static errno_t rfb_client_encode(rfb_client_t *client, rfb_frame_t *frame,
+    rfb_codec_t codec, void **rbuf, size_t *rsize)
+{
+	rfb_rectangle_t *rects = frame->rects;
+	size_t count = frame->count;
+	int32_t enctype = rfb_codec_enctype[codec];
+	errno_t rc;
+
+	size_t *data_size = malloc((count + 1) * sizeof(size_t));
+	if (data_size == NULL)
+		return ENOMEM;
+
+	size_t first = frame->copy ? 1 : 0;
+
+	/* Split the rectangles into bands */
+	size_t band_count = 0;
+	for (size_t i = first; i < count; i++) {
+		rects[i].enctype = enctype;
+		band_count += (rects[i].height + RFB_TILE_SIZE - 1) / RFB_TILE_SIZE;
+	}
+
+	rfb_band_t *bands = malloc(band_count * sizeof(rfb_band_t) + 1);
+	if (bands == NULL) {
+		free(data_size);
+		return ENOMEM;
+	}
+
+	size_t scratch_size = 0;
+	size_t band = 0;
+	for (size_t i = first; i < count; i++) {
+		for (uint16_t y = 0; y < rects[i].height; y += RFB_TILE_SIZE) {
+			bands[band].client = client;
+			bands[band].enctype = enctype;
+			bands[band].area.x = rects[i].x;
+			bands[band].area.y = rects[i].y + y;
+			bands[band].area.width = rects[i].width;
+			bands[band].area.height = min(RFB_TILE_SIZE,
+			    rects[i].height - y);
+			bands[band].size = scratch_size;
+			scratch_size += rfb_band_size_max(client, &bands[band].area);
+			band++;
+		}
+	}
+
+	rc = rfb_buffer_reserve(&client->scratch, &client->scratch_size,
+	    scratch_size);
+	if (rc != EOK)
+		goto out;
+
+	for (size_t i = 0; i < band_count; i++)
+		bands[i].buf = client->scratch + bands[i].size;
+
+	/* Encoding to a colour map changes the palette, do it in order */
+	rfb_encode_bands(bands, band_count, client->pixel_format.true_color);
+
+	/* Compute sizes of the rectangles and compress ZRLE data */
+	size_t zlen = 0;
+	size_t size = sizeof(rfb_framebuffer_update_t);
+	band = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (rects[i].enctype == RFB_ENCODING_COPY_RECT) {
+			data_size[i] = sizeof(rfb_copy_rect_t);
+		} else {
+			size_t nbands = (rects[i].height + RFB_TILE_SIZE - 1) /
+			    RFB_TILE_SIZE;
+
+			if (enctype == RFB_ENCODING_ZRLE) {
+				size_t start = zlen;
+				rc = rfb_zrle_compress(client, bands + band, nbands,
+				    &zlen);
+				if (rc != EOK)
+					goto out;
+
+				data_size[i] = sizeof(uint32_t) + (zlen - start);
+			} else {
+				data_size[i] = 0;
+				for (size_t j = 0; j < nbands; j++)
+					data_size[i] += bands[band + j].size;
+			}
+
+			band += nbands;
+		}
+
+		size += sizeof(rfb_rectangle_t) + data_size[i];
+	}
+
+	uint8_t *buf = malloc(size);
+	if (buf == NULL) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	uint8_t *pos = buf;
+	rfb_framebuffer_update_t *fbu = (rfb_framebuffer_update_t *) pos;
+	fbu->message_type = RFB_SMSG_FRAMEBUFFER_UPDATE;
+	fbu->pad = 0;
+	fbu->rect_count = count;
+	rfb_framebuffer_update_to_be(fbu, fbu);
+	pos += sizeof(rfb_framebuffer_update_t);
+
+	band = 0;
+	zlen = 0;
+	for (size_t i = 0; i < count; i++) {
+		rfb_rectangle_t *rect = (rfb_rectangle_t *) pos;
+		*rect = rects[i];
+		rfb_rectangle_to_be(rect, rect);
+		pos += sizeof(rfb_rectangle_t);
+
+		if (rects[i].enctype == RFB_ENCODING_COPY_RECT) {
+			rfb_copy_rect_t *copy = (rfb_copy_rect_t *) pos;
+			copy->src_x = frame->src_x;
+			copy->src_y = frame->src_y;
+			rfb_copy_rect_to_be(copy, copy);
+			pos += sizeof(rfb_copy_rect_t);
+			continue;
+		}
+
+		size_t nbands = (rects[i].height + RFB_TILE_SIZE - 1) /
+		    RFB_TILE_SIZE;
+
+		if (enctype == RFB_ENCODING_ZRLE) {
+			uint32_t length = data_size[i] - sizeof(uint32_t);
+			length = host2uint32_t_be(length);
+			memcpy(pos, &length, sizeof(uint32_t));
+			pos += sizeof(uint32_t);
+
+			memcpy(pos, client->zbuf + zlen, data_size[i] -
+			    sizeof(uint32_t));
+			zlen += data_size[i] - sizeof(uint32_t);
+			pos += data_size[i] - sizeof(uint32_t);
+		} else {
+			for (size_t j = 0; j < nbands; j++) {
+				memcpy(pos, bands[band + j].buf, bands[band + j].size);
+				pos += bands[band + j].size;
+			}
+		}
+
+		band += nbands;
+	}
+
+	*rbuf = buf;
+	*rsize = size;
+	rc = EOK;
+
+out:
+	free(bands);
+	free(data_size);
+	return rc;
+}
+
+/** Capture and encode an update
+ *
+ * @param client      Client.
+ * @param incremental False to encode the whole framebuffer.
+ * @param codec       Encoding of the update.
+ * @param frame       Place to store the damage the update consists of.
+ * @param rbuf        Place to store the FramebufferUpdate message.
+ * @param rsize       Place to store size of the message.
+ *
+ */
+static errno_t rfb_client_frame(rfb_client_t *client, bool incremental,
+    rfb_codec_t codec, rfb_frame_t *frame, void **rbuf, size_t *rsize)
+{
+	rfb_t *rfb = client->rfb;
+
+	/* client->lock locked by caller */
+
+	fibril_mutex_lock(&rfb->lock);
+	errno_t rc = rfb_client_capture(client, incremental, frame);
+	fibril_mutex_unlock(&rfb->lock);
+	if (rc != EOK)
+		return rc;
+
+	rc = rfb_client_encode(client, frame, codec, rbuf, rsize);
+	free(frame->rects);
+	frame->rects = NULL;
+	return rc;
+}
+
+/** Update measured cost of an encoding */
+static void rfb_codec_stats_update(rfb_codec_stats_t *stats, size_t pixels,
+    size_t size, usec_t time)
+{
+	if (pixels == 0)
+		return;
+
+	uint64_t sample_size = ((uint64_t) size << 20) / pixels;
+	uint64_t sample_time = ((uint64_t) time << 20) / pixels;
+
+	if (!stats->valid) {
+		stats->size = sample_size;
+		stats->time = sample_time;
+		stats->valid = true;
+	} else {
+		stats->size = (3 * stats->size + sample_size) / 4;
+		stats->time = (3 * stats->time + sample_time) / 4;
+	}
+}
+
+/** Choose the encoding of the next update
+ *
+ * Until the bandwidth to the client is known, the best compression the
+ * client supports is used. Then the encoding with the shortest estimated
+ * time of encoding and transferring the update wins. Every
+ * RFB_PROBE_FRAMES updates another encoding is tried to keep its cost
+ * up to date.
+ *
+ */
+static rfb_codec_t rfb_client_codec(rfb_client_t *client)
+{
+	bool supported[RFB_CODEC_COUNT] = {
+		[RFB_CODEC_RAW] = true,
+		[RFB_CODEC_TRLE] = client->supports_trle,
+		[RFB_CODEC_ZRLE] = client->supports_zrle
+	};
+
+	rfb_codec_t best = RFB_CODEC_RAW;
+	for (rfb_codec_t codec = 0; codec < RFB_CODEC_COUNT; codec++) {
+		if (supported[codec])
+			best = codec;
+	}
+
+	if (client->bandwidth == 0)
+		return best;
+
+	for (rfb_codec_t codec = 0; codec < RFB_CODEC_COUNT; codec++) {
+		if (supported[codec] && !client->codecs[codec].valid)
+			return codec;
+	}
+
+	if (++client->probe_frames >= RFB_PROBE_FRAMES) {
+		client->probe_frames = 0;
+		do {
+			client->probe_codec = (client->probe_codec + 1) %
+			    RFB_CODEC_COUNT;
+		} while (!supported[client->probe_codec]);
+
+		return client->probe_codec;
+	}
+
+	uint64_t best_cost = UINT64_MAX;
+	for (rfb_codec_t codec = 0; codec < RFB_CODEC_COUNT; codec++) {
+		if (!supported[codec])
+			continue;
+
+		/* Microseconds per 2^20 pixels */
+		uint64_t cost = client->codecs[codec].time +
+		    client->codecs[codec].size * 1000000 / client->bandwidth;
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = codec;
+		}
+	}
+
+	return best;
+}
+
+/** Encode update of the tiles changed since the last update of the client
+ *
+ * @param client      Client.
+ * @param incremental False to encode the whole framebuffer.
+ * @param rbuf        Place to store the FramebufferUpdate message.
+ * @param rsize       Place to store size of the message.
+ *
+ * @return EOK on success.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t rfb_client_update(rfb_client_t *client, bool incremental,
+    void **rbuf, size_t *rsize)
+{
+	rfb_frame_t frame;
+
+	fibril_mutex_lock(&client->lock);
+	errno_t rc = rfb_client_frame(client, incremental,
+	    rfb_client_codec(client), &frame, rbuf, rsize);
+	fibril_mutex_unlock(&client->lock);
+	return rc;
+}
+
+static void rfb_client_log_stats(rfb_client_t *client, log_level_t level)
+{
+	fibril_mutex_lock(&client->rfb->lock);
+	rfb_client_stats_t stats = client->stats;
+	fibril_mutex_unlock(&client->rfb->lock);
+
+	if (stats.frames == 0)
+		return;
+
+	log_msg(LOG_DEFAULT, level, "Client %p: %" PRIu64 " updates, %"
+	    PRIu64 " coalesced, %" PRIu64 " bytes/update, latency avg %lld us "
+	    "max %lld us, encoding %lld us/update, sending %lld us/update, "
+	    "bandwidth %" PRIu64 " KiB/s", client, stats.frames, stats.coalesced,
+	    stats.bytes / stats.frames, stats.latency / stats.frames,
+	    stats.latency_max, stats.encode_time / stats.frames,
+	    stats.send_time / stats.frames, client->bandwidth / 1024);
+}
+
+static errno_t rfb_send_framebuffer_update(rfb_client_t *client,
+    bool incremental)
+{
+	rfb_t *rfb = client->rfb;
+	struct timespec start;
+	struct timespec encoded;
+	struct timespec sent;
+	rfb_frame_t frame;
+	void *buf;
+	size_t buf_size;
+
+	fibril_mutex_lock(&client->lock);
+
+	rfb_codec_t codec = rfb_client_codec(client);
+
+	getuptime(&start);
+	errno_t rc = rfb_client_frame(client, incremental, codec, &frame, &buf,
+	    &buf_size);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&client->lock);
+		return rc;
+	}
+
+	size_t send_palette_size = 0;
+	void *send_palette = NULL;
+
+	if (!client->pixel_format.true_color) {
+		send_palette = rfb_send_palette_message(client, &send_palette_size);
+		if (send_palette == NULL) {
+			free(buf);
+			fibril_mutex_unlock(&client->lock);
+			return ENOMEM;
+		}
+	}
+
+	getuptime(&encoded);
+	usec_t encode_time = NSEC2USEC(ts_sub_diff(&encoded, &start));
+	rfb_codec_stats_update(&client->codecs[codec], frame.pixels, buf_size,
+	    encode_time);
+
+	fibril_mutex_unlock(&client->lock);
+
+	/* A slow client blocks here, its damage keeps merging meanwhile */
+	if (send_palette != NULL) {
+		rc = tcp_conn_send(client->conn, send_palette, send_palette_size);
+		free(send_palette);
+		if (rc != EOK) {
+			free(buf);
+			return rc;
+		}
+	}
+
+	rc = tcp_conn_send(client->conn, buf, buf_size);
+	free(buf);
+	if (rc != EOK)
+		return rc;
+
+	getuptime(&sent);
+	usec_t send_time = NSEC2USEC(ts_sub_diff(&sent, &encoded));
+
+	/* Small updates fit in the send buffers and say little */
+	if (buf_size >= BANDWIDTH_SAMPLE_MIN) {
+		uint64_t bandwidth = (uint64_t) buf_size * 1000000 /
+		    max(send_time, 1);
+
+		fibril_mutex_lock(&client->lock);
+		if (client->bandwidth == 0)
+			client->bandwidth = bandwidth;
+		else
+			client->bandwidth = (3 * client->bandwidth + bandwidth) / 4;
+		fibril_mutex_unlock(&client->lock);
+	}
+
+	fibril_mutex_lock(&rfb->lock);
+
+	rfb_client_stats_t *stats = &client->stats;
+	stats->frames++;
+	stats->bytes += buf_size;
+	stats->encode_time += encode_time;
+	stats->send_time += send_time;
+
+	if (frame.damaged) {
+		usec_t latency = NSEC2USEC(ts_sub_diff(&sent, &frame.damage_time));
+		stats->latency += latency;
+		stats->latency_max = max(stats->latency_max, latency);
+	}
+
+	bool log = (stats->frames % RFB_STATS_FRAMES) == 0;
+	fibril_mutex_unlock(&rfb->lock);
+
+	if (log)
+		rfb_client_log_stats(client, LVL_DEBUG);
+
+	return EOK;
+}
+
+/** Check whether an update can be sent to the client */
+static bool rfb_client_ready(rfb_client_t *client)
+{
+	/* rfb->lock locked by caller */
+
+	if (!client->update_requested)
+		return false;
+
+	return !client->update_incremental || client->dirty_count > 0 ||
+	    client->copy_valid;
+}
+
+/** Send updates to the client
+ *
+ * Updates are encoded only when the client has asked for one and the
+ * previous one has been sent, so a slow client gets the latest union of
+ * the damage instead of a queue of stale frames. Updates are sent at most
+ * once per RFB_FRAME_INTERVAL to let damage of a frame coalesce.
+ *
+ */
+static errno_t rfb_client_sender(void *arg)
+{
+	rfb_client_t *client = (rfb_client_t *) arg;
+	rfb_t *rfb = client->rfb;
+
+	fibril_mutex_lock(&rfb->lock);
+
+	while (!client->closing) {
+		if (!rfb_client_ready(client)) {
+			fibril_condvar_wait(&client->update_cv, &rfb->lock);
+			continue;
+		}
+
+		struct timespec now;
+		getuptime(&now);
+		usec_t elapsed = NSEC2USEC(ts_sub_diff(&now, &client->frame_time));
+		if (elapsed < RFB_FRAME_INTERVAL) {
+			fibril_condvar_wait_timeout(&client->update_cv, &rfb->lock,
+			    RFB_FRAME_INTERVAL - elapsed);
+			continue;
+		}
+
+		bool incremental = client->update_incremental;
+		client->update_requested = false;
+		client->frame_time = now;
+		fibril_mutex_unlock(&rfb->lock);
+
+		errno_t rc = rfb_send_framebuffer_update(client, incremental);
+
+		fibril_mutex_lock(&rfb->lock);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending update: %s",
+			    str_error(rc));
+			break;
+		}
+	}
+
+	client->sender_running = false;
+	fibril_condvar_broadcast(&client->update_cv);
+	fibril_mutex_unlock(&rfb->lock);
+
+	return EOK;
+}
+
+static errno_t rfb_set_pixel_format(rfb_client_t *client,
+    rfb_pixel_format_t *pixel_format)
+{
+	client->pixel_format = *pixel_format;
+	if (client->pixel_format.true_color) {
+		free(client->palette);
+		client->palette = NULL;
+		client->palette_used = 0;
+		log_msg(LOG_DEFAULT, LVL_DEBUG,
+		    "changed pixel format to %d-bit true color (%x<<%d, %x<<%d, %x<<%d)",
+		    pixel_format->depth, pixel_format->r_max, pixel_format->r_shift,
+		    pixel_format->g_max, pixel_format->g_shift, pixel_format->b_max,
+		    pixel_format->b_shift);
+	} else {
+		if (client->palette == NULL) {
+			client->palette = malloc(sizeof(pixel_t) * 256);
+			if (client->palette == NULL)
+				return ENOMEM;
+			memset(client->palette, 0, sizeof(pixel_t) * 256);
+			client->palette_used = 0;
+		}
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "changed pixel format to %d-bit palette",
+		    pixel_format->depth);
+	}
+	return EOK;
+}
+
+static void rfb_socket_connection(rfb_client_t *client)
+{
+	rfb_t *rfb = client->rfb;
+	tcp_conn_t *conn = client->conn;
+
+	/* Version handshake */
+	errno_t rc = tcp_conn_send(conn, "RFB 003.008\n", 12);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server version: %s",
+		    str_error(rc));
+		return;
+	}
+
+	char client_version[12];
+	rc = recv_chars(client, client_version, 12);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client version: %s",
+		    str_error(rc));
+		return;
+	}
+
+	if (memcmp(client_version, "RFB 003.008\n", 12) != 0) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Client version is not RFB 3.8");
+		return;
+	}
+
+	/*
+	 * Security handshake
+	 * 1 security type supported, which is 1 - None
+	 */
+	char sec_types[2];
+	sec_types[0] = 1; /* length */
+	sec_types[1] = RFB_SECURITY_NONE;
+	rc = tcp_conn_send(conn, sec_types, 2);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN,
+		    "Failed sending security handshake: %s", str_error(rc));
+		return;
+	}
+
+	char selected_sec_type = 0;
+	rc = recv_char(client, &selected_sec_type);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving security type: %s",
+		    str_error(rc));
+		return;
+	}
+	if (selected_sec_type != RFB_SECURITY_NONE) {
+		log_msg(LOG_DEFAULT, LVL_WARN,
+		    "Client selected security type other than none");
+		return;
+	}
+	uint32_t security_result = RFB_SECURITY_HANDSHAKE_OK;
+	rc = tcp_conn_send(conn, &security_result, sizeof(uint32_t));
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending security result: %s",
+		    str_error(rc));
+		return;
+	}
+
+	/* Client init */
+	char shared_flag;
+	rc = recv_char(client, &shared_flag);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client init: %s",
+		    str_error(rc));
+		return;
+	}
+
+	/* Server init */
+	fibril_mutex_lock(&rfb->lock);
+	size_t name_length = str_length(rfb->name);
+	size_t msg_length = sizeof(rfb_server_init_t) + name_length;
+	rfb_server_init_t *server_init = malloc(msg_length);
+	if (server_init == NULL) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Cannot allocate memory for server init");
+		fibril_mutex_unlock(&rfb->lock);
+		return;
+	}
+	server_init->width = rfb->width;
+	server_init->height = rfb->height;
+	server_init->pixel_format = rfb->pixel_format;
+	server_init->name_length = name_length;
+	rfb_server_init_to_be(server_init, server_init);
+	memcpy(server_init->name, rfb->name, name_length);
+	fibril_mutex_unlock(&rfb->lock);
+	rc = tcp_conn_send(conn, server_init, msg_length);
+	free(server_init);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server init: %s",
+		    str_error(rc));
+		return;
+	}
+
+	while (true) {
 		char message_type = 0;
-		rc = recv_char(conn, &message_type);
+		rc = recv_char(client, &message_type);
 		if (rc != EOK) {
 			log_msg(LOG_DEFAULT, LVL_WARN,
 			    "Failed receiving client message type: %s",
@@ -694,7 +2112,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 		rfb_client_cut_text_t cct;
 		switch (message_type) {
 		case RFB_CMSG_SET_PIXEL_FORMAT:
-			rc = recv_message(conn, message_type, &spf, sizeof(spf));
+			rc = recv_message(client, message_type, &spf, sizeof(spf));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -703,14 +2121,14 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			}
 			rfb_pixel_format_to_host(&spf.pixel_format, &spf.pixel_format);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received SetPixelFormat message");
-			fibril_mutex_lock(&rfb->lock);
-			rc = rfb_set_pixel_format(rfb, &spf.pixel_format);
-			fibril_mutex_unlock(&rfb->lock);
+			fibril_mutex_lock(&client->lock);
+			rc = rfb_set_pixel_format(client, &spf.pixel_format);
+			fibril_mutex_unlock(&client->lock);
 			if (rc != EOK)
 				return;
 			break;
 		case RFB_CMSG_SET_ENCODINGS:
-			rc = recv_message(conn, message_type, &se, sizeof(se));
+			rc = recv_message(client, message_type, &se, sizeof(se));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -719,21 +2137,43 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			}
 			rfb_set_encodings_to_host(&se, &se);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received SetEncodings message");
+
+			bool trle = false;
+			bool zrle = false;
+			bool copy_rect = false;
 			for (uint16_t i = 0; i < se.count; i++) {
 				int32_t encoding = 0;
-				rc = recv_chars(conn, (char *) &encoding, sizeof(int32_t));
+				rc = recv_chars(client, (char *) &encoding, sizeof(int32_t));
 				if (rc != EOK)
 					return;
 				encoding = uint32_t_be2host(encoding);
 				if (encoding == RFB_ENCODING_TRLE) {
 					log_msg(LOG_DEFAULT, LVL_DEBUG,
 					    "Client supports TRLE encoding");
-					rfb->supports_trle = true;
+					trle = true;
+				} else if (encoding == RFB_ENCODING_ZRLE) {
+					log_msg(LOG_DEFAULT, LVL_DEBUG,
+					    "Client supports ZRLE encoding");
+					zrle = true;
+				} else if (encoding == RFB_ENCODING_COPY_RECT) {
+					log_msg(LOG_DEFAULT, LVL_DEBUG,
+					    "Client supports CopyRect encoding");
+					copy_rect = true;
 				}
 			}
+
+			fibril_mutex_lock(&client->lock);
+			fibril_mutex_lock(&rfb->lock);
+			client->supports_trle = trle;
+			client->supports_zrle = zrle;
+			client->supports_copy_rect = copy_rect;
+			if (!copy_rect)
+				rfb_client_drop_copy(client);
+			fibril_mutex_unlock(&rfb->lock);
+			fibril_mutex_unlock(&client->lock);
 			break;
 		case RFB_CMSG_FRAMEBUFFER_UPDATE_REQUEST:
-			rc = recv_message(conn, message_type, &fbur, sizeof(fbur));
+			rc = recv_message(client, message_type, &fbur, sizeof(fbur));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -743,10 +2183,19 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			rfb_framebuffer_update_request_to_host(&fbur, &fbur);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2,
 			    "Received FramebufferUpdateRequest message");
-			rfb_send_framebuffer_update(rfb, conn, fbur.incremental);
+
+			/* A pending full update stays full */
+			fibril_mutex_lock(&rfb->lock);
+			if (!client->update_requested)
+				client->update_incremental = true;
+			if (!fbur.incremental)
+				client->update_incremental = false;
+			client->update_requested = true;
+			fibril_condvar_broadcast(&client->update_cv);
+			fibril_mutex_unlock(&rfb->lock);
 			break;
 		case RFB_CMSG_KEY_EVENT:
-			rc = recv_message(conn, message_type, &ke, sizeof(ke));
+			rc = recv_message(client, message_type, &ke, sizeof(ke));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -757,7 +2206,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received KeyEvent message");
 			break;
 		case RFB_CMSG_POINTER_EVENT:
-			rc = recv_message(conn, message_type, &pe, sizeof(pe));
+			rc = recv_message(client, message_type, &pe, sizeof(pe));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -768,7 +2217,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received PointerEvent message");
 			break;
 		case RFB_CMSG_CLIENT_CUT_TEXT:
-			rc = recv_message(conn, message_type, &cct, sizeof(cct));
+			rc = recv_message(client, message_type, &cct, sizeof(cct));
 			if (rc != EOK) {
 				log_msg(LOG_DEFAULT, LVL_WARN,
 				    "Failed receiving client message: %s",
@@ -777,7 +2226,7 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			}
 			rfb_client_cut_text_to_host(&cct, &cct);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Received ClientCutText message");
-			recv_skip_chars(conn, cct.length);
+			recv_skip_chars(client, cct.length);
 			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_WARN,
@@ -825,8 +2274,34 @@ static void rfb_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 	rfb_t *rfb = (rfb_t *)tcp_listener_userptr(lst);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Connection accepted");
 
-	rbuf_out = 0;
-	rbuf_in = 0;
+	rfb_client_t *client;
+	errno_t rc = rfb_client_create(rfb, conn, &client);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Cannot allocate client: %s",
+		    str_error(rc));
+		return;
+	}
+
+	/* Updates are sent by a fibril of their own, see rfb_client_sender() */
+	fid_t sender = fibril_create(rfb_client_sender, client);
+	if (sender == 0) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Cannot create sender fibril");
+		rfb_client_destroy(client);
+		return;
+	}
+
+	client->sender_running = true;
+	fibril_add_ready(sender);
+
+	rfb_socket_connection(client);
+
+	fibril_mutex_lock(&rfb->lock);
+	client->closing = true;
+	fibril_condvar_broadcast(&client->update_cv);
+	while (client->sender_running)
+		fibril_condvar_wait(&client->update_cv, &rfb->lock);
+	fibril_mutex_unlock(&rfb->lock);
 
-	rfb_socket_connection(rfb, conn);
+	rfb_client_log_stats(client, LVL_NOTE);
+	rfb_client_destroy(client);
 }
@@ -29,9 +29,12 @@
 #ifndef RFB_H__
 #define RFB_H__
 
+#include <adt/list.h>
+#include <deflate.h>
 #include <inet/tcp.h>
 #include <io/pixelmap.h>
 #include <fibril_synch.h>
+#include <time.h>
 
 #define RFB_SECURITY_NONE 1
 #define RFB_SECURITY_HANDSHAKE_OK 0
@@ -49,10 +52,34 @@
 #define RFB_SMSG_SERVER_CUT_TEXT 3
 
 #define RFB_ENCODING_RAW 0
+#define RFB_ENCODING_COPY_RECT 1
 #define RFB_ENCODING_TRLE 15
+#define RFB_ENCODING_ZRLE 16
 
 #define RFB_TILE_ENCODING_RAW 0
 #define RFB_TILE_ENCODING_SOLID 1
+#define RFB_TILE_ENCODING_PLAIN_RLE 128
+
+/** Size of the tiles damage is tracked in (also the size of ZRLE tiles) */
+#define RFB_TILE_SIZE 64
+
+/** Size of the tiles of TRLE encoding */
+#define RFB_TRLE_TILE_SIZE 16
+
+/** Maximal number of threads encoding an update */
+#define RFB_THREADS_MAX 16
+
+/** Buffer for receiving client messages */
+#define RFB_RBUF_SIZE 1024
+
+/** Shortest interval between updates sent to a client (in microseconds) */
+#define RFB_FRAME_INTERVAL 16666
+
+/** Number of updates after which other encodings are measured again */
+#define RFB_PROBE_FRAMES 64
+
+/** Number of updates after which the client statistics are logged */
+#define RFB_STATS_FRAMES 1024
 
 typedef struct {
 	uint8_t bpp;
@@ -133,6 +160,11 @@ typedef struct {
 	uint16_t rect_count;
 } __attribute__((packed)) rfb_framebuffer_update_t;
 
+typedef struct {
+	uint16_t src_x;
+	uint16_t src_y;
+} __attribute__((packed)) rfb_copy_rect_t;
+
 typedef struct {
 	uint8_t message_type;
 	uint8_t pad;
@@ -154,16 +186,125 @@ typedef struct {
 	tcp_t *tcp;
 	tcp_listener_t *lst;
 	pixelmap_t framebuffer;
-	rfb_rectangle_t damage_rect;
-	bool damage_valid;
+	/** Number of damage tracking tiles in a row and in a column */
+	size_t tiles_x;
+	size_t tiles_y;
+	/** Tiles changed by the damage being applied (scratch) */
+	uint8_t *changed;
+	/** Tiles changed outside of the detected scroll (scratch) */
+	uint8_t *changed_scrolled;
+	/** Row of the damage being applied (scratch) */
+	pixel_t *row;
+	/** Connected clients (rfb_client_t) */
+	list_t clients;
 	fibril_mutex_t lock;
+	/** Compression level of ZRLE */
+	unsigned int zlib_level;
+} rfb_t;
+
+/** Encodings an update can be sent with */
+typedef enum {
+	RFB_CODEC_RAW,
+	RFB_CODEC_TRLE,
+	RFB_CODEC_ZRLE,
+	RFB_CODEC_COUNT
+} rfb_codec_t;
+
+/** Measured cost of an encoding (averaged over the recent updates) */
+typedef struct {
+	bool valid;
+	/** Encoded size of 2^20 pixels (in bytes) */
+	uint64_t size;
+	/** Time of encoding 2^20 pixels (in microseconds) */
+	uint64_t time;
+} rfb_codec_stats_t;
+
+/** Counters of updates sent to a client */
+typedef struct {
+	/** Updates sent */
+	uint64_t frames;
+	/** Damage merged into an update which has not been sent yet */
+	uint64_t coalesced;
+	/** Bytes sent */
+	uint64_t bytes;
+	/** Sum and maximum of the time from damage to sending its update */
+	usec_t latency;
+	usec_t latency_max;
+	/** Time spent encoding and sending the updates */
+	usec_t encode_time;
+	usec_t send_time;
+} rfb_client_stats_t;
+
+typedef struct {
+	/** Link in rfb_t.clients */
+	link_t link;
+	rfb_t *rfb;
+	tcp_conn_t *conn;
+	char rbuf[RFB_RBUF_SIZE];
+	size_t rbuf_out;
+	size_t rbuf_in;
+	/**
+	 * Serializes encoding of updates with changes of the pixel format
+	 * and of the encodings. The encodings are changed with rfb_t.lock
+	 * held as well.
+	 */
+	fibril_mutex_t lock;
+	rfb_pixel_format_t pixel_format;
 	pixel_t *palette;
 	size_t palette_used;
 	bool supports_trle;
-} rfb_t;
+	bool supports_zrle;
+	bool supports_copy_rect;
+	/** Copy of the framebuffer updates are encoded from */
+	pixelmap_t shadow;
+	/** Cost of the encodings and bandwidth (in bytes per second) */
+	rfb_codec_stats_t codecs[RFB_CODEC_COUNT];
+	uint64_t bandwidth;
+	unsigned int probe_frames;
+	rfb_codec_t probe_codec;
+	/** Stream all ZRLE rectangles to the client are compressed with */
+	deflate_stream_t *zstream;
+	bool zstream_started;
+	/** Buffers reused by the updates */
+	uint8_t *scratch;
+	size_t scratch_size;
+	uint8_t *zbuf;
+	size_t zbuf_size;
+
+	/* Protected by rfb_t.lock */
+
+	/** Tiles changed since the last update sent to the client */
+	uint8_t *dirty;
+	size_t dirty_count;
+	/** When the oldest damage not sent yet has arrived */
+	struct timespec damage_time;
+	rfb_client_stats_t stats;
+	/** Scroll to be sent as CopyRect before the changed tiles */
+	bool copy_valid;
+	rfb_rectangle_t copy_rect;
+	uint16_t copy_src_x;
+	uint16_t copy_src_y;
+	/** Signalled when there is an update to send or the client closes */
+	fibril_condvar_t update_cv;
+	/** The client waits for an update (and whether it is incremental) */
+	bool update_requested;
+	bool update_incremental;
+	/** When the last update has been sent */
+	struct timespec frame_time;
+	/** The sender fibril of the client should exit and whether it runs */
+	bool closing;
+	bool sender_running;
+} rfb_client_t;
 
 extern errno_t rfb_init(rfb_t *, uint16_t, uint16_t, const char *);
 extern errno_t rfb_set_size(rfb_t *, uint16_t, uint16_t);
 extern errno_t rfb_listen(rfb_t *, uint16_t);
+extern errno_t rfb_encoders_start(size_t);
+extern errno_t rfb_damage(rfb_t *, pixelmap_t *, sysarg_t, sysarg_t, sysarg_t,
+    sysarg_t, sysarg_t, sysarg_t);
+
+extern errno_t rfb_client_create(rfb_t *, tcp_conn_t *, rfb_client_t **);
+extern void rfb_client_destroy(rfb_client_t *);
+extern errno_t rfb_client_update(rfb_client_t *, bool, void **, size_t *);
 
 #endif
@@ -59,6 +59,8 @@ static errno_t handle_log_level_change(sysarg_t new_level)
 
 	log_unlock(log);
 
+	writers_refresh_levels();
+
 	return EOK;
 }
 
@@ -82,12 +84,18 @@ void logger_connection_handler_control(ipc_call_t *icall)
 		switch (IPC_GET_IMETHOD(call)) {
 		case LOGGER_CONTROL_SET_DEFAULT_LEVEL:
 			rc = set_default_logging_level(IPC_GET_ARG1(call));
+			if (rc == EOK)
+				writers_refresh_levels();
 			async_answer_0(&call, rc);
 			break;
 		case LOGGER_CONTROL_SET_LOG_LEVEL:
 			rc = handle_log_level_change(IPC_GET_ARG1(call));
 			async_answer_0(&call, rc);
 			break;
+		case LOGGER_CONTROL_FLUSH:
+			flush_logs();
+			async_answer_0(&call, EOK);
+			break;
 		case LOGGER_CONTROL_SET_ROOT:
 			rc = vfs_receive_handle(true, &fd);
 			if (rc == EOK) {
@@ -38,6 +38,7 @@
 #include <adt/list.h>
 #include <adt/prodcons.h>
 #include <io/log.h>
+#include <ipc/logger.h>
 #include <async.h>
 #include <stdbool.h>
 #include <fibril_synch.h>
@@ -46,6 +47,9 @@
 #define NAME "logger"
 #define LOG_LEVEL_USE_DEFAULT (LVL_LIMIT + 1)
 
+/** Interval of writing buffered messages out to the log files */
+#define LOGGER_FLUSH_INTERVAL 1000000
+
 #ifdef LOGGER_LOG
 #define logger_log(fmt, ...) printf(NAME ": " fmt, ##__VA_ARGS__)
 #else
@@ -58,6 +62,8 @@ typedef struct {
 	fibril_mutex_t guard;
 	char *filename;
 	FILE *logfile;
+	/** Messages were written since the last flush */
+	bool dirty;
 } logger_dest_t;
 
 struct logger_log {
@@ -74,7 +80,7 @@ struct logger_log {
 	logger_dest_t *dest;
 };
 
-#define MAX_REFERENCED_LOGS_PER_CLIENT 100
+#define MAX_REFERENCED_LOGS_PER_CLIENT LOGGER_RING_MAX_LOGS
 
 typedef struct {
 	size_t logs_count;
@@ -84,9 +90,11 @@ typedef struct {
 logger_log_t *find_log_by_name_and_lock(const char *name);
 logger_log_t *find_or_create_log_and_lock(const char *, sysarg_t);
 logger_log_t *find_log_by_id_and_lock(sysarg_t);
+log_level_t get_log_level(logger_log_t *);
 bool shall_log_message(logger_log_t *, log_level_t);
 void log_unlock(logger_log_t *);
 void write_to_log(logger_log_t *, log_level_t, const char *);
+void flush_logs(void);
 void log_release(logger_log_t *);
 
 void registered_logs_init(logger_registered_logs_t *);
@@ -98,6 +106,7 @@ errno_t set_default_logging_level(log_level_t);
 
 void logger_connection_handler_control(ipc_call_t *);
 void logger_connection_handler_writer(ipc_call_t *);
+void writers_refresh_levels(void);
 
 void parse_initial_settings(void);
 void parse_level_settings(char *);
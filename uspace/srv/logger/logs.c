@@ -59,6 +59,7 @@ static errno_t create_dest(const char *name, logger_dest_t **dest)
 		return ENOMEM;
 	}
 	result->logfile = NULL;
+	result->dirty = false;
 	fibril_mutex_initialize(&result->guard);
 	*dest = result;
 	return EOK;
@@ -183,14 +184,19 @@ static log_level_t get_actual_log_level(logger_log_t *log)
 	return log->logged_level;
 }
 
-bool shall_log_message(logger_log_t *log, log_level_t level)
+log_level_t get_log_level(logger_log_t *log)
 {
 	fibril_mutex_lock(&log_list_guard);
-	bool result = level <= get_actual_log_level(log);
+	log_level_t result = get_actual_log_level(log);
 	fibril_mutex_unlock(&log_list_guard);
 	return result;
 }
 
+bool shall_log_message(logger_log_t *log, log_level_t level)
+{
+	return level <= get_log_level(log);
+}
+
 void log_unlock(logger_log_t *log)
 {
 	assert(fibril_mutex_is_locked(&log->guard));
@@ -294,12 +300,43 @@ void write_to_log(logger_log_t *log, log_level_t level, const char *message)
 		fprintf(log->dest->logfile, "[%s] %s: %s\n",
 		    log->full_name, log_level_str(level),
 		    (const char *) message);
-		fflush(log->dest->logfile);
+
+		/*
+		 * Output is flushed periodically by flush_logs(), except
+		 * for errors, which might precede a crash.
+		 */
+		if (level <= LVL_ERROR) {
+			fflush(log->dest->logfile);
+			log->dest->dirty = false;
+		} else {
+			log->dest->dirty = true;
+		}
 	}
 
 	fibril_mutex_unlock(&log->dest->guard);
 }
 
+/** Write buffered messages of all logs out to the log files. */
+void flush_logs(void)
+{
+	fibril_mutex_lock(&log_list_guard);
+
+	list_foreach(log_list, link, logger_log_t, log) {
+		/* Sublogs share the destination of their top-level log. */
+		if (log->parent != NULL)
+			continue;
+
+		fibril_mutex_lock(&log->dest->guard);
+		if (log->dest->dirty) {
+			fflush(log->dest->logfile);
+			log->dest->dirty = false;
+		}
+		fibril_mutex_unlock(&log->dest->guard);
+	}
+
+	fibril_mutex_unlock(&log_list_guard);
+}
+
 void registered_logs_init(logger_registered_logs_t *logs)
 {
 	logs->logs_count = 0;
@@ -43,6 +43,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <fibril.h>
 #include <str_error.h>
 #include "logger.h"
 
@@ -56,6 +57,16 @@ static void connection_handler_writer(ipc_call_t *icall, void *arg)
 	logger_connection_handler_writer(icall);
 }
 
+static errno_t flush_fibril(void *arg)
+{
+	while (true) {
+		fibril_usleep(LOGGER_FLUSH_INTERVAL);
+		flush_logs();
+	}
+
+	return EOK;
+}
+
 int main(int argc, char *argv[])
 {
 	printf(NAME ": HelenOS Logging Service\n");
@@ -81,6 +92,13 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
+	fid_t fid = fibril_create(flush_fibril, NULL);
+	if (fid == 0) {
+		printf("%s: Failed to create flush fibril.\n", NAME);
+		return -1;
+	}
+	fibril_add_ready(fid);
+
 	printf("%s: Accepting connections\n", NAME);
 	async_manager();
 
@@ -39,14 +39,73 @@
 #include <io/log.h>
 #include <io/logctl.h>
 #include <io/klog.h>
+#include <io/logfmt.h>
 #include <ns.h>
+#include <as.h>
 #include <async.h>
 #include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <str.h>
 #include <str_error.h>
 #include "logger.h"
 
+/** Longest message taken from a message ring (including the NUL). */
+#define RING_MESSAGE_MAX 4096
+
+/** Maximum number of binary record formats registered by a client. */
+#define MAX_FORMATS_PER_CLIENT 1024
+
+/** Writer client */
+typedef struct {
+	/** Link to writers */
+	link_t link;
+	/** Logs created by the client */
+	logger_registered_logs_t logs;
+	/** Message ring shared by the client or @c NULL */
+	logger_ring_t *ring;
+	/** Our copy of ring->tail, the client can write the ring */
+	unsigned int ring_tail;
+	/** Number of entries of ring->levels kept up to date */
+	size_t levels_count;
+	/** Formats of binary records, format id is index + 1 */
+	char **formats;
+	/** Number of registered formats */
+	size_t formats_count;
+	/** Copy of the message being written out */
+	char message[RING_MESSAGE_MAX];
+	/** Copy of the arguments of the binary record being written out */
+	uint8_t args[RING_MESSAGE_MAX];
+} logger_writer_t;
+
+/** Writers with a message ring, protected by writers_guard. */
+static LIST_INITIALIZE(writers);
+static FIBRIL_MUTEX_INITIALIZE(writers_guard);
+
+/** Publish current levels of a writer's logs in its ring.
+ *
+ * Must be called with writers_guard held.
+ */
+static void writer_publish_levels(logger_writer_t *writer)
+{
+	for (size_t i = 0; i < writer->levels_count; i++) {
+		atomic_store_explicit(&writer->ring->levels[i],
+		    get_log_level(writer->logs.logs[i]), memory_order_relaxed);
+	}
+}
+
+/** Publish levels of all logs to the clients after a level change. */
+void writers_refresh_levels(void)
+{
+	fibril_mutex_lock(&writers_guard);
+	list_foreach(writers, link, logger_writer_t, writer)
+		writer_publish_levels(writer);
+	fibril_mutex_unlock(&writers_guard);
+}
+
 static logger_log_t *handle_create_log(sysarg_t parent)
 {
 	void *name;
@@ -61,6 +120,188 @@ static logger_log_t *handle_create_log(sysarg_t parent)
 	return log;
 }
 
+/** Write out a message.
+ *
+ * Must be called with the log locked and only if shall_log_message().
+ */
+static void write_message(logger_log_t *log, sysarg_t level,
+    const char *message)
+{
+	KLOG_PRINTF(level, "[%s] %s: %s",
+	    log->full_name, log_level_str(level), message);
+	write_to_log(log, level, message);
+}
+
+static void ring_detach(logger_writer_t *writer)
+{
+	fibril_mutex_lock(&writers_guard);
+	list_remove(&writer->link);
+	fibril_mutex_unlock(&writers_guard);
+
+	as_area_destroy(writer->ring);
+	writer->ring = NULL;
+}
+
+static logger_log_t *writer_find_log(logger_writer_t *writer, sysarg_t log_id)
+{
+	for (size_t i = 0; i < writer->logs.logs_count; i++) {
+		if ((sysarg_t) writer->logs.logs[i] == log_id)
+			return writer->logs.logs[i];
+	}
+
+	return NULL;
+}
+
+/** Get the message of a ring record.
+ *
+ * Binary records are formatted here, so this is only done for messages
+ * that are actually written out.
+ *
+ * @param writer Writer owning the ring.
+ * @param hdr Copy of the record header.
+ * @param data Record data in the ring.
+ * @return @c false if the record is broken.
+ */
+static bool ring_message(logger_writer_t *writer, logger_ring_rec_t *hdr,
+    const void *data)
+{
+	size_t size = hdr->size - sizeof(logger_ring_rec_t);
+
+	if (hdr->format == 0) {
+		size_t len = min(size, RING_MESSAGE_MAX);
+		if (len == 0)
+			return false;
+
+		memcpy(writer->message, data, len);
+		writer->message[len - 1] = '\0';
+		return true;
+	}
+
+	if (hdr->format > writer->formats_count)
+		return false;
+
+	/* The arguments are formatted from a private copy. */
+	size = min(size, RING_MESSAGE_MAX);
+	memcpy(writer->args, data, size);
+
+	if (log_fmt_format(writer->message, RING_MESSAGE_MAX,
+	    writer->formats[hdr->format - 1], writer->args, size) != EOK)
+		return false;
+
+	str_rtrim(writer->message, '\n');
+	return true;
+}
+
+/** Write out all messages in the writer's ring.
+ *
+ * The ring is shared with the client, so every record is checked
+ * and the message copied out before use. Only the head is taken from
+ * the ring, if it is further than the size of the ring ahead of us,
+ * the records in between are dropped. A client that breaks the records
+ * loses the ring.
+ */
+static void ring_drain(logger_writer_t *writer)
+{
+	logger_ring_t *ring = writer->ring;
+	unsigned int tail = writer->ring_tail;
+	unsigned int head = atomic_load_explicit(&ring->head,
+	    memory_order_acquire);
+
+	if (head % LOGGER_RING_ALIGN != 0) {
+		logger_log("writer: broken message ring.\n");
+		ring_detach(writer);
+		return;
+	}
+
+	if (head - tail > LOGGER_RING_DATA_SIZE) {
+		logger_log("writer: message ring overrun, %u bytes of records "
+		    "dropped.\n", head - tail);
+		writer->ring_tail = head;
+		atomic_store_explicit(&ring->tail, head, memory_order_release);
+		return;
+	}
+
+	while (tail != head) {
+		size_t offset = tail % LOGGER_RING_DATA_SIZE;
+		logger_ring_rec_t *rec = (logger_ring_rec_t *) &ring->data[offset];
+		logger_ring_rec_t hdr = *rec;
+
+		if ((hdr.size < sizeof(logger_ring_rec_t)) ||
+		    (hdr.size % LOGGER_RING_ALIGN != 0) ||
+		    (hdr.size > LOGGER_RING_DATA_SIZE - offset) ||
+		    (hdr.size > head - tail)) {
+			logger_log("writer: broken message ring.\n");
+			ring_detach(writer);
+			return;
+		}
+
+		logger_log_t *log = writer_find_log(writer, hdr.log);
+		if (log != NULL) {
+			fibril_mutex_lock(&log->guard);
+			if (shall_log_message(log, hdr.level)) {
+				if (ring_message(writer, &hdr, rec + 1))
+					write_message(log, hdr.level, writer->message);
+				else
+					logger_log("writer: broken record.\n");
+			}
+			log_unlock(log);
+		}
+
+		tail += hdr.size;
+		writer->ring_tail = tail;
+		atomic_store_explicit(&ring->tail, tail, memory_order_release);
+	}
+}
+
+/** Drain the ring and tell the client to notify us of new messages. */
+static void ring_drain_and_wait(logger_writer_t *writer)
+{
+	while (writer->ring != NULL) {
+		ring_drain(writer);
+		if (writer->ring == NULL)
+			break;
+
+		/*
+		 * Re-check the ring after announcing that we wait, as the
+		 * client might have missed the announcement.
+		 */
+		atomic_store(&writer->ring->waiting, 1);
+		if (atomic_load(&writer->ring->head) == writer->ring_tail)
+			break;
+		atomic_store(&writer->ring->waiting, 0);
+	}
+}
+
+static errno_t handle_share_ring(logger_writer_t *writer)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+	void *ring;
+
+	if (!async_share_out_receive(&call, &size, &flags))
+		return EINVAL;
+
+	if ((writer->ring != NULL) || (size < sizeof(logger_ring_t))) {
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	errno_t rc = async_share_out_finalize(&call, &ring);
+	if ((rc != EOK) || (ring == AS_MAP_FAILED))
+		return ENOMEM;
+
+	writer->ring = ring;
+	writer->ring_tail = atomic_load(&writer->ring->tail);
+
+	fibril_mutex_lock(&writers_guard);
+	list_append(&writer->link, &writers);
+	writer_publish_levels(writer);
+	fibril_mutex_unlock(&writers_guard);
+
+	return EOK;
+}
+
 static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level)
 {
 	logger_log_t *log = find_log_by_id_and_lock(log_id);
@@ -72,16 +313,8 @@ static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level)
 	if (rc != EOK)
 		goto leave;
 
-	if (!shall_log_message(log, level)) {
-		rc = EOK;
-		goto leave;
-	}
-
-	KLOG_PRINTF(level, "[%s] %s: %s",
-	    log->full_name, log_level_str(level),
-	    (const char *) message);
-	write_to_log(log, level, message);
-
+	if (shall_log_message(log, level))
+		write_message(log, level, message);
 	rc = EOK;
 
 leave:
@@ -91,21 +324,72 @@ leave:
 	return rc;
 }
 
+static errno_t handle_register_format(logger_writer_t *writer,
+    sysarg_t *id)
+{
+	char *fmt;
+	errno_t rc = async_data_write_accept((void **) &fmt, true, 1,
+	    RING_MESSAGE_MAX, 0, NULL);
+	if (rc != EOK)
+		return rc;
+
+	/* Only formats we can check the arguments against are accepted. */
+	uint8_t args[LOG_FMT_MAX_ARGS];
+	size_t nargs;
+	rc = log_fmt_parse(fmt, args, NULL, &nargs);
+	if (rc != EOK)
+		goto error;
+
+	if (writer->formats_count == MAX_FORMATS_PER_CLIENT) {
+		rc = ELIMIT;
+		goto error;
+	}
+
+	char **formats = realloc(writer->formats,
+	    (writer->formats_count + 1) * sizeof(char *));
+	if (formats == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	formats[writer->formats_count++] = fmt;
+	writer->formats = formats;
+	*id = writer->formats_count;
+	return EOK;
+
+error:
+	free(fmt);
+	return rc;
+}
+
 void logger_connection_handler_writer(ipc_call_t *icall)
 {
 	logger_log_t *log;
+	sysarg_t id;
 	errno_t rc;
 
+	logger_writer_t *writer = malloc(sizeof(logger_writer_t));
+	if (writer == NULL) {
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
 	/* Acknowledge the connection. */
 	async_accept_0(icall);
 
 	logger_log("writer: new client.\n");
 
-	logger_registered_logs_t registered_logs;
-	registered_logs_init(&registered_logs);
+	link_initialize(&writer->link);
+	registered_logs_init(&writer->logs);
+	writer->ring = NULL;
+	writer->levels_count = 0;
+	writer->formats = NULL;
+	writer->formats_count = 0;
 
 	while (true) {
 		ipc_call_t call;
+
+		ring_drain_and_wait(writer);
 		async_get_call(&call);
 
 		if (!IPC_GET_IMETHOD(call)) {
@@ -120,26 +404,64 @@ void logger_connection_handler_writer(ipc_call_t *icall)
 				async_answer_0(&call, ENOMEM);
 				break;
 			}
-			if (!register_log(&registered_logs, log)) {
+			if (!register_log(&writer->logs, log)) {
 				log_unlock(log);
 				async_answer_0(&call, ELIMIT);
 				break;
 			}
 			log_unlock(log);
-			async_answer_1(&call, EOK, (sysarg_t) log);
+
+			fibril_mutex_lock(&writers_guard);
+			writer->levels_count = writer->logs.logs_count;
+			if (writer->ring != NULL)
+				writer_publish_levels(writer);
+			fibril_mutex_unlock(&writers_guard);
+
+			async_answer_2(&call, EOK, (sysarg_t) log,
+			    writer->logs.logs_count - 1);
 			break;
 		case LOGGER_WRITER_MESSAGE:
+			/* Messages in the ring were sent earlier. */
+			if (writer->ring != NULL)
+				ring_drain(writer);
 			rc = handle_receive_message(IPC_GET_ARG1(call),
 			    IPC_GET_ARG2(call));
 			async_answer_0(&call, rc);
 			break;
+		case LOGGER_WRITER_SHARE_RING:
+			rc = handle_share_ring(writer);
+			async_answer_0(&call, rc);
+			break;
+		case LOGGER_WRITER_REGISTER_FORMAT:
+			id = 0;
+			rc = handle_register_format(writer, &id);
+			async_answer_1(&call, rc, id);
+			break;
+		case LOGGER_WRITER_RING_NOTIFY:
+			/* The ring is drained before waiting for the next call. */
+			async_answer_0(&call, EOK);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 			break;
 		}
 	}
 
-	unregister_logs(&registered_logs);
+	if (writer->ring != NULL) {
+		ring_drain(writer);
+		if (writer->ring != NULL)
+			ring_detach(writer);
+	}
+
+	unregister_logs(&writer->logs);
+	for (size_t i = 0; i < writer->formats_count; i++)
+		free(writer->formats[i]);
+	free(writer->formats);
+	free(writer);
+
+	/* Do not keep the last words of the client in the buffers. */
+	flush_logs();
+
 	logger_log("writer: client terminated.\n");
 }
 
@@ -101,7 +101,7 @@ errno_t ethip_iplink_init(ethip_nic_t *nic)
 	static unsigned link_num = 0;
 	char *svc_name = NULL;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_iplink_init()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_iplink_init()");
 
 	iplink_srv_init(&nic->iplink);
 	nic->iplink.ops = &ethip_iplink_ops;
@@ -147,7 +147,7 @@ static void ethip_client_conn(ipc_call_t *icall, void *arg)
 	service_id_t sid;
 
 	sid = (service_id_t) IPC_GET_ARG2(*icall);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_client_conn(%u)", (unsigned)sid);
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_client_conn(%u)", (unsigned)sid);
 	nic = ethip_nic_find_by_iplink_sid(sid);
 	if (nic == NULL) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Uknown service ID.");
@@ -159,19 +159,19 @@ static void ethip_client_conn(ipc_call_t *icall, void *arg)
 
 static errno_t ethip_open(iplink_srv_t *srv)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_open()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_open()");
 	return EOK;
 }
 
 static errno_t ethip_close(iplink_srv_t *srv)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_close()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_close()");
 	return EOK;
 }
 
 static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_send()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_send()");
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 	eth_frame_t frame;
@@ -202,7 +202,7 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 
 static errno_t ethip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_send6()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_send6()");
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 	eth_frame_t frame;
@@ -227,15 +227,15 @@ static errno_t ethip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
 
 errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_received(): srv=%p", srv);
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_received(): srv=%p", srv);
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, " - eth_pdu_decode");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, " - eth_pdu_decode");
 
 	eth_frame_t frame;
 	errno_t rc = eth_pdu_decode(data, size, &frame);
 	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, " - eth_pdu_decode failed");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, " - eth_pdu_decode failed");
 		return rc;
 	}
 
@@ -246,21 +246,21 @@ errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
 		arp_received(nic, &frame);
 		break;
 	case ETYPE_IP:
-		log_msg(LOG_DEFAULT, LVL_DEBUG, " - construct SDU");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, " - construct SDU");
 		sdu.data = frame.data;
 		sdu.size = frame.size;
-		log_msg(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
 		rc = iplink_ev_recv(&nic->iplink, &sdu, ip_v4);
 		break;
 	case ETYPE_IPV6:
-		log_msg(LOG_DEFAULT, LVL_DEBUG, " - construct SDU IPv6");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, " - construct SDU IPv6");
 		sdu.data = frame.data;
 		sdu.size = frame.size;
-		log_msg(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
 		rc = iplink_ev_recv(&nic->iplink, &sdu, ip_v6);
 		break;
 	default:
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Unknown ethertype 0x%" PRIx16,
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Unknown ethertype 0x%" PRIx16,
 		    frame.etype_len);
 	}
 
@@ -270,14 +270,14 @@ errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
 
 static errno_t ethip_get_mtu(iplink_srv_t *srv, size_t *mtu)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_get_mtu()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_get_mtu()");
 	*mtu = 1500;
 	return EOK;
 }
 
 static errno_t ethip_get_mac48(iplink_srv_t *srv, addr48_t *mac)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_get_mac48()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_get_mac48()");
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 	addr48(nic->mac_addr, *mac);
@@ -287,7 +287,7 @@ static errno_t ethip_get_mac48(iplink_srv_t *srv, addr48_t *mac)
 
 static errno_t ethip_set_mac48(iplink_srv_t *srv, addr48_t *mac)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_set_mac48()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_set_mac48()");
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 	addr48(*mac, nic->mac_addr);
@@ -91,7 +91,7 @@ static errno_t ethip_nic_check_new(void)
 		}
 
 		if (!already_known) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "Found NIC '%lu'",
+			log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Found NIC '%lu'",
 			    (unsigned long) svcs[i]);
 			rc = ethip_nic_open(svcs[i]);
 			if (rc != EOK)
@@ -151,7 +151,7 @@ static errno_t ethip_nic_open(service_id_t sid)
 	bool in_list = false;
 	nic_address_t nic_address;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_open()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_open()");
 	ethip_nic_t *nic = ethip_nic_new();
 	if (nic == NULL)
 		return ENOMEM;
@@ -177,7 +177,7 @@ static errno_t ethip_nic_open(service_id_t sid)
 		goto error;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "Opened NIC '%s'", nic->svc_name);
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Opened NIC '%s'", nic->svc_name);
 	list_append(&nic->link, &ethip_nic_list);
 	in_list = true;
 
@@ -208,7 +208,7 @@ static errno_t ethip_nic_open(service_id_t sid)
 		goto error;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "Initialized IP link service,");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Initialized IP link service,");
 
 	return EOK;
 
@@ -236,11 +236,11 @@ static void ethip_nic_addr_changed(ethip_nic_t *nic, ipc_call_t *call)
 
 	rc = async_data_write_accept((void **) &addr, false, 0, 0, 0, &size);
 	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
 		return;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_changed(): "
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_changed(): "
 	    "new addr=%02x:%02x:%02x:%02x:%02x:%02x",
 	    addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
 
@@ -248,7 +248,7 @@ static void ethip_nic_addr_changed(ethip_nic_t *nic, ipc_call_t *call)
 
 	rc = iplink_ev_change_addr(&nic->iplink, &nic->mac_addr);
 	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "iplink_ev_change_addr() failed");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "iplink_ev_change_addr() failed");
 		return;
 	}
 
@@ -262,29 +262,29 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	void *data;
 	size_t size;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received() nic=%p", nic);
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received() nic=%p", nic);
 
 	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
 	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
 		return;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "Ethernet PDU contents (%zu bytes)",
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Ethernet PDU contents (%zu bytes)",
 	    size);
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "call ethip_received");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "call ethip_received");
 	rc = ethip_received(&nic->iplink, data, size);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "free data");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "free data");
 	free(data);
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received() done, rc=%s", str_error_name(rc));
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received() done, rc=%s", str_error_name(rc));
 	async_answer_0(call, rc);
 }
 
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
 	async_answer_0(call, ENOTSUP);
 }
 
@@ -292,7 +292,7 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 {
 	ethip_nic_t *nic = (ethip_nic_t *)arg;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethnip_nic_cb_conn()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethnip_nic_cb_conn()");
 
 	while (true) {
 		ipc_call_t call;
@@ -314,7 +314,7 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 			ethip_nic_device_state(nic, &call);
 			break;
 		default:
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, IPC_GET_IMETHOD(call));
+			log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, IPC_GET_IMETHOD(call));
 			async_answer_0(&call, ENOTSUP);
 		}
 	}
@@ -334,27 +334,27 @@ errno_t ethip_nic_discovery_start(void)
 
 ethip_nic_t *ethip_nic_find_by_iplink_sid(service_id_t iplink_sid)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid(%u)",
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid(%u)",
 	    (unsigned) iplink_sid);
 
 	list_foreach(ethip_nic_list, link, ethip_nic_t, nic) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid - element");
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid - element");
 		if (nic->iplink_sid == iplink_sid) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid - found %p", nic);
+			log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid - found %p", nic);
 			return nic;
 		}
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid - not found");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_find_by_iplink_sid - not found");
 	return NULL;
 }
 
 errno_t ethip_nic_send(ethip_nic_t *nic, void *data, size_t size)
 {
 	errno_t rc;
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_send(size=%zu)", size);
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_send(size=%zu)", size);
 	rc = nic_send_frame(nic->sess, data, size);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame -> %s", str_error_name(rc));
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame -> %s", str_error_name(rc));
 	return rc;
 }
 
@@ -366,7 +366,7 @@ errno_t ethip_nic_send(ethip_nic_t *nic, void *data, size_t size)
  */
 static errno_t ethip_nic_setup_multicast(ethip_nic_t *nic)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_setup_multicast()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_setup_multicast()");
 
 	/* Count the number of multicast addresses */
 
@@ -430,7 +430,7 @@ static errno_t ethip_nic_setup_multicast(ethip_nic_t *nic)
 
 errno_t ethip_nic_addr_add(ethip_nic_t *nic, inet_addr_t *addr)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_add()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_add()");
 
 	ethip_link_addr_t *laddr = ethip_nic_addr_new(addr);
 	if (laddr == NULL)
@@ -443,7 +443,7 @@ errno_t ethip_nic_addr_add(ethip_nic_t *nic, inet_addr_t *addr)
 
 errno_t ethip_nic_addr_remove(ethip_nic_t *nic, inet_addr_t *addr)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_remove()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_remove()");
 
 	ethip_link_addr_t *laddr = ethip_nic_addr_find(nic, addr);
 	if (laddr == NULL)
@@ -458,7 +458,7 @@ errno_t ethip_nic_addr_remove(ethip_nic_t *nic, inet_addr_t *addr)
 ethip_link_addr_t *ethip_nic_addr_find(ethip_nic_t *nic,
     inet_addr_t *addr)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_find()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_addr_find()");
 
 	list_foreach(nic->addr_list, link, ethip_link_addr_t, laddr) {
 		if (inet_addr_compare(addr, &laddr->addr))
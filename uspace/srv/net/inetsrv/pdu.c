@@ -310,10 +310,10 @@ errno_t inet_pdu_encode6(inet_packet_t *packet, addr128_t src, addr128_t dest,
 errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
     inet_packet_t *packet)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_pdu_decode()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "inet_pdu_decode()");
 
 	if (size < sizeof(ip_header_t)) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "PDU too short (%zu)", size);
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "PDU too short (%zu)", size);
 		return EINVAL;
 	}
 
@@ -322,18 +322,18 @@ errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
 	uint8_t version = BIT_RANGE_EXTRACT(uint8_t, VI_VERSION_h,
 	    VI_VERSION_l, hdr->ver_ihl);
 	if (version != 4) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Version (%d) != 4", version);
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Version (%d) != 4", version);
 		return EINVAL;
 	}
 
 	size_t tot_len = uint16_t_be2host(hdr->tot_len);
 	if (tot_len < sizeof(ip_header_t)) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Total Length too small (%zu)", tot_len);
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Total Length too small (%zu)", tot_len);
 		return EINVAL;
 	}
 
 	if (tot_len > size) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Total Length = %zu > PDU size = %zu",
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Total Length = %zu > PDU size = %zu",
 		    tot_len, size);
 		return EINVAL;
 	}
@@ -387,10 +387,10 @@ errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
 errno_t inet_pdu_decode6(void *data, size_t size, service_id_t link_id,
     inet_packet_t *packet)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_pdu_decode6()");
+	log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "inet_pdu_decode6()");
 
 	if (size < sizeof(ip6_header_t)) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "PDU too short (%zu)", size);
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "PDU too short (%zu)", size);
 		return EINVAL;
 	}
 
@@ -399,13 +399,13 @@ errno_t inet_pdu_decode6(void *data, size_t size, service_id_t link_id,
 	uint8_t version = BIT_RANGE_EXTRACT(uint8_t, VI_VERSION_h,
 	    VI_VERSION_l, hdr6->ver_tc);
 	if (version != 6) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Version (%d) != 6", version);
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Version (%d) != 6", version);
 		return EINVAL;
 	}
 
 	size_t payload_len = uint16_t_be2host(hdr6->payload_len);
 	if (payload_len + sizeof(ip6_header_t) > size) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Payload Length = %zu > PDU size = %zu",
+		log_msg_bin(LOG_DEFAULT, LVL_DEBUG, "Payload Length = %zu > PDU size = %zu",
 		    payload_len + sizeof(ip6_header_t), size);
 		return EINVAL;
 	}